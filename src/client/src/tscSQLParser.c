@@ -7290,6 +7290,7 @@ int32_t validateDNodeConfig(SMiscInfo* pOptions) {
   const int tokenDebugFlag = 4;
   const int tokenDebugFlagEnd = 20;
   const int tokenOfflineInterval = 21;
+  const int tokenMergeIndex = 22;
   const SDNodeDynConfOption cfgOptions[] = {
       {"resetLog", 8},    {"resetQueryCache", 15},  {"balance", 7},     {"monitor", 7},
       {"debugFlag", 9},   {"monDebugFlag", 12},     {"vDebugFlag", 10}, {"mDebugFlag", 10},
@@ -7298,6 +7299,7 @@ int32_t validateDNodeConfig(SMiscInfo* pOptions) {
       {"dDebugFlag", 10}, {"mqttDebugFlag", 13},    {"wDebugFlag", 10}, {"tmrDebugFlag", 12},
       {"cqDebugFlag", 11},
       {"offlineInterval", 15},
+      {"mergeIndex", 10},
   };
 
   SStrToken* pOptionToken = taosArrayGet(pOptions->a, 1);
@@ -7337,6 +7339,14 @@ int32_t validateDNodeConfig(SMiscInfo* pOptions) {
       return TSDB_CODE_TSC_INVALID_OPERATION;  // options value is invalid
     }
     return TSDB_CODE_SUCCESS;
+  } else if ((strncasecmp(cfgOptions[tokenMergeIndex].name, pOptionToken->z, pOptionToken->n) == 0) &&
+             (cfgOptions[tokenMergeIndex].len == pOptionToken->n)) {
+    SStrToken* pValToken = taosArrayGet(pOptions->a, 2);
+    int32_t    val = strtol(pValToken->z, NULL, 10);
+    if (val != 0 && val != 1) {
+      return TSDB_CODE_TSC_INVALID_OPERATION;  // options value is invalid
+    }
+    return TSDB_CODE_SUCCESS;
   } else {
     SStrToken* pValToken = taosArrayGet(pOptions->a, 2);
 
@@ -929,6 +929,7 @@ int tscBuildQueryMsg(SSqlObj *pSql, SSqlInfo *pInfo) {
   pQueryMsg->fillType       = htons(query.fillType);
   pQueryMsg->limit          = htobe64(query.limit.limit);
   pQueryMsg->offset         = htobe64(query.limit.offset);
+  pQueryMsg->vgroupLimit    = htobe64(query.prjInfo.vgroupLimit);
   pQueryMsg->numOfCols      = htons(query.numOfCols);
 
   pQueryMsg->interval.interval     = htobe64(query.interval.interval);
@@ -5078,6 +5078,11 @@ int32_t tscCreateQueryFromQueryInfo(SQueryInfo* pQueryInfo, SQueryAttr* pQueryAt
   pQueryAttr->pUdfInfo          = pQueryInfo->pUdfInfo;
   pQueryAttr->range             = pQueryInfo->range;
 
+  // the rows of the vgroups of a join query are limited after they are joined
+  if (!TSDB_QUERY_HAS_TYPE(pQueryInfo->type, TSDB_QUERY_TYPE_JOIN_QUERY | TSDB_QUERY_TYPE_JOIN_SEC_STAGE)) {
+    pQueryAttr->prjInfo.vgroupLimit = pQueryInfo->vgroupLimit;
+  }
+
   if (pQueryInfo->order.order == TSDB_ORDER_ASC) {   // TODO refactor
     pQueryAttr->window = pQueryInfo->window;
   } else {
@@ -54,7 +54,9 @@ extern int32_t  tsShellActivityTimer;
 extern uint32_t tsMaxTmrCtrl;
 extern float    tsNumOfThreadsPerCore;
 extern int32_t  tsNumOfCommitThreads;
+extern int32_t  tsNumOfCommitWorkers;
 extern float    tsRatioOfQueryCores;
+extern int32_t  tsNumOfQueryWorkers;
 extern int8_t   tsDaylight;
 extern char     tsTimezone[];
 extern char     tsLocale[];
@@ -69,6 +71,7 @@ extern char     tsTempDir[];
 extern int32_t tsQueryBufferSize;  // maximum allowed usage buffer size in MB for each data node during query processing
 extern int64_t
     tsQueryBufferSizeBytes;  // maximum allowed usage buffer size in byte for each data node during query processing
+extern int32_t tsGroupbyBufferSize;  // maximum buffer size in MB for the groups of a group by query, or spilled to disk
 extern int32_t tsRetrieveBlockingModel;  // retrieve threads will be blocked
 
 extern int8_t tsKeepOriginalColumnName;
@@ -114,6 +117,22 @@ extern int8_t  tsCacheLastRow;
 extern bool    tsdbForceKeepFile;
 extern bool    tsdbForceCompactFile;
 extern int32_t tsdbWalFlushSize;
+extern int8_t  tsdbLockFreeSkipList;
+extern int8_t  tsdbColumnarMemTable;
+extern int8_t  tsdbMergeIndex;
+extern int32_t tsdbLastRowCacheSize;
+extern int32_t tsdbBlockCacheSize;
+extern int32_t tsdbReadAheadBlocks;
+extern int8_t  tsdbColumnCodec;
+extern int32_t tsdbColumnDeflateLevel;
+extern int32_t tsdbAutoCompactInterval;
+extern int32_t tsdbAutoCompactFSets;
+extern int32_t tsdbAutoCompactIOBudget;
+extern char    tsdbRollupLevels[];
+extern int32_t tsdbHotFSetReads;
+extern int32_t tsdbHotFSetHalfLife;
+extern int32_t tsdbTierMigrateIOBudget;
+extern int32_t tsdbWriteBackSize;
 
 // balance
 extern int8_t  tsEnableBalance;
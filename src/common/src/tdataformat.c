@@ -593,6 +593,79 @@ _err:
   return -1;
 }
 
+/**
+ * Enlarge the capacity of pCols to maxPoints rows, the data already in pCols is kept.
+ * If it fails, pCols can only be reset or freed.
+ */
+int tdExpandDataCols(SDataCols *pCols, int maxPoints) {
+  if (maxPoints <= pCols->maxPoints) return 0;
+
+  for (int i = 0; i < pCols->numOfCols; i++) {
+    SDataCol *pCol = pCols->cols + i;
+    // space of an all NULL column is allocated with the new capacity on its first value
+    if (isAllRowsNull(pCol)) continue;
+
+    int oldOffPos = pCol->bytes * pCols->maxPoints;
+    if (tdAllocMemForCol(pCol, maxPoints) < 0) return -1;
+    if (IS_VAR_DATA_TYPE(pCol->type)) {
+      // the offset array is placed after the data part, move it with the data part enlarged
+      memmove(pCol->dataOff, POINTER_SHIFT(pCol->pData, oldOffPos), sizeof(VarDataOffsetT) * pCols->numOfRows);
+    }
+  }
+
+  pCols->maxPoints = maxPoints;
+  return 0;
+}
+
+/**
+ * Append nRows rows of source from offset to target, columns are matched by column ID and the target
+ * columns not in source are set as NULL. Keys of the appended rows should be larger than those in target.
+ */
+int tdAppendDataColsRows(SDataCols *target, SDataCols *source, int offset, int nRows) {
+  ASSERT(nRows > 0 && offset + nRows <= source->numOfRows && target->numOfRows + nRows <= target->maxPoints);
+  ASSERT(target->numOfRows == 0 || dataColsKeyLast(target) < dataColsKeyAtRow(source, offset));
+
+  int scol = 0;
+  for (int tcol = 0; tcol < target->numOfCols; tcol++) {
+    SDataCol *pDst = target->cols + tcol;
+    SDataCol *pSrc = NULL;
+
+    while (scol < source->numOfCols && source->cols[scol].colId < pDst->colId) scol++;
+    if (scol < source->numOfCols && source->cols[scol].colId == pDst->colId) pSrc = source->cols + scol;
+
+    if (pSrc == NULL || isAllRowsNull(pSrc)) {
+      if (isAllRowsNull(pDst)) continue;
+      for (int i = 0; i < nRows; i++) {
+        dataColAppendVal(pDst, getNullValue(pDst->type), target->numOfRows + i, target->maxPoints, 0);
+      }
+    } else if (target->numOfRows == 0) {
+      // copy the whole slice at once
+      if (tdAllocMemForCol(pDst, target->maxPoints) < 0) return -1;
+      if (IS_VAR_DATA_TYPE(pDst->type)) {
+        VarDataOffsetT start = pSrc->dataOff[offset];
+        pDst->len = dataColGetNEleLen(pSrc, offset + nRows) - start;
+        memcpy(pDst->pData, POINTER_SHIFT(pSrc->pData, start), pDst->len);
+        for (int i = 0; i < nRows; i++) {
+          pDst->dataOff[i] = pSrc->dataOff[offset + i] - start;
+        }
+      } else {
+        pDst->len = TYPE_BYTES[pDst->type] * nRows;
+        memcpy(pDst->pData, POINTER_SHIFT(pSrc->pData, TYPE_BYTES[pSrc->type] * offset), pDst->len);
+      }
+    } else {
+      for (int i = 0; i < nRows; i++) {
+        if (dataColAppendVal(pDst, tdGetColDataOfRow(pSrc, offset + i), target->numOfRows + i, target->maxPoints,
+                             0) < 0) {
+          return -1;
+        }
+      }
+    }
+  }
+
+  target->numOfRows += nRows;
+  return 0;
+}
+
 // src2 data has more priority than src1
 static void tdMergeTwoDataCols(SDataCols *target, SDataCols *src1, int *iter1, int limit1, SDataCols *src2, int *iter2,
                                int limit2, int tRows, bool forceSetNull) {
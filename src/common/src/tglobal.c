@@ -58,7 +58,9 @@ int32_t tsMaxConnections = 5000;
 int32_t tsShellActivityTimer = 3;  // second
 float   tsNumOfThreadsPerCore = 1.0f;
 int32_t tsNumOfCommitThreads = 4;
+int32_t tsNumOfCommitWorkers = 0;
 float   tsRatioOfQueryCores = 1.0f;
+int32_t tsNumOfQueryWorkers = 0;
 int8_t  tsDaylight = 0;
 char    tsTimezone[TSDB_TIMEZONE_LEN] = {0};
 char    tsLocale[TSDB_LOCALE_LEN] = {0};
@@ -125,6 +127,10 @@ int64_t tsMaxRetentWindow = 24 * 3600L;  // maximum time window tolerance
 int32_t tsQueryBufferSize = -1;
 int64_t tsQueryBufferSizeBytes = -1;
 
+// the memory in MB kept by the groups of a group by query, the rows of the other groups are spilled to temp files
+// -1 no limit, all groups are kept in memory
+int32_t tsGroupbyBufferSize = 256;
+
 // in retrieve blocking model, the retrieve threads will wait for the completion of the query processing.
 int32_t tsRetrieveBlockingModel = 0;
 
@@ -159,6 +165,22 @@ int32_t tsTsdbMetaCompactRatio = TSDB_META_COMPACT_RATIO;
 bool    tsdbForceKeepFile = false;
 bool    tsdbForceCompactFile = false;                    // compact TSDB fileset forcibly
 int32_t tsdbWalFlushSize = TSDB_DEFAULT_WAL_FLUSH_SIZE;  // MB
+int8_t  tsdbLockFreeSkipList = 0;                        // new memtable skiplists of tables are lock free
+int8_t  tsdbColumnarMemTable = 0;                        // keep in-order memtable rows column-wise as well
+int8_t  tsdbMergeIndex = 1;                              // merge memtable rows and file blocks through a merge index
+int32_t tsdbLastRowCacheSize = 0;                        // MB, memory of the last row cache of a vnode, 0 unlimited
+int32_t tsdbBlockCacheSize = 0;                          // MB, memory of the decoded block cache of a vnode, 0 disabled
+int32_t tsdbReadAheadBlocks = 4;                         // file blocks a query reads ahead, 0 to disable
+int8_t  tsdbColumnCodec = 0;                             // try dictionary and frame of reference codecs for columns
+int32_t tsdbColumnDeflateLevel = 0;                      // zlib level to try for columns, 0 to disable
+int32_t tsdbAutoCompactInterval = 0;                     // seconds between background compactions of a vnode, 0 to disable
+int32_t tsdbAutoCompactFSets = 1;                        // most filesets a background compaction rewrites
+int32_t tsdbAutoCompactIOBudget = 32;                    // MB/s, I/O rate of a background compaction, 0 unlimited
+char    tsdbRollupLevels[TSDB_ROLLUP_LEVELS_LEN] = {0};  // rollup levels kept in file blocks, such as 1h,1d
+int32_t tsdbHotFSetReads = 0;                            // reads keeping a fileset on the first tier, 0 to disable
+int32_t tsdbHotFSetHalfLife = 86400;                     // seconds for a read of a fileset to decay by half
+int32_t tsdbTierMigrateIOBudget = 32;                    // MB/s, I/O rate of a tier migration, 0 unlimited
+int32_t tsdbWriteBackSize = 0;                           // MB, written back by a commit or compaction at a time
 
 // balance
 int8_t  tsEnableBalance = 1;
@@ -574,6 +596,17 @@ static void doInitGlobalConfig(void) {
   cfg.unitType = TAOS_CFG_UTYPE_NONE;
   taosInitConfigOption(cfg);
 
+  // workers shared by commit threads to encode the tables of one file set in parallel, 0 to commit tables serially
+  cfg.option = "numOfCommitWorkers";
+  cfg.ptr = &tsNumOfCommitWorkers;
+  cfg.valType = TAOS_CFG_VTYPE_INT32;
+  cfg.cfgType = TSDB_CFG_CTYPE_B_CONFIG;
+  cfg.minValue = 0;
+  cfg.maxValue = 100;
+  cfg.ptrLength = 0;
+  cfg.unitType = TAOS_CFG_UTYPE_NONE;
+  taosInitConfigOption(cfg);
+
   cfg.option = "ratioOfQueryCores";
   cfg.ptr = &tsRatioOfQueryCores;
   cfg.valType = TAOS_CFG_VTYPE_FLOAT;
@@ -584,6 +617,17 @@ static void doInitGlobalConfig(void) {
   cfg.unitType = TAOS_CFG_UTYPE_NONE;
   taosInitConfigOption(cfg);
 
+  // workers shared by query threads to scan the tables of one super table aggregation in parallel, 0 to scan serially
+  cfg.option = "numOfQueryWorkers";
+  cfg.ptr = &tsNumOfQueryWorkers;
+  cfg.valType = TAOS_CFG_VTYPE_INT32;
+  cfg.cfgType = TSDB_CFG_CTYPE_B_CONFIG;
+  cfg.minValue = 0;
+  cfg.maxValue = 100;
+  cfg.ptrLength = 0;
+  cfg.unitType = TAOS_CFG_UTYPE_NONE;
+  taosInitConfigOption(cfg);
+
   cfg.option = "maxNumOfDistinctRes";
   cfg.ptr = &tsMaxNumOfDistinctResults;
   cfg.valType = TAOS_CFG_VTYPE_INT32;
@@ -1117,6 +1161,16 @@ static void doInitGlobalConfig(void) {
   cfg.unitType = TAOS_CFG_UTYPE_BYTE;
   taosInitConfigOption(cfg);
 
+  cfg.option = "groupbyBufferSize";
+  cfg.ptr = &tsGroupbyBufferSize;
+  cfg.valType = TAOS_CFG_VTYPE_INT32;
+  cfg.cfgType = TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW;
+  cfg.minValue = -1;
+  cfg.maxValue = 1048576;
+  cfg.ptrLength = 0;
+  cfg.unitType = TAOS_CFG_UTYPE_MB;
+  taosInitConfigOption(cfg);
+
   cfg.option = "retrieveBlockingModel";
   cfg.ptr = &tsRetrieveBlockingModel;
   cfg.valType = TAOS_CFG_VTYPE_INT32;
@@ -1749,6 +1803,177 @@ static void doInitGlobalConfig(void) {
   cfg.unitType = TAOS_CFG_UTYPE_MB;
   taosInitConfigOption(cfg);
 
+  // create the memtable skiplist of each table in lock free mode
+  cfg.option = "lockFreeSkipList";
+  cfg.ptr = &tsdbLockFreeSkipList;
+  cfg.valType = TAOS_CFG_VTYPE_INT8;
+  cfg.cfgType = TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW;
+  cfg.minValue = 0;
+  cfg.maxValue = 1;
+  cfg.ptrLength = 0;
+  cfg.unitType = TAOS_CFG_UTYPE_NONE;
+  taosInitConfigOption(cfg);
+
+  // keep the in-order rows of each table in memtable as column vectors for commit and query
+  cfg.option = "columnarMemTable";
+  cfg.ptr = &tsdbColumnarMemTable;
+  cfg.valType = TAOS_CFG_VTYPE_INT8;
+  cfg.cfgType = TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW;
+  cfg.minValue = 0;
+  cfg.maxValue = 1;
+  cfg.ptrLength = 0;
+  cfg.unitType = TAOS_CFG_UTYPE_NONE;
+  taosInitConfigOption(cfg);
+
+  // order the memtable rows and file block rows a query merges by a merge index and gather the columns after
+  cfg.option = "mergeIndex";
+  cfg.ptr = &tsdbMergeIndex;
+  cfg.valType = TAOS_CFG_VTYPE_INT8;
+  cfg.cfgType = TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW;
+  cfg.minValue = 0;
+  cfg.maxValue = 1;
+  cfg.ptrLength = 0;
+  cfg.unitType = TAOS_CFG_UTYPE_NONE;
+  taosInitConfigOption(cfg);
+
+  // bound the memory of the last row and last column cache of each vnode, the cache is persisted at commit if set
+  cfg.option = "lastRowCacheSize";
+  cfg.ptr = &tsdbLastRowCacheSize;
+  cfg.valType = TAOS_CFG_VTYPE_INT32;
+  cfg.cfgType = TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW;
+  cfg.minValue = 0;
+  cfg.maxValue = 65536;
+  cfg.ptrLength = 0;
+  cfg.unitType = TAOS_CFG_UTYPE_MB;
+  taosInitConfigOption(cfg);
+
+  // bound the memory of the decoded columns of file blocks each vnode keeps for queries, 0 to disable the cache
+  cfg.option = "blockCacheSize";
+  cfg.ptr = &tsdbBlockCacheSize;
+  cfg.valType = TAOS_CFG_VTYPE_INT32;
+  cfg.cfgType = TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW;
+  cfg.minValue = 0;
+  cfg.maxValue = 65536;
+  cfg.ptrLength = 0;
+  cfg.unitType = TAOS_CFG_UTYPE_MB;
+  taosInitConfigOption(cfg);
+
+  // number of file blocks a query asks the kernel to read ahead of the block it loads
+  cfg.option = "readAheadBlocks";
+  cfg.ptr = &tsdbReadAheadBlocks;
+  cfg.valType = TAOS_CFG_VTYPE_INT32;
+  cfg.cfgType = TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW;
+  cfg.minValue = 0;
+  cfg.maxValue = 1024;
+  cfg.ptrLength = 0;
+  cfg.unitType = TAOS_CFG_UTYPE_NONE;
+  taosInitConfigOption(cfg);
+
+  // encode the columns of a file block with the dictionary or the frame of reference codec if it is smaller
+  cfg.option = "columnCodec";
+  cfg.ptr = &tsdbColumnCodec;
+  cfg.valType = TAOS_CFG_VTYPE_INT8;
+  cfg.cfgType = TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW;
+  cfg.minValue = 0;
+  cfg.maxValue = 1;
+  cfg.ptrLength = 0;
+  cfg.unitType = TAOS_CFG_UTYPE_NONE;
+  taosInitConfigOption(cfg);
+
+  cfg.option = "columnDeflateLevel";
+  cfg.ptr = &tsdbColumnDeflateLevel;
+  cfg.valType = TAOS_CFG_VTYPE_INT32;
+  cfg.cfgType = TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW;
+  cfg.minValue = 0;
+  cfg.maxValue = 9;
+  cfg.ptrLength = 0;
+  cfg.unitType = TAOS_CFG_UTYPE_NONE;
+  taosInitConfigOption(cfg);
+
+  // compact the most fragmented filesets of a vnode in background after a commit
+  cfg.option = "autoCompactInterval";
+  cfg.ptr = &tsdbAutoCompactInterval;
+  cfg.valType = TAOS_CFG_VTYPE_INT32;
+  cfg.cfgType = TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW;
+  cfg.minValue = 0;
+  cfg.maxValue = 86400 * 30;
+  cfg.ptrLength = 0;
+  cfg.unitType = TAOS_CFG_UTYPE_SECOND;
+  taosInitConfigOption(cfg);
+
+  cfg.option = "autoCompactFSets";
+  cfg.ptr = &tsdbAutoCompactFSets;
+  cfg.valType = TAOS_CFG_VTYPE_INT32;
+  cfg.cfgType = TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW;
+  cfg.minValue = 1;
+  cfg.maxValue = 1024;
+  cfg.ptrLength = 0;
+  cfg.unitType = TAOS_CFG_UTYPE_NONE;
+  taosInitConfigOption(cfg);
+
+  cfg.option = "autoCompactIOBudget";
+  cfg.ptr = &tsdbAutoCompactIOBudget;
+  cfg.valType = TAOS_CFG_VTYPE_INT32;
+  cfg.cfgType = TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW;
+  cfg.minValue = 0;
+  cfg.maxValue = 65536;
+  cfg.ptrLength = 0;
+  cfg.unitType = TAOS_CFG_UTYPE_MB;
+  taosInitConfigOption(cfg);
+
+  // aggregate the rows of a file block in the time windows of each level when it is written
+  cfg.option = "rollupLevels";
+  cfg.ptr = tsdbRollupLevels;
+  cfg.valType = TAOS_CFG_VTYPE_STRING;
+  cfg.cfgType = TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW;
+  cfg.minValue = 0;
+  cfg.maxValue = 0;
+  cfg.ptrLength = tListLen(tsdbRollupLevels);
+  cfg.unitType = TAOS_CFG_UTYPE_NONE;
+  taosInitConfigOption(cfg);
+
+  // move the filesets of a vnode between tiers by their reads in background after a commit
+  cfg.option = "hotFileSetReads";
+  cfg.ptr = &tsdbHotFSetReads;
+  cfg.valType = TAOS_CFG_VTYPE_INT32;
+  cfg.cfgType = TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW;
+  cfg.minValue = 0;
+  cfg.maxValue = 1000000;
+  cfg.ptrLength = 0;
+  cfg.unitType = TAOS_CFG_UTYPE_NONE;
+  taosInitConfigOption(cfg);
+
+  cfg.option = "hotFileSetHalfLife";
+  cfg.ptr = &tsdbHotFSetHalfLife;
+  cfg.valType = TAOS_CFG_VTYPE_INT32;
+  cfg.cfgType = TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW;
+  cfg.minValue = 1;
+  cfg.maxValue = 86400 * 365;
+  cfg.ptrLength = 0;
+  cfg.unitType = TAOS_CFG_UTYPE_SECOND;
+  taosInitConfigOption(cfg);
+
+  cfg.option = "tierMigrateIOBudget";
+  cfg.ptr = &tsdbTierMigrateIOBudget;
+  cfg.valType = TAOS_CFG_VTYPE_INT32;
+  cfg.cfgType = TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW;
+  cfg.minValue = 0;
+  cfg.maxValue = 65536;
+  cfg.ptrLength = 0;
+  cfg.unitType = TAOS_CFG_UTYPE_MB;
+  taosInitConfigOption(cfg);
+
+  // keep the data files a commit or compaction writes, and the files it replaces, out of the page cache
+  cfg.option = "writeBackSize";
+  cfg.ptr = &tsdbWriteBackSize;
+  cfg.valType = TAOS_CFG_VTYPE_INT32;
+  cfg.cfgType = TSDB_CFG_CTYPE_B_CONFIG | TSDB_CFG_CTYPE_B_SHOW;
+  cfg.minValue = 0;
+  cfg.maxValue = 1024;
+  cfg.ptrLength = 0;
+  cfg.unitType = TAOS_CFG_UTYPE_MB;
+  taosInitConfigOption(cfg);
+
 #ifdef TD_TSZ
   // lossy compress
   cfg.option = "lossyColumns";
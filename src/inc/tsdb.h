@@ -82,8 +82,45 @@ typedef struct {
   int64_t totalStorage;  // total bytes occupie
   int64_t compStorage;
   int64_t pointsWritten;  // total data points written
+  int64_t rowsAppended;   // total rows taking the in-order append path of the memtable
+  int64_t rowsMerged;     // total rows taking the skiplist search path of the memtable
 } STsdbStat;
 
+// --------- TSDB LAST ROW CACHE STATISTICS
+typedef struct {
+  int64_t size;     // bytes taken by the cached last rows and columns, 0 if the cache is unlimited
+  int64_t maxSize;  // memory budget in bytes, 0 if unlimited
+  int64_t hit;      // tables served from the cache by last row and last queries
+  int64_t miss;     // tables loaded from files by last row and last queries
+  int64_t evicted;  // tables evicted from the cache
+} STsdbLastCacheStat;
+
+// --------- TSDB BLOCK CACHE STATISTICS
+typedef struct {
+  int64_t size;     // bytes taken by the cached columns
+  int64_t maxSize;  // memory budget in bytes, 0 if the cache is disabled
+  int64_t entries;  // columns in the cache
+  int64_t hit;      // columns copied from the cache by queries
+  int64_t miss;     // columns read and decoded from files by queries
+  int64_t evicted;  // columns evicted or dropped with their files
+} STsdbBlockCacheStat;
+
+// --------- TSDB COMMIT STATISTICS
+typedef struct {
+  int64_t commits;       // commits of TS data
+  int64_t rows;          // rows committed from the memtables
+  int64_t bytesIn;       // bytes of the rows committed as they are in the memtables
+  int64_t bytesRead;     // bytes of the blocks loaded to merge with or move
+  int64_t bytesWritten;  // bytes of the blocks written
+  int64_t lastWritten;   // bytes of the blocks written to the .last files
+  int64_t totalUs;       // time of the commits
+  int64_t iterUs;        // iterating the memtables and appending the rows to the data cols
+  int64_t loadUs;        // loading the blocks to merge with or move
+  int64_t encodeUs;      // encoding and compressing the blocks
+  int64_t writeUs;       // writing the blocks, the block infos and the indexes
+  int64_t fsyncUs;       // writing back and syncing the files
+} STsdbCommitStat;
+
 typedef struct STsdbRepo STsdbRepo;
 
 STsdbCfg *tsdbGetCfg(const STsdbRepo *repo);
@@ -178,6 +215,8 @@ typedef struct STsdbQueryCond {
   SColumnInfo *colList;
   bool         loadExternalRows;  // load external rows or not
   int32_t      type;              // data block load type:
+  void        *pFilters;          // SFilterInfo of the column filters to skip file sets, NULL if none
+  int64_t      rollupInterval;    // interval of the query to return blocks by their rollup windows, 0 if not
 } STsdbQueryCond;
 
 typedef struct STableData STableData;
@@ -194,6 +233,8 @@ typedef struct {
   SList *      bufBlockList;
   int64_t      pointsAdd;   // TODO
   int64_t      storageAdd;  // TODO
+  int64_t      rowsAppended;  // rows linked to the tail of the table skiplist directly
+  int64_t      rowsMerged;    // out of order or duplicated rows put by skiplist search
 } SMemTable;
 
 typedef struct {
@@ -403,6 +444,9 @@ int64_t tsdbSkipOffset(TsdbQueryHandleT queryHandle);
  * @param compStorage. total bytes took by the tsdb after compressed
  */
 void tsdbReportStat(void *repo, int64_t *totalPoints, int64_t *totalStorage, int64_t *compStorage);
+void tsdbGetLastCacheStat(STsdbRepo *repo, STsdbLastCacheStat *pStat);
+void tsdbGetBlockCacheStat(STsdbRepo *repo, STsdbBlockCacheStat *pStat);
+void tsdbGetCommitStat(STsdbRepo *repo, STsdbCommitStat *pStat);
 
 int  tsdbInitCommitQueue();
 void tsdbDestroyCommitQueue();
@@ -26,6 +26,22 @@ typedef struct {
   int64_t submitReqSucNum;
   int64_t submitRowNum;
   int64_t submitRowSucNum;
+  int64_t blockCacheSize;     // bytes taken by the block caches of the vnodes
+  int64_t blockCacheHit;      // total columns copied from the block caches
+  int64_t blockCacheMiss;     // total columns read and decoded from files
+  int64_t blockCacheEvicted;  // total columns evicted from the block caches
+  int64_t commits;            // total commits of the vnodes, see STsdbCommitStat for the counters below
+  int64_t commitRows;
+  int64_t commitBytesIn;
+  int64_t commitBytesRead;
+  int64_t commitBytesWritten;
+  int64_t commitLastWritten;
+  int64_t commitTotalUs;
+  int64_t commitIterUs;
+  int64_t commitLoadUs;
+  int64_t commitEncodeUs;
+  int64_t commitWriteUs;
+  int64_t commitFsyncUs;
 } SVnodeStatisInfo;
 
 typedef struct {
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Offline check of the data files of vnodes, taosd does not need to run. For each data directory, such as
+// <dataDir>/vnode/vnode2/tsdb/data, every FSET is scanned, the problems found and the block statistics of each FSET
+// and table are printed. The exit code is 1 if any problem is found.
+//
+// usage: taosscan [-t threads] [-s] [-d] <vnode data directory>...
+
+#include "os.h"
+#include "taoserror.h"
+#include "tglobal.h"
+#include "tsdbScan.h"
+
+extern int32_t tsdbDebugFlag;
+
+static void printUsage(const char *name) {
+  printf("usage: %s [-t threads] [-s] [-d] <vnode data directory>...\n", name);
+  printf("  -t threads  number of FSETs scanned at the same time, default the number of cores\n");
+  printf("  -s          print the statistics of each FSET only, not of each table\n");
+  printf("  -d          print the log of the tsdb module too\n");
+}
+
+int main(int argc, char *argv[]) {
+  int  nThreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  bool tableStat = true;
+  bool debug = false;
+  int  opt;
+
+  while ((opt = getopt(argc, argv, "t:sdh")) != -1) {
+    switch (opt) {
+      case 't':
+        nThreads = atoi(optarg);
+        break;
+      case 's':
+        tableStat = false;
+        break;
+      case 'd':
+        debug = true;
+        break;
+      default:
+        printUsage(argv[0]);
+        return 2;
+    }
+  }
+
+  if (optind >= argc || nThreads <= 0) {
+    printUsage(argv[0]);
+    return 2;
+  }
+
+  if (!debug) {
+    tsdbDebugFlag = 0;
+    uDebugFlag = 0;
+  }
+
+  int nErrors = 0;
+  for (int i = optind; i < argc; i++) {
+    int code = tsdbScanDataDir(argv[i], nThreads, tableStat, stdout);
+    if (code < 0) {
+      printf("failed to scan %s since %s\n", argv[i], tstrerror(terrno));
+      nErrors++;
+    } else {
+      nErrors += code;
+    }
+  }
+
+  return (nErrors > 0) ? 1 : 0;
+}
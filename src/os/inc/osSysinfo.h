@@ -29,6 +29,16 @@ typedef struct {
 int32_t taosGetDiskSize(char *dataDir, SysDiskSize *diskSize);
 
 int32_t taosGetCpuCores();
+
+// the SIMD instructions of the CPU, a level has those of the levels below, AVX512 has the F, BW, VL and DQ sets
+#define TAOS_CPU_SIMD_NONE   0
+#define TAOS_CPU_SIMD_SSE4   1
+#define TAOS_CPU_SIMD_AVX2   2
+#define TAOS_CPU_SIMD_AVX512 3
+
+// detected by the first call
+int32_t taosGetCpuSimdLevel();
+
 void taosGetSystemInfo();
 bool taosReadProcIO(int64_t* rchars, int64_t* wchars, int64_t* rbytes, int64_t* wbytes);
 bool taosGetProcIO(float *rcharKB, float *wcharKB, float *rbyteKB, float* wbyteKB);
@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _DEFAULT_SOURCE
+#include "os.h"
+
+#if defined(__x86_64__) && !defined(WINDOWS) && !defined(_TD_ARM_) && !defined(_TD_MIPS_)
+#define CPU_SIMD_X86
+#endif
+
+static pthread_once_t tsCpuSimdInit = PTHREAD_ONCE_INIT;
+static int32_t        tsCpuSimdLevel = TAOS_CPU_SIMD_NONE;
+
+static void taosInitCpuSimdLevel() {
+#ifdef CPU_SIMD_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+      __builtin_cpu_supports("avx512vl") && __builtin_cpu_supports("avx512dq")) {
+    tsCpuSimdLevel = TAOS_CPU_SIMD_AVX512;
+  } else if (__builtin_cpu_supports("avx2")) {
+    tsCpuSimdLevel = TAOS_CPU_SIMD_AVX2;
+  } else if (__builtin_cpu_supports("sse4.1")) {
+    tsCpuSimdLevel = TAOS_CPU_SIMD_SSE4;
+  }
+#endif
+}
+
+int32_t taosGetCpuSimdLevel() {
+  pthread_once(&tsCpuSimdInit, taosInitCpuSimdLevel);
+  return tsCpuSimdLevel;
+}
@@ -14,6 +14,9 @@
  */
 
 #define _DEFAULT_SOURCE
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE  // sync_file_range
+#endif
 #include "os.h"
 #include "tglobal.h"
 #include "tulog.h"
@@ -377,6 +380,10 @@ int32_t taosFsync(FileFd fd) {
   return FlushFileBuffers(h)-1;
 }
 
+int32_t taosReadAhead(FileFd fd, int64_t offset, int64_t count) { return 0; }
+int32_t taosWriteBack(FileFd fd, int64_t offset, int64_t count) { return 0; }
+int32_t taosDropCache(FileFd fd, int64_t offset, int64_t count) { return 0; }
+
 int32_t taosRename(char *oldName, char *newName) {
   int32_t code = MoveFileEx(oldName, newName, MOVEFILE_REPLACE_EXISTING | MOVEFILE_COPY_ALLOWED);
   if (code < 0) {
@@ -393,6 +400,47 @@ int32_t taosRename(char *oldName, char *newName) {
 int32_t taosFtruncate(FileFd fd, int64_t length) { return ftruncate(fd, length); }
 int32_t taosFsync(FileFd fd) { return fsync(fd); }
 
+// Start to read a range of the file into the page cache without waiting for it
+int32_t taosReadAhead(FileFd fd, int64_t offset, int64_t count) {
+#ifdef _TD_DARWIN_64
+  struct radvisory ra = {.ra_offset = offset, .ra_count = (int)count};
+  return fcntl(fd, F_RDADVISE, &ra);
+#else
+  int32_t code = posix_fadvise(fd, offset, count, POSIX_FADV_WILLNEED);
+  if (code != 0) {
+    errno = code;
+    return -1;
+  }
+
+  return 0;
+#endif
+}
+
+// Write a range of the file to the disk and wait for it, but not the metadata of the file as fsync does
+int32_t taosWriteBack(FileFd fd, int64_t offset, int64_t count) {
+#ifdef _TD_DARWIN_64
+  return fsync(fd);
+#else
+  return sync_file_range(fd, offset, count,
+                         SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+#endif
+}
+
+// Drop the clean pages of a range of the file from the page cache, count 0 for the range to the end of the file
+int32_t taosDropCache(FileFd fd, int64_t offset, int64_t count) {
+#ifdef _TD_DARWIN_64
+  return 0;
+#else
+  int32_t code = posix_fadvise(fd, offset, count, POSIX_FADV_DONTNEED);
+  if (code != 0) {
+    errno = code;
+    return -1;
+  }
+
+  return 0;
+#endif
+}
+
 int32_t taosRename(char *oldName, char *newName) {
   int32_t code = rename(oldName, newName);
   if (code < 0) {
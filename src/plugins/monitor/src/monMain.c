@@ -130,6 +130,10 @@ typedef enum {
   MON_CMD_CREATE_TB_GRANTS,
   MON_CMD_CREATE_MT_RESTFUL,
   MON_CMD_CREATE_TB_RESTFUL,
+  MON_CMD_CREATE_MT_BLOCK_CACHE,
+  MON_CMD_CREATE_TB_BLOCK_CACHE,
+  MON_CMD_CREATE_MT_COMMIT,
+  MON_CMD_CREATE_TB_COMMIT,
   MON_CMD_MAX
 } EMonCmd;
 
@@ -166,6 +170,8 @@ static SMonConn tsMonitor = {0};
 static SMonStat tsMonStat = {{0}};
 static int32_t  monQueryReqNum = 0, monSubmitReqNum = 0;
 static bool     monHasMnodeMaster = false;
+static int64_t  monBlockCacheHit = 0, monBlockCacheMiss = 0, monBlockCacheEvicted = 0;
+static SVnodeStatisInfo monCommitInfo = {0};
 
 static void  monSaveSystemInfo();
 static void  monSaveClusterInfo();
@@ -174,6 +180,8 @@ static void  monSaveVgroupsInfo();
 static void  monSaveDisksInfo();
 static void  monSaveGrantsInfo();
 static void  monSaveHttpReqInfo();
+static void  monSaveBlockCacheInfo();
+static void  monSaveCommitInfo();
 static void  monGetSysStats();
 static void *monThreadFunc(void *param);
 static void  monBuildMonitorSql(char *sql, int32_t cmd);
@@ -323,6 +331,8 @@ static void *monThreadFunc(void *param) {
         monSaveDisksInfo();
         monSaveGrantsInfo();
         monSaveHttpReqInfo();
+        monSaveBlockCacheInfo();
+        monSaveCommitInfo();
         monSaveSystemInfo();
       }
     }
@@ -475,6 +485,26 @@ static void monBuildMonitorSql(char *sql, int32_t cmd) {
   } else if (cmd == MON_CMD_CREATE_TB_RESTFUL) {
     snprintf(sql, SQL_LENGTH, "create table if not exists %s.restful_%d using %s.restful_info tags(%d, '%s')", tsMonitorDbName,
              dnodeGetDnodeId(), tsMonitorDbName, dnodeGetDnodeId(), tsLocalEp);
+  } else if (cmd == MON_CMD_CREATE_MT_BLOCK_CACHE) {
+    snprintf(sql, SQL_LENGTH,
+             "create table if not exists %s.block_cache_info(ts timestamp"
+             ", size bigint, hits bigint, misses bigint, hit_rate float, evictions bigint)"
+             " tags (dnode_id int, dnode_ep binary(%d))",
+             tsMonitorDbName, TSDB_EP_LEN);
+  } else if (cmd == MON_CMD_CREATE_TB_BLOCK_CACHE) {
+    snprintf(sql, SQL_LENGTH, "create table if not exists %s.block_cache_%d using %s.block_cache_info tags(%d, '%s')",
+             tsMonitorDbName, dnodeGetDnodeId(), tsMonitorDbName, dnodeGetDnodeId(), tsLocalEp);
+  } else if (cmd == MON_CMD_CREATE_MT_COMMIT) {
+    snprintf(sql, SQL_LENGTH,
+             "create table if not exists %s.commit_info(ts timestamp"
+             ", commits bigint, rows bigint, bytes_in bigint, bytes_read bigint, bytes_written bigint"
+             ", last_written bigint, write_amp float, total_us bigint, iter_us bigint, load_us bigint"
+             ", encode_us bigint, write_us bigint, fsync_us bigint)"
+             " tags (dnode_id int, dnode_ep binary(%d))",
+             tsMonitorDbName, TSDB_EP_LEN);
+  } else if (cmd == MON_CMD_CREATE_TB_COMMIT) {
+    snprintf(sql, SQL_LENGTH, "create table if not exists %s.commit_%d using %s.commit_info tags(%d, '%s')",
+             tsMonitorDbName, dnodeGetDnodeId(), tsMonitorDbName, dnodeGetDnodeId(), tsLocalEp);
   }
 
   sql[SQL_LENGTH] = 0;
@@ -1320,6 +1350,79 @@ static void monSaveHttpReqInfo() {
   }
 }
 
+// The block cache counters of the vnodes are cumulative, the hits, misses and evictions of the interval are saved
+static void monSaveBlockCacheInfo() {
+  SVnodeStatisInfo *pInfo = &tsMonStat.vInfo;
+
+  int64_t hits = MAX(pInfo->blockCacheHit - monBlockCacheHit, 0);
+  int64_t misses = MAX(pInfo->blockCacheMiss - monBlockCacheMiss, 0);
+  int64_t evictions = MAX(pInfo->blockCacheEvicted - monBlockCacheEvicted, 0);
+  float   hitRate = (hits + misses > 0) ? (float)hits / (hits + misses) : 0.0f;
+
+  monBlockCacheHit = pInfo->blockCacheHit;
+  monBlockCacheMiss = pInfo->blockCacheMiss;
+  monBlockCacheEvicted = pInfo->blockCacheEvicted;
+
+  int64_t ts = taosGetTimestampUs();
+  char *  sql = tsMonitor.sql;
+  snprintf(sql, SQL_LENGTH,
+           "insert into %s.block_cache_%d values(%" PRId64 ", %" PRId64 ", %" PRId64 ", %" PRId64 ", %f, %" PRId64 ")",
+           tsMonitorDbName, dnodeGetDnodeId(), ts, pInfo->blockCacheSize, hits, misses, hitRate, evictions);
+
+  void *res = taos_query(tsMonitor.conn, tsMonitor.sql);
+  int32_t code = taos_errno(res);
+  taos_free_result(res);
+
+  if (code != 0) {
+    monError("failed to save block_cache_%d info, reason:%s, sql:%s", dnodeGetDnodeId(), tstrerror(code), tsMonitor.sql);
+  } else {
+    monIncSubmitReqCnt();
+    monDebug("successfully to save block_cache_%d info, sql:%s", dnodeGetDnodeId(), tsMonitor.sql);
+  }
+}
+
+// Same as the block cache, the commits of the interval and what they cost are saved, write_amp being the bytes written
+// to the files for each byte committed from the memtables
+static void monSaveCommitInfo() {
+  SVnodeStatisInfo *pInfo = &tsMonStat.vInfo;
+  SVnodeStatisInfo *pLast = &monCommitInfo;
+
+  int64_t commits = MAX(pInfo->commits - pLast->commits, 0);
+  int64_t rows = MAX(pInfo->commitRows - pLast->commitRows, 0);
+  int64_t bytesIn = MAX(pInfo->commitBytesIn - pLast->commitBytesIn, 0);
+  int64_t bytesRead = MAX(pInfo->commitBytesRead - pLast->commitBytesRead, 0);
+  int64_t bytesWritten = MAX(pInfo->commitBytesWritten - pLast->commitBytesWritten, 0);
+  int64_t lastWritten = MAX(pInfo->commitLastWritten - pLast->commitLastWritten, 0);
+  int64_t totalUs = MAX(pInfo->commitTotalUs - pLast->commitTotalUs, 0);
+  int64_t iterUs = MAX(pInfo->commitIterUs - pLast->commitIterUs, 0);
+  int64_t loadUs = MAX(pInfo->commitLoadUs - pLast->commitLoadUs, 0);
+  int64_t encodeUs = MAX(pInfo->commitEncodeUs - pLast->commitEncodeUs, 0);
+  int64_t writeUs = MAX(pInfo->commitWriteUs - pLast->commitWriteUs, 0);
+  int64_t fsyncUs = MAX(pInfo->commitFsyncUs - pLast->commitFsyncUs, 0);
+  float   writeAmp = (bytesIn > 0) ? (float)bytesWritten / bytesIn : 0.0f;
+
+  *pLast = *pInfo;
+
+  int64_t ts = taosGetTimestampUs();
+  char *  sql = tsMonitor.sql;
+  snprintf(sql, SQL_LENGTH,
+           "insert into %s.commit_%d values(%" PRId64 ", %" PRId64 ", %" PRId64 ", %" PRId64 ", %" PRId64 ", %" PRId64
+           ", %" PRId64 ", %f, %" PRId64 ", %" PRId64 ", %" PRId64 ", %" PRId64 ", %" PRId64 ", %" PRId64 ")",
+           tsMonitorDbName, dnodeGetDnodeId(), ts, commits, rows, bytesIn, bytesRead, bytesWritten, lastWritten,
+           writeAmp, totalUs, iterUs, loadUs, encodeUs, writeUs, fsyncUs);
+
+  void *res = taos_query(tsMonitor.conn, tsMonitor.sql);
+  int32_t code = taos_errno(res);
+  taos_free_result(res);
+
+  if (code != 0) {
+    monError("failed to save commit_%d info, reason:%s, sql:%s", dnodeGetDnodeId(), tstrerror(code), tsMonitor.sql);
+  } else {
+    monIncSubmitReqCnt();
+    monDebug("successfully to save commit_%d info, sql:%s", dnodeGetDnodeId(), tsMonitor.sql);
+  }
+}
+
 static void monExecSqlCb(void *param, TAOS_RES *result, int32_t code) {
   int32_t c = taos_errno(result);
   if (c != TSDB_CODE_SUCCESS) {
@@ -259,6 +259,36 @@ extern int32_t functionCompatList[]; // compatible check array list
 
 bool topbot_datablock_filter(SQLFunctionCtx *pCtx, const char *minval, const char *maxval);
 
+// levels of the batch kernels of the aggregate functions, AGG_VEC_OFF aggregates row by row
+#define AGG_VEC_OFF    0
+#define AGG_VEC_SCALAR 1
+#define AGG_VEC_AVX2   2
+#define AGG_VEC_AVX512 3
+
+/*
+ * Batch kernels of the aggregate functions on a column of one numeric type. Each of them skips the null values of the
+ * column if hasNull is set, and returns the number of values aggregated.
+ *
+ * sum adds the values to an int64_t, uint64_t or double by the signedness of the type, dsum adds them to a double.
+ * minmax keeps the min and the max value of the column in its type, they are left untouched if all values are null.
+ * A float column with a NaN value is not aggregated by minmax and -1 is returned. sqdiff adds the square of the
+ * difference of each value to avg. The results are the same as aggregated row by row, the doubles are added in the
+ * row order.
+ */
+typedef struct SAggVecKernels {
+  int32_t (*sum)(const void *data, int32_t numOfRows, bool hasNull, void *sum);
+  int32_t (*dsum)(const void *data, int32_t numOfRows, bool hasNull, double *sum);
+  int32_t (*minmax)(const void *data, int32_t numOfRows, bool hasNull, void *min, void *max);
+  int32_t (*sqdiff)(const void *data, int32_t numOfRows, bool hasNull, double avg, double *res);
+} SAggVecKernels;
+
+// the kernels of the type at the level in use, NULL if the functions aggregate the type row by row
+const SAggVecKernels *aggGetVecKernels(int32_t type);
+int32_t aggVecLevel();
+// set the level of the kernels used from now on, for tests and benchmarks. It is capped by the CPU and the level set
+// is returned
+int32_t aggSetVecLevel(int32_t level);
+
 /**
  * the numOfRes should be kept, since it may be used later
  * and allow the ResultInfo to be re initialized
@@ -28,6 +28,7 @@
 #include "taosdef.h"
 #include "tarray.h"
 #include "tlockfree.h"
+#include "tsched.h"
 #include "tsdb.h"
 #include "qUdf.h"
 
@@ -359,6 +360,8 @@ enum OPERATOR_TYPE_E {
   OP_TimeEvery         = 23,
   OP_AllMultiTableTimeInterval = 24,
   OP_Order             = 25,
+  OP_ParallelAggregate = 26,   // super table aggregation run by the query workers
+  OP_TopN              = 27,   // the first rows in the order of an order by + limit query
 };
 
 typedef struct SOperatorInfo {
@@ -428,6 +431,7 @@ typedef struct SQueryParam {
   int32_t          tableScanOperator;
   SArray          *pOperator;
   SUdfInfo        *pUdfInfo;
+  int32_t          colCondLen;
 } SQueryParam;
 
 typedef struct SColumnDataParam{
@@ -457,6 +461,8 @@ typedef struct STableScanInfo {
 
   int32_t         tableIndex;
   int32_t         prevGroupId;     // previous table group id
+
+  struct SParallelAggInfo *pParallel;  // morsels of tables taken by the scan of a query worker
 } STableScanInfo;
 
 typedef struct STagScanInfo {
@@ -476,10 +482,32 @@ typedef struct SOptrBasicInfo {
 typedef struct SOptrBasicInfo STableIntervalOperatorInfo;
 
 typedef struct SAggOperatorInfo {
-  SOptrBasicInfo binfo;
-  uint32_t       seed;
+  SOptrBasicInfo   binfo;
+  uint32_t         seed;
+  STableGroupInfo *pBatches;      // the table groups aggregated one batch after another, NULL if all at once
+  int32_t          numOfBatches;
+  int32_t          nextBatch;
 } SAggOperatorInfo;
 
+typedef struct SParallelAggInfo {
+  SQInfo          *pQInfo;        // the query aggregated by the workers
+  int32_t          numOfWorkers;
+  SQInfo         **pWorkers;      // each worker aggregates the morsels it takes in a runtime env of its own
+  int32_t          numOfMorsels;
+  STableGroupInfo *pMorsels;      // the tables of the query, cut into morsels
+  int32_t          nextMorsel;
+  int32_t          bufSize;       // in-memory size of the result buffer of each worker
+  int64_t          reservedBuf;   // bytes of the query buffer taken by the result buffers of the workers
+  int32_t          code;
+  tsem_t           done;
+
+  pthread_mutex_t  lock;          // used to append the partial results of the workers
+  SSDataBlock     *pGather;       // partial results of all workers, merged by the client as those of other vnodes
+  int32_t          capacity;
+  int32_t          offset;        // rows of pGather already returned
+  SSDataBlock     *pRes;
+} SParallelAggInfo;
+
 typedef struct SProjectOperatorInfo {
   SOptrBasicInfo binfo;
   int32_t        bufCapacity;
@@ -542,10 +570,38 @@ typedef struct SFillOperatorInfo {
   bool         multigroupResult;
 } SFillOperatorInfo;
 
+// a partition of the rows of the groups that are not kept in memory by a group by query, written to a temp file
+typedef struct SGroupbySpillPart {
+  char     path[PATH_MAX];
+  FILE    *file;
+  int32_t  level;       // level of the partition, the partitions of a level are split by the next bits of the hash
+  int64_t  numOfRows;   // number of rows written to the file
+  STableQueryInfo *pTableInfo;  // the table of the buffered rows
+  int32_t  bufRows;     // number of rows buffered before writing to the file
+  char    *pBuf;        // buffered rows, column by column
+} SGroupbySpillPart;
+
+typedef struct SGroupbySpillInfo {
+  int32_t             maxGroups;  // max number of groups in memory, the rows of the other groups go to the partitions
+  int32_t             level;      // level of the current pass, 0 for the rows from the upstream
+  int32_t             capacity;   // max number of rows buffered for a partition
+  int32_t             numOfCols;
+  int32_t            *colOffset;  // offset of each column in a row
+  int32_t             rowSize;
+  SGroupbySpillPart **pParts;     // partitions of the current pass
+  SArray             *pPending;   // SArray<SGroupbySpillPart*>, partitions to be aggregated
+  SGroupbySpillPart  *pCurrent;   // partition being aggregated
+  SSDataBlock        *pBlock;     // block of the rows read from a partition
+  int64_t             spilledRows;
+  int32_t             numOfParts;
+  bool                overBudget; // the groups of the current pass exceed the budget and can not be spilled
+} SGroupbySpillInfo;
+
 typedef struct SGroupbyOperatorInfo {
-  SOptrBasicInfo binfo;
-  int32_t        colIndex;
-  char          *prevData;   // previous group by value
+  SOptrBasicInfo     binfo;
+  int32_t            colIndex;
+  char              *prevData;   // previous group by value
+  SGroupbySpillInfo *pSpill;     // NULL if the group states are never spilled
 } SGroupbyOperatorInfo;
 
 typedef struct SSWindowOperatorInfo {
@@ -613,6 +669,22 @@ typedef struct SOrderOperatorInfo {
   SSDataBlock *pDataBlock;
 } SOrderOperatorInfo;
 
+typedef struct STopNOperatorInfo {
+  SSDataBlock  *pRes;
+  int32_t       colIndex;
+  __compar_fn_t comparFn;
+  int32_t       limit;      // the number of rows to keep
+  int32_t       numOfRows;  // the number of rows kept
+  int32_t       capacity;
+  int32_t       rowSize;
+  int32_t      *colOffset;  // the offset of each column in a kept row
+  int32_t       keyOffset;  // the offset of the order column in a kept row
+  int32_t      *pSlots;     // the slots of the kept rows, a max heap with the last row in the order on the top once full
+  char         *pRows;
+  int32_t       rowIndex;   // the next row to return
+  int64_t       totalRows;  // the number of rows from upstream
+} STopNOperatorInfo;
+
 void appendUpstream(SOperatorInfo* p, SOperatorInfo* pUpstream);
 
 SOperatorInfo* createDataBlocksOptScanInfo(void* pTsdbQueryHandle, SQueryRuntimeEnv* pRuntimeEnv, int32_t repeatTime, int32_t reverseTime);
@@ -642,6 +714,8 @@ SOperatorInfo* createFilterOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperator
 
 SOperatorInfo* createJoinOperatorInfo(SOperatorInfo** pUpstream, int32_t numOfUpstream, SSchema* pSchema, int32_t numOfOutput);
 SOperatorInfo* createOrderOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperatorInfo* upstream, SExprInfo* pExpr, int32_t numOfOutput, SOrderVal* pOrderVal);
+SOperatorInfo* createTopNOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperatorInfo* upstream, SExprInfo* pExpr, int32_t numOfOutput, SOrderVal* pOrderVal, int32_t limit);
+SOperatorInfo* createParallelAggOperatorInfo(SQInfo* pQInfo, SOperatorInfo* upstream, char* colCond, int32_t colCondLen);
 
 SSDataBlock* doGlobalAggregate(void* param, bool* newgroup);
 SSDataBlock* doMultiwayMergeSort(void* param, bool* newgroup);
@@ -715,6 +789,9 @@ void freeQueryAttr(SQueryAttr *pQuery);
 
 int32_t getMaximumIdleDurationSec();
 
+int32_t qQueryWorkers();
+void    qScheduleQueryWork(void (*fp)(SSchedMsg *), void *ahandle, void *thandle);
+
 void doInvokeUdf(SUdfInfo* pUdfInfo, SQLFunctionCtx *pCtx, int32_t idx, int32_t type);
 int32_t getColumnDataFromId(void *param, int32_t id, void **data);
 
@@ -36,6 +36,11 @@ extern "C" {
 
 #define FILTER_RM_UNIT_MIN_ROWS 100
 
+// levels of the batch kernels of the filter units, FILTER_VEC_OFF evaluates every unit row by row
+#define FILTER_VEC_OFF    0
+#define FILTER_VEC_SCALAR 1
+#define FILTER_VEC_AVX2   2
+
 enum {
   FLD_TYPE_COLUMN = 1,
   FLD_TYPE_VALUE = 2,  
@@ -104,6 +109,9 @@ typedef struct SFilterRange {
 typedef bool (*rangeCompFunc) (const void *, const void *, const void *, const void *, __compar_fn_t);
 typedef int32_t(*filter_desc_compare_func)(const void *, const void *);
 typedef bool(*filter_exec_func)(void *, int32_t, int8_t**, SDataStatis *, int16_t);
+// sets res[i] to whether row i of a column matches the unit, null rows only match IS NULL
+typedef void (*filter_vec_func)(const void *colData, int32_t numOfRows, const void *valData, const void *valData2,
+                                int8_t *res);
 typedef int32_t (*filer_get_col_from_id)(void *, int32_t, void **);
 typedef int32_t (*filer_get_col_from_name)(void *, int32_t, char*, void **);
 
@@ -212,6 +220,7 @@ typedef struct SFilterComUnit {
   uint8_t optr;
   int8_t func;
   int8_t rfunc;
+  filter_vec_func vfunc;  // NULL if the unit is evaluated row by row
 } SFilterComUnit;
 
 typedef struct SFilterPCtx {
@@ -337,6 +346,12 @@ extern bool filterRangeExecute(SFilterInfo *info, SDataStatis *pDataStatis, int3
 extern int32_t filterIsIndexedColumnQuery(SFilterInfo* info, int32_t idxId, bool *res);
 extern int32_t filterGetIndexedColumnInfo(SFilterInfo* info, char** val, int32_t *order, int32_t *flag);
 
+extern filter_vec_func filterGetVecFunc(SFilterComUnit *cunit);
+extern int32_t filterVecLevel();
+// set the level of the kernels of the filters created from now on, for tests and benchmarks. It is capped by the CPU
+// and the level set is returned
+extern int32_t filterSetVecLevel(int32_t level);
+
 #ifdef __cplusplus
 }
 #endif
@@ -53,5 +53,6 @@ char* queryPlanToString(SQueryNode* pQueryNode);
 SArray* createTableScanPlan(SQueryAttr* pQueryAttr);
 SArray* createExecOperatorPlan(SQueryAttr* pQueryAttr);
 SArray* createGlobalMergePlan(SQueryAttr* pQueryAttr);
+int32_t getTopNRows(SQueryAttr* pQueryAttr);
 
 #endif  // TDENGINE_QPLAN_H
@@ -144,6 +144,12 @@ size_t getResBufSize(const SDiskbasedResultBuf* pResultBuf);
  */
 size_t getNumOfResultBufGroupId(const SDiskbasedResultBuf* pResultBuf);
 
+/**
+ * release all pages of the result buffer, the page id starts from 0 again
+ * @param pResultBuf
+ */
+void resetResultBuf(SDiskbasedResultBuf* pResultBuf);
+
 /**
  * destroy result buffer
  * @param pResultBuf
@@ -0,0 +1,316 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "os.h"
+#include "qAggMain.h"
+#include "taosdef.h"
+
+// Batch kernels of sum, avg, min, max, stddev and spread on fixed size columns. A null value is told by its bits and
+// replaced by the identity of the aggregation with a mask instead of a branch, so that the compiler vectorizes the
+// loops. The kernels give the same results as the row loops of qAggMain.c: the integers are reduced into one
+// accumulator, their sums and bounds not depending on the order, and the bounds of the floats are kept in
+// AGG_VEC_LANES partial results. The doubles are added in the row order into the sum given, since adding them in
+// another order changes the result. The AVX2 and AVX-512 versions are built for the CPUs supporting them.
+
+#if defined(__x86_64__) && !defined(WINDOWS) && !defined(_TD_ARM_) && !defined(_TD_MIPS_)
+#define AGG_VEC_X86
+#define AGG_VEC_ATTR_AVX2   __attribute__((target("avx2")))
+#define AGG_VEC_ATTR_AVX512 __attribute__((target("avx512f,avx512bw,avx512vl,avx512dq,prefer-vector-width=512")))
+#endif
+
+#define AGG_VEC_LANES 16
+
+#define AGG_VEC_FLOAT_INF_BITS      0x7F800000u
+#define AGG_VEC_FLOAT_NEG_INF_BITS  0xFF800000u
+#define AGG_VEC_DOUBLE_INF_BITS     0x7FF0000000000000ull
+#define AGG_VEC_DOUBLE_NEG_INF_BITS 0xFFF0000000000000ull
+
+// The body is run for the value k, in a loop where nulls tells if the block has nulls. The body of a flat loop reduces
+// into one accumulator, that of a lane loop into the lane j.
+#define AGG_VEC_FLAT_LOOP(body)                 \
+  if (hasNull) {                                \
+    for (int32_t k = 0; k < numOfRows; ++k) {   \
+      const bool nulls = true;                  \
+      body;                                     \
+    }                                           \
+  } else {                                      \
+    for (int32_t k = 0; k < numOfRows; ++k) {   \
+      const bool nulls = false;                 \
+      body;                                     \
+    }                                           \
+  }
+
+#define AGG_VEC_LANE_LOOP(body)                                      \
+  int32_t i = 0;                                                     \
+  if (hasNull) {                                                     \
+    for (; i + AGG_VEC_LANES <= numOfRows; i += AGG_VEC_LANES) {     \
+      for (int32_t j = 0; j < AGG_VEC_LANES; ++j) {                  \
+        const bool    nulls = true;                                  \
+        const int32_t k = i + j;                                     \
+        body;                                                        \
+      }                                                              \
+    }                                                                \
+  } else {                                                           \
+    for (; i + AGG_VEC_LANES <= numOfRows; i += AGG_VEC_LANES) {     \
+      for (int32_t j = 0; j < AGG_VEC_LANES; ++j) {                  \
+        const bool    nulls = false;                                 \
+        const int32_t k = i + j;                                     \
+        body;                                                        \
+      }                                                              \
+    }                                                                \
+  }                                                                  \
+  for (int32_t j = 0; i < numOfRows; ++i) {                          \
+    const bool    nulls = hasNull;                                   \
+    const int32_t k = i;                                             \
+    body;                                                            \
+  }
+
+// x is the value k of type T, or the identity given by its bits idBits of type B if the value is the null N
+#define AGG_VEC_GET(T, B, N, x, idBits)                    \
+  T x;                                                     \
+  if (nulls) {                                             \
+    B bits_ = b[k];                                        \
+    B mask_ = (B)0 - (B)(bits_ != (B)(N));                 \
+    bits_ = (bits_ & mask_) | ((B)(idBits) & ~mask_);      \
+    memcpy(&x, &bits_, sizeof(T));                         \
+  } else {                                                 \
+    x = v[k];                                              \
+  }
+
+#define AGG_VEC_NOT_NULL(B, N) (nulls ? (int32_t)(b[k] != (B)(N)) : 1)
+
+// the values not null are counted apart from the lanes of doubles, a NaN among them is told by nan
+#define AGG_VEC_COUNT_KERNEL(attr, fname, T, B, N, ISNAN)                                             \
+  attr static int32_t fname(const T *v, const B *b, int32_t numOfRows, bool hasNull, int32_t *nan) { \
+    int32_t count = 0;                                                                               \
+    int32_t nans = 0;                                                                                \
+    AGG_VEC_FLAT_LOOP(AGG_VEC_GET(T, B, N, x, 0); count += AGG_VEC_NOT_NULL(B, N); nans |= ISNAN(x)) \
+    *nan = nans;                                                                                     \
+    return count;                                                                                    \
+  }
+
+#define AGG_VEC_ISUM_KERNEL(attr, fname, T, B, N, S)                                         \
+  attr static int32_t fname(const void *data, int32_t numOfRows, bool hasNull, void *sum) { \
+    const T *v = (const T *)data;                                                          \
+    const B *b = (const B *)data;                                                          \
+    S        total = 0;                                                                    \
+    int32_t  count = 0;                                                                    \
+    AGG_VEC_FLAT_LOOP(AGG_VEC_GET(T, B, N, x, 0); total += (S)x; count += AGG_VEC_NOT_NULL(B, N)) \
+    *(S *)sum += total;                                                                    \
+    return count;                                                                          \
+  }
+
+// PS is the type of the pointer to the sum, a null adds 0 to it, which leaves it as it is
+#define AGG_VEC_DSUM_KERNEL(attr, fname, cname, T, B, N, PS)                                \
+  attr static int32_t fname(const void *data, int32_t numOfRows, bool hasNull, PS *sum) { \
+    const T *v = (const T *)data;                                                         \
+    const B *b = (const B *)data;                                                         \
+    double   total = *(double *)sum;                                                      \
+    int32_t  nan = 0;                                                                     \
+    AGG_VEC_FLAT_LOOP(AGG_VEC_GET(T, B, N, x, 0); total += (double)x)                     \
+    *(double *)sum = total;                                                               \
+    return cname(v, b, numOfRows, hasNull, &nan);                                         \
+  }
+
+#define AGG_VEC_MINMAX_UPDATE(T)              \
+  if (count > 0) {                            \
+    if (vmin < *(T *)pMin) *(T *)pMin = vmin; \
+    if (vmax > *(T *)pMax) *(T *)pMax = vmax; \
+  }                                           \
+  return count;
+
+#define AGG_VEC_IMINMAX_KERNEL(attr, fname, T, B, N, LOWEST, HIGHEST)                                    \
+  attr static int32_t fname(const void *data, int32_t numOfRows, bool hasNull, void *pMin, void *pMax) { \
+    const T *v = (const T *)data;                                                                        \
+    const B *b = (const B *)data;                                                                        \
+    T        vmin = HIGHEST;                                                                             \
+    T        vmax = LOWEST;                                                                              \
+    int32_t  count = 0;                                                                                  \
+    AGG_VEC_FLAT_LOOP(AGG_VEC_GET(T, B, N, xn, (B)(T)(HIGHEST)); AGG_VEC_GET(T, B, N, xx, (B)(T)(LOWEST)); \
+                      vmin = (xn < vmin) ? xn : vmin; vmax = (xx > vmax) ? xx : vmax;                   \
+                      count += AGG_VEC_NOT_NULL(B, N))                                                   \
+    AGG_VEC_MINMAX_UPDATE(T)                                                                             \
+  }
+
+// the bounds of the floats are reduced in lanes, the row loop is left to compare a NaN
+#define AGG_VEC_FMINMAX_KERNEL(attr, fname, cname, T, B, N, INF_BITS, NEG_INF_BITS)                      \
+  attr static int32_t fname(const void *data, int32_t numOfRows, bool hasNull, void *pMin, void *pMax) { \
+    const T *v = (const T *)data;                                                                        \
+    const B *b = (const B *)data;                                                                        \
+    T        mn[AGG_VEC_LANES];                                                                          \
+    T        mx[AGG_VEC_LANES];                                                                          \
+    int32_t  nan = 0;                                                                                    \
+    for (int32_t j = 0; j < AGG_VEC_LANES; ++j) {                                                        \
+      mn[j] = INFINITY;                                                                                  \
+      mx[j] = -INFINITY;                                                                                 \
+    }                                                                                                    \
+    AGG_VEC_LANE_LOOP(AGG_VEC_GET(T, B, N, xn, INF_BITS); AGG_VEC_GET(T, B, N, xx, NEG_INF_BITS);        \
+                      mn[j] = (xn < mn[j]) ? xn : mn[j]; mx[j] = (xx > mx[j]) ? xx : mx[j])              \
+    T vmin = INFINITY;                                                                                   \
+    T vmax = -INFINITY;                                                                                  \
+    for (int32_t j = 0; j < AGG_VEC_LANES; ++j) {                                                        \
+      vmin = (mn[j] < vmin) ? mn[j] : vmin;                                                              \
+      vmax = (mx[j] > vmax) ? mx[j] : vmax;                                                              \
+    }                                                                                                    \
+    int32_t count = cname(v, b, numOfRows, hasNull, &nan);                                               \
+    if (nan) return -1;                                                                                  \
+    AGG_VEC_MINMAX_UPDATE(T)                                                                             \
+  }
+
+// the square of a null is masked to 0 in its bits, the squares are added in the row order
+#define AGG_VEC_SQDIFF_KERNEL(attr, fname, cname, T, B, N)                                                  \
+  attr static int32_t fname(const void *data, int32_t numOfRows, bool hasNull, double avg, double *res) { \
+    const T *v = (const T *)data;                                                                         \
+    const B *b = (const B *)data;                                                                         \
+    double   total = *res;                                                                                \
+    int32_t  nan = 0;                                                                                     \
+    AGG_VEC_FLAT_LOOP(double d = (double)v[k] - avg; double sq = d * d; if (nulls) {                      \
+      uint64_t bits = 0;                                                                                  \
+      memcpy(&bits, &sq, sizeof(sq));                                                                     \
+      bits &= (uint64_t)0 - (uint64_t)(b[k] != (B)(N));                                                   \
+      memcpy(&sq, &bits, sizeof(sq));                                                                     \
+    } total += sq)                                                                                        \
+    *res = total;                                                                                         \
+    return cname(v, b, numOfRows, hasNull, &nan);                                                        \
+  }
+
+#define AGG_VEC_NO_NAN(x) 0
+#define AGG_VEC_IS_NAN(x) ((x) != (x))
+
+#define AGG_VEC_INT_KERNELS(attr, sfx, name, T, B, N, S, LOWEST, HIGHEST)       \
+  AGG_VEC_COUNT_KERNEL(attr, name##Count##sfx, T, B, N, AGG_VEC_NO_NAN)         \
+  AGG_VEC_ISUM_KERNEL(attr, name##Sum##sfx, T, B, N, S)                         \
+  AGG_VEC_DSUM_KERNEL(attr, name##Dsum##sfx, name##Count##sfx, T, B, N, double) \
+  AGG_VEC_IMINMAX_KERNEL(attr, name##Minmax##sfx, T, B, N, LOWEST, HIGHEST)     \
+  AGG_VEC_SQDIFF_KERNEL(attr, name##Sqdiff##sfx, name##Count##sfx, T, B, N)
+
+#define AGG_VEC_FLOAT_KERNELS(attr, sfx, name, T, B, N, INF_BITS, NEG_INF_BITS)                   \
+  AGG_VEC_COUNT_KERNEL(attr, name##Count##sfx, T, B, N, AGG_VEC_IS_NAN)                           \
+  AGG_VEC_DSUM_KERNEL(attr, name##Sum##sfx, name##Count##sfx, T, B, N, void)                      \
+  AGG_VEC_DSUM_KERNEL(attr, name##Dsum##sfx, name##Count##sfx, T, B, N, double)                   \
+  AGG_VEC_FMINMAX_KERNEL(attr, name##Minmax##sfx, name##Count##sfx, T, B, N, INF_BITS, NEG_INF_BITS) \
+  AGG_VEC_SQDIFF_KERNEL(attr, name##Sqdiff##sfx, name##Count##sfx, T, B, N)
+
+#define AGG_VEC_KERNELS(attr, sfx)                                                                            \
+  AGG_VEC_INT_KERNELS(attr, sfx, aggInt8, int8_t, uint8_t, TSDB_DATA_TINYINT_NULL, int64_t, INT8_MIN, INT8_MAX) \
+  AGG_VEC_INT_KERNELS(attr, sfx, aggInt16, int16_t, uint16_t, TSDB_DATA_SMALLINT_NULL, int64_t, INT16_MIN,      \
+                      INT16_MAX)                                                                                \
+  AGG_VEC_INT_KERNELS(attr, sfx, aggInt32, int32_t, uint32_t, TSDB_DATA_INT_NULL, int64_t, INT32_MIN, INT32_MAX) \
+  AGG_VEC_INT_KERNELS(attr, sfx, aggInt64, int64_t, uint64_t, TSDB_DATA_BIGINT_NULL, int64_t, INT64_MIN,        \
+                      INT64_MAX)                                                                                \
+  AGG_VEC_INT_KERNELS(attr, sfx, aggUint8, uint8_t, uint8_t, TSDB_DATA_UTINYINT_NULL, uint64_t, 0, UINT8_MAX)   \
+  AGG_VEC_INT_KERNELS(attr, sfx, aggUint16, uint16_t, uint16_t, TSDB_DATA_USMALLINT_NULL, uint64_t, 0,          \
+                      UINT16_MAX)                                                                               \
+  AGG_VEC_INT_KERNELS(attr, sfx, aggUint32, uint32_t, uint32_t, TSDB_DATA_UINT_NULL, uint64_t, 0, UINT32_MAX)   \
+  AGG_VEC_INT_KERNELS(attr, sfx, aggUint64, uint64_t, uint64_t, TSDB_DATA_UBIGINT_NULL, uint64_t, 0,            \
+                      UINT64_MAX)                                                                               \
+  AGG_VEC_FLOAT_KERNELS(attr, sfx, aggFloat, float, uint32_t, TSDB_DATA_FLOAT_NULL, AGG_VEC_FLOAT_INF_BITS,      \
+                        AGG_VEC_FLOAT_NEG_INF_BITS)                                                             \
+  AGG_VEC_FLOAT_KERNELS(attr, sfx, aggDouble, double, uint64_t, TSDB_DATA_DOUBLE_NULL, AGG_VEC_DOUBLE_INF_BITS,  \
+                        AGG_VEC_DOUBLE_NEG_INF_BITS)
+
+#define AGG_VEC_TYPE_TABLE(name, sfx) \
+  { name##Sum##sfx, name##Dsum##sfx, name##Minmax##sfx, name##Sqdiff##sfx }
+
+#define AGG_VEC_TABLE(sfx)                                                                                    \
+  {                                                                                                           \
+    AGG_VEC_TYPE_TABLE(aggInt8, sfx), AGG_VEC_TYPE_TABLE(aggInt16, sfx), AGG_VEC_TYPE_TABLE(aggInt32, sfx),   \
+        AGG_VEC_TYPE_TABLE(aggInt64, sfx), AGG_VEC_TYPE_TABLE(aggUint8, sfx),                                 \
+        AGG_VEC_TYPE_TABLE(aggUint16, sfx), AGG_VEC_TYPE_TABLE(aggUint32, sfx),                               \
+        AGG_VEC_TYPE_TABLE(aggUint64, sfx), AGG_VEC_TYPE_TABLE(aggFloat, sfx),                                \
+        AGG_VEC_TYPE_TABLE(aggDouble, sfx)                                                                    \
+  }
+
+enum {
+  AGG_VEC_INT8,
+  AGG_VEC_INT16,
+  AGG_VEC_INT32,
+  AGG_VEC_INT64,
+  AGG_VEC_UINT8,
+  AGG_VEC_UINT16,
+  AGG_VEC_UINT32,
+  AGG_VEC_UINT64,
+  AGG_VEC_FLOAT,
+  AGG_VEC_DOUBLE,
+  AGG_VEC_TYPES
+};
+
+AGG_VEC_KERNELS(, )
+#ifdef AGG_VEC_X86
+AGG_VEC_KERNELS(AGG_VEC_ATTR_AVX2, Avx2)
+AGG_VEC_KERNELS(AGG_VEC_ATTR_AVX512, Avx512)
+#endif
+
+static const SAggVecKernels aggVecKernels[][AGG_VEC_TYPES] = {
+    AGG_VEC_TABLE(),
+#ifdef AGG_VEC_X86
+    AGG_VEC_TABLE(Avx2),
+    AGG_VEC_TABLE(Avx512),
+#endif
+};
+
+static int32_t aggVecLevelSet = -1;
+
+static int32_t aggCpuVecLevel() {
+#ifdef AGG_VEC_X86
+  int32_t cpuLevel = taosGetCpuSimdLevel();
+  if (cpuLevel >= TAOS_CPU_SIMD_AVX512) return AGG_VEC_AVX512;
+  if (cpuLevel >= TAOS_CPU_SIMD_AVX2) return AGG_VEC_AVX2;
+#endif
+  return AGG_VEC_SCALAR;
+}
+
+int32_t aggVecLevel() {
+  // resolved by the first aggregation, the threads resolving it together store the same level
+  int32_t level = atomic_load_32(&aggVecLevelSet);
+  if (level < 0) {
+    atomic_val_compare_exchange_32(&aggVecLevelSet, -1, aggCpuVecLevel());
+    level = atomic_load_32(&aggVecLevelSet);
+  }
+  return level;
+}
+
+int32_t aggSetVecLevel(int32_t level) {
+  int32_t cpuLevel = aggCpuVecLevel();
+  if (level > cpuLevel) level = cpuLevel;
+  if (level < AGG_VEC_OFF) level = AGG_VEC_OFF;
+
+  atomic_store_32(&aggVecLevelSet, level);
+  return level;
+}
+
+static int32_t aggVecType(int32_t type) {
+  switch (type) {
+    case TSDB_DATA_TYPE_TINYINT:   return AGG_VEC_INT8;
+    case TSDB_DATA_TYPE_SMALLINT:  return AGG_VEC_INT16;
+    case TSDB_DATA_TYPE_INT:       return AGG_VEC_INT32;
+    case TSDB_DATA_TYPE_BIGINT:
+    case TSDB_DATA_TYPE_TIMESTAMP: return AGG_VEC_INT64;
+    case TSDB_DATA_TYPE_UTINYINT:  return AGG_VEC_UINT8;
+    case TSDB_DATA_TYPE_USMALLINT: return AGG_VEC_UINT16;
+    case TSDB_DATA_TYPE_UINT:      return AGG_VEC_UINT32;
+    case TSDB_DATA_TYPE_UBIGINT:   return AGG_VEC_UINT64;
+    case TSDB_DATA_TYPE_FLOAT:     return AGG_VEC_FLOAT;
+    case TSDB_DATA_TYPE_DOUBLE:    return AGG_VEC_DOUBLE;
+    default:                       return -1;
+  }
+}
+
+const SAggVecKernels *aggGetVecKernels(int32_t type) {
+  int32_t level = aggVecLevel();
+  int32_t vtype = aggVecType(type);
+
+  if (level == AGG_VEC_OFF || vtype < 0) return NULL;
+  return &aggVecKernels[level - AGG_VEC_SCALAR][vtype];
+}
@@ -643,13 +643,12 @@ int32_t noDataRequired(SQLFunctionCtx *pCtx, STimeWindow* w, int32_t colId) {
     }                                                              \
   } while(0)
 
-#define UPDATE_DATA(ctx, left, right, num, sign, k) \
-  do {                                              \
-    if (((left) < (right)) ^ (sign)) {              \
-      (left) = (right);                             \
-      DO_UPDATE_TAG_COLUMNS(ctx, k);                \
-      (num) += 1;                                   \
-    }                                               \
+#define UPDATE_DATA(ctx, left, right, sign, k) \
+  do {                                         \
+    if (((left) < (right)) ^ (sign)) {         \
+      (left) = (right);                        \
+      DO_UPDATE_TAG_COLUMNS(ctx, k);           \
+    }                                          \
   } while (0)
 
 #define DUPATE_DATA_WITHOUT_TS(ctx, left, right, num, sign) \
@@ -667,7 +666,8 @@ int32_t noDataRequired(SQLFunctionCtx *pCtx, STimeWindow* w, int32_t colId) {
       continue;                                                   \
     }                                                             \
     TSKEY key = (ctx)->ptsList != NULL? GET_TS_DATA(ctx, i):0;    \
-    UPDATE_DATA(ctx, val, (list)[i], num, sign, key);             \
+    UPDATE_DATA(ctx, val, (list)[i], sign, key);                  \
+    (num) += 1;                                                   \
   }
 
 #define TYPED_LOOPCHECK_N(type, data, list, ctx, tsdbType, sign, notNullElems) \
@@ -697,9 +697,13 @@ static void do_sum(SQLFunctionCtx *pCtx) {
     }
   } else {  // computing based on the true data block
     void *pData = GET_INPUT_DATA_LIST(pCtx);
+    const SAggVecKernels *pKernels = aggGetVecKernels(pCtx->inputType);
     notNullElems = 0;
 
-    if (IS_SIGNED_NUMERIC_TYPE(pCtx->inputType)) {
+    if (pKernels != NULL) {
+      // the same as added row by row, the floats are added in the row order
+      notNullElems = pKernels->sum(pData, pCtx->size, pCtx->hasNull, pCtx->pOutput);
+    } else if (IS_SIGNED_NUMERIC_TYPE(pCtx->inputType)) {
       int64_t *retVal = (int64_t *)pCtx->pOutput;
 
       if (pCtx->inputType == TSDB_DATA_TYPE_TINYINT) {
@@ -886,8 +890,22 @@ static void avg_function(SQLFunctionCtx *pCtx) {
     }
   } else {
     void *pData = GET_INPUT_DATA_LIST(pCtx);
-
-    if (pCtx->inputType == TSDB_DATA_TYPE_TINYINT) {
+    const SAggVecKernels *pKernels = aggGetVecKernels(pCtx->inputType);
+
+    if (pKernels != NULL && IS_SIGNED_NUMERIC_TYPE(pCtx->inputType) && pCtx->inputBytes < sizeof(int64_t)) {
+      // the sum of a block of integers up to 32 bits is exact in a double, so it is the same as added row by row
+      int64_t sum = 0;
+      notNullElems = pKernels->sum(pData, pCtx->size, pCtx->hasNull, &sum);
+      *pVal += sum;
+    } else if (pKernels != NULL && IS_UNSIGNED_NUMERIC_TYPE(pCtx->inputType) && pCtx->inputBytes < sizeof(uint64_t)) {
+      uint64_t sum = 0;
+      notNullElems = pKernels->sum(pData, pCtx->size, pCtx->hasNull, &sum);
+      *pVal += sum;
+    } else if (pKernels != NULL) {
+      // a 64 bit integer may be rounded as it is added to the double, so bigint and unsigned bigint are added one by
+      // one in the row order like the floats
+      notNullElems = pKernels->dsum(pData, pCtx->size, pCtx->hasNull, pVal);
+    } else if (pCtx->inputType == TSDB_DATA_TYPE_TINYINT) {
       LIST_ADD_N(*pVal, pCtx, pData, int8_t, notNullElems, pCtx->inputType);
     } else if (pCtx->inputType == TSDB_DATA_TYPE_SMALLINT) {
       LIST_ADD_N(*pVal, pCtx, pData, int16_t, notNullElems, pCtx->inputType);
@@ -1022,11 +1040,11 @@ static void minMax_function(SQLFunctionCtx *pCtx, char *pOutput, int32_t isMin,
       if (pCtx->inputType == TSDB_DATA_TYPE_TINYINT) {
         int8_t *data = (int8_t *)pOutput;
 
-        UPDATE_DATA(pCtx, *data, (int8_t)val, notNullElems, isMin, key);
+        UPDATE_DATA(pCtx, *data, (int8_t)val, isMin, key);
       } else if (pCtx->inputType == TSDB_DATA_TYPE_SMALLINT) {
         int16_t *data = (int16_t *)pOutput;
 
-        UPDATE_DATA(pCtx, *data, (int16_t)val, notNullElems, isMin, key);
+        UPDATE_DATA(pCtx, *data, (int16_t)val, isMin, key);
       } else if (pCtx->inputType == TSDB_DATA_TYPE_INT) {
         int32_t *data = (int32_t *)pOutput;
 #if defined(_DEBUG_VIEW)
@@ -1047,34 +1065,34 @@ static void minMax_function(SQLFunctionCtx *pCtx, char *pOutput, int32_t isMin,
         }
       } else if (pCtx->inputType == TSDB_DATA_TYPE_BIGINT) {
         int64_t *data = (int64_t *)pOutput;
-        UPDATE_DATA(pCtx, *data, val, notNullElems, isMin, key);
+        UPDATE_DATA(pCtx, *data, val, isMin, key);
       }
     } else if (IS_UNSIGNED_NUMERIC_TYPE(pCtx->inputType)) {
       uint64_t val = GET_UINT64_VAL(tval);
       if (pCtx->inputType == TSDB_DATA_TYPE_UTINYINT) {
         uint8_t *data = (uint8_t *)pOutput;
 
-        UPDATE_DATA(pCtx, *data, (uint8_t)val, notNullElems, isMin, key);
+        UPDATE_DATA(pCtx, *data, (uint8_t)val, isMin, key);
       } else if (pCtx->inputType == TSDB_DATA_TYPE_USMALLINT) {
         uint16_t *data = (uint16_t *)pOutput;
-        UPDATE_DATA(pCtx, *data, (uint16_t)val, notNullElems, isMin, key);
+        UPDATE_DATA(pCtx, *data, (uint16_t)val, isMin, key);
       } else if (pCtx->inputType == TSDB_DATA_TYPE_UINT) {
         uint32_t *data = (uint32_t *)pOutput;
-        UPDATE_DATA(pCtx, *data, (uint32_t)val, notNullElems, isMin, key);
+        UPDATE_DATA(pCtx, *data, (uint32_t)val, isMin, key);
       } else if (pCtx->inputType == TSDB_DATA_TYPE_UBIGINT) {
         uint64_t *data = (uint64_t *)pOutput;
-        UPDATE_DATA(pCtx, *data, val, notNullElems, isMin, key);
+        UPDATE_DATA(pCtx, *data, val, isMin, key);
       }
     } else if (pCtx->inputType == TSDB_DATA_TYPE_DOUBLE) {
         double *data = (double *)pOutput;
         double  val = GET_DOUBLE_VAL(tval);
 
-        UPDATE_DATA(pCtx, *data, val, notNullElems, isMin, key);
+        UPDATE_DATA(pCtx, *data, val, isMin, key);
     } else if (pCtx->inputType == TSDB_DATA_TYPE_FLOAT) {
       float *data = (float *)pOutput;
       double val = GET_DOUBLE_VAL(tval);
 
-      UPDATE_DATA(pCtx, *data, (float)val, notNullElems, isMin, key);
+      UPDATE_DATA(pCtx, *data, (float)val, isMin, key);
     }
 
     return;
@@ -1083,6 +1101,26 @@ static void minMax_function(SQLFunctionCtx *pCtx, char *pOutput, int32_t isMin,
   void  *p = GET_INPUT_DATA_LIST(pCtx);
   TSKEY *tsList = GET_TS_LIST(pCtx);
 
+  const SAggVecKernels *pKernels = aggGetVecKernels(pCtx->inputType);
+  if (pKernels != NULL && pCtx->tagInfo.numOfTagCols == 0) {
+    // no tag or timestamp to be updated with the value, the other bound is found in a copy which is thrown away
+    int64_t other = 0;
+    int32_t num = 0;
+    memcpy(&other, pOutput, pCtx->inputBytes);
+
+    if (isMin) {
+      num = pKernels->minmax(p, pCtx->size, pCtx->hasNull, pOutput, &other);
+    } else {
+      num = pKernels->minmax(p, pCtx->size, pCtx->hasNull, &other, pOutput);
+    }
+
+    // a NaN in the block is compared row by row like before
+    if (num >= 0) {
+      *notNullElems = num;
+      return;
+    }
+  }
+
   *notNullElems = 0;
 
   if (IS_SIGNED_NUMERIC_TYPE(pCtx->inputType)) {
@@ -1403,6 +1441,13 @@ static void stddev_function(SQLFunctionCtx *pCtx) {
     void *pData = GET_INPUT_DATA_LIST(pCtx);
     int32_t num = 0;
 
+    const SAggVecKernels *pKernels = aggGetVecKernels(pCtx->inputType);
+    if (pKernels != NULL) {
+      pKernels->sqdiff(pData, pCtx->size, pCtx->hasNull, avg, retVal);
+      SET_VAL(pCtx, 1, 1);
+      return;
+    }
+
     switch (pCtx->inputType) {
       case TSDB_DATA_TYPE_INT: {
         for (int32_t i = 0; i < pCtx->size; ++i) {
@@ -3545,6 +3590,42 @@ static void spread_function(SQLFunctionCtx *pCtx) {
   
   void *pData = GET_INPUT_DATA_LIST(pCtx);
   numOfElems = 0;
+
+  const SAggVecKernels *pKernels = aggGetVecKernels(pCtx->inputType);
+  if (pKernels != NULL) {
+    // the bounds start from the first value in the type of the column, the conversion to double keeps their order
+    int32_t first = 0;
+    while (first < pCtx->size && pCtx->hasNull &&
+           isNull((char *)pData + first * pCtx->inputBytes, pCtx->inputType)) {
+      ++first;
+    }
+
+    if (first == pCtx->size) {
+      goto _spread_over;
+    }
+
+    int64_t min = 0, max = 0;
+    memcpy(&min, (char *)pData + first * pCtx->inputBytes, pCtx->inputBytes);
+    memcpy(&max, &min, sizeof(min));
+
+    // a NaN in the block is compared row by row like before
+    int32_t num = pKernels->minmax(pData, pCtx->size, pCtx->hasNull, &min, &max);
+    if (num >= 0) {
+      double v = 0;
+      GET_TYPED_DATA(v, double, pCtx->inputType, &min);
+      if (v < pInfo->min) {
+        pInfo->min = v;
+      }
+
+      GET_TYPED_DATA(v, double, pCtx->inputType, &max);
+      if (v > pInfo->max) {
+        pInfo->max = v;
+      }
+
+      numOfElems = num;
+      goto _spread_over;
+    }
+  }
   
   if (pCtx->inputType == TSDB_DATA_TYPE_TINYINT) {
     LIST_MINMAX_N(pCtx, pInfo->min, pInfo->max, pCtx->size, pData, int8_t, pCtx->inputType, numOfElems);
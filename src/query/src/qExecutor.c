@@ -21,6 +21,7 @@
 #include "hash.h"
 #include "texpr.h"
 #include "qExecutor.h"
+#include "qPlan.h"
 #include "qResultbuf.h"
 #include "qUtil.h"
 #include "queryLog.h"
@@ -222,6 +223,8 @@ static SColumnInfo* extractColumnFilterInfo(SExprInfo* pExpr, int32_t numOfOutpu
 
 static int32_t setTimestampListJoinInfo(SQueryRuntimeEnv* pRuntimeEnv, tVariant* pTag, STableQueryInfo *pTableQueryInfo);
 static void releaseQueryBuf(size_t numOfTables);
+static int32_t acquireQueryBuf(int64_t t);
+static void releaseQueryBufBytes(int64_t t);
 static int32_t binarySearchForKey(char *pValue, int num, TSKEY key, int order);
 static STsdbQueryCond createTsdbQueryCond(SQueryAttr* pQueryAttr, STimeWindow* win);
 static STableIdInfo createTableIdInfo(STableQueryInfo* pTableQueryInfo);
@@ -236,10 +239,12 @@ static void destroyGroupbyOperatorInfo(void* param, int32_t numOfOutput);
 static void destroyProjectOperatorInfo(void* param, int32_t numOfOutput);
 static void destroyTagScanOperatorInfo(void* param, int32_t numOfOutput);
 static void destroyOrderOperatorInfo(void* param, int32_t numOfOutput);
+static void destroyTopNOperatorInfo(void* param, int32_t numOfOutput);
 static void destroySWindowOperatorInfo(void* param, int32_t numOfOutput);
 static void destroyStateWindowOperatorInfo(void* param, int32_t numOfOutput);
 static void destroyAggOperatorInfo(void* param, int32_t numOfOutput);
 static void destroyOperatorInfo(SOperatorInfo* pOperator);
+static void destroyParallelAggWorker(SQInfo* pWorker);
 
 static void doSetOperatorCompleted(SOperatorInfo* pOperator) {
   pOperator->status = OP_EXEC_DONE;
@@ -288,19 +293,20 @@ static int compareRowData(const void *a, const void *b, const void *userData) {
   return (in1 != NULL && in2 != NULL) ? supporter->comFunc(in1, in2) : 0;
 }
 
-static void sortGroupResByOrderList(SGroupResInfo *pGroupResInfo, SQueryRuntimeEnv *pRuntimeEnv, SSDataBlock* pDataBlock, SQLFunctionCtx *pCtx) {
-  SArray *columnOrderList = getOrderCheckColumns(pRuntimeEnv->pQueryAttr);
+static bool needSortGroupRes(SQueryAttr* pQueryAttr) {
+  SArray *columnOrderList = getOrderCheckColumns(pQueryAttr);
   size_t size = taosArrayGetSize(columnOrderList);
   taosArrayDestroy(&columnOrderList);
 
-  if (size <= 0) {
+  return size > 0 && pQueryAttr->order.orderColId > 0;
+}
+
+static void sortGroupResByOrderList(SGroupResInfo *pGroupResInfo, SQueryRuntimeEnv *pRuntimeEnv, SSDataBlock* pDataBlock, SQLFunctionCtx *pCtx) {
+  if (!needSortGroupRes(pRuntimeEnv->pQueryAttr)) {
     return;
   }
 
   int32_t orderId = pRuntimeEnv->pQueryAttr->order.orderColId;
-  if (orderId <= 0) {
-    return;
-  }
 
   int32_t orderIndex = -1;
   for (int32_t j = 0; j < pDataBlock->info.numOfCols; ++j) {
@@ -1575,13 +1581,292 @@ static void hashIntervalAgg(SOperatorInfo* pOperatorInfo, SResultRowInfo* pResul
   updateResultRowInfoActiveIndex(pResultRowInfo, pQueryAttr, pRuntimeEnv->current->lastKey);
 }
 
+#define GROUPBY_SPILL_PART_BITS       4
+#define GROUPBY_SPILL_PARTS           (1 << GROUPBY_SPILL_PART_BITS)
+#define GROUPBY_SPILL_MAX_LEVEL       (32 / GROUPBY_SPILL_PART_BITS)  // each level takes the next bits of the hash value
+#define GROUPBY_SPILL_MIN_GROUPS      1024
+#define GROUPBY_SPILL_BUF_SIZE        (256 * 1024)
+#define GROUPBY_SPILL_GROUP_OVERHEAD  64  // the nodes of the hash tables and the pointers to a group
+
+// the rows of a partition file are written in chunks, each one of the rows of a table
+typedef struct SGroupbySpillChunk {
+  STableQueryInfo *pTableInfo;
+  int32_t          rows;
+} SGroupbySpillChunk;
+
+static SGroupbySpillInfo* createGroupbySpillInfo(SQueryRuntimeEnv* pRuntimeEnv) {
+  SQueryAttr* pQueryAttr = pRuntimeEnv->pQueryAttr;
+
+  // The groups are returned one partition after another, so they can not be sorted here. The rows of a repeated or
+  // reversed scan can not be aggregated after the rows of the master scan are spilled either.
+  if (tsGroupbyBufferSize < 0 || getNumOfScanTimes(pQueryAttr) > 1 || pQueryAttr->needReverseScan ||
+      (!pQueryAttr->stableQuery && needSortGroupRes(pQueryAttr))) {
+    return NULL;
+  }
+
+  SGroupbySpillInfo* pSpill = calloc(1, sizeof(SGroupbySpillInfo));
+  pSpill->pParts = calloc(GROUPBY_SPILL_PARTS, POINTER_BYTES);
+  pSpill->pPending = taosArrayInit(GROUPBY_SPILL_PARTS, POINTER_BYTES);
+  return pSpill;
+}
+
+static void destroyGroupbySpillPart(SGroupbySpillPart* pPart) {
+  if (pPart == NULL) {
+    return;
+  }
+
+  if (pPart->file != NULL) {
+    fclose(pPart->file);
+    remove(pPart->path);
+  }
+
+  tfree(pPart->pBuf);
+  free(pPart);
+}
+
+static void destroyGroupbySpillInfo(SGroupbySpillInfo* pSpill) {
+  if (pSpill == NULL) {
+    return;
+  }
+
+  for (int32_t i = 0; i < GROUPBY_SPILL_PARTS; ++i) {
+    destroyGroupbySpillPart(pSpill->pParts[i]);
+  }
+
+  size_t num = taosArrayGetSize(pSpill->pPending);
+  for (int32_t i = 0; i < num; ++i) {
+    destroyGroupbySpillPart(*(SGroupbySpillPart**)taosArrayGet(pSpill->pPending, i));
+  }
+
+  destroyGroupbySpillPart(pSpill->pCurrent);
+  taosArrayDestroy(&pSpill->pPending);
+  destroyOutputBuf(pSpill->pBlock);
+  tfree(pSpill->pParts);
+  tfree(pSpill->colOffset);
+  free(pSpill);
+}
+
+static bool hasGroupbySpillPart(SGroupbyOperatorInfo* pInfo) {
+  return pInfo->pSpill != NULL && taosArrayGetSize(pInfo->pSpill->pPending) > 0;
+}
+
+// a group takes a result row of the pool, its intermediate results in the result buffer, its key and the entries of
+// the hash tables
+static int32_t getGroupbyMaxGroups(SQueryRuntimeEnv* pRuntimeEnv, int16_t bytes) {
+  int64_t groupSize = getResultRowSize(pRuntimeEnv) + pRuntimeEnv->pQueryAttr->resultRowSize + bytes +
+                      GET_RES_WINDOW_KEY_LEN(bytes) + GET_RES_EXT_WINDOW_KEY_LEN(bytes) + GROUPBY_SPILL_GROUP_OVERHEAD;
+  int64_t maxGroups = (tsGroupbyBufferSize * 1048576L) / groupSize;
+  maxGroups = MIN(MAX(maxGroups, GROUPBY_SPILL_MIN_GROUPS), MAX_INTERVAL_TIME_WINDOW);
+
+  qDebug("QInfo:0x%"PRIx64" group by buffer:%dMB, %"PRId64" bytes per group, at most %d groups in memory",
+         GET_QID(pRuntimeEnv), tsGroupbyBufferSize, groupSize, (int32_t)maxGroups);
+  return (int32_t)maxGroups;
+}
+
+static SGroupbySpillPart* getGroupbySpillPart(SQueryRuntimeEnv* pRuntimeEnv, SGroupbySpillInfo* pSpill,
+                                              SSDataBlock* pBlock, int32_t index) {
+  if (pSpill->pParts[index] != NULL) {
+    return pSpill->pParts[index];
+  }
+
+  // the layout of the rows is the same for all the blocks from the upstream
+  if (pSpill->colOffset == NULL) {
+    pSpill->numOfCols = pBlock->info.numOfCols;
+    pSpill->colOffset = calloc(pSpill->numOfCols + 1, sizeof(int32_t));
+
+    SSDataBlock* pRes = calloc(1, sizeof(SSDataBlock));
+    pRes->info.numOfCols = pBlock->info.numOfCols;
+    pRes->pDataBlock = taosArrayInit(pBlock->info.numOfCols, sizeof(SColumnInfoData));
+
+    for (int32_t i = 0; i < pSpill->numOfCols; ++i) {
+      SColumnInfoData* p = taosArrayGet(pBlock->pDataBlock, i);
+      pSpill->colOffset[i + 1] = pSpill->colOffset[i] + p->info.bytes;
+    }
+
+    pSpill->rowSize = pSpill->colOffset[pSpill->numOfCols];
+    pSpill->capacity = MAX(GROUPBY_SPILL_BUF_SIZE / pSpill->rowSize, 1);
+
+    for (int32_t i = 0; i < pSpill->numOfCols; ++i) {
+      SColumnInfoData* p = taosArrayGet(pBlock->pDataBlock, i);
+      SColumnInfoData  col = {.info = p->info};
+      col.pData = calloc(pSpill->capacity, p->info.bytes);
+      taosArrayPush(pRes->pDataBlock, &col);
+    }
+
+    pSpill->pBlock = pRes;
+  }
+
+  SGroupbySpillPart* pPart = calloc(1, sizeof(SGroupbySpillPart));
+  pPart->level = pSpill->level + 1;
+  pPart->pBuf = malloc((size_t)pSpill->capacity * pSpill->rowSize);
+  if (pPart->pBuf == NULL) {
+    free(pPart);
+    longjmp(pRuntimeEnv->env, TSDB_CODE_QRY_OUT_OF_MEMORY);
+  }
+
+  pSpill->pParts[index] = pPart;
+  return pPart;
+}
+
+static void flushGroupbySpillPart(SQueryRuntimeEnv* pRuntimeEnv, SGroupbySpillInfo* pSpill, SGroupbySpillPart* pPart) {
+  if (pPart->bufRows == 0) {
+    return;
+  }
+
+  if (pPart->file == NULL) {
+    taosGetTmpfilePath("qgroupby", pPart->path);
+    pPart->file = fopen(pPart->path, "wb+");
+    if (pPart->file == NULL) {
+      qError("QInfo:0x%"PRIx64" failed to create group by spill file:%s, reason:%s", GET_QID(pRuntimeEnv), pPart->path,
+             strerror(errno));
+      longjmp(pRuntimeEnv->env, TAOS_SYSTEM_ERROR(errno));
+    }
+  }
+
+  SGroupbySpillChunk chunk = {.pTableInfo = pPart->pTableInfo, .rows = pPart->bufRows};
+
+  bool ret = (fwrite(&chunk, sizeof(chunk), 1, pPart->file) == 1);
+  for (int32_t i = 0; i < pSpill->numOfCols && ret; ++i) {
+    int32_t bytes = pSpill->colOffset[i + 1] - pSpill->colOffset[i];
+    char*   pData = pPart->pBuf + (size_t)pSpill->colOffset[i] * pSpill->capacity;
+    ret = (fwrite(pData, (size_t)bytes * pPart->bufRows, 1, pPart->file) == 1);
+  }
+
+  if (!ret) {
+    qError("QInfo:0x%"PRIx64" failed to write group by spill file:%s, reason:%s", GET_QID(pRuntimeEnv), pPart->path,
+           strerror(errno));
+    longjmp(pRuntimeEnv->env, TAOS_SYSTEM_ERROR(errno));
+  }
+
+  pPart->numOfRows += pPart->bufRows;
+  pSpill->spilledRows += pPart->bufRows;
+  pPart->bufRows = 0;
+}
+
+static void appendGroupbySpillRows(SQueryRuntimeEnv* pRuntimeEnv, SGroupbySpillInfo* pSpill, SGroupbySpillPart* pPart,
+                                   SSDataBlock* pBlock, int32_t start, int32_t num) {
+  if (pPart->pTableInfo != pRuntimeEnv->current) {
+    flushGroupbySpillPart(pRuntimeEnv, pSpill, pPart);
+    pPart->pTableInfo = pRuntimeEnv->current;
+  }
+
+  while (num > 0) {
+    int32_t n = MIN(num, pSpill->capacity - pPart->bufRows);
+
+    for (int32_t i = 0; i < pSpill->numOfCols; ++i) {
+      SColumnInfoData* p = taosArrayGet(pBlock->pDataBlock, i);
+
+      int32_t bytes = p->info.bytes;
+      char*   pData = pPart->pBuf + (size_t)pSpill->colOffset[i] * pSpill->capacity;
+      memcpy(pData + (size_t)bytes * pPart->bufRows, p->pData + (size_t)bytes * start, (size_t)bytes * n);
+    }
+
+    pPart->bufRows += n;
+    start += n;
+    num -= n;
+
+    if (pPart->bufRows == pSpill->capacity) {
+      flushGroupbySpillPart(pRuntimeEnv, pSpill, pPart);
+    }
+  }
+}
+
+// Once the number of groups in memory reaches the budget, the rows of the groups that are not in memory are written to
+// the partition chosen by the hash value of the group by value, and are aggregated after the groups in memory are
+// returned.
+static bool spillGroupbyRows(SOperatorInfo* pOperator, SGroupbyOperatorInfo* pInfo, SSDataBlock* pBlock, char* val,
+                             int16_t type, int16_t bytes, int32_t start, int32_t num) {
+  SQueryRuntimeEnv*  pRuntimeEnv = pOperator->pRuntimeEnv;
+  SGroupbySpillInfo* pSpill = pInfo->pSpill;
+
+  if (pSpill == NULL || pInfo->binfo.resultRowInfo.size < pSpill->maxGroups) {
+    return false;
+  }
+
+  // all the bits of the hash value are taken, the groups left in the partition are kept in memory up to the limit of
+  // the result rows of a query
+  if (pSpill->level >= GROUPBY_SPILL_MAX_LEVEL) {
+    if (!pSpill->overBudget) {
+      pSpill->overBudget = true;
+      qWarn("QInfo:0x%"PRIx64" group by partition of level:%d can not be split, groups beyond the budget of %d groups "
+            "are kept in memory", GET_QID(pRuntimeEnv), pSpill->level, pSpill->maxGroups);
+    }
+    return false;
+  }
+
+  char*   d = val;
+  int16_t len = bytes;
+  if (IS_VAR_DATA_TYPE(type)) {
+    d = varDataVal(val);
+    len = varDataLen(val);
+  }
+
+  uint64_t groupIndex = pRuntimeEnv->current->groupIndex;
+  SET_RES_WINDOW_KEY(pRuntimeEnv->keyBuf, d, len, groupIndex);
+  if (taosHashGet(pRuntimeEnv->pResultRowHashTable, pRuntimeEnv->keyBuf, GET_RES_WINDOW_KEY_LEN(len)) != NULL) {
+    return false;
+  }
+
+  // the high bits are taken first, the low bits of the same hash function choose the slots of the hash table
+  uint32_t hashVal = MurmurHash3_32(pRuntimeEnv->keyBuf, (uint32_t)GET_RES_WINDOW_KEY_LEN(len));
+  int32_t  index = (hashVal >> (32 - (pSpill->level + 1) * GROUPBY_SPILL_PART_BITS)) & (GROUPBY_SPILL_PARTS - 1);
+
+  SGroupbySpillPart* pPart = getGroupbySpillPart(pRuntimeEnv, pSpill, pBlock, index);
+  appendGroupbySpillRows(pRuntimeEnv, pSpill, pPart, pBlock, start, num);
+  return true;
+}
+
+// the rows buffered are written, and the partitions of the pass are queued to be aggregated
+static void finishGroupbySpillPass(SQueryRuntimeEnv* pRuntimeEnv, SGroupbySpillInfo* pSpill) {
+  if (pSpill == NULL) {
+    return;
+  }
+
+  for (int32_t i = 0; i < GROUPBY_SPILL_PARTS; ++i) {
+    SGroupbySpillPart* pPart = pSpill->pParts[i];
+    if (pPart == NULL) {
+      continue;
+    }
+
+    flushGroupbySpillPart(pRuntimeEnv, pSpill, pPart);
+    tfree(pPart->pBuf);
+
+    pSpill->pParts[i] = NULL;
+    pSpill->numOfParts += 1;
+    taosArrayPush(pSpill->pPending, &pPart);
+
+    qDebug("QInfo:0x%"PRIx64" group by partition:%d of level:%d spilled, rows:%"PRId64, GET_QID(pRuntimeEnv), i,
+           pPart->level, pPart->numOfRows);
+  }
+}
+
+static void doHashGroupbyRows(SOperatorInfo* pOperator, SGroupbyOperatorInfo* pInfo, SSDataBlock* pSDataBlock, char* val,
+                              int16_t type, int16_t bytes, int32_t start, int32_t num, int64_t* tsList) {
+  SQueryRuntimeEnv* pRuntimeEnv = pOperator->pRuntimeEnv;
+  SQueryAttr*       pQueryAttr = pRuntimeEnv->pQueryAttr;
+
+  if (spillGroupbyRows(pOperator, pInfo, pSDataBlock, val, type, bytes, start, num)) {
+    return;
+  }
+
+  if (pQueryAttr->stableQuery && pQueryAttr->stabledev && (pRuntimeEnv->prevResult != NULL)) {
+    setParamForStableStddevByColData(pRuntimeEnv, pInfo->binfo.pCtx, pOperator->numOfOutput, pOperator->pExpr, val, bytes);
+  }
+
+  int32_t ret = setGroupResultOutputBuf(pRuntimeEnv, &(pInfo->binfo), pOperator->numOfOutput, val, type, bytes, pRuntimeEnv->current->groupIndex);
+  if (ret != TSDB_CODE_SUCCESS) {  // null data, too many state code
+    longjmp(pRuntimeEnv->env, TSDB_CODE_QRY_APP_ERROR);
+  }
+
+  STimeWindow w = TSWINDOW_INITIALIZER;
+  doApplyFunctions(pRuntimeEnv, pInfo->binfo.pCtx, &w, start, num, tsList, pSDataBlock->info.rows, pOperator->numOfOutput);
+}
+
 static void doHashGroupbyAgg(SOperatorInfo* pOperator, SGroupbyOperatorInfo *pInfo, SSDataBlock *pSDataBlock) {
   SQueryRuntimeEnv* pRuntimeEnv = pOperator->pRuntimeEnv;
-  STableQueryInfo*  item = pRuntimeEnv->current;
 
   SColumnInfoData* pColInfoData = taosArrayGet(pSDataBlock->pDataBlock, pInfo->colIndex);
 
-  SQueryAttr* pQueryAttr = pRuntimeEnv->pQueryAttr;
   int16_t     bytes = pColInfoData->info.bytes;
   int16_t     type = pColInfoData->info.type;
 
@@ -1593,8 +1878,6 @@ static void doHashGroupbyAgg(SOperatorInfo* pOperator, SGroupbyOperatorInfo *pIn
   SColumnInfoData* pFirstColData = taosArrayGet(pSDataBlock->pDataBlock, 0);
   int64_t* tsList = (pFirstColData->info.type == TSDB_DATA_TYPE_TIMESTAMP)? (int64_t*) pFirstColData->pData:NULL;
 
-  STimeWindow w = TSWINDOW_INITIALIZER;
-
   int32_t num = 0;
   for (int32_t j = 0; j < pSDataBlock->info.rows; ++j) {
     char* val = ((char*)pColInfoData->pData) + bytes * j;
@@ -1620,16 +1903,7 @@ static void doHashGroupbyAgg(SOperatorInfo* pOperator, SGroupbyOperatorInfo *pIn
       }
     }
 
-    if (pQueryAttr->stableQuery && pQueryAttr->stabledev && (pRuntimeEnv->prevResult != NULL)) {
-      setParamForStableStddevByColData(pRuntimeEnv, pInfo->binfo.pCtx, pOperator->numOfOutput, pOperator->pExpr, pInfo->prevData, bytes);
-    }
-
-    int32_t ret = setGroupResultOutputBuf(pRuntimeEnv, &(pInfo->binfo), pOperator->numOfOutput, pInfo->prevData, type, bytes, item->groupIndex);
-    if (ret != TSDB_CODE_SUCCESS) {  // null data, too many state code
-      longjmp(pRuntimeEnv->env, TSDB_CODE_QRY_APP_ERROR);
-    }
-
-    doApplyFunctions(pRuntimeEnv, pInfo->binfo.pCtx, &w, j - num, num, tsList, pSDataBlock->info.rows, pOperator->numOfOutput);
+    doHashGroupbyRows(pOperator, pInfo, pSDataBlock, pInfo->prevData, type, bytes, j - num, num, tsList);
 
     num = 1;
     memcpy(pInfo->prevData, val, bytes);
@@ -1639,16 +1913,7 @@ static void doHashGroupbyAgg(SOperatorInfo* pOperator, SGroupbyOperatorInfo *pIn
     char* val = ((char*)pColInfoData->pData) + bytes * (pSDataBlock->info.rows - num);
     memcpy(pInfo->prevData, val, bytes);
 
-    if (pQueryAttr->stableQuery && pQueryAttr->stabledev && (pRuntimeEnv->prevResult != NULL)) {
-      setParamForStableStddevByColData(pRuntimeEnv, pInfo->binfo.pCtx, pOperator->numOfOutput, pOperator->pExpr, val, bytes);
-    }
-
-    int32_t ret = setGroupResultOutputBuf(pRuntimeEnv, &(pInfo->binfo), pOperator->numOfOutput, val, type, bytes, item->groupIndex);
-    if (ret != TSDB_CODE_SUCCESS) {  // null data, too many state code
-      longjmp(pRuntimeEnv->env, TSDB_CODE_QRY_APP_ERROR);
-    }
-
-    doApplyFunctions(pRuntimeEnv, pInfo->binfo.pCtx, &w, pSDataBlock->info.rows - num, num, tsList, pSDataBlock->info.rows, pOperator->numOfOutput);
+    doHashGroupbyRows(pOperator, pInfo, pSDataBlock, val, type, bytes, pSDataBlock->info.rows - num, num, tsList);
   }
 
   tfree(pInfo->prevData);
@@ -2227,6 +2492,20 @@ static int32_t setupQueryRuntimeEnv(SQueryRuntimeEnv *pRuntimeEnv, int32_t numOf
         break;
       }
 
+      case OP_TopN: {
+        SExprInfo* pExpr = (pQueryAttr->pExpr2 != NULL)? pQueryAttr->pExpr2:pQueryAttr->pExpr1;
+        int32_t    num = (pQueryAttr->pExpr2 != NULL)? pQueryAttr->numOfExpr2:pQueryAttr->numOfOutput;
+
+        SOperatorInfo* prev = pRuntimeEnv->proot;
+        pRuntimeEnv->proot = createTopNOperatorInfo(pRuntimeEnv, prev, pExpr, num, &pQueryAttr->order, getTopNRows(pQueryAttr));
+        if (pRuntimeEnv->proot == NULL && pQueryAttr->vgId != 0) {  // all rows are sorted in the global merge
+          pRuntimeEnv->proot = prev;
+        } else if (pRuntimeEnv->proot == NULL) {  // sort all rows instead
+          pRuntimeEnv->proot = createOrderOperatorInfo(pRuntimeEnv, prev, pExpr, num, &pQueryAttr->order);
+        }
+        break;
+      }
+
       default: {
         assert(0);
       }
@@ -4726,6 +5005,19 @@ static int32_t setupQueryHandle(void* tsdb, SQueryRuntimeEnv* pRuntimeEnv, int64
     cond.type = BLOCK_LOAD_TABLE_SEQ_ORDER;    
   }
 
+  // only a plain scan filters all rows it reads, the others need rows the filters may not match
+  if (isFirstLastRowQuery(pQueryAttr) || isCachedLastQuery(pQueryAttr) || pQueryAttr->pointInterpQuery) {
+    cond.pFilters = NULL;
+  }
+
+  // an interval query without filters may be answered by the statistics of the rollup windows of file blocks
+  if (QUERY_IS_INTERVAL_QUERY(pQueryAttr) && pQueryAttr->interval.sliding == pQueryAttr->interval.interval &&
+      pQueryAttr->interval.offset == 0 && pQueryAttr->interval.intervalUnit != 'n' &&
+      pQueryAttr->interval.intervalUnit != 'y' && pQueryAttr->pFilters == NULL && !pQueryAttr->groupbyColumn &&
+      !pQueryAttr->topBotQuery && cond.type != BLOCK_LOAD_TABLE_SEQ_ORDER) {
+    cond.rollupInterval = pQueryAttr->interval.interval;
+  }
+
   if (!isSTableQuery
     && (pRuntimeEnv->tableqinfoGroupInfo.numOfTables == 1)
     && (cond.order == TSDB_ORDER_ASC)
@@ -4909,6 +5201,7 @@ STsdbQueryCond createTsdbQueryCond(SQueryAttr* pQueryAttr, STimeWindow* win) {
       .numOfCols = pQueryAttr->numOfCols,
       .type      = BLOCK_LOAD_OFFSET_SEQ_ORDER,
       .loadExternalRows = false,
+      .pFilters  = pQueryAttr->pFilters,
   };
 
   // set offset with
@@ -5577,6 +5870,27 @@ static SSDataBlock* doSort(void* param, bool* newgroup) {
   return (pInfo->pDataBlock->info.rows > 0)? pInfo->pDataBlock:NULL;
 }
 
+// The aggregates of the timestamp column, e.g. count(*) in the output of an interval query, have the same column id
+// with the timestamp column, so they are skipped for the first timestamp output. Any other order column is sorted by
+// its last output.
+static int32_t getOrderColumnIndex(SExprInfo* pExpr, int32_t numOfOutput, SOrderVal* pOrderVal) {
+  int32_t index = -1;
+
+  for(int32_t i = 0; i < numOfOutput; ++i) {
+    if (pExpr[i].base.colInfo.colId != pOrderVal->orderColId) {
+      continue;
+    }
+
+    if (pOrderVal->orderColId != PRIMARYKEY_TIMESTAMP_COL_INDEX) {
+      index = i;
+    } else if (pExpr[i].base.resType == TSDB_DATA_TYPE_TIMESTAMP) {
+      return i;
+    }
+  }
+
+  return index;
+}
+
 SOperatorInfo *createOrderOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperatorInfo* upstream, SExprInfo* pExpr, int32_t numOfOutput, SOrderVal* pOrderVal) {
   SOrderOperatorInfo* pInfo = calloc(1, sizeof(SOrderOperatorInfo));
 
@@ -5589,13 +5903,10 @@ SOperatorInfo *createOrderOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperatorI
         col.info.bytes = pExpr[i].base.resBytes;
         col.info.type  = pExpr[i].base.resType;
         taosArrayPush(pDataBlock->pDataBlock, &col);
-
-        if (col.info.colId == pOrderVal->orderColId) {
-          pInfo->colIndex = i;
-        }
       }
 
       pDataBlock->info.numOfCols = numOfOutput;
+      pInfo->colIndex = MAX(getOrderColumnIndex(pExpr, numOfOutput, pOrderVal), 0);
       pInfo->order = pOrderVal->order;
       pInfo->pDataBlock = pDataBlock;
   }
@@ -5614,6 +5925,171 @@ SOperatorInfo *createOrderOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperatorI
   return pOperator;
 }
 
+static int32_t topNRowComparFn(const void* p1, const void* p2, const void* param) {
+  const STopNOperatorInfo* pInfo = param;
+
+  char* pKey1 = pInfo->pRows + (size_t)pInfo->rowSize * (*(int32_t*)p1) + pInfo->keyOffset;
+  char* pKey2 = pInfo->pRows + (size_t)pInfo->rowSize * (*(int32_t*)p2) + pInfo->keyOffset;
+  return pInfo->comparFn(pKey1, pKey2);
+}
+
+static void topNSlotSwapFn(void* p1, void* p2, const void* param) {
+  int32_t t = *(int32_t*)p1;
+  *(int32_t*)p1 = *(int32_t*)p2;
+  *(int32_t*)p2 = t;
+}
+
+static void copyRowToTopN(STopNOperatorInfo* pInfo, SSDataBlock* pBlock, int32_t rowIndex, int32_t slot) {
+  char* pRow = pInfo->pRows + (size_t)pInfo->rowSize * slot;
+
+  for (int32_t i = 0; i < pBlock->info.numOfCols; ++i) {
+    SColumnInfoData* pColInfo = taosArrayGet(pBlock->pDataBlock, i);
+    memcpy(pRow + pInfo->colOffset[i], pColInfo->pData + pColInfo->info.bytes * rowIndex, pColInfo->info.bytes);
+  }
+}
+
+/*
+ * The rows are kept until the limit is reached, then the kept rows are built into a max heap with the last row in
+ * the order on the top. A new row takes the place of the top if it is before the top in the order, otherwise it is
+ * dropped after a single comparison.
+ */
+static void doAddToTopN(SQueryRuntimeEnv* pRuntimeEnv, STopNOperatorInfo* pInfo, SSDataBlock* pBlock) {
+  SColumnInfoData* pKeyCol = taosArrayGet(pBlock->pDataBlock, pInfo->colIndex);
+
+  for (int32_t j = 0; j < pBlock->info.rows; ++j) {
+    if (pInfo->numOfRows < pInfo->limit) {
+      if (pInfo->numOfRows >= pInfo->capacity) {
+        // start from a block of rows, the buffer grows to the limit on demand
+        int32_t capacity = MIN(pRuntimeEnv->resultInfo.capacity, pInfo->limit);
+        if (pInfo->capacity > 0) {
+          capacity = (int32_t)MIN((int64_t)pInfo->capacity * 2, pInfo->limit);
+        }
+
+        char*    pRows = realloc(pInfo->pRows, (size_t)pInfo->rowSize * capacity);
+        int32_t* pSlots = (pRows != NULL)? realloc(pInfo->pSlots, sizeof(int32_t) * capacity):NULL;
+        if (pRows != NULL) {
+          pInfo->pRows = pRows;
+        }
+        if (pSlots == NULL) {
+          longjmp(pRuntimeEnv->env, TSDB_CODE_QRY_OUT_OF_MEMORY);
+        }
+
+        pInfo->pSlots = pSlots;
+        pInfo->capacity = capacity;
+      }
+
+      pInfo->pSlots[pInfo->numOfRows] = pInfo->numOfRows;
+      copyRowToTopN(pInfo, pBlock, j, pInfo->numOfRows);
+      pInfo->numOfRows += 1;
+
+      if (pInfo->numOfRows == pInfo->limit) {
+        taosheapsort(pInfo->pSlots, sizeof(int32_t), pInfo->numOfRows, pInfo, topNRowComparFn, NULL, topNSlotSwapFn, true);
+      }
+      continue;
+    }
+
+    char* pTop = pInfo->pRows + (size_t)pInfo->rowSize * pInfo->pSlots[0] + pInfo->keyOffset;
+    if (pInfo->comparFn(pKeyCol->pData + pKeyCol->info.bytes * j, pTop) >= 0) {
+      continue;
+    }
+
+    copyRowToTopN(pInfo, pBlock, j, pInfo->pSlots[0]);
+    taosheapadjust(pInfo->pSlots, sizeof(int32_t), 0, pInfo->numOfRows - 1, pInfo, topNRowComparFn, NULL, topNSlotSwapFn,
+                   true);
+  }
+}
+
+static SSDataBlock* doTopN(void* param, bool* newgroup) {
+  SOperatorInfo* pOperator = (SOperatorInfo*) param;
+  if (pOperator->status == OP_EXEC_DONE) {
+    return NULL;
+  }
+
+  STopNOperatorInfo* pInfo = pOperator->info;
+  SQueryRuntimeEnv*  pRuntimeEnv = pOperator->pRuntimeEnv;
+
+  if (pOperator->status == OP_IN_EXECUTING) {
+    while(1) {
+      publishOperatorProfEvent(pOperator->upstream[0], QUERY_PROF_BEFORE_OPERATOR_EXEC);
+      SSDataBlock* pBlock = pOperator->upstream[0]->exec(pOperator->upstream[0], newgroup);
+      publishOperatorProfEvent(pOperator->upstream[0], QUERY_PROF_AFTER_OPERATOR_EXEC);
+
+      if (pBlock == NULL) {
+        break;
+      }
+
+      pInfo->totalRows += pBlock->info.rows;
+      doAddToTopN(pRuntimeEnv, pInfo, pBlock);
+    }
+
+    if (pInfo->numOfRows > 0) {
+      taosqsort(pInfo->pSlots, pInfo->numOfRows, sizeof(int32_t), pInfo, topNRowComparFn);
+    }
+
+    qDebug("QInfo:0x%"PRIx64" top-N kept %d of %"PRId64" rows, limit:%d", GET_QID(pRuntimeEnv), pInfo->numOfRows,
+           pInfo->totalRows, pInfo->limit);
+    pOperator->status = OP_RES_TO_RETURN;
+  }
+
+  SSDataBlock* pRes = pInfo->pRes;
+  int32_t      rows = MIN(pInfo->numOfRows - pInfo->rowIndex, pRuntimeEnv->resultInfo.capacity);
+
+  for (int32_t i = 0; i < pRes->info.numOfCols; ++i) {
+    SColumnInfoData* pColInfo = taosArrayGet(pRes->pDataBlock, i);
+    int32_t          bytes = pColInfo->info.bytes;
+
+    for (int32_t j = 0; j < rows; ++j) {
+      char* pRow = pInfo->pRows + (size_t)pInfo->rowSize * pInfo->pSlots[pInfo->rowIndex + j];
+      memcpy(pColInfo->pData + bytes * j, pRow + pInfo->colOffset[i], bytes);
+    }
+  }
+
+  pRes->info.rows = rows;
+  pInfo->rowIndex += rows;
+  if (pInfo->rowIndex >= pInfo->numOfRows) {
+    doSetOperatorCompleted(pOperator);
+  }
+
+  return (rows > 0)? pRes:NULL;
+}
+
+SOperatorInfo *createTopNOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperatorInfo* upstream, SExprInfo* pExpr,
+                                      int32_t numOfOutput, SOrderVal* pOrderVal, int32_t limit) {
+  // the rows can not be dropped if the column to order by is not in the output
+  int32_t colIndex = getOrderColumnIndex(pExpr, numOfOutput, pOrderVal);
+  if (colIndex < 0 || limit <= 0) {
+    return NULL;
+  }
+
+  STopNOperatorInfo* pInfo = calloc(1, sizeof(STopNOperatorInfo));
+
+  pInfo->pRes      = createOutputBuf(pExpr, numOfOutput, pRuntimeEnv->resultInfo.capacity);
+  pInfo->colIndex  = colIndex;
+  pInfo->comparFn  = getKeyComparFunc(pExpr[colIndex].base.resType, pOrderVal->order);
+  pInfo->limit     = limit;
+  pInfo->colOffset = calloc(numOfOutput, sizeof(int32_t));
+
+  for(int32_t i = 0; i < numOfOutput; ++i) {
+    pInfo->colOffset[i] = pInfo->rowSize;
+    pInfo->rowSize += pExpr[i].base.resBytes;
+  }
+
+  pInfo->keyOffset = pInfo->colOffset[colIndex];
+
+  SOperatorInfo* pOperator = calloc(1, sizeof(SOperatorInfo));
+  pOperator->name          = "TopNOperator";
+  pOperator->operatorType  = OP_TopN;
+  pOperator->blockingOptr  = true;
+  pOperator->status        = OP_IN_EXECUTING;
+  pOperator->info          = pInfo;
+  pOperator->exec          = doTopN;
+  pOperator->cleanup       = destroyTopNOperatorInfo;
+  pOperator->pRuntimeEnv   = pRuntimeEnv;
+
+  appendUpstream(pOperator, upstream);
+  return pOperator;
+}
+
 static int32_t getTableScanOrder(STableScanInfo* pTableScanInfo) {
   return pTableScanInfo->order;
 }
@@ -5681,78 +6157,149 @@ static SSDataBlock* doAggregate(void* param, bool* newgroup) {
   return pInfo->pRes;
 }
 
-static SSDataBlock* doSTableAggregate(void* param, bool* newgroup) {
-  SOperatorInfo* pOperator = (SOperatorInfo*) param;
-  if (pOperator->status == OP_EXEC_DONE) {
-    return NULL;
+// the groups returned are released, and the groups aggregated next take their memory
+static void resetAggResultRows(SQueryRuntimeEnv* pRuntimeEnv, SResultRowInfo* pResultRowInfo) {
+  for (int32_t i = 0; i < pResultRowInfo->size; ++i) {
+    tfree(pResultRowInfo->pResult[i]->key);
   }
 
-  SAggOperatorInfo* pAggInfo = pOperator->info;
-  SOptrBasicInfo* pInfo = &pAggInfo->binfo;
+  pResultRowInfo->size = 0;
+  pResultRowInfo->curPos = -1;
 
-  SQueryRuntimeEnv* pRuntimeEnv = pOperator->pRuntimeEnv;
+  taosHashClear(pRuntimeEnv->pResultRowHashTable);
+  taosHashClear(pRuntimeEnv->pResultRowListSet);
+  taosArrayClear(pRuntimeEnv->pResultRowArrayList);
+  resetResultRowPool(pRuntimeEnv->pool);
+  resetResultBuf(pRuntimeEnv->pResultBuf);
 
-  if (pOperator->status == OP_RES_TO_RETURN) {
-    toSSDataBlock(&pRuntimeEnv->groupResInfo, pRuntimeEnv, pInfo->pRes);
+  cleanupGroupResInfo(&pRuntimeEnv->groupResInfo);
+  setQueryStatus(pRuntimeEnv, QUERY_NOT_COMPLETED);
+}
 
-    if (pInfo->pRes->info.rows == 0 || !hasRemainDataInCurrentGroup(&pRuntimeEnv->groupResInfo)) {
-      pOperator->status = OP_EXEC_DONE;
-    }
+static bool hasNextSTableAggBatch(SAggOperatorInfo* pInfo) {
+  return pInfo->nextBatch < pInfo->numOfBatches;
+}
 
-    return pInfo->pRes;
-  }
+// the tables of the next batch of table groups are scanned by a new query handle
+static void setNextSTableAggBatch(SOperatorInfo* pOperator, SAggOperatorInfo* pInfo) {
+  SQueryRuntimeEnv* pRuntimeEnv = pOperator->pRuntimeEnv;
+  SQueryAttr*       pQueryAttr = pRuntimeEnv->pQueryAttr;
+  STableScanInfo*   pScanInfo = pOperator->upstream[0]->info;
 
-  SQueryAttr* pQueryAttr = pRuntimeEnv->pQueryAttr;
+  tsdbCleanupQueryHandle(pScanInfo->pQueryHandle);
+  pScanInfo->pQueryHandle = NULL;
+  pRuntimeEnv->pQueryHandle = NULL;
+
+  STableGroupInfo* pBatch = &pInfo->pBatches[pInfo->nextBatch++];
+  STsdbQueryCond   cond = createTsdbQueryCond(pQueryAttr, &pQueryAttr->window);
+
+  terrno = TSDB_CODE_SUCCESS;
+  pScanInfo->pQueryHandle = tsdbQueryTables(pQueryAttr->tsdb, &cond, pBatch, GET_QID(pRuntimeEnv), &pQueryAttr->memRef);
+  if (pScanInfo->pQueryHandle == NULL) {
+    longjmp(pRuntimeEnv->env, (terrno != TSDB_CODE_SUCCESS) ? terrno : TSDB_CODE_QRY_OUT_OF_MEMORY);
+  }
+
+  pRuntimeEnv->pQueryHandle = pScanInfo->pQueryHandle;
+  pRuntimeEnv->prevGroupId = INT32_MIN;
+  pScanInfo->current = 0;
+  pScanInfo->prevGroupId = -1;
+
+  qDebug("QInfo:0x%"PRIx64" aggregate the batch %d of %d, %"PRIzu" table groups of %u tables", GET_QID(pRuntimeEnv),
+         pInfo->nextBatch, pInfo->numOfBatches, taosArrayGetSize(pBatch->pGroupList), pBatch->numOfTables);
+}
+
+static SSDataBlock* doSTableAggregate(void* param, bool* newgroup) {
+  SOperatorInfo* pOperator = (SOperatorInfo*) param;
+  if (pOperator->status == OP_EXEC_DONE) {
+    return NULL;
+  }
+
+  SAggOperatorInfo* pAggInfo = pOperator->info;
+  SOptrBasicInfo* pInfo = &pAggInfo->binfo;
+
+  SQueryRuntimeEnv* pRuntimeEnv = pOperator->pRuntimeEnv;
+
+  // the groups of the next batch are aggregated once the results of the batch before are all returned
+  if (pOperator->status == OP_RES_TO_RETURN) {
+    toSSDataBlock(&pRuntimeEnv->groupResInfo, pRuntimeEnv, pInfo->pRes);
+
+    if (pInfo->pRes->info.rows == 0 || !hasRemainDataInCurrentGroup(&pRuntimeEnv->groupResInfo)) {
+      pOperator->status = hasNextSTableAggBatch(pAggInfo) ? OP_IN_EXECUTING : OP_EXEC_DONE;
+    }
+
+    if (pInfo->pRes->info.rows > 0 || pOperator->status == OP_EXEC_DONE) {
+      return pInfo->pRes;
+    }
+  }
+
+  SQueryAttr* pQueryAttr = pRuntimeEnv->pQueryAttr;
   int32_t order = pQueryAttr->order.order;
 
   SOperatorInfo* upstream = pOperator->upstream[0];
 
-  while(1) {
-    publishOperatorProfEvent(upstream, QUERY_PROF_BEFORE_OPERATOR_EXEC);
-    SSDataBlock* pBlock = upstream->exec(upstream, newgroup);
-    publishOperatorProfEvent(upstream, QUERY_PROF_AFTER_OPERATOR_EXEC);
+  while (1) {
+    if (pAggInfo->pBatches != NULL) {
+      if (pAggInfo->nextBatch > 0) {
+        resetAggResultRows(pRuntimeEnv, &pInfo->resultRowInfo);
+      }
 
-    if (pBlock == NULL) {
-      break;
+      setNextSTableAggBatch(pOperator, pAggInfo);
     }
 
-    setTagValue(pOperator, pRuntimeEnv->current->pTable, pInfo->pCtx, pOperator->numOfOutput);
+    while(1) {
+      publishOperatorProfEvent(upstream, QUERY_PROF_BEFORE_OPERATOR_EXEC);
+      SSDataBlock* pBlock = upstream->exec(upstream, newgroup);
+      publishOperatorProfEvent(upstream, QUERY_PROF_AFTER_OPERATOR_EXEC);
 
-    if (upstream->operatorType == OP_DataBlocksOptScan) {
-      STableScanInfo* pScanInfo = upstream->info;
-      order = getTableScanOrder(pScanInfo);
-    }
+      if (pBlock == NULL) {
+        break;
+      }
 
-    // the pDataBlock are always the same one, no need to call this again
-    setInputDataBlock(pOperator, pInfo->pCtx, pBlock, order);
+      setTagValue(pOperator, pRuntimeEnv->current->pTable, pInfo->pCtx, pOperator->numOfOutput);
 
-    TSKEY key = 0;
-    if (QUERY_IS_ASC_QUERY(pQueryAttr)) {
-      key = pBlock->info.window.ekey;
-      TSKEY_MAX_ADD(key, 1);
-    } else {
-      key = pBlock->info.window.skey;
-      TSKEY_MIN_SUB(key, -1);
-    }
+      if (upstream->operatorType == OP_DataBlocksOptScan) {
+        STableScanInfo* pScanInfo = upstream->info;
+        order = getTableScanOrder(pScanInfo);
+      }
+
+      // the pDataBlock are always the same one, no need to call this again
+      setInputDataBlock(pOperator, pInfo->pCtx, pBlock, order);
+
+      TSKEY key = 0;
+      if (QUERY_IS_ASC_QUERY(pQueryAttr)) {
+        key = pBlock->info.window.ekey;
+        TSKEY_MAX_ADD(key, 1);
+      } else {
+        key = pBlock->info.window.skey;
+        TSKEY_MIN_SUB(key, -1);
+      }
     
-    setExecutionContext(pRuntimeEnv, pInfo, pOperator->numOfOutput, pRuntimeEnv->current->groupIndex, key);
-    doAggregateImpl(pOperator, pQueryAttr->window.skey, pInfo->pCtx, pBlock);
-  }
+      setExecutionContext(pRuntimeEnv, pInfo, pOperator->numOfOutput, pRuntimeEnv->current->groupIndex, key);
+      doAggregateImpl(pOperator, pQueryAttr->window.skey, pInfo->pCtx, pBlock);
+    }
 
-  pOperator->status = OP_RES_TO_RETURN;
-  closeAllResultRows(&pInfo->resultRowInfo);
+    pOperator->status = OP_RES_TO_RETURN;
+    closeAllResultRows(&pInfo->resultRowInfo);
 
-  updateNumOfRowsInResultRows(pRuntimeEnv, pInfo->pCtx, pOperator->numOfOutput, &pInfo->resultRowInfo,
-                             pInfo->rowCellInfoOffset);
+    updateNumOfRowsInResultRows(pRuntimeEnv, pInfo->pCtx, pOperator->numOfOutput, &pInfo->resultRowInfo,
+                               pInfo->rowCellInfoOffset);
 
-  initGroupResInfo(&pRuntimeEnv->groupResInfo, &pInfo->resultRowInfo);
+    initGroupResInfo(&pRuntimeEnv->groupResInfo, &pInfo->resultRowInfo);
 
-  toSSDataBlock(&pRuntimeEnv->groupResInfo, pRuntimeEnv, pInfo->pRes);
-  if (pInfo->pRes->info.rows == 0 || !hasRemainDataInCurrentGroup(&pRuntimeEnv->groupResInfo)) {
-    doSetOperatorCompleted(pOperator);
-  }
+    toSSDataBlock(&pRuntimeEnv->groupResInfo, pRuntimeEnv, pInfo->pRes);
+    if (pInfo->pRes->info.rows == 0 || !hasRemainDataInCurrentGroup(&pRuntimeEnv->groupResInfo)) {
+      if (hasNextSTableAggBatch(pAggInfo)) {
+        pOperator->status = OP_IN_EXECUTING;
+      } else {
+        doSetOperatorCompleted(pOperator);
+      }
+    }
 
-  return pInfo->pRes;
+    // the tables of a batch may have no rows in the time range, the next batch is aggregated then
+    if (pInfo->pRes->info.rows > 0 || pOperator->status == OP_EXEC_DONE) {
+      return pInfo->pRes;
+    }
+  }
 }
 
 static SSDataBlock* doProjectOperation(void* param, bool* newgroup) {
@@ -6781,67 +7328,125 @@ static SSDataBlock* doSessionWindowAgg(void* param, bool* newgroup) {
   return pBInfo->pRes->info.rows == 0? NULL:pBInfo->pRes;
 }
 
-static SSDataBlock* hashGroupbyAggregate(void* param, bool* newgroup) {
-  SOperatorInfo* pOperator = (SOperatorInfo*) param;
-  if (pOperator->status == OP_EXEC_DONE) {
-    return NULL;
+static void finalizeGroupbyResult(SOperatorInfo* pOperator, SGroupbyOperatorInfo* pInfo) {
+  SQueryRuntimeEnv* pRuntimeEnv = pOperator->pRuntimeEnv;
+
+  pOperator->status = OP_RES_TO_RETURN;
+  closeAllResultRows(&pInfo->binfo.resultRowInfo);
+  setQueryStatus(pRuntimeEnv, QUERY_COMPLETED);
+
+  if (!pRuntimeEnv->pQueryAttr->stableQuery) { // finalize include the update of result rows
+    finalizeQueryResult(pOperator, pInfo->binfo.pCtx, &pInfo->binfo.resultRowInfo, pInfo->binfo.rowCellInfoOffset);
+  } else {
+    updateNumOfRowsInResultRows(pRuntimeEnv, pInfo->binfo.pCtx, pOperator->numOfOutput, &pInfo->binfo.resultRowInfo, pInfo->binfo.rowCellInfoOffset);
   }
 
-  SGroupbyOperatorInfo *pInfo = pOperator->info;
+  initGroupResInfo(&pRuntimeEnv->groupResInfo, &pInfo->binfo.resultRowInfo);
+  if (!pRuntimeEnv->pQueryAttr->stableQuery) {
+    sortGroupResByOrderList(&pRuntimeEnv->groupResInfo, pRuntimeEnv, pInfo->binfo.pRes, pInfo->binfo.pCtx);
+  }
+}
 
-  SQueryRuntimeEnv* pRuntimeEnv = pOperator->pRuntimeEnv;
-  if (pOperator->status == OP_RES_TO_RETURN) {
-    toSSDataBlock(&pRuntimeEnv->groupResInfo, pRuntimeEnv, pInfo->binfo.pRes);
+// aggregate the rows of the last partition queued, the rows of the groups beyond the budget go to the partitions of
+// the next level
+static void doHashGroupbySpillPart(SOperatorInfo* pOperator, SGroupbyOperatorInfo* pInfo) {
+  SQueryRuntimeEnv*  pRuntimeEnv = pOperator->pRuntimeEnv;
+  SGroupbySpillInfo* pSpill = pInfo->pSpill;
+  SSDataBlock*       pBlock = pSpill->pBlock;
+  STableQueryInfo*   current = pRuntimeEnv->current;
 
-    if (pInfo->binfo.pRes->info.rows == 0 || !hasRemainDataInCurrentGroup(&pRuntimeEnv->groupResInfo)) {
-      pOperator->status = OP_EXEC_DONE;
-    }
+  pSpill->pCurrent = *(SGroupbySpillPart**)taosArrayPop(pSpill->pPending);
+  pSpill->level = pSpill->pCurrent->level;
+  pSpill->overBudget = false;
 
-    return pInfo->binfo.pRes;
-  }
+  SGroupbySpillPart* pPart = pSpill->pCurrent;
+  qDebug("QInfo:0x%"PRIx64" start to aggregate group by partition of level:%d, rows:%"PRId64", remain partitions:%d",
+         GET_QID(pRuntimeEnv), pPart->level, pPart->numOfRows, (int32_t)taosArrayGetSize(pSpill->pPending));
 
-  SOperatorInfo* upstream = pOperator->upstream[0];
+  rewind(pPart->file);
 
-  while(1) {
-    publishOperatorProfEvent(upstream, QUERY_PROF_BEFORE_OPERATOR_EXEC);
-    SSDataBlock* pBlock = upstream->exec(upstream, newgroup);
-    publishOperatorProfEvent(upstream, QUERY_PROF_AFTER_OPERATOR_EXEC);
-    if (pBlock == NULL) {
-      break;
+  SGroupbySpillChunk chunk = {0};
+  while (fread(&chunk, sizeof(chunk), 1, pPart->file) == 1) {
+    for (int32_t i = 0; i < pSpill->numOfCols; ++i) {
+      SColumnInfoData* p = taosArrayGet(pBlock->pDataBlock, i);
+      if (fread(p->pData, p->info.bytes, chunk.rows, pPart->file) != chunk.rows) {
+        qError("QInfo:0x%"PRIx64" failed to read group by spill file:%s", GET_QID(pRuntimeEnv), pPart->path);
+        longjmp(pRuntimeEnv->env, TSDB_CODE_QRY_SYS_ERROR);
+      }
     }
 
-    // the pDataBlock are always the same one, no need to call this again
+    pBlock->info.rows = chunk.rows;
+    pRuntimeEnv->current = chunk.pTableInfo;
+
     setInputDataBlock(pOperator, pInfo->binfo.pCtx, pBlock, pRuntimeEnv->pQueryAttr->order.order);
     setTagValue(pOperator, pRuntimeEnv->current->pTable, pInfo->binfo.pCtx, pOperator->numOfOutput);
-    if (pInfo->colIndex == -1) {
-      pInfo->colIndex = getGroupbyColumnIndex(pRuntimeEnv->pQueryAttr->pGroupbyExpr, pBlock);
-    }
-
     doHashGroupbyAgg(pOperator, pInfo, pBlock);
   }
 
-  pOperator->status = OP_RES_TO_RETURN;
-  closeAllResultRows(&pInfo->binfo.resultRowInfo);
-  setQueryStatus(pRuntimeEnv, QUERY_COMPLETED);
+  pRuntimeEnv->current = current;
 
-  if (!pRuntimeEnv->pQueryAttr->stableQuery) { // finalize include the update of result rows
-    finalizeQueryResult(pOperator, pInfo->binfo.pCtx, &pInfo->binfo.resultRowInfo, pInfo->binfo.rowCellInfoOffset);
-  } else {
-    updateNumOfRowsInResultRows(pRuntimeEnv, pInfo->binfo.pCtx, pOperator->numOfOutput, &pInfo->binfo.resultRowInfo, pInfo->binfo.rowCellInfoOffset);
-  }
+  destroyGroupbySpillPart(pSpill->pCurrent);
+  pSpill->pCurrent = NULL;
 
-  initGroupResInfo(&pRuntimeEnv->groupResInfo, &pInfo->binfo.resultRowInfo);
-  if (!pRuntimeEnv->pQueryAttr->stableQuery) {
-    sortGroupResByOrderList(&pRuntimeEnv->groupResInfo, pRuntimeEnv, pInfo->binfo.pRes, pInfo->binfo.pCtx);
+  finishGroupbySpillPass(pRuntimeEnv, pSpill);
+}
+
+static SSDataBlock* hashGroupbyAggregate(void* param, bool* newgroup) {
+  SOperatorInfo* pOperator = (SOperatorInfo*) param;
+  if (pOperator->status == OP_EXEC_DONE) {
+    return NULL;
   }
 
-  toSSDataBlock(&pRuntimeEnv->groupResInfo, pRuntimeEnv, pInfo->binfo.pRes);
+  SGroupbyOperatorInfo *pInfo = pOperator->info;
 
-  if (pInfo->binfo.pRes->info.rows == 0 || !hasRemainDataInCurrentGroup(&pRuntimeEnv->groupResInfo)) {
-    pOperator->status = OP_EXEC_DONE;
+  SQueryRuntimeEnv* pRuntimeEnv = pOperator->pRuntimeEnv;
+  if (pOperator->status != OP_RES_TO_RETURN) {
+    SOperatorInfo* upstream = pOperator->upstream[0];
+
+    while(1) {
+      publishOperatorProfEvent(upstream, QUERY_PROF_BEFORE_OPERATOR_EXEC);
+      SSDataBlock* pBlock = upstream->exec(upstream, newgroup);
+      publishOperatorProfEvent(upstream, QUERY_PROF_AFTER_OPERATOR_EXEC);
+      if (pBlock == NULL) {
+        break;
+      }
+
+      // the pDataBlock are always the same one, no need to call this again
+      setInputDataBlock(pOperator, pInfo->binfo.pCtx, pBlock, pRuntimeEnv->pQueryAttr->order.order);
+      setTagValue(pOperator, pRuntimeEnv->current->pTable, pInfo->binfo.pCtx, pOperator->numOfOutput);
+      if (pInfo->colIndex == -1) {
+        pInfo->colIndex = getGroupbyColumnIndex(pRuntimeEnv->pQueryAttr->pGroupbyExpr, pBlock);
+
+        if (pInfo->pSpill != NULL) {
+          SColumnInfoData* pColInfoData = taosArrayGet(pBlock->pDataBlock, pInfo->colIndex);
+          pInfo->pSpill->maxGroups = getGroupbyMaxGroups(pRuntimeEnv, pColInfoData->info.bytes);
+        }
+      }
+
+      doHashGroupbyAgg(pOperator, pInfo, pBlock);
+    }
+
+    finishGroupbySpillPass(pRuntimeEnv, pInfo->pSpill);
+    finalizeGroupbyResult(pOperator, pInfo);
   }
 
-  return pInfo->binfo.pRes;
+  while (1) {
+    toSSDataBlock(&pRuntimeEnv->groupResInfo, pRuntimeEnv, pInfo->binfo.pRes);
+
+    bool spilled = hasGroupbySpillPart(pInfo);
+    if (pInfo->binfo.pRes->info.rows > 0 || !spilled) {
+      if (!spilled && (pInfo->binfo.pRes->info.rows == 0 || !hasRemainDataInCurrentGroup(&pRuntimeEnv->groupResInfo))) {
+        pOperator->status = OP_EXEC_DONE;
+      }
+
+      return pInfo->binfo.pRes;
+    }
+
+    // all the groups in memory are returned, continue with the groups of a spilled partition
+    resetAggResultRows(pRuntimeEnv, &pInfo->binfo.resultRowInfo);
+    doHashGroupbySpillPart(pOperator, pInfo);
+    finalizeGroupbyResult(pOperator, pInfo);
+  }
 }
 
 static void doHandleRemainBlockForNewGroupImpl(SFillOperatorInfo *pInfo, SQueryRuntimeEnv* pRuntimeEnv, bool* newgroup) {
@@ -7030,9 +7635,19 @@ static void destroyStateWindowOperatorInfo(void* param, int32_t numOfOutput) {
   doDestroyBasicInfo(&pInfo->binfo, numOfOutput);
   tfree(pInfo->prevData);
 }
+static void destroySTableAggBatches(SAggOperatorInfo* pInfo) {
+  for (int32_t i = 0; i < pInfo->numOfBatches; ++i) {
+    taosArrayDestroy(&pInfo->pBatches[i].pGroupList);
+  }
+
+  tfree(pInfo->pBatches);
+  pInfo->numOfBatches = 0;
+}
+
 static void destroyAggOperatorInfo(void* param, int32_t numOfOutput) {
   SAggOperatorInfo* pInfo = (SAggOperatorInfo*) param;
   doDestroyBasicInfo(&pInfo->binfo, numOfOutput);
+  destroySTableAggBatches(pInfo);
 }
 static void destroySWindowOperatorInfo(void* param, int32_t numOfOutput) {
   SSWindowOperatorInfo* pInfo = (SSWindowOperatorInfo*) param;
@@ -7050,6 +7665,7 @@ static void destroyGroupbyOperatorInfo(void* param, int32_t numOfOutput) {
   SGroupbyOperatorInfo* pInfo = (SGroupbyOperatorInfo*) param;
   doDestroyBasicInfo(&pInfo->binfo, numOfOutput);
   tfree(pInfo->prevData);
+  destroyGroupbySpillInfo(pInfo->pSpill);
 }
 
 static void destroyProjectOperatorInfo(void* param, int32_t numOfOutput) {
@@ -7074,6 +7690,14 @@ static void destroyOrderOperatorInfo(void* param, int32_t numOfOutput) {
   pInfo->pDataBlock = destroyOutputBuf(pInfo->pDataBlock);
 }
 
+static void destroyTopNOperatorInfo(void* param, int32_t numOfOutput) {
+  STopNOperatorInfo* pInfo = (STopNOperatorInfo*) param;
+  pInfo->pRes = destroyOutputBuf(pInfo->pRes);
+  tfree(pInfo->colOffset);
+  tfree(pInfo->pSlots);
+  tfree(pInfo->pRows);
+}
+
 static void destroyConditionOperatorInfo(void* param, int32_t numOfOutput) {
   SFilterOperatorInfo* pInfo = (SFilterOperatorInfo*) param;
   doDestroyFilterInfo(pInfo->pFilterInfo, pInfo->numOfFilterCols);
@@ -7087,6 +7711,63 @@ static void destroyDistinctOperatorInfo(void* param, int32_t numOfOutput) {
   pInfo->pRes = destroyOutputBuf(pInfo->pRes);
 }
 
+// The table groups are aggregated in batches when there are more of them than the group by buffer takes, like the
+// groups of a group by tbname query over millions of tables. The results of a batch are returned before the tables of
+// the next batch are scanned, so a batch takes the table groups next to each other, and the tables are scanned once.
+static void createSTableAggBatches(SQueryRuntimeEnv* pRuntimeEnv, SOperatorInfo* upstream, SAggOperatorInfo* pInfo) {
+  SQueryAttr*      pQueryAttr = pRuntimeEnv->pQueryAttr;
+  STableGroupInfo* pTableGroupInfo = &pQueryAttr->tableGroupInfo;
+
+  if (tsGroupbyBufferSize < 0 || pQueryAttr->tsdb == NULL || pRuntimeEnv->pTsBuf != NULL ||
+      pRuntimeEnv->prevResult != NULL || pQueryAttr->tsCompQuery || pQueryAttr->pointInterpQuery ||
+      isFirstLastRowQuery(pQueryAttr) || isCachedLastQuery(pQueryAttr) || upstream->operatorType != OP_TableScan) {
+    return;
+  }
+
+  STableScanInfo* pScanInfo = upstream->info;
+  if (pScanInfo->times != 1 || pScanInfo->reverseTimes != 0 || pScanInfo->pParallel != NULL) {
+    return;
+  }
+
+  int32_t numOfGroups = (int32_t) taosArrayGetSize(pTableGroupInfo->pGroupList);
+  int32_t maxGroups = getGroupbyMaxGroups(pRuntimeEnv, sizeof(int32_t));
+  if (numOfGroups <= maxGroups) {
+    return;
+  }
+
+  int32_t numOfBatches = (numOfGroups + maxGroups - 1) / maxGroups;
+  pInfo->pBatches = calloc(numOfBatches, sizeof(STableGroupInfo));
+  if (pInfo->pBatches == NULL) {
+    qWarn("QInfo:0x%"PRIx64" failed to create the batches of %d table groups, all of them are aggregated at once",
+          GET_QID(pRuntimeEnv), numOfGroups);
+    return;
+  }
+
+  // the groups of the batches are kept by the query
+  for (int32_t i = 0; i < numOfBatches; ++i) {
+    STableGroupInfo* pBatch = &pInfo->pBatches[i];
+    int32_t          end = MIN((i + 1) * maxGroups, numOfGroups);
+
+    pBatch->pGroupList = taosArrayInit(end - i * maxGroups, POINTER_BYTES);
+    if (pBatch->pGroupList == NULL) {
+      qWarn("QInfo:0x%"PRIx64" failed to create the batches of %d table groups, all of them are aggregated at once",
+            GET_QID(pRuntimeEnv), numOfGroups);
+      destroySTableAggBatches(pInfo);
+      return;
+    }
+
+    pInfo->numOfBatches += 1;
+    for (int32_t j = i * maxGroups; j < end; ++j) {
+      SArray* group = taosArrayGetP(pTableGroupInfo->pGroupList, j);
+      taosArrayPush(pBatch->pGroupList, &group);
+      pBatch->numOfTables += taosArrayGetSize(group);
+    }
+  }
+
+  qDebug("QInfo:0x%"PRIx64" %d table groups are aggregated in %d batches", GET_QID(pRuntimeEnv), numOfGroups,
+         numOfBatches);
+}
+
 SOperatorInfo* createMultiTableAggOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperatorInfo* upstream, SExprInfo* pExpr, int32_t numOfOutput) {
   SAggOperatorInfo* pInfo = calloc(1, sizeof(SAggOperatorInfo));
 
@@ -7110,7 +7791,522 @@ SOperatorInfo* createMultiTableAggOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SO
   pOperator->cleanup      = destroyAggOperatorInfo;
   appendUpstream(pOperator, upstream);
 
+  createSTableAggBatches(pRuntimeEnv, upstream, pInfo);
+
+  return pOperator;
+}
+
+static bool isParallelAggFunction(int32_t functionId) {
+  switch (functionId) {
+    case TSDB_FUNC_COUNT:
+    case TSDB_FUNC_SUM:
+    case TSDB_FUNC_AVG:
+    case TSDB_FUNC_MIN:
+    case TSDB_FUNC_MAX:
+    case TSDB_FUNC_TOP:
+    case TSDB_FUNC_BOTTOM:
+    case TSDB_FUNC_SPREAD:
+    case TSDB_FUNC_FIRST_DST:
+    case TSDB_FUNC_LAST_DST:
+    case TSDB_FUNC_TS:
+    case TSDB_FUNC_TS_DUMMY:
+    case TSDB_FUNC_TAG_DUMMY:
+    case TSDB_FUNC_TAG:
+      return true;
+    default:
+      return false;
+  }
+}
+
+#define PARALLEL_AGG_WORKER_BUF_SIZE  (20 * 1048576)  // at most in memory for the result rows of a worker
+
+// A super table aggregation that scans the tables once may be split among the query workers. Each worker aggregates
+// the tables it takes into partial results of the groups, which the client merges like those of different vnodes.
+static bool isParallelAggQuery(SQInfo* pQInfo) {
+  SQueryRuntimeEnv* pRuntimeEnv = &pQInfo->runtimeEnv;
+  SQueryAttr*       pQueryAttr = pRuntimeEnv->pQueryAttr;
+  SOperatorInfo*    proot = pRuntimeEnv->proot;
+
+  if (qQueryWorkers() < 2 || pQueryAttr->tsdb == NULL || !pQueryAttr->stableQuery || pQueryAttr->pExpr2 != NULL ||
+      pQueryAttr->pUdfInfo != NULL || pRuntimeEnv->pTsBuf != NULL || pRuntimeEnv->prevResult != NULL ||
+      pRuntimeEnv->tableqinfoGroupInfo.numOfTables < 2) {
+    return false;
+  }
+
+  if (proot == NULL || proot->operatorType != OP_MultiTableAggregate || proot->upstream[0]->operatorType != OP_TableScan) {
+    return false;
+  }
+
+  STableScanInfo* pScanInfo = proot->upstream[0]->info;
+  if (pScanInfo->times != 1 || pScanInfo->reverseTimes != 0) {
+    return false;
+  }
+
+  // the groups beyond the group by buffer are aggregated in batches one after another
+  SAggOperatorInfo* pAggInfo = proot->info;
+  if (pAggInfo->pBatches != NULL) {
+    return false;
+  }
+
+  for (int32_t i = 0; i < pQueryAttr->numOfOutput; ++i) {
+    if (!isParallelAggFunction(pQueryAttr->pExpr1[i].base.functionId)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// cut the tables into morsels small enough to keep all workers busy until the last one is taken
+static int32_t createParallelMorsels(SParallelAggInfo* pInfo, STableGroupInfo* pTableGroupInfo) {
+  int32_t numOfTables = (int32_t) pTableGroupInfo->numOfTables;
+  int32_t size = (numOfTables + pInfo->numOfWorkers * 4 - 1) / (pInfo->numOfWorkers * 4);
+
+  pInfo->pMorsels = calloc((numOfTables + size - 1) / size, sizeof(STableGroupInfo));
+  if (pInfo->pMorsels == NULL) {
+    return TSDB_CODE_QRY_OUT_OF_MEMORY;
+  }
+
+  STableGroupInfo* pMorsel = NULL;
+  size_t numOfGroups = taosArrayGetSize(pTableGroupInfo->pGroupList);
+
+  for (int32_t i = 0; i < numOfGroups; ++i) {
+    SArray* group = taosArrayGetP(pTableGroupInfo->pGroupList, i);
+
+    size_t num = taosArrayGetSize(group);
+    for (int32_t j = 0; j < num; ++j) {
+      if (pMorsel == NULL || pMorsel->numOfTables >= size) {
+        pMorsel = &pInfo->pMorsels[pInfo->numOfMorsels++];
+
+        SArray* p = taosArrayInit(size, sizeof(STableKeyInfo));
+        pMorsel->pGroupList = taosArrayInit(1, POINTER_BYTES);
+        if (p == NULL || pMorsel->pGroupList == NULL) {
+          taosArrayDestroy(&p);
+          return TSDB_CODE_QRY_OUT_OF_MEMORY;
+        }
+
+        taosArrayPush(pMorsel->pGroupList, &p);
+      }
+
+      SArray* p = taosArrayGetP(pMorsel->pGroupList, 0);
+      taosArrayPush(p, taosArrayGet(group, j));
+      pMorsel->numOfTables += 1;
+    }
+  }
+
+  return TSDB_CODE_SUCCESS;
+}
+
+// scan the morsels one after another, as long as any is left
+static SSDataBlock* doMorselScan(void* param, bool* newgroup) {
+  SOperatorInfo* pOperator = (SOperatorInfo*) param;
+
+  STableScanInfo   *pTableScanInfo = pOperator->info;
+  SParallelAggInfo *pInfo = pTableScanInfo->pParallel;
+  SQueryRuntimeEnv *pRuntimeEnv = pOperator->pRuntimeEnv;
+  SQueryAttr       *pQueryAttr = pRuntimeEnv->pQueryAttr;
+
+  *newgroup = false;
+
+  while (1) {
+    if (isQueryKilled(pInfo->pQInfo)) {
+      longjmp(pRuntimeEnv->env, TSDB_CODE_TSC_QUERY_CANCELLED);
+    }
+
+    if (pInfo->code != TSDB_CODE_SUCCESS) {  // another worker failed, the query is aborted anyway
+      longjmp(pRuntimeEnv->env, pInfo->code);
+    }
+
+    if (pTableScanInfo->pQueryHandle != NULL) {
+      SSDataBlock* pBlock = doTableScanImpl(pOperator, newgroup);
+      if (pBlock != NULL) {
+        return pBlock;
+      }
+
+      tsdbCleanupQueryHandle(pTableScanInfo->pQueryHandle);
+      pTableScanInfo->pQueryHandle = NULL;
+      pRuntimeEnv->pQueryHandle = NULL;
+    }
+
+    int32_t index = atomic_fetch_add_32(&pInfo->nextMorsel, 1);
+    if (index >= pInfo->numOfMorsels) {
+      return NULL;
+    }
+
+    STsdbQueryCond cond = createTsdbQueryCond(pQueryAttr, &pQueryAttr->window);
+
+    terrno = TSDB_CODE_SUCCESS;
+    pTableScanInfo->pQueryHandle = tsdbQueryTables(pQueryAttr->tsdb, &cond, &pInfo->pMorsels[index], GET_QID(pRuntimeEnv),
+                                                   &pQueryAttr->memRef);
+    if (pTableScanInfo->pQueryHandle == NULL) {
+      longjmp(pRuntimeEnv->env, (terrno != TSDB_CODE_SUCCESS) ? terrno : TSDB_CODE_QRY_OUT_OF_MEMORY);
+    }
+
+    pRuntimeEnv->pQueryHandle = pTableScanInfo->pQueryHandle;
+  }
+}
+
+static int32_t appendParallelAggResult(SParallelAggInfo* pInfo, SSDataBlock* pBlock) {
+  int32_t code = TSDB_CODE_SUCCESS;
+
+  pthread_mutex_lock(&pInfo->lock);
+
+  SSDataBlock* pGather = pInfo->pGather;
+  int32_t      rows = pGather->info.rows + pBlock->info.rows;
+
+  if (rows > pInfo->capacity) {
+    int32_t capacity = MAX(rows, pInfo->capacity * 2);
+
+    for (int32_t i = 0; i < pGather->info.numOfCols; ++i) {
+      SColumnInfoData* pColInfo = taosArrayGet(pGather->pDataBlock, i);
+
+      char* p = realloc(pColInfo->pData, (size_t)capacity * pColInfo->info.bytes);
+      if (p == NULL) {
+        code = TSDB_CODE_QRY_OUT_OF_MEMORY;
+        goto _end;
+      }
+
+      pColInfo->pData = p;
+    }
+
+    pInfo->capacity = capacity;
+  }
+
+  for (int32_t i = 0; i < pGather->info.numOfCols; ++i) {
+    SColumnInfoData* pColInfo = taosArrayGet(pGather->pDataBlock, i);
+    SColumnInfoData* pSrc = taosArrayGet(pBlock->pDataBlock, i);
+
+    memcpy(pColInfo->pData + (size_t)pGather->info.rows * pColInfo->info.bytes, pSrc->pData,
+           (size_t)pBlock->info.rows * pColInfo->info.bytes);
+  }
+
+  pGather->info.rows = rows;
+
+_end:
+  pthread_mutex_unlock(&pInfo->lock);
+  return code;
+}
+
+static void doParallelAggTask(SSchedMsg* pMsg) {
+  SParallelAggInfo *pInfo = pMsg->ahandle;
+  SQInfo           *pWorker = pMsg->thandle;
+  SQueryRuntimeEnv *pRuntimeEnv = &pWorker->runtimeEnv;
+  STableScanInfo   *pScanInfo = pRuntimeEnv->proot->upstream[0]->info;
+
+  int32_t code = setjmp(pRuntimeEnv->env);
+  if (code == TSDB_CODE_SUCCESS) {
+    bool         newgroup = false;
+    SSDataBlock* pBlock = NULL;
+
+    while ((pBlock = pRuntimeEnv->proot->exec(pRuntimeEnv->proot, &newgroup)) != NULL) {
+      if (pBlock->info.rows > 0 && (code = appendParallelAggResult(pInfo, pBlock)) != TSDB_CODE_SUCCESS) {
+        break;
+      }
+    }
+  }
+
+  if (code != TSDB_CODE_SUCCESS) {
+    qDebug("QInfo:0x%"PRIx64" query worker aborted, code:%s", pWorker->qId, tstrerror(code));
+    atomic_val_compare_exchange_32(&pInfo->code, TSDB_CODE_SUCCESS, code);
+  }
+
+  // the snapshot of memory tables is released before the workers are destroyed, so is the handle taking it
+  tsdbCleanupQueryHandle(pScanInfo->pQueryHandle);
+  pScanInfo->pQueryHandle = NULL;
+  pRuntimeEnv->pQueryHandle = NULL;
+
+  tsem_post(&pInfo->done);
+}
+
+static void addParallelAggCost(SQueryCostInfo* pSummary, SQueryCostInfo* pWorker) {
+  pSummary->loadStatisTime      += pWorker->loadStatisTime;
+  pSummary->loadFileBlockTime   += pWorker->loadFileBlockTime;
+  pSummary->loadDataInCacheTime += pWorker->loadDataInCacheTime;
+  pSummary->loadStatisSize      += pWorker->loadStatisSize;
+  pSummary->loadFileBlockSize   += pWorker->loadFileBlockSize;
+  pSummary->loadDataInCacheSize += pWorker->loadDataInCacheSize;
+  pSummary->loadDataTime        += pWorker->loadDataTime;
+  pSummary->totalRows           += pWorker->totalRows;
+  pSummary->totalCheckedRows    += pWorker->totalCheckedRows;
+  pSummary->totalBlocks         += pWorker->totalBlocks;
+  pSummary->loadBlocks          += pWorker->loadBlocks;
+  pSummary->loadBlockStatis     += pWorker->loadBlockStatis;
+  pSummary->discardBlocks       += pWorker->discardBlocks;
+}
+
+static SSDataBlock* doParallelAggregate(void* param, bool* newgroup) {
+  SOperatorInfo* pOperator = (SOperatorInfo*) param;
+  if (pOperator->status == OP_EXEC_DONE) {
+    return NULL;
+  }
+
+  SParallelAggInfo* pInfo = pOperator->info;
+  SQueryRuntimeEnv* pRuntimeEnv = pOperator->pRuntimeEnv;
+
+  *newgroup = false;
+
+  if (pOperator->status == OP_IN_EXECUTING) {
+    for (int32_t i = 0; i < pInfo->numOfWorkers; ++i) {
+      qScheduleQueryWork(doParallelAggTask, pInfo, pInfo->pWorkers[i]);
+    }
+
+    for (int32_t i = 0; i < pInfo->numOfWorkers; ++i) {
+      tsem_wait(&pInfo->done);
+    }
+
+    for (int32_t i = 0; i < pInfo->numOfWorkers; ++i) {
+      addParallelAggCost(&pInfo->pQInfo->summary, &pInfo->pWorkers[i]->summary);
+    }
+
+    pOperator->status = OP_RES_TO_RETURN;
+    if (pInfo->code != TSDB_CODE_SUCCESS) {
+      longjmp(pRuntimeEnv->env, pInfo->code);
+    }
+
+    qDebug("QInfo:0x%"PRIx64" %u tables aggregated in %d morsels by %d workers, %d bytes of result buffer each, %d "
+           "partial results", GET_QID(pRuntimeEnv), pRuntimeEnv->tableqinfoGroupInfo.numOfTables, pInfo->numOfMorsels,
+           pInfo->numOfWorkers, pInfo->bufSize, pInfo->pGather->info.rows);
+  }
+
+  // return the partial results in blocks no larger than the response
+  SSDataBlock* pRes = pInfo->pRes;
+  int32_t      rows = MIN(pInfo->pGather->info.rows - pInfo->offset, pRuntimeEnv->resultInfo.capacity);
+
+  for (int32_t i = 0; i < pRes->info.numOfCols; ++i) {
+    SColumnInfoData* pColInfo = taosArrayGet(pRes->pDataBlock, i);
+    SColumnInfoData* pSrc = taosArrayGet(pInfo->pGather->pDataBlock, i);
+
+    memcpy(pColInfo->pData, pSrc->pData + (size_t)pInfo->offset * pColInfo->info.bytes,
+           (size_t)rows * pColInfo->info.bytes);
+  }
+
+  pRes->info.rows = rows;
+  pInfo->offset += rows;
+
+  if (pInfo->offset >= pInfo->pGather->info.rows) {
+    doSetOperatorCompleted(pOperator);
+  }
+
+  return pRes;
+}
+
+static SQInfo* createParallelAggWorker(SParallelAggInfo* pInfo, char* colCond, int32_t colCondLen) {
+  SQInfo*           pQInfo = pInfo->pQInfo;
+  SQueryRuntimeEnv* pMaster = &pQInfo->runtimeEnv;
+
+  SQInfo* pWorker = calloc(1, sizeof(SQInfo));
+  if (pWorker == NULL) {
+    return NULL;
+  }
+
+  // the attributes and the snapshot of memory tables are shared with the query, but the filters keep the data of
+  // the block being filtered
+  pWorker->query = *pMaster->pQueryAttr;
+  pWorker->query.pFilters = NULL;
+  if (pMaster->pQueryAttr->pFilters != NULL &&
+      (colCond == NULL || createQueryFilter(colCond, colCondLen, &pWorker->query.pFilters) != TSDB_CODE_SUCCESS ||
+       pWorker->query.pFilters == NULL)) {
+    filterFreeInfo(pWorker->query.pFilters);
+    free(pWorker);
+    return NULL;
+  }
+
+  pWorker->signature = pWorker;
+  pWorker->qId       = pQInfo->qId;
+
+  // each table is taken by one worker only, so the table query infos are shared as well
+  SQueryRuntimeEnv* pRuntimeEnv = &pWorker->runtimeEnv;
+  pRuntimeEnv->qinfo = pWorker;
+  pRuntimeEnv->pQueryAttr = &pWorker->query;
+  pRuntimeEnv->tableqinfoGroupInfo = pMaster->tableqinfoGroupInfo;
+  pRuntimeEnv->groupResInfo.totalGroup = pMaster->groupResInfo.totalGroup;
+  pRuntimeEnv->cur.vgroupIndex = -1;
+  pRuntimeEnv->udfIsCopy = true;
+  setResultBufSize(&pWorker->query, &pRuntimeEnv->resultInfo);
+
+  STableScanInfo* pScanInfo = calloc(1, sizeof(STableScanInfo));
+  SOperatorInfo*  pOperator = calloc(1, sizeof(SOperatorInfo));
+  if (pScanInfo == NULL || pOperator == NULL) {
+    tfree(pScanInfo);
+    tfree(pOperator);
+    goto _error;
+  }
+
+  pScanInfo->times     = 1;
+  pScanInfo->order     = pWorker->query.order.order;
+  pScanInfo->pParallel = pInfo;
+
+  pOperator->name         = "MorselScanOperator";
+  pOperator->operatorType = OP_TableScan;
+  pOperator->blockingOptr = false;
+  pOperator->status       = OP_IN_EXECUTING;
+  pOperator->info         = pScanInfo;
+  pOperator->numOfOutput  = pWorker->query.numOfCols;
+  pOperator->pRuntimeEnv  = pRuntimeEnv;
+  pOperator->exec         = doMorselScan;
+  pRuntimeEnv->proot = pOperator;
+
+  int32_t ps = DEFAULT_PAGE_SIZE;
+  getIntermediateBufInfo(pRuntimeEnv, &ps, &pWorker->query.intermediateResultRowSize);
+
+  if (createDiskbasedResultBuffer(&pRuntimeEnv->pResultBuf, ps, pInfo->bufSize, pWorker->qId) != TSDB_CODE_SUCCESS) {
+    goto _error;
+  }
+
+  int32_t op = OP_MultiTableAggregate;
+  SArray* pPlan = taosArrayInit(1, sizeof(int32_t));
+  if (pPlan == NULL) {
+    goto _error;
+  }
+
+  taosArrayPush(pPlan, &op);
+  int32_t code = setupQueryRuntimeEnv(pRuntimeEnv, (int32_t) pWorker->query.tableGroupInfo.numOfTables, pPlan, NULL);
+  taosArrayDestroy(&pPlan);
+  if (code != TSDB_CODE_SUCCESS) {
+    goto _error;
+  }
+
+  setQueryStatus(pRuntimeEnv, QUERY_NOT_COMPLETED);
+  return pWorker;
+
+_error:
+  destroyParallelAggWorker(pWorker);
+  return NULL;
+}
+
+static void destroyParallelAggWorker(SQInfo* pWorker) {
+  if (pWorker == NULL) {
+    return;
+  }
+
+  // the tables and the snapshot of memory tables are released with the query
+  memset(&pWorker->query.memRef, 0, sizeof(SMemRef));
+  memset(&pWorker->runtimeEnv.tableqinfoGroupInfo, 0, sizeof(STableGroupInfo));
+
+  teardownQueryRuntimeEnv(&pWorker->runtimeEnv);
+  filterFreeInfo(pWorker->query.pFilters);
+  free(pWorker);
+}
+
+// The result rows of a worker beyond its buffer in memory are kept in a file. The buffers of the workers are taken
+// from the query buffer, a query takes no more than a quarter of what is left so the queries started next still get
+// theirs. The tables are aggregated serially if the workers can not have two pages each.
+static int32_t reserveParallelAggBuf(SParallelAggInfo* pInfo) {
+  SQueryRuntimeEnv* pRuntimeEnv = &pInfo->pQInfo->runtimeEnv;
+
+  pInfo->bufSize = PARALLEL_AGG_WORKER_BUF_SIZE;
+  if (tsQueryBufferSizeBytes < 0) {
+    return TSDB_CODE_SUCCESS;
+  }
+
+  int32_t ps = DEFAULT_PAGE_SIZE;
+  int32_t rowSize = 0;
+  getIntermediateBufInfo(pRuntimeEnv, &ps, &rowSize);
+
+  int64_t share = atomic_load_64(&tsQueryBufferSizeBytes) / 4 / pInfo->numOfWorkers;
+  pInfo->bufSize = (int32_t) MIN(share, PARALLEL_AGG_WORKER_BUF_SIZE);
+  if (pInfo->bufSize < ps * 2) {
+    qDebug("QInfo:0x%"PRIx64" %"PRId64" bytes of the query buffer for each worker, less than two pages of %d bytes",
+           GET_QID(pRuntimeEnv), share, ps);
+    return TSDB_CODE_QRY_NOT_ENOUGH_BUFFER;
+  }
+
+  int32_t code = acquireQueryBuf((int64_t) pInfo->bufSize * pInfo->numOfWorkers);
+  if (code == TSDB_CODE_SUCCESS) {
+    pInfo->reservedBuf = (int64_t) pInfo->bufSize * pInfo->numOfWorkers;
+  }
+
+  return code;
+}
+
+static void destroyParallelAggOperatorInfo(void* param, int32_t numOfOutput) {
+  SParallelAggInfo* pInfo = (SParallelAggInfo*) param;
+
+  if (pInfo->pWorkers != NULL) {
+    for (int32_t i = 0; i < pInfo->numOfWorkers; ++i) {
+      destroyParallelAggWorker(pInfo->pWorkers[i]);
+    }
+
+    tfree(pInfo->pWorkers);
+  }
+
+  if (pInfo->pMorsels != NULL) {
+    for (int32_t i = 0; i < pInfo->numOfMorsels; ++i) {
+      SArray* p = taosArrayGetSize(pInfo->pMorsels[i].pGroupList) > 0 ? taosArrayGetP(pInfo->pMorsels[i].pGroupList, 0) : NULL;
+      taosArrayDestroy(&p);
+      taosArrayDestroy(&pInfo->pMorsels[i].pGroupList);
+    }
+
+    tfree(pInfo->pMorsels);
+  }
+
+  pInfo->pGather = destroyOutputBuf(pInfo->pGather);
+  pInfo->pRes = destroyOutputBuf(pInfo->pRes);
+  releaseQueryBufBytes(pInfo->reservedBuf);
+
+  tsem_destroy(&pInfo->done);
+  pthread_mutex_destroy(&pInfo->lock);
+}
+
+SOperatorInfo* createParallelAggOperatorInfo(SQInfo* pQInfo, SOperatorInfo* upstream, char* colCond, int32_t colCondLen) {
+  SQueryRuntimeEnv* pRuntimeEnv = &pQInfo->runtimeEnv;
+  SQueryAttr*       pQueryAttr = pRuntimeEnv->pQueryAttr;
+
+  SParallelAggInfo* pInfo = calloc(1, sizeof(SParallelAggInfo));
+  SOperatorInfo*    pOperator = calloc(1, sizeof(SOperatorInfo));
+  if (pInfo == NULL || pOperator == NULL) {
+    tfree(pInfo);
+    tfree(pOperator);
+    return NULL;
+  }
+
+  pInfo->pQInfo       = pQInfo;
+  pInfo->numOfWorkers = qQueryWorkers();
+  pInfo->capacity     = pRuntimeEnv->resultInfo.capacity;
+  tsem_init(&pInfo->done, 0, 0);
+  pthread_mutex_init(&pInfo->lock, NULL);
+
+  pOperator->name         = "ParallelAggregate";
+  pOperator->operatorType = OP_ParallelAggregate;
+  pOperator->blockingOptr = true;
+  pOperator->status       = OP_IN_EXECUTING;
+  pOperator->info         = pInfo;
+  pOperator->pExpr        = pQueryAttr->pExpr1;
+  pOperator->numOfOutput  = pQueryAttr->numOfOutput;
+  pOperator->pRuntimeEnv  = pRuntimeEnv;
+  pOperator->exec         = doParallelAggregate;
+  pOperator->cleanup      = destroyParallelAggOperatorInfo;
+
+  pInfo->pGather = createOutputBuf(pQueryAttr->pExpr1, pQueryAttr->numOfOutput, pInfo->capacity);
+  pInfo->pRes = createOutputBuf(pQueryAttr->pExpr1, pQueryAttr->numOfOutput, pRuntimeEnv->resultInfo.capacity);
+
+  if (createParallelMorsels(pInfo, &pQueryAttr->tableGroupInfo) != TSDB_CODE_SUCCESS) {
+    goto _error;
+  }
+
+  pInfo->numOfWorkers = MIN(pInfo->numOfWorkers, pInfo->numOfMorsels);
+  if (reserveParallelAggBuf(pInfo) != TSDB_CODE_SUCCESS) {
+    goto _error;
+  }
+
+  pInfo->pWorkers = calloc(pInfo->numOfWorkers, POINTER_BYTES);
+  if (pInfo->pWorkers == NULL) {
+    goto _error;
+  }
+
+  for (int32_t i = 0; i < pInfo->numOfWorkers; ++i) {
+    pInfo->pWorkers[i] = createParallelAggWorker(pInfo, colCond, colCondLen);
+    if (pInfo->pWorkers[i] == NULL) {
+      goto _error;
+    }
+  }
+
+  appendUpstream(pOperator, upstream);
   return pOperator;
+
+_error:
+  destroyOperatorInfo(pOperator);
+  return NULL;
 }
 
 SOperatorInfo* createProjectOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperatorInfo* upstream, SExprInfo* pExpr, int32_t numOfOutput) {
@@ -7366,6 +8562,7 @@ SOperatorInfo* createGroupbyOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperato
 
   pInfo->binfo.pRes = createOutputBuf(pExpr, numOfOutput, pRuntimeEnv->resultInfo.capacity);
   initResultRowInfo(&pInfo->binfo.resultRowInfo, 8, TSDB_DATA_TYPE_INT);
+  pInfo->pSpill = createGroupbySpillInfo(pRuntimeEnv);
 
   SOperatorInfo* pOperator = calloc(1, sizeof(SOperatorInfo));
   pOperator->name         = "GroupbyAggOperator";
@@ -8029,6 +9226,7 @@ int32_t convertQueryMsg(SQueryTableMsg *pQueryMsg, SQueryParam* param) {
   }
 
   if (pQueryMsg->colCondLen > 0) {
+    param->colCondLen = pQueryMsg->colCondLen;
     param->colCond = calloc(1, pQueryMsg->colCondLen);
     if (param->colCond == NULL) {
       code = TSDB_CODE_QRY_OUT_OF_MEMORY;
@@ -9189,6 +10387,15 @@ int32_t initQInfo(STsBufInfo* pTsBufInfo, void* tsdb, void* sourceOptr, SQInfo*
     goto _error;
   }
 
+  if (isParallelAggQuery(pQInfo)) {
+    SOperatorInfo* pOperator = createParallelAggOperatorInfo(pQInfo, pRuntimeEnv->proot, param->colCond, param->colCondLen);
+    if (pOperator == NULL) {
+      qWarn("QInfo:0x%"PRIx64" failed to create query workers, tables are aggregated serially", pQInfo->qId);
+    } else {
+      pRuntimeEnv->proot = pOperator;
+    }
+  }
+
   return code;
 
 _error:
@@ -9414,7 +10621,11 @@ static int64_t getQuerySupportBufSize(size_t numOfTables) {
 }
 
 int32_t checkForQueryBuf(size_t numOfTables) {
-  int64_t t = getQuerySupportBufSize(numOfTables);
+  return acquireQueryBuf(getQuerySupportBufSize(numOfTables));
+}
+
+// take bytes of the query buffer, it is not limited if queryBufferSize is -1
+static int32_t acquireQueryBuf(int64_t t) {
   if (tsQueryBufferSizeBytes < 0) {
     return TSDB_CODE_SUCCESS;
   } else if (tsQueryBufferSizeBytes > 0) {
@@ -9461,12 +10672,14 @@ bool checkNeedToCompressQueryCol(SQInfo *pQInfo) {
 }
 
 void releaseQueryBuf(size_t numOfTables) {
+  releaseQueryBufBytes(getQuerySupportBufSize(numOfTables));
+}
+
+static void releaseQueryBufBytes(int64_t t) {
   if (tsQueryBufferSizeBytes < 0) {
     return;
   }
 
-  int64_t t = getQuerySupportBufSize(numOfTables);
-
   // restore value is not enough buffer available
   atomic_add_fetch_64(&tsQueryBufferSizeBytes, t);
 }
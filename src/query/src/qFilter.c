@@ -2658,6 +2658,7 @@ int32_t filterGenerateComInfo(SFilterInfo *info) {
     
     info->cunits[i].dataSize = FILTER_UNIT_COL_SIZE(info, unit);
     info->cunits[i].dataType = FILTER_UNIT_DATA_TYPE(unit);
+    info->cunits[i].vfunc = filterGetVecFunc(&info->cunits[i]);
   }
   
   return TSDB_CODE_SUCCESS;
@@ -2753,8 +2754,11 @@ int32_t filterRmUnitByRange(SFilterInfo *info, SDataStatis *pDataStatis, int32_t
       maxRes = (*gRangeCompare[cunit->rfunc])(maxVal, maxVal, cunit->valData, cunit->valData2, gDataCompare[cunit->func]);
 
       if (minRes && maxRes) {
-        info->blkUnitRes[k] = 1;
-        rmUnit = 1;
+        // the null rows of the block match no range
+        if (pDataBlockst->numOfNull <= 0) {
+          info->blkUnitRes[k] = 1;
+          rmUnit = 1;
+        }
       } else if ((!minRes) && (!maxRes)) {
         minRes = filterDoCompare(gDataCompare[cunit->func], TSDB_RELATION_LESS_EQUAL, minVal, cunit->valData);
         maxRes = filterDoCompare(gDataCompare[cunit->func], TSDB_RELATION_GREATER_EQUAL, maxVal, cunit->valData2);
@@ -2771,8 +2775,11 @@ int32_t filterRmUnitByRange(SFilterInfo *info, SDataStatis *pDataStatis, int32_t
       maxRes = filterDoCompare(gDataCompare[cunit->func], cunit->optr, maxVal, cunit->valData);
 
       if (minRes && maxRes) {
-        info->blkUnitRes[k] = 1;
-        rmUnit = 1;
+        // the null rows of the block match no range
+        if (pDataBlockst->numOfNull <= 0) {
+          info->blkUnitRes[k] = 1;
+          rmUnit = 1;
+        }
       } else if ((!minRes) && (!maxRes)) {
         if (cunit->optr == TSDB_RELATION_EQUAL) {
           minRes = filterDoCompare(gDataCompare[cunit->func], TSDB_RELATION_GREATER, minVal, cunit->valData);
@@ -2915,6 +2922,10 @@ bool filterExecuteBasedOnStatisImpl(void *pinfo, int32_t numOfRows, int8_t** p,
 
 
 
+static int32_t filterExecuteVecImpl(SFilterInfo *info, int32_t numOfRows, int8_t *p, bool blkUnits, bool *all);
+bool filterExecuteImplVec(void *pinfo, int32_t numOfRows, int8_t** p, SDataStatis *statis, int16_t numOfCols);
+bool filterExecuteImpl(void *pinfo, int32_t numOfRows, int8_t** p, SDataStatis *statis, int16_t numOfCols);
+
 int32_t filterExecuteBasedOnStatis(SFilterInfo *info, int32_t numOfRows, int8_t** p, SDataStatis *statis, int16_t numOfCols, bool* all) {
   if (statis && numOfRows >= FILTER_RM_UNIT_MIN_ROWS) {    
     info->blkFlag = 0;
@@ -2931,8 +2942,20 @@ int32_t filterExecuteBasedOnStatis(SFilterInfo *info, int32_t numOfRows, int8_t*
       }
 
       assert(info->unitNum > 1);
-      
-      *all = filterExecuteBasedOnStatisImpl(info, numOfRows, p, statis, numOfCols);
+
+      if (info->func == filterExecuteImplVec) {
+        if (*p == NULL) {
+          *p = calloc(numOfRows, sizeof(int8_t));
+        }
+
+        if (filterExecuteVecImpl(info, numOfRows, *p, true, all) != TSDB_CODE_SUCCESS) {
+          // left to the filter of all units
+          info->blkFlag = 0;
+          return 1;
+        }
+      } else {
+        *all = filterExecuteBasedOnStatisImpl(info, numOfRows, p, statis, numOfCols);
+      }
 
       goto _return;
     }
@@ -3148,6 +3171,136 @@ bool filterExecuteImplMisc(void *pinfo, int32_t numOfRows, int8_t** p, SDataStat
   return all;
 }
 
+// Evaluate a unit on the row at colData into *res
+static void filterExecuteUnitRow(SFilterComUnit *cunit, void *colData, int8_t *res) {
+  uint8_t optr = cunit->optr;
+
+  if (colData == NULL || isNull(colData, cunit->dataType)) {
+    *res = optr == TSDB_RELATION_ISNULL ? true : false;
+  } else {
+    if (optr == TSDB_RELATION_NOTNULL) {
+      *res = 1;
+    } else if (optr == TSDB_RELATION_ISNULL) {
+      *res = 0;
+    } else if (cunit->rfunc >= 0) {
+      *res = (*gRangeCompare[cunit->rfunc])(colData, colData, cunit->valData, cunit->valData2, gDataCompare[cunit->func]);
+    } else {
+      if(cunit->dataType == TSDB_DATA_TYPE_NCHAR && (cunit->optr == TSDB_RELATION_MATCH || cunit->optr == TSDB_RELATION_NMATCH)){
+        char *newColData = calloc(cunit->dataSize * TSDB_NCHAR_SIZE + VARSTR_HEADER_SIZE, 1);
+        int32_t len = taosUcs4ToMbs(varDataVal(colData), varDataLen(colData), varDataVal(newColData));
+        if (len < 0){
+          qError("castConvert1 taosUcs4ToMbs error");
+        }else{
+          varDataSetLen(newColData, len);
+          *res = filterDoCompare(gDataCompare[cunit->func], cunit->optr, newColData, cunit->valData);
+        }
+        tfree(newColData);
+      }else if(cunit->dataType == TSDB_DATA_TYPE_JSON){
+        doJsonCompare(cunit, res, colData);
+      }else{
+        *res = filterDoCompare(gDataCompare[cunit->func], cunit->optr, colData, cunit->valData);
+      }
+    }
+  }
+}
+
+// Evaluate the units of a group on all the rows into gres. The units with a kernel run on the whole column and their
+// results are ANDed, the others are evaluated row by row and only on the rows the group may still select, skipping
+// the rows selected by an earlier group (done).
+static void filterExecuteGroupVec(SFilterInfo *info, int32_t numOfRows, uint32_t unitNum, uint32_t *unitIdxs,
+                                  const int8_t *done, int8_t *gres, int8_t *ures) {
+  for (uint32_t u = 0; u < unitNum; ++u) {
+    SFilterComUnit *cunit = &info->cunits[unitIdxs[u]];
+    int8_t *res = (u == 0) ? gres : ures;
+
+    if (cunit->colData == NULL) {
+      memset(res, cunit->optr == TSDB_RELATION_ISNULL, numOfRows);
+    } else if (cunit->vfunc != NULL) {
+      (*cunit->vfunc)(cunit->colData, numOfRows, cunit->valData, cunit->valData2, res);
+    } else {
+      for (int32_t i = 0; i < numOfRows; ++i) {
+        res[i] = 0;
+        if ((done != NULL && done[i]) || (u > 0 && gres[i] == 0)) {
+          continue;
+        }
+
+        filterExecuteUnitRow(cunit, (char *)cunit->colData + cunit->dataSize * i, &res[i]);
+      }
+    }
+
+    if (u > 0) {
+      for (int32_t i = 0; i < numOfRows; ++i) {
+        gres[i] &= ures[i];
+      }
+    }
+  }
+}
+
+// The groups, or the groups left by filterRmUnitByRange in blkUnits, are ORed into p, all is set if all rows match
+static int32_t filterExecuteVecImpl(SFilterInfo *info, int32_t numOfRows, int8_t *p, bool blkUnits, bool *all) {
+  uint32_t  groupNum = blkUnits ? info->blkGroupNum : info->groupNum;
+  uint32_t *unitIdx = info->blkUnits;
+  int8_t   *gres = malloc(numOfRows * 2 * sizeof(int8_t));
+  int32_t   matched = 0;
+
+  CHK_LRET(gres == NULL, TSDB_CODE_QRY_OUT_OF_MEMORY, "failed to allocate the results of %d rows", numOfRows);
+  int8_t *ures = gres + numOfRows;
+
+  for (uint32_t g = 0; g < groupNum; ++g) {
+    uint32_t  unitNum;
+    uint32_t *unitIdxs;
+
+    if (blkUnits) {
+      unitNum = *(unitIdx++);
+      unitIdxs = unitIdx;
+      unitIdx += unitNum;
+    } else {
+      unitNum = info->groups[g].unitNum;
+      unitIdxs = info->groups[g].unitIdxs;
+    }
+
+    if (g == 0) {
+      filterExecuteGroupVec(info, numOfRows, unitNum, unitIdxs, NULL, p, ures);
+    } else {
+      filterExecuteGroupVec(info, numOfRows, unitNum, unitIdxs, p, gres, ures);
+      for (int32_t i = 0; i < numOfRows; ++i) {
+        p[i] |= gres[i];
+      }
+    }
+  }
+
+  tfree(gres);
+
+  for (int32_t i = 0; i < numOfRows; ++i) {
+    matched += p[i];
+  }
+
+  *all = (matched == numOfRows);
+  return TSDB_CODE_SUCCESS;
+}
+
+bool filterExecuteImplVec(void *pinfo, int32_t numOfRows, int8_t** p, SDataStatis *statis, int16_t numOfCols) {
+  SFilterInfo *info = (SFilterInfo *)pinfo;
+  bool all = true;
+
+  if (filterExecuteBasedOnStatis(info, numOfRows, p, statis, numOfCols, &all) == 0) {
+    return all;
+  }
+
+  if (*p == NULL) {
+    *p = calloc(numOfRows, sizeof(int8_t));
+  }
+
+  int32_t code = filterExecuteVecImpl(info, numOfRows, *p, false, &all);
+  if (code != TSDB_CODE_SUCCESS) {
+    // the rows are filtered one by one without the results of the units
+    terrno = code;
+    return filterExecuteImpl(info, numOfRows, p, NULL, numOfCols);
+  }
+
+  return all;
+}
+
 bool filterExecuteImpl(void *pinfo, int32_t numOfRows, int8_t** p, SDataStatis *statis, int16_t numOfCols) {
   SFilterInfo *info = (SFilterInfo *)pinfo;
   bool all = true;
@@ -3173,38 +3326,9 @@ bool filterExecuteImpl(void *pinfo, int32_t numOfRows, int8_t** p, SDataStatis *
         //if (FILTER_UNIT_GET_F(info, uidx)) {
         //  p[i] = FILTER_UNIT_GET_R(info, uidx);
         //} else {
-          uint8_t optr = cunit->optr;
-
-          if (colData == NULL || isNull(colData, cunit->dataType)) {
-            (*p)[i] = optr == TSDB_RELATION_ISNULL ? true : false;
-          } else {
-            if (optr == TSDB_RELATION_NOTNULL) {
-              (*p)[i] = 1;
-            } else if (optr == TSDB_RELATION_ISNULL) {
-              (*p)[i] = 0;
-            } else if (cunit->rfunc >= 0) {
-              (*p)[i] = (*gRangeCompare[cunit->rfunc])(colData, colData, cunit->valData, cunit->valData2, gDataCompare[cunit->func]);
-            } else {
-              if(cunit->dataType == TSDB_DATA_TYPE_NCHAR && (cunit->optr == TSDB_RELATION_MATCH || cunit->optr == TSDB_RELATION_NMATCH)){
-                char *newColData = calloc(cunit->dataSize * TSDB_NCHAR_SIZE + VARSTR_HEADER_SIZE, 1);
-                int32_t len = taosUcs4ToMbs(varDataVal(colData), varDataLen(colData), varDataVal(newColData));
-                if (len < 0){
-                  qError("castConvert1 taosUcs4ToMbs error");
-                }else{
-                  varDataSetLen(newColData, len);
-                  (*p)[i] = filterDoCompare(gDataCompare[cunit->func], cunit->optr, newColData, cunit->valData);
-                }
-                tfree(newColData);
-              }else if(cunit->dataType == TSDB_DATA_TYPE_JSON){
-                doJsonCompare(cunit, &(*p)[i], colData);
-              }else{
-                (*p)[i] = filterDoCompare(gDataCompare[cunit->func], cunit->optr, colData, cunit->valData);
-              }
-            }
-          
+          filterExecuteUnitRow(cunit, colData, &(*p)[i]);
           //FILTER_UNIT_SET_R(info, uidx, p[i]);
           //FILTER_UNIT_SET_F(info, uidx);
-          }
 
         if ((*p)[i] == 0) {
           break;
@@ -3240,6 +3364,13 @@ int32_t filterSetExecFunc(SFilterInfo *info) {
     return TSDB_CODE_SUCCESS;
   }
 
+  for (uint32_t i = 0; i < info->unitNum; ++i) {
+    if (info->cunits[i].vfunc != NULL) {
+      info->func = filterExecuteImplVec;
+      return TSDB_CODE_SUCCESS;
+    }
+  }
+
   if (info->unitNum > 1) {
     info->func = filterExecuteImpl;
     return TSDB_CODE_SUCCESS;
@@ -0,0 +1,243 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "os.h"
+#include "qFilter.h"
+#include "tcompare.h"
+
+// Batch kernels of the filter units on fixed size columns. A kernel evaluates a comparison of one type on a whole
+// column and sets a byte per row, it has no branch in its loop so that the compiler vectorizes it, with the AVX2
+// version built for CPUs supporting it. The results are the same as gDataCompare and gRangeCompare: floats are equal
+// within FLT_COMPAR_TOL_FACTOR * FLT_EPSILON and a NaN is less than any value.
+
+#if defined(__x86_64__) && !defined(WINDOWS) && !defined(_TD_ARM_) && !defined(_TD_MIPS_)
+#define FILTER_VEC_X86
+#define FILTER_VEC_ATTR_AVX2 __attribute__((target("avx2")))
+#endif
+
+enum {
+  FILTER_VEC_LT,
+  FILTER_VEC_LE,
+  FILTER_VEC_GT,
+  FILTER_VEC_GE,
+  FILTER_VEC_EQ,
+  FILTER_VEC_NE,
+  FILTER_VEC_EE,  // ranges, excluding or including each end
+  FILTER_VEC_EI,
+  FILTER_VEC_IE,
+  FILTER_VEC_II,
+  FILTER_VEC_ISNULL,
+  FILTER_VEC_NOTNULL,
+  FILTER_VEC_OPS
+};
+
+enum {
+  FILTER_VEC_BOOL,
+  FILTER_VEC_INT8,
+  FILTER_VEC_INT16,
+  FILTER_VEC_INT32,
+  FILTER_VEC_INT64,
+  FILTER_VEC_UINT8,
+  FILTER_VEC_UINT16,
+  FILTER_VEC_UINT32,
+  FILTER_VEC_UINT64,
+  FILTER_VEC_FLOAT,
+  FILTER_VEC_DOUBLE,
+  FILTER_VEC_TYPES
+};
+
+#define VEC_EQ_I(x, a) ((x) == (a))
+#define VEC_GT_I(x, a) ((x) > (a))
+#define VEC_EQ_F(x, a) (fabsf((x) - (a)) <= FLT_COMPAR_TOL_FACTOR * FLT_EPSILON)
+#define VEC_GT_F(x, a) ((x) > (a))
+#define VEC_EQ_D(x, a) (fabs((x) - (a)) <= FLT_COMPAR_TOL_FACTOR * FLT_EPSILON)
+#define VEC_GT_D(x, a) ((x) > (a))
+
+// x is compared with l for the lower end and with r for the upper end
+#define VEC_LT(EQ, GT) (!EQ(x, r) & !GT(x, r))
+#define VEC_LE(EQ, GT) (EQ(x, r) | !GT(x, r))
+#define VEC_GT(EQ, GT) (!EQ(x, l) & GT(x, l))
+#define VEC_GE(EQ, GT) (EQ(x, l) | GT(x, l))
+
+// T is the type of the values, B the integer of the same size to tell a null value N by its bits
+#define FILTER_VEC_KERNEL(attr, fname, T, B, N, match)                                                       \
+  attr static void fname(const void *colData, int32_t numOfRows, const void *valData, const void *valData2, \
+                         int8_t *res) {                                                                     \
+    const T *v = (const T *)colData;                                                                        \
+    const B *b = (const B *)colData;                                                                        \
+    T        l = (valData != NULL) ? *(const T *)valData : 0;                                               \
+    T        r = (valData2 != NULL) ? *(const T *)valData2 : 0;                                             \
+    (void)l;                                                                                                \
+    (void)r;                                                                                                \
+    for (int32_t i = 0; i < numOfRows; ++i) {                                                               \
+      T x = v[i];                                                                                           \
+      (void)x;                                                                                              \
+      res[i] = match;                                                                                       \
+    }                                                                                                       \
+  }
+
+#define NN(B, N) (b[i] != (B)(N))
+
+#define FILTER_VEC_TYPE_KERNELS(attr, sfx, name, T, B, N, EQ, GT)                                          \
+  FILTER_VEC_KERNEL(attr, name##Lt##sfx, T, B, N, NN(B, N) & VEC_LT(EQ, GT))                               \
+  FILTER_VEC_KERNEL(attr, name##Le##sfx, T, B, N, NN(B, N) & VEC_LE(EQ, GT))                               \
+  FILTER_VEC_KERNEL(attr, name##Gt##sfx, T, B, N, NN(B, N) & VEC_GT(EQ, GT))                               \
+  FILTER_VEC_KERNEL(attr, name##Ge##sfx, T, B, N, NN(B, N) & VEC_GE(EQ, GT))                               \
+  FILTER_VEC_KERNEL(attr, name##Eq##sfx, T, B, N, NN(B, N) & EQ(x, l))                                     \
+  FILTER_VEC_KERNEL(attr, name##Ne##sfx, T, B, N, NN(B, N) & !EQ(x, l))                                    \
+  FILTER_VEC_KERNEL(attr, name##Ee##sfx, T, B, N, NN(B, N) & VEC_GT(EQ, GT) & VEC_LT(EQ, GT))              \
+  FILTER_VEC_KERNEL(attr, name##Ei##sfx, T, B, N, NN(B, N) & VEC_GT(EQ, GT) & VEC_LE(EQ, GT))              \
+  FILTER_VEC_KERNEL(attr, name##Ie##sfx, T, B, N, NN(B, N) & VEC_GE(EQ, GT) & VEC_LT(EQ, GT))              \
+  FILTER_VEC_KERNEL(attr, name##Ii##sfx, T, B, N, NN(B, N) & VEC_GE(EQ, GT) & VEC_LE(EQ, GT))              \
+  FILTER_VEC_KERNEL(attr, name##IsNull##sfx, T, B, N, !NN(B, N))                                           \
+  FILTER_VEC_KERNEL(attr, name##NotNull##sfx, T, B, N, NN(B, N))
+
+#define FILTER_VEC_KERNELS(attr, sfx)                                                                        \
+  FILTER_VEC_TYPE_KERNELS(attr, sfx, vecBool, int8_t, uint8_t, TSDB_DATA_BOOL_NULL, VEC_EQ_I, VEC_GT_I)      \
+  FILTER_VEC_TYPE_KERNELS(attr, sfx, vecInt8, int8_t, uint8_t, TSDB_DATA_TINYINT_NULL, VEC_EQ_I, VEC_GT_I)   \
+  FILTER_VEC_TYPE_KERNELS(attr, sfx, vecInt16, int16_t, uint16_t, TSDB_DATA_SMALLINT_NULL, VEC_EQ_I,         \
+                          VEC_GT_I)                                                                          \
+  FILTER_VEC_TYPE_KERNELS(attr, sfx, vecInt32, int32_t, uint32_t, TSDB_DATA_INT_NULL, VEC_EQ_I, VEC_GT_I)    \
+  FILTER_VEC_TYPE_KERNELS(attr, sfx, vecInt64, int64_t, uint64_t, TSDB_DATA_BIGINT_NULL, VEC_EQ_I, VEC_GT_I) \
+  FILTER_VEC_TYPE_KERNELS(attr, sfx, vecUint8, uint8_t, uint8_t, TSDB_DATA_UTINYINT_NULL, VEC_EQ_I,          \
+                          VEC_GT_I)                                                                          \
+  FILTER_VEC_TYPE_KERNELS(attr, sfx, vecUint16, uint16_t, uint16_t, TSDB_DATA_USMALLINT_NULL, VEC_EQ_I,      \
+                          VEC_GT_I)                                                                          \
+  FILTER_VEC_TYPE_KERNELS(attr, sfx, vecUint32, uint32_t, uint32_t, TSDB_DATA_UINT_NULL, VEC_EQ_I, VEC_GT_I) \
+  FILTER_VEC_TYPE_KERNELS(attr, sfx, vecUint64, uint64_t, uint64_t, TSDB_DATA_UBIGINT_NULL, VEC_EQ_I,        \
+                          VEC_GT_I)                                                                          \
+  FILTER_VEC_TYPE_KERNELS(attr, sfx, vecFloat, float, uint32_t, TSDB_DATA_FLOAT_NULL, VEC_EQ_F, VEC_GT_F)    \
+  FILTER_VEC_TYPE_KERNELS(attr, sfx, vecDouble, double, uint64_t, TSDB_DATA_DOUBLE_NULL, VEC_EQ_D, VEC_GT_D)
+
+#define FILTER_VEC_TYPE_TABLE(name, sfx)                                                                  \
+  {                                                                                                       \
+    name##Lt##sfx, name##Le##sfx, name##Gt##sfx, name##Ge##sfx, name##Eq##sfx, name##Ne##sfx,            \
+        name##Ee##sfx, name##Ei##sfx, name##Ie##sfx, name##Ii##sfx, name##IsNull##sfx, name##NotNull##sfx \
+  }
+
+#define FILTER_VEC_TABLE(sfx)                                                                           \
+  {                                                                                                     \
+    FILTER_VEC_TYPE_TABLE(vecBool, sfx), FILTER_VEC_TYPE_TABLE(vecInt8, sfx),                           \
+        FILTER_VEC_TYPE_TABLE(vecInt16, sfx), FILTER_VEC_TYPE_TABLE(vecInt32, sfx),                     \
+        FILTER_VEC_TYPE_TABLE(vecInt64, sfx), FILTER_VEC_TYPE_TABLE(vecUint8, sfx),                     \
+        FILTER_VEC_TYPE_TABLE(vecUint16, sfx), FILTER_VEC_TYPE_TABLE(vecUint32, sfx),                   \
+        FILTER_VEC_TYPE_TABLE(vecUint64, sfx), FILTER_VEC_TYPE_TABLE(vecFloat, sfx),                    \
+        FILTER_VEC_TYPE_TABLE(vecDouble, sfx)                                                           \
+  }
+
+FILTER_VEC_KERNELS(, )
+#ifdef FILTER_VEC_X86
+FILTER_VEC_KERNELS(FILTER_VEC_ATTR_AVX2, Avx2)
+#endif
+
+static const filter_vec_func filterVecKernels[][FILTER_VEC_TYPES][FILTER_VEC_OPS] = {
+    FILTER_VEC_TABLE(),
+#ifdef FILTER_VEC_X86
+    FILTER_VEC_TABLE(Avx2),
+#endif
+};
+
+static int32_t filterVecLevelSet = -1;
+
+static int32_t filterCpuVecLevel() {
+#ifdef FILTER_VEC_X86
+  if (taosGetCpuSimdLevel() >= TAOS_CPU_SIMD_AVX2) return FILTER_VEC_AVX2;
+#endif
+  return FILTER_VEC_SCALAR;
+}
+
+int32_t filterVecLevel() {
+  // resolved by the first filter, the threads resolving it together store the same level
+  int32_t level = atomic_load_32(&filterVecLevelSet);
+  if (level < 0) {
+    atomic_val_compare_exchange_32(&filterVecLevelSet, -1, filterCpuVecLevel());
+    level = atomic_load_32(&filterVecLevelSet);
+  }
+  return level;
+}
+
+int32_t filterSetVecLevel(int32_t level) {
+  int32_t cpuLevel = filterCpuVecLevel();
+  if (level > cpuLevel) level = cpuLevel;
+  if (level < FILTER_VEC_OFF) level = FILTER_VEC_OFF;
+
+  atomic_store_32(&filterVecLevelSet, level);
+  return level;
+}
+
+static int32_t filterVecType(int32_t type) {
+  switch (type) {
+    case TSDB_DATA_TYPE_BOOL:      return FILTER_VEC_BOOL;
+    case TSDB_DATA_TYPE_TINYINT:   return FILTER_VEC_INT8;
+    case TSDB_DATA_TYPE_SMALLINT:  return FILTER_VEC_INT16;
+    case TSDB_DATA_TYPE_INT:       return FILTER_VEC_INT32;
+    case TSDB_DATA_TYPE_BIGINT:
+    case TSDB_DATA_TYPE_TIMESTAMP: return FILTER_VEC_INT64;
+    case TSDB_DATA_TYPE_UTINYINT:  return FILTER_VEC_UINT8;
+    case TSDB_DATA_TYPE_USMALLINT: return FILTER_VEC_UINT16;
+    case TSDB_DATA_TYPE_UINT:      return FILTER_VEC_UINT32;
+    case TSDB_DATA_TYPE_UBIGINT:   return FILTER_VEC_UINT64;
+    case TSDB_DATA_TYPE_FLOAT:     return FILTER_VEC_FLOAT;
+    case TSDB_DATA_TYPE_DOUBLE:    return FILTER_VEC_DOUBLE;
+    default:                       return -1;
+  }
+}
+
+static int32_t filterVecOp(uint8_t optr, int8_t rfunc) {
+  if (optr == TSDB_RELATION_ISNULL) return FILTER_VEC_ISNULL;
+  if (optr == TSDB_RELATION_NOTNULL) return FILTER_VEC_NOTNULL;
+
+  // as in gRangeCompare
+  switch (rfunc) {
+    case 0: return FILTER_VEC_EE;
+    case 1: return FILTER_VEC_EI;
+    case 2: return FILTER_VEC_IE;
+    case 3: return FILTER_VEC_II;
+    case 4: return FILTER_VEC_GT;
+    case 5: return FILTER_VEC_GE;
+    case 6: return FILTER_VEC_LT;
+    case 7: return FILTER_VEC_LE;
+    default: break;
+  }
+
+  if (optr == TSDB_RELATION_EQUAL) return FILTER_VEC_EQ;
+  if (optr == TSDB_RELATION_NOT_EQUAL) return FILTER_VEC_NE;
+
+  return -1;
+}
+
+static bool filterVecIsNan(int32_t type, const void *val) {
+  if (type == TSDB_DATA_TYPE_FLOAT) return isnan(GET_FLOAT_VAL(val));
+  if (type == TSDB_DATA_TYPE_DOUBLE) return isnan(GET_DOUBLE_VAL(val));
+  return false;
+}
+
+filter_vec_func filterGetVecFunc(SFilterComUnit *cunit) {
+  int32_t level = filterVecLevel();
+  int32_t vtype = filterVecType(cunit->dataType);
+  int32_t op = filterVecOp(cunit->optr, cunit->rfunc);
+
+  if (level == FILTER_VEC_OFF || vtype < 0 || op < 0) return NULL;
+  if (cunit->dataSize != tDataTypes[cunit->dataType].bytes) return NULL;
+
+  if (op != FILTER_VEC_ISNULL && op != FILTER_VEC_NOTNULL) {
+    // a NaN value is left to the compare functions
+    if (cunit->valData == NULL || cunit->valData2 == NULL) return NULL;
+    if (filterVecIsNan(cunit->dataType, cunit->valData) || filterVecIsNan(cunit->dataType, cunit->valData2)) {
+      return NULL;
+    }
+  }
+
+  return filterVecKernels[level - FILTER_VEC_SCALAR][vtype][op];
+}
@@ -592,7 +592,7 @@ SArray* createExecOperatorPlan(SQueryAttr* pQueryAttr) {
       int32_t orderColId = pQueryAttr->order.orderColId;
 
       if (pQueryAttr->vgId == 0 && orderColId != INT32_MIN) {
-        op = OP_Order;
+        op = (getTopNRows(pQueryAttr) > 0)? OP_TopN:OP_Order;
         taosArrayPush(plan, &op);
       }
     }
@@ -666,7 +666,11 @@ SArray* createExecOperatorPlan(SQueryAttr* pQueryAttr) {
     // outer query order by support
     int32_t orderColId = pQueryAttr->order.orderColId;
     if (pQueryAttr->vgId == 0 && orderColId != INT32_MIN) {
-      op = OP_Order;
+      op = (getTopNRows(pQueryAttr) > 0)? OP_TopN:OP_Order;
+      taosArrayPush(plan, &op);
+    } else if (pQueryAttr->vgId != 0 && pQueryAttr->stableQuery && getTopNRows(pQueryAttr) > 0) {
+      // the vnode only keeps the first vgroupLimit rows, they are sorted again in the global merge
+      op = OP_TopN;
       taosArrayPush(plan, &op);
     }
   }
@@ -679,6 +683,28 @@ SArray* createExecOperatorPlan(SQueryAttr* pQueryAttr) {
   return plan;
 }
 
+/*
+ * The number of rows to keep instead of sorting all rows of an order by + limit query, or -1 if all rows are needed.
+ * The limit of an ordered projection query on super table is applied after the results of all vgroups are merged,
+ * each vgroup returns at most vgroupLimit rows, see validateLimitNode. A grouped query is not limited, since the
+ * projection operator reports a new group both with the last block of a group and the first block of the next one,
+ * so the rows of a group can not be told apart in the top-N operator.
+ */
+int32_t getTopNRows(SQueryAttr* pQueryAttr) {
+  int64_t rows = -1;
+
+  if (pQueryAttr->stableQuery) {
+    bool grouped = (pQueryAttr->pGroupbyExpr != NULL && pQueryAttr->pGroupbyExpr->numOfGroupCols > 0);
+    if (!grouped && pQueryAttr->order.orderColId == PRIMARYKEY_TIMESTAMP_COL_INDEX) {
+      rows = pQueryAttr->prjInfo.vgroupLimit;
+    }
+  } else if (pQueryAttr->limit.limit > 0) {
+    rows = pQueryAttr->limit.limit + pQueryAttr->limit.offset;
+  }
+
+  return (rows > 0 && rows <= INT32_MAX)? (int32_t)rows:-1;
+}
+
 SArray* createGlobalMergePlan(SQueryAttr* pQueryAttr) {
   SArray* plan = taosArrayInit(4, sizeof(int32_t));
 
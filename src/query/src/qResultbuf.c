@@ -446,6 +446,36 @@ void destroyResultBuf(SDiskbasedResultBuf* pResultBuf) {
   tfree(pResultBuf);
 }
 
+void resetResultBuf(SDiskbasedResultBuf* pResultBuf) {
+  SArray** p = taosHashIterate(pResultBuf->groupSet, NULL);
+  while(p) {
+    size_t n = taosArrayGetSize(*p);
+    for(int32_t i = 0; i < n; ++i) {
+      SPageInfo* pi = taosArrayGetP(*p, i);
+      tfree(pi->pData);
+      tfree(pi);
+    }
+
+    taosArrayDestroy(p);
+    p = taosHashIterate(pResultBuf->groupSet, p);
+  }
+
+  taosHashClear(pResultBuf->groupSet);
+  taosHashClear(pResultBuf->all);
+  tdListEmpty(pResultBuf->lruList);
+
+  if (pResultBuf->pFree != NULL) {
+    taosArrayClear(pResultBuf->pFree);
+  }
+
+  // the disk file is kept, and the pages flushed later on overwrite it from the beginning
+  pResultBuf->numOfPages   = 0;
+  pResultBuf->totalBufSize = 0;
+  pResultBuf->allocateId   = -1;
+  pResultBuf->nextPos      = 0;
+  pResultBuf->fileSize     = 0;
+}
+
 SPageInfo* getLastPageInfo(SIDList pList) {
   size_t size = taosArrayGetSize(pList);
   return (SPageInfo*) taosArrayGetP(pList, size - 1);
@@ -35,6 +35,9 @@ typedef struct SQueryMgmt {
   bool            closed;
 } SQueryMgmt;
 
+static void *queryWorkers = NULL;  // scheduler of the workers shared by the queries of all vnodes
+static int32_t numOfQueryWorkers = 0;
+
 static void queryMgmtKillQueryFn(void* handle, void* param1) {
   void** fp = (void**)handle;
   qKillQuery(*fp);
@@ -568,6 +571,40 @@ void qCleanupQueryMgmt(void* pQMgmt) {
   qDebug("vgId:%d, queryMgmt cleanup completed", vgId);
 }
 
+int32_t qInitQueryWorkers() {
+  if (tsNumOfQueryWorkers <= 1) {
+    return 0;
+  }
+
+  queryWorkers = taosInitScheduler(tsNumOfQueryWorkers * 16, tsNumOfQueryWorkers, "qWorker");
+  if (queryWorkers == NULL) {
+    qWarn("failed to create query workers, tables are scanned in the query threads");
+  } else {
+    numOfQueryWorkers = tsNumOfQueryWorkers;
+  }
+
+  return 0;
+}
+
+void qCleanupQueryWorkers() {
+  if (queryWorkers != NULL) {
+    taosCleanUpScheduler(queryWorkers);
+    queryWorkers = NULL;
+    numOfQueryWorkers = 0;
+  }
+}
+
+int32_t qQueryWorkers() { return numOfQueryWorkers; }
+
+void qScheduleQueryWork(void (*fp)(SSchedMsg *), void *ahandle, void *thandle) {
+  SSchedMsg msg = {0};
+
+  msg.fp = fp;
+  msg.ahandle = ahandle;
+  msg.thandle = thandle;
+  taosScheduleTask(queryWorkers, &msg);
+}
+
 void** qRegisterQInfo(void* pMgmt, uint64_t qId, void *qInfo) {
   if (pMgmt == NULL) {
     terrno = TSDB_CODE_VND_INVALID_VGROUP_ID;
@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Benchmark of the aggregate functions of qAggMain.h. For each type, a block of random values with 1% nulls is
+// aggregated repeatedly by the functions of the SQL functions with the kernels off, checking the rows one by one, and
+// with the kernels of every level the CPU supports, the rows aggregated per second are reported.
+//
+// usage: aggBench [rows per block] [seconds per case]
+
+#include "os.h"
+#include "qAggMain.h"
+#include "queryLog.h"
+#include "taosdef.h"
+#include "tbench.h"
+#include "ttype.h"
+
+typedef struct {
+  SQLFunctionCtx      ctx;
+  SResultRowCellInfo *pResInfo;
+  char                output[16];
+} SBenchFunc;
+
+static const int16_t benchFuncs[] = {TSDB_FUNC_SUM, TSDB_FUNC_MIN, TSDB_FUNC_MAX, TSDB_FUNC_STDDEV};
+static const char   *funcNames[] = {"sum", "min", "max", "stddev"};
+static const char *levelNames[] = {"row", "scalar", "avx2", "avx512"};
+static const int   benchTypes[] = {TSDB_DATA_TYPE_TINYINT, TSDB_DATA_TYPE_SMALLINT, TSDB_DATA_TYPE_INT,
+                                 TSDB_DATA_TYPE_BIGINT,  TSDB_DATA_TYPE_FLOAT,    TSDB_DATA_TYPE_DOUBLE};
+
+static void benchGenerate(int type, char *data, int rows) {
+  int bytes = tDataTypes[type].bytes;
+
+  for (int i = 0; i < rows; i++) {
+    char *p = data + bytes * i;
+    int   v = (int)(benchRand() % 100);
+
+    if (benchRand() % 100 == 0) {
+      setNull(p, type, bytes);
+      continue;
+    }
+    switch (type) {
+      case TSDB_DATA_TYPE_TINYINT:  *(int8_t *)p = (int8_t)(v - 50); break;
+      case TSDB_DATA_TYPE_SMALLINT: *(int16_t *)p = (int16_t)(v * 100); break;
+      case TSDB_DATA_TYPE_INT:      *(int32_t *)p = v * 10000; break;
+      case TSDB_DATA_TYPE_BIGINT:   *(int64_t *)p = (int64_t)v * 1000000000L; break;
+      case TSDB_DATA_TYPE_FLOAT:    *(float *)p = (float)v / 3; break;
+      case TSDB_DATA_TYPE_DOUBLE:   *(double *)p = (double)v / 3; break;
+      default: break;
+    }
+  }
+}
+
+static int benchInit(SBenchFunc *pFunc, int16_t functionId, int type, char *data, int rows) {
+  int16_t outputType = 0;
+  int32_t outputBytes = 0;
+  int32_t interBytes = 0;
+
+  if (getResultDataInfo(type, tDataTypes[type].bytes, functionId, 0, &outputType, &outputBytes, &interBytes, 0, false,
+                        NULL) != TSDB_CODE_SUCCESS) {
+    return -1;
+  }
+
+  memset(pFunc, 0, sizeof(SBenchFunc));
+  pFunc->pResInfo = calloc(1, sizeof(SResultRowCellInfo) + interBytes);
+  pFunc->ctx.functionId = functionId;
+  pFunc->ctx.order = TSDB_ORDER_ASC;
+  pFunc->ctx.inputType = type;
+  pFunc->ctx.inputBytes = tDataTypes[type].bytes;
+  pFunc->ctx.outputType = outputType;
+  pFunc->ctx.outputBytes = outputBytes;
+  pFunc->ctx.interBufBytes = interBytes;
+  pFunc->ctx.pOutput = pFunc->output;
+  pFunc->ctx.resultInfo = pFunc->pResInfo;
+  pFunc->ctx.pInput = data;
+  pFunc->ctx.size = rows;
+  return 0;
+}
+
+// the block is aggregated as by a table scan, twice for stddev
+static void benchRun(void *param) {
+  SBenchFunc *    pFunc = param;
+  SQLFunctionCtx *pCtx = &pFunc->ctx;
+  int16_t         functionId = pCtx->functionId;
+
+  memset(pFunc->output, 0, sizeof(pFunc->output));
+  aAggs[functionId].init(pCtx, pFunc->pResInfo);
+
+  pCtx->currentStage = MASTER_SCAN;
+  pCtx->hasNull = true;
+  aAggs[functionId].xFunction(pCtx);
+  if (functionId == TSDB_FUNC_STDDEV) {
+    pCtx->currentStage = REPEAT_SCAN;
+    aAggs[functionId].xFunction(pCtx);
+  }
+
+  aAggs[functionId].xFinalize(pCtx);
+}
+
+int main(int argc, char *argv[]) {
+  SBenchArgs args;
+  if (benchParseArgs(argc, argv, &args) != 0) {
+    return 1;
+  }
+  int rows = args.rows;
+
+  qDebugFlag = 0;
+
+  char *data = malloc(rows * sizeof(int64_t));
+  int   maxLevel = aggSetVecLevel(AGG_VEC_AVX512);
+
+  printf("%-8s %-10s %8s", "func", "type", "rows");
+  benchPrintLevels(levelNames, AGG_VEC_OFF, maxLevel, "Mrows/s");
+
+  for (int t = 0; t < tListLen(benchTypes); t++) {
+    int type = benchTypes[t];
+
+    benchGenerate(type, data, rows);
+
+    for (int f = 0; f < tListLen(benchFuncs); f++) {
+      SBenchFunc func;
+      char       expect[16] = {0};
+
+      if (benchInit(&func, benchFuncs[f], type, data, rows) != 0) {
+        printf("%s of %s is not supported\n", funcNames[f], tDataTypes[type].name);
+        return 1;
+      }
+
+      printf("%-8s %-10s %8d", funcNames[f], tDataTypes[type].name, rows);
+      for (int level = AGG_VEC_OFF; level <= maxLevel; level++) {
+        aggSetVecLevel(level);
+        double rate = benchLoop(benchRun, &func, args.seconds);
+
+        // the kernels give the same results as the rows checked one by one
+        if (level == AGG_VEC_OFF) {
+          memcpy(expect, func.output, sizeof(expect));
+        } else if (memcmp(expect, func.output, sizeof(expect)) != 0) {
+          printf("\n%s of %s is not the same with %s\n", funcNames[f], tDataTypes[type].name, levelNames[level]);
+          return 1;
+        }
+        printf(" %15.1f", rows * rate);
+      }
+      printf("\n");
+
+      free(func.pResInfo);
+    }
+  }
+
+  free(data);
+  return 0;
+}
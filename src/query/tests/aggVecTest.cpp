@@ -0,0 +1,239 @@
+#include <gtest/gtest.h>
+#include <math.h>
+#include <iostream>
+
+#include "taos.h"
+#include "taosdef.h"
+
+#include "qAggMain.h"
+#include "ttype.h"
+
+#pragma GCC diagnostic ignored "-Wunused-function"
+#pragma GCC diagnostic ignored "-Wunused-variable"
+
+namespace {
+
+const int32_t rows = 1003;
+
+const int32_t types[] = {TSDB_DATA_TYPE_TINYINT,   TSDB_DATA_TYPE_SMALLINT, TSDB_DATA_TYPE_INT,
+                         TSDB_DATA_TYPE_BIGINT,    TSDB_DATA_TYPE_UTINYINT, TSDB_DATA_TYPE_USMALLINT,
+                         TSDB_DATA_TYPE_UINT,      TSDB_DATA_TYPE_UBIGINT,  TSDB_DATA_TYPE_FLOAT,
+                         TSDB_DATA_TYPE_DOUBLE,    TSDB_DATA_TYPE_TIMESTAMP};
+
+// values spread over the range of the small types, one in ten null if nulls are generated
+void genData(int32_t type, char *data, bool nulls) {
+  for (int32_t i = 0; i < rows; ++i) {
+    char *p = data + tDataTypes[type].bytes * i;
+    int   v = rand() % 250;
+
+    if (nulls && rand() % 10 == 0) {
+      setNull(p, type, tDataTypes[type].bytes);
+      continue;
+    }
+
+    switch (type) {
+      case TSDB_DATA_TYPE_TINYINT:   *(int8_t *)p = v - 125; break;
+      case TSDB_DATA_TYPE_SMALLINT:  *(int16_t *)p = (v - 125) * 200; break;
+      case TSDB_DATA_TYPE_INT:       *(int32_t *)p = (v - 125) * 10000000; break;
+      case TSDB_DATA_TYPE_BIGINT:
+      case TSDB_DATA_TYPE_TIMESTAMP: *(int64_t *)p = (int64_t)(v - 125) * 1000000000000L; break;
+      case TSDB_DATA_TYPE_UTINYINT:  *(uint8_t *)p = v; break;
+      case TSDB_DATA_TYPE_USMALLINT: *(uint16_t *)p = v * 200; break;
+      case TSDB_DATA_TYPE_UINT:      *(uint32_t *)p = v * 10000000u; break;
+      case TSDB_DATA_TYPE_UBIGINT:   *(uint64_t *)p = (uint64_t)v * 1000000000000UL; break;
+      case TSDB_DATA_TYPE_FLOAT:     *(float *)p = (float)(v - 125) / 7; break;
+      case TSDB_DATA_TYPE_DOUBLE:    *(double *)p = (double)(v - 125) / 7; break;
+      default: break;
+    }
+  }
+}
+
+const int32_t blockRows = 256;
+
+const int16_t functions[] = {TSDB_FUNC_SUM, TSDB_FUNC_AVG,    TSDB_FUNC_MIN,
+                             TSDB_FUNC_MAX, TSDB_FUNC_STDDEV, TSDB_FUNC_SPREAD};
+
+// the output of a function, and whether a row is output with the tag selected together
+struct SFuncRes {
+  char    output[16];
+  bool    hasResult;
+  int32_t tag;
+};
+
+// run the function on the column in blocks of blockRows rows like a table scan, stddev scans the blocks twice
+void runFunction(int16_t functionId, int32_t type, char *data, bool hasNull, bool withTag, SFuncRes *pRes) {
+  int32_t bytes = tDataTypes[type].bytes;
+  int16_t outputType = 0;
+  int32_t outputBytes = 0;
+  int32_t interBytes = 0;
+  ASSERT_EQ(getResultDataInfo(type, bytes, functionId, 0, &outputType, &outputBytes, &interBytes, 0, false, NULL),
+            TSDB_CODE_SUCCESS);
+  ASSERT_LE(outputBytes, (int32_t)sizeof(pRes->output));
+
+  memset(pRes, 0, sizeof(SFuncRes));
+  SResultRowCellInfo *pResInfo = (SResultRowCellInfo *)calloc(1, sizeof(SResultRowCellInfo) + interBytes);
+  int64_t            *ts = (int64_t *)malloc(rows * sizeof(int64_t));
+  for (int32_t i = 0; i < rows; ++i) {
+    ts[i] = 1600000000000L + i;
+  }
+
+  // a tag selected with min or max is updated with the bound, which takes the row loop
+  SQLFunctionCtx  tagCtx = {0};
+  SQLFunctionCtx *pTagCtx = &tagCtx;
+  SResultRowCellInfo tagResInfo = {0};
+  tagCtx.functionId = TSDB_FUNC_TAG;
+  tagCtx.outputType = TSDB_DATA_TYPE_INT;
+  tagCtx.outputBytes = sizeof(int32_t);
+  tagCtx.pOutput = (char *)&pRes->tag;
+  tagCtx.resultInfo = &tagResInfo;
+  tagCtx.tag.nType = TSDB_DATA_TYPE_INT;
+  tagCtx.tag.i64 = 7;
+
+  SQLFunctionCtx ctx = {0};
+  ctx.functionId = functionId;
+  ctx.order = TSDB_ORDER_ASC;
+  ctx.inputType = type;
+  ctx.inputBytes = bytes;
+  ctx.outputType = outputType;
+  ctx.outputBytes = outputBytes;
+  ctx.interBufBytes = interBytes;
+  ctx.pOutput = pRes->output;
+  ctx.resultInfo = pResInfo;
+  if (withTag) {
+    ctx.tagInfo.numOfTagCols = 1;
+    ctx.tagInfo.pTagCtxList = &pTagCtx;
+  }
+
+  aAggs[functionId].init(&ctx, pResInfo);
+  for (int32_t stage = 0; stage < ((functionId == TSDB_FUNC_STDDEV) ? 2 : 1); ++stage) {
+    ctx.currentStage = (stage == 0) ? MASTER_SCAN : REPEAT_SCAN;
+    for (int32_t start = 0; start < rows; start += blockRows) {
+      ctx.pInput = data + bytes * start;
+      ctx.size = (rows - start < blockRows) ? rows - start : blockRows;
+      ctx.hasNull = hasNull;
+      ctx.ptsList = ts + start;
+      aAggs[functionId].xFunction(&ctx);
+    }
+  }
+  pRes->hasResult = (pResInfo->hasResult == DATA_SET_FLAG);
+  aAggs[functionId].xFinalize(&ctx);
+
+  free(ts);
+  free(pResInfo);
+}
+
+// the functions give the same results with the kernels of each level as row by row, the floats added in the same order
+void checkFunctions(int32_t type, char *data, bool hasNull) {
+  for (int32_t f = 0; f < (int32_t)tListLen(functions); ++f) {
+    SFuncRes expect;
+    ASSERT_EQ(aggSetVecLevel(AGG_VEC_OFF), AGG_VEC_OFF);
+    runFunction(functions[f], type, data, hasNull, false, &expect);
+
+    for (int32_t level = AGG_VEC_SCALAR; level <= AGG_VEC_AVX512; ++level) {
+      if (aggSetVecLevel(level) != level) break;
+
+      SFuncRes res;
+      runFunction(functions[f], type, data, hasNull, false, &res);
+      ASSERT_EQ(expect.hasResult, res.hasResult) << "function " << functions[f] << " type " << type << " level " << level;
+      ASSERT_EQ(0, memcmp(expect.output, res.output, sizeof(res.output)))
+          << "function " << functions[f] << " type " << type << " level " << level;
+    }
+  }
+}
+
+}  // namespace
+
+TEST(aggVecTest, functions) {
+  int32_t level = aggVecLevel();
+  char   *data = (char *)malloc(rows * sizeof(int64_t));
+
+  for (int32_t t = 0; t < (int32_t)tListLen(types); ++t) {
+    if (types[t] == TSDB_DATA_TYPE_TIMESTAMP) continue;
+
+    genData(types[t], data, false);
+    checkFunctions(types[t], data, false);
+
+    genData(types[t], data, true);
+    checkFunctions(types[t], data, true);
+  }
+
+  free(data);
+  aggSetVecLevel(level);
+}
+
+// the avg of 64 bit integers rounded as they are added to the double is the same at every level
+TEST(aggVecTest, bigintAvg) {
+  int32_t level = aggVecLevel();
+  int64_t data[rows];
+
+  for (int32_t i = 0; i < rows; ++i) {
+    data[i] = (int64_t)(i % 17 - 8) * 1000000000000000007L + i * 3;
+  }
+
+  SFuncRes expect;
+  aggSetVecLevel(AGG_VEC_OFF);
+  runFunction(TSDB_FUNC_AVG, TSDB_DATA_TYPE_BIGINT, (char *)data, false, false, &expect);
+
+  for (int32_t l = AGG_VEC_SCALAR; l <= AGG_VEC_AVX512; ++l) {
+    if (aggSetVecLevel(l) != l) break;
+
+    SFuncRes res;
+    runFunction(TSDB_FUNC_AVG, TSDB_DATA_TYPE_BIGINT, (char *)data, false, false, &res);
+    ASSERT_EQ(*(double *)expect.output, *(double *)res.output) << "level " << l;
+  }
+
+  aggSetVecLevel(level);
+}
+
+// the max of a column of zeros is 0, the start of max of an unsigned column, it is output with or without a tag
+TEST(aggVecTest, minMaxCount) {
+  int32_t  level = aggVecLevel();
+  uint32_t data[rows] = {0};
+
+  for (int32_t l = AGG_VEC_OFF; l <= AGG_VEC_AVX512; ++l) {
+    if (aggSetVecLevel(l) != l) break;
+
+    for (int32_t withTag = 0; withTag < 2; ++withTag) {
+      SFuncRes res;
+      runFunction(TSDB_FUNC_MAX, TSDB_DATA_TYPE_UINT, (char *)data, true, withTag, &res);
+      ASSERT_TRUE(res.hasResult) << "level " << l << " tag " << withTag;
+      ASSERT_EQ(*(uint32_t *)res.output, 0u);
+    }
+  }
+
+  aggSetVecLevel(level);
+}
+
+TEST(aggVecTest, nullsAndNan) {
+  int32_t level = aggVecLevel();
+  double  data[rows];
+
+  for (int32_t i = 0; i < rows; ++i) {
+    setNull((char *)&data[i], TSDB_DATA_TYPE_DOUBLE, sizeof(double));
+  }
+
+  for (int32_t l = AGG_VEC_SCALAR; l <= AGG_VEC_AVX512; ++l) {
+    if (aggSetVecLevel(l) != l) break;
+
+    const SAggVecKernels *pKernels = aggGetVecKernels(TSDB_DATA_TYPE_DOUBLE);
+
+    // all null, the bounds are left as they are
+    double min = 1, max = 2, sum = 0;
+    ASSERT_EQ(pKernels->minmax(data, rows, true, &min, &max), 0);
+    ASSERT_EQ(min, 1);
+    ASSERT_EQ(max, 2);
+    ASSERT_EQ(pKernels->sum(data, rows, true, &sum), 0);
+    ASSERT_EQ(sum, 0);
+
+    // a NaN, which is not the null value, is left to the caller
+    data[rows / 2] = NAN;
+    ASSERT_EQ(pKernels->minmax(data, rows, true, &min, &max), -1);
+    setNull((char *)&data[rows / 2], TSDB_DATA_TYPE_DOUBLE, sizeof(double));
+  }
+
+  ASSERT_TRUE(aggSetVecLevel(AGG_VEC_OFF) == AGG_VEC_OFF);
+  ASSERT_TRUE(aggGetVecKernels(TSDB_DATA_TYPE_INT) == NULL);
+  ASSERT_TRUE(aggGetVecKernels(TSDB_DATA_TYPE_BINARY) == NULL);
+
+  aggSetVecLevel(level);
+}
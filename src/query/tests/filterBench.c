@@ -0,0 +1,236 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Benchmark of the filters of qFilter.h. For each predicate, a block of random rows with 1% nulls is filtered
+// repeatedly row by row and with the kernels of every level the CPU supports, the rows filtered per second are
+// reported.
+//
+// usage: filterBench [rows per block] [seconds per case]
+
+#include "os.h"
+#include "qFilter.h"
+#include "queryLog.h"
+#include "taosdef.h"
+#include "tbench.h"
+#include "tvariant.h"
+
+enum { BENCH_COL_TS = 1, BENCH_COL_INT, BENCH_COL_BIGINT, BENCH_COL_DOUBLE, BENCH_COL_FLOAT, BENCH_COLS };
+
+typedef struct {
+  const char *predicate;
+  tExprNode *(*build)();
+} SBenchCase;
+
+static void *benchData[BENCH_COLS];
+
+static bool benchNull() { return benchRand() % 100 == 0; }
+
+static void benchGenerate(int rows) {
+  int64_t *ts = malloc(rows * sizeof(int64_t));
+  int32_t *iv = malloc(rows * sizeof(int32_t));
+  int64_t *bv = malloc(rows * sizeof(int64_t));
+  double * dv = malloc(rows * sizeof(double));
+  float *  fv = malloc(rows * sizeof(float));
+
+  for (int i = 0; i < rows; i++) {
+    ts[i] = 1600000000000L + i * 1000L;
+    *(uint32_t *)(iv + i) = benchNull() ? TSDB_DATA_INT_NULL : (uint32_t)(benchRand() % 1000);
+    *(uint64_t *)(bv + i) = benchNull() ? TSDB_DATA_BIGINT_NULL : benchRand() % 16;
+    if (benchNull()) {
+      *(uint64_t *)(dv + i) = TSDB_DATA_DOUBLE_NULL;
+    } else {
+      dv[i] = (double)(benchRand() % 1000000) / 1000000;
+    }
+    if (benchNull()) {
+      *(uint32_t *)(fv + i) = TSDB_DATA_FLOAT_NULL;
+    } else {
+      fv[i] = (float)(benchRand() % 1000) - 500;
+    }
+  }
+
+  benchData[BENCH_COL_TS] = ts;
+  benchData[BENCH_COL_INT] = iv;
+  benchData[BENCH_COL_BIGINT] = bv;
+  benchData[BENCH_COL_DOUBLE] = dv;
+  benchData[BENCH_COL_FLOAT] = fv;
+}
+
+static int32_t benchGetCol(void *param, int32_t id, void **data) {
+  *data = benchData[id];
+  return TSDB_CODE_SUCCESS;
+}
+
+static tExprNode *benchCol(int16_t colId) {
+  static const int8_t types[BENCH_COLS] = {0, TSDB_DATA_TYPE_TIMESTAMP, TSDB_DATA_TYPE_INT, TSDB_DATA_TYPE_BIGINT,
+                                           TSDB_DATA_TYPE_DOUBLE, TSDB_DATA_TYPE_FLOAT};
+  tExprNode *pNode = calloc(1, sizeof(tExprNode));
+  pNode->nodeType = TSQL_NODE_COL;
+  pNode->pSchema = calloc(1, sizeof(SSchema));
+  pNode->pSchema->colId = colId;
+  pNode->pSchema->type = types[colId];
+  pNode->pSchema->bytes = tDataTypes[types[colId]].bytes;
+  snprintf(pNode->pSchema->name, sizeof(pNode->pSchema->name), "c%d", colId);
+  return pNode;
+}
+
+static tExprNode *benchInt(int64_t v) {
+  tExprNode *pNode = calloc(1, sizeof(tExprNode));
+  pNode->nodeType = TSQL_NODE_VALUE;
+  pNode->pVal = calloc(1, sizeof(tVariant));
+  pNode->pVal->nType = TSDB_DATA_TYPE_BIGINT;
+  pNode->pVal->nLen = sizeof(int64_t);
+  pNode->pVal->i64 = v;
+  return pNode;
+}
+
+static tExprNode *benchDouble(double v) {
+  tExprNode *pNode = calloc(1, sizeof(tExprNode));
+  pNode->nodeType = TSQL_NODE_VALUE;
+  pNode->pVal = calloc(1, sizeof(tVariant));
+  pNode->pVal->nType = TSDB_DATA_TYPE_DOUBLE;
+  pNode->pVal->nLen = sizeof(double);
+  pNode->pVal->dKey = v;
+  return pNode;
+}
+
+static tExprNode *benchExpr(uint8_t optr, tExprNode *pLeft, tExprNode *pRight) {
+  tExprNode *pNode = calloc(1, sizeof(tExprNode));
+  pNode->nodeType = TSQL_NODE_EXPR;
+  pNode->_node.optr = optr;
+  pNode->_node.pLeft = pLeft;
+  pNode->_node.pRight = pRight;
+  return pNode;
+}
+
+static tExprNode *benchIntGt() { return benchExpr(TSDB_RELATION_GREATER, benchCol(BENCH_COL_INT), benchInt(500)); }
+
+static tExprNode *benchIntRange() {
+  return benchExpr(TSDB_RELATION_AND,
+                   benchExpr(TSDB_RELATION_GREATER_EQUAL, benchCol(BENCH_COL_INT), benchInt(100)),
+                   benchExpr(TSDB_RELATION_LESS, benchCol(BENCH_COL_INT), benchInt(200)));
+}
+
+static tExprNode *benchBigintEq() { return benchExpr(TSDB_RELATION_EQUAL, benchCol(BENCH_COL_BIGINT), benchInt(7)); }
+
+static tExprNode *benchDoubleLt() {
+  return benchExpr(TSDB_RELATION_LESS, benchCol(BENCH_COL_DOUBLE), benchDouble(0.1));
+}
+
+static tExprNode *benchFloatNe() {
+  return benchExpr(TSDB_RELATION_NOT_EQUAL, benchCol(BENCH_COL_FLOAT), benchDouble(0));
+}
+
+static tExprNode *benchTsRange() {
+  return benchExpr(TSDB_RELATION_AND,
+                   benchExpr(TSDB_RELATION_GREATER_EQUAL, benchCol(BENCH_COL_TS), benchInt(1600000100000L)),
+                   benchExpr(TSDB_RELATION_LESS_EQUAL, benchCol(BENCH_COL_TS), benchInt(1600001000000L)));
+}
+
+static tExprNode *benchAnd() {
+  return benchExpr(TSDB_RELATION_AND, benchExpr(TSDB_RELATION_GREATER, benchCol(BENCH_COL_INT), benchInt(500)),
+                   benchExpr(TSDB_RELATION_LESS, benchCol(BENCH_COL_DOUBLE), benchDouble(0.5)));
+}
+
+static tExprNode *benchOr() {
+  return benchExpr(TSDB_RELATION_OR, benchExpr(TSDB_RELATION_GREATER, benchCol(BENCH_COL_INT), benchInt(900)),
+                   benchExpr(TSDB_RELATION_LESS, benchCol(BENCH_COL_DOUBLE), benchDouble(0.05)));
+}
+
+static tExprNode *benchNotNull() {
+  return benchExpr(TSDB_RELATION_NOTNULL, benchCol(BENCH_COL_INT), NULL);
+}
+
+static SBenchCase benchCases[] = {
+    {"int > 500", benchIntGt},
+    {"int >= 100 and int < 200", benchIntRange},
+    {"bigint = 7", benchBigintEq},
+    {"double < 0.1", benchDoubleLt},
+    {"float != 0", benchFloatNe},
+    {"ts in range", benchTsRange},
+    {"int > 500 and double < 0.5", benchAnd},
+    {"int > 900 or double < 0.05", benchOr},
+    {"int is not null", benchNotNull},
+};
+
+typedef struct {
+  SFilterInfo *pInfo;
+  int          rows;
+  int8_t *     res;
+} SBenchFilter;
+
+static const char *levelNames[] = {"row", "scalar", "avx2"};
+
+static void benchFilter(void *param) {
+  SBenchFilter *p = param;
+  memset(p->res, 0, p->rows);
+  filterExecute(p->pInfo, p->rows, &p->res, NULL, 0);
+}
+
+int main(int argc, char *argv[]) {
+  SBenchArgs args;
+  if (benchParseArgs(argc, argv, &args) != 0) {
+    return 1;
+  }
+  int rows = args.rows;
+
+  qDebugFlag = 0;
+  benchGenerate(rows);
+
+  int8_t *res = malloc(rows);
+  int8_t *expect = malloc(rows);
+  int     maxLevel = filterSetVecLevel(FILTER_VEC_AVX2);
+
+  printf("%-28s %8s %8s", "predicate", "rows", "select");
+  benchPrintLevels(levelNames, FILTER_VEC_OFF, maxLevel, "Mrows/s");
+
+  for (int c = 0; c < tListLen(benchCases); c++) {
+    SBenchCase *pCase = &benchCases[c];
+    int         selected = 0;
+
+    printf("%-28s %8d", pCase->predicate, rows);
+    for (int level = FILTER_VEC_OFF; level <= maxLevel; level++) {
+      SFilterInfo *pInfo = NULL;
+      tExprNode *  pTree = pCase->build();
+
+      filterSetVecLevel(level);
+      if (filterInitFromTree(pTree, (void **)&pInfo, 0) != TSDB_CODE_SUCCESS || pInfo == NULL) {
+        printf("\nfailed to create the filter of %s\n", pCase->predicate);
+        return 1;
+      }
+      tExprTreeDestroy(pTree, NULL);
+      filterSetColFieldData(pInfo, NULL, benchGetCol);
+
+      SBenchFilter filter = {pInfo, rows, res};
+      double       rate = benchLoop(benchFilter, &filter, args.seconds);
+
+      if (level == FILTER_VEC_OFF) {
+        memcpy(expect, res, rows);
+        for (int i = 0; i < rows; i++) selected += res[i];
+        printf(" %7.1f%%", 100.0 * selected / rows);
+      } else if (memcmp(expect, res, rows) != 0) {
+        printf("\n%s is not filtered the same with %s\n", pCase->predicate, levelNames[level]);
+        return 1;
+      }
+      printf(" %15.1f", rows * rate);
+
+      filterFreeInfo(pInfo);
+    }
+    printf("\n");
+  }
+
+  free(res);
+  free(expect);
+  return 0;
+}
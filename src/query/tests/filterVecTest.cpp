@@ -0,0 +1,190 @@
+#include <gtest/gtest.h>
+#include <iostream>
+
+#include "taos.h"
+#include "taosdef.h"
+#include "tvariant.h"
+
+#include "qFilter.h"
+
+#pragma GCC diagnostic ignored "-Wunused-function"
+#pragma GCC diagnostic ignored "-Wunused-variable"
+
+namespace {
+
+const int32_t rows = 1000;
+
+void *colData = NULL;
+
+int32_t getColData(void *param, int32_t id, void **data) {
+  *data = colData;
+  return TSDB_CODE_SUCCESS;
+}
+
+tExprNode *colNode(int32_t type) {
+  tExprNode *pNode = (tExprNode *)calloc(1, sizeof(tExprNode));
+  pNode->nodeType = TSQL_NODE_COL;
+  pNode->pSchema = (SSchema *)calloc(1, sizeof(SSchema));
+  pNode->pSchema->colId = 1;
+  pNode->pSchema->type = type;
+  pNode->pSchema->bytes = tDataTypes[type].bytes;
+  strcpy(pNode->pSchema->name, "c1");
+  return pNode;
+}
+
+tExprNode *valNode(int32_t type, double v) {
+  tExprNode *pNode = (tExprNode *)calloc(1, sizeof(tExprNode));
+  pNode->nodeType = TSQL_NODE_VALUE;
+  pNode->pVal = (tVariant *)calloc(1, sizeof(tVariant));
+  if (IS_FLOAT_TYPE(type)) {
+    pNode->pVal->nType = TSDB_DATA_TYPE_DOUBLE;
+    pNode->pVal->dKey = v;
+  } else {
+    pNode->pVal->nType = TSDB_DATA_TYPE_BIGINT;
+    pNode->pVal->i64 = (int64_t)v;
+  }
+  pNode->pVal->nLen = sizeof(int64_t);
+  return pNode;
+}
+
+tExprNode *exprNode(uint8_t optr, tExprNode *pLeft, tExprNode *pRight) {
+  tExprNode *pNode = (tExprNode *)calloc(1, sizeof(tExprNode));
+  pNode->nodeType = TSQL_NODE_EXPR;
+  pNode->_node.optr = optr;
+  pNode->_node.pLeft = pLeft;
+  pNode->_node.pRight = pRight;
+  return pNode;
+}
+
+tExprNode *compNode(int32_t type, uint8_t optr, double v) {
+  if (optr == TSDB_RELATION_ISNULL || optr == TSDB_RELATION_NOTNULL) {
+    return exprNode(optr, colNode(type), NULL);
+  }
+  return exprNode(optr, colNode(type), valNode(type, v));
+}
+
+// the client turns a not equal on a column other than bool or string into less or greater, like handleNeOptr does
+tExprNode *neNode(int32_t type, double v) {
+  if (type == TSDB_DATA_TYPE_BOOL) {
+    return compNode(type, TSDB_RELATION_NOT_EQUAL, v);
+  }
+  return exprNode(TSDB_RELATION_OR, compNode(type, TSDB_RELATION_LESS, v), compNode(type, TSDB_RELATION_GREATER, v));
+}
+
+// values 0 to 9, with nulls and for floats values within the tolerance of the compared ones
+void genData(int32_t type, char *data) {
+  for (int32_t i = 0; i < rows; ++i) {
+    char *p = data + tDataTypes[type].bytes * i;
+    int   v = rand() % 10;
+
+    if (rand() % 10 == 0) {
+      setNull(p, type, tDataTypes[type].bytes);
+      continue;
+    }
+
+    switch (type) {
+      case TSDB_DATA_TYPE_BOOL:      *(int8_t *)p = v % 2; break;
+      case TSDB_DATA_TYPE_TINYINT:   *(int8_t *)p = v - 5; break;
+      case TSDB_DATA_TYPE_SMALLINT:  *(int16_t *)p = v - 5; break;
+      case TSDB_DATA_TYPE_INT:       *(int32_t *)p = v - 5; break;
+      case TSDB_DATA_TYPE_BIGINT:
+      case TSDB_DATA_TYPE_TIMESTAMP: *(int64_t *)p = v - 5; break;
+      case TSDB_DATA_TYPE_UTINYINT:  *(uint8_t *)p = v; break;
+      case TSDB_DATA_TYPE_USMALLINT: *(uint16_t *)p = v; break;
+      case TSDB_DATA_TYPE_UINT:      *(uint32_t *)p = v; break;
+      case TSDB_DATA_TYPE_UBIGINT:   *(uint64_t *)p = v; break;
+      case TSDB_DATA_TYPE_FLOAT:     *(float *)p = (float)(v - 5) + ((rand() % 3) - 1) * 1e-7f; break;
+      case TSDB_DATA_TYPE_DOUBLE:    *(double *)p = (double)(v - 5) + ((rand() % 3) - 1) * 1e-7; break;
+      default: break;
+    }
+  }
+}
+
+// filter the column with the kernels off and at each level, the results must be the same
+void checkFilter(int32_t type, tExprNode *(*build)(int32_t type)) {
+  int8_t expect[rows];
+  int8_t res[rows];
+
+  for (int32_t level = FILTER_VEC_OFF; level <= FILTER_VEC_AVX2; ++level) {
+    void      *pInfo = NULL;
+    tExprNode *pTree = build(type);
+
+    if (filterSetVecLevel(level) != level) break;
+
+    ASSERT_EQ(filterInitFromTree(pTree, &pInfo, 0), TSDB_CODE_SUCCESS);
+    tExprTreeDestroy(pTree, NULL);
+    if (pInfo == NULL) {
+      // the filter turned out to match all rows or none
+      break;
+    }
+    filterSetColFieldData((SFilterInfo *)pInfo, NULL, getColData);
+
+    int8_t *p = res;
+    memset(res, 0, sizeof(res));
+    bool all = filterExecute((SFilterInfo *)pInfo, rows, &p, NULL, 0);
+
+    if (level == FILTER_VEC_OFF) {
+      memcpy(expect, res, sizeof(res));
+    } else {
+      for (int32_t i = 0; i < rows; ++i) {
+        ASSERT_EQ(expect[i] != 0, res[i] != 0) << "type " << type << " level " << level << " row " << i;
+      }
+    }
+    ASSERT_EQ(all, memchr(res, 0, rows) == NULL);
+
+    filterFreeInfo((SFilterInfo *)pInfo);
+  }
+}
+
+const uint8_t optrs[] = {TSDB_RELATION_LESS,         TSDB_RELATION_LESS_EQUAL, TSDB_RELATION_GREATER,
+                         TSDB_RELATION_GREATER_EQUAL, TSDB_RELATION_EQUAL,      TSDB_RELATION_NOT_EQUAL,
+                         TSDB_RELATION_ISNULL,        TSDB_RELATION_NOTNULL};
+int32_t       curOptr = 0;
+
+tExprNode *buildComp(int32_t type) {
+  if (optrs[curOptr] == TSDB_RELATION_NOT_EQUAL) {
+    return neNode(type, 1);
+  }
+  return compNode(type, optrs[curOptr], 1);
+}
+
+tExprNode *buildRange(int32_t type) {
+  return exprNode(TSDB_RELATION_AND, compNode(type, TSDB_RELATION_GREATER, -2),
+                  compNode(type, TSDB_RELATION_LESS_EQUAL, 3));
+}
+
+tExprNode *buildOr(int32_t type) {
+  return exprNode(TSDB_RELATION_OR, compNode(type, TSDB_RELATION_LESS, -3),
+                  exprNode(TSDB_RELATION_OR, compNode(type, TSDB_RELATION_EQUAL, 2),
+                           compNode(type, TSDB_RELATION_ISNULL, 0)));
+}
+
+tExprNode *buildAndOr(int32_t type) {
+  return exprNode(TSDB_RELATION_AND, buildOr(type), neNode(type, 2));
+}
+
+}  // namespace
+
+TEST(filterVecTest, kernels) {
+  const int32_t types[] = {TSDB_DATA_TYPE_BOOL,     TSDB_DATA_TYPE_TINYINT,  TSDB_DATA_TYPE_SMALLINT,
+                           TSDB_DATA_TYPE_INT,      TSDB_DATA_TYPE_BIGINT,   TSDB_DATA_TYPE_TIMESTAMP,
+                           TSDB_DATA_TYPE_UTINYINT, TSDB_DATA_TYPE_USMALLINT, TSDB_DATA_TYPE_UINT,
+                           TSDB_DATA_TYPE_UBIGINT,  TSDB_DATA_TYPE_FLOAT,    TSDB_DATA_TYPE_DOUBLE};
+
+  int32_t level = filterVecLevel();
+  colData = malloc(rows * sizeof(int64_t));
+
+  for (int32_t t = 0; t < (int32_t)tListLen(types); ++t) {
+    genData(types[t], (char *)colData);
+
+    for (curOptr = 0; curOptr < (int32_t)tListLen(optrs); ++curOptr) {
+      checkFilter(types[t], buildComp);
+    }
+    checkFilter(types[t], buildRange);
+    checkFilter(types[t], buildOr);
+    checkFilter(types[t], buildAndOr);
+  }
+
+  free(colData);
+  filterSetVecLevel(level);
+}
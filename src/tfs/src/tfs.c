@@ -155,6 +155,8 @@ void tfsGetMeta(SFSMeta *pMeta) {
   tfsUnLock();
 }
 
+int tfsNLevel() { return TFS_NLEVEL(); }
+
 /* Allocate an existing available tier level
  */
 void tfsAllocDisk(int expLevel, int *level, int *id) {
@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _TD_TSDB_BLOCK_CACHE_H_
+#define _TD_TSDB_BLOCK_CACHE_H_
+
+#define TSDB_BLOCK_CACHE_SHARDS 16
+
+// Cache of the decoded columns of the file blocks read by the queries of a repository. A block never changes once it
+// is written, so a column is identified by the file, the offset of its block in the file and its column id. A file is
+// identified by its fid, type and version, a rewritten file has a new version, and the entries of the files no longer
+// in the FS are dropped when a FS txn ends. Each shard is an LRU list under its own lock, taking its part of the budget.
+typedef struct SBlockCacheEntry SBlockCacheEntry;
+
+typedef struct {
+  pthread_mutex_t   mutex;
+  SHashObj *        pHash;  // SBlockCacheKey -> SBlockCacheEntry *
+  SBlockCacheEntry *head;   // most recently used
+  SBlockCacheEntry *tail;   // least recently used
+  int64_t           size;
+} SBlockCacheShard;
+
+typedef struct {
+  int64_t           maxSize;   // memory budget in bytes, 0 if the cache is disabled
+  int64_t           nHit;      // columns copied from the cache
+  int64_t           nMiss;     // columns read and decoded from the files
+  int64_t           nEvicted;  // columns evicted or dropped with their files
+  SBlockCacheShard *shards;
+} SBlockCache;
+
+#define TSDB_BLOCK_CACHE_ENABLED(r) ((r)->blockCache.shards != NULL)
+
+int  tsdbInitBlockCache(STsdbRepo *pRepo);
+void tsdbDestroyBlockCache(STsdbRepo *pRepo);
+bool tsdbGetCachedColData(SReadH *pReadh, SBlock *pBlock, SDataCol *pDataCol);
+void tsdbCacheColData(SReadH *pReadh, SBlock *pBlock, SDataCol *pDataCol);
+void tsdbDropStaleBlockCache(STsdbRepo *pRepo);
+
+#endif /* _TD_TSDB_BLOCK_CACHE_H_ */
@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _TD_TSDB_CODEC_H_
+#define _TD_TSDB_CODEC_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Codec of a column in a file block, saved in SBlockCol.codec. A column with a codec other than TSDB_COL_CODEC_NONE
+// is encoded by the codec only, the compression algorithm of the block does not apply to it.
+#define TSDB_COL_CODEC_NONE 0     // the compression algorithm of the block
+#define TSDB_COL_CODEC_DICT 1     // dictionary of the distinct values and an index per row, binary and nchar
+#define TSDB_COL_CODEC_FOR 2      // frame of reference and bit packing, integers
+#define TSDB_COL_CODEC_DEFLATE 3  // zlib deflate of the column data
+
+#define TSDB_COL_CODEC_ENABLED() (tsdbColumnCodec || tsdbColumnDeflateLevel > 0)
+
+/**
+ * Encode the first nRows rows of a column with the enabled codecs. The smallest encoding is written to output if it is
+ * smaller than maxLen bytes, and its codec is returned with its size in *len. TSDB_COL_CODEC_NONE is returned if no
+ * codec beats maxLen, and -1 on error.
+ */
+int tsdbEncodeColumn(SDataCol *pDataCol, int nRows, int32_t maxLen, void *output, int32_t *len, void **ppBuf);
+int tsdbDecodeColumn(SDataCol *pDataCol, int8_t codec, void *content, int32_t len, int nRows);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _TD_TSDB_CODEC_H_ */
@@ -20,6 +20,7 @@ typedef struct {
   int   minFid;
   int   midFid;
   int   maxFid;
+  int   nowFid;  // fid of the current time
   TSKEY minKey;
 } SRtn;
 
@@ -16,8 +16,11 @@
 #ifndef _TD_TSDB_COMMIT_QUEUE_H_
 #define _TD_TSDB_COMMIT_QUEUE_H_
 
-typedef enum { COMMIT_REQ, COMPACT_REQ,COMMIT_CONFIG_REQ } TSDB_REQ_T;
+typedef enum { COMMIT_REQ, COMPACT_REQ,COMMIT_CONFIG_REQ, MIGRATE_REQ } TSDB_REQ_T;
 
 int tsdbScheduleCommit(STsdbRepo *pRepo, TSDB_REQ_T req);
 
+int  tsdbCommitWorkers();
+void tsdbScheduleCommitWork(void (*fp)(SSchedMsg *), void *ahandle, void *param);
+
 #endif /* _TD_TSDB_COMMIT_QUEUE_H_ */
\ No newline at end of file
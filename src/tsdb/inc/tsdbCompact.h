@@ -19,7 +19,12 @@
 extern "C" {
 #endif
 
+enum { TSDB_NO_COMPACT, TSDB_IN_COMPACT, TSDB_WAITING_COMPACT};
+
 void *tsdbCompactImpl(STsdbRepo *pRepo);
+// Schedule a background compaction when readyToCommit is held after a commit, return true if it is scheduled and
+// owns readyToCommit from now on. It compacts one of the filesets picked and leaves the rest to the next commits.
+bool  tsdbScheduleAutoCompact(STsdbRepo *pRepo);
 
 #ifdef __cplusplus
 }
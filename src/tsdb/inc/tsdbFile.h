@@ -188,6 +188,7 @@ typedef struct {
   TFILE   f;
   int     fd;
   uint8_t state;
+  int64_t wbSize;  // bytes written back and dropped from the page cache, in memory only
 } SDFile;
 
 void  tsdbInitDFile(SDFile* pDFile, SDiskID did, int vid, int fid, uint32_t ver, TSDB_FILE_T ftype);
@@ -198,6 +199,7 @@ int   tsdbCreateDFile(SDFile* pDFile, bool updateHeader, TSDB_FILE_T ftype);
 int   tsdbUpdateDFileHeader(SDFile* pDFile);
 int   tsdbLoadDFileHeader(SDFile* pDFile, SDFInfo* pInfo);
 int   tsdbParseDFilename(const char* fname, int* vid, int* fid, TSDB_FILE_T* ftype, uint32_t* version);
+void  tsdbWriteBackDFile(SDFile* pDFile, bool force);
 
 static FORCE_INLINE void tsdbSetDFileInfo(SDFile* pDFile, SDFInfo* pInfo) { pDFile->info = *pInfo; }
 
@@ -286,6 +288,18 @@ static FORCE_INLINE int64_t tsdbReadDFile(SDFile* pDFile, void* buf, int64_t nby
   return nread;
 }
 
+// Only a hint to the kernel, so errors are ignored
+static FORCE_INLINE void tsdbReadAheadDFile(SDFile* pDFile, int64_t offset, int64_t nbyte) {
+  ASSERT(TSDB_FILE_OPENED(pDFile));
+  taosReadAhead(pDFile->fd, offset, nbyte);
+}
+
+// Only a hint to the kernel, so errors are ignored
+static FORCE_INLINE void tsdbDropDFileCache(SDFile* pDFile, int64_t offset, int64_t nbyte) {
+  ASSERT(TSDB_FILE_OPENED(pDFile));
+  taosDropCache(pDFile->fd, offset, nbyte);
+}
+
 static FORCE_INLINE int tsdbCopyDFile(SDFile* pSrc, SDFile* pDest) {
   if (tfscopy(TSDB_FILE_F(pSrc), TSDB_FILE_F(pDest)) < 0) {
     terrno = TAOS_SYSTEM_ERROR(errno);
@@ -346,6 +360,8 @@ int   tsdbEncodeDFileSetEx(void** buf, SDFileSet* pSet);
 void* tsdbDecodeDFileSetEx(void* buf, SDFileSet* pSet);
 int   tsdbApplyDFileSetChange(SDFileSet* from, SDFileSet* to);
 int   tsdbCreateDFileSet(SDFileSet* pSet, bool updateHeader);
+void  tsdbWriteBackDFileSet(SDFileSet* pSet);
+void  tsdbDropDFileSetCache(SDFileSet* pSet);
 int   tsdbUpdateDFileSetHeader(SDFileSet* pSet);
 int   tsdbScanAndTryFixDFileSet(STsdbRepo *pRepo, SDFileSet* pSet);
 
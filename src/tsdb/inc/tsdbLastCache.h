@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _TD_TSDB_LAST_CACHE_H_
+#define _TD_TSDB_LAST_CACHE_H_
+
+#define TSDB_LAST_CACHE_FNAME "lastcache"
+#define TSDB_LAST_CACHE_VER 0
+
+// Accounting of the last row and last column cache (pTable->lastRow and pTable->lastCols) of a repository. When the
+// cache is bounded, tables are evicted in CLOCK order (an approximation of LRU) by the write thread and the cache is
+// saved at commit.
+typedef struct {
+  int64_t maxSize;   // memory budget in bytes, 0 if unlimited
+  int64_t size;      // bytes taken by the cached last rows and columns, only counted if bounded
+  int64_t nHit;      // tables served from the cache by last row and last queries
+  int64_t nMiss;     // tables loaded from files by last row and last queries
+  int64_t nEvicted;  // tables evicted from the cache
+  int64_t sweepSize; // size when the last sweep stopped above the low water mark, 0 if it did not
+  int32_t hand;      // clock hand over table ids
+  int8_t  evicting;
+} SLastCache;
+
+// The cache saved by the last commit, the encoded entries are indexed by table id
+typedef struct {
+  void * pBuf;
+  int    maxTables;
+  void **entries;
+} SLastCacheFile;
+
+#define TSDB_LAST_CACHE_BOUNDED(r) ((r)->lastCache.maxSize > 0)
+#define TSDB_LAST_CACHE_SAVED(r) (TSDB_LAST_CACHE_BOUNDED(r) && !CACHE_NO_LAST(REPO_CFG(r)))
+
+void tsdbInitLastCache(STsdbRepo *pRepo);
+void tsdbUpdateLastCacheSize(STsdbRepo *pRepo, STable *pTable);
+void tsdbPinLastCache(STsdbRepo *pRepo, STable *pTable);
+void tsdbUnpinLastCache(STsdbRepo *pRepo, STable *pTable);
+void tsdbTouchLastCache(STsdbRepo *pRepo, bool hit);
+void tsdbEvictLastCache(STsdbRepo *pRepo);
+int  tsdbSaveLastCache(STsdbRepo *pRepo);
+void tsdbRemoveLastCacheFile(STsdbRepo *pRepo);
+int  tsdbOpenLastCacheFile(STsdbRepo *pRepo, SLastCacheFile *pFile);
+void tsdbCloseLastCacheFile(SLastCacheFile *pFile);
+bool tsdbRestoreLastCacheEntry(STsdbRepo *pRepo, SLastCacheFile *pFile, STable *pTable, TSKEY lastKey);
+
+#endif /* _TD_TSDB_LAST_CACHE_H_ */
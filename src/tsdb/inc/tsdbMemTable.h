@@ -28,6 +28,7 @@ typedef struct {
 
 typedef struct {
   STable *           pTable;
+  STableData *       pTableData;
   SSkipListIterator *pIter;
 } SCommitIter;
 
@@ -37,6 +38,8 @@ struct STableData {
   TSKEY      keyLast;
   int64_t    numOfRows;
   SSkipList* pData;
+  SRWLatch   colsLatch;
+  SDataCols* pCols;  // rows in pData column-wise, NULL if not kept or some rows are not appended in order
   T_REF_DECLARE()
 };
 
@@ -69,8 +72,28 @@ int   tsdbAsyncCommit(STsdbRepo* pRepo);
 int   tsdbSyncCommitConfig(STsdbRepo* pRepo);
 int   tsdbLoadDataFromCache(STable* pTable, SSkipListIterator* pIter, TSKEY maxKey, int maxRowsToRead, SDataCols* pCols,
                             TKEY* filterKeys, int nFilterKeys, bool keepDup, SMergeInfo* pMergeInfo);
+int   tsdbLoadDataFromMemCols(STableData* pTableData, SSkipListIterator* pIter, TSKEY maxKey, int maxRowsToRead,
+                              SDataCols* pCols, SMergeInfo* pMergeInfo);
+void  tsdbDropMemTableCols(SMemTable* pMemTable);
 void* tsdbCommitData(STsdbRepo* pRepo);
 
+// Find the row of key in the column-wise memtable data, return -1 if not found
+static FORCE_INLINE int tsdbMemColsFindKey(SDataCols* pCols, TSKEY key) {
+  int lo = 0, hi = pCols->numOfRows - 1;
+  while (lo <= hi) {
+    int   mid = lo + (hi - lo) / 2;
+    TSKEY midKey = dataColsKeyAt(pCols, mid);
+    if (midKey == key) return mid;
+    if (midKey < key) {
+      lo = mid + 1;
+    } else {
+      hi = mid - 1;
+    }
+  }
+
+  return -1;
+}
+
 static FORCE_INLINE SMemRow tsdbNextIterRow(SSkipListIterator* pIter) {
   if (pIter == NULL) return NULL;
 
@@ -51,6 +51,10 @@ typedef struct STable {
   bool           hasRestoreLastColumn;
   int            lastColSVersion;
   int16_t        cacheLastConfigVersion;
+  int32_t        lastCacheSize;     // bytes of lastRow and lastCols counted in the last row cache
+  int8_t         lastCacheRef;      // referenced since the clock hand passed
+  int32_t        lastCachePins;     // queries reading lastRow or lastCols, a pinned table is not evicted
+  bool           lastCacheEvicted;  // evicted from the last row cache, to be loaded from files again
   T_REF_DECLARE()
 } STable;
 
@@ -120,7 +120,7 @@ typedef struct {
 typedef struct {
   int16_t  colId;
   uint8_t  offsetH;
-  uint8_t  reserved;  // reserved field, not used
+  uint8_t  codec;     // TSDB_COL_CODEC_*, TSDB_COL_CODEC_NONE in blocks written before
   int32_t  len;
   uint32_t type : 8;
   uint32_t offset : 24;
@@ -175,6 +175,9 @@ struct SReadH {
   void *      pBuf;   // buffer
   void *      pCBuf;  // compression buffer
   void *      pExBuf;  // extra buffer
+  bool        cacheBlocks;  // look up and fill the block cache, set by queries
+  bool        dropDataCache;  // drop the blocks read from the page cache, set by commit if it replaces the data file
+  bool        dropLastCache;  // the same for the last file
 };
 
 #define TSDB_READ_REPO(rh) ((rh)->pRepo)
@@ -190,6 +193,8 @@ struct SReadH {
 #define TSDB_READ_COMP_BUF(rh) ((rh)->pCBuf)
 #define TSDB_READ_EXBUF(rh) ((rh)->pExBuf)
 
+#define TSDB_KEY_COL_OFFSET 0  // the key column is the first one after the block statis part
+
 #define TSDB_BLOCK_STATIS_SIZE(ncols, blkVer) \
   (sizeof(SBlockData) + sizeof(SBlockColV##blkVer) * (ncols) + sizeof(TSCKSUM))
 
@@ -227,6 +232,7 @@ int   tsdbLoadBlockData(SReadH *pReadh, SBlock *pBlock, SBlockInfo *pBlockInfo);
 int   tsdbLoadBlockDataCols(SReadH *pReadh, SBlock *pBlock, SBlockInfo *pBlkInfo, int16_t *colIds, int numOfColsIds);
 int   tsdbLoadBlockStatis(SReadH *pReadh, SBlock *pBlock);
 int   tsdbLoadBlockOffset(SReadH *pReadh, SBlock *pBlock);
+void  tsdbReadAheadBlock(SReadH *pReadh, SBlock *pBlock, SBlockInfo *pBlkInfo);
 int   tsdbEncodeSBlockIdx(void **buf, SBlockIdx *pIdx);
 void *tsdbDecodeSBlockIdx(void *buf, SBlockIdx *pIdx);
 void  tsdbGetBlockStatis(SReadH *pReadh, SDataStatis *pStatis, int numOfCols, SBlock *pBlock);
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _TD_TSDB_ROLLUP_H_
+#define _TD_TSDB_ROLLUP_H_
+
+#define TSDB_MAX_ROLLUP_LEVELS 4
+#define TSDB_ROLLUP_MIN_ROWS_PER_WIN 8  // a level with fewer rows in a window on average is not worth keeping
+
+// The rollup of a block is the aggregates of its rows in the time windows of each rollup level, such as every hour.
+// It is appended to the block in the .data or .last file after the columns, so pBlock->len covers it and it is moved,
+// synced and rewritten with the block, and a block without a rollup ends at its last column. The part is:
+//
+// SRollupHead | SRollupLevel[numOfLevels] | the windows of each level | TSCKSUM
+//
+// and each window is a SRollupWin followed by the SAggrBlkCol of the columns in the aggregate part of the block.
+typedef struct {
+  int32_t delimiter;  // TSDB_FILE_DELIMITER
+  int16_t numOfLevels;
+  int16_t numOfCols;  // columns in each window
+} SRollupHead;
+
+typedef struct {
+  int64_t resolution;  // in the precision of the repository
+  int32_t numOfWins;
+  char    unit;
+  char    padding[3];
+} SRollupLevel;
+
+typedef struct {
+  TSKEY   skey;   // first key in the window
+  TSKEY   ekey;   // last key in the window
+  int32_t start;  // row of the first key in the block
+  int32_t rows;
+} SRollupWin;
+
+#define TSDB_ROLLUP_WIN_SIZE(ncols) (sizeof(SRollupWin) + sizeof(SAggrBlkCol) * (ncols))
+
+typedef struct {
+  int64_t resolution;
+  char    unit;
+} SRollupLevelCfg;
+
+typedef struct {
+  int8_t          numOfLevels;
+  SRollupLevelCfg levels[TSDB_MAX_ROLLUP_LEVELS];
+} SRollupCfg;
+
+// The windows of a level in the rollup of a block, loaded by a query to return each window as a block
+typedef struct {
+  int32_t numOfCols;
+  int32_t numOfWins;
+  void *  pWins;  // in pBuf
+  void *  pBuf;
+} SBlockRollup;
+
+#define TSDB_ROLLUP_WIN(r, i) ((SRollupWin *)POINTER_SHIFT((r)->pWins, TSDB_ROLLUP_WIN_SIZE((r)->numOfCols) * (i)))
+
+void    tsdbInitRollupCfg(STsdbRepo *pRepo);
+int32_t tsdbEncodeBlockRollup(STsdbRepo *pRepo, SDataCols *pDataCols, SAggrBlkData *pAggrBlkData, int nCols,
+                              void **ppBuf, int32_t offset);
+int32_t tsdbBlockDataEnd(SBlock *pBlock, SBlockData *pBlockData);
+bool    tsdbCheckBlockRollup(void *pRollup, int32_t len, SBlock *pBlock);
+int     tsdbLoadBlockRollup(SReadH *pReadh, SBlock *pBlock, int64_t interval, SBlockRollup *pRollup);
+void    tsdbGetRollupStatis(SBlockRollup *pRollup, int idx, SDataStatis *pStatis, int numOfCols);
+void    tsdbDestroyBlockRollup(SBlockRollup *pRollup);
+
+#endif /* _TD_TSDB_ROLLUP_H_ */
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _TD_TSDB_SCAN_H_
+#define _TD_TSDB_SCAN_H_
+
+#include "os.h"
+#include "taosdef.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The scanner checks the data files of a vnode offline, without a running taosd and without the current file of the
+// vnode: the FSETs are found by the names of the files in the data directory. Every checksummed part of the files is
+// verified and every column of every block is decoded, the problems found are written to the log stream of the scan
+// handle and counted.
+typedef struct STsdbScanHandle STsdbScanHandle;
+
+typedef struct {
+  int32_t  tid;
+  uint64_t uid;
+  int32_t  nBlocks;      // super blocks
+  int32_t  nSubBlocks;   // sub-blocks of the super blocks with more than one sub-block
+  int32_t  nLastBlocks;  // super blocks in the .last file
+  int64_t  rows;
+  TSKEY    keyFirst;
+  TSKEY    keyLast;
+  int64_t  rawSize;   // bytes of the decoded columns
+  int64_t  fileSize;  // bytes of the blocks and their aggregates in the files
+} STableScanStat;
+
+STsdbScanHandle *tsdbNewScanHandle(int vid, bool tableStat);
+void             tsdbFreeScanHandle(STsdbScanHandle *pScanHandle);
+void             tsdbSetScanLogStream(STsdbScanHandle *pScanHandle, FILE *fLogStream);
+
+// All the functions below return the number of problems found, or -1 if the scan itself fails
+int tsdbSetAndOpenScanFile(STsdbScanHandle *pScanHandle, const char *dataDir, int fid);
+int tsdbScanSBlockIdx(STsdbScanHandle *pScanHandle);
+int tsdbScanSBlock(STsdbScanHandle *pScanHandle, int idx);
+int tsdbCloseScanFile(STsdbScanHandle *pScanHandle);
+int tsdbScanFGroup(STsdbScanHandle *pScanHandle, const char *dataDir, int fid);
+
+// Scan all FSETs in a vnode data directory with nThreads threads, the reports are written in the order of the FSETs
+int tsdbScanDataDir(const char *dataDir, int nThreads, bool tableStat, FILE *fLogStream);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _TD_TSDB_SCAN_H_ */
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _TD_TSDB_SUMMARY_H_
+#define _TD_TSDB_SUMMARY_H_
+
+#define TSDB_FSET_SUM_VER 0
+
+// The summary of a FSET is the union of the block aggregates of each table group (a super table or a table without
+// super table). It is written to the head file after the SBlockIdx part, so the part of a head file
+// [info.offset + info.len, info.size) is the summary, and a query can skip a FSET its filters can not match before
+// loading the SBlockIdx and SBlockInfo parts.
+typedef struct {
+  int16_t colId;
+  int8_t  type;
+  int64_t notNull;  // number of rows not NULL
+  int64_t min;      // the same layout as SAggrBlkCol
+  int64_t max;
+} SSumCol;
+
+typedef struct {
+  uint64_t uid;
+  int64_t  rows;
+  TSKEY    keyFirst;
+  TSKEY    keyLast;
+  SArray * aCol;  // SSumCol array sorted by colId, a column not in it is all NULL
+} SSumGroup;
+
+typedef struct {
+  bool      valid;    // all blocks in the FSET are summarized
+  SHashObj *pGroups;  // group uid -> SSumGroup
+} SFSetSum;
+
+int  tsdbInitFSetSum(SFSetSum *pSum);
+void tsdbDestroyFSetSum(SFSetSum *pSum);
+void tsdbResetFSetSum(SFSetSum *pSum);
+int  tsdbAddBlockToFSetSum(SFSetSum *pSum, STable *pTable, SBlock *pBlock, void *pBlockData, void *pAggrBlkData);
+int  tsdbWriteFSetSum(SDFile *pHeadf, SFSetSum *pSum, void **ppBuf);
+int  tsdbLoadFSetSum(SReadH *pReadh, SFSetSum *pSum);
+bool tsdbFSetSumMayMatch(SFSetSum *pSum, STable *pTable, void *pFilters, SDataStatis *pStatis, int16_t *colIds,
+                         int numOfCols);
+
+#endif /* _TD_TSDB_SUMMARY_H_ */
@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _TD_TSDB_TIER_H_
+#define _TD_TSDB_TIER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The reads of the filesets of a repository by the queries. A fileset read at least tsdbHotFSetReads times, each read
+// decaying by half every tsdbHotFSetHalfLife seconds, is kept on the first tier whatever its age, and a fileset on the
+// first tier nobody reads moves to the second one before its age requires. The counts are in memory only and start
+// over when the repository opens.
+typedef struct {
+  int     fid;
+  double  reads;     // decayed to lastRead
+  int64_t lastRead;  // ms
+} SFSetReads;
+
+typedef struct {
+  pthread_mutex_t mutex;
+  SArray *        aReads;  // SFSetReads ordered by fid
+  int64_t         since;   // ms, when the reads started to be counted
+} SFSetHeat;
+
+int   tsdbInitFSetHeat(STsdbRepo *pRepo);
+void  tsdbDestroyFSetHeat(STsdbRepo *pRepo);
+void  tsdbRecordFSetRead(STsdbRepo *pRepo, int fid);
+int   tsdbGetFSetTierLevel(STsdbRepo *pRepo, int fid, SRtn *pRtn);
+void *tsdbTierMigrateImpl(STsdbRepo *pRepo);
+// Schedule a background tier migration when readyToCommit is held after a commit, return true if it is scheduled and
+// owns readyToCommit from now on
+bool  tsdbScheduleTierMigrate(STsdbRepo *pRepo);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _TD_TSDB_TIER_H_ */
@@ -41,6 +41,7 @@
 #include "tarray.h"
 #include "tfs.h"
 #include "tsocket.h"
+#include "tsched.h"
 
 #include "tsdb.h"
 
@@ -62,12 +63,24 @@ extern "C" {
 #include "tsdbFS.h"
 // ReadImpl
 #include "tsdbReadImpl.h"
+// FSET summary
+#include "tsdbSummary.h"
+// Column codec
+#include "tsdbCodec.h"
+// Block rollup
+#include "tsdbRollup.h"
 // Commit
 #include "tsdbCommit.h"
 // Compact
 #include "tsdbCompact.h"
+// Tier migration
+#include "tsdbTier.h"
 // Commit Queue
 #include "tsdbCommitQueue.h"
+// Last row cache
+#include "tsdbLastCache.h"
+// Block cache
+#include "tsdbBlockCache.h"
 
 #include "tsdbRowMergeBuf.h"
 // Main definitions
@@ -81,9 +94,14 @@ struct STsdbRepo {
   pthread_mutex_t save_mutex;     // protect save config
 
   int16_t         cacheLastConfigVersion;
+  SLastCache      lastCache;
+  SBlockCache     blockCache;
+  SRollupCfg      rollupCfg;
+  SFSetHeat       fsetHeat;
 
   STsdbAppH       appH;
   STsdbStat       stat;
+  STsdbCommitStat commitStat;  // updated by the commit thread once a commit is over
   STsdbMeta*      tsdbMeta;
   STsdbBufPool*   pPool;
   SMemTable*      mem;
@@ -97,6 +115,11 @@ struct STsdbRepo {
 
   SMergeBuf       mergeBuf;  //used when update=2
   int8_t          compactState;  // compact state: inCompact/noCompact/waitingCompact?
+  bool            autoCompact;      // the compaction is scheduled in background rather than by the operator
+  bool            stopAutoCompact;  // set when the repo closes to stop a background compaction
+  int64_t         lastAutoCompact;  // ms, when a background compaction was last scheduled
+  SArray*         autoCompactFSets;  // filesets picked by a background compaction and left to the next commits
+  bool            stopTierMigrate;  // set when the repo closes to stop a background tier migration
   pthread_t*      pthread;
 };
 
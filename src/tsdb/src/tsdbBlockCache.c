@@ -0,0 +1,311 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "tglobal.h"
+#include "tsdbint.h"
+
+typedef struct {
+  int64_t  offset;  // offset of the block in the file
+  uint32_t fver;    // version of the file
+  int32_t  fid;
+  int16_t  colId;
+  int8_t   ftype;  // TSDB_FILE_DATA or TSDB_FILE_LAST
+  int8_t   reserved;
+} SBlockCacheKey;
+
+struct SBlockCacheEntry {
+  SBlockCacheKey    key;
+  SBlockCacheEntry *prev;
+  SBlockCacheEntry *next;
+  int32_t           size;       // bytes taken by the entry
+  int32_t           len;        // bytes of the column data
+  int32_t           numOfRows;  // offsets of the binary and nchar values follow the data
+  char              data[];
+};
+
+static uint32_t          tsdbGetDFileVersion(SDFile *pDFile);
+static void              tsdbInitBlockCacheKey(SBlockCacheKey *pKey, SReadH *pReadh, SBlock *pBlock, int16_t colId);
+static SBlockCacheShard *tsdbGetBlockCacheShard(SBlockCache *pCache, SBlockCacheKey *pKey);
+static void              tsdbUnlinkBlockCacheEntry(SBlockCacheShard *pShard, SBlockCacheEntry *pEntry);
+static void              tsdbLinkBlockCacheEntry(SBlockCacheShard *pShard, SBlockCacheEntry *pEntry);
+static void              tsdbRemoveBlockCacheEntry(SBlockCache *pCache, SBlockCacheShard *pShard, SBlockCacheEntry *pEntry);
+static bool              tsdbIsBlockCacheKeyLive(STsdbFS *pfs, SBlockCacheKey *pKey);
+
+int tsdbInitBlockCache(STsdbRepo *pRepo) {
+  SBlockCache *pCache = &(pRepo->blockCache);
+
+  memset(pCache, 0, sizeof(*pCache));
+  pCache->maxSize = (int64_t)tsdbBlockCacheSize * 1024 * 1024;
+  if (pCache->maxSize <= 0) return 0;
+
+  pCache->shards = (SBlockCacheShard *)calloc(TSDB_BLOCK_CACHE_SHARDS, sizeof(SBlockCacheShard));
+  if (pCache->shards == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    return -1;
+  }
+
+  for (int i = 0; i < TSDB_BLOCK_CACHE_SHARDS; i++) {
+    SBlockCacheShard *pShard = pCache->shards + i;
+
+    pthread_mutex_init(&(pShard->mutex), NULL);
+    pShard->pHash = taosHashInit(1024, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BINARY), false, HASH_NO_LOCK);
+    if (pShard->pHash == NULL) {
+      terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+      tsdbDestroyBlockCache(pRepo);
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+void tsdbDestroyBlockCache(STsdbRepo *pRepo) {
+  SBlockCache *pCache = &(pRepo->blockCache);
+
+  if (pCache->shards == NULL) return;
+
+  for (int i = 0; i < TSDB_BLOCK_CACHE_SHARDS; i++) {
+    SBlockCacheShard *pShard = pCache->shards + i;
+
+    while (pShard->head) {
+      SBlockCacheEntry *pEntry = pShard->head;
+      tsdbUnlinkBlockCacheEntry(pShard, pEntry);
+      free(pEntry);
+    }
+    taosHashCleanup(pShard->pHash);
+    pthread_mutex_destroy(&(pShard->mutex));
+  }
+
+  tfree(pCache->shards);
+}
+
+void tsdbGetBlockCacheStat(STsdbRepo *repo, STsdbBlockCacheStat *pStat) {
+  SBlockCache *pCache = &(repo->blockCache);
+
+  memset(pStat, 0, sizeof(*pStat));
+  if (!TSDB_BLOCK_CACHE_ENABLED(repo)) return;
+
+  for (int i = 0; i < TSDB_BLOCK_CACHE_SHARDS; i++) {
+    SBlockCacheShard *pShard = pCache->shards + i;
+
+    pthread_mutex_lock(&(pShard->mutex));
+    pStat->size += pShard->size;
+    pStat->entries += (int64_t)taosHashGetSize(pShard->pHash);
+    pthread_mutex_unlock(&(pShard->mutex));
+  }
+
+  pStat->maxSize = pCache->maxSize;
+  pStat->hit = atomic_load_64(&(pCache->nHit));
+  pStat->miss = atomic_load_64(&(pCache->nMiss));
+  pStat->evicted = atomic_load_64(&(pCache->nEvicted));
+}
+
+// Copy the column of the block from the cache, return false if it is not cached. A miss is only counted when the column
+// is decoded from the files, a column absent from the block is not
+bool tsdbGetCachedColData(SReadH *pReadh, SBlock *pBlock, SDataCol *pDataCol) {
+  STsdbRepo *  pRepo = TSDB_READ_REPO(pReadh);
+  SBlockCache *pCache = &(pRepo->blockCache);
+
+  if (!pReadh->cacheBlocks || !TSDB_BLOCK_CACHE_ENABLED(pRepo)) return false;
+
+  SBlockCacheKey key;
+  tsdbInitBlockCacheKey(&key, pReadh, pBlock, pDataCol->colId);
+  SBlockCacheShard *pShard = tsdbGetBlockCacheShard(pCache, &key);
+
+  pthread_mutex_lock(&(pShard->mutex));
+
+  SBlockCacheEntry **ppEntry = (SBlockCacheEntry **)taosHashGet(pShard->pHash, &key, sizeof(key));
+  if (ppEntry == NULL || tdAllocMemForCol(pDataCol, REPO_CFG(pRepo)->maxRowsPerFileBlock) < 0) {
+    pthread_mutex_unlock(&(pShard->mutex));
+    return false;
+  }
+
+  SBlockCacheEntry *pEntry = *ppEntry;
+  ASSERT(pEntry->numOfRows == pBlock->numOfRows);
+
+  memcpy(pDataCol->pData, pEntry->data, pEntry->len);
+  pDataCol->len = pEntry->len;
+  if (IS_VAR_DATA_TYPE(pDataCol->type)) {
+    memcpy(pDataCol->dataOff, pEntry->data + pEntry->len, sizeof(VarDataOffsetT) * pEntry->numOfRows);
+  }
+
+  tsdbUnlinkBlockCacheEntry(pShard, pEntry);
+  tsdbLinkBlockCacheEntry(pShard, pEntry);
+
+  pthread_mutex_unlock(&(pShard->mutex));
+
+  atomic_add_fetch_64(&(pCache->nHit), 1);
+  return true;
+}
+
+// Add the column just decoded from the block to the cache, evicting the least recently used columns beyond the budget
+void tsdbCacheColData(SReadH *pReadh, SBlock *pBlock, SDataCol *pDataCol) {
+  STsdbRepo *  pRepo = TSDB_READ_REPO(pReadh);
+  SBlockCache *pCache = &(pRepo->blockCache);
+  int64_t      shardSize = pCache->maxSize / TSDB_BLOCK_CACHE_SHARDS;
+
+  if (!pReadh->cacheBlocks || !TSDB_BLOCK_CACHE_ENABLED(pRepo)) return;
+
+  atomic_add_fetch_64(&(pCache->nMiss), 1);
+
+  int32_t offLen = IS_VAR_DATA_TYPE(pDataCol->type) ? (int32_t)sizeof(VarDataOffsetT) * pBlock->numOfRows : 0;
+  int32_t size = (int32_t)sizeof(SBlockCacheEntry) + pDataCol->len + offLen;
+  if (size > shardSize) return;
+
+  SBlockCacheEntry *pEntry = (SBlockCacheEntry *)malloc(size);
+  if (pEntry == NULL) return;
+
+  tsdbInitBlockCacheKey(&(pEntry->key), pReadh, pBlock, pDataCol->colId);
+  pEntry->prev = NULL;
+  pEntry->next = NULL;
+  pEntry->size = size;
+  pEntry->len = pDataCol->len;
+  pEntry->numOfRows = pBlock->numOfRows;
+  memcpy(pEntry->data, pDataCol->pData, pDataCol->len);
+  if (offLen > 0) {
+    memcpy(pEntry->data + pDataCol->len, pDataCol->dataOff, offLen);
+  }
+
+  SBlockCacheShard *pShard = tsdbGetBlockCacheShard(pCache, &(pEntry->key));
+
+  pthread_mutex_lock(&(pShard->mutex));
+
+  // Another query may have loaded the same column meanwhile
+  if (taosHashGet(pShard->pHash, &(pEntry->key), sizeof(pEntry->key)) != NULL) {
+    pthread_mutex_unlock(&(pShard->mutex));
+    free(pEntry);
+    return;
+  }
+
+  while (pShard->tail && pShard->size + size > shardSize) {
+    tsdbRemoveBlockCacheEntry(pCache, pShard, pShard->tail);
+  }
+
+  if (taosHashPut(pShard->pHash, &(pEntry->key), sizeof(pEntry->key), &pEntry, sizeof(pEntry)) < 0) {
+    pthread_mutex_unlock(&(pShard->mutex));
+    free(pEntry);
+    return;
+  }
+  tsdbLinkBlockCacheEntry(pShard, pEntry);
+
+  pthread_mutex_unlock(&(pShard->mutex));
+}
+
+// Drop the columns of the files removed from the FS, called when a FS txn ends
+void tsdbDropStaleBlockCache(STsdbRepo *pRepo) {
+  SBlockCache *pCache = &(pRepo->blockCache);
+  STsdbFS *    pfs = REPO_FS(pRepo);
+
+  if (!TSDB_BLOCK_CACHE_ENABLED(pRepo)) return;
+
+  tsdbRLockFS(pfs);
+  for (int i = 0; i < TSDB_BLOCK_CACHE_SHARDS; i++) {
+    SBlockCacheShard *pShard = pCache->shards + i;
+
+    pthread_mutex_lock(&(pShard->mutex));
+    SBlockCacheEntry *pEntry = pShard->head;
+    while (pEntry) {
+      SBlockCacheEntry *pNext = pEntry->next;
+      if (!tsdbIsBlockCacheKeyLive(pfs, &(pEntry->key))) {
+        tsdbRemoveBlockCacheEntry(pCache, pShard, pEntry);
+      }
+      pEntry = pNext;
+    }
+    pthread_mutex_unlock(&(pShard->mutex));
+  }
+  tsdbUnLockFS(pfs);
+}
+
+// The version in the name of a file, such as v2f1850.data-ver12, 0 if there is not
+static uint32_t tsdbGetDFileVersion(SDFile *pDFile) {
+  const char *fname = TSDB_FILE_FULL_NAME(pDFile);
+  const char *p = strrchr(fname, '-');
+
+  if (p == NULL || strncmp(p, "-ver", 4) != 0) return 0;
+  return (uint32_t)strtoul(p + 4, NULL, 10);
+}
+
+static void tsdbInitBlockCacheKey(SBlockCacheKey *pKey, SReadH *pReadh, SBlock *pBlock, int16_t colId) {
+  SDFileSet *pSet = TSDB_READ_FSET(pReadh);
+
+  memset(pKey, 0, sizeof(*pKey));
+  pKey->ftype = pBlock->last ? TSDB_FILE_LAST : TSDB_FILE_DATA;
+  pKey->offset = pBlock->offset;
+  pKey->fver = tsdbGetDFileVersion(TSDB_DFILE_IN_SET(pSet, pKey->ftype));
+  pKey->fid = pSet->fid;
+  pKey->colId = colId;
+}
+
+static SBlockCacheShard *tsdbGetBlockCacheShard(SBlockCache *pCache, SBlockCacheKey *pKey) {
+  uint64_t h = (uint64_t)pKey->offset * 31 + (uint64_t)pKey->colId;
+  return pCache->shards + (h % TSDB_BLOCK_CACHE_SHARDS);
+}
+
+static void tsdbUnlinkBlockCacheEntry(SBlockCacheShard *pShard, SBlockCacheEntry *pEntry) {
+  if (pEntry->prev) {
+    pEntry->prev->next = pEntry->next;
+  } else {
+    pShard->head = pEntry->next;
+  }
+
+  if (pEntry->next) {
+    pEntry->next->prev = pEntry->prev;
+  } else {
+    pShard->tail = pEntry->prev;
+  }
+
+  pEntry->prev = NULL;
+  pEntry->next = NULL;
+  pShard->size -= pEntry->size;
+}
+
+static void tsdbLinkBlockCacheEntry(SBlockCacheShard *pShard, SBlockCacheEntry *pEntry) {
+  pEntry->prev = NULL;
+  pEntry->next = pShard->head;
+  if (pShard->head) {
+    pShard->head->prev = pEntry;
+  } else {
+    pShard->tail = pEntry;
+  }
+  pShard->head = pEntry;
+  pShard->size += pEntry->size;
+}
+
+static void tsdbRemoveBlockCacheEntry(SBlockCache *pCache, SBlockCacheShard *pShard, SBlockCacheEntry *pEntry) {
+  tsdbUnlinkBlockCacheEntry(pShard, pEntry);
+  taosHashRemove(pShard->pHash, &(pEntry->key), sizeof(pEntry->key));
+  free(pEntry);
+  atomic_add_fetch_64(&(pCache->nEvicted), 1);
+}
+
+static bool tsdbIsBlockCacheKeyLive(STsdbFS *pfs, SBlockCacheKey *pKey) {
+  SArray *aSets = pfs->cstatus->df;
+  int     lo = 0;
+  int     hi = (int)taosArrayGetSize(aSets) - 1;
+
+  while (lo <= hi) {
+    int        mid = lo + (hi - lo) / 2;
+    SDFileSet *pSet = (SDFileSet *)taosArrayGet(aSets, mid);
+
+    if (pSet->fid == pKey->fid) {
+      return tsdbGetDFileVersion(TSDB_DFILE_IN_SET(pSet, pKey->ftype)) == pKey->fver;
+    } else if (pSet->fid < pKey->fid) {
+      lo = mid + 1;
+    } else {
+      hi = mid - 1;
+    }
+  }
+
+  return false;
+}
@@ -0,0 +1,328 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Column codecs of file blocks
+ *
+ * DICT:    | nDict (int32) | dictLen (int32) | width (uint8) | distinct values (VarData) | index of each row (width) |
+ * FOR:     | reference (int64) | width (uint8) | bit packed (value - reference) of each row |
+ * DEFLATE: | zlib stream of the column data |
+ *
+ * Integers are little endian as the rest of the file.
+ */
+
+#include "tsdbint.h"
+#include "tglobal.h"
+#include "zlib.h"
+
+#define TSDB_DICT_HEAD_SIZE (sizeof(int32_t) * 2 + sizeof(uint8_t))
+#define TSDB_FOR_HEAD_SIZE (sizeof(int64_t) + sizeof(uint8_t))
+
+static int32_t tsdbEncodeDict(SDataCol *pDataCol, int nRows, int32_t maxLen, void *output);
+static int32_t tsdbDecodeDict(SDataCol *pDataCol, void *content, int32_t len, int nRows);
+static int32_t tsdbEncodeFOR(SDataCol *pDataCol, int nRows, int32_t maxLen, void *output);
+static int32_t tsdbDecodeFOR(SDataCol *pDataCol, void *content, int32_t len, int nRows);
+static int32_t tsdbEncodeDeflate(SDataCol *pDataCol, int nRows, int32_t maxLen, void *output);
+static int32_t tsdbDecodeDeflate(SDataCol *pDataCol, void *content, int32_t len);
+static bool    tsdbIsFORType(int8_t type);
+
+int tsdbEncodeColumn(SDataCol *pDataCol, int nRows, int32_t maxLen, void *output, int32_t *len, void **ppBuf) {
+  int     codec = TSDB_COL_CODEC_NONE;
+  int32_t tlen = 0;
+
+  // each codec encodes to the buffer and the smallest one is copied to output
+  if (tsdbMakeRoom(ppBuf, maxLen) < 0) return -1;
+
+  if (tsdbColumnCodec && IS_VAR_DATA_TYPE(pDataCol->type)) {
+    tlen = tsdbEncodeDict(pDataCol, nRows, maxLen, *ppBuf);
+    if (tlen < 0) return -1;
+    if (tlen > 0) {
+      codec = TSDB_COL_CODEC_DICT;
+      maxLen = tlen;
+      memcpy(output, *ppBuf, tlen);
+    }
+  }
+
+  if (tsdbColumnCodec && tsdbIsFORType(pDataCol->type)) {
+    tlen = tsdbEncodeFOR(pDataCol, nRows, maxLen, *ppBuf);
+    if (tlen > 0) {
+      codec = TSDB_COL_CODEC_FOR;
+      maxLen = tlen;
+      memcpy(output, *ppBuf, tlen);
+    }
+  }
+
+  if (tsdbColumnDeflateLevel > 0) {
+    tlen = tsdbEncodeDeflate(pDataCol, nRows, maxLen, *ppBuf);
+    if (tlen > 0) {
+      codec = TSDB_COL_CODEC_DEFLATE;
+      maxLen = tlen;
+      memcpy(output, *ppBuf, tlen);
+    }
+  }
+
+  *len = maxLen;
+  return codec;
+}
+
+int tsdbDecodeColumn(SDataCol *pDataCol, int8_t codec, void *content, int32_t len, int nRows) {
+  switch (codec) {
+    case TSDB_COL_CODEC_DICT:
+      if (!IS_VAR_DATA_TYPE(pDataCol->type)) break;
+      return tsdbDecodeDict(pDataCol, content, len, nRows);
+    case TSDB_COL_CODEC_FOR:
+      if (!tsdbIsFORType(pDataCol->type)) break;
+      return tsdbDecodeFOR(pDataCol, content, len, nRows);
+    case TSDB_COL_CODEC_DEFLATE:
+      return tsdbDecodeDeflate(pDataCol, content, len);
+    default:
+      break;
+  }
+
+  tsdbError("invalid codec %d of column %d type %d", codec, pDataCol->colId, pDataCol->type);
+  return -1;
+}
+
+// Return the encoded size, 0 if it is not smaller than maxLen
+static int32_t tsdbEncodeDict(SDataCol *pDataCol, int nRows, int32_t maxLen, void *output) {
+  int32_t   nDict = 0;
+  int32_t   dictLen = 0;
+  SHashObj *pDict = taosHashInit(64, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BINARY), false, HASH_NO_LOCK);
+  if (pDict == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    return -1;
+  }
+
+  // the distinct values are written in the order of their first rows, the indexes are put at the end
+  char *pValues = POINTER_SHIFT(output, TSDB_DICT_HEAD_SIZE);
+  for (int i = 0; i < nRows; i++) {
+    const void *value = tdGetColDataOfRow(pDataCol, i);
+    uint32_t vlen = (uint32_t)varDataTLen(value);
+
+    if (taosHashGet(pDict, value, vlen) != NULL) continue;
+    if ((int32_t)(TSDB_DICT_HEAD_SIZE + dictLen + vlen) >= maxLen) {
+      taosHashCleanup(pDict);
+      return 0;
+    }
+    if (taosHashPut(pDict, value, vlen, &nDict, sizeof(nDict)) < 0) {
+      taosHashCleanup(pDict);
+      terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+      return -1;
+    }
+    memcpy(pValues + dictLen, value, vlen);
+    dictLen += vlen;
+    nDict++;
+  }
+
+  uint8_t width = (nDict <= UINT8_MAX + 1) ? sizeof(uint8_t) : ((nDict <= UINT16_MAX + 1) ? sizeof(uint16_t) : sizeof(uint32_t));
+  int32_t tlen = (int32_t)(TSDB_DICT_HEAD_SIZE + dictLen + width * nRows);
+  if (tlen >= maxLen) {
+    taosHashCleanup(pDict);
+    return 0;
+  }
+
+  char *pIdx = pValues + dictLen;
+  for (int i = 0; i < nRows; i++) {
+    const void *value = tdGetColDataOfRow(pDataCol, i);
+    uint32_t idx = (uint32_t)(*(int32_t *)taosHashGet(pDict, value, varDataTLen(value)));
+    memcpy(pIdx + width * i, &idx, width);
+  }
+  taosHashCleanup(pDict);
+
+  void *ptr = output;
+  taosEncodeFixedI32(&ptr, nDict);
+  taosEncodeFixedI32(&ptr, dictLen);
+  taosEncodeFixedU8(&ptr, width);
+
+  return tlen;
+}
+
+static int32_t tsdbDecodeDict(SDataCol *pDataCol, void *content, int32_t len, int nRows) {
+  int32_t nDict = 0;
+  int32_t dictLen = 0;
+  uint8_t width = 0;
+
+  if (len < (int32_t)TSDB_DICT_HEAD_SIZE) return -1;
+  void *ptr = taosDecodeFixedI32(content, &nDict);
+  ptr = taosDecodeFixedI32(ptr, &dictLen);
+  ptr = taosDecodeFixedU8(ptr, &width);
+  if (nDict <= 0 || nDict > nRows || dictLen <= 0 || (width != sizeof(uint8_t) && width != sizeof(uint16_t) &&
+                                                      width != sizeof(uint32_t)) ||
+      (int64_t)TSDB_DICT_HEAD_SIZE + dictLen + (int64_t)width * nRows != len) {
+    return -1;
+  }
+
+  // offsets of the distinct values are kept in dataOff, which is rebuilt for the rows after decoding
+  char *pValues = (char *)ptr;
+  int32_t offset = 0;
+  for (int i = 0; i < nDict; i++) {
+    if (offset + (int32_t)sizeof(VarDataLenT) > dictLen) return -1;
+    pDataCol->dataOff[i] = offset;
+    offset += (int32_t)varDataTLen(pValues + offset);
+  }
+  if (offset != dictLen) return -1;
+
+  char *  pIdx = pValues + dictLen;
+  int32_t tlen = 0;
+  for (int i = 0; i < nRows; i++) {
+    uint32_t idx = 0;
+    memcpy(&idx, pIdx + width * i, width);
+    if (idx >= (uint32_t)nDict) return -1;
+
+    void *   value = pValues + pDataCol->dataOff[idx];
+    uint32_t vlen = (uint32_t)varDataTLen(value);
+    if (tlen + (int32_t)vlen > pDataCol->spaceSize) return -1;
+    memcpy(POINTER_SHIFT(pDataCol->pData, tlen), value, vlen);
+    tlen += vlen;
+  }
+
+  return tlen;
+}
+
+static bool tsdbIsFORType(int8_t type) {
+  return IS_SIGNED_NUMERIC_TYPE(type) || IS_UNSIGNED_NUMERIC_TYPE(type) || type == TSDB_DATA_TYPE_TIMESTAMP;
+}
+
+static FORCE_INLINE uint64_t tsdbGetFORVal(int8_t type, const void *pData, int row) {
+  switch (type) {
+    case TSDB_DATA_TYPE_TINYINT:
+      return (uint64_t)(int64_t)((int8_t *)pData)[row];
+    case TSDB_DATA_TYPE_SMALLINT:
+      return (uint64_t)(int64_t)((int16_t *)pData)[row];
+    case TSDB_DATA_TYPE_INT:
+      return (uint64_t)(int64_t)((int32_t *)pData)[row];
+    case TSDB_DATA_TYPE_UTINYINT:
+      return ((uint8_t *)pData)[row];
+    case TSDB_DATA_TYPE_USMALLINT:
+      return ((uint16_t *)pData)[row];
+    case TSDB_DATA_TYPE_UINT:
+      return ((uint32_t *)pData)[row];
+    default:
+      return ((uint64_t *)pData)[row];
+  }
+}
+
+static FORCE_INLINE void tsdbSetFORVal(int8_t type, void *pData, int row, uint64_t val) {
+  switch (type) {
+    case TSDB_DATA_TYPE_TINYINT:
+    case TSDB_DATA_TYPE_UTINYINT:
+      ((uint8_t *)pData)[row] = (uint8_t)val;
+      break;
+    case TSDB_DATA_TYPE_SMALLINT:
+    case TSDB_DATA_TYPE_USMALLINT:
+      ((uint16_t *)pData)[row] = (uint16_t)val;
+      break;
+    case TSDB_DATA_TYPE_INT:
+    case TSDB_DATA_TYPE_UINT:
+      ((uint32_t *)pData)[row] = (uint32_t)val;
+      break;
+    default:
+      ((uint64_t *)pData)[row] = val;
+      break;
+  }
+}
+
+// Values of signed types are compared by flipping the sign bit, so a reference and offsets work for both
+static int32_t tsdbEncodeFOR(SDataCol *pDataCol, int nRows, int32_t maxLen, void *output) {
+  int8_t   type = pDataCol->type;
+  uint64_t flip = IS_UNSIGNED_NUMERIC_TYPE(type) ? 0 : ((uint64_t)1 << 63);
+  uint64_t min = UINT64_MAX, max = 0;
+
+  for (int i = 0; i < nRows; i++) {
+    uint64_t v = tsdbGetFORVal(type, pDataCol->pData, i) ^ flip;
+    if (v < min) min = v;
+    if (v > max) max = v;
+  }
+
+  uint64_t range = max - min;
+  uint8_t  width = (range == 0) ? 0 : (uint8_t)(64 - BUILDIN_CLZL(range));
+  int64_t  tlen = TSDB_FOR_HEAD_SIZE + ((int64_t)width * nRows + 7) / 8;
+  if (tlen >= maxLen) return 0;
+
+  void *ptr = output;
+  taosEncodeFixedU64(&ptr, min ^ flip);
+  taosEncodeFixedU8(&ptr, width);
+
+  uint8_t *pBits = (uint8_t *)ptr;
+  uint64_t acc = 0;
+  int      nbits = 0;
+  for (int i = 0; i < nRows && width > 0; i++) {
+    uint64_t delta = (tsdbGetFORVal(type, pDataCol->pData, i) ^ flip) - min;
+    acc |= delta << nbits;
+    if (nbits + width >= 64) {
+      // flush 8 bytes and keep the bits of delta not fitting in acc
+      memcpy(pBits, &acc, sizeof(acc));
+      pBits += sizeof(acc);
+      acc = (nbits == 0) ? 0 : (delta >> (64 - nbits));
+      nbits = nbits + width - 64;
+    } else {
+      nbits += width;
+    }
+  }
+  if (nbits > 0) memcpy(pBits, &acc, (nbits + 7) / 8);
+
+  return (int32_t)tlen;
+}
+
+static int32_t tsdbDecodeFOR(SDataCol *pDataCol, void *content, int32_t len, int nRows) {
+  int8_t   type = pDataCol->type;
+  uint64_t reference = 0;
+  uint8_t  width = 0;
+
+  if (len < (int32_t)TSDB_FOR_HEAD_SIZE) return -1;
+  void *ptr = taosDecodeFixedU64(content, &reference);
+  ptr = taosDecodeFixedU8(ptr, &width);
+  if (width > 64 || TSDB_FOR_HEAD_SIZE + ((int64_t)width * nRows + 7) / 8 != len ||
+      TYPE_BYTES[type] * nRows > pDataCol->spaceSize) {
+    return -1;
+  }
+
+  const uint8_t *pBits = (const uint8_t *)ptr;
+  uint64_t       mask = (width == 64) ? UINT64_MAX : (((uint64_t)1 << width) - 1);
+  int64_t        bit = 0;
+  for (int i = 0; i < nRows; i++, bit += width) {
+    uint64_t delta = 0;
+    if (width > 0) {
+      // up to 9 bytes hold the bits of a value, which are read byte by byte near the end
+      int64_t  byte = bit / 8;
+      int      shift = (int)(bit % 8);
+      int      nbytes = (int)MIN(sizeof(uint64_t), (uint64_t)(len - TSDB_FOR_HEAD_SIZE - byte));
+      uint64_t w = 0;
+      memcpy(&w, pBits + byte, nbytes);
+      delta = w >> shift;
+      if (shift + width > 64) delta |= (uint64_t)pBits[byte + 8] << (64 - shift);
+      delta &= mask;
+    }
+    tsdbSetFORVal(type, pDataCol->pData, i, reference + delta);
+  }
+
+  return TYPE_BYTES[type] * nRows;
+}
+
+static int32_t tsdbEncodeDeflate(SDataCol *pDataCol, int nRows, int32_t maxLen, void *output) {
+  uLongf tlen = (uLongf)(maxLen - 1);
+  int    code = compress2((Bytef *)output, &tlen, (const Bytef *)pDataCol->pData,
+                       (uLong)dataColGetNEleLen(pDataCol, nRows), tsdbColumnDeflateLevel);
+
+  // Z_BUF_ERROR if it does not fit in maxLen - 1 bytes
+  return (code == Z_OK) ? (int32_t)tlen : 0;
+}
+
+static int32_t tsdbDecodeDeflate(SDataCol *pDataCol, void *content, int32_t len) {
+  uLongf tlen = (uLongf)pDataCol->spaceSize;
+  if (uncompress((Bytef *)pDataCol->pData, &tlen, (const Bytef *)content, (uLong)len) != Z_OK) {
+    return -1;
+  }
+  return (int32_t)tlen;
+}
@@ -12,11 +12,15 @@
  * You should have received a copy of the GNU Affero General Public License
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
+#include "tglobal.h"
 #include "tsdbint.h"
 
 extern int32_t tsTsdbMetaCompactRatio;
 
 #define TSDB_MAX_SUBBLOCKS 8
+#define TSDB_COMMIT_ROUND_TABLES 1024
+#define TSDB_COMMIT_STAGED_FLAG ((int64_t)1 << 61)
+#define TSDB_COMMIT_PROF_TYPES (TSDB_DATA_TYPE_JSON + 1)
 static FORCE_INLINE int TSDB_KEY_FID(TSKEY key, int32_t days, int8_t precision) {
   if (key < 0) {
     return (int)((key + 1) / tsTickPerDay[precision] / days - 1);
@@ -25,6 +29,26 @@ static FORCE_INLINE int TSDB_KEY_FID(TSKEY key, int32_t days, int8_t precision)
   }
 }
 
+// Where the time and the I/O of a commit go. The commit handle and each of its workers keep their own, and the ones of
+// the workers are added to the commit handle after each FSET, so their time is summed over the workers.
+typedef struct {
+  int64_t iterUs;
+  int64_t loadUs;
+  int64_t encodeUs;
+  int64_t writeUs;
+  int64_t fsyncUs;
+  int64_t bytesRead;
+  int64_t bytesWritten;
+  int64_t lastWritten;
+  int64_t typeUs[TSDB_COMMIT_PROF_TYPES];     // compressing the columns of each type
+  int64_t typeBytesIn[TSDB_COMMIT_PROF_TYPES];  // bytes of the columns of each type before and after compression
+  int64_t typeBytesOut[TSDB_COMMIT_PROF_TYPES];
+  STable *pTable;        // table of the last block written
+  int64_t tableLast;     // bytes the table writes to the .last file of the FSET
+  STable *pLastTable;    // table writing the most bytes to the .last file of the FSET
+  int64_t lastTableMax;
+} SCommitProf;
+
 typedef struct {
   SRtn         rtn;     // retention snapshot
   SFSIter      fsIter;  // tsdb file iterator
@@ -41,9 +65,38 @@ typedef struct {
   STable *     pTable;
   SArray *     aSupBlk;  // Table super-block array
   SArray *     aSubBlk;  // table sub-block array
+  SArray *     aStgBlk;  // SCommitStgBlk array, only set in the handles of commit workers
   SDataCols *  pDataCols;
+  SFSetSum     fsetSum;  // summary of the blocks in the commit FSET
+  SCommitProf  prof;
 } SCommitH;
 
+// A block encoded by a commit worker and waiting to be written by the commit thread
+typedef struct {
+  SBlock block;
+  void * pData;
+  void * pAggr;
+} SCommitStgBlk;
+
+typedef struct {
+  int     tid;
+  STable *pTable;
+  SArray *aSupBlk;
+  SArray *aSubBlk;
+  SArray *aStgBlk;
+} SCommitTableRes;
+
+// A round of tables of one FSET committed by the commit workers
+typedef struct {
+  SCommitH *       pCommith;
+  SCommitH *       workers;
+  int              ntables;
+  int32_t          next;
+  int32_t          code;
+  SCommitTableRes *res;
+  tsem_t           done;
+} SCommitRound;
+
 #define TSDB_COMMIT_REPO(ch) TSDB_READ_REPO(&(ch->readh))
 #define TSDB_COMMIT_REPO_ID(ch) REPO_ID(TSDB_READ_REPO(&(ch->readh)))
 #define TSDB_COMMIT_WRITE_FSET(ch) (&((ch)->wSet))
@@ -77,7 +130,7 @@ static int  tsdbNextCommitFid(SCommitH *pCommith);
 static int  tsdbCommitToTable(SCommitH *pCommith, int tid);
 static int  tsdbSetCommitTable(SCommitH *pCommith, STable *pTable);
 static int  tsdbComparKeyBlock(const void *arg1, const void *arg2);
-static int  tsdbWriteBlockInfo(SCommitH *pCommih);
+static int  tsdbWriteBlockInfo(SCommitH *pCommih, STable *pTable, SArray *pSupA, SArray *pSubA);
 static int  tsdbCommitMemData(SCommitH *pCommith, SCommitIter *pIter, TSKEY keyLimit, bool toData);
 static int  tsdbMergeMemData(SCommitH *pCommith, SCommitIter *pIter, int bidx);
 static int  tsdbMoveBlock(SCommitH *pCommith, int bidx);
@@ -91,6 +144,16 @@ static void tsdbCloseCommitFile(SCommitH *pCommith, bool hasError);
 static bool tsdbCanAddSubBlock(SCommitH *pCommith, SBlock *pBlock, SMergeInfo *pInfo);
 static void tsdbLoadAndMergeFromCache(SDataCols *pDataCols, int *iter, SCommitIter *pCommitIter, SDataCols *pTarget,
                                       TSKEY maxKey, int maxRows, int8_t update);
+static int  tsdbCommitTablesParallel(SCommitH *pCommith, SDFileSet *pSet);
+static void tsdbClearStagedBlocks(SArray *aStgBlk);
+static int  tsdbEncodeBlock(STsdbRepo *pRepo, STable *pTable, SDataCols *pDataCols, SBlock *pBlock, bool isLast,
+                            bool isSuper, void **ppBuf, void **ppCBuf, void **ppExBuf, SCommitProf *pProf);
+static int  tsdbWriteEncodedBlock(STsdbRepo *pRepo, STable *pTable, SDFile *pDFile, SDFile *pDFileAggr, SBlock *pBlock,
+                                  void *pBuf, void *pExBuf);
+static int  tsdbCommitLoadBlock(SCommitH *pCommith, SBlock *pBlock, int16_t *colIds, int numOfColIds);
+static void tsdbProfBlockWritten(SCommitProf *pProf, STable *pTable, SBlock *pBlock);
+static void tsdbAddCommitProf(SCommitProf *pProf, SCommitProf *pWorkerProf);
+static void tsdbEndCommitProf(STsdbRepo *pRepo, SCommitProf *pProf, int64_t startUs);
 
 void *tsdbCommitData(STsdbRepo *pRepo) {
   if (pRepo->imem == NULL) {
@@ -129,7 +192,7 @@ int tsdbApplyRtnOnFSet(STsdbRepo *pRepo, SDFileSet *pSet, SRtn *pRtn) {
 
   ASSERT(pSet->fid >= pRtn->minFid);
 
-  level = tsdbGetFidLevel(pSet->fid, pRtn);
+  level = tsdbGetFSetTierLevel(pRepo, pSet->fid, pRtn);
 
   tfsAllocDisk(level, &(did.level), &(did.id));
   if (did.level == TFS_UNDECIDED_LEVEL) {
@@ -401,6 +464,7 @@ void tsdbGetRtnSnap(STsdbRepo *pRepo, SRtn *pRtn) {
   pRtn->minFid = (int)(TSDB_KEY_FID(minKey, pCfg->daysPerFile, pCfg->precision));
   pRtn->midFid = (int)(TSDB_KEY_FID(midKey, pCfg->daysPerFile, pCfg->precision));
   pRtn->maxFid = (int)(TSDB_KEY_FID(maxKey, pCfg->daysPerFile, pCfg->precision));
+  pRtn->nowFid = (int)(TSDB_KEY_FID(now, pCfg->daysPerFile, pCfg->precision));
   tsdbDebug("vgId:%d now:%" PRId64 " minKey:%" PRId64 " minFid:%d, midFid:%d, maxFid:%d", REPO_ID(pRepo), now, minKey,
             pRtn->minFid, pRtn->midFid, pRtn->maxFid);
 }
@@ -606,6 +670,7 @@ static int tsdbCommitTSData(STsdbRepo *pRepo) {
   SCommitH   commith;
   SDFileSet *pSet = NULL;
   int        fid;
+  int64_t    startUs = taosGetTimestampUs();
 
   memset(&commith, 0, sizeof(commith));
 
@@ -673,6 +738,7 @@ static int tsdbCommitTSData(STsdbRepo *pRepo) {
     }
   }
 
+  tsdbEndCommitProf(pRepo, &(commith.prof), startUs);
   tsdbDestroyCommitH(&commith);
   return 0;
 }
@@ -684,6 +750,11 @@ static void tsdbStartCommit(STsdbRepo *pRepo) {
 
   tsdbInfo("vgId:%d start to commit! keyFirst %" PRId64 " keyLast %" PRId64 " numOfRows %" PRId64 " meta rows: %d",
            REPO_ID(pRepo), pMem->keyFirst, pMem->keyLast, pMem->numOfRows, listNEles(pMem->actList));
+  tsdbDebug("vgId:%d rows appended in order %" PRId64 ", rows merged by skiplist search %" PRId64, REPO_ID(pRepo),
+            pMem->rowsAppended, pMem->rowsMerged);
+
+  pRepo->stat.rowsAppended += pMem->rowsAppended;
+  pRepo->stat.rowsMerged += pMem->rowsMerged;
 
   tsdbStartFSTxn(pRepo, pMem->pointsAdd, pMem->storageAdd);
 
@@ -695,6 +766,9 @@ static void tsdbEndCommit(STsdbRepo *pRepo, int eno) {
     tsdbEndFSTxnWithError(REPO_FS(pRepo));
   } else {
     tsdbEndFSTxn(pRepo);
+    if (tsdbSaveLastCache(pRepo) < 0) {
+      tsdbWarn("vgId:%d failed to save last row cache since %s", REPO_ID(pRepo), tstrerror(terrno));
+    }
   }
 
   tsdbInfo("vgId:%d commit over, %s", REPO_ID(pRepo), (eno == TSDB_CODE_SUCCESS) ? "succeed" : "failed");
@@ -702,10 +776,14 @@ static void tsdbEndCommit(STsdbRepo *pRepo, int eno) {
   if (pRepo->appH.notifyStatus) pRepo->appH.notifyStatus(pRepo->appH.appH, TSDB_STATUS_COMMIT_OVER, eno);
 
   SMemTable *pIMem = pRepo->imem;
+  tsdbDropMemTableCols(pIMem);
   (void)tsdbLockRepo(pRepo);
   pRepo->imem = NULL;
   (void)tsdbUnlockRepo(pRepo);
   tsdbUnRefMemTable(pRepo, pIMem);
+
+  // a background compaction or tier migration takes over readyToCommit and posts it once over
+  if (eno == TSDB_CODE_SUCCESS && (tsdbScheduleAutoCompact(pRepo) || tsdbScheduleTierMigrate(pRepo))) return;
   tsem_post(&(pRepo->readyToCommit));
 }
 
@@ -720,12 +798,19 @@ static bool tsdbHasDataToCommit(SCommitIter *iters, int nIters, TSKEY minKey, TS
 #endif
 
 static int tsdbCommitToFile(SCommitH *pCommith, SDFileSet *pSet, int fid) {
-  STsdbRepo *pRepo = TSDB_COMMIT_REPO(pCommith);
-  STsdbCfg * pCfg = REPO_CFG(pRepo);
+  STsdbRepo *  pRepo = TSDB_COMMIT_REPO(pCommith);
+  STsdbCfg *   pCfg = REPO_CFG(pRepo);
+  SCommitProf *pProf = &(pCommith->prof);
+  int64_t      bytesRead = pProf->bytesRead;
+  int64_t      bytesWritten = pProf->bytesWritten;
+  int64_t      lastWritten = pProf->lastWritten;
+  int64_t      ts;
 
   ASSERT(pSet == NULL || pSet->fid == fid);
 
   tsdbResetCommitFile(pCommith);
+  pProf->pTable = pProf->pLastTable = NULL;
+  pProf->tableLast = pProf->lastTableMax = 0;
   tsdbGetFidKeyRange(pCfg->daysPerFile, pCfg->precision, fid, &(pCommith->minKey), &(pCommith->maxKey));
 
   // Set and open files
@@ -733,20 +818,32 @@ static int tsdbCommitToFile(SCommitH *pCommith, SDFileSet *pSet, int fid) {
     return -1;
   }
 
-  // Loop to commit each table data
-  for (int tid = 1; tid < pCommith->niters; tid++) {
-    SCommitIter *pIter = pCommith->iters + tid;
-
-    if (pIter->pTable == NULL) continue;
-
-    if (tsdbCommitToTable(pCommith, tid) < 0) {
+  if (tsdbCommitWorkers() > 0 && (pSet == NULL || pCommith->isDFileSame)) {
+    // Encode tables by the commit workers, a FSET moved to another level is committed serially as all of its blocks
+    // are rewritten
+    if (tsdbCommitTablesParallel(pCommith, pSet) < 0) {
       tsdbCloseCommitFile(pCommith, true);
       // revert the file change
       tsdbApplyDFileSetChange(TSDB_COMMIT_WRITE_FSET(pCommith), pSet);
       return -1;
     }
+  } else {
+    // Loop to commit each table data
+    for (int tid = 1; tid < pCommith->niters; tid++) {
+      SCommitIter *pIter = pCommith->iters + tid;
+
+      if (pIter->pTable == NULL) continue;
+
+      if (tsdbCommitToTable(pCommith, tid) < 0) {
+        tsdbCloseCommitFile(pCommith, true);
+        // revert the file change
+        tsdbApplyDFileSetChange(TSDB_COMMIT_WRITE_FSET(pCommith), pSet);
+        return -1;
+      }
+    }
   }
 
+  ts = taosGetTimestampUs();
   if (tsdbWriteBlockIdx(TSDB_COMMIT_HEAD_FILE(pCommith), pCommith->aBlkIdx, (void **)(&(TSDB_COMMIT_BUF(pCommith)))) <
       0) {
     tsdbError("vgId:%d failed to write SBlockIdx part to FSET %d since %s", REPO_ID(pRepo), fid, tstrerror(terrno));
@@ -756,6 +853,15 @@ static int tsdbCommitToFile(SCommitH *pCommith, SDFileSet *pSet, int fid) {
     return -1;
   }
 
+  if (tsdbWriteFSetSum(TSDB_COMMIT_HEAD_FILE(pCommith), &(pCommith->fsetSum), (void **)(&(TSDB_COMMIT_BUF(pCommith)))) <
+      0) {
+    tsdbError("vgId:%d failed to write summary part to FSET %d since %s", REPO_ID(pRepo), fid, tstrerror(terrno));
+    tsdbCloseCommitFile(pCommith, true);
+    // revert the file change
+    tsdbApplyDFileSetChange(TSDB_COMMIT_WRITE_FSET(pCommith), pSet);
+    return -1;
+  }
+
   if (tsdbUpdateDFileSetHeader(&(pCommith->wSet)) < 0) {
     tsdbError("vgId:%d failed to update FSET %d header since %s", REPO_ID(pRepo), fid, tstrerror(terrno));
     tsdbCloseCommitFile(pCommith, true);
@@ -764,16 +870,277 @@ static int tsdbCommitToFile(SCommitH *pCommith, SDFileSet *pSet, int fid) {
     return -1;
   }
 
+  pProf->writeUs += taosGetTimestampUs() - ts;
+
   // Close commit file
+  ts = taosGetTimestampUs();
   tsdbCloseCommitFile(pCommith, false);
+  pProf->fsyncUs += taosGetTimestampUs() - ts;
 
   if (tsdbUpdateDFileSet(REPO_FS(pRepo), &(pCommith->wSet)) < 0) {
     return -1;
   }
 
+  tsdbDebug("vgId:%d FSET %d is committed, %" PRId64 " bytes read, %" PRId64 " bytes written, %" PRId64
+            " bytes to the .last file",
+            REPO_ID(pRepo), fid, pProf->bytesRead - bytesRead, pProf->bytesWritten - bytesWritten,
+            pProf->lastWritten - lastWritten);
+  if (pProf->pLastTable != NULL) {
+    tsdbDebug("vgId:%d FSET %d table %s tid %d uid %" PRIu64 " writes the most to the .last file, %" PRId64 " bytes",
+              REPO_ID(pRepo), fid, TABLE_CHAR_NAME(pProf->pLastTable), TABLE_TID(pProf->pLastTable),
+              TABLE_UID(pProf->pLastTable), pProf->lastTableMax);
+  }
+
+  return 0;
+}
+
+static void tsdbClearStagedBlocks(SArray *aStgBlk) {
+  size_t nStgBlks = taosArrayGetSize(aStgBlk);
+
+  for (size_t i = 0; i < nStgBlks; i++) {
+    SCommitStgBlk *pStgBlk = (SCommitStgBlk *)taosArrayGet(aStgBlk, i);
+    tfree(pStgBlk->pData);
+    tfree(pStgBlk->pAggr);
+  }
+
+  taosArrayClear(aStgBlk);
+}
+
+static void tsdbDestroyCommitTableRes(SCommitTableRes *pRes) {
+  if (pRes->aStgBlk) tsdbClearStagedBlocks(pRes->aStgBlk);
+  pRes->aStgBlk = taosArrayDestroy(&pRes->aStgBlk);
+  pRes->aSubBlk = taosArrayDestroy(&pRes->aSubBlk);
+  pRes->aSupBlk = taosArrayDestroy(&pRes->aSupBlk);
+  pRes->pTable = NULL;
+}
+
+static void tsdbDestroyCommitWorker(SCommitH *pWorker) {
+  pWorker->pDataCols = tdFreeDataCols(pWorker->pDataCols);
+  if (pWorker->aStgBlk) tsdbClearStagedBlocks(pWorker->aStgBlk);
+  pWorker->aStgBlk = taosArrayDestroy(&pWorker->aStgBlk);
+  pWorker->aSubBlk = taosArrayDestroy(&pWorker->aSubBlk);
+  pWorker->aSupBlk = taosArrayDestroy(&pWorker->aSupBlk);
+  // The iterators and the write FSET belong to the commit handle
+  tsdbDestroyReadH(&(pWorker->readh));
+}
+
+static int tsdbInitCommitWorker(SCommitH *pWorker, SCommitH *pCommith, SDFileSet *pSet) {
+  STsdbRepo *pRepo = TSDB_COMMIT_REPO(pCommith);
+  STsdbCfg * pCfg = REPO_CFG(pRepo);
+
+  memset(pWorker, 0, sizeof(*pWorker));
+
+  if (tsdbInitReadH(&(pWorker->readh), pRepo) < 0) {
+    return -1;
+  }
+  pWorker->readh.dropDataCache = pCommith->readh.dropDataCache;
+  pWorker->readh.dropLastCache = pCommith->readh.dropLastCache;
+
+  pWorker->rtn = pCommith->rtn;
+  pWorker->niters = pCommith->niters;
+  pWorker->iters = pCommith->iters;
+  pWorker->wSet = pCommith->wSet;
+  pWorker->isDFileSame = pCommith->isDFileSame;
+  pWorker->isLFileSame = pCommith->isLFileSame;
+  pWorker->minKey = pCommith->minKey;
+  pWorker->maxKey = pCommith->maxKey;
+
+  if (pCommith->isRFileSet) {
+    if (tsdbSetAndOpenReadFSet(&(pWorker->readh), pSet) < 0) {
+      return -1;
+    }
+
+    pWorker->isRFileSet = true;
+
+    if (tsdbLoadBlockIdx(&(pWorker->readh)) < 0) {
+      return -1;
+    }
+  }
+
+  pWorker->aSupBlk = taosArrayInit(1024, sizeof(SBlock));
+  pWorker->aSubBlk = taosArrayInit(1024, sizeof(SBlock));
+  pWorker->aStgBlk = taosArrayInit(1024, sizeof(SCommitStgBlk));
+  pWorker->pDataCols = tdNewDataCols(0, pCfg->maxRowsPerFileBlock);
+  if (pWorker->aSupBlk == NULL || pWorker->aSubBlk == NULL || pWorker->aStgBlk == NULL || pWorker->pDataCols == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    return -1;
+  }
+
   return 0;
 }
 
+// Move the blocks of the table just committed by the worker to the round result
+static int tsdbTakeCommitTableRes(SCommitH *pWorker, SCommitTableRes *pRes) {
+  if (taosArrayGetSize(pWorker->aSupBlk) == 0) return 0;
+
+  pRes->pTable = pWorker->pTable;
+  pRes->aSupBlk = taosArrayDup(pWorker->aSupBlk);
+  pRes->aStgBlk = taosArrayDup(pWorker->aStgBlk);
+  if (taosArrayGetSize(pWorker->aSubBlk) > 0) {
+    pRes->aSubBlk = taosArrayDup(pWorker->aSubBlk);
+  }
+
+  if (pRes->aSupBlk == NULL || pRes->aStgBlk == NULL ||
+      (taosArrayGetSize(pWorker->aSubBlk) > 0 && pRes->aSubBlk == NULL)) {
+    pRes->aStgBlk = taosArrayDestroy(&pRes->aStgBlk);
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    return -1;
+  }
+
+  // The staged data is owned by the result now
+  taosArrayClear(pWorker->aStgBlk);
+
+  return 0;
+}
+
+static void tsdbCommitTablesTask(SSchedMsg *pMsg) {
+  SCommitRound *pRound = (SCommitRound *)pMsg->ahandle;
+  SCommitH *    pWorker = (SCommitH *)pMsg->thandle;
+
+  // Each worker takes the tables in increasing tid order, as required by its read handle
+  while (atomic_load_32(&pRound->code) == TSDB_CODE_SUCCESS) {
+    int idx = atomic_fetch_add_32(&pRound->next, 1);
+    if (idx >= pRound->ntables) break;
+
+    SCommitTableRes *pRes = pRound->res + idx;
+    if (tsdbCommitToTable(pWorker, pRes->tid) < 0 || tsdbTakeCommitTableRes(pWorker, pRes) < 0) {
+      int32_t code = (terrno != TSDB_CODE_SUCCESS) ? terrno : TSDB_CODE_TDB_OUT_OF_MEMORY;
+      atomic_val_compare_exchange_32(&pRound->code, TSDB_CODE_SUCCESS, code);
+      break;
+    }
+  }
+
+  tsem_post(&pRound->done);
+}
+
+static void tsdbFixStagedOffsets(SArray *pBlockA, SArray *aStgBlk) {
+  size_t nBlocks = (pBlockA == NULL) ? 0 : taosArrayGetSize(pBlockA);
+
+  for (size_t i = 0; i < nBlocks; i++) {
+    SBlock *pBlock = (SBlock *)taosArrayGet(pBlockA, i);
+    if ((pBlock->offset & TSDB_COMMIT_STAGED_FLAG) == 0) continue;
+
+    SCommitStgBlk *pStgBlk = (SCommitStgBlk *)taosArrayGet(aStgBlk, pBlock->offset & (TSDB_COMMIT_STAGED_FLAG - 1));
+    pBlock->offset = pStgBlk->block.offset;
+    pBlock->aggrOffset = pStgBlk->block.aggrOffset;
+  }
+}
+
+// Write the blocks staged for a table in the order they are encoded, then its block info
+static int tsdbWriteStagedTable(SCommitH *pCommith, SCommitTableRes *pRes) {
+  STsdbRepo *pRepo = TSDB_COMMIT_REPO(pCommith);
+  size_t     nStgBlks = taosArrayGetSize(pRes->aStgBlk);
+
+  for (size_t i = 0; i < nStgBlks; i++) {
+    SCommitStgBlk *pStgBlk = (SCommitStgBlk *)taosArrayGet(pRes->aStgBlk, i);
+    SBlock *       pBlock = &(pStgBlk->block);
+    SDFile *       pDFile = pBlock->last ? TSDB_COMMIT_LAST_FILE(pCommith) : TSDB_COMMIT_DATA_FILE(pCommith);
+    SDFile *       pDFileAggr = pBlock->last ? TSDB_COMMIT_SMAL_FILE(pCommith) : TSDB_COMMIT_SMAD_FILE(pCommith);
+
+    int64_t ts = taosGetTimestampUs();
+    if (tsdbWriteEncodedBlock(pRepo, pRes->pTable, pDFile, pDFileAggr, pBlock, pStgBlk->pData, pStgBlk->pAggr) < 0) {
+      return -1;
+    }
+    pCommith->prof.writeUs += taosGetTimestampUs() - ts;
+    tsdbProfBlockWritten(&(pCommith->prof), pRes->pTable, pBlock);
+
+    if (tsdbAddBlockToFSetSum(&(pCommith->fsetSum), pRes->pTable, pBlock, pStgBlk->pData, pStgBlk->pAggr) < 0) {
+      return -1;
+    }
+  }
+
+  tsdbFixStagedOffsets(pRes->aSupBlk, pRes->aStgBlk);
+  tsdbFixStagedOffsets(pRes->aSubBlk, pRes->aStgBlk);
+
+  // tsdbWriteBlockInfo adds its write time to the profile itself
+  if (tsdbWriteBlockInfo(pCommith, pRes->pTable, pRes->aSupBlk, pRes->aSubBlk) < 0) {
+    tsdbError("vgId:%d failed to write SBlockInfo part into file %s since %s", REPO_ID(pRepo),
+              TSDB_FILE_FULL_NAME(TSDB_COMMIT_HEAD_FILE(pCommith)), tstrerror(terrno));
+    return -1;
+  }
+
+  return 0;
+}
+
+/**
+ * Commit the tables of a FSET with the commit workers. The tables are taken in rounds, the workers load, merge and
+ * encode the table blocks of a round, then the commit thread writes the blocks and the block info in table order so
+ * the files are the same as a serial commit.
+ */
+static int tsdbCommitTablesParallel(SCommitH *pCommith, SDFileSet *pSet) {
+  int          nworkers = tsdbCommitWorkers();
+  int          ninit = 0;
+  int          tid = 1;
+  int          ret = -1;
+  SCommitRound round = {0};
+
+  round.pCommith = pCommith;
+  round.res = (SCommitTableRes *)calloc(TSDB_COMMIT_ROUND_TABLES, sizeof(SCommitTableRes));
+  round.workers = (SCommitH *)calloc(nworkers, sizeof(SCommitH));
+  if (round.res == NULL || round.workers == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    tfree(round.res);
+    tfree(round.workers);
+    return -1;
+  }
+  tsem_init(&(round.done), 0, 0);
+
+  while (ninit < nworkers) {
+    if (tsdbInitCommitWorker(round.workers + ninit++, pCommith, pSet) < 0) {
+      goto _end;
+    }
+  }
+
+  while (true) {
+    round.ntables = 0;
+    round.next = 0;
+    for (; tid < pCommith->niters && round.ntables < TSDB_COMMIT_ROUND_TABLES; tid++) {
+      if (pCommith->iters[tid].pTable == NULL) continue;
+      round.res[round.ntables++].tid = tid;
+    }
+
+    if (round.ntables == 0) break;
+
+    int ntasks = MIN(nworkers, round.ntables);
+    for (int i = 0; i < ntasks; i++) {
+      tsdbScheduleCommitWork(tsdbCommitTablesTask, &round, round.workers + i);
+    }
+    for (int i = 0; i < ntasks; i++) {
+      tsem_wait(&(round.done));
+    }
+
+    if (round.code != TSDB_CODE_SUCCESS) {
+      terrno = round.code;
+      goto _end;
+    }
+
+    for (int i = 0; i < round.ntables; i++) {
+      SCommitTableRes *pRes = round.res + i;
+      if (pRes->aSupBlk == NULL) continue;
+
+      if (tsdbWriteStagedTable(pCommith, pRes) < 0) {
+        goto _end;
+      }
+      tsdbDestroyCommitTableRes(pRes);
+    }
+  }
+
+  ret = 0;
+
+_end:
+  for (int i = 0; i < TSDB_COMMIT_ROUND_TABLES; i++) {
+    tsdbDestroyCommitTableRes(round.res + i);
+  }
+  for (int i = 0; i < ninit; i++) {
+    tsdbAddCommitProf(&(pCommith->prof), &(round.workers[i].prof));
+    tsdbDestroyCommitWorker(round.workers + i);
+  }
+  tsem_destroy(&(round.done));
+  tfree(round.res);
+  tfree(round.workers);
+  return ret;
+}
+
 static int tsdbCreateCommitIters(SCommitH *pCommith) {
   STsdbRepo *pRepo = TSDB_COMMIT_REPO(pCommith);
   SMemTable *pMem = pRepo->imem;
@@ -805,6 +1172,7 @@ static int tsdbCreateCommitIters(SCommitH *pCommith) {
         terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
         return -1;
       }
+      pCommith->iters[i].pTableData = pMem->tData[i];
 
       tSkipListIterNext(pCommith->iters[i].pIter);
     }
@@ -887,10 +1255,16 @@ static int tsdbInitCommitH(SCommitH *pCommith, STsdbRepo *pRepo) {
     return -1;
   }
 
+  if (tsdbInitFSetSum(&(pCommith->fsetSum)) < 0) {
+    tsdbDestroyCommitH(pCommith);
+    return -1;
+  }
+
   return 0;
 }
 
 static void tsdbDestroyCommitH(SCommitH *pCommith) {
+  tsdbDestroyFSetSum(&(pCommith->fsetSum));
   pCommith->pDataCols = tdFreeDataCols(pCommith->pDataCols);
   pCommith->aSubBlk = taosArrayDestroy(&pCommith->aSubBlk);
   pCommith->aSupBlk = taosArrayDestroy(&pCommith->aSupBlk);
@@ -1014,7 +1388,10 @@ static int tsdbCommitToTable(SCommitH *pCommith, int tid) {
 
   TSDB_RUNLOCK_TABLE(pIter->pTable);
 
-  if (tsdbWriteBlockInfo(pCommith) < 0) {
+  // Blocks staged by a commit worker are written by the commit thread
+  if (pCommith->aStgBlk != NULL) return 0;
+
+  if (tsdbWriteBlockInfo(pCommith, pCommith->pTable, pCommith->aSupBlk, pCommith->aSubBlk) < 0) {
     tsdbError("vgId:%d failed to write SBlockInfo part into file %s since %s", TSDB_COMMIT_REPO_ID(pCommith),
               TSDB_FILE_FULL_NAME(TSDB_COMMIT_HEAD_FILE(pCommith)), tstrerror(terrno));
     return -1;
@@ -1056,12 +1433,15 @@ static int tsdbComparKeyBlock(const void *arg1, const void *arg2) {
   }
 }
 
-int tsdbWriteBlockImpl(STsdbRepo *pRepo, STable *pTable, SDFile *pDFile, SDFile *pDFileAggr, SDataCols *pDataCols,
-                       SBlock *pBlock, bool isLast, bool isSuper, void **ppBuf, void **ppCBuf, void **ppExBuf) {
+/**
+ * Encode and compress pDataCols as a block in *ppBuf and its aggregate part in *ppExBuf, pBlock is set except the
+ * offsets which are set when the block is written by tsdbWriteEncodedBlock.
+ */
+static int tsdbEncodeBlock(STsdbRepo *pRepo, STable *pTable, SDataCols *pDataCols, SBlock *pBlock, bool isLast,
+                           bool isSuper, void **ppBuf, void **ppCBuf, void **ppExBuf, SCommitProf *pProf) {
   STsdbCfg *  pCfg = REPO_CFG(pRepo);
   SBlockData *pBlockData;
   SAggrBlkData *pAggrBlkData = NULL;
-  int64_t     offset = 0, offsetAggr = 0;
   int         rowsToWrite = pDataCols->numOfRows;
 
   ASSERT(rowsToWrite > 0 && rowsToWrite <= pCfg->maxRowsPerFileBlock);
@@ -1146,6 +1526,8 @@ int tsdbWriteBlockImpl(STsdbRepo *pRepo, STable *pTable, SDFile *pDFile, SDFile
       return -1;
     }
 
+    int64_t ts = (pProf != NULL) ? taosGetTimestampUs() : 0;
+
     // Compress or just copy
     if (pCfg->compression) {
       flen = (*(tDataTypes[pDataCol->type].compFunc))((char *)pDataCol->pData, tlen, rowsToWrite, tptr,
@@ -1156,11 +1538,27 @@ int tsdbWriteBlockImpl(STsdbRepo *pRepo, STable *pTable, SDFile *pDFile, SDFile
       memcpy(tptr, pDataCol->pData, flen);
     }
 
+    // Replace it by a column codec if one is enabled and encodes the column smaller
+    if (ncol != 0 && TSDB_COL_CODEC_ENABLED()) {
+      int32_t clen = 0;
+      int     codec = tsdbEncodeColumn(pDataCol, rowsToWrite, flen, tptr, &clen, ppCBuf);
+      if (codec < 0) return -1;
+      if (codec != TSDB_COL_CODEC_NONE) {
+        pBlockCol->codec = (uint8_t)codec;
+        flen = clen;
+      }
+    }
+
+    if (pProf != NULL && pDataCol->type < TSDB_COMMIT_PROF_TYPES) {
+      pProf->typeUs[pDataCol->type] += taosGetTimestampUs() - ts;
+      pProf->typeBytesIn[pDataCol->type] += tlen;
+      pProf->typeBytesOut[pDataCol->type] += flen;
+    }
+
     // Add checksum
     ASSERT(flen > 0);
     flen += sizeof(TSCKSUM);
     taosCalcChecksumAppend(0, (uint8_t *)tptr, flen);
-    tsdbUpdateDFileMagic(pDFile, POINTER_SHIFT(tptr, flen - sizeof(TSCKSUM)));
 
     if (ncol != 0) {
       tsdbSetBlockColOffset(pBlockCol, toffset);
@@ -1174,33 +1572,26 @@ int tsdbWriteBlockImpl(STsdbRepo *pRepo, STable *pTable, SDFile *pDFile, SDFile
     lsize += flen;
   }
 
+  // Append the rollup of the rows after the columns
+  int32_t rlen = tsdbEncodeBlockRollup(pRepo, pDataCols, pAggrBlkData, nColsNotAllNull, ppBuf, lsize);
+  if (rlen < 0) return -1;
+  pBlockData = (SBlockData *)(*ppBuf);
+  lsize += rlen;
+
   pBlockData->delimiter = TSDB_FILE_DELIMITER;
   pBlockData->uid = TABLE_UID(pTable);
   pBlockData->numOfCols = nColsNotAllNull;
 
   taosCalcChecksumAppend(0, (uint8_t *)pBlockData, tsize);
-  tsdbUpdateDFileMagic(pDFile, POINTER_SHIFT(pBlockData, tsize - sizeof(TSCKSUM)));
-
-  // Write the whole block to file
-  if (tsdbAppendDFile(pDFile, (void *)pBlockData, lsize, &offset) < lsize) {
-    return -1;
-  }
 
   uint32_t aggrStatus = nColsNotAllNull > 0 ? 1 : 0;
   if (aggrStatus > 0) {
-
     taosCalcChecksumAppend(0, (uint8_t *)pAggrBlkData, tsizeAggr);
-    tsdbUpdateDFileMagic(pDFileAggr, POINTER_SHIFT(pAggrBlkData, tsizeAggr - sizeof(TSCKSUM)));
-
-    // Write the whole block to file
-    if (tsdbAppendDFile(pDFileAggr, (void *)pAggrBlkData, tsizeAggr, &offsetAggr) < tsizeAggr) {
-      return -1;
-    }
   }
 
   // Update pBlock membership variables
   pBlock->last = isLast;
-  pBlock->offset = offset;
+  pBlock->offset = 0;
   pBlock->algorithm = pCfg->compression;
   pBlock->numOfRows = rowsToWrite;
   pBlock->len = lsize;
@@ -1212,33 +1603,154 @@ int tsdbWriteBlockImpl(STsdbRepo *pRepo, STable *pTable, SDFile *pDFile, SDFile
   // since blkVer1
   pBlock->aggrStat = aggrStatus;
   pBlock->blkVer = SBlockVerLatest;
+  pBlock->aggrOffset = 0;
+
+  return 0;
+}
+
+/**
+ * Append a block encoded by tsdbEncodeBlock to pDFile and its aggregate part to pDFileAggr, and set the offsets of
+ * pBlock. The file magics are updated with the checksums in the same order as the parts are encoded.
+ */
+static int tsdbWriteEncodedBlock(STsdbRepo *pRepo, STable *pTable, SDFile *pDFile, SDFile *pDFileAggr, SBlock *pBlock,
+                                 void *pBuf, void *pExBuf) {
+  SBlockData *pBlockData = (SBlockData *)pBuf;
+  int32_t     tsize = (int32_t)tsdbBlockStatisSize(pBlock->numOfCols, SBlockVerLatest);
+  int64_t     offset = 0, offsetAggr = 0;
+
+  tsdbUpdateDFileMagic(pDFile, POINTER_SHIFT(pBlockData, tsize + pBlock->keyLen - sizeof(TSCKSUM)));
+  for (int i = 0; i < pBlock->numOfCols; i++) {
+    SBlockCol *pBlockCol = pBlockData->cols + i;
+    tsdbUpdateDFileMagic(pDFile, POINTER_SHIFT(pBlockData, tsize + tsdbGetBlockColOffset(pBlockCol) + pBlockCol->len -
+                                                               sizeof(TSCKSUM)));
+  }
+  tsdbUpdateDFileMagic(pDFile, POINTER_SHIFT(pBlockData, tsize - sizeof(TSCKSUM)));
+  if (tsdbBlockDataEnd(pBlock, pBlockData) < pBlock->len) {
+    tsdbUpdateDFileMagic(pDFile, POINTER_SHIFT(pBlockData, pBlock->len - sizeof(TSCKSUM)));
+  }
+
+  // Write the whole block to file
+  if (tsdbAppendDFile(pDFile, pBuf, pBlock->len, &offset) < pBlock->len) {
+    return -1;
+  }
+
+  if (pBlock->aggrStat > 0) {
+    uint32_t tsizeAggr = (uint32_t)tsdbBlockAggrSize(pBlock->numOfCols, SBlockVerLatest);
+
+    tsdbUpdateDFileMagic(pDFileAggr, POINTER_SHIFT(pExBuf, tsizeAggr - sizeof(TSCKSUM)));
+
+    // Write the whole block to file
+    if (tsdbAppendDFile(pDFileAggr, pExBuf, tsizeAggr, &offsetAggr) < tsizeAggr) {
+      return -1;
+    }
+  }
+
+  pBlock->offset = offset;
   pBlock->aggrOffset = (uint64_t)offsetAggr;
 
+  tsdbWriteBackDFile(pDFile, false);
+  if (pBlock->aggrStat > 0) tsdbWriteBackDFile(pDFileAggr, false);
+
   tsdbDebug("vgId:%d tid:%d a block of data is written to file %s, offset %" PRId64
             " numOfRows %d len %d numOfCols %" PRId16 " keyFirst %" PRId64 " keyLast %" PRId64,
-            REPO_ID(pRepo), TABLE_TID(pTable), TSDB_FILE_FULL_NAME(pDFile), offset, rowsToWrite, pBlock->len,
+            REPO_ID(pRepo), TABLE_TID(pTable), TSDB_FILE_FULL_NAME(pDFile), offset, pBlock->numOfRows, pBlock->len,
             pBlock->numOfCols, pBlock->keyFirst, pBlock->keyLast);
 
   return 0;
 }
 
+int tsdbWriteBlockImpl(STsdbRepo *pRepo, STable *pTable, SDFile *pDFile, SDFile *pDFileAggr, SDataCols *pDataCols,
+                       SBlock *pBlock, bool isLast, bool isSuper, void **ppBuf, void **ppCBuf, void **ppExBuf) {
+  if (tsdbEncodeBlock(pRepo, pTable, pDataCols, pBlock, isLast, isSuper, ppBuf, ppCBuf, ppExBuf, NULL) < 0) {
+    return -1;
+  }
+
+  return tsdbWriteEncodedBlock(pRepo, pTable, pDFile, pDFileAggr, pBlock, *ppBuf, *ppExBuf);
+}
+
+static int tsdbStageBlock(SCommitH *pCommith, SDataCols *pDataCols, SBlock *pBlock, bool isLast, bool isSuper) {
+  SCommitStgBlk stgBlk = {0};
+  int64_t       ts = taosGetTimestampUs();
+
+  if (tsdbEncodeBlock(TSDB_COMMIT_REPO(pCommith), TSDB_COMMIT_TABLE(pCommith), pDataCols, pBlock, isLast, isSuper,
+                      (void **)(&(TSDB_COMMIT_BUF(pCommith))), (void **)(&(TSDB_COMMIT_COMP_BUF(pCommith))),
+                      (void **)(&(TSDB_COMMIT_EXBUF(pCommith))), &(pCommith->prof)) < 0) {
+    return -1;
+  }
+  pCommith->prof.encodeUs += taosGetTimestampUs() - ts;
+
+  stgBlk.block = *pBlock;
+  stgBlk.pData = malloc(pBlock->len);
+  if (stgBlk.pData == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    return -1;
+  }
+  memcpy(stgBlk.pData, TSDB_COMMIT_BUF(pCommith), pBlock->len);
+
+  if (pBlock->aggrStat) {
+    size_t aggrSize = tsdbBlockAggrSize(pBlock->numOfCols, SBlockVerLatest);
+    stgBlk.pAggr = malloc(aggrSize);
+    if (stgBlk.pAggr == NULL) {
+      free(stgBlk.pData);
+      terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+      return -1;
+    }
+    memcpy(stgBlk.pAggr, TSDB_COMMIT_EXBUF(pCommith), aggrSize);
+  }
+
+  if (taosArrayPush(pCommith->aStgBlk, &stgBlk) == NULL) {
+    free(stgBlk.pData);
+    free(stgBlk.pAggr);
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    return -1;
+  }
+
+  // The offsets refer to the staged block until it is written
+  pBlock->offset = TSDB_COMMIT_STAGED_FLAG | (int64_t)(taosArrayGetSize(pCommith->aStgBlk) - 1);
+  pBlock->aggrOffset = 0;
+
+  return 0;
+}
+
 static int tsdbWriteBlock(SCommitH *pCommith, SDFile *pDFile, SDataCols *pDataCols, SBlock *pBlock, bool isLast,
                           bool isSuper) {
-  return tsdbWriteBlockImpl(TSDB_COMMIT_REPO(pCommith), TSDB_COMMIT_TABLE(pCommith), pDFile,
-                            isLast ? TSDB_COMMIT_SMAL_FILE(pCommith) : TSDB_COMMIT_SMAD_FILE(pCommith), pDataCols,
-                            pBlock, isLast, isSuper, (void **)(&(TSDB_COMMIT_BUF(pCommith))),
-                            (void **)(&(TSDB_COMMIT_COMP_BUF(pCommith))), (void **)(&(TSDB_COMMIT_EXBUF(pCommith))));
+  STsdbRepo *pRepo = TSDB_COMMIT_REPO(pCommith);
+  STable *   pTable = TSDB_COMMIT_TABLE(pCommith);
+  int64_t    ts = taosGetTimestampUs();
+
+  if (pCommith->aStgBlk != NULL) {
+    return tsdbStageBlock(pCommith, pDataCols, pBlock, isLast, isSuper);
+  }
+
+  if (tsdbEncodeBlock(pRepo, pTable, pDataCols, pBlock, isLast, isSuper, (void **)(&(TSDB_COMMIT_BUF(pCommith))),
+                      (void **)(&(TSDB_COMMIT_COMP_BUF(pCommith))), (void **)(&(TSDB_COMMIT_EXBUF(pCommith))),
+                      &(pCommith->prof)) < 0) {
+    return -1;
+  }
+  pCommith->prof.encodeUs += taosGetTimestampUs() - ts;
+
+  ts = taosGetTimestampUs();
+  if (tsdbWriteEncodedBlock(pRepo, pTable, pDFile,
+                            isLast ? TSDB_COMMIT_SMAL_FILE(pCommith) : TSDB_COMMIT_SMAD_FILE(pCommith), pBlock,
+                            TSDB_COMMIT_BUF(pCommith), TSDB_COMMIT_EXBUF(pCommith)) < 0) {
+    return -1;
+  }
+  pCommith->prof.writeUs += taosGetTimestampUs() - ts;
+  tsdbProfBlockWritten(&(pCommith->prof), pTable, pBlock);
+
+  return tsdbAddBlockToFSetSum(&(pCommith->fsetSum), TSDB_COMMIT_TABLE(pCommith), pBlock, TSDB_COMMIT_BUF(pCommith),
+                               TSDB_COMMIT_EXBUF(pCommith));
 }
 
-static int tsdbWriteBlockInfo(SCommitH *pCommih) {
+static int tsdbWriteBlockInfo(SCommitH *pCommih, STable *pTable, SArray *pSupA, SArray *pSubA) {
   SDFile *  pHeadf = TSDB_COMMIT_HEAD_FILE(pCommih);
   SBlockIdx blkIdx;
-  STable *  pTable = TSDB_COMMIT_TABLE(pCommih);
+  int64_t   ts = taosGetTimestampUs();
 
-  if (tsdbWriteBlockInfoImpl(pHeadf, pTable, pCommih->aSupBlk, pCommih->aSubBlk, (void **)(&(TSDB_COMMIT_BUF(pCommih))),
-                             &blkIdx) < 0) {
+  if (tsdbWriteBlockInfoImpl(pHeadf, pTable, pSupA, pSubA, (void **)(&(TSDB_COMMIT_BUF(pCommih))), &blkIdx) < 0) {
     return -1;
   }
+  pCommih->prof.writeUs += taosGetTimestampUs() - ts;
 
   if (blkIdx.numOfBlocks == 0) {
     return 0;
@@ -1262,8 +1774,13 @@ static int tsdbCommitMemData(SCommitH *pCommith, SCommitIter *pIter, TSKEY keyLi
   SBlock     block;
 
   while (true) {
-    tsdbLoadDataFromCache(pIter->pTable, pIter->pIter, keyLimit, defaultRows, pCommith->pDataCols, NULL, 0,
-                          pCfg->update, &mInfo);
+    int64_t ts = taosGetTimestampUs();
+    if (tsdbLoadDataFromMemCols(pIter->pTableData, pIter->pIter, keyLimit, defaultRows, pCommith->pDataCols,
+                                &mInfo) < 0) {
+      tsdbLoadDataFromCache(pIter->pTable, pIter->pIter, keyLimit, defaultRows, pCommith->pDataCols, NULL, 0,
+                            pCfg->update, &mInfo);
+    }
+    pCommith->prof.iterUs += taosGetTimestampUs() - ts;
 
     if (pCommith->pDataCols->numOfRows <= 0) break;
 
@@ -1304,10 +1821,12 @@ static int tsdbMergeMemData(SCommitH *pCommith, SCommitIter *pIter, int bidx) {
   }
 
   SSkipListIterator titer = *(pIter->pIter);
-  if (tsdbLoadBlockDataCols(&(pCommith->readh), pBlock, NULL, &colId, 1) < 0) return -1;
+  if (tsdbCommitLoadBlock(pCommith, pBlock, &colId, 1) < 0) return -1;
 
+  int64_t ts = taosGetTimestampUs();
   tsdbLoadDataFromCache(pIter->pTable, &titer, keyLimit, INT32_MAX, NULL, pCommith->readh.pDCols[0]->cols[0].pData,
                         pCommith->readh.pDCols[0]->numOfRows, pCfg->update, &mInfo);
+  pCommith->prof.iterUs += taosGetTimestampUs() - ts;
 
   if (mInfo.nOperations == 0) {
     // no new data to insert (all updates denied)
@@ -1321,9 +1840,11 @@ static int tsdbMergeMemData(SCommitH *pCommith, SCommitIter *pIter, int bidx) {
     *(pIter->pIter) = titer;
   } else if (tsdbCanAddSubBlock(pCommith, pBlock, &mInfo)) {
     // Add a sub-block
+    ts = taosGetTimestampUs();
     tsdbLoadDataFromCache(pIter->pTable, pIter->pIter, keyLimit, INT32_MAX, pCommith->pDataCols,
                           pCommith->readh.pDCols[0]->cols[0].pData, pCommith->readh.pDCols[0]->numOfRows, pCfg->update,
                           &mInfo);
+    pCommith->prof.iterUs += taosGetTimestampUs() - ts;
     if (pBlock->last) {
       pDFile = TSDB_COMMIT_LAST_FILE(pCommith);
     } else {
@@ -1349,7 +1870,7 @@ static int tsdbMergeMemData(SCommitH *pCommith, SCommitIter *pIter, int bidx) {
 
     if (tsdbCommitAddBlock(pCommith, &supBlock, subBlocks, supBlock.numOfSubBlocks) < 0) return -1;
   } else {
-    if (tsdbLoadBlockData(&(pCommith->readh), pBlock, NULL) < 0) return -1;
+    if (tsdbCommitLoadBlock(pCommith, pBlock, NULL, 0) < 0) return -1;
     if (tsdbMergeBlockData(pCommith, pIter, pCommith->readh.pDCols[0], keyLimit, bidx == (nBlocks - 1)) < 0) return -1;
   }
 
@@ -1387,7 +1908,7 @@ static int tsdbMoveBlock(SCommitH *pCommith, int bidx) {
       }
     }
   } else {
-    if (tsdbLoadBlockData(&(pCommith->readh), pBlock, NULL) < 0) return -1;
+    if (tsdbCommitLoadBlock(pCommith, pBlock, NULL, 0) < 0) return -1;
     if (tsdbWriteBlock(pCommith, pDFile, pCommith->readh.pDCols[0], &block, pBlock->last, true) < 0) return -1;
     if (tsdbCommitAddBlock(pCommith, &block, NULL, 0) < 0) return -1;
   }
@@ -1395,6 +1916,30 @@ static int tsdbMoveBlock(SCommitH *pCommith, int bidx) {
   return 0;
 }
 
+// Load the block, or only the columns in colIds if any, into readh.pDCols[0]
+static int tsdbCommitLoadBlock(SCommitH *pCommith, SBlock *pBlock, int16_t *colIds, int numOfColIds) {
+  int64_t ts = taosGetTimestampUs();
+  int     code;
+
+  if (colIds == NULL) {
+    code = tsdbLoadBlockData(&(pCommith->readh), pBlock, NULL);
+    if (pBlock->numOfSubBlocks > 1) {
+      SBlock *pSubBlocks = POINTER_SHIFT(pCommith->readh.pBlkInfo, pBlock->offset);
+      for (int i = 0; i < pBlock->numOfSubBlocks; i++) {
+        pCommith->prof.bytesRead += pSubBlocks[i].len;
+      }
+    } else {
+      pCommith->prof.bytesRead += pBlock->len;
+    }
+  } else {
+    code = tsdbLoadBlockDataCols(&(pCommith->readh), pBlock, NULL, colIds, numOfColIds);
+    pCommith->prof.bytesRead += pBlock->keyLen;
+  }
+  pCommith->prof.loadUs += taosGetTimestampUs() - ts;
+
+  return code;
+}
+
 static int tsdbCommitAddBlock(SCommitH *pCommith, const SBlock *pSupBlock, const SBlock *pSubBlocks, int nSubBlocks) {
   if (taosArrayPush(pCommith->aSupBlk, pSupBlock) == NULL) {
     terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
@@ -1419,8 +1964,10 @@ static int tsdbMergeBlockData(SCommitH *pCommith, SCommitIter *pIter, SDataCols
 
   int biter = 0;
   while (true) {
+    int64_t ts = taosGetTimestampUs();
     tsdbLoadAndMergeFromCache(pCommith->readh.pDCols[0], &biter, pIter, pCommith->pDataCols, keyLimit, defaultRows,
                               pCfg->update);
+    pCommith->prof.iterUs += taosGetTimestampUs() - ts;
 
     if (pCommith->pDataCols->numOfRows == 0) break;
 
@@ -1523,6 +2070,7 @@ static void tsdbResetCommitFile(SCommitH *pCommith) {
 static void tsdbResetCommitTable(SCommitH *pCommith) {
   taosArrayClear(pCommith->aSubBlk);
   taosArrayClear(pCommith->aSupBlk);
+  if (pCommith->aStgBlk) tsdbClearStagedBlocks(pCommith->aStgBlk);
   pCommith->pTable = NULL;
 }
 
@@ -1531,7 +2079,7 @@ static int tsdbSetAndOpenCommitFile(SCommitH *pCommith, SDFileSet *pSet, int fid
   STsdbRepo *pRepo = TSDB_COMMIT_REPO(pCommith);
   SDFileSet *pWSet = TSDB_COMMIT_WRITE_FSET(pCommith);
 
-  tfsAllocDisk(tsdbGetFidLevel(fid, &(pCommith->rtn)), &(did.level), &(did.id));
+  tfsAllocDisk(tsdbGetFSetTierLevel(pRepo, fid, &(pCommith->rtn)), &(did.level), &(did.id));
   if (did.level == TFS_UNDECIDED_LEVEL) {
     terrno = TSDB_CODE_TDB_NO_AVAIL_DISK;
     return -1;
@@ -1550,10 +2098,14 @@ static int tsdbSetAndOpenCommitFile(SCommitH *pCommith, SDFileSet *pSet, int fid
       return -1;
     }
 
+    // The blocks kept from the FSET are only summarized by its summary, the new FSET has no summary if it fails to load
+    tsdbLoadFSetSum(&(pCommith->readh), &(pCommith->fsetSum));
+
     tsdbDebug("vgId:%d FSET %d at level %d disk id %d is opened to read to commit", REPO_ID(pRepo), TSDB_FSET_FID(pSet),
               TSDB_FSET_LEVEL(pSet), TSDB_FSET_ID(pSet));
   } else {
     pCommith->isRFileSet = false;
+    tsdbResetFSetSum(&(pCommith->fsetSum));
   }
 
   // Set and open commit FSET
@@ -1718,6 +2270,11 @@ static int tsdbSetAndOpenCommitFile(SCommitH *pCommith, SDFileSet *pSet, int fid
     }
   }
 
+  // the blocks read from the data or last file replaced by the FSET written are dropped from the page cache, the
+  // files kept are still read by the queries
+  pCommith->readh.dropDataCache = pCommith->isRFileSet && !pCommith->isDFileSame;
+  pCommith->readh.dropLastCache = pCommith->isRFileSet && !pCommith->isLFileSame;
+
   return 0;
 }
 
@@ -1727,6 +2284,7 @@ static void tsdbCloseCommitFile(SCommitH *pCommith, bool hasError) {
   }
 
   if (!hasError) {
+    tsdbWriteBackDFileSet(TSDB_COMMIT_WRITE_FSET(pCommith));
     TSDB_FSET_FSYNC(TSDB_COMMIT_WRITE_FSET(pCommith));
   }
   tsdbCloseDFileSet(TSDB_COMMIT_WRITE_FSET(pCommith));
@@ -1774,3 +2332,107 @@ int tsdbApplyRtn(STsdbRepo *pRepo) {
 
   return 0;
 }
+
+static void tsdbProfBlockWritten(SCommitProf *pProf, STable *pTable, SBlock *pBlock) {
+  pProf->bytesWritten += pBlock->len;
+  if (!pBlock->last) return;
+
+  pProf->lastWritten += pBlock->len;
+  if (pProf->pTable != pTable) {
+    pProf->pTable = pTable;
+    pProf->tableLast = 0;
+  }
+  pProf->tableLast += pBlock->len;
+  if (pProf->tableLast > pProf->lastTableMax) {
+    pProf->pLastTable = pTable;
+    pProf->lastTableMax = pProf->tableLast;
+  }
+}
+
+static void tsdbAddCommitProf(SCommitProf *pProf, SCommitProf *pWorkerProf) {
+  pProf->iterUs += pWorkerProf->iterUs;
+  pProf->loadUs += pWorkerProf->loadUs;
+  pProf->encodeUs += pWorkerProf->encodeUs;
+  pProf->writeUs += pWorkerProf->writeUs;
+  pProf->bytesRead += pWorkerProf->bytesRead;
+  for (int i = 0; i < TSDB_COMMIT_PROF_TYPES; i++) {
+    pProf->typeUs[i] += pWorkerProf->typeUs[i];
+    pProf->typeBytesIn[i] += pWorkerProf->typeBytesIn[i];
+    pProf->typeBytesOut[i] += pWorkerProf->typeBytesOut[i];
+  }
+  // the blocks of the workers are written by the commit handle, so bytesWritten and lastWritten are counted there
+
+  memset(pWorkerProf, 0, sizeof(*pWorkerProf));
+}
+
+// Bytes the rows take in the buffer blocks of a memtable
+static int64_t tsdbMemTableBytes(SMemTable *pMem) {
+  SListIter      iter;
+  SListNode *    pNode;
+  STsdbBufBlock *pBufBlock;
+  int64_t        bytes = 0;
+
+  tdListInitIter(pMem->bufBlockList, &iter, TD_LIST_FORWARD);
+  while ((pNode = tdListNext(&iter)) != NULL) {
+    tdListNodeGetData(pMem->bufBlockList, pNode, (void *)(&pBufBlock));
+    bytes += pBufBlock->offset;
+  }
+
+  return bytes;
+}
+
+static void tsdbEndCommitProf(STsdbRepo *pRepo, SCommitProf *pProf, int64_t startUs) {
+  STsdbCommitStat *pStat = &(pRepo->commitStat);
+  SMemTable *      pMem = pRepo->imem;
+  int64_t          totalUs = taosGetTimestampUs() - startUs;
+  int64_t          bytesIn = tsdbMemTableBytes(pMem);
+  char             buf[512];
+  int              len = 0;
+
+  atomic_add_fetch_64(&(pStat->commits), 1);
+  atomic_add_fetch_64(&(pStat->rows), pMem->numOfRows);
+  atomic_add_fetch_64(&(pStat->bytesIn), bytesIn);
+  atomic_add_fetch_64(&(pStat->bytesRead), pProf->bytesRead);
+  atomic_add_fetch_64(&(pStat->bytesWritten), pProf->bytesWritten);
+  atomic_add_fetch_64(&(pStat->lastWritten), pProf->lastWritten);
+  atomic_add_fetch_64(&(pStat->totalUs), totalUs);
+  atomic_add_fetch_64(&(pStat->iterUs), pProf->iterUs);
+  atomic_add_fetch_64(&(pStat->loadUs), pProf->loadUs);
+  atomic_add_fetch_64(&(pStat->encodeUs), pProf->encodeUs);
+  atomic_add_fetch_64(&(pStat->writeUs), pProf->writeUs);
+  atomic_add_fetch_64(&(pStat->fsyncUs), pProf->fsyncUs);
+
+  tsdbInfo("vgId:%d %" PRId64 " rows of %" PRId64 " bytes are committed in %" PRId64 " us, %" PRId64
+           " bytes read, %" PRId64 " bytes written, %" PRId64 " bytes to the .last files, write amplification %.2f, "
+           "iter %" PRId64 " us, load %" PRId64 " us, encode %" PRId64 " us, write %" PRId64 " us, fsync %" PRId64
+           " us",
+           REPO_ID(pRepo), pMem->numOfRows, bytesIn, totalUs, pProf->bytesRead, pProf->bytesWritten,
+           pProf->lastWritten, (bytesIn > 0) ? (double)pProf->bytesWritten / bytesIn : 0.0, pProf->iterUs,
+           pProf->loadUs, pProf->encodeUs, pProf->writeUs, pProf->fsyncUs);
+
+  for (int i = 0; i < TSDB_COMMIT_PROF_TYPES && len < sizeof(buf) - 64; i++) {
+    if (pProf->typeBytesIn[i] == 0) continue;
+    len += snprintf(buf + len, sizeof(buf) - len, " %s %" PRId64 "/%" PRId64 " %" PRId64 "us", tDataTypes[i].name,
+                    pProf->typeBytesOut[i], pProf->typeBytesIn[i], pProf->typeUs[i]);
+  }
+  if (len > 0) {
+    tsdbDebug("vgId:%d compression by column type:%s", REPO_ID(pRepo), buf);
+  }
+}
+
+void tsdbGetCommitStat(STsdbRepo *repo, STsdbCommitStat *pStat) {
+  STsdbCommitStat *pCommitStat = &(repo->commitStat);
+
+  pStat->commits = atomic_load_64(&(pCommitStat->commits));
+  pStat->rows = atomic_load_64(&(pCommitStat->rows));
+  pStat->bytesIn = atomic_load_64(&(pCommitStat->bytesIn));
+  pStat->bytesRead = atomic_load_64(&(pCommitStat->bytesRead));
+  pStat->bytesWritten = atomic_load_64(&(pCommitStat->bytesWritten));
+  pStat->lastWritten = atomic_load_64(&(pCommitStat->lastWritten));
+  pStat->totalUs = atomic_load_64(&(pCommitStat->totalUs));
+  pStat->iterUs = atomic_load_64(&(pCommitStat->iterUs));
+  pStat->loadUs = atomic_load_64(&(pCommitStat->loadUs));
+  pStat->encodeUs = atomic_load_64(&(pCommitStat->encodeUs));
+  pStat->writeUs = atomic_load_64(&(pCommitStat->writeUs));
+  pStat->fsyncUs = atomic_load_64(&(pCommitStat->fsyncUs));
+}
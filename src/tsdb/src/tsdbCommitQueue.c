@@ -23,6 +23,8 @@ typedef struct {
   int             refCount;
   SList *         queue;
   pthread_t *     threads;
+  int             nworkers;
+  void *          workers;  // scheduler to run the table commit tasks of a file set
 } SCommitQueue;
 
 typedef struct {
@@ -63,6 +65,15 @@ int tsdbInitCommitQueue() {
     pthread_create(pQueue->threads + i, NULL, tsdbLoopCommit, NULL);
   }
 
+  if (tsNumOfCommitWorkers > 0) {
+    pQueue->workers = taosInitScheduler(tsNumOfCommitWorkers * nthreads, tsNumOfCommitWorkers, "tsdbCommitW");
+    if (pQueue->workers == NULL) {
+      tsdbWarn("failed to create commit workers, tables are committed serially");
+    } else {
+      pQueue->nworkers = tsNumOfCommitWorkers;
+    }
+  }
+
   return 0;
 }
 
@@ -85,6 +96,12 @@ void tsdbDestroyCommitQueue() {
     pthread_join(pQueue->threads[i], NULL);
   }
 
+  if (pQueue->workers != NULL) {
+    taosCleanUpScheduler(pQueue->workers);
+    pQueue->workers = NULL;
+    pQueue->nworkers = 0;
+  }
+
   free(pQueue->threads);
   tdListFree(pQueue->queue);
   pthread_cond_destroy(&(pQueue->queueNotEmpty));
@@ -114,6 +131,17 @@ int tsdbScheduleCommit(STsdbRepo *pRepo, TSDB_REQ_T req) {
   return 0;
 }
 
+int tsdbCommitWorkers() { return tsCommitQueue.nworkers; }
+
+void tsdbScheduleCommitWork(void (*fp)(SSchedMsg *), void *ahandle, void *param) {
+  SSchedMsg msg = {0};
+
+  msg.fp = fp;
+  msg.ahandle = ahandle;
+  msg.thandle = param;
+  taosScheduleTask(tsCommitQueue.workers, &msg);
+}
+
 static void tsdbApplyRepoConfig(STsdbRepo *pRepo) {
   pthread_mutex_lock(&pRepo->save_mutex);
 
@@ -192,6 +220,8 @@ static void *tsdbLoopCommit(void *arg) {
       ASSERT(pRepo->config_changed);
       tsdbApplyRepoConfig(pRepo);
       tsem_post(&(pRepo->readyToCommit));
+    } else if (req == MIGRATE_REQ) {
+      tsdbTierMigrateImpl(pRepo);
     } else {
       ASSERT(0);
     }
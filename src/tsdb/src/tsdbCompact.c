@@ -12,7 +12,9 @@
  * You should have received a copy of the GNU Affero General Public License
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
+#include "tglobal.h"
 #include "tsdbint.h"
+#include "tsdbHealth.h"
 
 typedef struct {
   STable *    pTable;
@@ -30,8 +32,30 @@ typedef struct {
   SArray *   aBlkIdx;
   SArray *   aSupBlk;
   SDataCols *pDataCols;
+  SFSetSum   fsetSum;  // summary of the blocks written to wSet
+  SArray *   aAutoFid;  // the fileset compacted by a background compaction, NULL when the operator compacts all
+  bool       cancelled;  // a background compaction stops for the ingest
+  int64_t    ioStart;    // ms, start of a background compaction
+  int64_t    ioBytes;    // bytes read and written by a background compaction
 } SCompactH;
 
+typedef struct {
+  int     nBlocks;       // total blocks
+  int     nSubBlocks;    // # of blocks with sub-blocks
+  int     nSmallBlocks;  // # of blocks with rows < defaultRows
+  int     nExtraSmall;   // # of small blocks beyond one per table, which compaction merges
+  int64_t liveSize;      // size of the blocks in data and last files
+  int64_t fileSize;      // size of data and last files without headers
+} SFSetFragStat;
+
+typedef struct {
+  int    fid;
+  double score;
+} SAutoCompactFSet;
+
+#define TSDB_AUTO_COMPACT_MIN_SCORE 1.0
+#define TSDB_AUTO_COMPACT_SLEEP_MS 100
+
 #define TSDB_COMPACT_WSET(pComph) (&((pComph)->wSet))
 #define TSDB_COMPACT_REPO(pComph) TSDB_READ_REPO(&((pComph)->readh))
 #define TSDB_COMPACT_HEAD_FILE(pComph) TSDB_DFILE_IN_SET(TSDB_COMPACT_WSET(pComph), TSDB_FILE_HEAD)
@@ -50,6 +74,11 @@ static int  tsdbCompactMeta(STsdbRepo *pRepo);
 static int  tsdbCompactTSData(STsdbRepo *pRepo);
 static int  tsdbCompactFSet(SCompactH *pComph, SDFileSet *pSet);
 static bool tsdbShouldCompact(SCompactH *pComph);
+static void tsdbGetFSetFragStat(SCompactH *pComph, SFSetFragStat *pStat);
+static double tsdbGetFSetFragScore(const SFSetFragStat *pStat);
+static int  tsdbPickAutoCompactFSets(SCompactH *pComph);
+static bool tsdbIsAutoCompactFSet(SCompactH *pComph, int fid);
+static int  tsdbThrottleAutoCompact(SCompactH *pComph);
 static int  tsdbInitCompactH(SCompactH *pComph, STsdbRepo *pRepo);
 static void tsdbDestroyCompactH(SCompactH *pComph);
 static int  tsdbInitCompTbArray(SCompactH *pComph);
@@ -61,13 +90,17 @@ static int  tsdbCompactFSetImpl(SCompactH *pComph);
 static int  tsdbWriteBlockToRightFile(SCompactH *pComph, STable *pTable, SDataCols *pDataCols, void **ppBuf,
                                       void **ppCBuf, void **ppExBuf);
 
-enum { TSDB_NO_COMPACT, TSDB_IN_COMPACT, TSDB_WAITING_COMPACT};
 int tsdbCompact(STsdbRepo *pRepo) { return tsdbAsyncCompact(pRepo); }
 
+static FORCE_INLINE bool tsdbHasAutoCompactFSets(STsdbRepo *pRepo) {
+  return pRepo->autoCompactFSets != NULL && taosArrayGetSize(pRepo->autoCompactFSets) > 0;
+}
+
 void *tsdbCompactImpl(STsdbRepo *pRepo) {
   // Check if there are files in TSDB FS to compact
   if (REPO_FS(pRepo)->cstatus->pmf == NULL) {
-    pRepo->compactState = TSDB_NO_COMPACT;
+    atomic_store_8(&pRepo->compactState, TSDB_NO_COMPACT);
+    pRepo->autoCompact = false;
     tsem_post(&(pRepo->readyToCommit));
     tsdbInfo("vgId:%d compact over, no file to compact in FS", REPO_ID(pRepo));
     return NULL;
@@ -95,21 +128,51 @@ _err:
 }
 
 static int tsdbAsyncCompact(STsdbRepo *pRepo) {
-  if (pRepo->compactState != TSDB_NO_COMPACT) {
+  if (atomic_val_compare_exchange_8(&pRepo->compactState, TSDB_NO_COMPACT, TSDB_WAITING_COMPACT) != TSDB_NO_COMPACT) {
     tsdbInfo("vgId:%d not compact tsdb again ", REPO_ID(pRepo));
     return 0; 
   } 
-  pRepo->compactState = TSDB_WAITING_COMPACT;   
   tsem_wait(&(pRepo->readyToCommit));
+  pRepo->autoCompact = false;
+  // the operator compacts all filesets, those left by a background compaction included
+  if (pRepo->autoCompactFSets != NULL) taosArrayClear(pRepo->autoCompactFSets);
   return tsdbScheduleCommit(pRepo, COMPACT_REQ);
 }
 
+bool tsdbScheduleAutoCompact(STsdbRepo *pRepo) {
+  int64_t now = taosGetTimestampMs();
+  bool    resume = tsdbHasAutoCompactFSets(pRepo);
+
+  // the filesets left by the last background compaction are compacted after the next commits, one each time
+  if (tsdbAutoCompactInterval <= 0 || pRepo->stopAutoCompact ||
+      (!resume && now - pRepo->lastAutoCompact < (int64_t)tsdbAutoCompactInterval * 1000) ||
+      tsdbIngestUnderPressure(pRepo)) {
+    return false;
+  }
+
+  if (atomic_val_compare_exchange_8(&pRepo->compactState, TSDB_NO_COMPACT, TSDB_WAITING_COMPACT) != TSDB_NO_COMPACT) {
+    return false;
+  }
+
+  if (!resume) pRepo->lastAutoCompact = now;
+  pRepo->autoCompact = true;
+  if (tsdbScheduleCommit(pRepo, COMPACT_REQ) < 0) {
+    tsdbWarn("vgId:%d failed to schedule background compaction since %s", REPO_ID(pRepo), tstrerror(terrno));
+    pRepo->autoCompact = false;
+    atomic_store_8(&pRepo->compactState, TSDB_NO_COMPACT);
+    return false;
+  }
+
+  tsdbDebug("vgId:%d background compaction is scheduled", REPO_ID(pRepo));
+  return true;
+}
+
 static void tsdbStartCompact(STsdbRepo *pRepo) {
-  assert(pRepo->compactState != TSDB_IN_COMPACT);
+  assert(atomic_load_8(&pRepo->compactState) != TSDB_IN_COMPACT);
   tsdbInfo("vgId:%d start to compact!", REPO_ID(pRepo));
   tsdbStartFSTxn(pRepo, 0, 0);
   pRepo->code = TSDB_CODE_SUCCESS;
-  pRepo->compactState = TSDB_IN_COMPACT;
+  atomic_store_8(&pRepo->compactState, TSDB_IN_COMPACT);
 }
 
 static void tsdbEndCompact(STsdbRepo *pRepo, int eno) {
@@ -118,7 +181,8 @@ static void tsdbEndCompact(STsdbRepo *pRepo, int eno) {
   } else {
     tsdbEndFSTxn(pRepo);
   }
-  pRepo->compactState = TSDB_NO_COMPACT;
+  atomic_store_8(&pRepo->compactState, TSDB_NO_COMPACT);
+  pRepo->autoCompact = false;
   tsdbInfo("vgId:%d compact over, %s", REPO_ID(pRepo), (eno == TSDB_CODE_SUCCESS) ? "succeed" : "failed");
   tsem_post(&(pRepo->readyToCommit));
 }
@@ -145,6 +209,26 @@ static int tsdbCompactMeta(STsdbRepo *pRepo) {
       return -1;
     }
 
+    // A background compaction compacts one fileset in each FS transaction so that it holds readyToCommit no longer
+    if (pRepo->autoCompact) {
+      compactH.ioStart = taosGetTimestampMs();
+      if (!tsdbHasAutoCompactFSets(pRepo) && tsdbPickAutoCompactFSets(&compactH) < 0) {
+        tsdbDestroyCompactH(&compactH);
+        return -1;
+      }
+
+      compactH.aAutoFid = taosArrayInit(1, sizeof(SAutoCompactFSet));
+      if (compactH.aAutoFid == NULL) {
+        terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+        tsdbDestroyCompactH(&compactH);
+        return -1;
+      }
+      if (!compactH.cancelled && tsdbHasAutoCompactFSets(pRepo)) {
+        taosArrayPush(compactH.aAutoFid, taosArrayGet(pRepo->autoCompactFSets, 0));
+        taosArrayRemove(pRepo->autoCompactFSets, 0);
+      }
+    }
+
     while ((pSet = tsdbFSIterNext(&(compactH.fsIter)))) {
       // Remove those expired files
       if (pSet->fid < compactH.rtn.minFid) {
@@ -159,11 +243,30 @@ static int tsdbCompactMeta(STsdbRepo *pRepo) {
         continue;
       }
 
+      // Keep the filesets not picked by a background compaction, or all the rest once it stops for the ingest
+      if (compactH.aAutoFid != NULL && !compactH.cancelled && tsdbIngestUnderPressure(pRepo)) {
+        tsdbInfo("vgId:%d background compaction stops before FSET %d for the ingest", REPO_ID(pRepo), pSet->fid);
+        compactH.cancelled = true;
+      }
+      if (compactH.aAutoFid != NULL && (compactH.cancelled || !tsdbIsAutoCompactFSet(&compactH, pSet->fid))) {
+        if (tsdbApplyRtnOnFSet(pRepo, pSet, &(compactH.rtn)) < 0) {
+          tsdbDestroyCompactH(&compactH);
+          return -1;
+        }
+        continue;
+      }
+
       if (tsdbCompactFSet(&compactH, pSet) < 0) {
         tsdbDestroyCompactH(&compactH);
         tsdbError("vgId:%d failed to compact FSET %d since %s", REPO_ID(pRepo), pSet->fid, tstrerror(terrno));
         return -1;
       }
+      if (compactH.aAutoFid != NULL && !compactH.cancelled) taosArrayClear(compactH.aAutoFid);
+    }
+
+    // The fileset not compacted for the ingest is compacted after the next commit
+    if (compactH.cancelled && !pRepo->stopAutoCompact && taosArrayGetSize(compactH.aAutoFid) > 0) {
+      taosArrayInsert(pRepo->autoCompactFSets, 0, taosArrayGet(compactH.aAutoFid, 0));
     }
 
     tsdbDestroyCompactH(&compactH);
@@ -182,7 +285,7 @@ static int tsdbCompactMeta(STsdbRepo *pRepo) {
       return -1;
     }
 
-    if (!tsdbShouldCompact(pComph)) {
+    if (pComph->aAutoFid == NULL && !tsdbShouldCompact(pComph)) {
       tsdbDebug("vgId:%d no need to compact FSET %d", REPO_ID(pRepo), pSet->fid);
       if (tsdbApplyRtnOnFSet(TSDB_COMPACT_REPO(pComph), pSet, &(pComph->rtn)) < 0) {
         tsdbCompactFSetEnd(pComph);
@@ -190,7 +293,7 @@ static int tsdbCompactMeta(STsdbRepo *pRepo) {
       }
     } else {
       // Create new fset as compacted fset
-      tfsAllocDisk(tsdbGetFidLevel(pSet->fid, &(pComph->rtn)), &(did.level), &(did.id));
+      tfsAllocDisk(tsdbGetFSetTierLevel(pRepo, pSet->fid, &(pComph->rtn)), &(did.level), &(did.id));
       if (did.level == TFS_UNDECIDED_LEVEL) {
         terrno = TSDB_CODE_TDB_NO_AVAIL_DISK;
         tsdbError("vgId:%d failed to compact FSET %d since %s", REPO_ID(pRepo), pSet->fid, tstrerror(terrno));
@@ -210,11 +313,19 @@ static int tsdbCompactMeta(STsdbRepo *pRepo) {
         tsdbCloseDFileSet(TSDB_COMPACT_WSET(pComph));
         tsdbRemoveDFileSet(TSDB_COMPACT_WSET(pComph));
         tsdbCompactFSetEnd(pComph);
+        if (pComph->cancelled) {
+          // Keep the fileset as it is
+          tsdbInfo("vgId:%d background compaction of FSET %d stops for the ingest", REPO_ID(pRepo), pSet->fid);
+          return tsdbApplyRtnOnFSet(pRepo, pSet, &(pComph->rtn));
+        }
         return -1;
       }
 
+      tsdbWriteBackDFileSet(TSDB_COMPACT_WSET(pComph));
       tsdbCloseDFileSet(TSDB_COMPACT_WSET(pComph));
       tsdbUpdateDFileSet(REPO_FS(pRepo), TSDB_COMPACT_WSET(pComph));
+      // the compacted FSET is retired, the queries read the new one
+      tsdbDropDFileSetCache(TSDB_READ_FSET(&(pComph->readh)));
       tsdbDebug("vgId:%d FSET %d compact over", REPO_ID(pRepo), pSet->fid);
     }
 
@@ -226,6 +337,14 @@ static int tsdbCompactMeta(STsdbRepo *pRepo) {
     if (tsdbForceCompactFile) {
       return true;
     }
+    SFSetFragStat stat;
+
+    tsdbGetFSetFragStat(pComph, &stat);
+    return (((stat.nSubBlocks * 1.0 / stat.nBlocks) > 0.33) || ((stat.nSmallBlocks * 1.0 / stat.nBlocks) > 0.33) ||
+            (stat.liveSize * 1.0 / stat.fileSize < 0.85));
+  }
+
+  static void tsdbGetFSetFragStat(SCompactH *pComph, SFSetFragStat *pStat) {
     STsdbRepo *     pRepo = TSDB_COMPACT_REPO(pComph);
     STsdbCfg *      pCfg = REPO_CFG(pRepo);
     SReadH *        pReadh = &(pComph->readh);
@@ -235,18 +354,16 @@ static int tsdbCompactMeta(STsdbRepo *pRepo) {
     SDFile *        pDataF = TSDB_READ_DATA_FILE(pReadh);
     SDFile *        pLastF = TSDB_READ_LAST_FILE(pReadh);
 
-    int     tblocks = 0;       // total blocks
-    int     nSubBlocks = 0;    // # of blocks with sub-blocks
-    int     nSmallBlocks = 0;  // # of blocks with rows < defaultRows
-    int64_t tsize = 0;
+    memset(pStat, 0, sizeof(*pStat));
 
     for (size_t i = 0; i < taosArrayGetSize(pComph->tbArray); i++) {
       pTh = (STableCompactH *)taosArrayGet(pComph->tbArray, i);
 
       if (pTh->pTable == NULL || pTh->pBlkIdx == NULL) continue;
 
+      int nSmallBlocks = 0;
       for (size_t bidx = 0; bidx < pTh->pBlkIdx->numOfBlocks; bidx++) {
-        tblocks++;
+        pStat->nBlocks++;
         pBlock = pTh->pInfo->blocks + bidx;
 
         if (pBlock->numOfRows < defaultRows) {
@@ -254,21 +371,136 @@ static int tsdbCompactMeta(STsdbRepo *pRepo) {
         }
 
         if (pBlock->numOfSubBlocks > 1) {
-          nSubBlocks++;
+          pStat->nSubBlocks++;
           for (int k = 0; k < pBlock->numOfSubBlocks; k++) {
             SBlock *iBlock = ((SBlock *)POINTER_SHIFT(pTh->pInfo, pBlock->offset)) + k;
-            tsize = tsize + iBlock->len;
+            pStat->liveSize += iBlock->len;
           }
         } else if (pBlock->numOfSubBlocks == 1) {
-          tsize += pBlock->len;
+          pStat->liveSize += pBlock->len;
         } else {
           ASSERT(0);
         }
       }
+
+      pStat->nSmallBlocks += nSmallBlocks;
+      if (nSmallBlocks > 1) pStat->nExtraSmall += nSmallBlocks - 1;
     }
 
-    return (((nSubBlocks * 1.0 / tblocks) > 0.33) || ((nSmallBlocks * 1.0 / tblocks) > 0.33) ||
-            (tsize * 1.0 / (pDataF->info.size + pLastF->info.size - 2 * TSDB_FILE_HEAD_SIZE) < 0.85));
+    pStat->fileSize = pDataF->info.size + pLastF->info.size - 2 * TSDB_FILE_HEAD_SIZE;
+  }
+
+  // A fileset scores 1 when it is as fragmented as tsdbShouldCompact allows, counting only what compaction fixes: the
+  // sub-blocks, the small blocks of a table merged into one and the dead space in the data and last files
+  static double tsdbGetFSetFragScore(const SFSetFragStat *pStat) {
+    double score = 0;
+    double s;
+
+    if (pStat->nBlocks == 0) return 0;
+
+    s = pStat->nSubBlocks * 1.0 / pStat->nBlocks / 0.33;
+    if (s > score) score = s;
+    s = pStat->nExtraSmall * 1.0 / pStat->nBlocks / 0.33;
+    if (s > score) score = s;
+    if (pStat->fileSize > 0) {
+      s = (1.0 - pStat->liveSize * 1.0 / pStat->fileSize) / 0.15;
+      if (s > score) score = s;
+    }
+
+    return score;
+  }
+
+  static int tsdbCompareAutoCompactFSet(const void *a, const void *b) {
+    double sa = ((const SAutoCompactFSet *)a)->score;
+    double sb = ((const SAutoCompactFSet *)b)->score;
+    if (sa > sb) return -1;
+    if (sa < sb) return 1;
+    return 0;
+  }
+
+  // Score the filesets and keep the most fragmented ones in pRepo->autoCompactFSets, the block indexes read to score
+  // them are within tsdbAutoCompactIOBudget as well
+  static int tsdbPickAutoCompactFSets(SCompactH *pComph) {
+    STsdbRepo *   pRepo = TSDB_COMPACT_REPO(pComph);
+    SFSIter       fsIter;
+    SDFileSet *   pSet;
+    SFSetFragStat stat;
+
+    if (pRepo->autoCompactFSets == NULL) {
+      pRepo->autoCompactFSets = taosArrayInit(16, sizeof(SAutoCompactFSet));
+      if (pRepo->autoCompactFSets == NULL) {
+        terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+        return -1;
+      }
+    }
+
+    tsdbFSIterInit(&fsIter, REPO_FS(pRepo), TSDB_FS_ITER_FORWARD);
+    while ((pSet = tsdbFSIterNext(&fsIter))) {
+      if (pSet->fid < pComph->rtn.minFid || TSDB_FSET_LEVEL(pSet) == TFS_MAX_LEVEL) continue;
+
+      if (tsdbThrottleAutoCompact(pComph) < 0) {
+        tsdbInfo("vgId:%d background compaction stops picking filesets for the ingest", REPO_ID(pRepo));
+        taosArrayClear(pRepo->autoCompactFSets);
+        return 0;
+      }
+
+      if (tsdbCompactFSetInit(pComph, pSet) < 0) return -1;
+      pComph->ioBytes += TSDB_READ_HEAD_FILE(&(pComph->readh))->info.size;
+      tsdbGetFSetFragStat(pComph, &stat);
+      tsdbCompactFSetEnd(pComph);
+
+      SAutoCompactFSet fset = {.fid = pSet->fid, .score = tsdbGetFSetFragScore(&stat)};
+      tsdbDebug("vgId:%d FSET %d fragmentation score %.2f, blocks %d sub-blocks %d small blocks %d live %" PRId64
+                " of %" PRId64 " bytes",
+                REPO_ID(pRepo), fset.fid, fset.score, stat.nBlocks, stat.nSubBlocks, stat.nSmallBlocks, stat.liveSize,
+                stat.fileSize);
+      if (fset.score < TSDB_AUTO_COMPACT_MIN_SCORE) continue;
+
+      if (taosArrayPush(pRepo->autoCompactFSets, &fset) == NULL) {
+        terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+        return -1;
+      }
+    }
+
+    taosArraySort(pRepo->autoCompactFSets, tsdbCompareAutoCompactFSet);
+    if (taosArrayGetSize(pRepo->autoCompactFSets) > tsdbAutoCompactFSets) {
+      taosArraySetSize(pRepo->autoCompactFSets, tsdbAutoCompactFSets);
+    }
+
+    for (size_t i = 0; i < taosArrayGetSize(pRepo->autoCompactFSets); i++) {
+      SAutoCompactFSet *pFSet = (SAutoCompactFSet *)taosArrayGet(pRepo->autoCompactFSets, i);
+      tsdbInfo("vgId:%d background compaction picks FSET %d with fragmentation score %.2f", REPO_ID(pRepo), pFSet->fid,
+               pFSet->score);
+    }
+
+    return 0;
+  }
+
+  static bool tsdbIsAutoCompactFSet(SCompactH *pComph, int fid) {
+    for (size_t i = 0; i < taosArrayGetSize(pComph->aAutoFid); i++) {
+      if (((SAutoCompactFSet *)taosArrayGet(pComph->aAutoFid, i))->fid == fid) return true;
+    }
+    return false;
+  }
+
+  // Stop a background compaction for the ingest or the repo closing, and keep its I/O within tsdbAutoCompactIOBudget
+  static int tsdbThrottleAutoCompact(SCompactH *pComph) {
+    STsdbRepo *pRepo = TSDB_COMPACT_REPO(pComph);
+
+    while (true) {
+      if (pRepo->stopAutoCompact || tsdbIngestUnderPressure(pRepo)) {
+        pComph->cancelled = true;
+        return -1;
+      }
+
+      if (tsdbAutoCompactIOBudget <= 0) return 0;
+
+      int64_t expected = pComph->ioBytes * 1000 / ((int64_t)tsdbAutoCompactIOBudget * 1024 * 1024);
+      int64_t elapsed = taosGetTimestampMs() - pComph->ioStart;
+      if (elapsed >= expected) return 0;
+
+      taosMsleep((int32_t)MIN(expected - elapsed, TSDB_AUTO_COMPACT_SLEEP_MS));
+    }
   }
 
   static int tsdbInitCompactH(SCompactH *pComph, STsdbRepo *pRepo) {
@@ -311,10 +543,17 @@ static int tsdbCompactMeta(STsdbRepo *pRepo) {
       return -1;
     }
 
+    if (tsdbInitFSetSum(&(pComph->fsetSum)) < 0) {
+      tsdbDestroyCompactH(pComph);
+      return -1;
+    }
+
     return 0;
   }
 
   static void tsdbDestroyCompactH(SCompactH *pComph) {
+    pComph->aAutoFid = taosArrayDestroy(&pComph->aAutoFid);
+    tsdbDestroyFSetSum(&(pComph->fsetSum));
     pComph->pDataCols = tdFreeDataCols(pComph->pDataCols);
     pComph->aSupBlk = taosArrayDestroy(&pComph->aSupBlk);
     pComph->aBlkIdx = taosArrayDestroy(&pComph->aBlkIdx);
@@ -405,6 +644,7 @@ static int tsdbCompactMeta(STsdbRepo *pRepo) {
   static int tsdbCompactFSetInit(SCompactH *pComph, SDFileSet *pSet) {
     taosArrayClear(pComph->aBlkIdx);
     taosArrayClear(pComph->aSupBlk);
+    tsdbResetFSetSum(&(pComph->fsetSum));
 
     if (tsdbSetAndOpenReadFSet(&(pComph->readh), pSet) < 0) {
       return -1;
@@ -438,6 +678,8 @@ static int tsdbCompactMeta(STsdbRepo *pRepo) {
 
       if (pTh->pTable == NULL || pTh->pBlkIdx == NULL) continue;
 
+      if (pComph->aAutoFid != NULL && tsdbThrottleAutoCompact(pComph) < 0) return -1;
+
       pSchema = tsdbGetTableSchemaImpl(pTh->pTable, true, true, -1, -1);
       taosArrayClear(pComph->aSupBlk);
       if ((tdInitDataCols(pComph->pDataCols, pSchema) < 0) || (tdInitDataCols(pReadh->pDCols[0], pSchema) < 0) ||
@@ -456,6 +698,7 @@ static int tsdbCompactMeta(STsdbRepo *pRepo) {
         if (tsdbLoadBlockData(pReadh, pBlock, pTh->pInfo) < 0) {
           return -1;
         }
+        pComph->ioBytes += pBlock->len;
 
         // Merge pComph->pDataCols and pReadh->pDCols[0] and write data to file
         if (pComph->pDataCols->numOfRows == 0 && pBlock->numOfRows >= defaultRows) {
@@ -503,6 +746,10 @@ static int tsdbCompactMeta(STsdbRepo *pRepo) {
       return -1;
     }
 
+    if (tsdbWriteFSetSum(TSDB_COMPACT_HEAD_FILE(pComph), &(pComph->fsetSum), ppBuf) < 0) {
+      return -1;
+    }
+
     return 0;
   }
 
@@ -530,10 +777,15 @@ static int tsdbCompactMeta(STsdbRepo *pRepo) {
       return -1;
     }
 
+    if (tsdbAddBlockToFSetSum(&(pComph->fsetSum), pTable, &block, *ppBuf, *ppExBuf) < 0) {
+      return -1;
+    }
+
     if (taosArrayPush(pComph->aSupBlk, (void *)(&block)) == NULL) {
       terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
       return -1;
     }
+    pComph->ioBytes += block.len;
 
     return 0;
   }
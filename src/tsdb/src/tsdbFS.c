@@ -395,6 +395,9 @@ int tsdbEndFSTxn(STsdbRepo *pRepo) {
   // Apply actual change to each file and SDFileSet
   tsdbApplyFSTxnOnDisk(pfs->nstatus, pfs->cstatus);
 
+  // Drop the cached blocks of the files replaced or removed
+  tsdbDropStaleBlockCache(pRepo);
+
   pfs->intxn = false;
   return 0;
 }
@@ -930,8 +933,9 @@ static int tsdbScanRootDir(STsdbRepo *pRepo) {
   while ((pf = tfsReaddir(tdir))) {
     tfsbasename(pf, bname);
 
-    if (strcmp(bname, tsdbTxnFname[TSDB_TXN_CURR_FILE]) == 0 || strcmp(bname, "data") == 0) {
-      // Skip current file and data directory
+    if (strcmp(bname, tsdbTxnFname[TSDB_TXN_CURR_FILE]) == 0 || strcmp(bname, "data") == 0 ||
+        strcmp(bname, TSDB_LAST_CACHE_FNAME) == 0) {
+      // Skip current file, data directory and last row cache file
       continue;
     }
 
@@ -13,6 +13,7 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include "tglobal.h"
 #include "tsdbint.h"
 
 static const char *TSDB_FNAME_SUFFIX[] = {
@@ -304,6 +305,7 @@ void tsdbInitDFile(SDFile *pDFile, SDiskID did, int vid, int fid, uint32_t ver,
   memset(&(pDFile->info), 0, sizeof(pDFile->info));
   pDFile->info.magic = TSDB_FILE_INIT_MAGIC;
   pDFile->info.fver = tsdbGetDFSVersion(ftype);
+  pDFile->wbSize = 0;
 
   tsdbGetFilename(vid, fid, ver, ftype, fname);
   tfsInitFile(&(pDFile->f), did.level, did.id, fname);
@@ -312,6 +314,7 @@ void tsdbInitDFile(SDFile *pDFile, SDiskID did, int vid, int fid, uint32_t ver,
 void tsdbInitDFileEx(SDFile *pDFile, SDFile *pODFile) {
   *pDFile = *pODFile;
   TSDB_FILE_SET_CLOSED(pDFile);
+  pDFile->wbSize = (int64_t)pODFile->info.size;
 }
 
 int tsdbEncodeSDFile(void **buf, SDFile *pDFile) {
@@ -327,6 +330,7 @@ void *tsdbDecodeSDFile(void *buf, SDFile *pDFile, uint32_t sfver) {
   buf = tsdbDecodeDFInfo(buf, &(pDFile->info), sfver);
   buf = tfsDecodeFile(buf, &(pDFile->f));
   TSDB_FILE_SET_CLOSED(pDFile);
+  pDFile->wbSize = (int64_t)pDFile->info.size;
 
   return buf;
 }
@@ -352,6 +356,20 @@ static void *tsdbDecodeSDFileEx(void *buf, SDFile *pDFile) {
   return buf;
 }
 
+// Write the bytes appended to pDFile since the last time back to the disk once they reach tsdbWriteBackSize, or with
+// force whatever they are, and drop them from the page cache. The final fsync reports the errors.
+void tsdbWriteBackDFile(SDFile *pDFile, bool force) {
+  int64_t size = (int64_t)pDFile->info.size;
+  int64_t nbyte = size - pDFile->wbSize;
+
+  if (tsdbWriteBackSize <= 0 || !TSDB_FILE_OPENED(pDFile) || nbyte <= 0) return;
+  if (!force && nbyte < (int64_t)tsdbWriteBackSize * 1024 * 1024) return;
+
+  taosWriteBack(pDFile->fd, pDFile->wbSize, nbyte);
+  taosDropCache(pDFile->fd, pDFile->wbSize, nbyte);
+  pDFile->wbSize = size;
+}
+
 int tsdbCreateDFile(SDFile *pDFile, bool updateHeader, TSDB_FILE_T fType) {
   ASSERT(pDFile->info.size == 0 && pDFile->info.magic == TSDB_FILE_INIT_MAGIC);
 
@@ -663,6 +681,21 @@ int tsdbCreateDFileSet(SDFileSet *pSet, bool updateHeader) {
   return 0;
 }
 
+void tsdbWriteBackDFileSet(SDFileSet *pSet) {
+  for (TSDB_FILE_T ftype = 0; ftype < tsdbGetNFiles(pSet); ftype++) {
+    tsdbWriteBackDFile(TSDB_DFILE_IN_SET(pSet, ftype), true);
+  }
+}
+
+void tsdbDropDFileSetCache(SDFileSet *pSet) {
+  if (tsdbWriteBackSize <= 0) return;
+
+  for (TSDB_FILE_T ftype = 0; ftype < tsdbGetNFiles(pSet); ftype++) {
+    SDFile *pDFile = TSDB_DFILE_IN_SET(pSet, ftype);
+    if (TSDB_FILE_OPENED(pDFile)) tsdbDropDFileCache(pDFile, 0, 0);
+  }
+}
+
 int tsdbUpdateDFileSetHeader(SDFileSet *pSet) {
   for (TSDB_FILE_T ftype = 0; ftype < tsdbGetNFiles(pSet); ftype++) {
     if (tsdbUpdateDFileHeader(TSDB_DFILE_IN_SET(pSet, ftype)) < 0) {
@@ -91,6 +91,25 @@ bool tsdbAllowNewBlock(STsdbRepo* pRepo) {
   return true;
 }
 
+// The memtable is half way to the commit threshold or the buffer pool is elastic, so a commit is coming soon
+bool tsdbIngestUnderPressure(STsdbRepo* pRepo) {
+  STsdbBufPool* pPool = pRepo->pPool;
+  bool          pressure = false;
+
+  if (pPool->nElasticBlocks > 0) return true;
+
+  if (tsdbLockRepo(pRepo) < 0) return true;
+  STsdbBufBlock* pBufBlock = tsdbGetCurrBufBlock(pRepo);
+  if (pBufBlock != NULL) {
+    int64_t threshold = (int64_t)(pRepo->config.totalBlocks / 3) * pPool->bufBlockSize;
+    int64_t used = (int64_t)listNEles(pRepo->mem->bufBlockList) * pPool->bufBlockSize - pBufBlock->remain;
+    pressure = (pRepo->mem->extraBuffList != NULL) || (used * 2 >= threshold);
+  }
+  tsdbUnlockRepo(pRepo);
+
+  return pressure;
+}
+
 bool tsdbNoProblem(STsdbRepo* pRepo) {
   if(listNEles(pRepo->pPool->bufBlockList) == 0) 
      return false;
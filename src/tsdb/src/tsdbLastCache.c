@@ -0,0 +1,484 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "tglobal.h"
+#include "tsdbint.h"
+
+#define TSDB_LAST_CACHE_HEAD_SIZE (sizeof(uint32_t) * 2)
+
+static void tsdbGetLastCacheFname(int repoid, bool temp, char fname[]);
+static void tsdbRefLastCacheMems(STsdbRepo *pRepo, SMemTable **ppMem, SMemTable **ppIMem);
+static bool tsdbTableHasMemData(SMemTable *pMem, STable *pTable);
+static int  tsdbEncodeLastCacheEntry(void **buf, STable *pTable);
+
+void tsdbInitLastCache(STsdbRepo *pRepo) {
+  SLastCache *pCache = &(pRepo->lastCache);
+
+  memset(pCache, 0, sizeof(*pCache));
+  pCache->maxSize = (int64_t)tsdbLastRowCacheSize * 1024 * 1024;
+}
+
+void tsdbGetLastCacheStat(STsdbRepo *repo, STsdbLastCacheStat *pStat) {
+  SLastCache *pCache = &(repo->lastCache);
+
+  pStat->size = atomic_load_64(&(pCache->size));
+  pStat->maxSize = pCache->maxSize;
+  pStat->hit = atomic_load_64(&(pCache->nHit));
+  pStat->miss = atomic_load_64(&(pCache->nMiss));
+  pStat->evicted = atomic_load_64(&(pCache->nEvicted));
+}
+
+// Must be called with the table write locked
+void tsdbUpdateLastCacheSize(STsdbRepo *pRepo, STable *pTable) {
+  int64_t size = 0;
+
+  if (!TSDB_LAST_CACHE_BOUNDED(pRepo)) return;
+
+  if (pTable->lastRow != NULL) {
+    size += taosTSizeof(pTable->lastRow);
+  }
+
+  if (pTable->lastCols != NULL) {
+    size += sizeof(SDataCol) * pTable->maxColNum;
+    for (int16_t i = 0; i < pTable->maxColNum; i++) {
+      size += pTable->lastCols[i].bytes;
+    }
+  }
+
+  atomic_add_fetch_64(&(pRepo->lastCache.size), size - pTable->lastCacheSize);
+  pTable->lastCacheSize = (int32_t)size;
+}
+
+// Pin the cached values of a table for a query so they are not evicted until tsdbUnpinLastCache
+void tsdbPinLastCache(STsdbRepo *pRepo, STable *pTable) {
+  if (!TSDB_LAST_CACHE_BOUNDED(pRepo)) return;
+
+  atomic_add_fetch_32(&(pTable->lastCachePins), 1);
+  atomic_store_8(&(pTable->lastCacheRef), 1);
+}
+
+void tsdbUnpinLastCache(STsdbRepo *pRepo, STable *pTable) {
+  if (!TSDB_LAST_CACHE_BOUNDED(pRepo)) return;
+
+  atomic_sub_fetch_32(&(pTable->lastCachePins), 1);
+}
+
+void tsdbTouchLastCache(STsdbRepo *pRepo, bool hit) {
+  SLastCache *pCache = &(pRepo->lastCache);
+
+  atomic_add_fetch_64(hit ? &(pCache->nHit) : &(pCache->nMiss), 1);
+}
+
+/**
+ * Evict tables from the last row cache until it is under the budget. It is only called by the write thread, which
+ * updates lastRow without holding the table lock.
+ */
+void tsdbEvictLastCache(STsdbRepo *pRepo) {
+  SLastCache *pCache = &(pRepo->lastCache);
+  STsdbMeta * pMeta = pRepo->tsdbMeta;
+  SMemTable * pMem = NULL;
+  SMemTable * pIMem = NULL;
+  int64_t     lowSize = pCache->maxSize - pCache->maxSize / 8;
+  int32_t     nEvicted = 0;
+
+  if (!TSDB_LAST_CACHE_BOUNDED(pRepo)) return;
+
+  // Do not sweep again if the last sweep is blocked by tables not committed, until the cache grows a step further
+  int64_t size = atomic_load_64(&(pCache->size));
+  if (size <= pCache->maxSize || size <= atomic_load_64(&(pCache->sweepSize)) + pCache->maxSize / 8) return;
+  if (atomic_val_compare_exchange_8(&(pCache->evicting), 0, 1) != 0) return;
+
+  tsdbRefLastCacheMems(pRepo, &pMem, &pIMem);
+  if (tsdbRLockRepoMeta(pRepo) < 0) {
+    tsdbUnRefMemTable(pRepo, pMem);
+    tsdbUnRefMemTable(pRepo, pIMem);
+    atomic_store_8(&(pCache->evicting), 0);
+    return;
+  }
+
+  // Evict down to a low water mark so a full cache is not swept by each insertion. A table referenced since the
+  // hand passed gets a second chance.
+  for (int n = 0; n < pMeta->maxTables * 2 && atomic_load_64(&(pCache->size)) > lowSize; n++) {
+    int32_t tid = (pCache->hand < pMeta->maxTables) ? pCache->hand : 0;
+    pCache->hand = tid + 1;
+
+    STable *pTable = pMeta->tables[tid];
+    if (pTable == NULL || pTable->lastCacheSize == 0) continue;
+    if (atomic_val_compare_exchange_8(&(pTable->lastCacheRef), 1, 0) == 1) continue;
+
+    // The cached values of a table with data not committed yet can not be loaded from files again
+    if (tsdbTableHasMemData(pMem, pTable) || tsdbTableHasMemData(pIMem, pTable)) continue;
+
+    TSDB_WLOCK_TABLE(pTable);
+    if (atomic_load_32(&(pTable->lastCachePins)) > 0) {
+      TSDB_WUNLOCK_TABLE(pTable);
+      continue;
+    }
+    taosTZfree(pTable->lastRow);
+    pTable->lastRow = NULL;
+    tsdbFreeLastColumns(pTable);
+    pTable->lastCacheEvicted = true;
+    tsdbUpdateLastCacheSize(pRepo, pTable);
+    TSDB_WUNLOCK_TABLE(pTable);
+
+    nEvicted++;
+  }
+
+  tsdbUnlockRepoMeta(pRepo);
+  tsdbUnRefMemTable(pRepo, pMem);
+  tsdbUnRefMemTable(pRepo, pIMem);
+
+  size = atomic_load_64(&(pCache->size));
+  atomic_store_64(&(pCache->sweepSize), (size > lowSize) ? size : 0);
+  atomic_add_fetch_64(&(pCache->nEvicted), nEvicted);
+  tsdbDebug("vgId:%d %d tables are evicted from last row cache, size %" PRId64 " max size %" PRId64, REPO_ID(pRepo),
+            nEvicted, size, pCache->maxSize);
+
+  atomic_store_8(&(pCache->evicting), 0);
+}
+
+/**
+ * Save the cached last rows and columns of the tables whose data are all in files, it is called after a commit is
+ * applied. An entry not matching the files after a crash is detected by its last key when it is restored.
+ */
+int tsdbSaveLastCache(STsdbRepo *pRepo) {
+  STsdbCfg * pCfg = REPO_CFG(pRepo);
+  STsdbMeta *pMeta = pRepo->tsdbMeta;
+  SMemTable *pMem = NULL;
+  SMemTable *pIMem = NULL;
+  void *     pBuf = NULL;
+  void *     ptr;
+  uint32_t   nTables = 0;
+  int        tlen = TSDB_LAST_CACHE_HEAD_SIZE;
+  char       tfname[TSDB_FILENAME_LEN] = "\0";
+  char       fname[TSDB_FILENAME_LEN] = "\0";
+
+  if (!TSDB_LAST_CACHE_SAVED(pRepo)) return 0;
+
+  // The committed tables can be evicted again
+  atomic_store_64(&(pRepo->lastCache.sweepSize), 0);
+
+  if (tsdbMakeRoom(&pBuf, tlen) < 0) return -1;
+
+  tsdbRefLastCacheMems(pRepo, &pMem, &pIMem);
+  if (tsdbRLockRepoMeta(pRepo) < 0) {
+    tsdbUnRefMemTable(pRepo, pMem);
+    tsdbUnRefMemTable(pRepo, pIMem);
+    taosTZfree(pBuf);
+    return -1;
+  }
+
+  for (int tid = 1; tid < pMeta->maxTables; tid++) {
+    STable *pTable = pMeta->tables[tid];
+
+    // Data in the memory table is not in files yet
+    if (pTable == NULL || pTable->lastCacheEvicted || tsdbTableHasMemData(pMem, pTable)) continue;
+
+    TSDB_RLOCK_TABLE(pTable);
+    if (pTable->cacheLastConfigVersion != pRepo->cacheLastConfigVersion ||
+        (CACHE_LAST_ROW(pCfg) && pTable->lastRow == NULL) ||
+        (CACHE_LAST_NULL_COLUMN(pCfg) && pTable->lastCols == NULL)) {
+      TSDB_RUNLOCK_TABLE(pTable);
+      continue;
+    }
+
+    int elen = tsdbEncodeLastCacheEntry(NULL, pTable);
+    if (tsdbMakeRoom(&pBuf, tlen + elen + sizeof(TSCKSUM)) < 0) {
+      TSDB_RUNLOCK_TABLE(pTable);
+      tsdbUnlockRepoMeta(pRepo);
+      tsdbUnRefMemTable(pRepo, pMem);
+      tsdbUnRefMemTable(pRepo, pIMem);
+      taosTZfree(pBuf);
+      return -1;
+    }
+
+    ptr = POINTER_SHIFT(pBuf, tlen);
+    tlen += tsdbEncodeLastCacheEntry(&ptr, pTable);
+    nTables++;
+    TSDB_RUNLOCK_TABLE(pTable);
+  }
+
+  tsdbUnlockRepoMeta(pRepo);
+  tsdbUnRefMemTable(pRepo, pMem);
+  tsdbUnRefMemTable(pRepo, pIMem);
+
+  if (tsdbMakeRoom(&pBuf, tlen + sizeof(TSCKSUM)) < 0) {
+    taosTZfree(pBuf);
+    return -1;
+  }
+
+  ptr = pBuf;
+  taosEncodeFixedU32(&ptr, TSDB_LAST_CACHE_VER);
+  taosEncodeFixedU32(&ptr, nTables);
+  tlen += sizeof(TSCKSUM);
+  taosCalcChecksumAppend(0, (uint8_t *)pBuf, tlen);
+
+  tsdbGetLastCacheFname(REPO_ID(pRepo), true, tfname);
+  tsdbGetLastCacheFname(REPO_ID(pRepo), false, fname);
+
+  int fd = open(tfname, O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0755);
+  if (fd < 0) {
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    taosTZfree(pBuf);
+    return -1;
+  }
+
+  if (taosWrite(fd, pBuf, tlen) < tlen || taosFsync(fd) < 0) {
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    close(fd);
+    (void)remove(tfname);
+    taosTZfree(pBuf);
+    return -1;
+  }
+
+  (void)close(fd);
+  (void)taosRename(tfname, fname);
+  taosTZfree(pBuf);
+
+  tsdbDebug("vgId:%d last row cache of %u tables is saved to %s, %d bytes", REPO_ID(pRepo), nTables, fname, tlen);
+
+  return 0;
+}
+
+void tsdbRemoveLastCacheFile(STsdbRepo *pRepo) {
+  char fname[TSDB_FILENAME_LEN] = "\0";
+
+  tsdbGetLastCacheFname(REPO_ID(pRepo), false, fname);
+  (void)remove(fname);
+}
+
+/**
+ * Load the cache saved by the last commit. A missing or corrupted file is not an error, the entries are left NULL
+ * and the tables are loaded from files on demand.
+ */
+int tsdbOpenLastCacheFile(STsdbRepo *pRepo, SLastCacheFile *pFile) {
+  STsdbMeta * pMeta = pRepo->tsdbMeta;
+  char        fname[TSDB_FILENAME_LEN] = "\0";
+  struct stat fstatus;
+  uint32_t    ver;
+  uint32_t    nTables;
+  void *      ptr;
+
+  memset(pFile, 0, sizeof(*pFile));
+
+  tsdbGetLastCacheFname(REPO_ID(pRepo), false, fname);
+  int fd = open(fname, O_RDONLY | O_BINARY);
+  if (fd < 0) return 0;
+
+  if (fstat(fd, &fstatus) < 0 || fstatus.st_size < (off_t)(TSDB_LAST_CACHE_HEAD_SIZE + sizeof(TSCKSUM))) {
+    tsdbWarn("vgId:%d last row cache file %s is ignored since it is invalid", REPO_ID(pRepo), fname);
+    close(fd);
+    return 0;
+  }
+
+  int tlen = (int)fstatus.st_size;
+  if (tsdbMakeRoom(&(pFile->pBuf), tlen) < 0) {
+    close(fd);
+    return -1;
+  }
+
+  if (taosRead(fd, pFile->pBuf, tlen) < tlen || !taosCheckChecksumWhole((uint8_t *)pFile->pBuf, tlen)) {
+    tsdbWarn("vgId:%d last row cache file %s is ignored since it is corrupted", REPO_ID(pRepo), fname);
+    close(fd);
+    tsdbCloseLastCacheFile(pFile);
+    return 0;
+  }
+  close(fd);
+
+  ptr = taosDecodeFixedU32(pFile->pBuf, &ver);
+  ptr = taosDecodeFixedU32(ptr, &nTables);
+  if (ver != TSDB_LAST_CACHE_VER) {
+    tsdbWarn("vgId:%d last row cache file %s is ignored since version %u", REPO_ID(pRepo), fname, ver);
+    tsdbCloseLastCacheFile(pFile);
+    return 0;
+  }
+
+  pFile->maxTables = pMeta->maxTables;
+  pFile->entries = (void **)calloc(pFile->maxTables, sizeof(void *));
+  if (pFile->entries == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    tsdbCloseLastCacheFile(pFile);
+    return -1;
+  }
+
+  for (uint32_t i = 0; i < nTables; i++) {
+    int32_t  tid;
+    uint32_t rowLen;
+    int16_t  nCols;
+    int32_t  bytes;
+    void *   pEntry = ptr;
+
+    ptr = taosDecodeFixedI32(ptr, &tid);
+    ptr = POINTER_SHIFT(ptr, sizeof(uint64_t) + sizeof(TSKEY));
+    ptr = taosDecodeFixedU32(ptr, &rowLen);
+    ptr = POINTER_SHIFT(ptr, rowLen + sizeof(int32_t));
+    ptr = taosDecodeFixedI16(ptr, &nCols);
+    for (int16_t j = 0; j < nCols; j++) {
+      ptr = POINTER_SHIFT(ptr, sizeof(int16_t));
+      ptr = taosDecodeFixedI32(ptr, &bytes);
+      ptr = POINTER_SHIFT(ptr, sizeof(TSKEY) + bytes);
+    }
+
+    if (tid > 0 && tid < pFile->maxTables) {
+      pFile->entries[tid] = pEntry;
+    }
+  }
+
+  tsdbDebug("vgId:%d last row cache of %u tables is loaded from %s", REPO_ID(pRepo), nTables, fname);
+
+  return 0;
+}
+
+void tsdbCloseLastCacheFile(SLastCacheFile *pFile) {
+  tfree(pFile->entries);
+  pFile->pBuf = taosTZfree(pFile->pBuf);
+  pFile->maxTables = 0;
+}
+
+/**
+ * Restore the cached values of a table from the saved entry, the entry is only used if the table still has the last
+ * key when the cache was saved.
+ */
+bool tsdbRestoreLastCacheEntry(STsdbRepo *pRepo, SLastCacheFile *pFile, STable *pTable, TSKEY lastKey) {
+  STsdbCfg *pCfg = REPO_CFG(pRepo);
+  int32_t   tid = TABLE_TID(pTable);
+  uint64_t  uid;
+  TSKEY     key;
+  uint32_t  rowLen;
+  int32_t   sversion;
+  int16_t   nCols;
+  SMemRow   lastRow = NULL;
+  SDataCol *lastCols = NULL;
+  void *    ptr;
+
+  if (pFile->entries == NULL || tid >= pFile->maxTables || pFile->entries[tid] == NULL) return false;
+
+  ptr = POINTER_SHIFT(pFile->entries[tid], sizeof(int32_t));
+  ptr = taosDecodeFixedU64(ptr, &uid);
+  ptr = taosDecodeFixedI64(ptr, &key);
+  if (uid != TABLE_UID(pTable) || key != lastKey) return false;
+
+  ptr = taosDecodeFixedU32(ptr, &rowLen);
+  if (CACHE_LAST_ROW(pCfg)) {
+    if (rowLen == 0 || (lastRow = taosTMalloc(rowLen)) == NULL) return false;
+    memcpy(lastRow, ptr, rowLen);
+  }
+  ptr = POINTER_SHIFT(ptr, rowLen);
+
+  ptr = taosDecodeFixedI32(ptr, &sversion);
+  ptr = taosDecodeFixedI16(ptr, &nCols);
+  if (CACHE_LAST_NULL_COLUMN(pCfg)) {
+    if (nCols == 0 || (lastCols = (SDataCol *)calloc(nCols, sizeof(SDataCol))) == NULL) {
+      taosTZfree(lastRow);
+      return false;
+    }
+
+    for (int16_t i = 0; i < nCols; i++) {
+      SDataCol *pCol = lastCols + i;
+      ptr = taosDecodeFixedI16(ptr, &(pCol->colId));
+      ptr = taosDecodeFixedI32(ptr, &(pCol->bytes));
+      ptr = taosDecodeFixedI64(ptr, &(pCol->ts));
+      if (pCol->bytes > 0) {
+        if ((pCol->pData = malloc(pCol->bytes)) == NULL) {
+          pCol->bytes = 0;
+          for (int16_t j = 0; j < i; j++) tfree(lastCols[j].pData);
+          tfree(lastCols);
+          taosTZfree(lastRow);
+          return false;
+        }
+        memcpy(pCol->pData, ptr, pCol->bytes);
+        ptr = POINTER_SHIFT(ptr, pCol->bytes);
+      }
+    }
+  }
+
+  TSDB_WLOCK_TABLE(pTable);
+  taosTZfree(pTable->lastRow);
+  pTable->lastRow = lastRow;
+  if (lastCols != NULL) {
+    tsdbFreeLastColumns(pTable);
+    pTable->lastCols = lastCols;
+    pTable->maxColNum = nCols;
+    pTable->lastColSVersion = sversion;
+    pTable->restoreColumnNum = nCols;
+    pTable->hasRestoreLastColumn = true;
+  }
+  tsdbUpdateLastCacheSize(pRepo, pTable);
+  TSDB_WUNLOCK_TABLE(pTable);
+
+  return true;
+}
+
+static void tsdbGetLastCacheFname(int repoid, bool temp, char fname[]) {
+  snprintf(fname, TSDB_FILENAME_LEN, "%s/vnode/vnode%d/tsdb/%s%s", TFS_PRIMARY_PATH(), repoid, TSDB_LAST_CACHE_FNAME,
+           temp ? ".t" : "");
+}
+
+static void tsdbRefLastCacheMems(STsdbRepo *pRepo, SMemTable **ppMem, SMemTable **ppIMem) {
+  (void)tsdbLockRepo(pRepo);
+  *ppMem = pRepo->mem;
+  *ppIMem = pRepo->imem;
+  tsdbRefMemTable(pRepo, *ppMem);
+  tsdbRefMemTable(pRepo, *ppIMem);
+  (void)tsdbUnlockRepo(pRepo);
+}
+
+static bool tsdbTableHasMemData(SMemTable *pMem, STable *pTable) {
+  int32_t tid = TABLE_TID(pTable);
+  bool    has = false;
+
+  if (pMem == NULL) return false;
+
+  taosRLockLatch(&(pMem->latch));
+  if (tid < pMem->maxTables) {
+    STableData *pTableData = pMem->tData[tid];
+    has = (pTableData != NULL && pTableData->uid == TABLE_UID(pTable));
+  }
+  taosRUnLockLatch(&(pMem->latch));
+
+  return has;
+}
+
+static int tsdbEncodeLastCacheEntry(void **buf, STable *pTable) {
+  int      tlen = 0;
+  uint32_t rowLen = (pTable->lastRow == NULL) ? 0 : memRowTLen(pTable->lastRow);
+  int16_t  nCols = (pTable->lastCols == NULL) ? 0 : pTable->maxColNum;
+
+  tlen += taosEncodeFixedI32(buf, TABLE_TID(pTable));
+  tlen += taosEncodeFixedU64(buf, TABLE_UID(pTable));
+  tlen += taosEncodeFixedI64(buf, pTable->lastKey);
+  tlen += taosEncodeFixedU32(buf, rowLen);
+  if (buf != NULL && rowLen > 0) {
+    memcpy(*buf, pTable->lastRow, rowLen);
+    *buf = POINTER_SHIFT(*buf, rowLen);
+  }
+  tlen += rowLen;
+
+  tlen += taosEncodeFixedI32(buf, pTable->lastColSVersion);
+  tlen += taosEncodeFixedI16(buf, nCols);
+  for (int16_t i = 0; i < nCols; i++) {
+    SDataCol *pCol = pTable->lastCols + i;
+
+    tlen += taosEncodeFixedI16(buf, pCol->colId);
+    tlen += taosEncodeFixedI32(buf, pCol->bytes);
+    tlen += taosEncodeFixedI64(buf, pCol->ts);
+    if (buf != NULL && pCol->bytes > 0) {
+      memcpy(*buf, pCol->pData, pCol->bytes);
+      *buf = POINTER_SHIFT(*buf, pCol->bytes);
+    }
+    tlen += pCol->bytes;
+  }
+
+  return tlen;
+}
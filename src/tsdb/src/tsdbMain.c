@@ -31,6 +31,7 @@ static void       tsdbStartStream(STsdbRepo *pRepo);
 static void       tsdbStopStream(STsdbRepo *pRepo);
 static int        tsdbRestoreLastColumns(STsdbRepo *pRepo, STable *pTable, SReadH* pReadh);
 static int        tsdbRestoreLastRow(STsdbRepo *pRepo, STable *pTable, SReadH* pReadh, SBlockIdx *pIdx);
+static void       tsdbUpdateLoadedLastCacheSize(STsdbRepo *pRepo, STable *pTable);
 
 // Function declaration
 int32_t tsdbCreateRepo(int repoid) {
@@ -128,6 +129,8 @@ int tsdbCloseRepo(STsdbRepo *repo, int toCommit) {
   terrno = TSDB_CODE_SUCCESS;
 
   tsdbStopStream(pRepo);
+  pRepo->stopAutoCompact = true;
+  pRepo->stopTierMigrate = true;
   if(pRepo->pthread){
     taosDestoryThread(pRepo->pthread);
     pRepo->pthread = NULL;
@@ -213,7 +216,7 @@ STsdbRepoInfo *tsdbGetStatus(STsdbRepo *pRepo) { return NULL; }
 
 int tsdbGetState(STsdbRepo *repo) { return repo->state; }
 
-int8_t tsdbGetCompactState(STsdbRepo *repo) { return (int8_t)(repo->compactState); }
+int8_t tsdbGetCompactState(STsdbRepo *repo) { return (int8_t)atomic_load_8(&repo->compactState); }
 
 void tsdbReportStat(void *repo, int64_t *totalPoints, int64_t *totalStorage, int64_t *compStorage) {
   ASSERT(repo != NULL);
@@ -574,6 +577,7 @@ static STsdbRepo *tsdbNewRepo(STsdbCfg *pCfg, STsdbAppH *pAppH) {
   pRepo->state = TSDB_STATE_OK;
   pRepo->code = TSDB_CODE_SUCCESS;
   pRepo->compactState = 0;
+  pRepo->lastAutoCompact = taosGetTimestampMs();
   pRepo->config = *pCfg;
   if (pAppH) {
     pRepo->appH = *pAppH;
@@ -596,6 +600,18 @@ static STsdbRepo *tsdbNewRepo(STsdbCfg *pCfg, STsdbAppH *pAppH) {
   }
   pRepo->config_changed = false;
   pRepo->cacheLastConfigVersion = 0;
+  tsdbInitLastCache(pRepo);
+  tsdbInitRollupCfg(pRepo);
+
+  if (tsdbInitBlockCache(pRepo) < 0) {
+    tsdbFreeRepo(pRepo);
+    return NULL;
+  }
+
+  if (tsdbInitFSetHeat(pRepo) < 0) {
+    tsdbFreeRepo(pRepo);
+    return NULL;
+  }
 
   code = tsem_init(&(pRepo->readyToCommit), 0, 1);
   if (code != 0) {
@@ -635,6 +651,9 @@ static void tsdbFreeRepo(STsdbRepo *pRepo) {
     tsdbFreeBufPool(pRepo->pPool);
     tsdbFreeMeta(pRepo->tsdbMeta);
     tsdbFreeMergeBuf(pRepo->mergeBuf);
+    tsdbDestroyBlockCache(pRepo);
+    tsdbDestroyFSetHeat(pRepo);
+    taosArrayDestroy(&pRepo->autoCompactFSets);
     // tsdbFreeMemTable(pRepo->mem);
     // tsdbFreeMemTable(pRepo->imem);
     tsem_destroy(&(pRepo->readyToCommit));
@@ -857,13 +876,22 @@ static int tsdbRestoreLastRow(STsdbRepo *pRepo, STable *pTable, SReadH* pReadh,
 }
 
 int tsdbRestoreInfo(STsdbRepo *pRepo) {
-  SFSIter    fsiter;
-  SReadH     readh;
-  SDFileSet *pSet;
-  STsdbMeta *pMeta = pRepo->tsdbMeta;
-  STsdbCfg * pCfg = REPO_CFG(pRepo);
+  SFSIter        fsiter;
+  SReadH         readh;
+  SDFileSet *    pSet;
+  STsdbMeta *    pMeta = pRepo->tsdbMeta;
+  STsdbCfg *     pCfg = REPO_CFG(pRepo);
+  SLastCacheFile lcf = {0};
+  bool           saved = TSDB_LAST_CACHE_SAVED(pRepo);
+
+  // With a saved last row cache, the cached values are restored from the file saved by the last commit instead of
+  // scanning the data files, tables without a valid entry are loaded on the first query
+  if (saved && tsdbOpenLastCacheFile(pRepo, &lcf) < 0) {
+    return -1;
+  }
 
   if (tsdbInitReadH(&readh, pRepo) < 0) {
+    tsdbCloseLastCacheFile(&lcf);
     return -1;
   }
 
@@ -881,11 +909,13 @@ int tsdbRestoreInfo(STsdbRepo *pRepo) {
   while ((pSet = tsdbFSIterNext(&fsiter)) != NULL) {
     if (tsdbSetAndOpenReadFSet(&readh, pSet) < 0) {
       tsdbDestroyReadH(&readh);
+      tsdbCloseLastCacheFile(&lcf);
       return -1;
     }
 
     if (tsdbLoadBlockIdx(&readh) < 0) {
       tsdbDestroyReadH(&readh);
+      tsdbCloseLastCacheFile(&lcf);
       return -1;
     }
 
@@ -897,6 +927,7 @@ int tsdbRestoreInfo(STsdbRepo *pRepo) {
 
       if (tsdbSetReadTable(&readh, pTable) < 0) {
         tsdbDestroyReadH(&readh);
+        tsdbCloseLastCacheFile(&lcf);
         return -1;
       }
 
@@ -905,6 +936,13 @@ int tsdbRestoreInfo(STsdbRepo *pRepo) {
       if (pIdx && lastKey < pIdx->maxKey) {
         pTable->lastKey = pIdx->maxKey;
 
+        if (saved) {
+          if (!tsdbRestoreLastCacheEntry(pRepo, &lcf, pTable, pIdx->maxKey)) {
+            pTable->lastCacheEvicted = true;
+          }
+          continue;
+        }
+
         if (CACHE_LAST_ROW(pCfg) && tsdbRestoreLastRow(pRepo, pTable, &readh, pIdx) != 0) {
           tsdbDestroyReadH(&readh);
           return -1;
@@ -912,7 +950,7 @@ int tsdbRestoreInfo(STsdbRepo *pRepo) {
       }
       
       // restore NULL columns
-      if (pIdx && CACHE_LAST_NULL_COLUMN(pCfg) && !pTable->hasRestoreLastColumn) {
+      if (pIdx && !saved && CACHE_LAST_NULL_COLUMN(pCfg) && !pTable->hasRestoreLastColumn) {
         if (tsdbRestoreLastColumns(pRepo, pTable, &readh) != 0) {
           tsdbDestroyReadH(&readh);
           return -1;
@@ -922,6 +960,7 @@ int tsdbRestoreInfo(STsdbRepo *pRepo) {
   }
 
   tsdbDestroyReadH(&readh);
+  tsdbCloseLastCacheFile(&lcf);
 
   // if (CACHE_LAST_NULL_COLUMN(pCfg)) {
   //   atomic_store_8(&pRepo->hasCachedLastColumn, 1);
@@ -944,6 +983,10 @@ int32_t tsdbLoadLastCache(STsdbRepo *pRepo, STable *pTable) {
 
   pTable->cacheLastConfigVersion = pRepo->cacheLastConfigVersion;
 
+  // columns of an evicted table may be partially cached again by new rows, load the others from files
+  bool evicted = pTable->lastCacheEvicted;
+  pTable->lastCacheEvicted = false;
+
   if (!cacheLastRow && pTable->lastRow != NULL) {
     taosTZfree(pTable->lastRow);
     pTable->lastRow = NULL;
@@ -953,13 +996,15 @@ int32_t tsdbLoadLastCache(STsdbRepo *pRepo, STable *pTable) {
   }
 
   if (!cacheLastRow && !cacheLastCol) {
+    tsdbUpdateLoadedLastCacheSize(pRepo, pTable);
     return 0;
   }
 
   cacheLastRowTableNum = (cacheLastRow && pTable->lastRow  == NULL) ? 1 : 0;
-  cacheLastColTableNum = (cacheLastCol && pTable->lastCols == NULL) ? 1 : 0;
+  cacheLastColTableNum = (cacheLastCol && (pTable->lastCols == NULL || evicted)) ? 1 : 0;
 
   if (cacheLastRowTableNum == 0 && cacheLastColTableNum == 0) {
+    tsdbUpdateLoadedLastCacheSize(pRepo, pTable);
     return 0;
   }
 
@@ -1018,9 +1063,19 @@ int32_t tsdbLoadLastCache(STsdbRepo *pRepo, STable *pTable) {
   tsdbUnLockFS(REPO_FS(pRepo));
   tsdbDestroyReadH(&readh);
 
+  tsdbUpdateLoadedLastCacheSize(pRepo, pTable);
+
   return 0;
 }
 
+static void tsdbUpdateLoadedLastCacheSize(STsdbRepo *pRepo, STable *pTable) {
+  if (!TSDB_LAST_CACHE_BOUNDED(pRepo)) return;
+
+  TSDB_WLOCK_TABLE(pTable);
+  tsdbUpdateLastCacheSize(pRepo, pTable);
+  TSDB_WUNLOCK_TABLE(pTable);
+}
+
 UNUSED_FUNC int tsdbCacheLastData(STsdbRepo *pRepo, STsdbCfg* oldCfg) {
   bool cacheLastRow = false, cacheLastCol = false;
   SFSIter    fsiter;
@@ -15,12 +15,14 @@
 
 #include "tdataformat.h"
 #include "tfunctional.h"
+#include "tglobal.h"
 #include "tsdbint.h"
 #include "tskiplist.h"
 #include "tsdbRowMergeBuf.h"
 
 #define TSDB_DATA_SKIPLIST_LEVEL 5
 #define TSDB_MAX_INSERT_BATCH 512
+#define TSDB_MEM_COLS_INIT_ROWS 256
 
 typedef struct {
   int32_t  totalLen;
@@ -36,9 +38,15 @@ typedef struct {
 
 static SMemTable *  tsdbNewMemTable(STsdbRepo *pRepo);
 static void         tsdbFreeMemTable(SMemTable *pMemTable);
-static STableData*  tsdbNewTableData(STsdbCfg *pCfg, STable *pTable);
+static STableData*  tsdbNewTableData(STsdbRepo *pRepo, STable *pTable);
 static void         tsdbFreeTableData(STableData *pTableData);
+static void         tsdbAppendRowToMemCols(STableData *pTableData, STable *pTable, SMemRow row, int maxRows);
+static void         tsdbDropMemCols(STableData *pTableData);
+static void         tsdbAppendNodesToMemCols(STableData *pTableData, STable *pTable, SSkipListNode *pPrevLast,
+                                             int maxRows);
+static bool         tsdbIsSubmitBlkAppend(STableData *pTableData, SSubmitBlkIter *pIter);
 static char *       tsdbGetTsTupleKey(const void *data);
+static void *       tsdbAllocSkipListNode(void *param, int32_t size);
 static int          tsdbAdjustMemMaxTables(SMemTable *pMemTable, int maxTables);
 static int          tsdbAppendTableRowToCols(STable *pTable, SDataCols *pCols, STSchema **ppSchema, SMemRow row);
 static int          tsdbInitSubmitBlkIter(SSubmitBlk *pBlock, SSubmitBlkIter *pIter);
@@ -81,6 +89,8 @@ int32_t tsdbInsertData(STsdbRepo *repo, SSubmitMsg *pMsg, SShellSubmitRspMsg *pR
     pRsp->numOfRows = htonl(numOfRows);
   }
 
+  tsdbEvictLastCache(pRepo);
+
   if (tsdbCheckCommit(pRepo) < 0) return -1;
   return 0;
 }
@@ -522,7 +532,8 @@ static void tsdbFreeMemTable(SMemTable* pMemTable) {
   }
 }
 
-static STableData *tsdbNewTableData(STsdbCfg *pCfg, STable *pTable) {
+static STableData *tsdbNewTableData(STsdbRepo *pRepo, STable *pTable) {
+  STsdbCfg *  pCfg = &(pRepo->config);
   STableData *pTableData = (STableData *)calloc(1, sizeof(*pTableData));
   if (pTableData == NULL) {
     terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
@@ -540,6 +551,9 @@ static STableData *tsdbNewTableData(STsdbCfg *pCfg, STable *pTable) {
   else
     skipListCreateFlags = SL_UPDATE_DUP_KEY;
 
+  // the mode is fixed when the table data is created, i.e. once per table in each memtable
+  if (tsdbLockFreeSkipList) skipListCreateFlags |= SL_LOCK_FREE;
+
   pTableData->pData =
       tSkipListCreate(TSDB_DATA_SKIPLIST_LEVEL, TSDB_DATA_TYPE_TIMESTAMP, TYPE_BYTES[TSDB_DATA_TYPE_TIMESTAMP],
                       tkeyComparFn, skipListCreateFlags, tsdbGetTsTupleKey);
@@ -549,6 +563,20 @@ static STableData *tsdbNewTableData(STsdbCfg *pCfg, STable *pTable) {
     return NULL;
   }
 
+  // skiplist nodes live in the buffer blocks of the memtable like the rows they point to
+  tSkipListSetAllocator(pTableData->pData, tsdbAllocSkipListNode, pRepo);
+
+  taosInitRWLatch(&(pTableData->colsLatch));
+  if (tsdbColumnarMemTable) {
+    pTableData->pCols = tdNewDataCols(0, MIN(TSDB_MEM_COLS_INIT_ROWS, REPO_CFG(pRepo)->maxRowsPerFileBlock));
+    if (pTableData->pCols == NULL) {
+      terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+      tSkipListDestroy(pTableData->pData);
+      free(pTableData);
+      return NULL;
+    }
+  }
+
   T_REF_INC(pTableData);
 
   return pTableData;
@@ -559,13 +587,157 @@ static void tsdbFreeTableData(STableData *pTableData) {
     int32_t ref = T_REF_DEC(pTableData);
     if (ref == 0) {
       tSkipListDestroy(pTableData->pData);
+      tdFreeDataCols(pTableData->pCols);
       free(pTableData);
     }
   }
 }
 
+// Called with colsLatch write locked. At most maxRows rows are kept column-wise, the rows after them are only in
+// the skiplist and read from it.
+static void tsdbAppendRowToMemCols(STableData *pTableData, STable *pTable, SMemRow row, int maxRows) {
+  SDataCols *pCols = pTableData->pCols;
+  if (pCols->numOfRows >= maxRows) return;
+
+  STSchema * pSchema = tsdbGetTableSchemaImpl(pTable, false, false, memRowVersion(row), (int8_t)memRowType(row));
+  if (pSchema == NULL) {
+    tsdbDropMemCols(pTableData);
+    return;
+  }
+
+  if (pCols->numOfRows == 0) {
+    if (tdInitDataCols(pCols, pSchema) < 0) {
+      tsdbDropMemCols(pTableData);
+      return;
+    }
+    pCols->sversion = schemaVersion(pSchema);
+  } else if (pCols->sversion != schemaVersion(pSchema)) {
+    // rows of different schema versions are not kept column-wise
+    tsdbDropMemCols(pTableData);
+    return;
+  }
+
+  if (pCols->numOfRows >= pCols->maxPoints && tdExpandDataCols(pCols, MIN(pCols->maxPoints * 2, maxRows)) < 0) {
+    tsdbDropMemCols(pTableData);
+    return;
+  }
+
+  tdAppendMemRowToDataCol(row, pSchema, pCols, true, 0);
+}
+
+// Called with colsLatch write locked, the table falls back to the row-wise data in skiplist only
+static void tsdbDropMemCols(STableData *pTableData) { pTableData->pCols = tdFreeDataCols(pTableData->pCols); }
+
+// The column-wise rows of a committed memtable are freed at once, queries still holding it read the skiplist
+void tsdbDropMemTableCols(SMemTable *pMemTable) {
+  for (int i = 0; i < pMemTable->maxTables; i++) {
+    STableData *pTableData = pMemTable->tData[i];
+    if (pTableData == NULL || pTableData->pCols == NULL) continue;
+
+    taosWLockLatch(&(pTableData->colsLatch));
+    tsdbDropMemCols(pTableData);
+    taosWUnLockLatch(&(pTableData->colsLatch));
+  }
+}
+
+// Called with colsLatch write locked, append the rows linked after pPrevLast by the last batch put
+static void tsdbAppendNodesToMemCols(STableData *pTableData, STable *pTable, SSkipListNode *pPrevLast,
+                                     int maxRows) {
+  SSkipList *    pSkipList = pTableData->pData;
+  SSkipListNode *pNode = SL_NODE_GET_FORWARD_POINTER(pPrevLast, 0);
+
+  while (pNode != pSkipList->pTail && pTableData->pCols != NULL && pTableData->pCols->numOfRows < maxRows) {
+    if (SL_GET_NODE_DATA(pNode) == NULL) {
+      tsdbDropMemCols(pTableData);
+      break;
+    }
+    tsdbAppendRowToMemCols(pTableData, pTable, (SMemRow)SL_GET_NODE_DATA(pNode), maxRows);
+    pNode = SL_NODE_GET_FORWARD_POINTER(pNode, 0);
+  }
+}
+
+// Whether all rows of the submit block are put after the last key of the table, in ascending order
+static bool tsdbIsSubmitBlkAppend(STableData *pTableData, SSubmitBlkIter *pIter) {
+  SSubmitBlkIter iter = *pIter;
+  SMemRow        row = NULL;
+  bool           isEmpty = (SL_SIZE(pTableData->pData) == 0);
+  TSKEY          lastKey = pTableData->keyLast;
+
+  while ((row = tsdbGetSubmitBlkNext(&iter)) != NULL) {
+    TSKEY key = memRowKey(row);
+    if (!isEmpty && key <= lastKey) return false;
+
+    isEmpty = false;
+    lastKey = key;
+  }
+
+  return true;
+}
+
+/**
+ * Load rows from the column-wise copy of the memtable data instead of converting the skiplist rows one by one.
+ *
+ * It loads the same rows as tsdbLoadDataFromCache without filter keys and moves pIter in the same way. Return the
+ * number of rows loaded, or -1 if the table data is not kept column-wise and tsdbLoadDataFromCache should be used.
+ */
+int tsdbLoadDataFromMemCols(STableData *pTableData, SSkipListIterator *pIter, TSKEY maxKey, int maxRowsToRead,
+                            SDataCols *pCols, SMergeInfo *pMergeInfo) {
+  ASSERT(maxRowsToRead > 0 && pCols != NULL);
+  if (pTableData == NULL || pIter == NULL) return -1;
+
+  SMemRow row = tsdbNextIterRow(pIter);
+  if (row == NULL || memRowKey(row) > maxKey) return -1;
+
+  taosRLockLatch(&(pTableData->colsLatch));
+
+  SDataCols *pMemCols = pTableData->pCols;
+  int        start = (pMemCols == NULL) ? -1 : tsdbMemColsFindKey(pMemCols, memRowKey(row));
+  if (start < 0) {
+    taosRUnLockLatch(&(pTableData->colsLatch));
+    return -1;
+  }
+
+  int nRows = 0;
+  while (start + nRows < pMemCols->numOfRows && nRows < maxRowsToRead && nRows < pCols->maxPoints &&
+         dataColsKeyAt(pMemCols, start + nRows) <= maxKey) {
+    nRows++;
+  }
+
+  tdResetDataCols(pCols);
+  if (tdAppendDataColsRows(pCols, pMemCols, start, nRows) < 0) {
+    taosRUnLockLatch(&(pTableData->colsLatch));
+    tdResetDataCols(pCols);
+    return -1;
+  }
+
+  taosRUnLockLatch(&(pTableData->colsLatch));
+
+  for (int i = 0; i < nRows; i++) {
+    ASSERT(memRowKey(tsdbNextIterRow(pIter)) == dataColsKeyAt(pCols, i));
+    tSkipListIterNext(pIter);
+  }
+
+  if (pMergeInfo) {
+    memset(pMergeInfo, 0, sizeof(*pMergeInfo));
+    pMergeInfo->rowsInserted = nRows;
+    pMergeInfo->nOperations = nRows;
+    pMergeInfo->keyFirst = dataColsKeyFirst(pCols);
+    pMergeInfo->keyLast = dataColsKeyLast(pCols);
+  }
+
+  return nRows;
+}
+
 static char *tsdbGetTsTupleKey(const void *data) { return memRowKeys((SMemRow)data); }
 
+static void *tsdbAllocSkipListNode(void *param, int32_t size) {
+  // rows are packed without padding, align the node so its forward pointers can be updated atomically
+  char *ptr = tsdbAllocBytes((STsdbRepo *)param, size + POINTER_BYTES - 1);
+  if (ptr == NULL) return NULL;
+
+  return (void *)ALIGN_NUM((uintptr_t)ptr, POINTER_BYTES);
+}
+
 static int tsdbAdjustMemMaxTables(SMemTable *pMemTable, int maxTables) {
   ASSERT(pMemTable->maxTables < maxTables);
 
@@ -794,7 +966,6 @@ static int tsdbInsertDataToTable(STsdbRepo* pRepo, SSubmitBlk* pBlock, int32_t *
   SSubmitBlkIter   blkIter = {0};
   SMemTable       *pMemTable = NULL;
   STableData      *pTableData = NULL;
-  STsdbCfg        *pCfg = &(pRepo->config);
 
   tsdbInitSubmitBlkIter(pBlock, &blkIter);
   if(blkIter.row == NULL) return 0;
@@ -826,7 +997,7 @@ static int tsdbInsertDataToTable(STsdbRepo* pRepo, SSubmitBlk* pBlock, int32_t *
       taosWUnLockLatch(&(pMemTable->latch));
     }
 
-    pTableData = tsdbNewTableData(pCfg, pTable);
+    pTableData = tsdbNewTableData(pRepo, pTable);
     if (pTableData == NULL) {
       tsdbError("vgId:%d failed to insert data to table %s uid %" PRId64 " tid %d since %s", REPO_ID(pRepo),
                 TABLE_CHAR_NAME(pTable), TABLE_UID(pTable), TABLE_TID(pTable), tstrerror(terrno));
@@ -838,13 +1009,38 @@ static int tsdbInsertDataToTable(STsdbRepo* pRepo, SSubmitBlk* pBlock, int32_t *
 
   ASSERT((pTableData != NULL) && pTableData->uid == TABLE_UID(pTable));
 
+  SSkipList *    pSkipList = pTableData->pData;
+  SSkipListNode *pPrevLast = SL_NODE_GET_BACKWARD_POINTER(pSkipList->pTail, 0);
+  uint32_t       nAppends = pSkipList->numOfAppends;
+  uint32_t       nMerges = pSkipList->numOfMerges;
+
+  // the column-wise rows only follow the skiplist while rows are appended, drop them before the skiplist changes
+  if (pTableData->pCols != NULL && !tsdbIsSubmitBlkAppend(pTableData, &blkIter)) {
+    taosWLockLatch(&(pTableData->colsLatch));
+    tsdbDropMemCols(pTableData);
+    taosWUnLockLatch(&(pTableData->colsLatch));
+  }
+
   SMemRow lastRow = NULL;
-  int64_t osize = SL_SIZE(pTableData->pData);
-  tsdbSetupSkipListHookFns(pTableData->pData, pRepo, pTable, &points, &lastRow);
-  tSkipListPutBatchByIter(pTableData->pData, &blkIter, (iter_next_fn_t)tsdbGetSubmitBlkNext);
-  int64_t dsize = SL_SIZE(pTableData->pData) - osize;
+  int64_t osize = SL_SIZE(pSkipList);
+  tsdbSetupSkipListHookFns(pSkipList, pRepo, pTable, &points, &lastRow);
+  tSkipListPutBatchByIter(pSkipList, &blkIter, (iter_next_fn_t)tsdbGetSubmitBlkNext);
+  int64_t dsize = SL_SIZE(pSkipList) - osize;
   (*pAffectedRows) += points;
 
+  pMemTable->rowsAppended += pSkipList->numOfAppends - nAppends;
+  pMemTable->rowsMerged += pSkipList->numOfMerges - nMerges;
+
+  if (pTableData->pCols != NULL) {
+    taosWLockLatch(&(pTableData->colsLatch));
+    if (pSkipList->numOfMerges != nMerges) {
+      tsdbDropMemCols(pTableData);
+    } else {
+      tsdbAppendNodesToMemCols(pTableData, pTable, pPrevLast, REPO_CFG(pRepo)->maxRowsPerFileBlock);
+    }
+    taosWUnLockLatch(&(pTableData->colsLatch));
+  }
+
   if(lastRow != NULL) {
     TSKEY lastRowKey = memRowKey(lastRow);
     if (pMemTable->keyFirst > firstRowKey) pMemTable->keyFirst = firstRowKey;
@@ -1076,5 +1272,12 @@ static int tsdbUpdateTableLatestInfo(STsdbRepo *pRepo, STable *pTable, SMemRow r
 
   pTable->cacheLastConfigVersion = pRepo->cacheLastConfigVersion;
 
+  if (TSDB_LAST_CACHE_BOUNDED(pRepo)) {
+    TSDB_WLOCK_TABLE(pTable);
+    tsdbUpdateLastCacheSize(pRepo, pTable);
+    TSDB_WUNLOCK_TABLE(pTable);
+    atomic_store_8(&(pTable->lastCacheRef), 1);
+  }
+
   return 0;
 }
@@ -1042,6 +1042,7 @@ static void tsdbRemoveTableFromMeta(STsdbRepo *pRepo, STable *pTable, bool rmFro
     }
   } else {
     pMeta->tables[pTable->tableId.tid] = NULL;
+    atomic_sub_fetch_64(&(pRepo->lastCache.size), pTable->lastCacheSize);
     if (TABLE_TYPE(pTable) == TSDB_CHILD_TABLE && rmFromIdx) {
       tsdbRemoveTableFromIndex(pMeta, pTable);
     }
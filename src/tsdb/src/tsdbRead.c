@@ -14,6 +14,7 @@
  */
 
 #include "os.h"
+#include "tglobal.h"
 #include "tdataformat.h"
 #include "tskiplist.h"
 #include "tulog.h"
@@ -114,6 +115,8 @@ typedef struct SIOCostSummary {
   int64_t checkForNextTime;
   int64_t headFileLoad;
   int64_t headFileLoadTime;
+  int64_t fileSkipped;
+  int64_t blockSkipped;
 } SIOCostSummary;
 
 typedef struct STsdbQueryHandle {
@@ -126,6 +129,7 @@ typedef struct STsdbQueryHandle {
   STimeWindow    window;           // the primary query time window that applies to all queries
   SDataStatis*   statis;           // query level statistics, only one table block statistics info exists at any time
   int32_t        numOfBlocks;
+  int32_t        readAheadPos;     // last traverse position of the current file blocks that has been read ahead
   SArray*        pColumns;         // column list, SColumnInfoData array list
   bool           locateStart;
   int32_t        outputCapacity;
@@ -134,6 +138,7 @@ typedef struct STsdbQueryHandle {
   int32_t        activeIndex;
   bool           checkFiles;       // check file stage
   int8_t         cachelastrow;     // check if last row cached
+  bool           pinCacheLast;     // tables in pTableCheckInfo are pinned in the last row cache
   bool           loadExternalRow;  // load time window external data rows
   bool           currentLoadExternalRows; // current load external rows
   int32_t        loadType;         // block load type
@@ -153,6 +158,18 @@ typedef struct STsdbQueryHandle {
   SArray        *prev;             // previous row which is before than time window
   SArray        *next;             // next row which is after the query time window
   SIOCostSummary cost;
+
+  void          *pFilters;         // column filters to skip file sets by their summaries
+  SFSetSum       fsetSum;          // summary of the current file set, only initialized with pFilters
+  SDataStatis   *fsetStatis;       // statistics of a table group in the current file set
+
+  int64_t        rollupInterval;   // interval of the query, 0 if whole file blocks are not returned by rollup windows
+  SBlockRollup   rollup;           // rollup of the current file block
+  int32_t        rollupWin;        // current rollup window of the block, -1 if the whole block is returned
+
+  int32_t       *mergeIndex;       // file block row or -(memtable row + 1) of each merged row in the query order
+  SMemRow       *mergeRows;        // memtable rows in mergeIndex
+  int32_t        numOfMergeRows;
 } STsdbQueryHandle;
 
 typedef struct STableGroupSupporter {
@@ -170,6 +187,7 @@ static STimeWindow updateLastrowForEachGroup(STableGroupInfo *groupList);
 static int32_t checkForCachedLastRow(STsdbQueryHandle* pQueryHandle, STableGroupInfo *groupList);
 static int32_t checkForCachedLast(STsdbQueryHandle* pQueryHandle);
 static int32_t lazyLoadCacheLast(STsdbQueryHandle* pQueryHandle);
+static void    unpinCacheLast(STsdbQueryHandle* pQueryHandle);
 static int32_t tsdbGetCachedLastRow(STable* pTable, SMemRow* pRes, TSKEY* lastKey);
 
 static void    changeQueryHandleForInterpQuery(TsdbQueryHandleT pHandle);
@@ -438,6 +456,8 @@ static STsdbQueryHandle* tsdbQueryTablesImpl(STsdbRepo* tsdb, STsdbQueryCond* pC
   pQueryHandle->locateStart = false;
   pQueryHandle->pMemRef     = pMemRef;
   pQueryHandle->loadType    = pCond->type;
+  pQueryHandle->rollupInterval = pCond->rollupInterval;
+  pQueryHandle->rollupWin   = -1;
 
   pQueryHandle->outputCapacity  = ((STsdbRepo*)tsdb)->config.maxRowsPerFileBlock;
   pQueryHandle->loadExternalRow = pCond->loadExternalRows;
@@ -446,6 +466,7 @@ static STsdbQueryHandle* tsdbQueryTablesImpl(STsdbRepo* tsdb, STsdbQueryCond* pC
   if (tsdbInitReadH(&pQueryHandle->rhelper, (STsdbRepo*)tsdb) != 0) {
     goto _end;
   }
+  pQueryHandle->rhelper.cacheBlocks = true;
 
   assert(pCond != NULL && pMemRef != NULL);
   setQueryTimewindow(pQueryHandle, pCond);
@@ -477,6 +498,15 @@ static STsdbQueryHandle* tsdbQueryTablesImpl(STsdbRepo* tsdb, STsdbQueryCond* pC
     }
 
     pQueryHandle->defaultLoadColumn = getDefaultLoadColumns(pQueryHandle, true);
+
+    if (pCond->pFilters != NULL && !pCond->loadExternalRows) {
+      pQueryHandle->fsetStatis = calloc(taosArrayGetSize(pQueryHandle->defaultLoadColumn), sizeof(SDataStatis));
+      if (pQueryHandle->fsetStatis == NULL || tsdbInitFSetSum(&pQueryHandle->fsetSum) < 0) {
+        goto _end;
+      }
+
+      pQueryHandle->pFilters = pCond->pFilters;
+    }
   }
 
   STsdbMeta* pMeta = tsdbGetMeta(tsdb);
@@ -554,6 +584,8 @@ void tsdbResetQueryHandle(TsdbQueryHandleT queryHandle, STsdbQueryCond *pCond) {
   pQueryHandle->activeIndex = 0;   // current active table index
   pQueryHandle->locateStart = false;
   pQueryHandle->loadExternalRow = pCond->loadExternalRows;
+  pQueryHandle->rollupInterval = pCond->rollupInterval;
+  pQueryHandle->rollupWin   = -1;
 
   if (ASCENDING_TRAVERSE(pCond->order)) {
     assert(pQueryHandle->window.skey <= pQueryHandle->window.ekey);
@@ -582,6 +614,8 @@ void tsdbResetQueryHandleForNewTable(TsdbQueryHandleT queryHandle, STsdbQueryCon
   pQueryHandle->activeIndex = 0;   // current active table index
   pQueryHandle->locateStart = false;
   pQueryHandle->loadExternalRow = pCond->loadExternalRows;
+  pQueryHandle->rollupInterval = pCond->rollupInterval;
+  pQueryHandle->rollupWin   = -1;
 
   if (ASCENDING_TRAVERSE(pCond->order)) {
     assert(pQueryHandle->window.skey <= pQueryHandle->window.ekey);
@@ -598,6 +632,7 @@ void tsdbResetQueryHandleForNewTable(TsdbQueryHandleT queryHandle, STsdbQueryCon
   SArray* pTable = NULL;
   STsdbMeta* pMeta = tsdbGetMeta(pQueryHandle->pTsdb);
 
+  unpinCacheLast(pQueryHandle);
   pQueryHandle->pTableCheckInfo = destroyTableCheckInfo(pQueryHandle->pTableCheckInfo);
 
   pQueryHandle->pTableCheckInfo = createCheckInfoFromTableGroup(pQueryHandle, groupList, pMeta, &pTable);
@@ -621,10 +656,24 @@ static int32_t lazyLoadCacheLast(STsdbQueryHandle* pQueryHandle) {
 
   size_t  numOfTables = taosArrayGetSize(pQueryHandle->pTableCheckInfo);
   int32_t code = 0;
+
+  // pin all the tables first, so the cached values are neither evicted before they are read nor while loading
+  for (size_t i = 0; i < numOfTables; ++i) {
+    STableCheckInfo* pCheckInfo = taosArrayGet(pQueryHandle->pTableCheckInfo, i);
+    tsdbPinLastCache(pRepo, pCheckInfo->pTableObj);
+  }
+  pQueryHandle->pinCacheLast = true;
+
   for (size_t i = 0; i < numOfTables; ++i) {
     STableCheckInfo* pCheckInfo = taosArrayGet(pQueryHandle->pTableCheckInfo, i);
     STable*          pTable = pCheckInfo->pTableObj;
-    if (pTable->cacheLastConfigVersion == pRepo->cacheLastConfigVersion) {
+
+    TSDB_RLOCK_TABLE(pTable);
+    bool cached = (pTable->cacheLastConfigVersion == pRepo->cacheLastConfigVersion) && !pTable->lastCacheEvicted;
+    TSDB_RUNLOCK_TABLE(pTable);
+
+    tsdbTouchLastCache(pRepo, cached);
+    if (cached) {
       continue;
     }
     code = tsdbLoadLastCache(pRepo, pTable);
@@ -638,6 +687,19 @@ static int32_t lazyLoadCacheLast(STsdbQueryHandle* pQueryHandle) {
   return code;
 }
 
+static void unpinCacheLast(STsdbQueryHandle* pQueryHandle) {
+  if (!pQueryHandle->pinCacheLast) {
+    return;
+  }
+
+  size_t numOfTables = taosArrayGetSize(pQueryHandle->pTableCheckInfo);
+  for (size_t i = 0; i < numOfTables; ++i) {
+    STableCheckInfo* pCheckInfo = taosArrayGet(pQueryHandle->pTableCheckInfo, i);
+    tsdbUnpinLastCache(pQueryHandle->pTsdb, pCheckInfo->pTableObj);
+  }
+  pQueryHandle->pinCacheLast = false;
+}
+
 TsdbQueryHandleT tsdbQueryLastRow(STsdbRepo *tsdb, STsdbQueryCond *pCond, STableGroupInfo *groupList, uint64_t qId, SMemRef* pMemRef) {
   pCond->twindow = updateLastrowForEachGroup(groupList);
 
@@ -1421,9 +1483,29 @@ static int32_t getFileCompInfo(STsdbQueryHandle* pQueryHandle, int32_t* numOfBlo
   return code;
 }
 
+// Ask the kernel to read the next blocks in traverse order while the current one is loaded and decompressed
+static void readAheadDataBlocks(STsdbQueryHandle* pQueryHandle, int32_t slotIndex) {
+  if (tsdbReadAheadBlocks <= 0 || slotIndex < 0 || slotIndex >= pQueryHandle->numOfBlocks) {
+    return;
+  }
+
+  bool    asc = ASCENDING_TRAVERSE(pQueryHandle->order);
+  int32_t pos = asc ? slotIndex : pQueryHandle->numOfBlocks - 1 - slotIndex;
+  int32_t end = MIN(pos + tsdbReadAheadBlocks, pQueryHandle->numOfBlocks - 1);
+
+  for (int32_t i = MAX(pos, pQueryHandle->readAheadPos) + 1; i <= end; ++i) {
+    STableBlockInfo* pBlockInfo = &pQueryHandle->pDataBlockInfo[asc ? i : pQueryHandle->numOfBlocks - 1 - i];
+    tsdbReadAheadBlock(&pQueryHandle->rhelper, pBlockInfo->compBlock, pBlockInfo->pTableCheckInfo->pCompInfo);
+  }
+
+  pQueryHandle->readAheadPos = MAX(pQueryHandle->readAheadPos, end);
+}
+
 static int32_t doLoadFileDataBlock(STsdbQueryHandle* pQueryHandle, SBlock* pBlock, STableCheckInfo* pCheckInfo, int32_t slotIndex) {
   int64_t st = taosGetTimestampUs();
 
+  readAheadDataBlocks(pQueryHandle, slotIndex);
+
   STSchema *pSchema = tsdbGetTableSchema(pCheckInfo->pTableObj);
   int32_t   code = tdInitDataCols(pQueryHandle->pDataCols, pSchema);
   if (code != TSDB_CODE_SUCCESS) {
@@ -1491,10 +1573,142 @@ _error:
 
 static int32_t getEndPosInDataBlock(STsdbQueryHandle* pQueryHandle, SDataBlockInfo* pBlockInfo);
 static int32_t doCopyRowsFromFileBlock(STsdbQueryHandle* pQueryHandle, int32_t capacity, int32_t numOfRows, int32_t start, int32_t end);
+static void doCopyRowsFromDataCols(STsdbQueryHandle* pQueryHandle, SDataCols* pCols, int32_t capacity, int32_t numOfRows,
+                                   int32_t start, int32_t end);
 static void moveDataToFront(STsdbQueryHandle* pQueryHandle, int32_t numOfRows, int32_t numOfCols);
 static void doCheckGeneratedBlockRange(STsdbQueryHandle* pQueryHandle);
+static void updateInfoAfterMerge(STsdbQueryHandle* pQueryHandle, STableCheckInfo* pCheckInfo, int32_t numOfRows, int32_t endPos);
 static void copyAllRemainRowsFromFileBlock(STsdbQueryHandle* pQueryHandle, STableCheckInfo* pCheckInfo, SDataBlockInfo* pBlockInfo, int32_t endPos);
 
+static void setRollupWinOfBlock(STsdbQueryHandle* pQueryHandle) {
+  SQueryFilePos* cur = &pQueryHandle->cur;
+  SRollupWin*    pWin = TSDB_ROLLUP_WIN(&pQueryHandle->rollup, pQueryHandle->rollupWin);
+
+  cur->rows = pWin->rows;
+  cur->win.skey = pWin->skey;
+  cur->win.ekey = pWin->ekey;
+  pQueryHandle->realNumOfRows = pWin->rows;
+}
+
+/*
+ * Return the whole file block by the windows of its rollup if the windows of the interval query are their multiples,
+ * so that the statistics of a window answer an interval window without loading the block. The block is loaded only
+ * if the rows of a window are retrieved.
+ */
+static void startRollupWinOfBlock(STsdbQueryHandle* pQueryHandle, SBlock* pBlock) {
+  int32_t numOfWins = tsdbLoadBlockRollup(&pQueryHandle->rhelper, pBlock, pQueryHandle->rollupInterval,
+                                          &pQueryHandle->rollup);
+  if (numOfWins <= 0) {  // a corrupted rollup is only logged, the block is still returned as a whole
+    return;
+  }
+
+  pQueryHandle->rollupWin = ASCENDING_TRAVERSE(pQueryHandle->order) ? 0 : (numOfWins - 1);
+  setRollupWinOfBlock(pQueryHandle);
+}
+
+static bool moveToNextRollupWin(STsdbQueryHandle* pQueryHandle) {
+  if (pQueryHandle->rollupWin < 0) {
+    return false;
+  }
+
+  pQueryHandle->rollupWin += ASCENDING_TRAVERSE(pQueryHandle->order) ? 1 : -1;
+  if (pQueryHandle->rollupWin < 0 || pQueryHandle->rollupWin >= pQueryHandle->rollup.numOfWins) {
+    pQueryHandle->rollupWin = -1;
+    return false;
+  }
+
+  setRollupWinOfBlock(pQueryHandle);
+  return true;
+}
+
+// Load the statistics of the columns in the query of a file block without sub-blocks into pQueryHandle->statis
+static int loadBlockStatis(STsdbQueryHandle* pQueryHandle, SBlock* pBlock) {
+  int64_t stime = taosGetTimestampUs();
+  int     statisStatus = tsdbLoadBlockStatis(&pQueryHandle->rhelper, pBlock);
+  if (statisStatus != TSDB_STATIS_OK) {
+    return statisStatus;
+  }
+
+  int16_t* colIds = pQueryHandle->defaultLoadColumn->pData;
+
+  size_t numOfCols = QH_GET_NUM_OF_COLS(pQueryHandle);
+  memset(pQueryHandle->statis, 0, numOfCols * sizeof(SDataStatis));
+  for(int32_t i = 0; i < numOfCols; ++i) {
+    pQueryHandle->statis[i].colId = colIds[i];
+  }
+
+  tsdbGetBlockStatis(&pQueryHandle->rhelper, pQueryHandle->statis, (int)numOfCols, pBlock);
+
+  // always load the first primary timestamp column data
+  SDataStatis* pPrimaryColStatis = &pQueryHandle->statis[0];
+  assert(pPrimaryColStatis->colId == PRIMARYKEY_TIMESTAMP_COL_INDEX);
+
+  pPrimaryColStatis->numOfNull = 0;
+  pPrimaryColStatis->min = pBlock->keyFirst;
+  pPrimaryColStatis->max = pBlock->keyLast;
+
+  //update the number of NULL data rows
+  for(int32_t i = 1; i < numOfCols; ++i) {
+    if (pQueryHandle->statis[i].numOfNull == -1) { // set the column data are all NULL
+      pQueryHandle->statis[i].numOfNull = pBlock->numOfRows;
+    }
+  }
+
+  int64_t elapsed = taosGetTimestampUs() - stime;
+  pQueryHandle->cost.statisInfoLoadTime += elapsed;
+
+  return TSDB_STATIS_OK;
+}
+
+// Check by the statistics of a file block, which is to be loaded and merged by the reader since the query time range
+// starts or ends in it, if any of its rows may match the filters. The executor only checks the statistics of the blocks
+// returned as a whole, so no rows of the block would be read otherwise. A block with rows in memory falling into its
+// range is always loaded, since those rows are merged with, or discarded for, the rows of the block.
+static bool fileBlockMayMatch(STsdbQueryHandle* pQueryHandle, SBlock* pBlock, STableCheckInfo* pCheckInfo) {
+  if (pQueryHandle->pFilters == NULL || pBlock->numOfSubBlocks > 1) {
+    return true;
+  }
+
+  initTableMemIterator(pQueryHandle, pCheckInfo);
+
+  TSKEY key = extractFirstTraverseKey(pCheckInfo, pQueryHandle->order, pQueryHandle->pTsdb->config.update);
+  if (key != TSKEY_INITIAL_VAL) {
+    if ((ASCENDING_TRAVERSE(pQueryHandle->order) && key <= pBlock->keyLast) ||
+        (!ASCENDING_TRAVERSE(pQueryHandle->order) && key >= pBlock->keyFirst)) {
+      return true;
+    }
+  }
+
+  // an error in loading the statistics is reported when the block itself is loaded
+  if (loadBlockStatis(pQueryHandle, pBlock) != TSDB_STATIS_OK) {
+    return true;
+  }
+
+  return filterRangeExecute(pQueryHandle->pFilters, pQueryHandle->statis, (int32_t)QH_GET_NUM_OF_COLS(pQueryHandle),
+                            pBlock->numOfRows);
+}
+
+static void skipFileBlock(STsdbQueryHandle* pQueryHandle, SBlock* pBlock, STableCheckInfo* pCheckInfo) {
+  SQueryFilePos* cur = &pQueryHandle->cur;
+
+  if (ASCENDING_TRAVERSE(pQueryHandle->order)) {
+    cur->lastKey = pBlock->keyLast + 1;
+    cur->pos = pBlock->numOfRows;
+  } else {
+    cur->lastKey = pBlock->keyFirst - 1;
+    cur->pos = -1;
+  }
+
+  cur->win = pQueryHandle->window;
+  cur->mixBlock = true;
+  cur->blockCompleted = true;
+  updateInfoAfterMerge(pQueryHandle, pCheckInfo, 0, cur->pos);
+
+  pQueryHandle->cost.blockSkipped += 1;
+  tsdbDebug("%p file block skipped by filters, brange:%"PRId64"-%"PRId64", rows:%d, tid:%d, 0x%"PRIx64, pQueryHandle,
+            pBlock->keyFirst, pBlock->keyLast, pBlock->numOfRows, pCheckInfo->tableId.tid, pQueryHandle->qId);
+}
+
 static int32_t handleDataMergeIfNeeded(STsdbQueryHandle* pQueryHandle, SBlock* pBlock, STableCheckInfo* pCheckInfo){
   SQueryFilePos* cur = &pQueryHandle->cur;
   STsdbCfg*      pCfg = &pQueryHandle->pTsdb->config;
@@ -1502,6 +1716,8 @@ static int32_t handleDataMergeIfNeeded(STsdbQueryHandle* pQueryHandle, SBlock* p
   TSKEY          key;
   int32_t code = TSDB_CODE_SUCCESS;
 
+  pQueryHandle->rollupWin = -1;
+
   /*bool hasData = */ initTableMemIterator(pQueryHandle, pCheckInfo);
   assert(cur->pos >= 0 && cur->pos <= binfo.rows);
 
@@ -1570,13 +1786,21 @@ static int32_t handleDataMergeIfNeeded(STsdbQueryHandle* pQueryHandle, SBlock* p
         cur->lastKey = binfo.window.skey - 1;
         cur->pos = -1;
       }
+
+      if (pQueryHandle->rollupInterval > 0) {
+        startRollupWinOfBlock(pQueryHandle, pBlock);
+      }
     } else { // partially copy to dest buffer
       copyAllRemainRowsFromFileBlock(pQueryHandle, pCheckInfo, &binfo, endPos);
       cur->mixBlock = true;
     }
 
     assert(cur->blockCompleted);
-    if (cur->rows == binfo.rows) {
+    if (pQueryHandle->rollupWin >= 0) {
+      tsdbDebug("%p whole file block qualified by %d rollup windows, brange:%"PRId64"-%"PRId64", rows:%d, tid:%d, %"PRIx64,
+                pQueryHandle, pQueryHandle->rollup.numOfWins, binfo.window.skey, binfo.window.ekey, binfo.rows,
+                binfo.tid, pQueryHandle->qId);
+    } else if (cur->rows == binfo.rows) {
       tsdbDebug("%p whole file block qualified, brange:%"PRId64"-%"PRId64", rows:%d, lastKey:%"PRId64", tid:%d, %"PRIx64,
                 pQueryHandle, cur->win.skey, cur->win.ekey, cur->rows, cur->lastKey, binfo.tid, pQueryHandle->qId);
     } else {
@@ -1594,9 +1818,17 @@ static int32_t loadFileDataBlock(STsdbQueryHandle* pQueryHandle, SBlock* pBlock,
   int32_t code = TSDB_CODE_SUCCESS;
   bool asc = ASCENDING_TRAVERSE(pQueryHandle->order);
 
+  pQueryHandle->rollupWin = -1;
+
   if (asc) {
     // query ended in/started from current block
     if (pQueryHandle->window.ekey < pBlock->keyLast || pCheckInfo->lastKey > pBlock->keyFirst) {
+      if (!fileBlockMayMatch(pQueryHandle, pBlock, pCheckInfo)) {
+        skipFileBlock(pQueryHandle, pBlock, pCheckInfo);
+        *exists = false;
+        return code;
+      }
+
       if ((code = doLoadFileDataBlock(pQueryHandle, pBlock, pCheckInfo, cur->slot)) != TSDB_CODE_SUCCESS) {
         *exists = false;
         return code;
@@ -1620,6 +1852,12 @@ static int32_t loadFileDataBlock(STsdbQueryHandle* pQueryHandle, SBlock* pBlock,
     }
   } else {  //desc order, query ended in current block
     if (pQueryHandle->window.ekey > pBlock->keyFirst || pCheckInfo->lastKey < pBlock->keyLast) {
+      if (!fileBlockMayMatch(pQueryHandle, pBlock, pCheckInfo)) {
+        skipFileBlock(pQueryHandle, pBlock, pCheckInfo);
+        *exists = false;
+        return code;
+      }
+
       if ((code = doLoadFileDataBlock(pQueryHandle, pBlock, pCheckInfo, cur->slot)) != TSDB_CODE_SUCCESS) {
         *exists = false;
         return code;
@@ -1704,7 +1942,6 @@ static int doBinarySearchKey(TSKEY* keyList, int num, int pos, TSKEY key, int or
 }
 
 static int32_t doCopyRowsFromFileBlock(STsdbQueryHandle* pQueryHandle, int32_t capacity, int32_t numOfRows, int32_t start, int32_t end) {
-  char* pData = NULL;
   int32_t step = ASCENDING_TRAVERSE(pQueryHandle->order)? 1 : -1;
 
   SDataCols* pCols = pQueryHandle->rhelper.pDCols[0];
@@ -1717,6 +1954,20 @@ static int32_t doCopyRowsFromFileBlock(STsdbQueryHandle* pQueryHandle, int32_t c
     return numOfRows;
   }
 
+  doCopyRowsFromDataCols(pQueryHandle, pCols, capacity, numOfRows, start, end);
+
+  pQueryHandle->cur.win.ekey = tsArray[end];
+  pQueryHandle->cur.lastKey = tsArray[end] + step;
+
+  return numOfRows + num;
+}
+
+// copy rows [start, end] of pCols to the result columns, used for both file blocks and column-wise memtable data
+static void doCopyRowsFromDataCols(STsdbQueryHandle* pQueryHandle, SDataCols* pCols, int32_t capacity, int32_t numOfRows,
+                                   int32_t start, int32_t end) {
+  char*   pData = NULL;
+  int32_t num = end - start + 1;
+
   int32_t requiredNumOfCols = (int32_t)taosArrayGetSize(pQueryHandle->pColumns);
 
   //data in buffer has greater timestamp, copy data in file block
@@ -1790,11 +2041,6 @@ static int32_t doCopyRowsFromFileBlock(STsdbQueryHandle* pQueryHandle, int32_t c
 
     i++;
   }
-
-  pQueryHandle->cur.win.ekey = tsArray[end];
-  pQueryHandle->cur.lastKey = tsArray[end] + step;
-
-  return numOfRows + num;
 }
 
 // Note: row1 always has high priority
@@ -2129,6 +2375,156 @@ int32_t getEndPosInDataBlock(STsdbQueryHandle* pQueryHandle, SDataBlockInfo* pBl
   return endPos;
 }
 
+static bool initMergeIndex(STsdbQueryHandle* pQueryHandle) {
+  if (pQueryHandle->mergeIndex == NULL) {
+    pQueryHandle->mergeIndex = malloc(sizeof(int32_t) * pQueryHandle->outputCapacity);
+    pQueryHandle->mergeRows = malloc(sizeof(SMemRow) * pQueryHandle->outputCapacity);
+    if (pQueryHandle->mergeIndex == NULL || pQueryHandle->mergeRows == NULL) {
+      tfree(pQueryHandle->mergeIndex);
+      tfree(pQueryHandle->mergeRows);
+      return false;
+    }
+  }
+
+  pQueryHandle->numOfMergeRows = 0;
+  return true;
+}
+
+static void appendMemRowToMergeIndex(STsdbQueryHandle* pQueryHandle, int32_t numOfRows, SMemRow row) {
+  pQueryHandle->mergeRows[pQueryHandle->numOfMergeRows] = row;
+  pQueryHandle->mergeIndex[numOfRows] = -(++pQueryHandle->numOfMergeRows);
+}
+
+// append the file block rows [start, end] in the query order, return the number of merged rows
+static int32_t appendFileRowsToMergeIndex(STsdbQueryHandle* pQueryHandle, int32_t numOfRows, int32_t start,
+                                          int32_t end) {
+  if (ASCENDING_TRAVERSE(pQueryHandle->order)) {
+    for (int32_t i = start; i <= end; ++i) {
+      pQueryHandle->mergeIndex[numOfRows++] = i;
+    }
+  } else {
+    for (int32_t i = end; i >= start; --i) {
+      pQueryHandle->mergeIndex[numOfRows++] = i;
+    }
+  }
+
+  return numOfRows;
+}
+
+static void copyFileColRows(SDataCol* src, char* pData, SColumnInfoData* pColInfo, int32_t start, int32_t num) {
+  int32_t bytes = pColInfo->info.bytes;
+
+  if (src == NULL) {
+    if (IS_VAR_DATA_TYPE(pColInfo->info.type)) {
+      for (int32_t k = 0; k < num; ++k, pData += bytes) {
+        setVardataNull(pData, pColInfo->info.type);
+      }
+    } else {
+      setNullN(pData, pColInfo->info.type, bytes, num);
+    }
+  } else if (IS_VAR_DATA_TYPE(pColInfo->info.type)) {
+    for (int32_t k = start; k < start + num; ++k, pData += bytes) {
+      const char* p = tdGetColDataOfRow(src, k);
+      memcpy(pData, p, varDataTLen(p));
+    }
+  } else {
+    memcpy(pData, (char*)src->pData + bytes * start, bytes * num);
+  }
+}
+
+static void copyMemRowCol(SMemRow row, STSchema* pSchema, char* pData, SColumnInfoData* pColInfo) {
+  int16_t colId = pColInfo->info.colId;
+  int8_t  type = pColInfo->info.type;
+  void*   value = NULL;
+
+  if (colId == PRIMARYKEY_TIMESTAMP_COL_INDEX) {
+    *(TSKEY*)pData = memRowKey(row);
+    return;
+  }
+
+  if (isDataRow(row)) {
+    STColumn* pCol = tdGetColOfID(pSchema, colId);
+    if (pCol != NULL) {
+      value = tdGetRowDataOfCol(memRowDataBody(row), type, TD_DATA_ROW_HEAD_SIZE + pCol->offset);
+    }
+  } else {
+    SColIdx* pColIdx = tdGetKVRowIdxOfCol(memRowKvBody(row), colId);
+    if (pColIdx != NULL) {
+      value = tdGetKvRowDataOfCol(memRowKvBody(row), pColIdx->offset);
+    }
+  }
+
+  if (value == NULL) {
+    if (IS_VAR_DATA_TYPE(type)) {
+      setVardataNull(pData, type);
+    } else {
+      setNull(pData, type, pColInfo->info.bytes);
+    }
+  } else if (IS_VAR_DATA_TYPE(type)) {
+    memcpy(pData, value, varDataTLen(value));
+  } else {
+    memcpy(pData, value, pColInfo->info.bytes);
+  }
+}
+
+/*
+ * Gather the columns of the merged rows in mergeIndex to the result buffer the same way as the rows are copied one by
+ * one: from the front of the buffer in ascending order, or to its end in descending order. The runs of file block
+ * rows are copied at once and the values of the memtable rows are read column by column.
+ */
+static void doGatherRowsByMergeIndex(STsdbQueryHandle* pQueryHandle, STable* pTable, int32_t numOfRows) {
+  SDataCols* pCols = pQueryHandle->rhelper.pDCols[0];
+  int32_t*   index = pQueryHandle->mergeIndex;
+  int32_t    numOfCols = (int32_t)taosArrayGetSize(pQueryHandle->pColumns);
+  int32_t    dstStart = 0;
+
+  // rows in the buffer are always in ascending order
+  if (!ASCENDING_TRAVERSE(pQueryHandle->order)) {
+    for (int32_t s = 0, e = numOfRows - 1; s < e; ++s, --e) {
+      SWAP(index[s], index[e], int32_t);
+    }
+    dstStart = pQueryHandle->outputCapacity - numOfRows;
+  }
+
+  for (int32_t i = 0, j = 0; i < numOfCols; ++i) {
+    SColumnInfoData* pColInfo = taosArrayGet(pQueryHandle->pColumns, i);
+    int32_t          bytes = pColInfo->info.bytes;
+    char*            pData = (char*)pColInfo->pData + dstStart * bytes;
+
+    while (j < pCols->numOfCols && pCols->cols[j].colId < pColInfo->info.colId) {
+      j++;
+    }
+
+    SDataCol* src = NULL;
+    if (j < pCols->numOfCols && pCols->cols[j].colId == pColInfo->info.colId && !isAllRowsNull(&pCols->cols[j])) {
+      src = &pCols->cols[j];
+    }
+
+    int16_t   rv = -1;
+    STSchema* pSchema = NULL;
+    for (int32_t r = 0; r < numOfRows;) {
+      if (index[r] >= 0) {
+        int32_t num = 1;
+        while (r + num < numOfRows && index[r + num] == index[r] + num) {
+          num++;
+        }
+
+        copyFileColRows(src, pData + r * bytes, pColInfo, index[r], num);
+        r += num;
+      } else {
+        SMemRow row = pQueryHandle->mergeRows[-index[r] - 1];
+        if (isDataRow(row) && rv != memRowVersion(row)) {
+          pSchema = tsdbGetTableSchemaByVersion(pTable, memRowVersion(row), (int8_t)memRowType(row));
+          rv = memRowVersion(row);
+        }
+
+        copyMemRowCol(row, pSchema, pData + r * bytes, pColInfo);
+        r++;
+      }
+    }
+  }
+}
+
 // only return the qualified data to client in terms of query time window, data rows in the same block but do not
 // be included in the query time window will be discarded
 static void doMergeTwoLevelData(STsdbQueryHandle* pQueryHandle, STableCheckInfo* pCheckInfo, SBlock* pBlock) {
@@ -2176,6 +2572,11 @@ static void doMergeTwoLevelData(STsdbQueryHandle* pQueryHandle, STableCheckInfo*
     return;
   } else if (pCheckInfo->iter != NULL || pCheckInfo->iiter != NULL) {
     SSkipListNode* node = NULL;
+
+    // the loop only decides the order of the rows with the merge index, their columns are gathered after it, except
+    // that a partial update merges a memtable row with the file row of the same key
+    bool useIndex = tsdbMergeIndex && (pCfg->update != TD_ROW_PARTIAL_UPDATE) && initMergeIndex(pQueryHandle);
+
     do {
       SMemRow row2 = NULL;
       SMemRow row1 = getSMemRowInTableMem(pCheckInfo, pQueryHandle->order, pCfg->update, &row2);
@@ -2200,16 +2601,20 @@ static void doMergeTwoLevelData(STsdbQueryHandle* pQueryHandle, STableCheckInfo*
 
       if ((keyMem < keyFile[pos] && ASCENDING_TRAVERSE(pQueryHandle->order)) ||
           (keyMem > keyFile[pos] && !ASCENDING_TRAVERSE(pQueryHandle->order))) {
-        if (rv1 != memRowVersion(row1)) {
-          pSchema1 = tsdbGetTableSchemaByVersion(pTable, memRowVersion(row1), (int8_t)memRowType(row1));
-          rv1 = memRowVersion(row1);
-        }
-        if(row2 && rv2 != memRowVersion(row2)) {
-          pSchema2 = tsdbGetTableSchemaByVersion(pTable, memRowVersion(row2), (int8_t)memRowType(row2));
-          rv2 = memRowVersion(row2);
+        if (useIndex) {
+          appendMemRowToMergeIndex(pQueryHandle, numOfRows, row1);
+        } else {
+          if (rv1 != memRowVersion(row1)) {
+            pSchema1 = tsdbGetTableSchemaByVersion(pTable, memRowVersion(row1), (int8_t)memRowType(row1));
+            rv1 = memRowVersion(row1);
+          }
+          if(row2 && rv2 != memRowVersion(row2)) {
+            pSchema2 = tsdbGetTableSchemaByVersion(pTable, memRowVersion(row2), (int8_t)memRowType(row2));
+            rv2 = memRowVersion(row2);
+          }
+
+          mergeTwoRowFromMem(pQueryHandle, pQueryHandle->outputCapacity, numOfRows, row1, row2, numOfCols, pTable, pSchema1, pSchema2, true);
         }
-        
-        mergeTwoRowFromMem(pQueryHandle, pQueryHandle->outputCapacity, numOfRows, row1, row2, numOfCols, pTable, pSchema1, pSchema2, true);
         numOfRows += 1;
         // record start key with memory key if not
         if (cur->win.skey == TSKEY_INITIAL_VAL) {
@@ -2224,20 +2629,24 @@ static void doMergeTwoLevelData(STsdbQueryHandle* pQueryHandle, STableCheckInfo*
       // same  select mem key if update is true
       } else if (keyMem == keyFile[pos]) {
         if (pCfg->update) {
-          if(pCfg->update == TD_ROW_PARTIAL_UPDATE) {
-            doCopyRowsFromFileBlock(pQueryHandle, pQueryHandle->outputCapacity, numOfRows, pos, pos);
-          }
-          if (rv1 != memRowVersion(row1)) {
-            pSchema1 = tsdbGetTableSchemaByVersion(pTable, memRowVersion(row1), (int8_t)memRowType(row1));
-            rv1 = memRowVersion(row1);
-          }
-          if(row2 && rv2 != memRowVersion(row2)) {
-            pSchema2 = tsdbGetTableSchemaByVersion(pTable, memRowVersion(row2), (int8_t)memRowType(row2));
-            rv2 = memRowVersion(row2);
+          if (useIndex) {
+            appendMemRowToMergeIndex(pQueryHandle, numOfRows, row1);
+          } else {
+            if(pCfg->update == TD_ROW_PARTIAL_UPDATE) {
+              doCopyRowsFromFileBlock(pQueryHandle, pQueryHandle->outputCapacity, numOfRows, pos, pos);
+            }
+            if (rv1 != memRowVersion(row1)) {
+              pSchema1 = tsdbGetTableSchemaByVersion(pTable, memRowVersion(row1), (int8_t)memRowType(row1));
+              rv1 = memRowVersion(row1);
+            }
+            if(row2 && rv2 != memRowVersion(row2)) {
+              pSchema2 = tsdbGetTableSchemaByVersion(pTable, memRowVersion(row2), (int8_t)memRowType(row2));
+              rv2 = memRowVersion(row2);
+            }
+
+            bool forceSetNull = pCfg->update != TD_ROW_PARTIAL_UPDATE;
+            mergeTwoRowFromMem(pQueryHandle, pQueryHandle->outputCapacity, numOfRows, row1, row2, numOfCols, pTable, pSchema1, pSchema2, forceSetNull);
           }
-          
-          bool forceSetNull = pCfg->update != TD_ROW_PARTIAL_UPDATE;
-          mergeTwoRowFromMem(pQueryHandle, pQueryHandle->outputCapacity, numOfRows, row1, row2, numOfCols, pTable, pSchema1, pSchema2, forceSetNull);
           numOfRows += 1;
           if (cur->win.skey == TSKEY_INITIAL_VAL) {
             cur->win.skey = keyMem;
@@ -2279,7 +2688,11 @@ static void doMergeTwoLevelData(STsdbQueryHandle* pQueryHandle, STableCheckInfo*
 
         if(qend >= qstart) {
           // copy qend - qstart + 1 rows from file
-          numOfRows = doCopyRowsFromFileBlock(pQueryHandle, pQueryHandle->outputCapacity, numOfRows, qstart, qend);
+          if (useIndex) {
+            numOfRows = appendFileRowsToMergeIndex(pQueryHandle, numOfRows, qstart, qend);
+          } else {
+            numOfRows = doCopyRowsFromFileBlock(pQueryHandle, pQueryHandle->outputCapacity, numOfRows, qstart, qend);
+          }
           int32_t num = qend - qstart + 1;
           pos += num * step;
         } else {
@@ -2310,7 +2723,11 @@ static void doMergeTwoLevelData(STsdbQueryHandle* pQueryHandle, STableCheckInfo*
         int32_t start = -1, end = -1;
         getQualifiedRowsPos(pQueryHandle, pos, endPos, numOfRows, &start, &end);
 
-        numOfRows = doCopyRowsFromFileBlock(pQueryHandle, pQueryHandle->outputCapacity, numOfRows, start, end);
+        if (useIndex) {
+          numOfRows = appendFileRowsToMergeIndex(pQueryHandle, numOfRows, start, end);
+        } else {
+          numOfRows = doCopyRowsFromFileBlock(pQueryHandle, pQueryHandle->outputCapacity, numOfRows, start, end);
+        }
         pos += (end - start + 1) * step;
 
         cur->win.ekey = ASCENDING_TRAVERSE(pQueryHandle->order)? keyFile[end] : keyFile[start];
@@ -2318,6 +2735,10 @@ static void doMergeTwoLevelData(STsdbQueryHandle* pQueryHandle, STableCheckInfo*
         cur->mixBlock = true;
       }
     }
+
+    if (useIndex) {
+      doGatherRowsByMergeIndex(pQueryHandle, pTable, numOfRows);
+    }
   }
 
   cur->blockCompleted =
@@ -2582,6 +3003,51 @@ static int32_t getDataBlockRv(STsdbQueryHandle* pQueryHandle, STableBlockInfo* p
   }
 }
 
+// Check by the summary of the current file set if the rows of any table in the query may match the filters. If not, the
+// file set is skipped without loading the block index and the block info of the tables.
+static bool fileSetMayMatch(STsdbQueryHandle* pQueryHandle) {
+  if (pQueryHandle->pFilters == NULL) {
+    return true;
+  }
+
+  SFSetSum* pSum = &pQueryHandle->fsetSum;
+  if (tsdbLoadFSetSum(&pQueryHandle->rhelper, pSum) < 0 || !pSum->valid) {
+    return true;
+  }
+
+  int16_t* colIds = pQueryHandle->defaultLoadColumn->pData;
+  int32_t  numOfCols = (int32_t)taosArrayGetSize(pQueryHandle->defaultLoadColumn);
+  size_t   numOfTables = taosArrayGetSize(pQueryHandle->pTableCheckInfo);
+  STable*  pSuper = NULL;
+
+  for (int32_t i = 0; i < numOfTables; ++i) {
+    STableCheckInfo* pCheckInfo = taosArrayGet(pQueryHandle->pTableCheckInfo, i);
+    STable*          pTable = pCheckInfo->pTableObj;
+
+    // the child tables of a super table are in the same group
+    if (pTable->pSuper != NULL && pTable->pSuper == pSuper) {
+      continue;
+    }
+    pSuper = pTable->pSuper;
+
+    if (tsdbFSetSumMayMatch(pSum, pTable, pQueryHandle->pFilters, pQueryHandle->fsetStatis, colIds, numOfCols)) {
+      return true;
+    }
+  }
+
+  // no blocks of the tables in the file set, as getFileCompInfo finds
+  for (int32_t i = 0; i < numOfTables; ++i) {
+    if (pQueryHandle->loadType == BLOCK_LOAD_TABLE_SEQ_ORDER && i != pQueryHandle->activeIndex) {
+      continue;
+    }
+
+    STableCheckInfo* pCheckInfo = taosArrayGet(pQueryHandle->pTableCheckInfo, i);
+    pCheckInfo->numOfBlocks = 0;
+  }
+
+  return false;
+}
+
 static int32_t getFirstFileDataBlock(STsdbQueryHandle* pQueryHandle, bool* exists) {
   pQueryHandle->numOfBlocks = 0;
   SQueryFilePos* cur = &pQueryHandle->cur;
@@ -2623,6 +3089,13 @@ static int32_t getFirstFileDataBlock(STsdbQueryHandle* pQueryHandle, bool* exist
 
     tsdbUnLockFS(REPO_FS(pQueryHandle->pTsdb));
 
+    if (!fileSetMayMatch(pQueryHandle)) {
+      pQueryHandle->cost.fileSkipped += 1;
+      tsdbDebug("%p file skipped by its summary for %d table(s), fid:%d, 0x%"PRIx64, pQueryHandle, numOfTables,
+                pQueryHandle->pFileGroup->fid, pQueryHandle->qId);
+      continue;
+    }
+
     if (tsdbLoadBlockIdx(&pQueryHandle->rhelper) < 0) {
       code = terrno;
       break;
@@ -2640,6 +3113,8 @@ static int32_t getFirstFileDataBlock(STsdbQueryHandle* pQueryHandle, bool* exist
       continue;
     }
 
+    tsdbRecordFSetRead(pQueryHandle->pTsdb, pQueryHandle->pFileGroup->fid);
+
     // todo return error code to query engine
     if ((code = createDataBlocksInfo(pQueryHandle, numOfBlocks, &pQueryHandle->numOfBlocks)) != TSDB_CODE_SUCCESS) {
       break;
@@ -2665,6 +3140,7 @@ static int32_t getFirstFileDataBlock(STsdbQueryHandle* pQueryHandle, bool* exist
   assert(pQueryHandle->pFileGroup != NULL && pQueryHandle->numOfBlocks > 0);
   cur->slot = ASCENDING_TRAVERSE(pQueryHandle->order)? 0:pQueryHandle->numOfBlocks-1;
   cur->fid = pQueryHandle->pFileGroup->fid;
+  pQueryHandle->readAheadPos = -1;
 
   STableBlockInfo* pBlockInfo = &pQueryHandle->pDataBlockInfo[cur->slot];
   return getDataBlockRv(pQueryHandle, pBlockInfo, exists);
@@ -2800,6 +3276,12 @@ static int32_t getDataBlocksInFiles(STsdbQueryHandle* pQueryHandle, bool* exists
     STableBlockInfo* pBlockInfo = &pQueryHandle->pDataBlockInfo[cur->slot];
     STableCheckInfo* pCheckInfo = pBlockInfo->pTableCheckInfo;
 
+    // the next rollup window of the current block if it is returned by windows
+    if (moveToNextRollupWin(pQueryHandle)) {
+      *exists = true;
+      return TSDB_CODE_SUCCESS;
+    }
+
     // current block is done, try next
     if ((!cur->mixBlock) || cur->blockCompleted) {
       // all data blocks in current file has been checked already, try next file if exists
@@ -2876,6 +3358,87 @@ static UNUSED_FUNC void changeQueryHandleForInterpQuery(TsdbQueryHandleT pHandle
   taosArrayPush(pQueryHandle->pTableCheckInfo, &info);
 }
 
+static STableData* getTableDataInMem(SMemTable* pMemT, STableCheckInfo* pCheckInfo) {
+  if (pMemT == NULL || pCheckInfo->tableId.tid >= pMemT->maxTables) {
+    return NULL;
+  }
+
+  STableData* pTableData = pMemT->tData[pCheckInfo->tableId.tid];
+  if (pTableData == NULL || pTableData->uid != pCheckInfo->tableId.uid) {
+    return NULL;
+  }
+
+  return pTableData;
+}
+
+/*
+ * Copy the rows in buffer from the column-wise memtable data directly, it only works when the rows come from one of
+ * mem and imem and the table data is kept column-wise. Return -1 if it does not work, the rows are read one by one then.
+ */
+static int tsdbReadRowsFromMemCols(STableCheckInfo* pCheckInfo, TSKEY maxKey, int maxRowsToRead, STimeWindow* win,
+                                   STsdbQueryHandle* pQueryHandle) {
+  SSkipListNode* pNode = (pCheckInfo->iter != NULL) ? tSkipListIterGet(pCheckInfo->iter) : NULL;
+  SSkipListNode* pINode = (pCheckInfo->iiter != NULL) ? tSkipListIterGet(pCheckInfo->iiter) : NULL;
+  if ((pNode == NULL) == (pINode == NULL)) {
+    return -1;
+  }
+
+  SSkipListIterator* pIter = (pNode != NULL) ? pCheckInfo->iter : pCheckInfo->iiter;
+  STableData* pTableData = (pNode != NULL) ? getTableDataInMem(pQueryHandle->pMemRef->snapshot.mem, pCheckInfo)
+                                           : getTableDataInMem(pQueryHandle->pMemRef->snapshot.imem, pCheckInfo);
+  if (pTableData == NULL) {
+    return -1;
+  }
+
+  TSKEY key = memRowKey((SMemRow)SL_GET_NODE_DATA((pNode != NULL) ? pNode : pINode));
+  bool  asc = ASCENDING_TRAVERSE(pQueryHandle->order);
+  if ((asc && key > maxKey) || (!asc && key < maxKey)) {
+    return -1;
+  }
+
+  taosRLockLatch(&pTableData->colsLatch);
+
+  SDataCols* pCols = pTableData->pCols;
+  int32_t    pos = (pCols == NULL) ? -1 : tsdbMemColsFindKey(pCols, key);
+  if (pos < 0) {
+    taosRUnLockLatch(&pTableData->colsLatch);
+    return -1;
+  }
+
+  // rows in pCols are in ascending order, find the range [start, end] to read in the query order
+  int32_t start = pos, end = pos;
+  if (asc) {
+    while (end + 1 < pCols->numOfRows && end - start + 1 < maxRowsToRead && dataColsKeyAt(pCols, end + 1) <= maxKey) {
+      end++;
+    }
+  } else {
+    while (start > 0 && end - start + 1 < maxRowsToRead && dataColsKeyAt(pCols, start - 1) >= maxKey) {
+      start--;
+    }
+  }
+
+  TSKEY skey = dataColsKeyAt(pCols, start);
+  TSKEY ekey = dataColsKeyAt(pCols, end);
+  doCopyRowsFromDataCols(pQueryHandle, pCols, maxRowsToRead, 0, start, end);
+
+  taosRUnLockLatch(&pTableData->colsLatch);
+
+  win->skey = asc ? skey : ekey;
+  win->ekey = asc ? ekey : skey;
+
+  // move the iterator over the rows copied as it is done when the rows are read one by one
+  SMemRow row = NULL;
+  while ((row = tsdbNextIterRow(pIter)) != NULL) {
+    TSKEY rowKey = memRowKey(row);
+    if ((asc && rowKey > ekey) || (!asc && rowKey < skey)) {
+      break;
+    }
+    tSkipListIterNext(pIter);
+  }
+
+  return end - start + 1;
+}
+
 static int tsdbReadRowsFromCache(STableCheckInfo* pCheckInfo, TSKEY maxKey, int maxRowsToRead, STimeWindow* win,
                                  STsdbQueryHandle* pQueryHandle) {
   int     numOfRows = 0;
@@ -2888,6 +3451,12 @@ static int tsdbReadRowsFromCache(STableCheckInfo* pCheckInfo, TSKEY maxKey, int
   int16_t rv = -1;
   STSchema* pSchema = NULL;
 
+  numOfRows = tsdbReadRowsFromMemCols(pCheckInfo, maxKey, maxRowsToRead, win, pQueryHandle);
+  if (numOfRows >= 0) {
+    goto _end;
+  }
+
+  numOfRows = 0;
   do {
     SMemRow row = getSMemRowInTableMem(pCheckInfo, pQueryHandle->order, pCfg->update, NULL);
     if (row == NULL) {
@@ -2920,6 +3489,7 @@ static int tsdbReadRowsFromCache(STableCheckInfo* pCheckInfo, TSKEY maxKey, int
 
   } while(moveToNextRowInMem(pCheckInfo));
 
+_end:
   assert(numOfRows <= maxRowsToRead);
 
   // if the buffer is not full in case of descending order query, move the data in the front of the buffer
@@ -3073,17 +3643,18 @@ static bool loadCachedLast(STsdbQueryHandle* pQueryHandle) {
     STable* pTable = pCheckInfo->pTableObj;  
     char* pData = NULL;
 
+    // lock pTable->lastCols[i] as it would be released when schema update(tsdbUpdateLastColSchema)
+    TSDB_RLOCK_TABLE(pTable);
     int32_t numOfCols = pTable->maxColNum;
     
     if (pTable->lastCols == NULL || pTable->maxColNum <= 0) {
+      TSDB_RUNLOCK_TABLE(pTable);
       tsdbWarn("no last cached for table %s, uid:%" PRIu64 ",tid:%d", pTable->name->data, pTable->tableId.uid, pTable->tableId.tid);
       continue;
     }
     
     int32_t i = 0, j = 0;
 
-    // lock pTable->lastCols[i] as it would be released when schema update(tsdbUpdateLastColSchema)
-    TSDB_RLOCK_TABLE(pTable);
     while(i < tgNumOfCols && j < numOfCols) {
       pColInfo = taosArrayGet(pQueryHandle->pColumns, i);
       if (pTable->lastCols[j].colId < pColInfo->info.colId) {
@@ -3636,6 +4207,54 @@ void tsdbRetrieveDataBlockInfo(TsdbQueryHandleT* pQueryHandle, SDataBlockInfo* p
   pDataBlockInfo->numOfCols = (int32_t)(QH_GET_NUM_OF_COLS(pHandle));
 }
 
+// the statistics of the current rollup window of a file block
+static void getRollupWinStatis(STsdbQueryHandle* pHandle) {
+  SRollupWin* pWin = TSDB_ROLLUP_WIN(&pHandle->rollup, pHandle->rollupWin);
+  int16_t*    colIds = pHandle->defaultLoadColumn->pData;
+  size_t      numOfCols = QH_GET_NUM_OF_COLS(pHandle);
+
+  memset(pHandle->statis, 0, numOfCols * sizeof(SDataStatis));
+  for(int32_t i = 0; i < numOfCols; ++i) {
+    pHandle->statis[i].colId = colIds[i];
+  }
+
+  tsdbGetRollupStatis(&pHandle->rollup, pHandle->rollupWin, pHandle->statis, (int)numOfCols);
+
+  SDataStatis* pPrimaryColStatis = &pHandle->statis[0];
+  assert(pPrimaryColStatis->colId == PRIMARYKEY_TIMESTAMP_COL_INDEX);
+
+  pPrimaryColStatis->numOfNull = 0;
+  pPrimaryColStatis->min = pWin->skey;
+  pPrimaryColStatis->max = pWin->ekey;
+}
+
+// the rows of the current rollup window of a file block, the block is loaded once for all its windows
+static SArray* doRetrieveRollupWin(STsdbQueryHandle* pHandle, STableBlockInfo* pBlockInfo) {
+  SQueryFilePos*      cur = &pHandle->cur;
+  STableCheckInfo*    pCheckInfo = pBlockInfo->pTableCheckInfo;
+  SDataBlockLoadInfo* pBlockLoadInfo = &pHandle->dataBlockLoadInfo;
+  SRollupWin*         pWin = TSDB_ROLLUP_WIN(&pHandle->rollup, pHandle->rollupWin);
+
+  if (pBlockLoadInfo->slot != cur->slot || pBlockLoadInfo->fileGroup->fid != cur->fid ||
+      pBlockLoadInfo->tid != pCheckInfo->pTableObj->tableId.tid) {
+    if (doLoadFileDataBlock(pHandle, pBlockInfo->compBlock, pCheckInfo, cur->slot) != TSDB_CODE_SUCCESS) {
+      return NULL;
+    }
+  }
+
+  // the position is still the whole block, only the rows are copied
+  STimeWindow win = cur->win;
+  int64_t     lastKey = cur->lastKey;
+
+  int32_t numOfRows =
+      doCopyRowsFromFileBlock(pHandle, pHandle->outputCapacity, 0, pWin->start, pWin->start + pWin->rows - 1);
+  moveDataToFront(pHandle, numOfRows, (int32_t)taosArrayGetSize(pHandle->pColumns));
+
+  cur->win = win;
+  cur->lastKey = lastKey;
+  return pHandle->pColumns;
+}
+
 /*
  * return null for mixed data block, if not a complete file data block, the statistics value will always return NULL
  */
@@ -3657,8 +4276,13 @@ int32_t tsdbRetrieveDataBlockStatisInfo(TsdbQueryHandleT* pQueryHandle, SDataSta
     return TSDB_CODE_SUCCESS;
   }
 
-  int64_t stime = taosGetTimestampUs();
-  int     statisStatus = tsdbLoadBlockStatis(&pHandle->rhelper, pBlockInfo->compBlock);
+  if (pHandle->rollupWin >= 0) {
+    getRollupWinStatis(pHandle);
+    *pBlockStatis = pHandle->statis;
+    return TSDB_CODE_SUCCESS;
+  }
+
+  int statisStatus = loadBlockStatis(pHandle, pBlockInfo->compBlock);
   if (statisStatus < TSDB_STATIS_OK) {
     return terrno;
   } else if (statisStatus > TSDB_STATIS_OK) {
@@ -3666,34 +4290,6 @@ int32_t tsdbRetrieveDataBlockStatisInfo(TsdbQueryHandleT* pQueryHandle, SDataSta
     return TSDB_CODE_SUCCESS;
   }
 
-  int16_t* colIds = pHandle->defaultLoadColumn->pData;
-
-  size_t numOfCols = QH_GET_NUM_OF_COLS(pHandle);
-  memset(pHandle->statis, 0, numOfCols * sizeof(SDataStatis));
-  for(int32_t i = 0; i < numOfCols; ++i) {
-    pHandle->statis[i].colId = colIds[i];
-  }
-
-  tsdbGetBlockStatis(&pHandle->rhelper, pHandle->statis, (int)numOfCols, pBlockInfo->compBlock);
-
-  // always load the first primary timestamp column data
-  SDataStatis* pPrimaryColStatis = &pHandle->statis[0];
-  assert(pPrimaryColStatis->colId == PRIMARYKEY_TIMESTAMP_COL_INDEX);
-
-  pPrimaryColStatis->numOfNull = 0;
-  pPrimaryColStatis->min = pBlockInfo->compBlock->keyFirst;
-  pPrimaryColStatis->max = pBlockInfo->compBlock->keyLast;
-
-  //update the number of NULL data rows
-  for(int32_t i = 1; i < numOfCols; ++i) {
-    if (pHandle->statis[i].numOfNull == -1) { // set the column data are all NULL
-      pHandle->statis[i].numOfNull = pBlockInfo->compBlock->numOfRows;
-    }
-  }
-
-  int64_t elapsed = taosGetTimestampUs() - stime;
-  pHandle->cost.statisInfoLoadTime += elapsed;
-
   *pBlockStatis = pHandle->statis;
   return TSDB_CODE_SUCCESS;
 }
@@ -3717,6 +4313,10 @@ SArray* tsdbRetrieveDataBlock(TsdbQueryHandleT* pQueryHandle, SArray* pIdList) {
       SDataBlockInfo binfo = GET_FILE_DATA_BLOCK_INFO(pCheckInfo, pBlockInfo->compBlock);
       assert(pHandle->realNumOfRows <= binfo.rows);
 
+      if (pHandle->rollupWin >= 0) {
+        return doRetrieveRollupWin(pHandle, pBlockInfo);
+      }
+
       // data block has been loaded, todo extract method
       SDataBlockLoadInfo* pBlockLoadInfo = &pHandle->dataBlockLoadInfo;
 
@@ -4161,6 +4761,11 @@ void tsdbCleanupQueryHandle(TsdbQueryHandleT queryHandle) {
   taosArrayDestroy(&pQueryHandle->defaultLoadColumn);
   tfree(pQueryHandle->pDataBlockInfo);
   tfree(pQueryHandle->statis);
+  tfree(pQueryHandle->fsetStatis);
+  tsdbDestroyFSetSum(&pQueryHandle->fsetSum);
+  tsdbDestroyBlockRollup(&pQueryHandle->rollup);
+  tfree(pQueryHandle->mergeIndex);
+  tfree(pQueryHandle->mergeRows);
 
   if (!emptyQueryTimewindow(pQueryHandle)) {
     tsdbMayUnTakeMemSnapshot(pQueryHandle);
@@ -4169,6 +4774,7 @@ void tsdbCleanupQueryHandle(TsdbQueryHandleT queryHandle) {
   }
 
   if (pQueryHandle->pTableCheckInfo != NULL) {
+    unpinCacheLast(pQueryHandle);
     pQueryHandle->pTableCheckInfo = destroyTableCheckInfo(pQueryHandle->pTableCheckInfo);
   }
 
@@ -4182,8 +4788,8 @@ void tsdbCleanupQueryHandle(TsdbQueryHandleT queryHandle) {
 
   SIOCostSummary* pCost = &pQueryHandle->cost;
 
-  tsdbDebug("%p :io-cost summary: head-file read cnt:%"PRIu64", head-file time:%"PRIu64" us, statis-info:%"PRId64" us, datablock:%" PRId64" us, check data:%"PRId64" us, 0x%"PRIx64,
-      pQueryHandle, pCost->headFileLoad, pCost->headFileLoadTime, pCost->statisInfoLoadTime, pCost->blockLoadTime, pCost->checkForNextTime, pQueryHandle->qId);
+  tsdbDebug("%p :io-cost summary: head-file read cnt:%"PRIu64", head-file time:%"PRIu64" us, file skipped:%"PRId64", block skipped:%"PRId64", statis-info:%"PRId64" us, datablock:%" PRId64" us, check data:%"PRId64" us, 0x%"PRIx64,
+      pQueryHandle, pCost->headFileLoad, pCost->headFileLoadTime, pCost->fileSkipped, pCost->blockSkipped, pCost->statisInfoLoadTime, pCost->blockLoadTime, pCost->checkForNextTime, pQueryHandle->qId);
 
   tfree(pQueryHandle);
 }
@@ -13,15 +13,14 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include "tglobal.h"
 #include "tsdbint.h"
 
-#define TSDB_KEY_COL_OFFSET 0
-
 static void tsdbResetReadTable(SReadH *pReadh);
 static void tsdbResetReadFile(SReadH *pReadh);
 static int  tsdbLoadBlockDataImpl(SReadH *pReadh, SBlock *pBlock, SDataCols *pDataCols);
-static int  tsdbCheckAndDecodeColumnData(SDataCol *pDataCol, void *content, int32_t len, int8_t comp, int numOfRows,
-                                         int maxPoints, char *buffer, int bufferSize);
+static int  tsdbCheckAndDecodeColumnData(SDataCol *pDataCol, void *content, int32_t len, int8_t comp, int8_t codec,
+                                         int numOfRows, int maxPoints, char *buffer, int bufferSize);
 static int  tsdbLoadBlockDataColsImpl(SReadH *pReadh, SBlock *pBlock, SDataCols *pDataCols, int16_t *colIds,
                                       int numOfColIds);
 static int  tsdbLoadColData(SReadH *pReadh, SDFile *pDFile, SBlock *pBlock, SBlockCol *pBlockCol, SDataCol *pDataCol);
@@ -515,6 +514,30 @@ int tsdbLoadBlockOffset(SReadH *pReadh, SBlock *pBlock) {
   return tsdbLoadBlockStatisFromDFile(pReadh, pBlock);
 }
 
+/**
+ * Start to read the parts of a block into the page cache without waiting for them, so that the block is loaded from
+ * memory later while the blocks before it are decoded.
+ */
+void tsdbReadAheadBlock(SReadH *pReadh, SBlock *pBlock, SBlockInfo *pBlkInfo) {
+  ASSERT(pBlock->numOfSubBlocks > 0);
+
+  SBlock *iBlock = pBlock;
+  if (pBlock->numOfSubBlocks > 1) {
+    iBlock = POINTER_SHIFT((pBlkInfo != NULL) ? pBlkInfo : pReadh->pBlkInfo, pBlock->offset);
+  }
+
+  for (int i = 0; i < pBlock->numOfSubBlocks; i++, iBlock++) {
+    SDFile *pDFile = (iBlock->last) ? TSDB_READ_LAST_FILE(pReadh) : TSDB_READ_DATA_FILE(pReadh);
+    tsdbReadAheadDFile(pDFile, iBlock->offset, iBlock->len);
+  }
+
+  // The statistics are only loaded for a block without sub-blocks
+  if (pBlock->numOfSubBlocks == 1 && pBlock->blkVer > TSDB_SBLK_VER_0 && pBlock->aggrStat) {
+    SDFile *pDFileAggr = (pBlock->last) ? TSDB_READ_SMAL_FILE(pReadh) : TSDB_READ_SMAD_FILE(pReadh);
+    tsdbReadAheadDFile(pDFileAggr, pBlock->aggrOffset, tsdbBlockAggrSize(pBlock->numOfCols, (uint32_t)pBlock->blkVer));
+  }
+}
+
 int tsdbEncodeSBlockIdx(void **buf, SBlockIdx *pIdx) {
   int tlen = 0;
 
@@ -651,6 +674,10 @@ static int tsdbLoadBlockDataImpl(SReadH *pReadh, SBlock *pBlock, SDataCols *pDat
     return -1;
   }
 
+  if ((pBlock->last ? pReadh->dropLastCache : pReadh->dropDataCache) && tsdbWriteBackSize > 0) {
+    tsdbDropDFileCache(pDFile, pBlock->offset, pBlock->len);
+  }
+
   int32_t tsize = (int32_t)tsdbBlockStatisSize(pBlock->numOfCols, (uint32_t)pBlock->blkVer);
   if (!taosCheckChecksumWhole((uint8_t *)TSDB_READ_BUF(pReadh), tsize)) {
     terrno = TSDB_CODE_TDB_FILE_CORRUPTED;
@@ -699,7 +726,8 @@ static int tsdbLoadBlockDataImpl(SReadH *pReadh, SBlock *pBlock, SDataCols *pDat
       }
 
       if (tsdbCheckAndDecodeColumnData(pDataCol, POINTER_SHIFT(pBlockData, tsize + toffset), tlen, pBlock->algorithm,
-                                       pBlock->numOfRows, pDataCols->maxPoints, TSDB_READ_COMP_BUF(pReadh),
+                                       (dcol == 0) ? TSDB_COL_CODEC_NONE : pBlockCol->codec, pBlock->numOfRows,
+                                       pDataCols->maxPoints, TSDB_READ_COMP_BUF(pReadh),
                                        (int)taosTSizeof(TSDB_READ_COMP_BUF(pReadh))) < 0) {
         tsdbError("vgId:%d file %s is broken at column %d block offset %" PRId64 " column offset %u",
                   TSDB_READ_REPO_ID(pReadh), TSDB_FILE_FULL_NAME(pDFile), tcolId, (int64_t)pBlock->offset, toffset);
@@ -722,8 +750,8 @@ static int tsdbLoadBlockDataImpl(SReadH *pReadh, SBlock *pBlock, SDataCols *pDat
   return 0;
 }
 
-static int tsdbCheckAndDecodeColumnData(SDataCol *pDataCol, void *content, int32_t len, int8_t comp, int numOfRows,
-                                        int maxPoints, char *buffer, int bufferSize) {
+static int tsdbCheckAndDecodeColumnData(SDataCol *pDataCol, void *content, int32_t len, int8_t comp, int8_t codec,
+                                        int numOfRows, int maxPoints, char *buffer, int bufferSize) {
   if (!taosCheckChecksumWhole((uint8_t *)content, len)) {
     terrno = TSDB_CODE_TDB_FILE_CORRUPTED;
     return -1;
@@ -732,7 +760,16 @@ static int tsdbCheckAndDecodeColumnData(SDataCol *pDataCol, void *content, int32
   tdAllocMemForCol(pDataCol, maxPoints);
 
   // Decode the data
-  if (comp) {
+  if (codec != TSDB_COL_CODEC_NONE) {
+    int tlen = tsdbDecodeColumn(pDataCol, codec, content, len - sizeof(TSCKSUM), numOfRows);
+    if (tlen < 0) {
+      tsdbError("Failed to decode column, file corrupted, len:%d codec:%d numOfRows:%d maxPoints:%d", len, codec,
+                numOfRows, maxPoints);
+      terrno = TSDB_CODE_TDB_FILE_CORRUPTED;
+      return -1;
+    }
+    pDataCol->len = tlen;
+  } else if (comp) {
     // Need to decompress
     int tlen = (*(tDataTypes[pDataCol->type].decompFunc))(content, len - sizeof(TSCKSUM), numOfRows, pDataCol->pData,
                                                              pDataCol->spaceSize, comp, buffer, bufferSize);
@@ -765,13 +802,12 @@ static int tsdbLoadBlockDataColsImpl(SReadH *pReadh, SBlock *pBlock, SDataCols *
 
   tdResetDataCols(pDataCols);
 
-  // If only load timestamp column, no need to load SBlockData part
-  if (numOfColIds > 1 && tsdbLoadBlockOffset(pReadh, pBlock) < 0) return -1;
-
   pDataCols->numOfRows = pBlock->numOfRows;
 
-  int dcol = 0;
-  int ccol = 0;
+  // The SBlockData part is only loaded when a non-key column is not in the block cache
+  bool offsetLoaded = false;
+  int  dcol = 0;
+  int  ccol = 0;
   for (int i = 0; i < numOfColIds; i++) {
     int16_t    colId = colIds[i];
     SDataCol * pDataCol = NULL;
@@ -795,6 +831,8 @@ static int tsdbLoadBlockDataColsImpl(SReadH *pReadh, SBlock *pBlock, SDataCols *
     if (pDataCol == NULL) continue;
     ASSERT(pDataCol->colId == colId);
 
+    if (tsdbGetCachedColData(pReadh, pBlock, pDataCol)) continue;
+
     if (colId == 0) {  // load the key row
       blockCol.colId = colId;
       blockCol.len = pBlock->keyLen;
@@ -802,6 +840,11 @@ static int tsdbLoadBlockDataColsImpl(SReadH *pReadh, SBlock *pBlock, SDataCols *
       blockCol.offset = TSDB_KEY_COL_OFFSET;
       pBlockCol = &blockCol;
     } else {  // load non-key rows
+      if (!offsetLoaded) {
+        if (tsdbLoadBlockOffset(pReadh, pBlock) < 0) return -1;
+        offsetLoaded = true;
+      }
+
       while (true) {
         if (ccol >= pBlock->numOfCols) {
           pBlockCol = NULL;
@@ -829,6 +872,7 @@ static int tsdbLoadBlockDataColsImpl(SReadH *pReadh, SBlock *pBlock, SDataCols *
     }
 
     if (tsdbLoadColData(pReadh, pDFile, pBlock, pBlockCol, pDataCol) < 0) return -1;
+    tsdbCacheColData(pReadh, pBlock, pDataCol);
   }
 
   return 0;
@@ -867,8 +911,9 @@ static int tsdbLoadColData(SReadH *pReadh, SDFile *pDFile, SBlock *pBlock, SBloc
     return -1;
   }
 
-  if (tsdbCheckAndDecodeColumnData(pDataCol, pReadh->pBuf, pBlockCol->len, pBlock->algorithm, pBlock->numOfRows,
-                                   pCfg->maxRowsPerFileBlock, pReadh->pCBuf, (int32_t)taosTSizeof(pReadh->pCBuf)) < 0) {
+  if (tsdbCheckAndDecodeColumnData(pDataCol, pReadh->pBuf, pBlockCol->len, pBlock->algorithm, pBlockCol->codec,
+                                   pBlock->numOfRows, pCfg->maxRowsPerFileBlock, pReadh->pCBuf,
+                                   (int32_t)taosTSizeof(pReadh->pCBuf)) < 0) {
     tsdbError("vgId:%d file %s is broken at column %d offset %" PRId64, REPO_ID(pRepo), TSDB_FILE_FULL_NAME(pDFile),
               pBlockCol->colId, offset);
     return -1;
@@ -0,0 +1,309 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "tglobal.h"
+#include "tsdbint.h"
+
+static TSKEY tsdbRollupWinEnd(SRollupLevelCfg *pLevel, TSKEY key, int8_t precision);
+static int   tsdbRollupNextWin(SDataCols *pDataCols, int start, TSKEY ekey);
+static int   tsdbRollupLevelCmpr(const void *p1, const void *p2);
+
+// Parse the rollup levels of the rollupLevels option in the precision of the repository, such as 1m,1h,1d
+void tsdbInitRollupCfg(STsdbRepo *pRepo) {
+  SRollupCfg *pCfg = &(pRepo->rollupCfg);
+  char        levels[TSDB_ROLLUP_LEVELS_LEN] = "\0";
+  char *      saveptr = NULL;
+
+  memset(pCfg, 0, sizeof(*pCfg));
+  tstrncpy(levels, tsdbRollupLevels, sizeof(levels));
+
+  for (char *token = strtok_r(levels, ", ", &saveptr); token; token = strtok_r(NULL, ", ", &saveptr)) {
+    SRollupLevelCfg level = {0};
+
+    if (pCfg->numOfLevels >= TSDB_MAX_ROLLUP_LEVELS) {
+      tsdbWarn("vgId:%d rollup level %s is ignored since at most %d levels are kept", REPO_ID(pRepo), token,
+               TSDB_MAX_ROLLUP_LEVELS);
+      continue;
+    }
+
+    if (parseAbsoluteDuration(token, (int32_t)strlen(token), &level.resolution, &level.unit,
+                              REPO_CFG(pRepo)->precision) < 0 ||
+        level.resolution < TSDB_TICK_PER_SECOND(REPO_CFG(pRepo)->precision)) {
+      tsdbWarn("vgId:%d rollup level %s is ignored since it is not a duration of one second or more", REPO_ID(pRepo),
+               token);
+      continue;
+    }
+
+    pCfg->levels[pCfg->numOfLevels++] = level;
+  }
+
+  qsort(pCfg->levels, pCfg->numOfLevels, sizeof(SRollupLevelCfg), tsdbRollupLevelCmpr);
+}
+
+/**
+ * Encode the rollup of the rows in pDataCols at offset of *ppBuf, with the columns of the aggregate part of the block.
+ * Return the length of the rollup, 0 if no level has more than one window and enough rows in each window, or -1.
+ */
+int32_t tsdbEncodeBlockRollup(STsdbRepo *pRepo, SDataCols *pDataCols, SAggrBlkData *pAggrBlkData, int nCols,
+                              void **ppBuf, int32_t offset) {
+  SRollupCfg *pCfg = &(pRepo->rollupCfg);
+  int8_t      precision = REPO_CFG(pRepo)->precision;
+  int         rows = pDataCols->numOfRows;
+  int32_t     nWins[TSDB_MAX_ROLLUP_LEVELS] = {0};
+  int         nLevels = 0;
+  int32_t     tsize = sizeof(SRollupHead) + sizeof(TSCKSUM);
+
+  if (pCfg->numOfLevels == 0) return 0;
+
+  // Count the windows of each level first
+  for (int l = 0; l < pCfg->numOfLevels; l++) {
+    SRollupLevelCfg *pLevel = pCfg->levels + l;
+
+    for (int i = 0; i < rows; nWins[l]++) {
+      i = tsdbRollupNextWin(pDataCols, i, tsdbRollupWinEnd(pLevel, dataColsKeyAt(pDataCols, i), precision));
+    }
+
+    if (nWins[l] <= 1 || nWins[l] * TSDB_ROLLUP_MIN_ROWS_PER_WIN > rows) {
+      nWins[l] = 0;
+      continue;
+    }
+
+    nLevels++;
+    tsize += sizeof(SRollupLevel) + TSDB_ROLLUP_WIN_SIZE(nCols) * nWins[l];
+  }
+
+  if (nLevels == 0) return 0;
+
+  if (tsdbMakeRoom(ppBuf, offset + tsize) < 0) return -1;
+
+  SAggrBlkCol *pAggrCols = (SAggrBlkCol *)pAggrBlkData;
+
+  SRollupHead *pHead = (SRollupHead *)POINTER_SHIFT(*ppBuf, offset);
+  pHead->delimiter = TSDB_FILE_DELIMITER;
+  pHead->numOfLevels = (int16_t)nLevels;
+  pHead->numOfCols = (int16_t)nCols;
+
+  SRollupLevel *pRLevel = (SRollupLevel *)POINTER_SHIFT(pHead, sizeof(*pHead));
+  SRollupWin *  pWin = (SRollupWin *)(pRLevel + nLevels);
+  for (int l = 0; l < pCfg->numOfLevels; l++) {
+    SRollupLevelCfg *pLevel = pCfg->levels + l;
+    if (nWins[l] == 0) continue;
+
+    memset(pRLevel, 0, sizeof(*pRLevel));
+    pRLevel->resolution = pLevel->resolution;
+    pRLevel->unit = pLevel->unit;
+    pRLevel->numOfWins = nWins[l];
+    pRLevel++;
+
+    for (int i = 0; i < rows;) {
+      int next = tsdbRollupNextWin(pDataCols, i, tsdbRollupWinEnd(pLevel, dataColsKeyAt(pDataCols, i), precision));
+
+      pWin->skey = dataColsKeyAt(pDataCols, i);
+      pWin->ekey = dataColsKeyAt(pDataCols, next - 1);
+      pWin->start = i;
+      pWin->rows = next - i;
+
+      // The columns of the aggregate part are the data columns not all NULL, both are sorted by colId
+      SAggrBlkCol *pAggrCol = (SAggrBlkCol *)POINTER_SHIFT(pWin, sizeof(SRollupWin));
+      for (int c = 0, dcol = 1; c < nCols; c++, pAggrCol++) {
+        while (pDataCols->cols[dcol].colId != pAggrCols[c].colId) dcol++;
+        SDataCol *pDataCol = pDataCols->cols + dcol;
+
+        memset(pAggrCol, 0, sizeof(*pAggrCol));
+        pAggrCol->colId = pDataCol->colId;
+        if (tDataTypes[pDataCol->type].statisFunc) {
+          (*tDataTypes[pDataCol->type].statisFunc)(tdGetColDataOfRow(pDataCol, i), pWin->rows, &(pAggrCol->min),
+                                                   &(pAggrCol->max), &(pAggrCol->sum), &(pAggrCol->minIndex),
+                                                   &(pAggrCol->maxIndex), &(pAggrCol->numOfNull));
+        }
+      }
+
+      pWin = (SRollupWin *)POINTER_SHIFT(pWin, TSDB_ROLLUP_WIN_SIZE(nCols));
+      i = next;
+    }
+  }
+
+  taosCalcChecksumAppend(0, (uint8_t *)pHead, tsize);
+  return tsize;
+}
+
+// The length of the block without its rollup
+int32_t tsdbBlockDataEnd(SBlock *pBlock, SBlockData *pBlockData) {
+  SBlockCol  blockCol = {0};
+  SBlockCol *pBlockCol = &blockCol;
+  int32_t    end = (int32_t)tsdbBlockStatisSize(pBlock->numOfCols, (uint32_t)pBlock->blkVer) + pBlock->keyLen;
+
+  for (int i = 0; i < pBlock->numOfCols; i++) {
+    tsdbGetSBlockCol(pBlock, &pBlockCol, pBlockData->cols, i);
+    end += pBlockCol->len;
+  }
+
+  return end;
+}
+
+// Check the checksum and the layout of a rollup of len bytes, and that the windows of each level cover the block
+bool tsdbCheckBlockRollup(void *pRollup, int32_t len, SBlock *pBlock) {
+  SRollupHead *pHead = (SRollupHead *)pRollup;
+
+  if (len < (int32_t)(sizeof(SRollupHead) + sizeof(TSCKSUM)) || !taosCheckChecksumWhole((uint8_t *)pRollup, len) ||
+      pHead->delimiter != TSDB_FILE_DELIMITER || pHead->numOfCols != pBlock->numOfCols || pHead->numOfLevels <= 0) {
+    return false;
+  }
+
+  int64_t       tsize = sizeof(SRollupHead) + sizeof(SRollupLevel) * pHead->numOfLevels + sizeof(TSCKSUM);
+  SRollupLevel *pLevel = (SRollupLevel *)POINTER_SHIFT(pHead, sizeof(*pHead));
+  if (tsize > len) return false;
+
+  SRollupWin *pWin = (SRollupWin *)(pLevel + pHead->numOfLevels);
+  for (int l = 0; l < pHead->numOfLevels; l++, pLevel++) {
+    tsize += TSDB_ROLLUP_WIN_SIZE(pHead->numOfCols) * (int64_t)pLevel->numOfWins;
+    if (pLevel->numOfWins <= 0 || pLevel->resolution <= 0 || tsize > len) return false;
+
+    int32_t rows = 0;
+    for (int w = 0; w < pLevel->numOfWins; w++) {
+      if (pWin->start != rows || pWin->rows <= 0 || pWin->skey > pWin->ekey) return false;
+      rows += pWin->rows;
+      pWin = (SRollupWin *)POINTER_SHIFT(pWin, TSDB_ROLLUP_WIN_SIZE(pHead->numOfCols));
+    }
+    if (rows != pBlock->numOfRows) return false;
+  }
+
+  return tsize == len;
+}
+
+/**
+ * Load the rollup of a block and choose the coarsest level whose windows divide the windows of interval. Return the
+ * number of windows of the level, 0 if the block has no rollup or no level fits, or -1 if the rollup is corrupted.
+ */
+int tsdbLoadBlockRollup(SReadH *pReadh, SBlock *pBlock, int64_t interval, SBlockRollup *pRollup) {
+  pRollup->numOfWins = 0;
+  pRollup->pWins = NULL;
+
+  if (pBlock->numOfSubBlocks > 1 || pBlock->blkVer == TSDB_SBLK_VER_0 || interval <= 0) return 0;
+
+  if (tsdbLoadBlockOffset(pReadh, pBlock) < 0) return -1;
+
+  int32_t end = tsdbBlockDataEnd(pBlock, pReadh->pBlkData);
+  int32_t len = pBlock->len - end;
+  if (len <= 0) return 0;
+
+  SDFile *pDFile = (pBlock->last) ? TSDB_READ_LAST_FILE(pReadh) : TSDB_READ_DATA_FILE(pReadh);
+  if (tsdbMakeRoom(&(pRollup->pBuf), len) < 0) return -1;
+  if (tsdbSeekDFile(pDFile, pBlock->offset + end, SEEK_SET) < 0) {
+    tsdbError("vgId:%d failed to load block rollup while seek file %s to offset %" PRId64 " since %s",
+              TSDB_READ_REPO_ID(pReadh), TSDB_FILE_FULL_NAME(pDFile), (int64_t)pBlock->offset + end,
+              tstrerror(terrno));
+    return -1;
+  }
+
+  int64_t nread = tsdbReadDFile(pDFile, pRollup->pBuf, len);
+  if (nread < 0) {
+    tsdbError("vgId:%d failed to load block rollup while read file %s since %s, offset:%" PRId64 " len:%d",
+              TSDB_READ_REPO_ID(pReadh), TSDB_FILE_FULL_NAME(pDFile), tstrerror(terrno),
+              (int64_t)pBlock->offset + end, len);
+    return -1;
+  }
+
+  if (nread < len || !tsdbCheckBlockRollup(pRollup->pBuf, len, pBlock)) {
+    terrno = TSDB_CODE_TDB_FILE_CORRUPTED;
+    tsdbError("vgId:%d block rollup in file %s is corrupted, offset:%" PRId64 " len:%d", TSDB_READ_REPO_ID(pReadh),
+              TSDB_FILE_FULL_NAME(pDFile), (int64_t)pBlock->offset + end, len);
+    return -1;
+  }
+
+  SRollupHead * pHead = (SRollupHead *)pRollup->pBuf;
+  SRollupLevel *pLevel = (SRollupLevel *)POINTER_SHIFT(pHead, sizeof(*pHead));
+  void *        pWins = pLevel + pHead->numOfLevels;
+
+  pRollup->numOfCols = pHead->numOfCols;
+  for (int l = 0; l < pHead->numOfLevels; l++, pLevel++) {
+    if (interval % pLevel->resolution == 0) {
+      pRollup->numOfWins = pLevel->numOfWins;
+      pRollup->pWins = pWins;
+    }
+    pWins = POINTER_SHIFT(pWins, TSDB_ROLLUP_WIN_SIZE(pHead->numOfCols) * pLevel->numOfWins);
+  }
+
+  return pRollup->numOfWins;
+}
+
+// Get the statistics of the window idx as tsdbGetBlockStatis does for a block, the key column is not set
+void tsdbGetRollupStatis(SBlockRollup *pRollup, int idx, SDataStatis *pStatis, int numOfCols) {
+  SRollupWin * pWin = TSDB_ROLLUP_WIN(pRollup, idx);
+  SAggrBlkCol *pAggrCols = (SAggrBlkCol *)POINTER_SHIFT(pWin, sizeof(SRollupWin));
+
+  for (int i = 0, j = 0; i < numOfCols;) {
+    if (j >= pRollup->numOfCols) {
+      pStatis[i].numOfNull = pWin->rows;
+      i++;
+      continue;
+    }
+
+    SAggrBlkCol *pAggrCol = pAggrCols + j;
+    if (pStatis[i].colId == pAggrCol->colId) {
+      pStatis[i].sum = pAggrCol->sum;
+      pStatis[i].max = pAggrCol->max;
+      pStatis[i].min = pAggrCol->min;
+      pStatis[i].maxIndex = pAggrCol->maxIndex;
+      pStatis[i].minIndex = pAggrCol->minIndex;
+      pStatis[i].numOfNull = pAggrCol->numOfNull;
+      i++;
+      j++;
+    } else if (pStatis[i].colId < pAggrCol->colId) {
+      pStatis[i].numOfNull = pWin->rows;
+      i++;
+    } else {
+      j++;
+    }
+  }
+}
+
+void tsdbDestroyBlockRollup(SBlockRollup *pRollup) {
+  pRollup->pBuf = taosTZfree(pRollup->pBuf);
+  pRollup->pWins = NULL;
+  pRollup->numOfWins = 0;
+}
+
+static TSKEY tsdbRollupWinEnd(SRollupLevelCfg *pLevel, TSKEY key, int8_t precision) {
+  SInterval interval = {.intervalUnit = pLevel->unit,
+                        .slidingUnit = pLevel->unit,
+                        .interval = pLevel->resolution,
+                        .sliding = pLevel->resolution};
+
+  return taosTimeTruncate(key, &interval, precision) + pLevel->resolution - 1;
+}
+
+// The first row after start with a key greater than ekey
+static int tsdbRollupNextWin(SDataCols *pDataCols, int start, TSKEY ekey) {
+  int lo = start + 1;
+  int hi = pDataCols->numOfRows;
+
+  while (lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+    if (dataColsKeyAt(pDataCols, mid) <= ekey) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  return lo;
+}
+
+static int tsdbRollupLevelCmpr(const void *p1, const void *p2) {
+  int64_t r1 = ((SRollupLevelCfg *)p1)->resolution;
+  int64_t r2 = ((SRollupLevelCfg *)p2)->resolution;
+
+  return (r1 < r2) ? -1 : ((r1 > r2) ? 1 : 0);
+}
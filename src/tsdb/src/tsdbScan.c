@@ -13,26 +13,738 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include "tcompare.h"
 #include "tsdbint.h"
+#include "tsdbScan.h"
 
-#if 0
 #ifndef _TSDB_PLUGINS
 
-int tsdbScanFGroup(STsdbScanHandle* pScanHandle, char* rootDir, int fid) { return 0; }
+struct STsdbScanHandle {
+  STsdbRepo *    pRepo;  // the read helpers only use the id and the config of it
+  SReadH         readh;
+  FILE *         fLogStream;
+  bool           tableStat;
+  bool           opened;
+  int            vid;
+  int            fid;
+  int32_t        nErrors;  // problems found in the FSET
+  int32_t        nTables;
+  STableScanStat total;  // sum of the FSET
+  SArray *       aTableStat;
+  void *         pDBuf;  // decoded column
+  void *         pZBuf;  // buffer of the two stage decompression
+};
 
-STsdbScanHandle* tsdbNewScanHandle() { return NULL; }
+typedef struct {
+  char *  buf;
+  size_t  size;
+  int     nErrors;  // -1 if the FSET is not scanned
+  int32_t code;
+  int     nTables;
 
-void tsdbSetScanLogStream(STsdbScanHandle* pScanHandle, FILE* fLogStream) {}
+  STableScanStat total;
+} SScanFSetResult;
 
-int tsdbSetAndOpenScanFile(STsdbScanHandle* pScanHandle, char* rootDir, int fid) { return 0; }
+typedef struct {
+  const char *     dataDir;
+  int              vid;
+  bool             tableStat;
+  SArray *         aFid;
+  int32_t          next;  // index of the next FSET to scan in aFid
+  SScanFSetResult *results;
+} SScanJob;
 
-int tsdbScanSBlockIdx(STsdbScanHandle* pScanHandle) { return 0; }
+#define TSDB_SCAN_FILE_NAME(h, ftype) TSDB_FILE_FULL_NAME(TSDB_DFILE_IN_SET(TSDB_READ_FSET(&(h)->readh), ftype))
 
-int tsdbScanSBlock(STsdbScanHandle* pScanHandle, int idx) { return 0; }
+static const char *tsdbScanFileSuffix[] = {"head", "data", "last", "smad", "smal"};
 
-int tsdbCloseScanFile(STsdbScanHandle* pScanHandle) { return 0; }
+static void  tsdbScanError(STsdbScanHandle *pScanHandle, const char *format, ...);
+static void  tsdbScanWarn(STsdbScanHandle *pScanHandle, const char *format, ...);
+static int   tsdbScanBlock(STsdbScanHandle *pScanHandle, SBlock *pBlock, STableScanStat *pStat);
+static int   tsdbScanDecodeColumn(STsdbScanHandle *pScanHandle, SBlock *pBlock, int8_t type, int8_t codec,
+                                  void *content, int32_t len, int32_t *rawLen);
+static bool  tsdbScanCheckVarData(void *pData, int32_t len, int nRows);
+static void  tsdbScanAddStat(STableScanStat *pTotal, STableScanStat *pStat);
+static void  tsdbScanPrintStat(FILE *fLogStream, const char *prefix, STableScanStat *pStat);
+static int   tsdbScanListFids(const char *dataDir, int *vid, SArray *aFid);
+static void *tsdbScanThreadFunc(void *param);
 
-void tsdbFreeScanHandle(STsdbScanHandle* pScanHandle) {}
+STsdbScanHandle *tsdbNewScanHandle(int vid, bool tableStat) {
+  STsdbScanHandle *pScanHandle = (STsdbScanHandle *)calloc(1, sizeof(*pScanHandle));
+  if (pScanHandle == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    return NULL;
+  }
+
+  pScanHandle->fLogStream = stdout;
+  pScanHandle->tableStat = tableStat;
+  pScanHandle->vid = vid;
+
+  pScanHandle->pRepo = (STsdbRepo *)calloc(1, sizeof(STsdbRepo));
+  if (pScanHandle->pRepo == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    free(pScanHandle);
+    return NULL;
+  }
+  REPO_CFG(pScanHandle->pRepo)->tsdbId = vid;
+  REPO_CFG(pScanHandle->pRepo)->maxRowsPerFileBlock = TSDB_DEFAULT_MAX_ROW_FBLOCK;
+
+  if (tsdbInitReadH(&(pScanHandle->readh), pScanHandle->pRepo) < 0) {
+    free(pScanHandle->pRepo);
+    free(pScanHandle);
+    return NULL;
+  }
+
+  pScanHandle->aTableStat = taosArrayInit(1024, sizeof(STableScanStat));
+  if (pScanHandle->aTableStat == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    tsdbFreeScanHandle(pScanHandle);
+    return NULL;
+  }
+
+  return pScanHandle;
+}
+
+void tsdbFreeScanHandle(STsdbScanHandle *pScanHandle) {
+  if (pScanHandle == NULL) return;
+
+  tsdbDestroyReadH(&(pScanHandle->readh));
+  taosArrayDestroy(&pScanHandle->aTableStat);
+  taosTZfree(pScanHandle->pDBuf);
+  taosTZfree(pScanHandle->pZBuf);
+  tfree(pScanHandle->pRepo);
+  free(pScanHandle);
+}
+
+void tsdbSetScanLogStream(STsdbScanHandle *pScanHandle, FILE *fLogStream) { pScanHandle->fLogStream = fLogStream; }
+
+int tsdbSetAndOpenScanFile(STsdbScanHandle *pScanHandle, const char *dataDir, int fid) {
+  char        fnames[TSDB_FILE_MAX][TSDB_FILENAME_LEN] = {{0}};
+  uint32_t    fvers[TSDB_FILE_MAX] = {0};
+  SDFileSet   fset;
+  DIR *       dir;
+  struct dirent *pEntry;
+  bool        broken = false;  // the FSET can not be opened
+
+  tsdbCloseAndUnsetFSet(&(pScanHandle->readh));
+  taosArrayClear(pScanHandle->aTableStat);
+  memset(&(pScanHandle->total), 0, sizeof(pScanHandle->total));
+  pScanHandle->opened = false;
+  pScanHandle->fid = fid;
+  pScanHandle->nErrors = 0;
+  pScanHandle->nTables = 0;
+
+  if ((dir = opendir(dataDir)) == NULL) {
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    return -1;
+  }
+
+  // A file may be left with several versions by an interrupted commit, the latest one is the one to check
+  while ((pEntry = readdir(dir)) != NULL) {
+    int         tvid, tfid;
+    char        tchar;
+    TSDB_FILE_T ftype;
+    uint32_t    fver;
+
+    if (sscanf(pEntry->d_name, "v%df%d.%c", &tvid, &tfid, &tchar) != 3) continue;
+    tsdbParseDFilename(pEntry->d_name, &tvid, &tfid, &ftype, &fver);
+    if (tfid != fid || ftype == TSDB_FILE_MAX || (pScanHandle->vid >= 0 && tvid != pScanHandle->vid)) continue;
+
+    if (fnames[ftype][0] != 0) {
+      bool newer = fver > fvers[ftype];
+      tsdbScanWarn(pScanHandle, "file %s is ignored since %s is newer", newer ? fnames[ftype] : pEntry->d_name,
+                   newer ? pEntry->d_name : fnames[ftype]);
+      if (!newer) continue;
+    }
+    if (snprintf(fnames[ftype], TSDB_FILENAME_LEN, "%s/%s", dataDir, pEntry->d_name) >= TSDB_FILENAME_LEN) {
+      tsdbScanError(pScanHandle, "file %s is not checked since the path is too long", pEntry->d_name);
+    }
+    fvers[ftype] = fver;
+  }
+  closedir(dir);
+
+  memset(&fset, 0, sizeof(fset));
+  fset.fid = fid;
+  fset.ver = (fnames[TSDB_FILE_SMAD][0] != 0 || fnames[TSDB_FILE_SMAL][0] != 0) ? TSDB_FSET_VER_1 : TSDB_FSET_VER_0;
+  TSDB_FSET_SET_CLOSED(&fset);
+
+  for (TSDB_FILE_T ftype = 0; ftype < tsdbGetNFiles(&fset); ftype++) {
+    SDFile *    pDFile = TSDB_DFILE_IN_SET(&fset, ftype);
+    struct stat fst;
+
+    if (fnames[ftype][0] == 0) {
+      tsdbScanError(pScanHandle, "file v%df%d.%s is missing", pScanHandle->vid, fid, tsdbScanFileSuffix[ftype]);
+      broken = true;
+      continue;
+    }
+
+    memcpy(TSDB_FILE_FULL_NAME(pDFile), fnames[ftype], TSDB_FILENAME_LEN);
+    if (stat(fnames[ftype], &fst) < 0 || tsdbOpenDFile(pDFile, O_RDONLY) < 0) {
+      tsdbScanError(pScanHandle, "file %s can not be opened since %s", fnames[ftype], strerror(errno));
+      broken = true;
+      continue;
+    }
+
+    if (tsdbLoadDFileHeader(pDFile, &(pDFile->info)) < 0) {
+      tsdbScanError(pScanHandle, "file %s header is corrupted since %s", fnames[ftype], tstrerror(terrno));
+      broken = true;
+    } else if (pDFile->info.size > (uint64_t)fst.st_size) {
+      tsdbScanError(pScanHandle, "file %s is truncated, size:%" PRIu64 " size on disk:%" PRId64, fnames[ftype],
+                    pDFile->info.size, (int64_t)fst.st_size);
+    } else if (pDFile->info.size < (uint64_t)fst.st_size) {
+      // taosd truncates them at startup, see tsdbScanAndTryFixDFile
+      tsdbScanWarn(pScanHandle, "file %s has %" PRId64 " bytes not committed", fnames[ftype],
+                   (int64_t)fst.st_size - (int64_t)pDFile->info.size);
+    }
+    tsdbCloseDFile(pDFile);
+  }
+
+  if (broken) return pScanHandle->nErrors;
+
+  if (tsdbSetAndOpenReadFSet(&(pScanHandle->readh), &fset) < 0) {
+    tsdbScanError(pScanHandle, "fset %d can not be opened since %s", fid, tstrerror(terrno));
+    return pScanHandle->nErrors;
+  }
+
+  pScanHandle->opened = true;
+  return pScanHandle->nErrors;
+}
+
+int tsdbScanSBlockIdx(STsdbScanHandle *pScanHandle) {
+  SReadH * pReadh = &(pScanHandle->readh);
+  SDFile * pHeadf = TSDB_READ_HEAD_FILE(pReadh);
+  int32_t  nErrors = pScanHandle->nErrors;
+  SFSetSum fsetSum;
+
+  if (!pScanHandle->opened) return 0;
+
+  if (pHeadf->info.offset > 0 && ((int64_t)pHeadf->info.offset < TSDB_FILE_HEAD_SIZE ||
+                                  (int64_t)pHeadf->info.offset + pHeadf->info.len > (int64_t)pHeadf->info.size)) {
+    tsdbScanError(pScanHandle, "file %s SBlockIdx part is out of the file, offset:%u len:%u size:%" PRIu64,
+                  TSDB_FILE_FULL_NAME(pHeadf), pHeadf->info.offset, pHeadf->info.len, pHeadf->info.size);
+    return pScanHandle->nErrors - nErrors;
+  }
+
+  if (tsdbLoadBlockIdx(pReadh) < 0) {
+    tsdbScanError(pScanHandle, "file %s SBlockIdx part is corrupted since %s, offset:%u len:%u",
+                  TSDB_FILE_FULL_NAME(pHeadf), tstrerror(terrno), pHeadf->info.offset, pHeadf->info.len);
+    taosArrayClear(pReadh->aBlkIdx);
+    return pScanHandle->nErrors - nErrors;
+  }
+
+  for (size_t i = 0; i < taosArrayGetSize(pReadh->aBlkIdx); i++) {
+    SBlockIdx *pBlkIdx = (SBlockIdx *)taosArrayGet(pReadh->aBlkIdx, i);
+
+    if (i > 0 && pBlkIdx->tid <= ((SBlockIdx *)taosArrayGet(pReadh->aBlkIdx, i - 1))->tid) {
+      tsdbScanError(pScanHandle, "file %s SBlockIdx of tid %d is out of order", TSDB_FILE_FULL_NAME(pHeadf),
+                    pBlkIdx->tid);
+    }
+    if (pBlkIdx->numOfBlocks == 0 || pBlkIdx->offset < TSDB_FILE_HEAD_SIZE ||
+        (int64_t)pBlkIdx->offset + pBlkIdx->len > (int64_t)pHeadf->info.offset ||
+        pBlkIdx->len < sizeof(SBlockInfo) + sizeof(TSCKSUM)) {
+      tsdbScanError(pScanHandle, "file %s SBlockIdx of tid %d is invalid, blocks:%u offset:%u len:%u",
+                    TSDB_FILE_FULL_NAME(pHeadf), pBlkIdx->tid, pBlkIdx->numOfBlocks, pBlkIdx->offset, pBlkIdx->len);
+    }
+  }
+
+  if (tsdbInitFSetSum(&fsetSum) < 0) return -1;
+  if (tsdbLoadFSetSum(pReadh, &fsetSum) < 0) {
+    tsdbScanError(pScanHandle, "file %s summary part is corrupted since %s", TSDB_FILE_FULL_NAME(pHeadf),
+                  tstrerror(terrno));
+  }
+  tsdbDestroyFSetSum(&fsetSum);
+
+  return pScanHandle->nErrors - nErrors;
+}
+
+int tsdbScanSBlock(STsdbScanHandle *pScanHandle, int idx) {
+  SReadH *       pReadh = &(pScanHandle->readh);
+  SDFile *       pHeadf = TSDB_READ_HEAD_FILE(pReadh);
+  int32_t        nErrors = pScanHandle->nErrors;
+  uint32_t       infoLen = 0;
+  STableScanStat stat = {0};
+
+  if (!pScanHandle->opened || idx >= taosArrayGetSize(pReadh->aBlkIdx)) return 0;
+
+  SBlockIdx *pBlkIdx = (SBlockIdx *)taosArrayGet(pReadh->aBlkIdx, idx);
+  if (pBlkIdx->numOfBlocks == 0 || pBlkIdx->offset < TSDB_FILE_HEAD_SIZE ||
+      (int64_t)pBlkIdx->offset + pBlkIdx->len > (int64_t)pHeadf->info.offset) {
+    return 0;  // reported by tsdbScanSBlockIdx
+  }
+
+  pReadh->pBlkIdx = pBlkIdx;
+  if (tsdbLoadBlockInfo(pReadh, NULL, &infoLen) < 0) {
+    tsdbScanError(pScanHandle, "file %s SBlockInfo of tid %d is corrupted since %s, offset:%u len:%u",
+                  TSDB_FILE_FULL_NAME(pHeadf), pBlkIdx->tid, tstrerror(terrno), pBlkIdx->offset, pBlkIdx->len);
+    return pScanHandle->nErrors - nErrors;
+  }
+
+  SBlockInfo *pBlkInfo = pReadh->pBlkInfo;
+  if (pBlkInfo->delimiter != TSDB_FILE_DELIMITER || pBlkInfo->tid != pBlkIdx->tid || pBlkInfo->uid != pBlkIdx->uid ||
+      sizeof(SBlockInfo) + sizeof(SBlock) * pBlkIdx->numOfBlocks > infoLen) {
+    tsdbScanError(pScanHandle, "file %s SBlockInfo of tid %d does not match its SBlockIdx, tid:%d uid:%" PRIu64,
+                  TSDB_FILE_FULL_NAME(pHeadf), pBlkIdx->tid, pBlkInfo->tid, pBlkInfo->uid);
+    return pScanHandle->nErrors - nErrors;
+  }
+
+  stat.tid = pBlkIdx->tid;
+  stat.uid = pBlkIdx->uid;
+  stat.keyFirst = TSKEY_INITIAL_VAL;
+  stat.keyLast = TSKEY_INITIAL_VAL;
+
+  for (int i = 0; i < pBlkIdx->numOfBlocks; i++) {
+    SBlock *pBlock = pBlkInfo->blocks + i;
+
+    if (pBlock->keyFirst > pBlock->keyLast || (i > 0 && pBlock->keyFirst <= pBlkInfo->blocks[i - 1].keyLast) ||
+        (pBlock->last && i != pBlkIdx->numOfBlocks - 1) || pBlock->numOfSubBlocks <= 0) {
+      tsdbScanError(pScanHandle, "file %s block %d of tid %d is out of order, keys:[%" PRId64 ", %" PRId64
+                    "] sub-blocks:%d last:%d", TSDB_FILE_FULL_NAME(pHeadf), i, pBlkIdx->tid, pBlock->keyFirst,
+                    pBlock->keyLast, pBlock->numOfSubBlocks, (int)pBlock->last);
+      continue;
+    }
+
+    stat.nBlocks++;
+    stat.nLastBlocks += pBlock->last ? 1 : 0;
+    stat.rows += pBlock->numOfRows;
+    if (stat.keyFirst == TSKEY_INITIAL_VAL) stat.keyFirst = pBlock->keyFirst;
+    stat.keyLast = pBlock->keyLast;
+
+    if (pBlock->numOfSubBlocks == 1) {
+      tsdbScanBlock(pScanHandle, pBlock, &stat);
+      continue;
+    }
+
+    if ((int64_t)pBlock->offset < (int64_t)sizeof(SBlockInfo) ||
+        (int64_t)pBlock->offset + (int64_t)sizeof(SBlock) * pBlock->numOfSubBlocks > (int64_t)infoLen) {
+      tsdbScanError(pScanHandle, "file %s sub-blocks of block %d of tid %d are out of SBlockInfo, offset:%" PRId64,
+                    TSDB_FILE_FULL_NAME(pHeadf), i, pBlkIdx->tid, (int64_t)pBlock->offset);
+      continue;
+    }
+
+    SBlock *pSubBlocks = (SBlock *)POINTER_SHIFT(pBlkInfo, pBlock->offset);
+    for (int j = 0; j < pBlock->numOfSubBlocks; j++) {
+      SBlock *pSubBlock = pSubBlocks + j;
+      if (pSubBlock->keyFirst < pBlock->keyFirst || pSubBlock->keyLast > pBlock->keyLast ||
+          pSubBlock->last != pBlock->last) {
+        tsdbScanError(pScanHandle, "file %s sub-block %d of block %d of tid %d is out of its block",
+                      TSDB_FILE_FULL_NAME(pHeadf), j, i, pBlkIdx->tid);
+        continue;
+      }
+      stat.nSubBlocks++;
+      tsdbScanBlock(pScanHandle, pSubBlock, &stat);
+    }
+  }
+
+  if (stat.nBlocks > 0 && stat.keyLast != pBlkIdx->maxKey) {
+    tsdbScanError(pScanHandle, "file %s SBlockIdx of tid %d has max key %" PRId64 " but the last key is %" PRId64,
+                  TSDB_FILE_FULL_NAME(pHeadf), pBlkIdx->tid, pBlkIdx->maxKey, stat.keyLast);
+  }
+
+  if (taosArrayPush(pScanHandle->aTableStat, &stat) == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    return -1;
+  }
+  pScanHandle->nTables++;
+  tsdbScanAddStat(&(pScanHandle->total), &stat);
+
+  return pScanHandle->nErrors - nErrors;
+}
+
+int tsdbCloseScanFile(STsdbScanHandle *pScanHandle) {
+  FILE *fLogStream = pScanHandle->fLogStream;
+  char  prefix[64];
+
+  if (pScanHandle->tableStat) {
+    for (size_t i = 0; i < taosArrayGetSize(pScanHandle->aTableStat); i++) {
+      STableScanStat *pStat = (STableScanStat *)taosArrayGet(pScanHandle->aTableStat, i);
+      snprintf(prefix, sizeof(prefix), "  tid:%d uid:%" PRIu64, pStat->tid, pStat->uid);
+      tsdbScanPrintStat(fLogStream, prefix, pStat);
+    }
+  }
+
+  snprintf(prefix, sizeof(prefix), "fset %d: tables:%d", pScanHandle->fid, pScanHandle->nTables);
+  tsdbScanPrintStat(fLogStream, prefix, &(pScanHandle->total));
+  fprintf(fLogStream, "fset %d: %s, %d problems found\n", pScanHandle->fid, (pScanHandle->nErrors > 0) ? "BAD" : "OK",
+          pScanHandle->nErrors);
+
+  tsdbCloseAndUnsetFSet(&(pScanHandle->readh));
+  pScanHandle->opened = false;
+  return 0;
+}
+
+int tsdbScanFGroup(STsdbScanHandle *pScanHandle, const char *dataDir, int fid) {
+  if (tsdbSetAndOpenScanFile(pScanHandle, dataDir, fid) < 0) return -1;
+  if (tsdbScanSBlockIdx(pScanHandle) < 0) return -1;
+
+  for (int i = 0; i < taosArrayGetSize(pScanHandle->readh.aBlkIdx); i++) {
+    if (tsdbScanSBlock(pScanHandle, i) < 0) return -1;
+  }
+
+  tsdbCloseScanFile(pScanHandle);
+  return pScanHandle->nErrors;
+}
+
+int tsdbScanDataDir(const char *dataDir, int nThreads, bool tableStat, FILE *fLogStream) {
+  SScanJob       job = {0};
+  STableScanStat total = {0};
+  int            nTables = 0;
+  int            nErrors = 0;
+  int64_t        start = taosGetTimestampMs();
+
+  job.dataDir = dataDir;
+  job.tableStat = tableStat;
+  job.vid = -1;
+  job.aFid = taosArrayInit(64, sizeof(int));
+  if (job.aFid == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    return -1;
+  }
+
+  if (tsdbScanListFids(dataDir, &job.vid, job.aFid) < 0) {
+    taosArrayDestroy(&job.aFid);
+    return -1;
+  }
+
+  int nFSets = (int)taosArrayGetSize(job.aFid);
+  job.results = (SScanFSetResult *)calloc(MAX(nFSets, 1), sizeof(SScanFSetResult));
+  if (job.results == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    taosArrayDestroy(&job.aFid);
+    return -1;
+  }
+
+  nThreads = MIN(nThreads, nFSets);
+  nThreads = MAX(nThreads, 1);
+  pthread_t *threads = (pthread_t *)calloc(nThreads, sizeof(pthread_t));
+  if (threads == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    free(job.results);
+    taosArrayDestroy(&job.aFid);
+    return -1;
+  }
+
+  int nStarted = 0;
+  for (; nStarted < nThreads; nStarted++) {
+    if (pthread_create(threads + nStarted, NULL, tsdbScanThreadFunc, &job) != 0) break;
+  }
+  if (nStarted == 0) tsdbScanThreadFunc(&job);
+  for (int i = 0; i < nStarted; i++) {
+    pthread_join(threads[i], NULL);
+  }
+
+  for (int i = 0; i < nFSets; i++) {
+    SScanFSetResult *pResult = job.results + i;
+
+    if (pResult->buf != NULL) fwrite(pResult->buf, 1, pResult->size, fLogStream);
+    if (pResult->nErrors < 0) {
+      fprintf(fLogStream, "fset %d: failed to scan since %s\n", *(int *)taosArrayGet(job.aFid, i),
+              tstrerror(pResult->code));
+      nErrors++;
+    } else {
+      nErrors += pResult->nErrors;
+    }
+    nTables += pResult->nTables;
+    tsdbScanAddStat(&total, &(pResult->total));
+    free(pResult->buf);
+  }
+
+  char prefix[128];
+  snprintf(prefix, sizeof(prefix), "vgId:%d fsets:%d tables:%d", job.vid, nFSets, nTables);
+  tsdbScanPrintStat(fLogStream, prefix, &total);
+  fprintf(fLogStream, "vgId:%d: %s, %d problems found in %s, %d threads %" PRId64 " ms\n", job.vid,
+          (nErrors > 0) ? "BAD" : "OK", nErrors, dataDir, nStarted, taosGetTimestampMs() - start);
+
+  free(threads);
+  free(job.results);
+  taosArrayDestroy(&job.aFid);
+  return nErrors;
+}
+
+static void tsdbScanError(STsdbScanHandle *pScanHandle, const char *format, ...) {
+  va_list ap;
+
+  pScanHandle->nErrors++;
+  fprintf(pScanHandle->fLogStream, "ERROR fset %d: ", pScanHandle->fid);
+  va_start(ap, format);
+  vfprintf(pScanHandle->fLogStream, format, ap);
+  va_end(ap);
+  fprintf(pScanHandle->fLogStream, "\n");
+}
+
+static void tsdbScanWarn(STsdbScanHandle *pScanHandle, const char *format, ...) {
+  va_list ap;
+
+  fprintf(pScanHandle->fLogStream, "WARN fset %d: ", pScanHandle->fid);
+  va_start(ap, format);
+  vfprintf(pScanHandle->fLogStream, format, ap);
+  va_end(ap);
+  fprintf(pScanHandle->fLogStream, "\n");
+}
+
+// Check one block with one sub-block, the block is read at once and every column is decoded
+static int tsdbScanBlock(STsdbScanHandle *pScanHandle, SBlock *pBlock, STableScanStat *pStat) {
+  SReadH *    pReadh = &(pScanHandle->readh);
+  TSDB_FILE_T ftype = pBlock->last ? TSDB_FILE_LAST : TSDB_FILE_DATA;
+  SDFile *    pDFile = TSDB_DFILE_IN_SET(TSDB_READ_FSET(pReadh), ftype);
+  const char *fname = TSDB_FILE_FULL_NAME(pDFile);
+  int64_t     offset = (int64_t)pBlock->offset;
+  int32_t     rawLen = 0;
+
+  if (pBlock->numOfRows <= 0 || pBlock->numOfCols < 0 || offset < TSDB_FILE_HEAD_SIZE ||
+      offset + pBlock->len > (int64_t)pDFile->info.size) {
+    tsdbScanError(pScanHandle, "file %s block at offset %" PRId64 " is out of the file, len:%d rows:%d cols:%d",
+                  fname, offset, pBlock->len, pBlock->numOfRows, pBlock->numOfCols);
+    return 0;
+  }
+
+  int32_t tsize = (int32_t)tsdbBlockStatisSize(pBlock->numOfCols, (uint32_t)pBlock->blkVer);
+  if (tsize + pBlock->keyLen > pBlock->len) {
+    tsdbScanError(pScanHandle, "file %s block at offset %" PRId64 " is shorter than its columns, len:%d keyLen:%d",
+                  fname, offset, pBlock->len, pBlock->keyLen);
+    return 0;
+  }
+
+  if (tsdbMakeRoom((void **)(&TSDB_READ_BUF(pReadh)), pBlock->len) < 0) return -1;
+  if (tsdbSeekDFile(pDFile, offset, SEEK_SET) < 0 ||
+      tsdbReadDFile(pDFile, TSDB_READ_BUF(pReadh), pBlock->len) < pBlock->len) {
+    tsdbScanError(pScanHandle, "file %s block at offset %" PRId64 " can not be read, len:%d", fname, offset,
+                  pBlock->len);
+    return 0;
+  }
+
+  pStat->fileSize += pBlock->len;
+
+  SBlockData *pBlockData = (SBlockData *)TSDB_READ_BUF(pReadh);
+  if (!taosCheckChecksumWhole((uint8_t *)pBlockData, tsize)) {
+    tsdbScanError(pScanHandle, "file %s block statis part at offset %" PRId64 " has wrong checksum, len:%d", fname,
+                  offset, tsize);
+    return 0;
+  }
+  if (pBlockData->delimiter != TSDB_FILE_DELIMITER || pBlockData->numOfCols != pBlock->numOfCols ||
+      pBlockData->uid != pStat->uid) {
+    tsdbScanError(pScanHandle, "file %s block at offset %" PRId64 " does not belong to table %" PRIu64
+                  ", cols:%d uid:%" PRIu64, fname, offset, pStat->uid, pBlockData->numOfCols, pBlockData->uid);
+    return 0;
+  }
+
+  // the key column
+  void *content = POINTER_SHIFT(pBlockData, tsize + TSDB_KEY_COL_OFFSET);
+  if (!taosCheckChecksumWhole((uint8_t *)content, pBlock->keyLen)) {
+    tsdbScanError(pScanHandle, "file %s block at offset %" PRId64 " key column has wrong checksum", fname, offset);
+  } else if (tsdbScanDecodeColumn(pScanHandle, pBlock, TSDB_DATA_TYPE_TIMESTAMP, TSDB_COL_CODEC_NONE, content,
+                                  pBlock->keyLen, &rawLen) != 0 ||
+             rawLen != pBlock->numOfRows * TYPE_BYTES[TSDB_DATA_TYPE_TIMESTAMP]) {
+    tsdbScanError(pScanHandle, "file %s block at offset %" PRId64 " key column can not be decoded", fname, offset);
+  } else {
+    TSKEY *keys = (TSKEY *)pScanHandle->pDBuf;
+    int    i = 1;
+    while (i < pBlock->numOfRows && keys[i] > keys[i - 1]) i++;
+    if (i < pBlock->numOfRows || keys[0] != pBlock->keyFirst || keys[pBlock->numOfRows - 1] != pBlock->keyLast) {
+      tsdbScanError(pScanHandle, "file %s block at offset %" PRId64 " keys do not match the block, keys:[%" PRId64
+                    ", %" PRId64 "]", fname, offset, pBlock->keyFirst, pBlock->keyLast);
+    }
+    pStat->rawSize += rawLen;
+  }
+
+  SBlockCol  blockCol = {0};
+  SBlockCol *pBlockCol = &blockCol;
+  for (int i = 0; i < pBlock->numOfCols; i++) {
+    tsdbGetSBlockCol(pBlock, &pBlockCol, pBlockData->cols, i);
+
+    int64_t coffset = (int64_t)tsize + tsdbGetBlockColOffset(pBlockCol);
+    int8_t  type = (int8_t)pBlockCol->type;
+    int8_t  codec = (pBlock->blkVer == TSDB_SBLK_VER_0) ? TSDB_COL_CODEC_NONE : pBlockCol->codec;
+
+    if (pBlockCol->len < (int32_t)sizeof(TSCKSUM) || coffset + pBlockCol->len > pBlock->len ||
+        type <= TSDB_DATA_TYPE_NULL || type > TSDB_DATA_TYPE_UBIGINT) {
+      tsdbScanError(pScanHandle, "file %s block at offset %" PRId64 " column %d is invalid, type:%d offset:%" PRId64
+                    " len:%d", fname, offset, pBlockCol->colId, type, coffset, pBlockCol->len);
+      continue;
+    }
+
+    content = POINTER_SHIFT(pBlockData, coffset);
+    if (!taosCheckChecksumWhole((uint8_t *)content, pBlockCol->len)) {
+      tsdbScanError(pScanHandle, "file %s block at offset %" PRId64 " column %d has wrong checksum", fname, offset,
+                    pBlockCol->colId);
+      continue;
+    }
+
+    int code = tsdbScanDecodeColumn(pScanHandle, pBlock, type, codec, content, pBlockCol->len, &rawLen);
+    if (code < 0) return -1;
+    if (code > 0 ||
+        (IS_VAR_DATA_TYPE(type) ? !tsdbScanCheckVarData(pScanHandle->pDBuf, rawLen, pBlock->numOfRows)
+                                : rawLen != pBlock->numOfRows * TYPE_BYTES[type])) {
+      tsdbScanError(pScanHandle, "file %s block at offset %" PRId64 " column %d can not be decoded, codec:%d", fname,
+                    offset, pBlockCol->colId, codec);
+      continue;
+    }
+    pStat->rawSize += rawLen;
+  }
+
+  // the rollup after the last column if any
+  int32_t end = tsdbBlockDataEnd(pBlock, pBlockData);
+  if (end < pBlock->len && !tsdbCheckBlockRollup(POINTER_SHIFT(pBlockData, end), pBlock->len - end, pBlock)) {
+    tsdbScanError(pScanHandle, "file %s block at offset %" PRId64 " rollup is corrupted, len:%d", fname, offset,
+                  pBlock->len - end);
+  }
+
+  if (pBlock->blkVer > TSDB_SBLK_VER_0 && pBlock->aggrStat) {
+    if (tsdbLoadBlockStatis(pReadh, pBlock) < 0) {
+      tsdbScanError(pScanHandle, "file %s aggregates of block at offset %" PRId64 " are corrupted since %s",
+                    TSDB_SCAN_FILE_NAME(pScanHandle, pBlock->last ? TSDB_FILE_SMAL : TSDB_FILE_SMAD), offset,
+                    tstrerror(terrno));
+    } else {
+      pStat->fileSize += tsdbBlockAggrSize(pBlock->numOfCols, (uint32_t)pBlock->blkVer);
+    }
+  }
+
+  return 0;
+}
+
+// Decode a column to pScanHandle->pDBuf, return 1 if it can not be decoded. The size of a decoded binary or nchar
+// column is not known, so the buffer is doubled until the column fits.
+static int tsdbScanDecodeColumn(STsdbScanHandle *pScanHandle, SBlock *pBlock, int8_t type, int8_t codec,
+                                void *content, int32_t len, int32_t *rawLen) {
+  int     nRows = pBlock->numOfRows;
+  int32_t clen = len - (int32_t)sizeof(TSCKSUM);
+  int64_t maxSize = IS_VAR_DATA_TYPE(type) ? (int64_t)nRows * TSDB_MAX_BYTES_PER_ROW : (int64_t)nRows * TYPE_BYTES[type];
+  int64_t size = maxSize;
+
+  if (IS_VAR_DATA_TYPE(type)) {
+    size = MAX((int64_t)nRows * 64, (int64_t)len * 4);
+    size = MIN(size, maxSize);
+  }
+
+  while (true) {
+    int tlen = -1;
+
+    if (tsdbMakeRoom(&(pScanHandle->pDBuf), size + COMP_OVERFLOW_BYTES + sizeof(VarDataOffsetT) * nRows) < 0) {
+      return -1;
+    }
+
+    if (codec != TSDB_COL_CODEC_NONE) {
+      SDataCol dataCol = {0};
+      dataCol.type = type;
+      dataCol.bytes = IS_VAR_DATA_TYPE(type) ? 0 : TYPE_BYTES[type];
+      dataCol.pData = pScanHandle->pDBuf;
+      dataCol.spaceSize = (int)size;
+      dataCol.dataOff = POINTER_SHIFT(pScanHandle->pDBuf, size + COMP_OVERFLOW_BYTES);
+      tlen = tsdbDecodeColumn(&dataCol, codec, content, clen, nRows);
+    } else if (pBlock->algorithm != NO_COMPRESSION) {
+      if (pBlock->algorithm == TWO_STAGE_COMP && tsdbMakeRoom(&(pScanHandle->pZBuf), size + COMP_OVERFLOW_BYTES) < 0) {
+        return -1;
+      }
+      tlen = (*(tDataTypes[type].decompFunc))(content, clen, nRows, pScanHandle->pDBuf, (int)size, pBlock->algorithm,
+                                               pScanHandle->pZBuf, (int)taosTSizeof(pScanHandle->pZBuf));
+    } else if (clen <= size) {
+      memcpy(pScanHandle->pDBuf, content, clen);
+      tlen = clen;
+    }
+
+    if (tlen > 0) {
+      *rawLen = tlen;
+      return 0;
+    }
+
+    if (!IS_VAR_DATA_TYPE(type) || size >= maxSize) return 1;
+    size = MIN(size * 2, maxSize);
+  }
+}
+
+static bool tsdbScanCheckVarData(void *pData, int32_t len, int nRows) {
+  int32_t offset = 0;
+
+  for (int i = 0; i < nRows; i++) {
+    if (offset + (int32_t)VARSTR_HEADER_SIZE > len) return false;
+    offset += (int32_t)varDataTLen(POINTER_SHIFT(pData, offset));
+    if (offset > len) return false;
+  }
+
+  return offset == len;
+}
+
+static void tsdbScanAddStat(STableScanStat *pTotal, STableScanStat *pStat) {
+  if (pStat->nBlocks == 0) return;
+
+  if (pTotal->nBlocks == 0 || pStat->keyFirst < pTotal->keyFirst) pTotal->keyFirst = pStat->keyFirst;
+  if (pTotal->nBlocks == 0 || pStat->keyLast > pTotal->keyLast) pTotal->keyLast = pStat->keyLast;
+  pTotal->nBlocks += pStat->nBlocks;
+  pTotal->nSubBlocks += pStat->nSubBlocks;
+  pTotal->nLastBlocks += pStat->nLastBlocks;
+  pTotal->rows += pStat->rows;
+  pTotal->rawSize += pStat->rawSize;
+  pTotal->fileSize += pStat->fileSize;
+}
+
+static void tsdbScanPrintStat(FILE *fLogStream, const char *prefix, STableScanStat *pStat) {
+  fprintf(fLogStream,
+          "%s blocks:%d sub-blocks:%d last blocks:%d rows:%" PRId64 " keys:[%" PRId64 ", %" PRId64 "] raw:%" PRId64
+          " file:%" PRId64 " ratio:%.2f\n",
+          prefix, pStat->nBlocks, pStat->nSubBlocks, pStat->nLastBlocks, pStat->rows, pStat->keyFirst,
+          pStat->keyLast, pStat->rawSize, pStat->fileSize,
+          (pStat->fileSize > 0) ? (double)pStat->rawSize / pStat->fileSize : 0.0);
+}
+
+static int tsdbScanListFids(const char *dataDir, int *vid, SArray *aFid) {
+  DIR *          dir;
+  struct dirent *pEntry;
+
+  if ((dir = opendir(dataDir)) == NULL) {
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    return -1;
+  }
+
+  while ((pEntry = readdir(dir)) != NULL) {
+    int         tvid, tfid;
+    char        tchar;
+    TSDB_FILE_T ftype;
+    uint32_t    fver;
+
+    if (sscanf(pEntry->d_name, "v%df%d.%c", &tvid, &tfid, &tchar) != 3) continue;
+    tsdbParseDFilename(pEntry->d_name, &tvid, &tfid, &ftype, &fver);
+    if (ftype == TSDB_FILE_MAX) continue;
+    if (*vid < 0) *vid = tvid;
+    if (tvid != *vid) continue;
+
+    if (taosArrayPush(aFid, &tfid) == NULL) {
+      closedir(dir);
+      terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+      return -1;
+    }
+  }
+  closedir(dir);
+
+  taosArraySort(aFid, compareInt32Val);
+  taosArrayRemoveDuplicate(aFid, compareInt32Val, NULL);
+  return 0;
+}
+
+static void *tsdbScanThreadFunc(void *param) {
+  SScanJob *       pJob = (SScanJob *)param;
+  STsdbScanHandle *pScanHandle = tsdbNewScanHandle(pJob->vid, pJob->tableStat);
+
+  while (true) {
+    int idx = atomic_fetch_add_32(&pJob->next, 1);
+    if (idx >= taosArrayGetSize(pJob->aFid)) break;
+
+    SScanFSetResult *pResult = pJob->results + idx;
+    FILE *           fLogStream = NULL;
+    if (pScanHandle == NULL || (fLogStream = open_memstream(&pResult->buf, &pResult->size)) == NULL) {
+      pResult->nErrors = -1;
+      pResult->code = (pScanHandle == NULL) ? terrno : TAOS_SYSTEM_ERROR(errno);
+      continue;
+    }
+
+    tsdbSetScanLogStream(pScanHandle, fLogStream);
+    pResult->nErrors = tsdbScanFGroup(pScanHandle, pJob->dataDir, *(int *)taosArrayGet(pJob->aFid, idx));
+    pResult->code = terrno;
+    pResult->nTables = pScanHandle->nTables;
+    pResult->total = pScanHandle->total;
+    fclose(fLogStream);
+  }
+
+  tsdbFreeScanHandle(pScanHandle);
+  return NULL;
+}
 
 #endif
-#endif
\ No newline at end of file
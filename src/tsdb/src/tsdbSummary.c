@@ -0,0 +1,366 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tsdbint.h"
+#include "qFilter.h"
+
+static bool  tsdbGetGroupUid(STable *pTable, uint64_t *uid);
+static int   tsdbSumColIndex(SArray *aCol, int16_t colId);
+static void  tsdbMergeSumCol(SSumCol *pCol, int64_t notNull, int64_t min, int64_t max);
+static int   tsdbEncodeSumGroup(void **buf, SSumGroup *pGroup);
+static void *tsdbDecodeSumGroup(void *buf, SSumGroup *pGroup);
+static void  tsdbClearSumGroups(SFSetSum *pSum);
+
+int tsdbInitFSetSum(SFSetSum *pSum) {
+  pSum->valid = true;
+  pSum->pGroups = taosHashInit(64, taosGetDefaultHashFunction(TSDB_DATA_TYPE_UBIGINT), false, HASH_NO_LOCK);
+  if (pSum->pGroups == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    return -1;
+  }
+
+  return 0;
+}
+
+void tsdbDestroyFSetSum(SFSetSum *pSum) {
+  if (pSum->pGroups == NULL) return;
+  tsdbClearSumGroups(pSum);
+  taosHashCleanup(pSum->pGroups);
+  pSum->pGroups = NULL;
+}
+
+void tsdbResetFSetSum(SFSetSum *pSum) {
+  tsdbClearSumGroups(pSum);
+  pSum->valid = true;
+}
+
+/**
+ * Add a block written to the FSET to the summary, pBlockData and pAggrBlkData are the SBlockData and aggregate parts
+ * encoded for the block.
+ */
+int tsdbAddBlockToFSetSum(SFSetSum *pSum, STable *pTable, SBlock *pBlock, void *pBlockData, void *pAggrBlkData) {
+  uint64_t   uid;
+  SSumGroup *pGroup;
+
+  if (!pSum->valid) return 0;
+
+  if (!tsdbGetGroupUid(pTable, &uid)) {
+    pSum->valid = false;
+    return 0;
+  }
+
+  pGroup = (SSumGroup *)taosHashGet(pSum->pGroups, &uid, sizeof(uid));
+  if (pGroup == NULL) {
+    SSumGroup group = {.uid = uid, .rows = 0, .keyFirst = pBlock->keyFirst, .keyLast = pBlock->keyLast};
+
+    group.aCol = taosArrayInit(16, sizeof(SSumCol));
+    if (group.aCol == NULL || taosHashPut(pSum->pGroups, &uid, sizeof(uid), &group, sizeof(group)) < 0) {
+      taosArrayDestroy(&group.aCol);
+      terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+      return -1;
+    }
+
+    pGroup = (SSumGroup *)taosHashGet(pSum->pGroups, &uid, sizeof(uid));
+  }
+
+  pGroup->rows += pBlock->numOfRows;
+  pGroup->keyFirst = MIN(pGroup->keyFirst, pBlock->keyFirst);
+  pGroup->keyLast = MAX(pGroup->keyLast, pBlock->keyLast);
+
+  // All columns except the key column are NULL
+  if (pBlock->aggrStat == 0) return 0;
+
+  for (int i = 0; i < pBlock->numOfCols; i++) {
+    SBlockCol *  pBlockCol = ((SBlockData *)pBlockData)->cols + i;
+    SAggrBlkCol *pAggrBlkCol = (SAggrBlkCol *)pAggrBlkData + i;
+    int64_t      notNull = pBlock->numOfRows - pAggrBlkCol->numOfNull;
+
+    ASSERT(pBlockCol->colId == pAggrBlkCol->colId);
+    if (notNull <= 0) continue;
+
+    int      idx = tsdbSumColIndex(pGroup->aCol, pBlockCol->colId);
+    SSumCol *pCol = (idx < taosArrayGetSize(pGroup->aCol)) ? (SSumCol *)taosArrayGet(pGroup->aCol, idx) : NULL;
+
+    if (pCol == NULL || pCol->colId != pBlockCol->colId) {
+      SSumCol col = {.colId = pBlockCol->colId, .type = pBlockCol->type, .notNull = 0};
+      if ((pCol = taosArrayInsert(pGroup->aCol, idx, &col)) == NULL) {
+        terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+        return -1;
+      }
+    } else if (pCol->type != pBlockCol->type) {
+      pSum->valid = false;
+      return 0;
+    }
+
+    tsdbMergeSumCol(pCol, notNull, pAggrBlkCol->min, pAggrBlkCol->max);
+  }
+
+  return 0;
+}
+
+/**
+ * Append the summary to the head file after the SBlockIdx part. Nothing is written if there is no data in the FSET or
+ * the summary is not valid.
+ */
+int tsdbWriteFSetSum(SDFile *pHeadf, SFSetSum *pSum, void **ppBuf) {
+  int        tlen = 0;
+  int64_t    offset = 0;
+  SSumGroup *pGroup;
+
+  if (!pSum->valid || pHeadf->info.offset == 0) return 0;
+
+  tlen += taosEncodeFixedU32(NULL, TSDB_FSET_SUM_VER);
+  tlen += taosEncodeVariantU32(NULL, (uint32_t)taosHashGetSize(pSum->pGroups));
+  pGroup = taosHashIterate(pSum->pGroups, NULL);
+  while (pGroup) {
+    tlen += tsdbEncodeSumGroup(NULL, pGroup);
+    pGroup = taosHashIterate(pSum->pGroups, pGroup);
+  }
+  tlen += sizeof(TSCKSUM);
+
+  if (tsdbMakeRoom(ppBuf, tlen) < 0) return -1;
+
+  void *ptr = *ppBuf;
+  taosEncodeFixedU32(&ptr, TSDB_FSET_SUM_VER);
+  taosEncodeVariantU32(&ptr, (uint32_t)taosHashGetSize(pSum->pGroups));
+  pGroup = taosHashIterate(pSum->pGroups, NULL);
+  while (pGroup) {
+    tsdbEncodeSumGroup(&ptr, pGroup);
+    pGroup = taosHashIterate(pSum->pGroups, pGroup);
+  }
+  taosCalcChecksumAppend(0, (uint8_t *)(*ppBuf), tlen);
+
+  if (tsdbAppendDFile(pHeadf, *ppBuf, tlen, &offset) < tlen) {
+    return -1;
+  }
+
+  tsdbUpdateDFileMagic(pHeadf, POINTER_SHIFT(*ppBuf, tlen - sizeof(TSCKSUM)));
+
+  return 0;
+}
+
+/**
+ * Load the summary of the FSET opened by pReadh. The summary is marked not valid if the head file has data but no
+ * summary, which is the case of files written by older versions.
+ */
+int tsdbLoadFSetSum(SReadH *pReadh, SFSetSum *pSum) {
+  SDFile * pHeadf = TSDB_READ_HEAD_FILE(pReadh);
+  int64_t  offset = (int64_t)pHeadf->info.offset + pHeadf->info.len;
+  int64_t  tlen = (int64_t)pHeadf->info.size - offset;
+  uint32_t ver, nGroups;
+
+  tsdbResetFSetSum(pSum);
+
+  // No data at all
+  if (pHeadf->info.offset <= 0) return 0;
+
+  if (tlen <= (int64_t)sizeof(TSCKSUM)) {
+    pSum->valid = false;
+    return 0;
+  }
+
+  if (tsdbSeekDFile(pHeadf, offset, SEEK_SET) < 0) {
+    tsdbError("vgId:%d failed to load summary part while seek file %s since %s, offset:%" PRId64 " len:%" PRId64,
+              TSDB_READ_REPO_ID(pReadh), TSDB_FILE_FULL_NAME(pHeadf), tstrerror(terrno), offset, tlen);
+    pSum->valid = false;
+    return -1;
+  }
+
+  if (tsdbMakeRoom((void **)(&TSDB_READ_BUF(pReadh)), tlen) < 0) {
+    pSum->valid = false;
+    return -1;
+  }
+
+  int64_t nread = tsdbReadDFile(pHeadf, TSDB_READ_BUF(pReadh), tlen);
+  if (nread < tlen || !taosCheckChecksumWhole((uint8_t *)TSDB_READ_BUF(pReadh), (uint32_t)tlen)) {
+    if (nread >= 0) terrno = TSDB_CODE_TDB_FILE_CORRUPTED;
+    tsdbError("vgId:%d summary part in file %s is corrupted, offset:%" PRId64 " len:%" PRId64 " read bytes:%" PRId64,
+              TSDB_READ_REPO_ID(pReadh), TSDB_FILE_FULL_NAME(pHeadf), offset, tlen, nread);
+    pSum->valid = false;
+    return -1;
+  }
+
+  void *ptr = TSDB_READ_BUF(pReadh);
+  ptr = taosDecodeFixedU32(ptr, &ver);
+  if (ver != TSDB_FSET_SUM_VER) {
+    pSum->valid = false;
+    return 0;
+  }
+
+  ptr = taosDecodeVariantU32(ptr, &nGroups);
+  for (uint32_t i = 0; i < nGroups; i++) {
+    SSumGroup group = {0};
+
+    if ((ptr = tsdbDecodeSumGroup(ptr, &group)) == NULL ||
+        taosHashPut(pSum->pGroups, &group.uid, sizeof(group.uid), &group, sizeof(group)) < 0) {
+      taosArrayDestroy(&group.aCol);
+      terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+      pSum->valid = false;
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+/**
+ * Check if the rows of the table group of pTable in the FSET may match the filters. pStatis is a buffer of numOfCols
+ * entries which is filled for the columns in colIds as the statistics of a data block before it is passed to
+ * filterRangeExecute.
+ */
+bool tsdbFSetSumMayMatch(SFSetSum *pSum, STable *pTable, void *pFilters, SDataStatis *pStatis, int16_t *colIds,
+                         int numOfCols) {
+  uint64_t   uid;
+  SSumGroup *pGroup;
+
+  if (!pSum->valid || !tsdbGetGroupUid(pTable, &uid)) return true;
+
+  pGroup = (SSumGroup *)taosHashGet(pSum->pGroups, &uid, sizeof(uid));
+  if (pGroup == NULL) return false;
+
+  // The null counts of SDataStatis are int16_t, so the group is presented as a block of two rows with no, some or all
+  // rows of a column NULL.
+  memset(pStatis, 0, sizeof(SDataStatis) * numOfCols);
+  for (int i = 0; i < numOfCols; i++) {
+    pStatis[i].colId = colIds[i];
+    if (colIds[i] == PRIMARYKEY_TIMESTAMP_COL_INDEX) {
+      pStatis[i].min = pGroup->keyFirst;
+      pStatis[i].max = pGroup->keyLast;
+      continue;
+    }
+
+    int      idx = tsdbSumColIndex(pGroup->aCol, colIds[i]);
+    SSumCol *pCol = (idx < taosArrayGetSize(pGroup->aCol)) ? (SSumCol *)taosArrayGet(pGroup->aCol, idx) : NULL;
+    if (pCol == NULL || pCol->colId != colIds[i]) {
+      pStatis[i].numOfNull = 2;
+    } else {
+      pStatis[i].numOfNull = (pCol->notNull >= pGroup->rows) ? 0 : 1;
+      pStatis[i].min = pCol->min;
+      pStatis[i].max = pCol->max;
+    }
+  }
+
+  return filterRangeExecute((SFilterInfo *)pFilters, pStatis, numOfCols, 2);
+}
+
+static bool tsdbGetGroupUid(STable *pTable, uint64_t *uid) {
+  if (TABLE_TYPE(pTable) == TSDB_CHILD_TABLE) {
+    if (pTable->pSuper == NULL) return false;
+    *uid = TABLE_UID(pTable->pSuper);
+  } else {
+    *uid = TABLE_UID(pTable);
+  }
+
+  return true;
+}
+
+// Index of the first column with id not less than colId
+static int tsdbSumColIndex(SArray *aCol, int16_t colId) {
+  int lidx = 0, ridx = (int)taosArrayGetSize(aCol);
+
+  while (lidx < ridx) {
+    int midx = (lidx + ridx) / 2;
+    if (((SSumCol *)taosArrayGet(aCol, midx))->colId < colId) {
+      lidx = midx + 1;
+    } else {
+      ridx = midx;
+    }
+  }
+
+  return lidx;
+}
+
+// Float and double aggregates are kept as the bits of a double
+static FORCE_INLINE double tsdbSumDoubleVal(int64_t v) {
+  double dv;
+  memcpy(&dv, &v, sizeof(dv));
+  return dv;
+}
+
+static void tsdbMergeSumCol(SSumCol *pCol, int64_t notNull, int64_t min, int64_t max) {
+  if (pCol->notNull == 0) {
+    pCol->min = min;
+    pCol->max = max;
+  } else if (IS_UNSIGNED_NUMERIC_TYPE(pCol->type)) {
+    if ((uint64_t)min < (uint64_t)pCol->min) pCol->min = min;
+    if ((uint64_t)max > (uint64_t)pCol->max) pCol->max = max;
+  } else if (IS_FLOAT_TYPE(pCol->type)) {
+    if (tsdbSumDoubleVal(min) < tsdbSumDoubleVal(pCol->min)) pCol->min = min;
+    if (tsdbSumDoubleVal(max) > tsdbSumDoubleVal(pCol->max)) pCol->max = max;
+  } else {
+    pCol->min = MIN(pCol->min, min);
+    pCol->max = MAX(pCol->max, max);
+  }
+
+  pCol->notNull += notNull;
+}
+
+static int tsdbEncodeSumGroup(void **buf, SSumGroup *pGroup) {
+  int    tlen = 0;
+  size_t nCols = taosArrayGetSize(pGroup->aCol);
+
+  tlen += taosEncodeFixedU64(buf, pGroup->uid);
+  tlen += taosEncodeFixedI64(buf, pGroup->rows);
+  tlen += taosEncodeFixedI64(buf, pGroup->keyFirst);
+  tlen += taosEncodeFixedI64(buf, pGroup->keyLast);
+  tlen += taosEncodeVariantU32(buf, (uint32_t)nCols);
+  for (size_t i = 0; i < nCols; i++) {
+    SSumCol *pCol = (SSumCol *)taosArrayGet(pGroup->aCol, i);
+
+    tlen += taosEncodeFixedI16(buf, pCol->colId);
+    tlen += taosEncodeFixedI8(buf, pCol->type);
+    tlen += taosEncodeFixedI64(buf, pCol->notNull);
+    tlen += taosEncodeFixedI64(buf, pCol->min);
+    tlen += taosEncodeFixedI64(buf, pCol->max);
+  }
+
+  return tlen;
+}
+
+static void *tsdbDecodeSumGroup(void *buf, SSumGroup *pGroup) {
+  uint32_t nCols;
+
+  buf = taosDecodeFixedU64(buf, &(pGroup->uid));
+  buf = taosDecodeFixedI64(buf, &(pGroup->rows));
+  buf = taosDecodeFixedI64(buf, &(pGroup->keyFirst));
+  buf = taosDecodeFixedI64(buf, &(pGroup->keyLast));
+  buf = taosDecodeVariantU32(buf, &nCols);
+
+  pGroup->aCol = taosArrayInit(nCols, sizeof(SSumCol));
+  if (pGroup->aCol == NULL) return NULL;
+
+  for (uint32_t i = 0; i < nCols; i++) {
+    SSumCol col;
+
+    buf = taosDecodeFixedI16(buf, &(col.colId));
+    buf = taosDecodeFixedI8(buf, &(col.type));
+    buf = taosDecodeFixedI64(buf, &(col.notNull));
+    buf = taosDecodeFixedI64(buf, &(col.min));
+    buf = taosDecodeFixedI64(buf, &(col.max));
+    taosArrayPush(pGroup->aCol, &col);
+  }
+
+  return buf;
+}
+
+static void tsdbClearSumGroups(SFSetSum *pSum) {
+  SSumGroup *pGroup = taosHashIterate(pSum->pGroups, NULL);
+  while (pGroup) {
+    taosArrayDestroy(&pGroup->aCol);
+    pGroup = taosHashIterate(pSum->pGroups, pGroup);
+  }
+
+  taosHashClear(pSum->pGroups);
+}
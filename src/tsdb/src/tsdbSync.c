@@ -17,6 +17,7 @@
 #include "os.h"
 #include "taoserror.h"
 #include "tsdbint.h"
+#include "tsha256.h"
 
 // Sync handle
 typedef struct {
@@ -29,24 +30,58 @@ typedef struct {
   SMFile     mf;
   SDFileSet  df;
   SDFileSet *pdf;
+  bool       remoteDelta;  // remote is able to send only the blocks missing here
 } SSyncH;
 
 #define SYNC_BUFFER(sh) ((sh)->pBuf)
 
+// Decisions on a FSET, sent by the receiver
+#define TSDB_SYNC_FSET_SKIP 0   // same or expired, nothing to send
+#define TSDB_SYNC_FSET_FULL 1   // send all the files
+#define TSDB_SYNC_FSET_DELTA 2  // send the .head and .sma files and only the blocks of .data and .last missing here
+
+// A block in the .data or .last file of a FSET. The replicas commit independently, so the same block is at different
+// offsets in the files of each replica, and is matched by the table, keys and length and the SHA-256 of its bytes. A
+// local block is only reused in place of the remote one when the digests are equal, a checksum is too weak for that.
+typedef struct {
+  uint64_t uid;
+  TSKEY    keyFirst;
+  TSKEY    keyLast;
+  int64_t  offset;
+  int32_t  numOfRows;
+  int32_t  len;
+  uint8_t  digest[SHA256_DIGEST_SIZE];
+  int8_t   ftype;     // TSDB_FILE_DATA or TSDB_FILE_LAST
+  int8_t   digested;  // digest is computed, the local blocks are digested only when they have a candidate
+} SSyncBlock;
+
+#define TSDB_SYNC_BLOCK_ENCODE_SIZE (sizeof(uint64_t) + sizeof(TSKEY) * 2 + sizeof(int64_t) + sizeof(int32_t) * 2 + \
+                                     SHA256_DIGEST_SIZE + sizeof(int8_t))
+
 static void    tsdbInitSyncH(SSyncH *pSyncH, STsdbRepo *pRepo, SOCKET socketFd);
 static void    tsdbDestroySyncH(SSyncH *pSyncH);
 static int32_t tsdbSyncSendMeta(SSyncH *pSynch);
 static int32_t tsdbSyncRecvMeta(SSyncH *pSynch);
 static int32_t tsdbSendMetaInfo(SSyncH *pSynch);
 static int32_t tsdbRecvMetaInfo(SSyncH *pSynch);
-static int32_t tsdbSendDecision(SSyncH *pSynch, bool toSend);
-static int32_t tsdbRecvDecision(SSyncH *pSynch, bool *toSend);
+static int32_t tsdbSendDecision(SSyncH *pSynch, uint8_t decision);
+static int32_t tsdbRecvDecision(SSyncH *pSynch, uint8_t *decision);
 static int32_t tsdbSyncSendDFileSetArray(SSyncH *pSynch);
 static int32_t tsdbSyncRecvDFileSetArray(SSyncH *pSynch);
 static bool    tsdbIsTowFSetSame(SDFileSet *pSet1, SDFileSet *pSet2);
 static int32_t tsdbSyncSendDFileSet(SSyncH *pSynch, SDFileSet *pSet);
 static int32_t tsdbSendDFileSetInfo(SSyncH *pSynch, SDFileSet *pSet);
 static int32_t tsdbRecvDFileSetInfo(SSyncH *pSynch);
+static int32_t tsdbSyncSendDFile(SSyncH *pSynch, SDFile *pDFile);
+static int32_t tsdbSyncRecvDFile(SSyncH *pSynch, SDFile *pDFile, SDFile *pRDFile);
+static int32_t tsdbSyncSendDFileSetDelta(SSyncH *pSynch, SDFileSet *pSet);
+static int32_t tsdbSyncRecvDFileSetDelta(SSyncH *pSynch, SDFileSet *pLSet, SDFileSet *pSet);
+static int32_t tsdbLoadSyncBlocks(SReadH *pReadh, SArray *aBlocks, bool digest);
+static int32_t tsdbDigestSyncBlock(SReadH *pReadh, SSyncBlock *pBlock);
+static int32_t tsdbSendSyncBlocks(SSyncH *pSynch, SArray *aBlocks);
+static int32_t tsdbRecvSyncBlocks(SSyncH *pSynch, SArray *aBlocks);
+static int32_t tsdbSendSyncBitmap(SSyncH *pSynch, uint8_t *bitmap, int32_t nBlocks);
+static int32_t tsdbRecvSyncBitmap(SSyncH *pSynch, uint8_t *bitmap, int32_t nBlocks);
 static int     tsdbReload(STsdbRepo *pRepo, bool isMfChanged);
 
 int32_t tsdbSyncSend(void *tsdb, SOCKET socketFd) {
@@ -124,7 +159,7 @@ static void tsdbDestroySyncH(SSyncH *pSyncH) { taosTZfree(pSyncH->pBuf); }
 
 static int32_t tsdbSyncSendMeta(SSyncH *pSynch) {
   STsdbRepo *pRepo = pSynch->pRepo;
-  bool       toSendMeta = false;
+  uint8_t    toSendMeta = TSDB_SYNC_FSET_SKIP;
   SMFile     mf;
 
   // Send meta info to remote
@@ -199,7 +234,7 @@ static int32_t tsdbSyncRecvMeta(SSyncH *pSynch) {
     // Local has no meta file or has a different meta file, need to copy from remote
     pSynch->mfChanged = true;
 
-    if (tsdbSendDecision(pSynch, true) < 0) {
+    if (tsdbSendDecision(pSynch, TSDB_SYNC_FSET_FULL) < 0) {
       tsdbError("vgId:%d, failed to send decision while recv metafile since %s", REPO_ID(pRepo), tstrerror(terrno));
       return -1;
     }
@@ -236,7 +271,7 @@ static int32_t tsdbSyncRecvMeta(SSyncH *pSynch) {
   } else {
     pSynch->mfChanged = false;
     tsdbInfo("vgId:%d, metafile is same, no need to recv", REPO_ID(pRepo));
-    if (tsdbSendDecision(pSynch, false) < 0) {
+    if (tsdbSendDecision(pSynch, TSDB_SYNC_FSET_SKIP) < 0) {
       tsdbError("vgId:%d, failed to send decision while recv metafile since %s", REPO_ID(pRepo), tstrerror(terrno));
       return -1;
     }
@@ -327,9 +362,8 @@ static int32_t tsdbRecvMetaInfo(SSyncH *pSynch) {
   return 0;
 }
 
-static int32_t tsdbSendDecision(SSyncH *pSynch, bool toSend) {
+static int32_t tsdbSendDecision(SSyncH *pSynch, uint8_t decision) {
   STsdbRepo *pRepo = pSynch->pRepo;
-  uint8_t    decision = toSend;
 
   int32_t writeLen = sizeof(uint8_t);
   int32_t ret = taosWriteMsg(pSynch->socketFd, (void *)(&decision), writeLen);
@@ -342,19 +376,17 @@ static int32_t tsdbSendDecision(SSyncH *pSynch, bool toSend) {
   return 0;
 }
 
-static int32_t tsdbRecvDecision(SSyncH *pSynch, bool *toSend) {
+static int32_t tsdbRecvDecision(SSyncH *pSynch, uint8_t *decision) {
   STsdbRepo *pRepo = pSynch->pRepo;
-  uint8_t    decision = 0;
 
   int32_t readLen = sizeof(uint8_t);
-  int32_t ret = taosReadMsg(pSynch->socketFd, (void *)(&decision), readLen);
+  int32_t ret = taosReadMsg(pSynch->socketFd, (void *)decision, readLen);
   if (ret != readLen) {
     terrno = TAOS_SYSTEM_ERROR(errno);
     tsdbError("vgId:%d, failed to recv decison, ret:%d readLen:%d", REPO_ID(pRepo), ret, readLen);
     return -1;
   }
 
-  *toSend = decision;
   return 0;
 }
 
@@ -423,16 +455,17 @@ static int32_t tsdbSyncRecvDFileSetArray(SSyncH *pSynch) {
           return -1;
         }
 
-        if (tsdbSendDecision(pSynch, false) < 0) {
+        if (tsdbSendDecision(pSynch, TSDB_SYNC_FSET_SKIP) < 0) {
           tsdbError("vgId:%d, failed to send decision since %s", REPO_ID(pRepo), tstrerror(terrno));
           return -1;
         }
       } else {
         // Need to copy from remote
-        int fidLevel = tsdbGetFidLevel(pSynch->pdf->fid, &(pSynch->rtn));
+        uint8_t decision;
+        int     fidLevel = tsdbGetFidLevel(pSynch->pdf->fid, &(pSynch->rtn));
         if (fidLevel < 0) {  // expired fileset
           tsdbInfo("vgId:%d, fileset:%d will be skipped as expired", REPO_ID(pRepo), pSynch->pdf->fid);
-          if (tsdbSendDecision(pSynch, false) < 0) {
+          if (tsdbSendDecision(pSynch, TSDB_SYNC_FSET_SKIP) < 0) {
             tsdbError("vgId:%d, failed to send decision since %s", REPO_ID(pRepo), tstrerror(terrno));
             return -1;
           }
@@ -447,9 +480,17 @@ static int32_t tsdbSyncRecvDFileSetArray(SSyncH *pSynch) {
           // Next loop
           continue;
         } else {
-          tsdbInfo("vgId:%d, fileset:%d will be received", REPO_ID(pRepo), pSynch->pdf->fid);
+          // A local FSET of the same fid is the base of the new one, only the blocks missing in it are received
+          if (pSynch->remoteDelta && pLSet && pLSet->fid == pSynch->pdf->fid && tsdbFSetIsOk(pLSet)) {
+            decision = TSDB_SYNC_FSET_DELTA;
+          } else {
+            decision = TSDB_SYNC_FSET_FULL;
+          }
+
+          tsdbInfo("vgId:%d, fileset:%d will be received, delta:%d", REPO_ID(pRepo), pSynch->pdf->fid,
+                   decision == TSDB_SYNC_FSET_DELTA);
           // Notify remote to send there file here
-          if (tsdbSendDecision(pSynch, true) < 0) {
+          if (tsdbSendDecision(pSynch, decision) < 0) {
             tsdbError("vgId:%d, failed to send decision since %s", REPO_ID(pRepo), tstrerror(terrno));
             return -1;
           }
@@ -474,27 +515,25 @@ static int32_t tsdbSyncRecvDFileSetArray(SSyncH *pSynch) {
           return -1;
         }
 
-        for (TSDB_FILE_T ftype = 0; ftype < tsdbGetNFiles(pSynch->pdf); ftype++) {
-          SDFile *pDFile = TSDB_DFILE_IN_SET(&fset, ftype);         // local file
-          SDFile *pRDFile = TSDB_DFILE_IN_SET(pSynch->pdf, ftype);  // remote file
-
-          tsdbInfo("vgId:%d, file:%s will be received, osize:%" PRIu64 " rsize:%" PRIu64, REPO_ID(pRepo),
-                   pDFile->f.aname, pDFile->info.size, pRDFile->info.size);
-
-          int64_t writeLen = pRDFile->info.size;
-          int64_t ret = taosCopyFds(pSynch->socketFd, pDFile->fd, writeLen);
-          if (ret != writeLen) {
-            terrno = TAOS_SYSTEM_ERROR(errno);
-            tsdbError("vgId:%d, failed to recv file:%s since %s, ret:%" PRId64 " writeLen:%" PRId64, REPO_ID(pRepo),
-                      pDFile->f.aname, tstrerror(terrno), ret, writeLen);
+        if (decision == TSDB_SYNC_FSET_DELTA) {
+          if (tsdbSyncRecvDFileSetDelta(pSynch, pLSet, &fset) < 0) {
+            tsdbError("vgId:%d, failed to recv fileset:%d delta since %s", REPO_ID(pRepo), fset.fid,
+                      tstrerror(terrno));
             tsdbCloseDFileSet(&fset);
             tsdbRemoveDFileSet(&fset);
             return -1;
           }
-
-          // Update new file info
-          pDFile->info = pRDFile->info;
-          tsdbInfo("vgId:%d, file:%s is received, size:%" PRId64, REPO_ID(pRepo), pDFile->f.aname, writeLen);
+        } else {
+          for (TSDB_FILE_T ftype = 0; ftype < tsdbGetNFiles(pSynch->pdf); ftype++) {
+            SDFile *pDFile = TSDB_DFILE_IN_SET(&fset, ftype);         // local file
+            SDFile *pRDFile = TSDB_DFILE_IN_SET(pSynch->pdf, ftype);  // remote file
+
+            if (tsdbSyncRecvDFile(pSynch, pDFile, pRDFile) < 0) {
+              tsdbCloseDFileSet(&fset);
+              tsdbRemoveDFileSet(&fset);
+              return -1;
+            }
+          }
         }
 
         tsdbCloseDFileSet(&fset);
@@ -567,7 +606,7 @@ static bool tsdbIsTowFSetSame(SDFileSet *pSet1, SDFileSet *pSet2) {
 
 static int32_t tsdbSyncSendDFileSet(SSyncH *pSynch, SDFileSet *pSet) {
   STsdbRepo *pRepo = pSynch->pRepo;
-  bool toSend = false;
+  uint8_t    decision = TSDB_SYNC_FSET_SKIP;
 
   // skip expired fileset
   if (pSet && tsdbGetFidLevel(pSet->fid, &(pSynch->rtn)) < 0) {
@@ -586,37 +625,28 @@ static int32_t tsdbSyncSendDFileSet(SSyncH *pSynch, SDFileSet *pSet) {
     return 0;
   }
 
-  if (tsdbRecvDecision(pSynch, &toSend) < 0) {
+  if (tsdbRecvDecision(pSynch, &decision) < 0) {
     tsdbError("vgId:%d, failed to recv decision while send fileset:%d since %s", REPO_ID(pRepo), pSet->fid,
               tstrerror(terrno));
     return -1;
   }
 
-  if (toSend) {
-    tsdbInfo("vgId:%d, fileset:%d will be sent", REPO_ID(pRepo), pSet->fid);
+  if (decision == TSDB_SYNC_FSET_DELTA) {
+    tsdbInfo("vgId:%d, fileset:%d delta will be sent", REPO_ID(pRepo), pSet->fid);
 
-    for (TSDB_FILE_T ftype = 0; ftype < tsdbGetNFiles(pSet); ftype++) {
-      SDFile df = *TSDB_DFILE_IN_SET(pSet, ftype);
-      
-      if (tsdbOpenDFile(&df, O_RDONLY) < 0) {
-        tsdbError("vgId:%d, failed to file:%s since %s", REPO_ID(pRepo), df.f.aname, tstrerror(terrno));
-        return -1;
-      }
+    if (tsdbSyncSendDFileSetDelta(pSynch, pSet) < 0) {
+      tsdbError("vgId:%d, failed to send fileset:%d delta since %s", REPO_ID(pRepo), pSet->fid, tstrerror(terrno));
+      return -1;
+    }
 
-      int64_t writeLen = df.info.size;
-      tsdbInfo("vgId:%d, file:%s will be sent, size:%" PRId64, REPO_ID(pRepo), df.f.aname, writeLen);
+    tsdbInfo("vgId:%d, fileset:%d delta is sent", REPO_ID(pRepo), pSet->fid);
+  } else if (decision != TSDB_SYNC_FSET_SKIP) {
+    tsdbInfo("vgId:%d, fileset:%d will be sent", REPO_ID(pRepo), pSet->fid);
 
-      int64_t ret = taosSendFile(pSynch->socketFd, TSDB_FILE_FD(&df), 0, writeLen);
-      if (ret != writeLen) {
-        terrno = TAOS_SYSTEM_ERROR(errno);
-        tsdbError("vgId:%d, failed to send file:%s since %s, ret:%" PRId64 " writeLen:%" PRId64, REPO_ID(pRepo),
-                  df.f.aname, tstrerror(terrno), ret, writeLen);
-        tsdbCloseDFile(&df);
+    for (TSDB_FILE_T ftype = 0; ftype < tsdbGetNFiles(pSet); ftype++) {
+      if (tsdbSyncSendDFile(pSynch, TSDB_DFILE_IN_SET(pSet, ftype)) < 0) {
         return -1;
       }
-
-      tsdbInfo("vgId:%d, file:%s is sent", REPO_ID(pRepo), df.f.aname);
-      tsdbCloseDFile(&df);
     }
 
     tsdbInfo("vgId:%d, fileset:%d is sent", REPO_ID(pRepo), pSet->fid);
@@ -631,8 +661,10 @@ static int32_t tsdbSendDFileSetInfo(SSyncH *pSynch, SDFileSet *pSet) {
   STsdbRepo *pRepo = pSynch->pRepo;
   uint32_t   tlen = 0;
 
+  // The FSET info is followed by the decisions supported more than full sending, which are ignored by the receivers
+  // not knowing them
   if (pSet) {
-    tlen = tsdbEncodeDFileSetEx(NULL, pSet) + sizeof(TSCKSUM);
+    tlen = tsdbEncodeDFileSetEx(NULL, pSet) + sizeof(uint8_t) + sizeof(TSCKSUM);
   }
 
   if (tsdbMakeRoom((void **)(&SYNC_BUFFER(pSynch)), tlen + sizeof(tlen)) < 0) {
@@ -645,6 +677,7 @@ static int32_t tsdbSendDFileSetInfo(SSyncH *pSynch, SDFileSet *pSet) {
   void *tptr = ptr;
   if (pSet) {
     tsdbEncodeDFileSetEx(&ptr, pSet);
+    taosEncodeFixedU8(&ptr, TSDB_SYNC_FSET_DELTA);
     taosCalcChecksumAppend(0, (uint8_t *)tptr, tlen);
   }
 
@@ -698,8 +731,604 @@ static int32_t tsdbRecvDFileSetInfo(SSyncH *pSynch) {
   }
 
   pSynch->pdf = &(pSynch->df);
-  tsdbDecodeDFileSetEx(SYNC_BUFFER(pSynch), pSynch->pdf);
+  void *ptr = tsdbDecodeDFileSetEx(SYNC_BUFFER(pSynch), pSynch->pdf);
+
+  uint8_t delta = TSDB_SYNC_FSET_SKIP;
+  if (POINTER_DISTANCE(POINTER_SHIFT(SYNC_BUFFER(pSynch), tlen - sizeof(TSCKSUM)), ptr) > 0) {
+    taosDecodeFixedU8(ptr, &delta);
+  }
+  pSynch->remoteDelta = (delta == TSDB_SYNC_FSET_DELTA);
+
+  return 0;
+}
+
+static int32_t tsdbSyncSendDFile(SSyncH *pSynch, SDFile *pDFile) {
+  STsdbRepo *pRepo = pSynch->pRepo;
+  SDFile     df = *pDFile;
+
+  if (tsdbOpenDFile(&df, O_RDONLY) < 0) {
+    tsdbError("vgId:%d, failed to file:%s since %s", REPO_ID(pRepo), df.f.aname, tstrerror(terrno));
+    return -1;
+  }
+
+  int64_t writeLen = df.info.size;
+  tsdbInfo("vgId:%d, file:%s will be sent, size:%" PRId64, REPO_ID(pRepo), df.f.aname, writeLen);
+
+  int64_t ret = taosSendFile(pSynch->socketFd, TSDB_FILE_FD(&df), 0, writeLen);
+  if (ret != writeLen) {
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    tsdbError("vgId:%d, failed to send file:%s since %s, ret:%" PRId64 " writeLen:%" PRId64, REPO_ID(pRepo),
+              df.f.aname, tstrerror(terrno), ret, writeLen);
+    tsdbCloseDFile(&df);
+    return -1;
+  }
+
+  tsdbInfo("vgId:%d, file:%s is sent", REPO_ID(pRepo), df.f.aname);
+  tsdbCloseDFile(&df);
+  return 0;
+}
+
+static int32_t tsdbSyncRecvDFile(SSyncH *pSynch, SDFile *pDFile, SDFile *pRDFile) {
+  STsdbRepo *pRepo = pSynch->pRepo;
+
+  tsdbInfo("vgId:%d, file:%s will be received, osize:%" PRIu64 " rsize:%" PRIu64, REPO_ID(pRepo), pDFile->f.aname,
+           pDFile->info.size, pRDFile->info.size);
+
+  int64_t writeLen = pRDFile->info.size;
+  int64_t ret = taosCopyFds(pSynch->socketFd, pDFile->fd, writeLen);
+  if (ret != writeLen) {
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    tsdbError("vgId:%d, failed to recv file:%s since %s, ret:%" PRId64 " writeLen:%" PRId64, REPO_ID(pRepo),
+              pDFile->f.aname, tstrerror(terrno), ret, writeLen);
+    return -1;
+  }
+
+  // Update new file info
+  pDFile->info = pRDFile->info;
+  tsdbInfo("vgId:%d, file:%s is received, size:%" PRId64, REPO_ID(pRepo), pDFile->f.aname, writeLen);
+  return 0;
+}
+
+#define TSDB_SYNC_BITMAP_SIZE(n) (((n) + 7) / 8 + 1)
+#define TSDB_SYNC_BIT_SET(bitmap, i) ((bitmap)[(i) / 8] |= (uint8_t)(1u << ((i) % 8)))
+#define TSDB_SYNC_BIT_IS_SET(bitmap, i) (((bitmap)[(i) / 8] & (1u << ((i) % 8))) != 0)
+
+static int tsdbSyncBlockPosCmpr(const void *p1, const void *p2) {
+  const SSyncBlock *pBlock1 = (const SSyncBlock *)p1;
+  const SSyncBlock *pBlock2 = (const SSyncBlock *)p2;
+
+  if (pBlock1->ftype != pBlock2->ftype) return (pBlock1->ftype < pBlock2->ftype) ? -1 : 1;
+  if (pBlock1->offset != pBlock2->offset) return (pBlock1->offset < pBlock2->offset) ? -1 : 1;
+  return 0;
+}
+
+static int tsdbSyncBlockKeyCmpr(const void *p1, const void *p2) {
+  const SSyncBlock *pBlock1 = (const SSyncBlock *)p1;
+  const SSyncBlock *pBlock2 = (const SSyncBlock *)p2;
+
+  if (pBlock1->uid != pBlock2->uid) return (pBlock1->uid < pBlock2->uid) ? -1 : 1;
+  if (pBlock1->keyFirst != pBlock2->keyFirst) return (pBlock1->keyFirst < pBlock2->keyFirst) ? -1 : 1;
+  if (pBlock1->keyLast != pBlock2->keyLast) return (pBlock1->keyLast < pBlock2->keyLast) ? -1 : 1;
+  if (pBlock1->numOfRows != pBlock2->numOfRows) return (pBlock1->numOfRows < pBlock2->numOfRows) ? -1 : 1;
+  if (pBlock1->len != pBlock2->len) return (pBlock1->len < pBlock2->len) ? -1 : 1;
+  return 0;
+}
+
+// Find the local block with the same bytes as the remote block, *lidx is -1 if there is not
+static int32_t tsdbMatchSyncBlock(SReadH *pReadh, SArray *aLBlocks, SSyncBlock *pRBlock, int32_t *lidx) {
+  int32_t lo = 0;
+  int32_t hi = (int32_t)taosArrayGetSize(aLBlocks);
+
+  while (lo < hi) {
+    int32_t mid = lo + (hi - lo) / 2;
+    if (tsdbSyncBlockKeyCmpr(taosArrayGet(aLBlocks, mid), pRBlock) < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  *lidx = -1;
+  for (int32_t i = lo; i < (int32_t)taosArrayGetSize(aLBlocks); i++) {
+    SSyncBlock *pLBlock = (SSyncBlock *)taosArrayGet(aLBlocks, i);
+    if (tsdbSyncBlockKeyCmpr(pLBlock, pRBlock) != 0) break;
+
+    if (!pLBlock->digested && tsdbDigestSyncBlock(pReadh, pLBlock) < 0) return -1;
+    if (memcmp(pLBlock->digest, pRBlock->digest, SHA256_DIGEST_SIZE) == 0) {
+      *lidx = i;
+      break;
+    }
+  }
+
+  return 0;
+}
+
+static int32_t tsdbSyncSendDFileSetDelta(SSyncH *pSynch, SDFileSet *pSet) {
+  STsdbRepo *pRepo = pSynch->pRepo;
+  SReadH     readh;
+  SArray *   aBlocks = NULL;
+  uint8_t *  bitmap = NULL;
+  int32_t    code = -1;
+  int32_t    nSent = 0;
+  int64_t    sentLen = 0;
+
+  if (tsdbInitReadH(&readh, pRepo) < 0) {
+    return -1;
+  }
+
+  aBlocks = taosArrayInit(1024, sizeof(SSyncBlock));
+  if (aBlocks == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    goto _exit;
+  }
+
+  if (tsdbSetAndOpenReadFSet(&readh, pSet) < 0 || tsdbLoadSyncBlocks(&readh, aBlocks, true) < 0) {
+    goto _exit;
+  }
+  taosArraySort(aBlocks, tsdbSyncBlockPosCmpr);
+
+  if (tsdbSendSyncBlocks(pSynch, aBlocks) < 0) {
+    goto _exit;
+  }
+
+  int32_t nBlocks = (int32_t)taosArrayGetSize(aBlocks);
+  bitmap = (uint8_t *)calloc(1, TSDB_SYNC_BITMAP_SIZE(nBlocks));
+  if (bitmap == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    goto _exit;
+  }
+
+  if (tsdbRecvSyncBitmap(pSynch, bitmap, nBlocks) < 0) {
+    goto _exit;
+  }
+
+  for (TSDB_FILE_T ftype = 0; ftype < tsdbGetNFiles(pSet); ftype++) {
+    SDFile *pDFile = TSDB_DFILE_IN_SET(TSDB_READ_FSET(&readh), ftype);
+
+    if (ftype != TSDB_FILE_DATA && ftype != TSDB_FILE_LAST) {
+      if (tsdbSyncSendDFile(pSynch, TSDB_DFILE_IN_SET(pSet, ftype)) < 0) goto _exit;
+      continue;
+    }
+
+    // The needed blocks of the file in the order of their offsets, the adjacent ones are sent at once
+    for (int32_t i = 0; i < nBlocks;) {
+      SSyncBlock *pBlock = (SSyncBlock *)taosArrayGet(aBlocks, i);
+      if (pBlock->ftype != ftype || !TSDB_SYNC_BIT_IS_SET(bitmap, i)) {
+        i++;
+        continue;
+      }
+
+      int64_t offset = pBlock->offset;
+      int64_t len = pBlock->len;
+      for (i++, nSent++; i < nBlocks; i++, nSent++) {
+        SSyncBlock *pNext = (SSyncBlock *)taosArrayGet(aBlocks, i);
+        if (pNext->ftype != ftype || !TSDB_SYNC_BIT_IS_SET(bitmap, i) || pNext->offset != offset + len) break;
+        len += pNext->len;
+      }
+
+      int64_t ret = taosSendFile(pSynch->socketFd, TSDB_FILE_FD(pDFile), &offset, len);
+      if (ret != len) {
+        terrno = TAOS_SYSTEM_ERROR(errno);
+        tsdbError("vgId:%d, failed to send blocks of file:%s since %s, ret:%" PRId64 " len:%" PRId64, REPO_ID(pRepo),
+                  TSDB_FILE_FULL_NAME(pDFile), tstrerror(terrno), ret, len);
+        goto _exit;
+      }
+      sentLen += len;
+    }
+  }
+
+  tsdbInfo("vgId:%d, fileset:%d blocks:%d of %d are sent, size:%" PRId64, REPO_ID(pRepo), pSet->fid, nSent, nBlocks,
+           sentLen);
+  code = 0;
+
+_exit:
+  tsdbDestroyReadH(&readh);
+  taosArrayDestroy(&aBlocks);
+  tfree(bitmap);
+  return code;
+}
+
+// The new FSET is made of the .head and .sma files of remote and the .data and .last files with the blocks at the
+// same offsets as in remote, the blocks found in the local FSET are copied from it and the others are received
+static int32_t tsdbSyncRecvDFileSetDelta(SSyncH *pSynch, SDFileSet *pLSet, SDFileSet *pSet) {
+  STsdbRepo *pRepo = pSynch->pRepo;
+  SReadH     readh;
+  SArray *   aLBlocks = NULL;
+  SArray *   aRBlocks = NULL;
+  int32_t *  lidxs = NULL;
+  uint8_t *  bitmap = NULL;
+  int32_t    code = -1;
+  int32_t    nRecv = 0;
+  int64_t    recvLen = 0;
+
+  if (tsdbInitReadH(&readh, pRepo) < 0) {
+    return -1;
+  }
+
+  aLBlocks = taosArrayInit(1024, sizeof(SSyncBlock));
+  aRBlocks = taosArrayInit(1024, sizeof(SSyncBlock));
+  if (aLBlocks == NULL || aRBlocks == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    goto _exit;
+  }
+
+  if (tsdbSetAndOpenReadFSet(&readh, pLSet) < 0 || tsdbLoadSyncBlocks(&readh, aLBlocks, false) < 0) {
+    goto _exit;
+  }
+  taosArraySort(aLBlocks, tsdbSyncBlockKeyCmpr);
+
+  if (tsdbRecvSyncBlocks(pSynch, aRBlocks) < 0) {
+    goto _exit;
+  }
+
+  int32_t nBlocks = (int32_t)taosArrayGetSize(aRBlocks);
+  lidxs = (int32_t *)malloc(sizeof(int32_t) * (nBlocks + 1));
+  bitmap = (uint8_t *)calloc(1, TSDB_SYNC_BITMAP_SIZE(nBlocks));
+  if (lidxs == NULL || bitmap == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    goto _exit;
+  }
+
+  for (int32_t i = 0; i < nBlocks; i++) {
+    if (tsdbMatchSyncBlock(&readh, aLBlocks, taosArrayGet(aRBlocks, i), lidxs + i) < 0) goto _exit;
+    if (lidxs[i] < 0) TSDB_SYNC_BIT_SET(bitmap, i);
+  }
+
+  if (tsdbSendSyncBitmap(pSynch, bitmap, nBlocks) < 0) {
+    goto _exit;
+  }
+
+  for (TSDB_FILE_T ftype = 0; ftype < tsdbGetNFiles(pSynch->pdf); ftype++) {
+    SDFile *pDFile = TSDB_DFILE_IN_SET(pSet, ftype);              // new file
+    SDFile *pRDFile = TSDB_DFILE_IN_SET(pSynch->pdf, ftype);      // remote file
+
+    if (ftype != TSDB_FILE_DATA && ftype != TSDB_FILE_LAST) {
+      if (tsdbSyncRecvDFile(pSynch, pDFile, pRDFile) < 0) goto _exit;
+      continue;
+    }
+
+    for (int32_t i = 0; i < nBlocks;) {
+      SSyncBlock *pRBlock = (SSyncBlock *)taosArrayGet(aRBlocks, i);
+      if (pRBlock->ftype != ftype) {
+        i++;
+        continue;
+      }
+
+      if (tsdbSeekDFile(pDFile, pRBlock->offset, SEEK_SET) < 0) goto _exit;
+
+      bool        toRecv = (lidxs[i] < 0);
+      SSyncBlock *pLBlock = toRecv ? NULL : (SSyncBlock *)taosArrayGet(aLBlocks, lidxs[i]);
+      int64_t     offset = toRecv ? 0 : pLBlock->offset;
+      int64_t     len = pRBlock->len;
+
+      // Take the adjacent blocks from the same source at once
+      for (i++; i < nBlocks; i++) {
+        SSyncBlock *pNext = (SSyncBlock *)taosArrayGet(aRBlocks, i);
+        if (pNext->ftype != ftype || pNext->offset != pRBlock->offset + len || (lidxs[i] < 0) != toRecv) break;
+        if (!toRecv) {
+          SSyncBlock *pLNext = (SSyncBlock *)taosArrayGet(aLBlocks, lidxs[i]);
+          if (pLNext->ftype != pLBlock->ftype || pLNext->offset != offset + len) break;
+        }
+        len += pNext->len;
+      }
+
+      int64_t ret;
+      if (toRecv) {
+        ret = taosCopyFds(pSynch->socketFd, TSDB_FILE_FD(pDFile), len);
+        recvLen += len;
+      } else {
+        SDFile *pLDFile = TSDB_DFILE_IN_SET(TSDB_READ_FSET(&readh), pLBlock->ftype);
+        ret = taosSendFile(TSDB_FILE_FD(pDFile), TSDB_FILE_FD(pLDFile), &offset, len);
+      }
+      if (ret != len) {
+        terrno = TAOS_SYSTEM_ERROR(errno);
+        tsdbError("vgId:%d, failed to %s blocks of file:%s since %s, ret:%" PRId64 " len:%" PRId64, REPO_ID(pRepo),
+                  toRecv ? "recv" : "copy", TSDB_FILE_FULL_NAME(pDFile), tstrerror(terrno), ret, len);
+        goto _exit;
+      }
+    }
+
+    // The space not taken by any block, as the header, is left zero, the header is written with the remote info
+    if (taosFtruncate(TSDB_FILE_FD(pDFile), pRDFile->info.size) < 0) {
+      terrno = TAOS_SYSTEM_ERROR(errno);
+      goto _exit;
+    }
+
+    pDFile->info = pRDFile->info;
+    if (tsdbUpdateDFileHeader(pDFile) < 0) {
+      goto _exit;
+    }
+
+    tsdbInfo("vgId:%d, file:%s is built, size:%" PRIu64, REPO_ID(pRepo), pDFile->f.aname, pDFile->info.size);
+  }
+
+  for (int32_t i = 0; i < nBlocks; i++) {
+    if (lidxs[i] < 0) nRecv++;
+  }
+  tsdbInfo("vgId:%d, fileset:%d blocks:%d of %d are received, size:%" PRId64, REPO_ID(pRepo), pSet->fid, nRecv,
+           nBlocks, recvLen);
+  code = 0;
+
+_exit:
+  tsdbDestroyReadH(&readh);
+  taosArrayDestroy(&aLBlocks);
+  taosArrayDestroy(&aRBlocks);
+  tfree(lidxs);
+  tfree(bitmap);
+  return code;
+}
+
+// Load the blocks, and the sub-blocks of the super blocks, in the .data and .last files of the FSET opened
+static int32_t tsdbLoadSyncBlocks(SReadH *pReadh, SArray *aBlocks, bool digest) {
+  if (tsdbLoadBlockIdx(pReadh) < 0) {
+    return -1;
+  }
+
+  size_t nIdx = taosArrayGetSize(pReadh->aBlkIdx);
+  for (size_t i = 0; i < nIdx; i++) {
+    SBlockIdx *pBlkIdx = (SBlockIdx *)taosArrayGet(pReadh->aBlkIdx, i);
+    uint32_t   extLen = 0;
+
+    pReadh->pBlkIdx = pBlkIdx;
+    if (tsdbLoadBlockInfo(pReadh, NULL, &extLen) < 0) {
+      return -1;
+    }
+
+    for (uint32_t j = 0; j < pBlkIdx->numOfBlocks; j++) {
+      SBlock *pBlock = pReadh->pBlkInfo->blocks + j;
+      SBlock *pSubBlocks = pBlock;
+      int     nSubBlocks = 1;
+
+      if (pBlock->numOfSubBlocks > 1) {
+        pSubBlocks = (SBlock *)POINTER_SHIFT(pReadh->pBlkInfo, pBlock->offset);
+        nSubBlocks = pBlock->numOfSubBlocks;
+      }
+
+      for (int k = 0; k < nSubBlocks; k++) {
+        SBlock *   pSubBlock = pSubBlocks + k;
+        SSyncBlock block = {.uid = pBlkIdx->uid,
+                            .keyFirst = pSubBlock->keyFirst,
+                            .keyLast = pSubBlock->keyLast,
+                            .offset = pSubBlock->offset,
+                            .numOfRows = pSubBlock->numOfRows,
+                            .len = pSubBlock->len,
+                            .ftype = pSubBlock->last ? TSDB_FILE_LAST : TSDB_FILE_DATA};
+
+        if (digest && tsdbDigestSyncBlock(pReadh, &block) < 0) {
+          return -1;
+        }
+
+        if (taosArrayPush(aBlocks, &block) == NULL) {
+          terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+          return -1;
+        }
+      }
+    }
+  }
+
+  return 0;
+}
+
+static int32_t tsdbDigestSyncBlock(SReadH *pReadh, SSyncBlock *pBlock) {
+  SDFile *pDFile = TSDB_DFILE_IN_SET(TSDB_READ_FSET(pReadh), pBlock->ftype);
+
+  if (tsdbSeekDFile(pDFile, pBlock->offset, SEEK_SET) < 0 ||
+      tsdbMakeRoom((void **)(&TSDB_READ_BUF(pReadh)), pBlock->len) < 0) {
+    return -1;
+  }
+
+  int64_t nread = tsdbReadDFile(pDFile, TSDB_READ_BUF(pReadh), pBlock->len);
+  if (nread < 0) {
+    return -1;
+  }
 
+  if (nread < pBlock->len) {
+    terrno = TSDB_CODE_TDB_FILE_CORRUPTED;
+    tsdbError("vgId:%d, block in file %s is corrupted, offset:%" PRId64 " expected bytes:%d read bytes:%" PRId64,
+              TSDB_READ_REPO_ID(pReadh), TSDB_FILE_FULL_NAME(pDFile), pBlock->offset, pBlock->len, nread);
+    return -1;
+  }
+
+  SHA256_CTX context;
+  SHA256Init(&context);
+  SHA256Update(&context, (uint8_t *)TSDB_READ_BUF(pReadh), pBlock->len);
+  SHA256Final(&context);
+
+  memcpy(pBlock->digest, context.digest, SHA256_DIGEST_SIZE);
+  pBlock->digested = 1;
+  return 0;
+}
+
+static int32_t tsdbSendSyncBlocks(SSyncH *pSynch, SArray *aBlocks) {
+  STsdbRepo *pRepo = pSynch->pRepo;
+  uint32_t   nBlocks = (uint32_t)taosArrayGetSize(aBlocks);
+  uint32_t   tlen = sizeof(uint32_t) + TSDB_SYNC_BLOCK_ENCODE_SIZE * nBlocks + sizeof(TSCKSUM);
+
+  if (tsdbMakeRoom((void **)(&SYNC_BUFFER(pSynch)), tlen + sizeof(tlen)) < 0) {
+    tsdbError("vgId:%d, failed to makeroom while send blocks since %s", REPO_ID(pRepo), tstrerror(terrno));
+    return -1;
+  }
+
+  void *ptr = SYNC_BUFFER(pSynch);
+  taosEncodeFixedU32(&ptr, tlen);
+  void *tptr = ptr;
+  taosEncodeFixedU32(&ptr, nBlocks);
+  for (uint32_t i = 0; i < nBlocks; i++) {
+    SSyncBlock *pBlock = (SSyncBlock *)taosArrayGet(aBlocks, i);
+    taosEncodeFixedU64(&ptr, pBlock->uid);
+    taosEncodeFixedI64(&ptr, pBlock->keyFirst);
+    taosEncodeFixedI64(&ptr, pBlock->keyLast);
+    taosEncodeFixedI64(&ptr, pBlock->offset);
+    taosEncodeFixedI32(&ptr, pBlock->numOfRows);
+    taosEncodeFixedI32(&ptr, pBlock->len);
+    memcpy(ptr, pBlock->digest, SHA256_DIGEST_SIZE);
+    ptr = POINTER_SHIFT(ptr, SHA256_DIGEST_SIZE);
+    taosEncodeFixedI8(&ptr, pBlock->ftype);
+  }
+  taosCalcChecksumAppend(0, (uint8_t *)tptr, tlen);
+
+  int32_t writeLen = tlen + sizeof(uint32_t);
+  int32_t ret = taosWriteMsg(pSynch->socketFd, SYNC_BUFFER(pSynch), writeLen);
+  if (ret != writeLen) {
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    tsdbError("vgId:%d, failed to send blocks, ret:%d writeLen:%d", REPO_ID(pRepo), ret, writeLen);
+    return -1;
+  }
+
+  return 0;
+}
+
+static int32_t tsdbRecvSyncBlocks(SSyncH *pSynch, SArray *aBlocks) {
+  STsdbRepo *pRepo = pSynch->pRepo;
+  uint32_t   tlen = 0;
+  uint32_t   nBlocks = 0;
+  char       buf[64] = {0};
+
+  int32_t readLen = sizeof(uint32_t);
+  int32_t ret = taosReadMsg(pSynch->socketFd, buf, readLen);
+  if (ret != readLen) {
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    tsdbError("vgId:%d, failed to recv blocks len, ret:%d readLen:%d", REPO_ID(pRepo), ret, readLen);
+    return -1;
+  }
+
+  taosDecodeFixedU32(buf, &tlen);
+  if (tlen < sizeof(uint32_t) + sizeof(TSCKSUM)) {
+    terrno = TSDB_CODE_TDB_MESSED_MSG;
+    tsdbError("vgId:%d, failed to recv blocks since %s, tlen:%u", REPO_ID(pRepo), tstrerror(terrno), tlen);
+    return -1;
+  }
+
+  if (tsdbMakeRoom((void **)(&SYNC_BUFFER(pSynch)), tlen) < 0) {
+    tsdbError("vgId:%d, failed to makeroom while recv blocks since %s", REPO_ID(pRepo), tstrerror(terrno));
+    return -1;
+  }
+
+  ret = taosReadMsg(pSynch->socketFd, SYNC_BUFFER(pSynch), tlen);
+  if (ret != tlen) {
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    tsdbError("vgId:%d, failed to recv blocks, ret:%d tlen:%u", REPO_ID(pRepo), ret, tlen);
+    return -1;
+  }
+
+  if (!taosCheckChecksumWhole((uint8_t *)SYNC_BUFFER(pSynch), tlen)) {
+    terrno = TSDB_CODE_TDB_MESSED_MSG;
+    tsdbError("vgId:%d, failed to checksum while recv blocks since %s", REPO_ID(pRepo), tstrerror(terrno));
+    return -1;
+  }
+
+  void *ptr = taosDecodeFixedU32(SYNC_BUFFER(pSynch), &nBlocks);
+  if (tlen != sizeof(uint32_t) + TSDB_SYNC_BLOCK_ENCODE_SIZE * (uint64_t)nBlocks + sizeof(TSCKSUM)) {
+    terrno = TSDB_CODE_TDB_MESSED_MSG;
+    tsdbError("vgId:%d, failed to recv blocks since %s, tlen:%u blocks:%u", REPO_ID(pRepo), tstrerror(terrno), tlen,
+              nBlocks);
+    return -1;
+  }
+
+  // The blocks are in the order of their files and offsets and in the range of the files, not overlapped
+  int64_t end = 0;
+  int8_t  ftype = TSDB_FILE_DATA;
+  for (uint32_t i = 0; i < nBlocks; i++) {
+    SSyncBlock block = {0};
+    ptr = taosDecodeFixedU64(ptr, &block.uid);
+    ptr = taosDecodeFixedI64(ptr, &block.keyFirst);
+    ptr = taosDecodeFixedI64(ptr, &block.keyLast);
+    ptr = taosDecodeFixedI64(ptr, &block.offset);
+    ptr = taosDecodeFixedI32(ptr, &block.numOfRows);
+    ptr = taosDecodeFixedI32(ptr, &block.len);
+    memcpy(block.digest, ptr, SHA256_DIGEST_SIZE);
+    ptr = POINTER_SHIFT(ptr, SHA256_DIGEST_SIZE);
+    ptr = taosDecodeFixedI8(ptr, &block.ftype);
+    block.digested = 1;
+
+    if (block.ftype != ftype) {
+      end = 0;
+      ftype = block.ftype;
+    }
+    if ((block.ftype != TSDB_FILE_DATA && block.ftype != TSDB_FILE_LAST) || block.len <= 0 ||
+        block.offset < MAX(end, TSDB_FILE_HEAD_SIZE) ||
+        block.offset + block.len > (int64_t)TSDB_DFILE_IN_SET(pSynch->pdf, block.ftype)->info.size) {
+      terrno = TSDB_CODE_TDB_MESSED_MSG;
+      tsdbError("vgId:%d, failed to recv blocks since %s, block:%u ftype:%d offset:%" PRId64 " len:%d",
+                REPO_ID(pRepo), tstrerror(terrno), i, block.ftype, block.offset, block.len);
+      return -1;
+    }
+    end = block.offset + block.len;
+
+    if (taosArrayPush(aBlocks, &block) == NULL) {
+      terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+static int32_t tsdbSendSyncBitmap(SSyncH *pSynch, uint8_t *bitmap, int32_t nBlocks) {
+  STsdbRepo *pRepo = pSynch->pRepo;
+  uint32_t   tlen = TSDB_SYNC_BITMAP_SIZE(nBlocks) + sizeof(TSCKSUM);
+
+  if (tsdbMakeRoom((void **)(&SYNC_BUFFER(pSynch)), tlen + sizeof(tlen)) < 0) {
+    tsdbError("vgId:%d, failed to makeroom while send bitmap since %s", REPO_ID(pRepo), tstrerror(terrno));
+    return -1;
+  }
+
+  void *ptr = SYNC_BUFFER(pSynch);
+  taosEncodeFixedU32(&ptr, tlen);
+  memcpy(ptr, bitmap, TSDB_SYNC_BITMAP_SIZE(nBlocks));
+  taosCalcChecksumAppend(0, (uint8_t *)ptr, tlen);
+
+  int32_t writeLen = tlen + sizeof(uint32_t);
+  int32_t ret = taosWriteMsg(pSynch->socketFd, SYNC_BUFFER(pSynch), writeLen);
+  if (ret != writeLen) {
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    tsdbError("vgId:%d, failed to send bitmap, ret:%d writeLen:%d", REPO_ID(pRepo), ret, writeLen);
+    return -1;
+  }
+
+  return 0;
+}
+
+static int32_t tsdbRecvSyncBitmap(SSyncH *pSynch, uint8_t *bitmap, int32_t nBlocks) {
+  STsdbRepo *pRepo = pSynch->pRepo;
+  uint32_t   tlen = 0;
+  char       buf[64] = {0};
+
+  int32_t readLen = sizeof(uint32_t);
+  int32_t ret = taosReadMsg(pSynch->socketFd, buf, readLen);
+  if (ret != readLen) {
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    tsdbError("vgId:%d, failed to recv bitmap len, ret:%d readLen:%d", REPO_ID(pRepo), ret, readLen);
+    return -1;
+  }
+
+  taosDecodeFixedU32(buf, &tlen);
+  if (tlen != TSDB_SYNC_BITMAP_SIZE(nBlocks) + sizeof(TSCKSUM)) {
+    terrno = TSDB_CODE_TDB_MESSED_MSG;
+    tsdbError("vgId:%d, failed to recv bitmap since %s, tlen:%u blocks:%d", REPO_ID(pRepo), tstrerror(terrno), tlen,
+              nBlocks);
+    return -1;
+  }
+
+  if (tsdbMakeRoom((void **)(&SYNC_BUFFER(pSynch)), tlen) < 0) {
+    tsdbError("vgId:%d, failed to makeroom while recv bitmap since %s", REPO_ID(pRepo), tstrerror(terrno));
+    return -1;
+  }
+
+  ret = taosReadMsg(pSynch->socketFd, SYNC_BUFFER(pSynch), tlen);
+  if (ret != tlen) {
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    tsdbError("vgId:%d, failed to recv bitmap, ret:%d tlen:%u", REPO_ID(pRepo), ret, tlen);
+    return -1;
+  }
+
+  if (!taosCheckChecksumWhole((uint8_t *)SYNC_BUFFER(pSynch), tlen)) {
+    terrno = TSDB_CODE_TDB_MESSED_MSG;
+    tsdbError("vgId:%d, failed to checksum while recv bitmap since %s", REPO_ID(pRepo), tstrerror(terrno));
+    return -1;
+  }
+
+  memcpy(bitmap, SYNC_BUFFER(pSynch), TSDB_SYNC_BITMAP_SIZE(nBlocks));
   return 0;
 }
 
@@ -718,6 +1347,10 @@ static int tsdbReload(STsdbRepo *pRepo, bool isMfChanged) {
   pRepo->mem = NULL;
   pRepo->imem = NULL;
 
+  // The saved last row cache does not match the synced files, and the cached tables are all new
+  tsdbRemoveLastCacheFile(pRepo);
+  atomic_store_64(&(pRepo->lastCache.size), 0);
+
   if (tsdbRestoreInfo(pRepo) < 0) {
     tsdbError("vgId:%d failed to restore info from file since %s", REPO_ID(pRepo), tstrerror(terrno));
     return -1;
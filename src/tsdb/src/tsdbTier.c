@@ -0,0 +1,369 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "tglobal.h"
+#include "tsdbint.h"
+#include "tsdbHealth.h"
+
+#define TSDB_COLD_FSET_READS 1.0  // a fileset read less is not worth the first tier
+#define TSDB_TIER_COPY_BUF_SIZE (1024 * 1024)
+#define TSDB_TIER_MIGRATE_SLEEP_MS 100
+
+typedef struct {
+  STsdbRepo *pRepo;
+  SRtn       rtn;
+  void *     pBuf;       // copy buffer
+  bool       cancelled;  // the migration stops for the ingest or the repo closing
+  int64_t    ioStart;    // ms
+  int64_t    ioBytes;    // bytes read and written
+} STierMigrateH;
+
+static int    tsdbFSetReadsIndex(SArray *aReads, int fid);
+static double tsdbGetFSetReads(STsdbRepo *pRepo, int fid, int64_t now);
+static int    tsdbGetFSetMigrateLevel(STsdbRepo *pRepo, SDFileSet *pSet, SRtn *pRtn, int64_t now);
+static bool   tsdbHasFSetToMigrate(STsdbRepo *pRepo);
+static int    tsdbMigrateTSData(STsdbRepo *pRepo);
+static int    tsdbMigrateFSet(STierMigrateH *pMh, SDFileSet *pSet, int level);
+static int    tsdbCopyDFileThrottled(STierMigrateH *pMh, SDFile *pSrc, SDFile *pDest);
+static int    tsdbThrottleTierMigrate(STierMigrateH *pMh);
+
+int tsdbInitFSetHeat(STsdbRepo *pRepo) {
+  SFSetHeat *pHeat = &(pRepo->fsetHeat);
+
+  pthread_mutex_init(&(pHeat->mutex), NULL);
+  pHeat->since = taosGetTimestampMs();
+  pHeat->aReads = taosArrayInit(16, sizeof(SFSetReads));
+  if (pHeat->aReads == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    return -1;
+  }
+
+  return 0;
+}
+
+void tsdbDestroyFSetHeat(STsdbRepo *pRepo) {
+  SFSetHeat *pHeat = &(pRepo->fsetHeat);
+
+  if (pHeat->aReads == NULL) return;
+
+  taosArrayDestroy(&(pHeat->aReads));
+  pthread_mutex_destroy(&(pHeat->mutex));
+}
+
+// Count a read of the fileset fid by a query, which finds blocks of its tables in the fileset
+void tsdbRecordFSetRead(STsdbRepo *pRepo, int fid) {
+  SFSetHeat *pHeat = &(pRepo->fsetHeat);
+  int64_t    now = taosGetTimestampMs();
+
+  if (tsdbHotFSetReads <= 0) return;
+
+  pthread_mutex_lock(&(pHeat->mutex));
+
+  int idx = tsdbFSetReadsIndex(pHeat->aReads, fid);
+  if (idx < taosArrayGetSize(pHeat->aReads) && ((SFSetReads *)taosArrayGet(pHeat->aReads, idx))->fid == fid) {
+    SFSetReads *pReads = (SFSetReads *)taosArrayGet(pHeat->aReads, idx);
+    pReads->reads = pReads->reads * pow(0.5, (now - pReads->lastRead) / (tsdbHotFSetHalfLife * 1000.0)) + 1;
+    pReads->lastRead = now;
+  } else {
+    SFSetReads reads = {.fid = fid, .reads = 1, .lastRead = now};
+    taosArrayInsert(pHeat->aReads, idx, &reads);
+  }
+
+  pthread_mutex_unlock(&(pHeat->mutex));
+}
+
+// The level of the fileset fid by its age, or the first level if it is read often. A fileset is never moved to a colder
+// level by a commit or a compaction while it is hot.
+int tsdbGetFSetTierLevel(STsdbRepo *pRepo, int fid, SRtn *pRtn) {
+  int level = tsdbGetFidLevel(fid, pRtn);
+
+  if (tsdbHotFSetReads <= 0 || level <= 0) return level;
+
+  if (tsdbGetFSetReads(pRepo, fid, taosGetTimestampMs()) >= tsdbHotFSetReads) {
+    return 0;
+  }
+
+  return level;
+}
+
+void *tsdbTierMigrateImpl(STsdbRepo *pRepo) {
+  tsdbDebug("vgId:%d start to migrate filesets between tiers", REPO_ID(pRepo));
+  tsdbStartFSTxn(pRepo, 0, 0);
+  pRepo->code = TSDB_CODE_SUCCESS;
+
+  // the meta file is kept as it is
+  tsdbUpdateMFile(REPO_FS(pRepo), REPO_FS(pRepo)->cstatus->pmf);
+
+  if (tsdbMigrateTSData(pRepo) < 0) {
+    tsdbError("vgId:%d failed to migrate filesets between tiers since %s", REPO_ID(pRepo), tstrerror(terrno));
+    pRepo->code = terrno;
+    tsdbEndFSTxnWithError(REPO_FS(pRepo));
+  } else {
+    tsdbEndFSTxn(pRepo);
+    tsdbDebug("vgId:%d migrate filesets between tiers over", REPO_ID(pRepo));
+  }
+
+  tsem_post(&(pRepo->readyToCommit));
+  return NULL;
+}
+
+bool tsdbScheduleTierMigrate(STsdbRepo *pRepo) {
+  if (tsdbHotFSetReads <= 0 || pRepo->stopTierMigrate || atomic_load_8(&pRepo->compactState) != TSDB_NO_COMPACT ||
+      tsdbIngestUnderPressure(pRepo) || !tsdbHasFSetToMigrate(pRepo)) {
+    return false;
+  }
+
+  if (tsdbScheduleCommit(pRepo, MIGRATE_REQ) < 0) {
+    tsdbWarn("vgId:%d failed to schedule tier migration since %s", REPO_ID(pRepo), tstrerror(terrno));
+    return false;
+  }
+
+  tsdbDebug("vgId:%d tier migration is scheduled", REPO_ID(pRepo));
+  return true;
+}
+
+// Index of the first entry with fid not less than fid
+static int tsdbFSetReadsIndex(SArray *aReads, int fid) {
+  int lidx = 0, ridx = (int)taosArrayGetSize(aReads);
+
+  while (lidx < ridx) {
+    int midx = (lidx + ridx) / 2;
+    if (((SFSetReads *)taosArrayGet(aReads, midx))->fid < fid) {
+      lidx = midx + 1;
+    } else {
+      ridx = midx;
+    }
+  }
+
+  return lidx;
+}
+
+static double tsdbGetFSetReads(STsdbRepo *pRepo, int fid, int64_t now) {
+  SFSetHeat *pHeat = &(pRepo->fsetHeat);
+  double     reads = 0;
+
+  pthread_mutex_lock(&(pHeat->mutex));
+
+  int idx = tsdbFSetReadsIndex(pHeat->aReads, fid);
+  if (idx < taosArrayGetSize(pHeat->aReads) && ((SFSetReads *)taosArrayGet(pHeat->aReads, idx))->fid == fid) {
+    SFSetReads *pReads = (SFSetReads *)taosArrayGet(pHeat->aReads, idx);
+    reads = pReads->reads * pow(0.5, (now - pReads->lastRead) / (tsdbHotFSetHalfLife * 1000.0));
+  }
+
+  pthread_mutex_unlock(&(pHeat->mutex));
+
+  return reads;
+}
+
+// The level a migration moves the fileset to, called with tsdbHotFSetReads set. Only a hot fileset moves to a hotter
+// level than the one it is on, and besides the hot ones, the filesets on the first level but the two latest, which take
+// the writes, move to the second level if they are not read for a half-life since the reads are counted.
+static int tsdbGetFSetMigrateLevel(STsdbRepo *pRepo, SDFileSet *pSet, SRtn *pRtn, int64_t now) {
+  int    level = tsdbGetFidLevel(pSet->fid, pRtn);
+  double reads = tsdbGetFSetReads(pRepo, pSet->fid, now);
+
+  if (reads >= tsdbHotFSetReads) return 0;
+
+  if (level == 0 && pSet->fid < pRtn->nowFid - 1 && tfsNLevel() > 1 && reads < TSDB_COLD_FSET_READS &&
+      now - pRepo->fsetHeat.since >= (int64_t)tsdbHotFSetHalfLife * 1000) {
+    level = 1;
+  }
+
+  // the levels beyond the tiers are on the last one
+  level = MAX(level, TSDB_FSET_LEVEL(pSet));
+  return MIN(level, tfsNLevel() - 1);
+}
+
+static bool tsdbHasFSetToMigrate(STsdbRepo *pRepo) {
+  STsdbFS *  pfs = REPO_FS(pRepo);
+  SFSIter    fsIter;
+  SDFileSet *pSet;
+  SRtn       rtn;
+  bool       found = false;
+  int64_t    now = taosGetTimestampMs();
+
+  tsdbGetRtnSnap(pRepo, &rtn);
+
+  tsdbRLockFS(pfs);
+  tsdbFSIterInit(&fsIter, pfs, TSDB_FS_ITER_FORWARD);
+  while ((pSet = tsdbFSIterNext(&fsIter))) {
+    if (pSet->fid < rtn.minFid) continue;
+
+    if (tsdbGetFSetMigrateLevel(pRepo, pSet, &rtn, now) != TSDB_FSET_LEVEL(pSet)) {
+      found = true;
+      break;
+    }
+  }
+  tsdbUnLockFS(pfs);
+
+  return found;
+}
+
+static int tsdbMigrateTSData(STsdbRepo *pRepo) {
+  STierMigrateH mh = {0};
+  SFSIter       fsIter;
+  SDFileSet *   pSet;
+  int64_t       now = taosGetTimestampMs();
+
+  mh.pRepo = pRepo;
+  mh.ioStart = now;
+  tsdbGetRtnSnap(pRepo, &(mh.rtn));
+
+  tsdbFSIterInit(&fsIter, REPO_FS(pRepo), TSDB_FS_ITER_FORWARD);
+  while ((pSet = tsdbFSIterNext(&fsIter))) {
+    if (pSet->fid < mh.rtn.minFid) {
+      tsdbInfo("vgId:%d FSET %d on level %d disk id %d expires, remove it", REPO_ID(pRepo), pSet->fid,
+               TSDB_FSET_LEVEL(pSet), TSDB_FSET_ID(pSet));
+      continue;
+    }
+
+    int level = tsdbGetFSetMigrateLevel(pRepo, pSet, &(mh.rtn), now);
+    if (mh.cancelled || level == TSDB_FSET_LEVEL(pSet)) {
+      // Keep the fileset on its level unless its age requires otherwise
+      if (tsdbApplyRtnOnFSet(pRepo, pSet, &(mh.rtn)) < 0) {
+        tfree(mh.pBuf);
+        return -1;
+      }
+      continue;
+    }
+
+    if (tsdbMigrateFSet(&mh, pSet, level) < 0) {
+      tfree(mh.pBuf);
+      return -1;
+    }
+  }
+
+  tfree(mh.pBuf);
+  return 0;
+}
+
+static int tsdbMigrateFSet(STierMigrateH *pMh, SDFileSet *pSet, int level) {
+  STsdbRepo *pRepo = pMh->pRepo;
+  STsdbFS *  pfs = REPO_FS(pRepo);
+  SDiskID    did;
+  SDFileSet  nSet;
+
+  tfsAllocDisk(level, &(did.level), &(did.id));
+  if (did.level == TFS_UNDECIDED_LEVEL || did.level == TSDB_FSET_LEVEL(pSet)) {
+    return tsdbApplyRtnOnFSet(pRepo, pSet, &(pMh->rtn));
+  }
+
+  tsdbInitDFileSet(&nSet, did, REPO_ID(pRepo), pSet->fid, FS_TXN_VERSION(pfs), pSet->ver);
+
+  for (TSDB_FILE_T ftype = 0; ftype < tsdbGetNFiles(pSet); ftype++) {
+    if (tsdbCopyDFileThrottled(pMh, TSDB_DFILE_IN_SET(pSet, ftype), TSDB_DFILE_IN_SET(&nSet, ftype)) < 0) {
+      tsdbRemoveDFileSet(&nSet);
+      if (pMh->cancelled) {
+        tsdbInfo("vgId:%d tier migration of FSET %d stops for the ingest", REPO_ID(pRepo), pSet->fid);
+        return tsdbApplyRtnOnFSet(pRepo, pSet, &(pMh->rtn));
+      }
+
+      tsdbError("vgId:%d failed to copy FSET %d from level %d to level %d since %s", REPO_ID(pRepo), pSet->fid,
+                TSDB_FSET_LEVEL(pSet), did.level, tstrerror(terrno));
+      return -1;
+    }
+  }
+
+  if (tsdbUpdateDFileSet(pfs, &nSet) < 0) {
+    return -1;
+  }
+
+  tsdbInfo("vgId:%d FSET %d read %.1f times is moved from level %d disk id %d to level %d disk id %d", REPO_ID(pRepo),
+           pSet->fid, tsdbGetFSetReads(pRepo, pSet->fid, taosGetTimestampMs()), TSDB_FSET_LEVEL(pSet),
+           TSDB_FSET_ID(pSet), did.level, did.id);
+  return 0;
+}
+
+static int tsdbCopyDFileThrottled(STierMigrateH *pMh, SDFile *pSrc, SDFile *pDest) {
+  int     sfd = -1, dfd = -1;
+  int64_t nread;
+
+  if (pMh->pBuf == NULL && (pMh->pBuf = malloc(TSDB_TIER_COPY_BUF_SIZE)) == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    return -1;
+  }
+
+  sfd = tfsopen(TSDB_FILE_F(pSrc), O_RDONLY);
+  if (sfd < 0) {
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    goto _err;
+  }
+
+  dfd = tfsopen(TSDB_FILE_F(pDest), O_WRONLY | O_CREAT | O_EXCL);
+  if (dfd < 0) {
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    goto _err;
+  }
+
+  while (true) {
+    if (tsdbThrottleTierMigrate(pMh) < 0) goto _err;
+
+    nread = taosRead(sfd, pMh->pBuf, TSDB_TIER_COPY_BUF_SIZE);
+    if (nread < 0) {
+      terrno = TAOS_SYSTEM_ERROR(errno);
+      goto _err;
+    }
+    if (nread == 0) break;
+
+    if (taosWrite(dfd, pMh->pBuf, nread) < nread) {
+      terrno = TAOS_SYSTEM_ERROR(errno);
+      goto _err;
+    }
+
+    pMh->ioBytes += nread * 2;
+  }
+
+  if (taosFsync(dfd) < 0) {
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    goto _err;
+  }
+
+  if (tsdbWriteBackSize > 0) {
+    taosDropCache(sfd, 0, 0);
+    taosDropCache(dfd, 0, 0);
+  }
+
+  tfsclose(sfd);
+  tfsclose(dfd);
+  tsdbSetDFileInfo(pDest, TSDB_FILE_INFO(pSrc));
+  return 0;
+
+_err:
+  if (sfd >= 0) tfsclose(sfd);
+  if (dfd >= 0) {
+    tfsclose(dfd);
+    tfsremove(TSDB_FILE_F(pDest));
+  }
+  return -1;
+}
+
+// Stop a migration for the ingest or the repo closing, and keep its I/O within tsdbTierMigrateIOBudget
+static int tsdbThrottleTierMigrate(STierMigrateH *pMh) {
+  STsdbRepo *pRepo = pMh->pRepo;
+
+  while (true) {
+    if (pRepo->stopTierMigrate || tsdbIngestUnderPressure(pRepo)) {
+      pMh->cancelled = true;
+      return -1;
+    }
+
+    if (tsdbTierMigrateIOBudget <= 0) return 0;
+
+    int64_t expected = pMh->ioBytes * 1000 / ((int64_t)tsdbTierMigrateIOBudget * 1024 * 1024);
+    int64_t elapsed = taosGetTimestampMs() - pMh->ioStart;
+    if (elapsed >= expected) return 0;
+
+    taosMsleep((int32_t)MIN(expected - elapsed, TSDB_TIER_MIGRATE_SLEEP_MS));
+  }
+}
@@ -0,0 +1,301 @@
+#include <gtest/gtest.h>
+#include <stdlib.h>
+
+#include "os.h"
+#include "tdataformat.h"
+#include "tglobal.h"
+
+#include "tsdbCodec.h"
+
+#pragma GCC diagnostic ignored "-Wunused-function"
+
+namespace {
+
+const int32_t maxRows = 4096;
+
+typedef void (*FGenVal)(int8_t type, int32_t bytes, int32_t row, void *value);
+
+void initCol(SDataCol *pCol, int8_t type, int32_t bytes) {
+  memset(pCol, 0, sizeof(*pCol));
+  pCol->type = type;
+  pCol->colId = 1;
+  pCol->bytes = bytes;
+  ASSERT_EQ(tdAllocMemForCol(pCol, maxRows), 0);
+}
+
+// one value of each fixed length type from an int64, binary and nchar take its decimal digits
+void setVal(int8_t type, int32_t bytes, int64_t v, void *value) {
+  switch (type) {
+    case TSDB_DATA_TYPE_BOOL:      *(int8_t *)value = (int8_t)(v & 1); break;
+    case TSDB_DATA_TYPE_TINYINT:
+    case TSDB_DATA_TYPE_UTINYINT:  *(int8_t *)value = (int8_t)v; break;
+    case TSDB_DATA_TYPE_SMALLINT:
+    case TSDB_DATA_TYPE_USMALLINT: *(int16_t *)value = (int16_t)v; break;
+    case TSDB_DATA_TYPE_INT:
+    case TSDB_DATA_TYPE_UINT:      *(int32_t *)value = (int32_t)v; break;
+    case TSDB_DATA_TYPE_FLOAT:     *(float *)value = (float)v / 7; break;
+    case TSDB_DATA_TYPE_DOUBLE:    *(double *)value = (double)v / 7; break;
+    case TSDB_DATA_TYPE_BINARY: {
+      int len = snprintf((char *)varDataVal(value), bytes - VARSTR_HEADER_SIZE, "v%" PRId64, v);
+      varDataSetLen(value, len);
+      break;
+    }
+    case TSDB_DATA_TYPE_NCHAR: {
+      char    buf[32];
+      int32_t len = snprintf(buf, sizeof(buf), "%" PRId64, v);
+      for (int32_t i = 0; i < len; ++i) {
+        ((int32_t *)varDataVal(value))[i] = buf[i];
+      }
+      varDataSetLen(value, len * TSDB_NCHAR_SIZE);
+      break;
+    }
+    default:                       *(int64_t *)value = v; break;
+  }
+}
+
+void genRepeated(int8_t type, int32_t bytes, int32_t row, void *value) { setVal(type, bytes, row % 10, value); }
+
+void genRandom(int8_t type, int32_t bytes, int32_t row, void *value) {
+  setVal(type, bytes, ((int64_t)rand() << 32) | (uint32_t)rand(), value);
+}
+
+void genNullHeavy(int8_t type, int32_t bytes, int32_t row, void *value) {
+  if (row % 50 != 7) {
+    setNull((char *)value, type, bytes);
+  } else {
+    setVal(type, bytes, row, value);
+  }
+}
+
+/**
+ * Encode the first nRows rows of the column with maxLen as the size to beat, decode them to a new column and compare.
+ * The codec picked is returned.
+ */
+int encodeAndDecode(SDataCol *pCol, int32_t nRows, int32_t maxLen) {
+  void *  pBuf = NULL;
+  char *  output = (char *)malloc(maxLen);
+  int32_t len = 0;
+
+  int codec = tsdbEncodeColumn(pCol, nRows, maxLen, output, &len, &pBuf);
+  EXPECT_GE(codec, TSDB_COL_CODEC_NONE);
+  EXPECT_LE(len, maxLen);
+
+  if (codec > TSDB_COL_CODEC_NONE) {
+    EXPECT_LT(len, maxLen);
+
+    SDataCol col;
+    initCol(&col, pCol->type, pCol->bytes);
+    col.len = tsdbDecodeColumn(&col, (int8_t)codec, output, len, nRows);
+    EXPECT_EQ(col.len, dataColGetNEleLen(pCol, nRows)) << "type " << (int)pCol->type << " codec " << codec;
+
+    if (col.len == dataColGetNEleLen(pCol, nRows)) {
+      if (IS_VAR_DATA_TYPE(col.type)) dataColSetOffset(&col, nRows);
+      for (int32_t i = 0; i < nRows; ++i) {
+        const void *expect = tdGetColDataOfRow(pCol, i);
+        const void *value = tdGetColDataOfRow(&col, i);
+        int32_t     vlen = IS_VAR_DATA_TYPE(col.type) ? varDataTLen(expect) : TYPE_BYTES[col.type];
+        if (memcmp(expect, value, vlen) != 0) {
+          ADD_FAILURE() << "type " << (int)col.type << " codec " << codec << " row " << i;
+          break;
+        }
+      }
+    }
+
+    tfree(col.pData);
+  }
+
+  taosTZfree(pBuf);
+  free(output);
+  return codec;
+}
+
+int checkCodec(int8_t codec, int32_t deflateLevel, SDataCol *pCol, int32_t nRows) {
+  tsdbColumnCodec = codec;
+  tsdbColumnDeflateLevel = deflateLevel;
+
+  return encodeAndDecode(pCol, nRows, dataColGetNEleLen(pCol, nRows));
+}
+
+void fillCol(SDataCol *pCol, int32_t nRows, FGenVal gen) {
+  char *value = (char *)malloc(pCol->bytes);
+
+  pCol->len = 0;
+  for (int32_t i = 0; i < nRows; ++i) {
+    memset(value, 0, pCol->bytes);
+    gen(pCol->type, pCol->bytes, i, value);
+    ASSERT_EQ(dataColAppendVal(pCol, value, i, maxRows, 0), 0);
+  }
+
+  free(value);
+}
+
+const int8_t types[] = {TSDB_DATA_TYPE_BOOL,      TSDB_DATA_TYPE_TINYINT,   TSDB_DATA_TYPE_SMALLINT,
+                        TSDB_DATA_TYPE_INT,       TSDB_DATA_TYPE_BIGINT,    TSDB_DATA_TYPE_FLOAT,
+                        TSDB_DATA_TYPE_DOUBLE,    TSDB_DATA_TYPE_BINARY,    TSDB_DATA_TYPE_TIMESTAMP,
+                        TSDB_DATA_TYPE_NCHAR,     TSDB_DATA_TYPE_UTINYINT,  TSDB_DATA_TYPE_USMALLINT,
+                        TSDB_DATA_TYPE_UINT,      TSDB_DATA_TYPE_UBIGINT};
+
+int32_t typeBytes(int8_t type) {
+  if (type == TSDB_DATA_TYPE_BINARY) return 24 + VARSTR_HEADER_SIZE;
+  if (type == TSDB_DATA_TYPE_NCHAR) return 24 * TSDB_NCHAR_SIZE + VARSTR_HEADER_SIZE;
+  return TYPE_BYTES[type];
+}
+
+bool isFORType(int8_t type) {
+  return IS_SIGNED_NUMERIC_TYPE(type) || IS_UNSIGNED_NUMERIC_TYPE(type) || type == TSDB_DATA_TYPE_TIMESTAMP;
+}
+
+}  // namespace
+
+TEST(TsdbCodecTest, allTypes) {
+  int8_t  codec = tsdbColumnCodec;
+  int32_t deflateLevel = tsdbColumnDeflateLevel;
+  FGenVal gens[] = {genRepeated, genRandom, genNullHeavy};
+  int32_t rows[] = {1, 7, 100, maxRows};
+
+  srand(0);
+  for (int32_t t = 0; t < (int32_t)tListLen(types); ++t) {
+    SDataCol col;
+    initCol(&col, types[t], typeBytes(types[t]));
+
+    for (int32_t g = 0; g < (int32_t)tListLen(gens); ++g) {
+      for (int32_t r = 0; r < (int32_t)tListLen(rows); ++r) {
+        fillCol(&col, rows[r], gens[g]);
+        if (isAllRowsNull(&col)) continue;
+
+        checkCodec(1, 0, &col, rows[r]);
+        checkCodec(0, 6, &col, rows[r]);
+        checkCodec(1, 1, &col, rows[r]);
+      }
+    }
+
+    // the repeated values of a full block are encoded smaller by the codec of the type
+    fillCol(&col, maxRows, genRepeated);
+    if (IS_VAR_DATA_TYPE(col.type)) {
+      EXPECT_EQ(checkCodec(1, 0, &col, maxRows), TSDB_COL_CODEC_DICT);
+    } else if (isFORType(col.type)) {
+      EXPECT_EQ(checkCodec(1, 0, &col, maxRows), TSDB_COL_CODEC_FOR);
+    } else {
+      EXPECT_EQ(checkCodec(1, 0, &col, maxRows), TSDB_COL_CODEC_NONE);
+    }
+    EXPECT_EQ(checkCodec(0, 6, &col, maxRows), TSDB_COL_CODEC_DEFLATE);
+
+    // the nulls of a block with few values are encoded by all codecs
+    fillCol(&col, maxRows, genNullHeavy);
+    if (IS_VAR_DATA_TYPE(col.type)) {
+      EXPECT_EQ(checkCodec(1, 0, &col, maxRows), TSDB_COL_CODEC_DICT);
+    }
+    EXPECT_EQ(checkCodec(0, 6, &col, maxRows), TSDB_COL_CODEC_DEFLATE);
+
+    tfree(col.pData);
+  }
+
+  tsdbColumnCodec = codec;
+  tsdbColumnDeflateLevel = deflateLevel;
+}
+
+TEST(TsdbCodecTest, dictCutoff) {
+  int8_t  codec = tsdbColumnCodec;
+  int32_t deflateLevel = tsdbColumnDeflateLevel;
+  int32_t nDicts[] = {1, 255, 256, 257, 1024, maxRows};
+
+  tsdbColumnCodec = 1;
+  tsdbColumnDeflateLevel = 0;
+
+  SDataCol col;
+  initCol(&col, TSDB_DATA_TYPE_BINARY, typeBytes(TSDB_DATA_TYPE_BINARY));
+  char *value = (char *)malloc(col.bytes);
+
+  // the index of a row takes 1 byte up to 256 distinct values and 2 bytes over it
+  for (int32_t d = 0; d < (int32_t)tListLen(nDicts); ++d) {
+    col.len = 0;
+    for (int32_t i = 0; i < maxRows; ++i) {
+      setVal(col.type, col.bytes, (i * 7919) % nDicts[d], value);
+      ASSERT_EQ(dataColAppendVal(&col, value, i, maxRows, 0), 0);
+    }
+
+    int32_t rawLen = dataColGetNEleLen(&col, maxRows);
+    int     res = encodeAndDecode(&col, maxRows, rawLen);
+    if (nDicts[d] < maxRows) {
+      EXPECT_EQ(res, TSDB_COL_CODEC_DICT) << nDicts[d] << " distinct values";
+    } else {
+      // the dictionary of distinct rows is as large as the column
+      EXPECT_EQ(res, TSDB_COL_CODEC_NONE);
+    }
+
+    // a dictionary larger than the size to beat is given up
+    EXPECT_EQ(encodeAndDecode(&col, maxRows, (int32_t)(sizeof(int32_t) * 2 + sizeof(uint8_t) + 2)),
+              TSDB_COL_CODEC_NONE);
+  }
+
+  free(value);
+  tfree(col.pData);
+
+  tsdbColumnCodec = codec;
+  tsdbColumnDeflateLevel = deflateLevel;
+}
+
+TEST(TsdbCodecTest, forExtremeRanges) {
+  int8_t  codec = tsdbColumnCodec;
+  int32_t deflateLevel = tsdbColumnDeflateLevel;
+
+  tsdbColumnCodec = 1;
+  tsdbColumnDeflateLevel = 0;
+
+  // the lowest and highest value of each type, and offsets of 1, 63 and 64 bits
+  struct {
+    int8_t   type;
+    uint64_t low;
+    uint64_t high;
+  } ranges[] = {
+      {TSDB_DATA_TYPE_TINYINT, (uint64_t)INT8_MIN, INT8_MAX},
+      {TSDB_DATA_TYPE_SMALLINT, (uint64_t)INT16_MIN, INT16_MAX},
+      {TSDB_DATA_TYPE_INT, (uint64_t)INT32_MIN, INT32_MAX},
+      {TSDB_DATA_TYPE_BIGINT, (uint64_t)INT64_MIN, INT64_MAX},
+      {TSDB_DATA_TYPE_BIGINT, (uint64_t)INT64_MAX - 1, INT64_MAX},
+      {TSDB_DATA_TYPE_BIGINT, (uint64_t)INT64_MIN, (uint64_t)INT64_MIN + 1},
+      {TSDB_DATA_TYPE_BIGINT, (uint64_t)-1, 0},
+      {TSDB_DATA_TYPE_BIGINT, (uint64_t)INT64_MIN, (uint64_t)-1},
+      {TSDB_DATA_TYPE_TIMESTAMP, 0, INT64_MAX},
+      {TSDB_DATA_TYPE_UTINYINT, 0, UINT8_MAX},
+      {TSDB_DATA_TYPE_USMALLINT, 0, UINT16_MAX},
+      {TSDB_DATA_TYPE_UINT, 0, UINT32_MAX},
+      {TSDB_DATA_TYPE_UBIGINT, 0, UINT64_MAX},
+      {TSDB_DATA_TYPE_UBIGINT, UINT64_MAX - 1, UINT64_MAX},
+      {TSDB_DATA_TYPE_UBIGINT, 0, (uint64_t)INT64_MAX},
+  };
+  int32_t rows[] = {1, 3, 65, 1000};
+
+  for (int32_t k = 0; k < (int32_t)tListLen(ranges); ++k) {
+    SDataCol col;
+    initCol(&col, ranges[k].type, TYPE_BYTES[ranges[k].type]);
+
+    for (int32_t r = 0; r < (int32_t)tListLen(rows); ++r) {
+      col.len = 0;
+      for (int32_t i = 0; i < rows[r]; ++i) {
+        // the lowest, the highest and random values between them
+        uint64_t span = ranges[k].high - ranges[k].low;
+        uint64_t v = ranges[k].low + ((span < UINT32_MAX) ? (uint64_t)rand() % (span + 1) : (uint64_t)rand());
+        if (i % 3 == 0) v = ranges[k].low;
+        if (i % 3 == 1) v = ranges[k].high;
+
+        int64_t value = 0;
+        memcpy(&value, &v, sizeof(v));
+        ASSERT_EQ(dataColAppendVal(&col, &value, i, maxRows, 0), 0);
+      }
+
+      // the lowest signed values are the nulls, a column of nulls only is not written
+      if (isAllRowsNull(&col)) continue;
+
+      // a size to beat over the column lets the offsets of the widest ranges be packed too
+      int32_t rawLen = dataColGetNEleLen(&col, rows[r]);
+      EXPECT_EQ(encodeAndDecode(&col, rows[r], rawLen * 2 + 16), TSDB_COL_CODEC_FOR) << "range " << k;
+      encodeAndDecode(&col, rows[r], rawLen);
+    }
+
+    tfree(col.pData);
+  }
+
+  tsdbColumnCodec = codec;
+  tsdbColumnDeflateLevel = deflateLevel;
+}
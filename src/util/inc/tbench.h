@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TDENGINE_TBENCH_H
+#define TDENGINE_TBENCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "os.h"
+
+// Helpers of the benchmarks of the tests comparing the levels of the SIMD kernels: the arguments, the random values
+// and the timing loop.
+
+typedef struct {
+  int    rows;
+  double seconds;
+} SBenchArgs;
+
+// usage: <bench> [rows per block] [seconds per case]
+static FORCE_INLINE int benchParseArgs(int argc, char *argv[], SBenchArgs *pArgs) {
+  pArgs->rows = (argc > 1) ? atoi(argv[1]) : 4096;
+  pArgs->seconds = (argc > 2) ? atof(argv[2]) : 0.5;
+  if (pArgs->rows <= 0 || pArgs->seconds <= 0) {
+    printf("usage: %s [rows per block] [seconds per case]\n", argv[0]);
+    return -1;
+  }
+  return 0;
+}
+
+// xorshift, the values are the same in every run
+static FORCE_INLINE uint64_t benchRand() {
+  static uint64_t x = 88172645463325252ull;
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+  return x;
+}
+
+// the header of the columns of the levels from, to, each 15 characters wide
+static FORCE_INLINE void benchPrintLevels(const char *names[], int from, int to, const char *unit) {
+  for (int level = from; level <= to; level++) printf(" %*s %s", 14 - (int)strlen(unit), names[level], unit);
+  printf("\n");
+}
+
+// calls fp in batches of 64 for the seconds, returns the calls per microsecond
+static FORCE_INLINE double benchLoop(void (*fp)(void *param), void *param, double seconds) {
+  int64_t loops = 0;
+  int64_t start = taosGetTimestampUs();
+  int64_t elapsed = 0;
+  do {
+    for (int i = 0; i < 64; i++) fp(param);
+    loops += 64;
+    elapsed = taosGetTimestampUs() - start;
+  } while (elapsed < seconds * 1000000);
+
+  return (double)loops / elapsed;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TDENGINE_TBENCH_H
@@ -50,6 +50,11 @@ extern "C" {
 #define HEAD_MODE(x)  x%2
 #define HEAD_ALGO(x)  x/2
 
+// SIMD instruction set used by the decoders, the best one supported by the CPU is used by default
+#define COMP_SIMD_NONE 0
+#define COMP_SIMD_SSE4 1
+#define COMP_SIMD_AVX2 2
+
 extern int tsCompressINTImp(const char *const input, const int nelements, char *const output, const char type);
 extern int tsDecompressINTImp(const char *const input, const int nelements, char *const output, const char type);
 extern int tsCompressBoolImp(const char *const input, const int nelements, char *const output);
@@ -68,6 +73,10 @@ extern int tsDecompressFloatLossyImp(const char * input, int compressedSize, con
 extern int tsCompressDoubleLossyImp(const char * input, const int nelements, char *const output);
 extern int tsDecompressDoubleLossyImp(const char * input, int compressedSize, const int nelements, char *const output);
 
+extern int tsCompressSimdLevel();
+// set the SIMD level of the decoders for tests and benchmarks, it is capped by the CPU and the level set is returned
+extern int tsSetCompressSimdLevel(int level);
+
 #ifdef TD_TSZ
 extern bool lossyFloat;
 extern bool lossyDouble;
@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TDENGINE_TSHA256_H
+#define TDENGINE_TSHA256_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#define SHA256_DIGEST_SIZE 32
+
+// SHA-256 of FIPS 180-4, used the same way as MD5_CTX of tmd5.h
+typedef struct {
+  uint32_t state[8];
+  uint64_t count;                       /* number of bytes handled */
+  uint8_t  in[64];                      /* input buffer */
+  uint8_t  digest[SHA256_DIGEST_SIZE];  /* actual digest after SHA256Final call */
+} SHA256_CTX;
+
+void SHA256Init(SHA256_CTX *ctx);
+void SHA256Update(SHA256_CTX *ctx, const uint8_t *inBuf, uint32_t inLen);
+void SHA256Final(SHA256_CTX *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TDENGINE_TSHA256_H
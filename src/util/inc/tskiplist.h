@@ -35,12 +35,14 @@ extern "C" {
 
 // For thread safety setting
 #define SL_THREAD_SAFE (uint8_t)0x4
+#define SL_LOCK_FREE (uint8_t)0x8  // readers without rwlock, a single writer and no removal (for memtable usage)
 
 typedef char *SSkipListKey;
 typedef char *(*__sl_key_fn_t)(const void *);
 
 typedef void (*sl_patch_row_fn_t)(void * pDst, const void * pSrc);
 typedef void* (*iter_next_fn_t)(void *iter);
+typedef void* (*sl_alloc_fn_t)(void *param, int32_t size);
 
 typedef struct SSkipListNode {
   uint8_t        level;
@@ -71,6 +73,16 @@ typedef struct SSkipListNode {
  *
  *    Memory consumption: the memory alignment causes many memory wasted. So, employ a memory
  *    pool will significantly reduce the total memory consumption, as well as the calloc/malloc operation costs.
+ *    A pool can be plugged in by tSkipListSetAllocator(), nodes are then carved from it and never freed one
+ *    by one, the owner of the pool releases them all at once after the skip list is destroyed.
+ *
+ * Note: Lock free mode.
+ * When created with SL_LOCK_FREE, readers never take a lock while a single writer puts nodes, like the
+ * write thread of a vnode does for its memtable. A node is linked on level 0 first, which publishes it to
+ * the readers, and then on the upper levels. Nodes are never unlinked in this mode (tSkipListRemove* are
+ * not supported), which makes every node ever observed before another one stay before it. Backward
+ * pointers are therefore only maintained at level 0 as hints and are fixed up by walking forward.
+ * Duplicated keys must be discarded or updated (SL_ALLOW_DUP_KEY falls back to the locked version).
  *
  */
 
@@ -123,6 +135,10 @@ typedef struct SSkipList {
   tSkipListState state;  // skiplist state
 #endif
   tGenericSavedFunc* insertHandleFn;
+  sl_alloc_fn_t      allocFn;     // allocate data nodes from a pool instead of calloc if not NULL
+  void *             allocParam;
+  uint32_t           numOfAppends;  // puts linked after the max key without a search
+  uint32_t           numOfMerges;   // puts searched for their position, including those on a duplicated key
 } SSkipList;
 
 typedef struct SSkipListIterator {
@@ -134,6 +150,7 @@ typedef struct SSkipListIterator {
 } SSkipListIterator;
 
 #define SL_IS_THREAD_SAFE(s) (((s)->flags) & SL_THREAD_SAFE)
+#define SL_IS_LOCK_FREE(s) (((s)->flags) & SL_LOCK_FREE)
 #define SL_DUP_MODE(s) (((s)->flags) & ((((uint8_t)1) << 2) - 1))
 #define SL_GET_NODE_KEY(s, n) ((s)->keyFn((n)->pData))
 #define SL_GET_MIN_KEY(s) SL_GET_NODE_KEY(s, SL_NODE_GET_FORWARD_POINTER((s)->pHead, 0))
@@ -154,6 +171,7 @@ SSkipListNode *    tSkipListIterGet(SSkipListIterator *iter);
 void *             tSkipListDestroyIter(SSkipListIterator *iter);
 uint32_t           tSkipListRemove(SSkipList *pSkipList, SSkipListKey key);
 void               tSkipListRemoveNode(SSkipList *pSkipList, SSkipListNode *pNode);
+void               tSkipListSetAllocator(SSkipList *pSkipList, sl_alloc_fn_t fn, void *param);
 
 #ifdef __cplusplus
 }
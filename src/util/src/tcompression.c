@@ -66,6 +66,313 @@ static const int TEST_NUMBER = 1;
 #define ZIGZAG_ENCODE(T, v) ((u##T)((v) >> (sizeof(T) * 8 - 1))) ^ (((u##T)(v)) << 1)  // zigzag encode
 #define ZIGZAG_DECODE(T, v) ((v) >> 1) ^ -((T)((v)&1))                                 // zigzag decode
 
+#if defined(__x86_64__) && !defined(WINDOWS) && !defined(_TD_ARM_) && !defined(_TD_MIPS_)
+#define COMP_SIMD_X86
+#include <immintrin.h>
+#endif
+
+// Values are decoded into chunks before the prefix sum (or xor) is applied, the chunk size must be even so that a
+// pair of values sharing a flag byte is never split
+#define DECODE_CHUNK_SIZE 256
+// Bytes of a value may be loaded with a fixed size load if there are at least that many bytes after it, which is
+// true if DECODE_SAFE_TAIL more values follow since each pair of them takes at least one byte
+#define DECODE_SAFE_TAIL 18
+
+static const uint64_t byteMask[16] = {0x0ul,
+                                      0xfful,
+                                      0xfffful,
+                                      0xfffffful,
+                                      0xfffffffful,
+                                      0xfffffffffful,
+                                      0xfffffffffffful,
+                                      0xfffffffffffffful,
+                                      0xfffffffffffffffful,
+                                      0xfffffffffffffffful,
+                                      0xfffffffffffffffful,
+                                      0xfffffffffffffffful,
+                                      0xfffffffffffffffful,
+                                      0xfffffffffffffffful,
+                                      0xfffffffffffffffful,
+                                      0xfffffffffffffffful};
+
+/* ----------------------------------------------Decode Kernels
+ * ---------------------------------------------- */
+// The decoders parse the variable length codes with scalar code, and the data parallel steps, which are the prefix
+// sums of the deltas, the prefix xor of the float values and the unpacking of bools, are done by these kernels.
+typedef struct {
+  int64_t (*unzigzagSum64)(const uint64_t *src, int64_t *dst, int n, int64_t carry);
+  int64_t (*unzigzagSum2x64)(const uint64_t *src, int64_t *dst, int n, int64_t *delta, int64_t carry);
+  uint64_t (*xor64)(uint64_t *v, int n, uint64_t carry);
+  uint32_t (*xor32)(uint32_t *v, int n, uint32_t carry);
+  void (*unpackBool)(const uint8_t *in, int nbytes, char *out);
+} SDecodeKernels;
+
+static int64_t unzigzagSum64(const uint64_t *src, int64_t *dst, int n, int64_t carry) {
+  uint64_t sum = (uint64_t)carry;
+  for (int i = 0; i < n; i++) {
+    sum += (src[i] >> 1) ^ (0 - (src[i] & 1));
+    dst[i] = (int64_t)sum;
+  }
+  return (int64_t)sum;
+}
+
+// the values of the delta of deltas, the prefix sum of the prefix sum
+static int64_t unzigzagSum2x64(const uint64_t *src, int64_t *dst, int n, int64_t *delta, int64_t carry) {
+  uint64_t d = (uint64_t)(*delta);
+  uint64_t sum = (uint64_t)carry;
+  for (int i = 0; i < n; i++) {
+    d += (src[i] >> 1) ^ (0 - (src[i] & 1));
+    sum += d;
+    dst[i] = (int64_t)sum;
+  }
+  *delta = (int64_t)d;
+  return (int64_t)sum;
+}
+
+static uint64_t xor64(uint64_t *v, int n, uint64_t carry) {
+  for (int i = 0; i < n; i++) {
+    carry ^= v[i];
+    v[i] = carry;
+  }
+  return carry;
+}
+
+static uint32_t xor32(uint32_t *v, int n, uint32_t carry) {
+  for (int i = 0; i < n; i++) {
+    carry ^= v[i];
+    v[i] = carry;
+  }
+  return carry;
+}
+
+static void unpackBool(const uint8_t *in, int nbytes, char *out) {
+  static const char values[4] = {0, 1, TSDB_DATA_BOOL_NULL, 0};
+  for (int i = 0; i < nbytes; i++) {
+    uint8_t b = in[i];
+    out[4 * i] = values[b & INT8MASK(2)];
+    out[4 * i + 1] = values[(b >> 2) & INT8MASK(2)];
+    out[4 * i + 2] = values[(b >> 4) & INT8MASK(2)];
+    out[4 * i + 3] = values[(b >> 6) & INT8MASK(2)];
+  }
+}
+
+#ifdef COMP_SIMD_X86
+#define UNZIGZAG_SSE(v) _mm_xor_si128(_mm_srli_epi64(v, 1), _mm_sub_epi64(_mm_setzero_si128(), _mm_and_si128(v, one)))
+#define UNZIGZAG_AVX2(v) \
+  _mm256_xor_si256(_mm256_srli_epi64(v, 1), _mm256_sub_epi64(_mm256_setzero_si256(), _mm256_and_si256(v, one)))
+
+// prefix sum of the 2 lanes
+__attribute__((target("sse4.1"))) static FORCE_INLINE __m128i prefixSum2x64(__m128i v) {
+  return _mm_add_epi64(v, _mm_slli_si128(v, 8));
+}
+
+// prefix sum of the 4 lanes, the sum of the low 128 bits is added to the high ones
+__attribute__((target("avx2"))) static FORCE_INLINE __m256i prefixSum4x64(__m256i v) {
+  v = _mm256_add_epi64(v, _mm256_slli_si256(v, 8));
+  __m256i low = _mm256_permute4x64_epi64(v, _MM_SHUFFLE(1, 1, 1, 1));
+  return _mm256_add_epi64(v, _mm256_blend_epi32(_mm256_setzero_si256(), low, 0xF0));
+}
+
+__attribute__((target("avx2"))) static FORCE_INLINE __m256i prefixXor4x64(__m256i v) {
+  v = _mm256_xor_si256(v, _mm256_slli_si256(v, 8));
+  __m256i low = _mm256_permute4x64_epi64(v, _MM_SHUFFLE(1, 1, 1, 1));
+  return _mm256_xor_si256(v, _mm256_blend_epi32(_mm256_setzero_si256(), low, 0xF0));
+}
+
+__attribute__((target("sse4.1"))) static int64_t unzigzagSum64Sse4(const uint64_t *src, int64_t *dst, int n,
+                                                                   int64_t carry) {
+  const __m128i one = _mm_set1_epi64x(1);
+  __m128i       sum = _mm_set1_epi64x(carry);
+  int           i = 0;
+  for (; i + 2 <= n; i += 2) {
+    __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+    v = _mm_add_epi64(prefixSum2x64(UNZIGZAG_SSE(v)), sum);
+    _mm_storeu_si128((__m128i *)(dst + i), v);
+    sum = _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 2, 3, 2));
+  }
+  return unzigzagSum64(src + i, dst + i, n - i, _mm_cvtsi128_si64(sum));
+}
+
+__attribute__((target("sse4.1"))) static int64_t unzigzagSum2x64Sse4(const uint64_t *src, int64_t *dst, int n,
+                                                                     int64_t *delta, int64_t carry) {
+  const __m128i one = _mm_set1_epi64x(1);
+  __m128i       d = _mm_set1_epi64x(*delta);
+  __m128i       sum = _mm_set1_epi64x(carry);
+  int           i = 0;
+  for (; i + 2 <= n; i += 2) {
+    __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+    d = _mm_add_epi64(prefixSum2x64(UNZIGZAG_SSE(v)), d);
+    v = _mm_add_epi64(prefixSum2x64(d), sum);
+    _mm_storeu_si128((__m128i *)(dst + i), v);
+    d = _mm_shuffle_epi32(d, _MM_SHUFFLE(3, 2, 3, 2));
+    sum = _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 2, 3, 2));
+  }
+  *delta = _mm_cvtsi128_si64(d);
+  return unzigzagSum2x64(src + i, dst + i, n - i, delta, _mm_cvtsi128_si64(sum));
+}
+
+__attribute__((target("sse4.1"))) static uint64_t xor64Sse4(uint64_t *v, int n, uint64_t carry) {
+  __m128i acc = _mm_set1_epi64x((int64_t)carry);
+  int     i = 0;
+  for (; i + 2 <= n; i += 2) {
+    __m128i x = _mm_loadu_si128((const __m128i *)(v + i));
+    x = _mm_xor_si128(_mm_xor_si128(x, _mm_slli_si128(x, 8)), acc);
+    _mm_storeu_si128((__m128i *)(v + i), x);
+    acc = _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 2, 3, 2));
+  }
+  return xor64(v + i, n - i, (uint64_t)_mm_cvtsi128_si64(acc));
+}
+
+__attribute__((target("sse4.1"))) static uint32_t xor32Sse4(uint32_t *v, int n, uint32_t carry) {
+  __m128i acc = _mm_set1_epi32((int32_t)carry);
+  int     i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m128i x = _mm_loadu_si128((const __m128i *)(v + i));
+    x = _mm_xor_si128(x, _mm_slli_si128(x, 4));
+    x = _mm_xor_si128(_mm_xor_si128(x, _mm_slli_si128(x, 8)), acc);
+    _mm_storeu_si128((__m128i *)(v + i), x);
+    acc = _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 3, 3));
+  }
+  return xor32(v + i, n - i, (uint32_t)_mm_cvtsi128_si32(acc));
+}
+
+// each byte is copied to 4 output bytes, which are then masked to the 2 bits of the output value and compared
+__attribute__((target("sse4.1"))) static void unpackBoolSse4(const uint8_t *in, int nbytes, char *out) {
+  const __m128i index = _mm_setr_epi8(0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3);
+  const __m128i mask = _mm_set1_epi32((int32_t)0xC0300C03);
+  const __m128i ones = _mm_set1_epi32(0x40100401);
+  const __m128i nulls = _mm_set1_epi32((int32_t)0x80200802);
+  int           i = 0;
+  for (; i + 4 <= nbytes; i += 4) {
+    int32_t w;
+    memcpy(&w, in + i, sizeof(w));
+    __m128i x = _mm_and_si128(_mm_shuffle_epi8(_mm_cvtsi32_si128(w), index), mask);
+    __m128i r = _mm_or_si128(_mm_and_si128(_mm_cmpeq_epi8(x, ones), _mm_set1_epi8(1)),
+                             _mm_and_si128(_mm_cmpeq_epi8(x, nulls), _mm_set1_epi8(TSDB_DATA_BOOL_NULL)));
+    _mm_storeu_si128((__m128i *)(out + 4 * i), r);
+  }
+  unpackBool(in + i, nbytes - i, out + 4 * i);
+}
+
+__attribute__((target("avx2"))) static int64_t unzigzagSum64Avx2(const uint64_t *src, int64_t *dst, int n,
+                                                                 int64_t carry) {
+  const __m256i one = _mm256_set1_epi64x(1);
+  __m256i       sum = _mm256_set1_epi64x(carry);
+  int           i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)(src + i));
+    v = _mm256_add_epi64(prefixSum4x64(UNZIGZAG_AVX2(v)), sum);
+    _mm256_storeu_si256((__m256i *)(dst + i), v);
+    sum = _mm256_permute4x64_epi64(v, _MM_SHUFFLE(3, 3, 3, 3));
+  }
+  return unzigzagSum64(src + i, dst + i, n - i, _mm_cvtsi128_si64(_mm256_castsi256_si128(sum)));
+}
+
+__attribute__((target("avx2"))) static int64_t unzigzagSum2x64Avx2(const uint64_t *src, int64_t *dst, int n,
+                                                                   int64_t *delta, int64_t carry) {
+  const __m256i one = _mm256_set1_epi64x(1);
+  __m256i       d = _mm256_set1_epi64x(*delta);
+  __m256i       sum = _mm256_set1_epi64x(carry);
+  int           i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)(src + i));
+    d = _mm256_add_epi64(prefixSum4x64(UNZIGZAG_AVX2(v)), d);
+    v = _mm256_add_epi64(prefixSum4x64(d), sum);
+    _mm256_storeu_si256((__m256i *)(dst + i), v);
+    d = _mm256_permute4x64_epi64(d, _MM_SHUFFLE(3, 3, 3, 3));
+    sum = _mm256_permute4x64_epi64(v, _MM_SHUFFLE(3, 3, 3, 3));
+  }
+  *delta = _mm_cvtsi128_si64(_mm256_castsi256_si128(d));
+  return unzigzagSum2x64(src + i, dst + i, n - i, delta, _mm_cvtsi128_si64(_mm256_castsi256_si128(sum)));
+}
+
+__attribute__((target("avx2"))) static uint64_t xor64Avx2(uint64_t *v, int n, uint64_t carry) {
+  __m256i acc = _mm256_set1_epi64x((int64_t)carry);
+  int     i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m256i x = _mm256_xor_si256(prefixXor4x64(_mm256_loadu_si256((const __m256i *)(v + i))), acc);
+    _mm256_storeu_si256((__m256i *)(v + i), x);
+    acc = _mm256_permute4x64_epi64(x, _MM_SHUFFLE(3, 3, 3, 3));
+  }
+  return xor64(v + i, n - i, (uint64_t)_mm_cvtsi128_si64(_mm256_castsi256_si128(acc)));
+}
+
+__attribute__((target("avx2"))) static uint32_t xor32Avx2(uint32_t *v, int n, uint32_t carry) {
+  const __m256i lane3 = _mm256_set1_epi32(3);
+  const __m256i lane7 = _mm256_set1_epi32(7);
+  __m256i       acc = _mm256_set1_epi32((int32_t)carry);
+  int           i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256i x = _mm256_loadu_si256((const __m256i *)(v + i));
+    x = _mm256_xor_si256(x, _mm256_slli_si256(x, 4));
+    x = _mm256_xor_si256(x, _mm256_slli_si256(x, 8));
+    x = _mm256_xor_si256(x, _mm256_blend_epi32(_mm256_setzero_si256(), _mm256_permutevar8x32_epi32(x, lane3), 0xF0));
+    x = _mm256_xor_si256(x, acc);
+    _mm256_storeu_si256((__m256i *)(v + i), x);
+    acc = _mm256_permutevar8x32_epi32(x, lane7);
+  }
+  return xor32(v + i, n - i, (uint32_t)_mm_cvtsi128_si32(_mm256_castsi256_si128(acc)));
+}
+
+__attribute__((target("avx2"))) static void unpackBoolAvx2(const uint8_t *in, int nbytes, char *out) {
+  const __m256i index = _mm256_setr_epi8(0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 6, 6,
+                                         6, 6, 7, 7, 7, 7);
+  const __m256i mask = _mm256_set1_epi32((int32_t)0xC0300C03);
+  const __m256i ones = _mm256_set1_epi32(0x40100401);
+  const __m256i nulls = _mm256_set1_epi32((int32_t)0x80200802);
+  int           i = 0;
+  for (; i + 8 <= nbytes; i += 8) {
+    int64_t w;
+    memcpy(&w, in + i, sizeof(w));
+    __m256i x = _mm256_and_si256(_mm256_shuffle_epi8(_mm256_set1_epi64x(w), index), mask);
+    __m256i r = _mm256_or_si256(_mm256_and_si256(_mm256_cmpeq_epi8(x, ones), _mm256_set1_epi8(1)),
+                                _mm256_and_si256(_mm256_cmpeq_epi8(x, nulls), _mm256_set1_epi8(TSDB_DATA_BOOL_NULL)));
+    _mm256_storeu_si256((__m256i *)(out + 4 * i), r);
+  }
+  unpackBoolSse4(in + i, nbytes - i, out + 4 * i);
+}
+#endif
+
+static const SDecodeKernels decodeKernels[] = {
+    {unzigzagSum64, unzigzagSum2x64, xor64, xor32, unpackBool},
+#ifdef COMP_SIMD_X86
+    {unzigzagSum64Sse4, unzigzagSum2x64Sse4, xor64Sse4, xor32Sse4, unpackBoolSse4},
+    {unzigzagSum64Avx2, unzigzagSum2x64Avx2, xor64Avx2, xor32Avx2, unpackBoolAvx2},
+#endif
+};
+
+static int32_t decodeSimdLevel = -1;
+
+static int tsCpuSimdLevel() {
+#ifdef COMP_SIMD_X86
+  int32_t cpuLevel = taosGetCpuSimdLevel();
+  if (cpuLevel >= TAOS_CPU_SIMD_AVX2) return COMP_SIMD_AVX2;
+  if (cpuLevel >= TAOS_CPU_SIMD_SSE4) return COMP_SIMD_SSE4;
+#endif
+  return COMP_SIMD_NONE;
+}
+
+int tsCompressSimdLevel() {
+  // resolved by the first decoder, the threads resolving it together store the same level
+  int32_t level = atomic_load_32(&decodeSimdLevel);
+  if (level < 0) {
+    atomic_val_compare_exchange_32(&decodeSimdLevel, -1, tsCpuSimdLevel());
+    level = atomic_load_32(&decodeSimdLevel);
+  }
+  return level;
+}
+
+int tsSetCompressSimdLevel(int level) {
+  int cpuLevel = tsCpuSimdLevel();
+  if (level > cpuLevel) level = cpuLevel;
+  if (level < COMP_SIMD_NONE) level = COMP_SIMD_NONE;
+
+  atomic_store_32(&decodeSimdLevel, level);
+  return level;
+}
+
+static FORCE_INLINE const SDecodeKernels *tsDecodeKernels() { return &decodeKernels[tsCompressSimdLevel()]; }
+
 #ifdef TD_TSZ
 bool lossyFloat  = false;
 bool lossyDouble = false;
@@ -260,62 +567,104 @@ int tsDecompressINTImp(const char *const input, const int nelements, char *const
 
   // Selector value:              0    1   2   3   4   5   6   7   8  9  10  11
   // 12  13  14  15
-  char bit_per_integer[] = {0, 0, 1, 2, 3, 4, 5, 6, 7, 8, 10, 12, 15, 20, 30, 60};
-  int  selector_to_elems[] = {240, 120, 60, 30, 20, 15, 12, 10, 8, 7, 6, 5, 4, 3, 2, 1};
+  int selector_to_elems[] = {240, 120, 60, 30, 20, 15, 12, 10, 8, 7, 6, 5, 4, 3, 2, 1};
+
+  const SDecodeKernels *pKernels = tsDecodeKernels();
+
+  // The values of a word are unpacked with a constant bit width, so the loop can be unrolled and vectorized
+#define SIMPLE8B_UNPACK(_bit)                                  \
+  for (int i = 0; i < elems; i++) {                            \
+    zigzag[n + i] = (w >> (4 + (_bit) * i)) & INT64MASK(_bit); \
+  }
 
   const char *ip = input + 1;
   int         count = 0;
-  int         _pos = 0;
   int64_t     prev_value = 0;
-
-  while (1) {
-    if (count == nelements) break;
-
-    uint64_t w = 0;
-    memcpy(&w, ip, LONG_BYTES);
-
-    char selector = (char)(w & INT64MASK(4));  // selector = 4
-    char bit = bit_per_integer[(int)selector];      // bit = 3
-    int  elems = selector_to_elems[(int)selector];
-
-    for (int i = 0; i < elems; i++) {
-      uint64_t zigzag_value;
-
-      if (selector == 0 || selector == 1) {
-        zigzag_value = 0;
-      } else {
-        zigzag_value = ((w >> (4 + bit * i)) & INT64MASK(bit));
-      }
-      int64_t diff = ZIGZAG_DECODE(int64_t, zigzag_value);
-      int64_t curr_value = diff + prev_value;
-      prev_value = curr_value;
-
-      switch (type) {
-        case TSDB_DATA_TYPE_BIGINT:
-          *((int64_t *)output + _pos) = (int64_t)curr_value;
-          _pos++;
+  uint64_t    zigzag[DECODE_CHUNK_SIZE + 240];
+  int64_t     values[DECODE_CHUNK_SIZE + 240];
+
+  while (count < nelements) {
+    int n = 0;
+    while (n < DECODE_CHUNK_SIZE && count + n < nelements) {
+      uint64_t w = 0;
+      memcpy(&w, ip, LONG_BYTES);
+      ip += LONG_BYTES;
+
+      char selector = (char)(w & INT64MASK(4));
+      int  elems = selector_to_elems[(int)selector];
+      switch (selector) {
+        case 0:
+        case 1:
+          memset(zigzag + n, 0, elems * sizeof(uint64_t));
           break;
-        case TSDB_DATA_TYPE_INT:
-          *((int32_t *)output + _pos) = (int32_t)curr_value;
-          _pos++;
+        case 2:
+          SIMPLE8B_UNPACK(1);
           break;
-        case TSDB_DATA_TYPE_SMALLINT:
-          *((int16_t *)output + _pos) = (int16_t)curr_value;
-          _pos++;
+        case 3:
+          SIMPLE8B_UNPACK(2);
           break;
-        case TSDB_DATA_TYPE_TINYINT:
-          *((int8_t *)output + _pos) = (int8_t)curr_value;
-          _pos++;
+        case 4:
+          SIMPLE8B_UNPACK(3);
+          break;
+        case 5:
+          SIMPLE8B_UNPACK(4);
+          break;
+        case 6:
+          SIMPLE8B_UNPACK(5);
+          break;
+        case 7:
+          SIMPLE8B_UNPACK(6);
+          break;
+        case 8:
+          SIMPLE8B_UNPACK(7);
+          break;
+        case 9:
+          SIMPLE8B_UNPACK(8);
+          break;
+        case 10:
+          SIMPLE8B_UNPACK(10);
+          break;
+        case 11:
+          SIMPLE8B_UNPACK(12);
+          break;
+        case 12:
+          SIMPLE8B_UNPACK(15);
+          break;
+        case 13:
+          SIMPLE8B_UNPACK(20);
+          break;
+        case 14:
+          SIMPLE8B_UNPACK(30);
           break;
         default:
-          perror("Wrong integer types.\n");
-          return -1;
+          SIMPLE8B_UNPACK(60);
+          break;
       }
-      count++;
-      if (count == nelements) break;
+      n += elems;
+    }
+
+    // the last word may hold more values than nelements
+    n = MIN(n, nelements - count);
+    switch (type) {
+      case TSDB_DATA_TYPE_BIGINT:
+        prev_value = pKernels->unzigzagSum64(zigzag, (int64_t *)output + count, n, prev_value);
+        break;
+      case TSDB_DATA_TYPE_INT:
+        prev_value = pKernels->unzigzagSum64(zigzag, values, n, prev_value);
+        for (int i = 0; i < n; i++) *((int32_t *)output + count + i) = (int32_t)values[i];
+        break;
+      case TSDB_DATA_TYPE_SMALLINT:
+        prev_value = pKernels->unzigzagSum64(zigzag, values, n, prev_value);
+        for (int i = 0; i < n; i++) *((int16_t *)output + count + i) = (int16_t)values[i];
+        break;
+      default:
+        prev_value = pKernels->unzigzagSum64(zigzag, values, n, prev_value);
+        for (int i = 0; i < n; i++) *((int8_t *)output + count + i) = (int8_t)values[i];
+        break;
     }
-    ip += LONG_BYTES;
+    count += n;
   }
+#undef SIMPLE8B_UNPACK
 
   return nelements * word_length;
 }
@@ -355,21 +704,19 @@ int tsCompressBoolImp(const char *const input, const int nelements, char *const
 }
 
 int tsDecompressBoolImp(const char *const input, const int nelements, char *const output) {
-  int ipos = -1, opos = 0;
   int ele_per_byte = BITS_PER_BYTE / 2;
+  int nbytes = nelements / ele_per_byte;
 
-  for (int i = 0; i < nelements; i++) {
-    if (i % ele_per_byte == 0) {
-      ipos++;
-    }
+  tsDecodeKernels()->unpackBool((const uint8_t *)input, nbytes, output);
 
-    uint8_t ele = (input[ipos] >> (2 * (i % ele_per_byte))) & INT8MASK(2);
+  for (int i = nbytes * ele_per_byte; i < nelements; i++) {
+    uint8_t ele = (input[nbytes] >> (2 * (i % ele_per_byte))) & INT8MASK(2);
     if (ele == 1) {
-      output[opos++] = 1;
+      output[i] = 1;
     } else if (ele == 2) {
-      output[opos++] = TSDB_DATA_BOOL_NULL;
+      output[i] = TSDB_DATA_BOOL_NULL;
     } else {
-      output[opos++] = 0;
+      output[i] = 0;
     }
   }
 
@@ -575,67 +922,79 @@ int tsDecompressTimestampImp(const char *const input, const int nelements, char
     memcpy(output, input + 1, nelements * LONG_BYTES);
     return nelements * LONG_BYTES;
   } else if (input[0] == 1) {  // Decompress
+    const SDecodeKernels *pKernels = tsDecodeKernels();
+
     int64_t *ostream = (int64_t *)output;
+    uint64_t dd[DECODE_CHUNK_SIZE];
 
     int     ipos = 1, opos = 0;
     int8_t  nbytes = 0;
     int64_t prev_value = 0;
     int64_t prev_delta = 0;
-    int64_t delta_of_delta = 0;
-
-    while (1) {
-      uint8_t flags = input[ipos++];
-      // Decode dd1
-      uint64_t dd1 = 0;
-      nbytes = flags & INT8MASK(4);
-      if (nbytes == 0) {
-        delta_of_delta = 0;
-      } else {
+
+    while (opos < nelements) {
+      int n = MIN(DECODE_CHUNK_SIZE, nelements - opos);
+      int i = 0;
+
+      // Decode the zigzag encoded delta of deltas of the chunk
+      if (!is_bigendian()) {
+        for (; i + 2 <= n && opos + i + DECODE_SAFE_TAIL <= nelements; i += 2) {
+          uint8_t flags = input[ipos++];
+          if (flags == 0) {  // common for timestamps of a fixed interval, the position does not wait for the load
+            dd[i] = dd[i + 1] = 0;
+            continue;
+          }
+          memcpy(&dd[i], input + ipos, LONG_BYTES);
+          dd[i] &= byteMask[flags & INT8MASK(4)];
+          ipos += flags & INT8MASK(4);
+          memcpy(&dd[i + 1], input + ipos, LONG_BYTES);
+          dd[i + 1] &= byteMask[(flags >> 4) & INT8MASK(4)];
+          ipos += (flags >> 4) & INT8MASK(4);
+        }
+      }
+      for (; i < n; i += 2) {
+        uint8_t flags = input[ipos++];
+        // Decode dd1
+        dd[i] = 0;
+        nbytes = flags & INT8MASK(4);
         if (is_bigendian()) {
-          memcpy(((char *)(&dd1)) + LONG_BYTES - nbytes, input + ipos, nbytes);
+          memcpy(((char *)(&dd[i])) + LONG_BYTES - nbytes, input + ipos, nbytes);
         } else {
-          memcpy(&dd1, input + ipos, nbytes);
+          memcpy(&dd[i], input + ipos, nbytes);
         }
-        delta_of_delta = ZIGZAG_DECODE(int64_t, dd1);
-      }
-      ipos += nbytes;
-      if (opos == 0) {
-        prev_value = delta_of_delta;
-        prev_delta = 0;
-        ostream[opos++] = delta_of_delta;
-      } else {
-        prev_delta = delta_of_delta + prev_delta;
-        prev_value = prev_value + prev_delta;
-        ostream[opos++] = prev_value;
-      }
-      if (opos == nelements) return nelements * LONG_BYTES;
+        ipos += nbytes;
+        if (i + 1 == n) break;
 
-      // Decode dd2
-      uint64_t dd2 = 0;
-      nbytes = (flags >> 4) & INT8MASK(4);
-      if (nbytes == 0) {
-        delta_of_delta = 0;
-      } else {
+        // Decode dd2
+        dd[i + 1] = 0;
+        nbytes = (flags >> 4) & INT8MASK(4);
         if (is_bigendian()) {
-          memcpy(((char *)(&dd2)) + LONG_BYTES - nbytes, input + ipos, nbytes);
+          memcpy(((char *)(&dd[i + 1])) + LONG_BYTES - nbytes, input + ipos, nbytes);
         } else {
-          memcpy(&dd2, input + ipos, nbytes);
+          memcpy(&dd[i + 1], input + ipos, nbytes);
         }
-        // zigzag_decoding
-        delta_of_delta = ZIGZAG_DECODE(int64_t, dd2);
+        ipos += nbytes;
+      }
+
+      // The first value is stored as is, then the deltas and the values are the prefix sums
+      i = 0;
+      if (opos == 0) {
+        prev_value = ZIGZAG_DECODE(int64_t, dd[0]);
+        prev_delta = 0;
+        ostream[opos] = prev_value;
+        i = 1;
       }
-      ipos += nbytes;
-      prev_delta = delta_of_delta + prev_delta;
-      prev_value = prev_value + prev_delta;
-      ostream[opos++] = prev_value;
-      if (opos == nelements) return nelements * LONG_BYTES;
+      prev_value = pKernels->unzigzagSum2x64(dd + i, ostream + opos + i, n - i, &prev_delta, prev_value);
+      opos += n;
     }
 
+    return nelements * LONG_BYTES;
   } else {
     assert(0);
     return -1;
   }
 }
+
 /* --------------------------------------------Double Compression
  * ---------------------------------------------- */
 void encodeDoubleValue(uint64_t diff, uint8_t flag, char *const output, int *const pos) {
@@ -748,7 +1107,7 @@ uint64_t decodeDoubleValue(const char *const input, int *const ipos, uint8_t fla
 
 int tsDecompressDoubleImp(const char *const input, const int nelements, char *const output) {
   // output stream
-  double *ostream = (double *)output;
+  uint64_t *ostream = (uint64_t *)output;
 
   if (input[0] == 1) {
     memcpy(output, input + 1, nelements * DOUBLE_BYTES);
@@ -759,8 +1118,29 @@ int tsDecompressDoubleImp(const char *const input, const int nelements, char *co
   int      ipos = 1;
   int      opos = 0;
   uint64_t prev_value = 0;
+  int      i = 0;
+
+  // Decode the xor diffs, bytes are loaded with a fixed size load while there are enough bytes after them
+  if (!is_bigendian()) {
+    const char *ip = input + ipos;
+    for (; i + DECODE_SAFE_TAIL <= nelements; i++) {
+      if (i % 2 == 0) {
+        flags = *(ip++);
+      }
 
-  for (int i = 0; i < nelements; i++) {
+      uint8_t  flag = flags & INT8MASK(4);
+      int      nbytes = (flag & INT8MASK(3)) + 1;
+      uint64_t diff;
+      flags >>= 4;
+
+      memcpy(&diff, ip, LONG_BYTES);
+      ip += nbytes;
+      ostream[opos++] = (diff & byteMask[nbytes]) << ((LONG_BYTES * BITS_PER_BYTE - nbytes * BITS_PER_BYTE) * (flag >> 3));
+    }
+    ipos = (int)(ip - input);
+  }
+
+  for (; i < nelements; i++) {
     if (i % 2 == 0) {
       flags = input[ipos++];
     }
@@ -768,19 +1148,12 @@ int tsDecompressDoubleImp(const char *const input, const int nelements, char *co
     uint8_t flag = flags & INT8MASK(4);
     flags >>= 4;
 
-    uint64_t diff = decodeDoubleValue(input, &ipos, flag);
-    union {
-      uint64_t bits;
-      double   real;
-    } curr;
-
-    uint64_t predicted = prev_value;
-    curr.bits = predicted ^ diff;
-    prev_value = curr.bits;
-
-    ostream[opos++] = curr.real;
+    ostream[opos++] = decodeDoubleValue(input, &ipos, flag);
   }
 
+  // A value is the xor of the diffs up to it
+  tsDecodeKernels()->xor64(ostream, nelements, prev_value);
+
   return nelements * DOUBLE_BYTES;
 }
 
@@ -894,7 +1267,7 @@ uint32_t decodeFloatValue(const char *const input, int *const ipos, uint8_t flag
 }
 
 int tsDecompressFloatImp(const char *const input, const int nelements, char *const output) {
-  float *ostream = (float *)output;
+  uint32_t *ostream = (uint32_t *)output;
 
   if (input[0] == 1) {
     memcpy(output, input + 1, nelements * FLOAT_BYTES);
@@ -905,8 +1278,36 @@ int tsDecompressFloatImp(const char *const input, const int nelements, char *con
   int      ipos = 1;
   int      opos = 0;
   uint32_t prev_value = 0;
+  int      i = 0;
+
+  // Decode the xor diffs, bytes are loaded with a fixed size load while there are enough bytes after them
+  if (!is_bigendian()) {
+    const char *ip = input + ipos;
+    for (; i + DECODE_SAFE_TAIL <= nelements; i++) {
+      if (i % 2 == 0) {
+        flags = *(ip++);
+      }
 
-  for (int i = 0; i < nelements; i++) {
+      uint8_t  flag = flags & INT8MASK(4);
+      int      nbytes = (flag & INT8MASK(3)) + 1;
+      uint32_t diff;
+      flags >>= 4;
+
+      if (nbytes > FLOAT_BYTES) {  // only in corrupted data
+        ipos = (int)(ip - input);
+        ostream[opos++] = decodeFloatValue(input, &ipos, flag);
+        ip = input + ipos;
+        continue;
+      }
+      memcpy(&diff, ip, FLOAT_BYTES);
+      ip += nbytes;
+      ostream[opos++] = (diff & (uint32_t)byteMask[nbytes])
+                        << ((FLOAT_BYTES * BITS_PER_BYTE - nbytes * BITS_PER_BYTE) * (flag >> 3));
+    }
+    ipos = (int)(ip - input);
+  }
+
+  for (; i < nelements; i++) {
     if (i % 2 == 0) {
       flags = input[ipos++];
     }
@@ -914,19 +1315,12 @@ int tsDecompressFloatImp(const char *const input, const int nelements, char *con
     uint8_t flag = flags & INT8MASK(4);
     flags >>= 4;
 
-    uint32_t diff = decodeFloatValue(input, &ipos, flag);
-    union {
-      uint32_t bits;
-      float    real;
-    } curr;
-
-    uint32_t predicted = prev_value;
-    curr.bits = predicted ^ diff;
-    prev_value = curr.bits;
-
-    ostream[opos++] = curr.real;
+    ostream[opos++] = decodeFloatValue(input, &ipos, flag);
   }
 
+  // A value is the xor of the diffs up to it
+  tsDecodeKernels()->xor32(ostream, nelements, prev_value);
+
   return nelements * FLOAT_BYTES;
 }
 
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "os.h"
+#include "tsha256.h"
+
+static const uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+#define ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+#define CH(x, y, z) (((x) & (y)) ^ (~(x) & (z)))
+#define MAJ(x, y, z) (((x) & (y)) ^ ((x) & (z)) ^ ((y) & (z)))
+#define EP0(x) (ROTR(x, 2) ^ ROTR(x, 13) ^ ROTR(x, 22))
+#define EP1(x) (ROTR(x, 6) ^ ROTR(x, 11) ^ ROTR(x, 25))
+#define SIG0(x) (ROTR(x, 7) ^ ROTR(x, 18) ^ ((x) >> 3))
+#define SIG1(x) (ROTR(x, 17) ^ ROTR(x, 19) ^ ((x) >> 10))
+
+/* basic SHA-256 step, transforms state based on a 64-byte block */
+static void Transform(uint32_t *state, const uint8_t *in) {
+  uint32_t w[64];
+  for (int i = 0; i < 16; i++) {
+    w[i] = ((uint32_t)in[i * 4] << 24) | ((uint32_t)in[i * 4 + 1] << 16) | ((uint32_t)in[i * 4 + 2] << 8) |
+           (uint32_t)in[i * 4 + 3];
+  }
+  for (int i = 16; i < 64; i++) {
+    w[i] = SIG1(w[i - 2]) + w[i - 7] + SIG0(w[i - 15]) + w[i - 16];
+  }
+
+  uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+  uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+  for (int i = 0; i < 64; i++) {
+    uint32_t t1 = h + EP1(e) + CH(e, f, g) + K[i] + w[i];
+    uint32_t t2 = EP0(a) + MAJ(a, b, c);
+    h = g;
+    g = f;
+    f = e;
+    e = d + t1;
+    d = c;
+    c = b;
+    b = a;
+    a = t1 + t2;
+  }
+
+  state[0] += a;
+  state[1] += b;
+  state[2] += c;
+  state[3] += d;
+  state[4] += e;
+  state[5] += f;
+  state[6] += g;
+  state[7] += h;
+}
+
+void SHA256Init(SHA256_CTX *ctx) {
+  ctx->state[0] = 0x6a09e667;
+  ctx->state[1] = 0xbb67ae85;
+  ctx->state[2] = 0x3c6ef372;
+  ctx->state[3] = 0xa54ff53a;
+  ctx->state[4] = 0x510e527f;
+  ctx->state[5] = 0x9b05688c;
+  ctx->state[6] = 0x1f83d9ab;
+  ctx->state[7] = 0x5be0cd19;
+  ctx->count = 0;
+}
+
+void SHA256Update(SHA256_CTX *ctx, const uint8_t *inBuf, uint32_t inLen) {
+  uint32_t used = (uint32_t)(ctx->count % 64);
+  ctx->count += inLen;
+
+  if (used > 0) {
+    uint32_t n = MIN(64 - used, inLen);
+    memcpy(ctx->in + used, inBuf, n);
+    inBuf += n;
+    inLen -= n;
+    if (used + n < 64) return;
+    Transform(ctx->state, ctx->in);
+  }
+
+  for (; inLen >= 64; inBuf += 64, inLen -= 64) {
+    Transform(ctx->state, inBuf);
+  }
+  memcpy(ctx->in, inBuf, inLen);
+}
+
+void SHA256Final(SHA256_CTX *ctx) {
+  uint64_t bits = ctx->count * 8;
+  uint32_t used = (uint32_t)(ctx->count % 64);
+
+  /* pad with 0x80 and zeros to 56 mod 64 bytes, then the length in bits */
+  ctx->in[used++] = 0x80;
+  if (used > 56) {
+    memset(ctx->in + used, 0, 64 - used);
+    Transform(ctx->state, ctx->in);
+    used = 0;
+  }
+  memset(ctx->in + used, 0, 56 - used);
+  for (int i = 0; i < 8; i++) {
+    ctx->in[63 - i] = (uint8_t)(bits >> (i * 8));
+  }
+  Transform(ctx->state, ctx->in);
+
+  for (int i = 0; i < 8; i++) {
+    ctx->digest[i * 4] = (uint8_t)(ctx->state[i] >> 24);
+    ctx->digest[i * 4 + 1] = (uint8_t)(ctx->state[i] >> 16);
+    ctx->digest[i * 4 + 2] = (uint8_t)(ctx->state[i] >> 8);
+    ctx->digest[i * 4 + 3] = (uint8_t)ctx->state[i];
+  }
+}
@@ -28,9 +28,24 @@ static SSkipListIterator *doCreateSkipListIterator(SSkipList *pSkipList, int32_t
 static void tSkipListDoInsert(SSkipList *pSkipList, SSkipListNode **direction, SSkipListNode *pNode, bool isForward);
 static bool tSkipListGetPosToPut(SSkipList *pSkipList, SSkipListNode **backward, void *pData);
 static SSkipListNode *tSkipListNewNode(uint8_t level);
+static SSkipListNode *tSkipListNewDataNode(SSkipList *pSkipList, uint8_t level);
 #define tSkipListFreeNode(n) tfree((n))
+#define tSkipListFreeDataNode(s, n)  \
+  do {                               \
+    if ((s)->allocFn == NULL) {      \
+      tSkipListFreeNode(n);          \
+    }                                \
+  } while (0)
 static SSkipListNode *tSkipListPutImpl(SSkipList *pSkipList, void *pData, SSkipListNode **direction, bool isForward,
                                        bool hasDup);
+static SSkipListNode *tSkipListUpdateDupNode(SSkipList *pSkipList, SSkipListNode *pNode, void *pData);
+static SSkipListNode *tSkipListPutLockFree(SSkipList *pSkipList, void *pData, SSkipListNode **backward,
+                                           SSkipListNode **forward, bool isAppend);
+static bool           tSkipListFindLockFree(SSkipList *pSkipList, const char *pKey, SSkipListNode **backward,
+                                            SSkipListNode **forward);
+static SSkipListNode *getPrevNode(SSkipList *pSkipList, SSkipListNode *pNode);
+
+#define SL_LOAD_FORWARD(n, l) ((SSkipListNode *)atomic_load_ptr(&SL_NODE_GET_FORWARD_POINTER((n), (l))))
 
 
 static FORCE_INLINE int     tSkipListWLock(SSkipList *pSkipList);
@@ -52,6 +67,14 @@ SSkipList *tSkipListCreate(uint8_t maxLevel, uint8_t keyType, uint16_t keyLen, _
   pSkipList->len = keyLen;
   pSkipList->flags = flags;
   pSkipList->keyFn = fn;
+  if (SL_IS_LOCK_FREE(pSkipList)) {
+    if (SL_DUP_MODE(pSkipList) == SL_ALLOW_DUP_KEY) {
+      // the order among duplicated keys can not be kept identical on all levels without a lock
+      pSkipList->flags &= ~SL_LOCK_FREE;
+    } else {
+      pSkipList->flags &= ~SL_THREAD_SAFE;
+    }
+  }
   pSkipList->seed = rand();
   if (comparFn == NULL) {
     pSkipList->comparFn = getKeyComparFunc(keyType, TSDB_ORDER_ASC);
@@ -92,7 +115,9 @@ void tSkipListDestroy(SSkipList *pSkipList) {
 
   tSkipListWLock(pSkipList);
 
+  // nodes allocated from a pool are released together with the pool
   SSkipListNode *pNode = SL_NODE_GET_FORWARD_POINTER(pSkipList->pHead, 0);
+  if (pSkipList->allocFn != NULL) pNode = pSkipList->pTail;
 
   while (pNode != pSkipList->pTail) {
     SSkipListNode *pTemp = pNode;
@@ -116,6 +141,12 @@ void tSkipListDestroy(SSkipList *pSkipList) {
 SSkipListNode *tSkipListPut(SSkipList *pSkipList, void *pData) {
   if (pSkipList == NULL || pData == NULL) return NULL;
 
+  if (SL_IS_LOCK_FREE(pSkipList)) {
+    SSkipListNode *backward[MAX_SKIP_LIST_LEVEL] = {0};
+    SSkipListNode *forward[MAX_SKIP_LIST_LEVEL] = {0};
+    return tSkipListPutLockFree(pSkipList, pData, backward, forward, false);
+  }
+
   SSkipListNode *backward[MAX_SKIP_LIST_LEVEL] = {0};
   SSkipListNode *pNode = NULL;
 
@@ -136,10 +167,22 @@ void tSkipListPutBatchByIter(SSkipList *pSkipList, void *iter, iter_next_fn_t it
   char *         pKey = NULL;
   char *         pDataKey = NULL;
   int            compare = 0;
+  void *         pData = NULL;
+
+  if (SL_IS_LOCK_FREE(pSkipList)) {
+    // a row after the last node is linked behind it without a search, as in the locked version
+    bool isAppend = false;
+    while ((pData = iterate(iter)) != NULL) {
+      isAppend = isAppend && pSkipList->comparFn(pSkipList->keyFn(pData), SL_GET_MAX_KEY(pSkipList)) > 0;
+      tSkipListPutLockFree(pSkipList, pData, backward, forward, isAppend);
+      isAppend = (forward[0] == pSkipList->pTail);
+    }
+    return;
+  }
 
   tSkipListWLock(pSkipList);
 
-  void* pData = iterate(iter);
+  pData = iterate(iter);
   if(pData == NULL) return;
 
   // backward to put the first data
@@ -162,11 +205,14 @@ void tSkipListPutBatchByIter(SSkipList *pSkipList, void *iter, iter_next_fn_t it
       for (int i = 0; i < pSkipList->maxLevel; i++) {
         forward[i] = SL_NODE_GET_BACKWARD_POINTER(pSkipList->pTail, i);
       }
+      pSkipList->numOfAppends++;
     } else if(compare == 0) {
       // same need special deal
       forward[0] = SL_NODE_GET_BACKWARD_POINTER(SL_NODE_GET_BACKWARD_POINTER(pSkipList->pTail,0),0);
       hasDup = true;
+      pSkipList->numOfMerges++;
     } else {
+      pSkipList->numOfMerges++;
       SSkipListNode *p  = NULL;
       SSkipListNode *px = pSkipList->pHead;
       for (int i = pSkipList->maxLevel - 1; i >= 0; --i) {
@@ -216,6 +262,12 @@ void tSkipListPutBatchByIter(SSkipList *pSkipList, void *iter, iter_next_fn_t it
 uint32_t tSkipListRemove(SSkipList *pSkipList, SSkipListKey key) {
   uint32_t count = 0;
 
+  if (SL_IS_LOCK_FREE(pSkipList)) {
+    uError("skiplist %p is lock free, remove is not supported", pSkipList);
+    ASSERT(false);
+    return 0;
+  }
+
   tSkipListWLock(pSkipList);
 
   SSkipListNode *pNode = getPriorNode(pSkipList, key, TSDB_ORDER_ASC, NULL);
@@ -247,7 +299,7 @@ SArray *tSkipListGet(SSkipList *pSkipList, SSkipListKey key) {
 
   SSkipListNode *pNode = getPriorNode(pSkipList, key, TSDB_ORDER_ASC, NULL);
   while (1) {
-    SSkipListNode *p = SL_NODE_GET_FORWARD_POINTER(pNode, 0);
+    SSkipListNode *p = SL_LOAD_FORWARD(pNode, 0);
     if (p == pSkipList->pTail) {
       break;
     }
@@ -264,12 +316,24 @@ SArray *tSkipListGet(SSkipList *pSkipList, SSkipListKey key) {
 }
 
 void tSkipListRemoveNode(SSkipList *pSkipList, SSkipListNode *pNode) {
+  if (SL_IS_LOCK_FREE(pSkipList)) {
+    uError("skiplist %p is lock free, remove is not supported", pSkipList);
+    ASSERT(false);
+    return;
+  }
+
   tSkipListWLock(pSkipList);
   tSkipListRemoveNodeImpl(pSkipList, pNode);
   tSkipListCorrectLevel(pSkipList);
   tSkipListUnlock(pSkipList);
 }
 
+void tSkipListSetAllocator(SSkipList *pSkipList, sl_alloc_fn_t fn, void *param) {
+  ASSERT(pSkipList->size == 0);
+  pSkipList->allocFn = fn;
+  pSkipList->allocParam = param;
+}
+
 SSkipListIterator *tSkipListCreateIter(SSkipList *pSkipList) {
   if (pSkipList == NULL) return NULL;
 
@@ -309,14 +373,14 @@ bool tSkipListIterNext(SSkipListIterator *iter) {
       return false;
     }
 
-    iter->cur = SL_NODE_GET_FORWARD_POINTER(iter->cur, 0);
+    iter->cur = SL_LOAD_FORWARD(iter->cur, 0);
 
     // a new node is inserted into between iter->cur and iter->next, ignore it
     if (iter->cur != iter->next && (iter->next != NULL)) {
       iter->cur = iter->next;
     }
 
-    iter->next = SL_NODE_GET_FORWARD_POINTER(iter->cur, 0);
+    iter->next = SL_LOAD_FORWARD(iter->cur, 0);
     iter->step++;
   } else {
     if (iter->cur == pSkipList->pHead) {
@@ -325,14 +389,14 @@ bool tSkipListIterNext(SSkipListIterator *iter) {
       return false;
     }
 
-    iter->cur = SL_NODE_GET_BACKWARD_POINTER(iter->cur, 0);
+    iter->cur = getPrevNode(pSkipList, iter->cur);
 
     // a new node is inserted into between iter->cur and iter->next, ignore it
     if (iter->cur != iter->next && (iter->next != NULL)) {
       iter->cur = iter->next;
     }
 
-    iter->next = SL_NODE_GET_BACKWARD_POINTER(iter->cur, 0);
+    iter->next = getPrevNode(pSkipList, iter->cur);
     iter->step++;
   }
 
@@ -433,10 +497,10 @@ static SSkipListIterator *doCreateSkipListIterator(SSkipList *pSkipList, int32_t
   iter->order = order;
   if (order == TSDB_ORDER_ASC) {
     iter->cur = pSkipList->pHead;
-    iter->next = SL_NODE_GET_FORWARD_POINTER(iter->cur, 0);
+    iter->next = SL_LOAD_FORWARD(iter->cur, 0);
   } else {
     iter->cur = pSkipList->pTail;
-    iter->next = SL_NODE_GET_BACKWARD_POINTER(iter->cur, 0);
+    iter->next = getPrevNode(pSkipList, iter->cur);
   }
 
   return iter;
@@ -472,6 +536,7 @@ static bool tSkipListGetPosToPut(SSkipList *pSkipList, SSkipListNode **backward,
     for (int i = 0; i < pSkipList->maxLevel; i++) {
       backward[i] = pSkipList->pTail;
     }
+    pSkipList->numOfAppends++;
   } else {
     char *pKey = NULL;
 
@@ -483,9 +548,16 @@ static bool tSkipListGetPosToPut(SSkipList *pSkipList, SSkipListNode **backward,
         backward[i] = pSkipList->pTail;
       }
 
+      if (compare > 0) {
+        pSkipList->numOfAppends++;
+      } else {
+        pSkipList->numOfMerges++;
+      }
       return (compare == 0);
     }
 
+    pSkipList->numOfMerges++;
+
     // Compare min key
     pKey = SL_GET_MIN_KEY(pSkipList);
     compare = pSkipList->comparFn(pDataKey, pKey);
@@ -535,7 +607,7 @@ static void tSkipListRemoveNodeImpl(SSkipList *pSkipList, SSkipListNode *pNode)
     SL_NODE_GET_BACKWARD_POINTER(next, j) = prev;
   }
 
-  tSkipListFreeNode(pNode);
+  tSkipListFreeDataNode(pSkipList, pNode);
   pSkipList->size--;
 }
 
@@ -609,12 +681,12 @@ static SSkipListNode *getPriorNode(SSkipList *pSkipList, const char *val, int32_
   if (order == TSDB_ORDER_ASC) {
     pNode = pSkipList->pHead;
     for (int32_t i = pSkipList->level - 1; i >= 0; --i) {
-      SSkipListNode *p = SL_NODE_GET_FORWARD_POINTER(pNode, i);
+      SSkipListNode *p = SL_LOAD_FORWARD(pNode, i);
       while (p != pSkipList->pTail) {
         char *key = SL_GET_NODE_KEY(pSkipList, p);
         if (comparFn(key, val) < 0) {
           pNode = p;
-          p = SL_NODE_GET_FORWARD_POINTER(p, i);
+          p = SL_LOAD_FORWARD(p, i);
         } else {
           if (pCur != NULL) {
             *pCur = p;
@@ -623,6 +695,22 @@ static SSkipListNode *getPriorNode(SSkipList *pSkipList, const char *val, int32_
         }
       }
     }
+  } else if (SL_IS_LOCK_FREE(pSkipList)) {
+    // backward pointers are only hints in lock free mode, so search forward for the last node with key <= val
+    SSkipListNode *px = pSkipList->pHead;
+    SSkipListNode *p = pSkipList->pTail;
+    for (int32_t i = atomic_load_8(&pSkipList->level) - 1; i >= 0; --i) {
+      p = SL_LOAD_FORWARD(px, i);
+      while (p != pSkipList->pTail && comparFn(SL_GET_NODE_KEY(pSkipList, p), val) <= 0) {
+        px = p;
+        p = SL_LOAD_FORWARD(px, i);
+      }
+    }
+
+    pNode = p;
+    if (pCur != NULL && px != pSkipList->pHead) {
+      *pCur = px;
+    }
   } else {
     pNode = pSkipList->pTail;
     for (int32_t i = pSkipList->level - 1; i >= 0; --i) {
@@ -677,36 +765,34 @@ static SSkipListNode *tSkipListNewNode(uint8_t level) {
   return pNode;
 }
 
+static SSkipListNode *tSkipListNewDataNode(SSkipList *pSkipList, uint8_t level) {
+  if (pSkipList->allocFn == NULL) {
+    return tSkipListNewNode(level);
+  }
+
+  int32_t        tsize = sizeof(SSkipListNode) + sizeof(SSkipListNode *) * level * 2;
+  SSkipListNode *pNode = (SSkipListNode *)(*pSkipList->allocFn)(pSkipList->allocParam, tsize);
+  if (pNode == NULL) return NULL;
+
+  memset(pNode, 0, tsize);
+  pNode->level = level;
+  return pNode;
+}
+
 static SSkipListNode *tSkipListPutImpl(SSkipList *pSkipList, void *pData, SSkipListNode **direction, bool isForward,
                                        bool hasDup) {
   uint8_t        dupMode = SL_DUP_MODE(pSkipList);
   SSkipListNode *pNode = NULL;
 
   if (hasDup && (dupMode != SL_ALLOW_DUP_KEY)) {
-    if (dupMode == SL_UPDATE_DUP_KEY) {
-      if (isForward) {
-        pNode = SL_NODE_GET_FORWARD_POINTER(direction[0], 0);
-      } else {
-        pNode = SL_NODE_GET_BACKWARD_POINTER(direction[0], 0);
-      }
-      if (pSkipList->insertHandleFn) {
-        pSkipList->insertHandleFn->args[0] = pData;
-        pSkipList->insertHandleFn->args[1] = pNode->pData;
-        pData = genericInvoke(pSkipList->insertHandleFn);
-      }
-      if(pData) {
-        atomic_store_ptr(&(pNode->pData), pData);
-      }
+    if (isForward) {
+      pNode = SL_NODE_GET_FORWARD_POINTER(direction[0], 0);
     } else {
-      //for compatiblity, duplicate key inserted when update=0 should be also calculated as affected rows!
-      if(pSkipList->insertHandleFn) {
-        pSkipList->insertHandleFn->args[0] = NULL;
-        pSkipList->insertHandleFn->args[1] = NULL;
-        genericInvoke(pSkipList->insertHandleFn);
-      }
+      pNode = SL_NODE_GET_BACKWARD_POINTER(direction[0], 0);
     }
+    pNode = tSkipListUpdateDupNode(pSkipList, pNode, pData);
   } else {
-    pNode = tSkipListNewNode(getSkipListRandLevel(pSkipList));
+    pNode = tSkipListNewDataNode(pSkipList, getSkipListRandLevel(pSkipList));
     if (pNode != NULL) {
       // insertHandleFn will be assigned only for timeseries data,
       // in which case, pData is pointed to an memory to be freed later;
@@ -724,3 +810,107 @@ static SSkipListNode *tSkipListPutImpl(SSkipList *pSkipList, void *pData, SSkipL
 
   return pNode;
 }
+
+static SSkipListNode *tSkipListUpdateDupNode(SSkipList *pSkipList, SSkipListNode *pNode, void *pData) {
+  if (SL_DUP_MODE(pSkipList) == SL_UPDATE_DUP_KEY) {
+    if (pSkipList->insertHandleFn) {
+      pSkipList->insertHandleFn->args[0] = pData;
+      pSkipList->insertHandleFn->args[1] = pNode->pData;
+      pData = genericInvoke(pSkipList->insertHandleFn);
+    }
+    if(pData) {
+      atomic_store_ptr(&(pNode->pData), pData);
+    }
+    return pNode;
+  }
+
+  //for compatiblity, duplicate key inserted when update=0 should be also calculated as affected rows!
+  if(pSkipList->insertHandleFn) {
+    pSkipList->insertHandleFn->args[0] = NULL;
+    pSkipList->insertHandleFn->args[1] = NULL;
+    genericInvoke(pSkipList->insertHandleFn);
+  }
+  return NULL;
+}
+
+// In lock free mode the backward pointer at level 0 is only a hint. Since nodes are never unlinked, the hint is
+// always before pNode, so walk forward from it until the real predecessor is found.
+static SSkipListNode *getPrevNode(SSkipList *pSkipList, SSkipListNode *pNode) {
+  if (!SL_IS_LOCK_FREE(pSkipList) || pNode == pSkipList->pHead) {
+    return SL_NODE_GET_BACKWARD_POINTER(pNode, 0);
+  }
+
+  SSkipListNode *p = (SSkipListNode *)atomic_load_ptr(&SL_NODE_GET_BACKWARD_POINTER(pNode, 0));
+  while (true) {
+    SSkipListNode *next = SL_LOAD_FORWARD(p, 0);
+    if (next == pNode) break;
+    p = next;
+  }
+
+  return p;
+}
+
+// find the last node with key less than pKey (backward) and its successor (forward) on each level
+static bool tSkipListFindLockFree(SSkipList *pSkipList, const char *pKey, SSkipListNode **backward,
+                                  SSkipListNode **forward) {
+  SSkipListNode *px = pSkipList->pHead;
+  for (int32_t i = pSkipList->maxLevel - 1; i >= 0; --i) {
+    SSkipListNode *p = SL_LOAD_FORWARD(px, i);
+    while (p != pSkipList->pTail && pSkipList->comparFn(SL_GET_NODE_KEY(pSkipList, p), pKey) < 0) {
+      px = p;
+      p = SL_LOAD_FORWARD(px, i);
+    }
+
+    backward[i] = px;
+    forward[i] = p;
+  }
+
+  return (forward[0] != pSkipList->pTail) && (pSkipList->comparFn(SL_GET_NODE_KEY(pSkipList, forward[0]), pKey) == 0);
+}
+
+/*
+ * Put a node by the single writer of a lock free skip list. The node is published to the readers by the store to the
+ * forward pointer of its predecessor on level 0, the upper levels only accelerate the search. backward and forward
+ * hold the position of the node on each level. If isAppend is true, they are already the position after the last
+ * node from the previous put, and the search is skipped. On return, they are the position right after the node.
+ */
+static SSkipListNode *tSkipListPutLockFree(SSkipList *pSkipList, void *pData, SSkipListNode **backward,
+                                           SSkipListNode **forward, bool isAppend) {
+  if (!isAppend && tSkipListFindLockFree(pSkipList, pSkipList->keyFn(pData), backward, forward)) {
+    pSkipList->numOfMerges++;
+    return tSkipListUpdateDupNode(pSkipList, forward[0], pData);
+  }
+
+  SSkipListNode *pNode = tSkipListNewDataNode(pSkipList, getSkipListRandLevel(pSkipList));
+  if (pNode == NULL) return NULL;
+
+  pNode->pData = pData;
+  if (pSkipList->insertHandleFn) {
+    pSkipList->insertHandleFn->args[0] = pData;
+    pSkipList->insertHandleFn->args[1] = NULL;
+    pNode->pData = genericInvoke(pSkipList->insertHandleFn);
+  }
+
+  for (int32_t i = 0; i < pNode->level; ++i) {
+    SL_NODE_GET_FORWARD_POINTER(pNode, i) = forward[i];
+  }
+  SL_NODE_GET_BACKWARD_POINTER(pNode, 0) = backward[0];
+
+  for (int32_t i = 0; i < pNode->level; ++i) {
+    atomic_store_ptr(&SL_NODE_GET_FORWARD_POINTER(backward[i], i), pNode);
+    backward[i] = pNode;
+  }
+  atomic_store_ptr(&SL_NODE_GET_BACKWARD_POINTER(forward[0], 0), pNode);
+
+  if (pSkipList->level < pNode->level) {
+    atomic_store_8(&pSkipList->level, pNode->level);
+  }
+  atomic_add_fetch_32(&pSkipList->size, 1);
+  if (forward[0] == pSkipList->pTail) {
+    pSkipList->numOfAppends++;
+  } else {
+    pSkipList->numOfMerges++;
+  }
+
+  return pNode;
+}
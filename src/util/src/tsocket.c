@@ -13,6 +13,9 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE  // splice
+#endif
 #include "os.h"
 #include "tulog.h"
 #include "tsocket.h"
@@ -502,13 +505,61 @@ void tinet_ntoa(char *ipstr, uint32_t ip) {
 }
 
 #define COPY_SIZE 32768
-// sendfile shall be used
+
+#if defined(_TD_LINUX_64) || defined(_TD_LINUX_32) || defined(_TD_ARM_64) || defined(_TD_ARM_32) || defined(_TD_MIPS_64)
+// Move the data from the socket to the file through a pipe, the data is not copied to the user space. Return -2 if
+// splice is not supported for the fds before any data is moved, so the caller can copy them in the user space.
+static int64_t taosSpliceFds(SOCKET sfd, int32_t dfd, int64_t len) {
+  int32_t pipeFds[2];
+  int64_t leftLen = len;
+
+  if (pipe(pipeFds) < 0) return -2;
+
+  while (leftLen > 0) {
+    size_t  tlen = (size_t)MIN(leftLen, COPY_SIZE * 8);
+    ssize_t inLen = splice(sfd, NULL, pipeFds[1], NULL, tlen, SPLICE_F_MOVE | SPLICE_F_MORE);
+    if (inLen < 0 && errno == EINTR) continue;
+    if (inLen < 0 && errno == EINVAL && leftLen == len) {
+      close(pipeFds[0]);
+      close(pipeFds[1]);
+      return -2;
+    }
+    if (inLen <= 0) {
+      uError("splice error, len:%" PRId64 " leftLen:%" PRId64 ", reason:%s", len, leftLen,
+             (inLen == 0) ? "socket closed" : strerror(errno));
+      break;
+    }
+
+    while (inLen > 0) {
+      ssize_t outLen = splice(pipeFds[0], NULL, dfd, NULL, (size_t)inLen, SPLICE_F_MOVE | SPLICE_F_MORE);
+      if (outLen < 0 && errno == EINTR) continue;
+      if (outLen <= 0) {
+        uError("splice error, len:%" PRId64 " leftLen:%" PRId64 ", reason:%s", len, leftLen, strerror(errno));
+        close(pipeFds[0]);
+        close(pipeFds[1]);
+        return -1;
+      }
+      inLen -= outLen;
+      leftLen -= outLen;
+    }
+  }
+
+  close(pipeFds[0]);
+  close(pipeFds[1]);
+  return (leftLen == 0) ? len : -1;
+}
+#endif
 
 int64_t taosCopyFds(SOCKET sfd, int32_t dfd, int64_t len) {
   int64_t leftLen;
   int64_t readLen, writeLen;
   char    temp[COPY_SIZE];
 
+#if defined(_TD_LINUX_64) || defined(_TD_LINUX_32) || defined(_TD_ARM_64) || defined(_TD_ARM_32) || defined(_TD_MIPS_64)
+  int64_t ret = taosSpliceFds(sfd, dfd, len);
+  if (ret != -2) return ret;
+#endif
+
   leftLen = len;
 
   while (leftLen > 0) {
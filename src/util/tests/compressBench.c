@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Benchmark of the decoders of tscompression.h. For each data type and distribution, a block of rows is encoded once
+// and decoded repeatedly with every SIMD level the CPU supports, the decoded bytes per second are reported.
+//
+// usage: compressBench [rows per block] [seconds per case]
+
+#include "os.h"
+#include "tbench.h"
+#include "tscompression.h"
+
+typedef struct {
+  const char *type;
+  const char *distribution;
+  int         bytes;
+  void (*generate)(void *data, int n);
+  int (*compress)(const char *const input, const int nelements, char *const output);
+  int (*decompress)(const char *const input, const int nelements, char *const output);
+} SBenchCase;
+
+static void genTsRegular(void *data, int n) {
+  for (int i = 0; i < n; i++) ((int64_t *)data)[i] = 1600000000000L + i * 1000L;
+}
+
+static void genTsJitter(void *data, int n) {
+  for (int i = 0; i < n; i++) ((int64_t *)data)[i] = 1600000000000L + i * 1000L + (int64_t)(benchRand() % 100);
+}
+
+static void genTsSparse(void *data, int n) {
+  int64_t ts = 1600000000000L;
+  for (int i = 0; i < n; i++) {
+    ts += 1 + (int64_t)(benchRand() % 86400000);
+    ((int64_t *)data)[i] = ts;
+  }
+}
+
+static void genBigintSmall(void *data, int n) {
+  for (int i = 0; i < n; i++) ((int64_t *)data)[i] = (int64_t)(benchRand() % 16);
+}
+
+static void genBigintRandom(void *data, int n) {
+  for (int i = 0; i < n; i++) ((int64_t *)data)[i] = (int64_t)(benchRand() % 1000000000000L);
+}
+
+static void genIntConstant(void *data, int n) {
+  for (int i = 0; i < n; i++) ((int32_t *)data)[i] = 42;
+}
+
+static void genIntSmall(void *data, int n) {
+  for (int i = 0; i < n; i++) ((int32_t *)data)[i] = 1000 + (int32_t)(benchRand() % 16);
+}
+
+static void genIntRandom(void *data, int n) {
+  for (int i = 0; i < n; i++) ((int32_t *)data)[i] = (int32_t)benchRand();
+}
+
+static void genBoolRandom(void *data, int n) {
+  for (int i = 0; i < n; i++) ((int8_t *)data)[i] = (int8_t)(benchRand() % 2);
+}
+
+static void genBoolNull(void *data, int n) {
+  for (int i = 0; i < n; i++) {
+    int r = (int)(benchRand() % 3);
+    ((int8_t *)data)[i] = (r == 2) ? TSDB_DATA_BOOL_NULL : (int8_t)r;
+  }
+}
+
+static void genFloatSmooth(void *data, int n) {
+  for (int i = 0; i < n; i++) ((float *)data)[i] = (float)(20.0 + sin(i / 100.0));
+}
+
+static void genFloatRandom(void *data, int n) {
+  for (int i = 0; i < n; i++) ((float *)data)[i] = (float)(benchRand() % 1000000) / 7.0f;
+}
+
+static void genDoubleSmooth(void *data, int n) {
+  for (int i = 0; i < n; i++) ((double *)data)[i] = 20.0 + sin(i / 100.0);
+}
+
+static void genDoubleRepeat(void *data, int n) {
+  for (int i = 0; i < n; i++) ((double *)data)[i] = (double)(i / 64);
+}
+
+static void genDoubleRandom(void *data, int n) {
+  for (int i = 0; i < n; i++) ((double *)data)[i] = (double)benchRand() / 3.0;
+}
+
+static int compressBigint(const char *const input, const int nelements, char *const output) {
+  return tsCompressINTImp(input, nelements, output, TSDB_DATA_TYPE_BIGINT);
+}
+
+static int decompressBigint(const char *const input, const int nelements, char *const output) {
+  return tsDecompressINTImp(input, nelements, output, TSDB_DATA_TYPE_BIGINT);
+}
+
+static int compressInt(const char *const input, const int nelements, char *const output) {
+  return tsCompressINTImp(input, nelements, output, TSDB_DATA_TYPE_INT);
+}
+
+static int decompressInt(const char *const input, const int nelements, char *const output) {
+  return tsDecompressINTImp(input, nelements, output, TSDB_DATA_TYPE_INT);
+}
+
+static SBenchCase benchCases[] = {
+    {"timestamp", "regular", 8, genTsRegular, tsCompressTimestampImp, tsDecompressTimestampImp},
+    {"timestamp", "jitter", 8, genTsJitter, tsCompressTimestampImp, tsDecompressTimestampImp},
+    {"timestamp", "sparse", 8, genTsSparse, tsCompressTimestampImp, tsDecompressTimestampImp},
+    {"bigint", "small", 8, genBigintSmall, compressBigint, decompressBigint},
+    {"bigint", "random", 8, genBigintRandom, compressBigint, decompressBigint},
+    {"int", "constant", 4, genIntConstant, compressInt, decompressInt},
+    {"int", "small", 4, genIntSmall, compressInt, decompressInt},
+    {"int", "random", 4, genIntRandom, compressInt, decompressInt},
+    {"bool", "random", 1, genBoolRandom, tsCompressBoolImp, tsDecompressBoolImp},
+    {"bool", "null", 1, genBoolNull, tsCompressBoolImp, tsDecompressBoolImp},
+    {"float", "smooth", 4, genFloatSmooth, tsCompressFloatImp, tsDecompressFloatImp},
+    {"float", "random", 4, genFloatRandom, tsCompressFloatImp, tsDecompressFloatImp},
+    {"double", "smooth", 8, genDoubleSmooth, tsCompressDoubleImp, tsDecompressDoubleImp},
+    {"double", "repeat", 8, genDoubleRepeat, tsCompressDoubleImp, tsDecompressDoubleImp},
+    {"double", "random", 8, genDoubleRandom, tsCompressDoubleImp, tsDecompressDoubleImp},
+};
+
+typedef struct {
+  SBenchCase *pCase;
+  int         rows;
+  char *      encoded;
+  char *      decoded;
+} SBenchDecode;
+
+static const char *levelNames[] = {"scalar", "sse4", "avx2"};
+
+static void benchDecode(void *param) {
+  SBenchDecode *p = param;
+  p->pCase->decompress(p->encoded, p->rows, p->decoded);
+}
+
+int main(int argc, char *argv[]) {
+  SBenchArgs args;
+  if (benchParseArgs(argc, argv, &args) != 0) {
+    return 1;
+  }
+  int rows = args.rows;
+
+  char *data = malloc((size_t)rows * LONG_BYTES);
+  char *encoded = malloc((size_t)rows * LONG_BYTES + 64);
+  char *decoded = malloc((size_t)rows * LONG_BYTES);
+  if (data == NULL || encoded == NULL || decoded == NULL) {
+    printf("failed to allocate buffers for %d rows\n", rows);
+    return 1;
+  }
+
+  int maxLevel = tsSetCompressSimdLevel(COMP_SIMD_AVX2);
+  printf("%-10s %-10s %8s %8s", "type", "data", "rows", "ratio");
+  benchPrintLevels(levelNames, COMP_SIMD_NONE, maxLevel, "GB/s");
+
+  for (int c = 0; c < tListLen(benchCases); c++) {
+    SBenchCase *pCase = &benchCases[c];
+    int         size = rows * pCase->bytes;
+
+    pCase->generate(data, rows);
+    int len = pCase->compress(data, rows, encoded);
+    printf("%-10s %-10s %8d %8.2f", pCase->type, pCase->distribution, rows, (double)size / len);
+
+    for (int level = COMP_SIMD_NONE; level <= maxLevel; level++) {
+      SBenchDecode decode = {pCase, rows, encoded, decoded};
+
+      tsSetCompressSimdLevel(level);
+      double rate = benchLoop(benchDecode, &decode, args.seconds);
+
+      if (memcmp(data, decoded, size) != 0) {
+        printf("\n%s %s is not decoded correctly with %s\n", pCase->type, pCase->distribution, levelNames[level]);
+        return 1;
+      }
+      printf(" %15.2f", size * rate / 1000.0);
+    }
+    printf("\n");
+  }
+
+  free(data);
+  free(encoded);
+  free(decoded);
+  return 0;
+}
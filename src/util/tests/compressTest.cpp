@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+#include <math.h>
+#include <stdlib.h>
+#include <random>
+#include <vector>
+
+#include "tscompression.h"
+
+namespace {
+const int numOfElems[] = {1, 2, 3, 17, 18, 19, 255, 256, 257, 1000, 4096};
+
+// decode the encoded data with all the SIMD levels of the CPU and compare with the original data
+template <typename T>
+void checkDecode(const std::vector<T> &data, int (*compress)(const char *const, const int, char *const),
+                 int (*decompress)(const char *const, const int, char *const)) {
+  int               n = (int)data.size();
+  std::vector<char> encoded(n * sizeof(T) + 64);
+  compress((const char *)data.data(), n, encoded.data());
+
+  int maxLevel = tsSetCompressSimdLevel(COMP_SIMD_AVX2);
+  for (int level = COMP_SIMD_NONE; level <= maxLevel; level++) {
+    ASSERT_EQ(tsSetCompressSimdLevel(level), level);
+
+    std::vector<T> decoded(n);
+    ASSERT_EQ(decompress(encoded.data(), n, (char *)decoded.data()), (int)(n * sizeof(T)));
+    ASSERT_EQ(memcmp(decoded.data(), data.data(), n * sizeof(T)), 0) << "level:" << level << " n:" << n;
+  }
+  tsSetCompressSimdLevel(maxLevel);
+}
+
+template <typename T>
+void checkDecodeINT(const std::vector<T> &data, char type) {
+  int               n = (int)data.size();
+  std::vector<char> encoded(n * sizeof(T) + 64);
+  tsCompressINTImp((const char *)data.data(), n, encoded.data(), type);
+
+  int maxLevel = tsSetCompressSimdLevel(COMP_SIMD_AVX2);
+  for (int level = COMP_SIMD_NONE; level <= maxLevel; level++) {
+    ASSERT_EQ(tsSetCompressSimdLevel(level), level);
+
+    std::vector<T> decoded(n);
+    ASSERT_EQ(tsDecompressINTImp(encoded.data(), n, (char *)decoded.data(), type), (int)(n * sizeof(T)));
+    ASSERT_EQ(memcmp(decoded.data(), data.data(), n * sizeof(T)), 0) << "level:" << level << " n:" << n;
+  }
+  tsSetCompressSimdLevel(maxLevel);
+}
+}  // namespace
+
+TEST(testCase, compress_timestamp_test) {
+  std::mt19937_64 gen(12345);
+  for (int n : numOfElems) {
+    std::vector<int64_t> regular(n), jitter(n), random(n);
+    for (int i = 0; i < n; i++) {
+      regular[i] = 1600000000000L + i * 1000L;
+      jitter[i] = 1600000000000L + i * 1000L + (int64_t)(gen() % 50);
+      random[i] = (int64_t)(gen() % 1000000000000000L);
+    }
+    checkDecode(regular, tsCompressTimestampImp, tsDecompressTimestampImp);
+    checkDecode(jitter, tsCompressTimestampImp, tsDecompressTimestampImp);
+    checkDecode(random, tsCompressTimestampImp, tsDecompressTimestampImp);
+  }
+}
+
+TEST(testCase, compress_integer_test) {
+  std::mt19937_64 gen(12345);
+  for (int n : numOfElems) {
+    std::vector<int64_t> bigints(n), constants(n, 7);
+    std::vector<int32_t> ints(n);
+    std::vector<int16_t> smallints(n);
+    std::vector<int8_t>  tinyints(n);
+    for (int i = 0; i < n; i++) {
+      bigints[i] = (int64_t)(gen() % 100000000L) - 50000000L;
+      ints[i] = (i % 100 < 50) ? (int32_t)(gen() % 16) : (int32_t)gen();
+      smallints[i] = (int16_t)(gen() % 2000 - 1000);
+      tinyints[i] = (int8_t)(gen() % 200 - 100);
+    }
+    checkDecodeINT(bigints, TSDB_DATA_TYPE_BIGINT);
+    checkDecodeINT(constants, TSDB_DATA_TYPE_BIGINT);
+    checkDecodeINT(ints, TSDB_DATA_TYPE_INT);
+    checkDecodeINT(smallints, TSDB_DATA_TYPE_SMALLINT);
+    checkDecodeINT(tinyints, TSDB_DATA_TYPE_TINYINT);
+  }
+}
+
+TEST(testCase, compress_bool_test) {
+  std::mt19937_64 gen(12345);
+  for (int n : numOfElems) {
+    std::vector<int8_t> bools(n);
+    for (int i = 0; i < n; i++) {
+      int r = (int)(gen() % 3);
+      bools[i] = (r == 2) ? TSDB_DATA_BOOL_NULL : (int8_t)r;
+    }
+    checkDecode(bools, tsCompressBoolImp, tsDecompressBoolImp);
+  }
+}
+
+TEST(testCase, compress_float_test) {
+  std::mt19937_64 gen(12345);
+  for (int n : numOfElems) {
+    std::vector<double> smoothd(n), randomd(n);
+    std::vector<float>  smoothf(n), randomf(n);
+    for (int i = 0; i < n; i++) {
+      smoothd[i] = 20.0 + sin(i / 100.0);
+      randomd[i] = (double)gen() / 3.0;
+      smoothf[i] = (float)(20.0 + sin(i / 100.0));
+      randomf[i] = (float)(gen() % 1000000) / 7.0f;
+    }
+    checkDecode(smoothd, tsCompressDoubleImp, tsDecompressDoubleImp);
+    checkDecode(randomd, tsCompressDoubleImp, tsDecompressDoubleImp);
+    checkDecode(smoothf, tsCompressFloatImp, tsDecompressFloatImp);
+    checkDecode(randomf, tsCompressFloatImp, tsDecompressFloatImp);
+  }
+}
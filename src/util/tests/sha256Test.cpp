@@ -0,0 +1,36 @@
+#include <gtest/gtest.h>
+#include <string>
+
+#include "tsha256.h"
+
+namespace {
+
+std::string sha256Hex(const std::string& s, uint32_t step) {
+  SHA256_CTX ctx;
+  SHA256Init(&ctx);
+  for (size_t i = 0; i < s.size(); i += step) {
+    SHA256Update(&ctx, (const uint8_t*)s.data() + i, (uint32_t)std::min<size_t>(step, s.size() - i));
+  }
+  SHA256Final(&ctx);
+
+  char buf[SHA256_DIGEST_SIZE * 2 + 1] = {0};
+  for (int i = 0; i < SHA256_DIGEST_SIZE; i++) {
+    sprintf(buf + i * 2, "%02x", ctx.digest[i]);
+  }
+  return buf;
+}
+
+}  // namespace
+
+// the vectors of FIPS 180-4, fed at once and in pieces across the 64-byte blocks
+TEST(testCase, sha256_test) {
+  const std::string abc56 = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+
+  for (uint32_t step : {1u, 3u, 63u, 64u, 1000u}) {
+    EXPECT_EQ(sha256Hex("", step), "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    EXPECT_EQ(sha256Hex("abc", step), "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    EXPECT_EQ(sha256Hex(abc56, step), "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+    EXPECT_EQ(sha256Hex(std::string(1000000, 'a'), step * 64),
+              "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+  }
+}
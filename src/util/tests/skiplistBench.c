@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Benchmark of the rwlock skip list against the lock free one of the memtable. A single writer puts the keys in
+// batches, like the write thread of a vnode, while the readers scan the list like queries on the memtable. The put
+// rate of the writer and the scan rate of all readers are reported.
+//
+// usage: skiplistBench [keys] [max readers]
+
+#include "os.h"
+#include "tbench.h"
+#include "tcompare.h"
+#include "tskiplist.h"
+
+typedef struct {
+  int64_t *keys;
+  int32_t  start;
+  int32_t  num;
+} SBenchBatch;
+
+typedef struct {
+  SSkipList *      pSkipList;
+  volatile int32_t stop;
+  int64_t          rows;
+} SBenchReader;
+
+static char *getInt64Key(const void *data) { return (char *)data; }
+
+static int compareInt64(const void *p1, const void *p2) {
+  int64_t k1 = *(const int64_t *)p1;
+  int64_t k2 = *(const int64_t *)p2;
+  return (k1 < k2) ? -1 : (k1 > k2);
+}
+
+static void *nextBatchKey(void *iter) {
+  SBenchBatch *p = iter;
+  return (p->start < p->num) ? &p->keys[p->start++] : NULL;
+}
+
+static void *scanWhilePut(void *param) {
+  SBenchReader *p = param;
+  while (!p->stop) {
+    SSkipListIterator *pIter = tSkipListCreateIter(p->pSkipList);
+    while (tSkipListIterNext(pIter)) p->rows++;
+    tSkipListDestroyIter(pIter);
+  }
+  return NULL;
+}
+
+static void runBench(uint8_t flags, const char *name, int64_t *keys, int32_t numOfKeys, int32_t numOfReaders) {
+  SSkipList *pSkipList = tSkipListCreate(MAX_SKIP_LIST_LEVEL, TSDB_DATA_TYPE_BIGINT, sizeof(int64_t),
+                                         getKeyComparFunc(TSDB_DATA_TYPE_BIGINT, TSDB_ORDER_ASC),
+                                         flags | SL_DISCARD_DUP_KEY, getInt64Key);
+
+  pthread_t    threads[64];
+  SBenchReader readers[64] = {{0}};
+  for (int32_t i = 0; i < numOfReaders; i++) {
+    readers[i].pSkipList = pSkipList;
+    pthread_create(&threads[i], NULL, scanWhilePut, &readers[i]);
+  }
+
+  int64_t     start = taosGetTimestampUs();
+  SBenchBatch batch = {keys, 0, 0};
+  for (int32_t i = 0; i < numOfKeys; i += 1000) {
+    batch.start = i;
+    batch.num = MIN(i + 1000, numOfKeys);
+    tSkipListPutBatchByIter(pSkipList, &batch, nextBatchKey);
+  }
+  int64_t elapsed = taosGetTimestampUs() - start;
+
+  int64_t rows = 0;
+  for (int32_t i = 0; i < numOfReaders; i++) {
+    readers[i].stop = 1;
+    pthread_join(threads[i], NULL);
+    rows += readers[i].rows;
+  }
+  int64_t scanElapsed = taosGetTimestampUs() - start;
+
+  printf("%-10s %8d %8u %14.2f %14.2f\n", name, numOfReaders, SL_SIZE(pSkipList), (double)numOfKeys / elapsed,
+         (double)rows / scanElapsed);
+  tSkipListDestroy(pSkipList);
+}
+
+int main(int argc, char *argv[]) {
+  int32_t numOfKeys = (argc > 1) ? atoi(argv[1]) : 400000;
+  int32_t maxReaders = (argc > 2) ? atoi(argv[2]) : 8;
+  if (numOfKeys <= 0 || maxReaders < 0 || maxReaders > 64) {
+    printf("usage: %s [keys] [max readers]\n", argv[0]);
+    return 1;
+  }
+
+  int64_t *keys = malloc(sizeof(int64_t) * numOfKeys);
+  if (keys == NULL) {
+    printf("failed to allocate %d keys\n", numOfKeys);
+    return 1;
+  }
+
+  // mostly appended with a tenth of the keys before the last one, the rows of a submit block are sorted as in
+  // the memtable
+  for (int32_t i = 0; i < numOfKeys; i++) {
+    keys[i] = (benchRand() % 10 == 0) ? (int64_t)(benchRand() % numOfKeys) * 2 + 1 : (int64_t)i * 2;
+  }
+  for (int32_t i = 0; i < numOfKeys; i += 1000) {
+    qsort(keys + i, MIN(1000, numOfKeys - i), sizeof(int64_t), compareInt64);
+  }
+
+  printf("%-10s %8s %8s %14s %14s\n", "mode", "readers", "keys", "put Mrows/s", "scan Mrows/s");
+  for (int32_t numOfReaders = 0; numOfReaders <= maxReaders; numOfReaders = MAX(numOfReaders * 2, 1)) {
+    runBench(SL_THREAD_SAFE, "rwlock", keys, numOfKeys, numOfReaders);
+    runBench(SL_LOCK_FREE, "lock-free", keys, numOfKeys, numOfReaders);
+  }
+
+  free(keys);
+  return 0;
+}
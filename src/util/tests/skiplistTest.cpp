@@ -377,4 +377,175 @@ TEST(testCase, skiplist_test) {
       free(pKeys);*/
 }
 
-#endif
\ No newline at end of file
+#endif
+namespace {
+
+char* getInt64Key(const void* data) { return (char*)(data); }
+
+typedef struct {
+  SSkipList* pSkipList;
+  int64_t*   keys;
+  int32_t    start;
+  int32_t    num;
+} SSkipListBatch;
+
+void* skipListBatchNext(void* iter) {
+  SSkipListBatch* p = (SSkipListBatch*)iter;
+  return (p->start < p->num) ? &p->keys[p->start++] : NULL;
+}
+
+typedef struct {
+  SSkipList*       pSkipList;
+  volatile int32_t stop;
+  int64_t          scans;
+  bool             ordered;
+} SSkipListReader;
+
+// keys must come out in order in both directions while the writer is putting nodes
+void* skipListReadWhilePut(void* param) {
+  SSkipListReader* p = (SSkipListReader*)param;
+  while (!p->stop) {
+    int64_t            prev = -1;
+    SSkipListIterator* pIter = tSkipListCreateIter(p->pSkipList);
+    while (tSkipListIterNext(pIter)) {
+      int64_t key = *(int64_t*)SL_GET_NODE_DATA(tSkipListIterGet(pIter));
+      if (key <= prev) p->ordered = false;
+      prev = key;
+    }
+    tSkipListDestroyIter(pIter);
+
+    int64_t start = INT64_MAX;
+    prev = INT64_MAX;
+    pIter = tSkipListCreateIterFromVal(p->pSkipList, (const char*)&start, TSDB_DATA_TYPE_BIGINT, TSDB_ORDER_DESC);
+    while (tSkipListIterNext(pIter)) {
+      int64_t key = *(int64_t*)SL_GET_NODE_DATA(tSkipListIterGet(pIter));
+      if (key >= prev) p->ordered = false;
+      prev = key;
+    }
+    tSkipListDestroyIter(pIter);
+    p->scans++;
+  }
+  return NULL;
+}
+
+}  // namespace
+
+// one writer puts in-order batches, out of order batches and single keys while readers scan without a lock
+TEST(testCase, skiplist_lock_free_readers) {
+  const int32_t numOfKeys = 20000;
+  const int32_t numOfReaders = 4;
+  int64_t*      keys = (int64_t*)malloc(sizeof(int64_t) * numOfKeys * 2);
+
+  SSkipList* pSkipList = tSkipListCreate(MAX_SKIP_LIST_LEVEL, TSDB_DATA_TYPE_BIGINT, sizeof(int64_t),
+                                         getKeyComparFunc(TSDB_DATA_TYPE_BIGINT, TSDB_ORDER_ASC),
+                                         SL_LOCK_FREE | SL_DISCARD_DUP_KEY, getInt64Key);
+  ASSERT_TRUE(pSkipList != NULL);
+  ASSERT_TRUE(SL_IS_LOCK_FREE(pSkipList));
+
+  pthread_t       threads[numOfReaders];
+  SSkipListReader readers[numOfReaders];
+  for (int32_t i = 0; i < numOfReaders; ++i) {
+    readers[i].pSkipList = pSkipList;
+    readers[i].stop = 0;
+    readers[i].scans = 0;
+    readers[i].ordered = true;
+    pthread_create(&threads[i], NULL, skipListReadWhilePut, &readers[i]);
+  }
+
+  // the even keys are appended, the odd ones go in between, every tenth key is put twice
+  int32_t n = 0;
+  for (int32_t i = 0; i < numOfKeys; i += 2) keys[n++] = i;
+  for (int32_t i = 1; i < numOfKeys; i += 2) {
+    keys[n++] = i;
+    if (i % 10 == 1) keys[n++] = i;
+  }
+
+  const int32_t  batchSize = 500;
+  SSkipListBatch batch = {pSkipList, keys, 0, 0};
+  for (int32_t i = 0; i < n; i += batchSize) {
+    batch.start = i;
+    batch.num = std::min(i + batchSize, n);
+    tSkipListPutBatchByIter(pSkipList, &batch, skipListBatchNext);
+  }
+
+  for (int32_t i = 0; i < numOfKeys; i += 7) {
+    ASSERT_TRUE(tSkipListPut(pSkipList, &keys[i]) == NULL);
+  }
+
+  for (int32_t i = 0; i < numOfReaders; ++i) {
+    readers[i].stop = 1;
+    pthread_join(threads[i], NULL);
+    ASSERT_TRUE(readers[i].ordered);
+    ASSERT_GT(readers[i].scans, 0);
+  }
+
+  ASSERT_EQ(SL_SIZE(pSkipList), (uint32_t)numOfKeys);
+  ASSERT_GE(pSkipList->numOfAppends, (uint32_t)numOfKeys / 2);
+
+  int64_t            prev = -1;
+  SSkipListIterator* pIter = tSkipListCreateIter(pSkipList);
+  while (tSkipListIterNext(pIter)) {
+    int64_t key = *(int64_t*)SL_GET_NODE_DATA(tSkipListIterGet(pIter));
+    ASSERT_EQ(key, prev + 1);
+    prev = key;
+  }
+  tSkipListDestroyIter(pIter);
+  ASSERT_EQ(prev, numOfKeys - 1);
+
+  tSkipListDestroy(pSkipList);
+  free(keys);
+}
+
+namespace {
+
+typedef struct {
+  char*   buf;
+  int32_t offset;
+  int32_t numOfAllocs;
+} SSkipListTestPool;
+
+void* skipListTestAlloc(void* param, int32_t size) {
+  SSkipListTestPool* pPool = (SSkipListTestPool*)param;
+  void*              ptr = pPool->buf + pPool->offset;
+  pPool->offset += ALIGN8(size);
+  pPool->numOfAllocs++;
+  return ptr;
+}
+
+}  // namespace
+
+TEST(testCase, skiplist_allocator_test) {
+  const int32_t     numOfKeys = 10000;
+  SSkipListTestPool pool = {0};
+  int64_t*          keys = (int64_t*)malloc(sizeof(int64_t) * numOfKeys);
+
+  pool.buf = (char*)malloc(numOfKeys * (sizeof(SSkipListNode) + sizeof(SSkipListNode*) * MAX_SKIP_LIST_LEVEL * 2));
+
+  SSkipList* pSkipList =
+      tSkipListCreate(MAX_SKIP_LIST_LEVEL, TSDB_DATA_TYPE_BIGINT, sizeof(int64_t),
+                      getKeyComparFunc(TSDB_DATA_TYPE_BIGINT, TSDB_ORDER_ASC), SL_DISCARD_DUP_KEY, getInt64Key);
+  tSkipListSetAllocator(pSkipList, skipListTestAlloc, &pool);
+
+  for (int32_t i = 0; i < numOfKeys; ++i) {
+    keys[i] = numOfKeys - i;
+    tSkipListPut(pSkipList, &keys[i]);
+    tSkipListPut(pSkipList, &keys[i]);  // discarded, no node allocated
+  }
+
+  ASSERT_EQ(SL_SIZE(pSkipList), (uint32_t)numOfKeys);
+  ASSERT_EQ(pool.numOfAllocs, numOfKeys);
+
+  int64_t            prev = 0;
+  SSkipListIterator* pIter = tSkipListCreateIter(pSkipList);
+  while (tSkipListIterNext(pIter)) {
+    int64_t key = *(int64_t*)SL_GET_NODE_DATA(tSkipListIterGet(pIter));
+    ASSERT_EQ(key, prev + 1);
+    prev = key;
+  }
+  tSkipListDestroyIter(pIter);
+
+  // nodes are owned by the pool
+  tSkipListDestroy(pSkipList);
+  free(pool.buf);
+  free(keys);
+}
@@ -29,6 +29,7 @@ void    vnodeRelease(void *pVnode);
 void*   vnodeGetWal(void *pVnode);
 
 int32_t vnodeGetVnodeList(int32_t vnodeList[], int32_t *numOfVnodes);
+void    vnodeGetTsdbStat(SVnodeStatisInfo *pInfo);
 void    vnodeBuildStatusMsg(void *pStatus);
 void    vnodeSetAccess(SVgroupAccess *pAccess, int32_t numOfVnodes);
 
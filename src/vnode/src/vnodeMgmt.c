@@ -16,6 +16,7 @@
 #define _DEFAULT_SOURCE
 #include "os.h"
 #include "dnode.h"
+#include "query.h"
 #include "vnodeStatus.h"
 #include "vnodeBackup.h"
 #include "vnodeWorker.h"
@@ -35,7 +36,8 @@ static SStep tsVnodeSteps[] = {
   {"vnode-write",  vnodeInitWrite,      vnodeCleanupWrite},
   {"vnode-read",   vnodeInitRead,       vnodeCleanupRead},
   {"vnode-hash",   vnodeInitHash,       vnodeCleanupHash},
-  {"tsdb-queue",   tsdbInitCommitQueue, tsdbDestroyCommitQueue}
+  {"tsdb-queue",   tsdbInitCommitQueue, tsdbDestroyCommitQueue},
+  {"query-worker", qInitQueryWorkers,   qCleanupQueryWorkers}
 };
 
 int32_t vnodeInitMgmt() {
@@ -186,6 +188,45 @@ int32_t vnodeGetVnodeList(int32_t vnodeList[], int32_t *numOfVnodes) {
   return TSDB_CODE_SUCCESS;
 }
 
+void vnodeGetTsdbStat(SVnodeStatisInfo *pInfo) {
+  int32_t vnodeList[TSDB_MAX_VNODES] = {0};
+  int32_t numOfVnodes = 0;
+
+  vnodeGetVnodeList(vnodeList, &numOfVnodes);
+  numOfVnodes = MIN(numOfVnodes, TSDB_MAX_VNODES);
+
+  for (int32_t i = 0; i < numOfVnodes; ++i) {
+    SVnodeObj *pVnode = vnodeAcquire(vnodeList[i]);
+    if (pVnode == NULL) continue;
+
+    if (pVnode->tsdb != NULL) {
+      STsdbBlockCacheStat stat;
+      tsdbGetBlockCacheStat(pVnode->tsdb, &stat);
+      pInfo->blockCacheSize += stat.size;
+      pInfo->blockCacheHit += stat.hit;
+      pInfo->blockCacheMiss += stat.miss;
+      pInfo->blockCacheEvicted += stat.evicted;
+
+      STsdbCommitStat cstat;
+      tsdbGetCommitStat(pVnode->tsdb, &cstat);
+      pInfo->commits += cstat.commits;
+      pInfo->commitRows += cstat.rows;
+      pInfo->commitBytesIn += cstat.bytesIn;
+      pInfo->commitBytesRead += cstat.bytesRead;
+      pInfo->commitBytesWritten += cstat.bytesWritten;
+      pInfo->commitLastWritten += cstat.lastWritten;
+      pInfo->commitTotalUs += cstat.totalUs;
+      pInfo->commitIterUs += cstat.iterUs;
+      pInfo->commitLoadUs += cstat.loadUs;
+      pInfo->commitEncodeUs += cstat.encodeUs;
+      pInfo->commitWriteUs += cstat.writeUs;
+      pInfo->commitFsyncUs += cstat.fsyncUs;
+    }
+
+    vnodeRelease(pVnode);
+  }
+}
+
 void vnodeBuildStatusMsg(void *param) {
   SStatusMsg *pStatus = param;
 
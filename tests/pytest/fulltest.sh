@@ -168,6 +168,7 @@ python3 ./test.py -f update/merge_commit_data.py
 python3 test.py -f tools/taosdumpTest.py
 python3 test.py -f tools/taosdumpTest2.py
 python3 test.py -f tools/taosdumpTest3.py
+python3 test.py -f tools/taosscanTest.py
 
 python3 test.py -f tools/taosdemoTest.py
 python3 test.py -f tools/taosdemoTestWithoutMetric.py
@@ -373,6 +374,13 @@ python3 ./test.py -f query/last_row_cache.py
 python3 ./test.py -f account/account_create.py
 python3 ./test.py -f alter/alter_table.py
 python3 ./test.py -f query/queryGroupbySort.py
+python3 ./test.py -f query/queryGroupbySpill.py
+python3 ./test.py -f query/queryOrderbyLimit.py
+python3 ./test.py -f query/queryIntervalRollup.py
+python3 ./test.py -f query/queryParallelAgg.py
+python3 ./test.py -f query/queryMergeIndex.py
+python3 ./test.py -f query/queryBlockSkip.py
+python3 ./test.py -f query/queryBlockCache.py
 #python3 ./test.py -f functions/queryTestCases.py
 python3 ./test.py -f functions/function_stateWindow.py
 python3 ./test.py -f functions/function_derivative.py
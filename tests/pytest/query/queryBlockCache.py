@@ -0,0 +1,100 @@
+###################################################################
+#           Copyright (c) 2016 by TAOS Technologies, Inc.
+#                     All rights reserved.
+#
+#  This file is proprietary and confidential to TAOS Technologies.
+#  No part of this file may be reproduced, stored, transmitted,
+#  disclosed or used in any form or by any means other than as
+#  expressly provided by the written permission from Jianhui Tao
+#
+###################################################################
+
+# -*- coding: utf-8 -*-
+
+import time
+import taos
+from util.log import tdLog
+from util.cases import tdCases
+from util.sql import tdSql
+from util.dnodes import tdDnodes
+
+
+class TDTestCase:
+    def init(self, conn, logSql):
+        tdLog.debug("start to execute %s" % __file__)
+        tdSql.init(conn.cursor(), logSql)
+
+        self.ts = 1537146000000
+        self.rows = 3000
+        self.interval = 1
+
+    # the hits and misses saved by the monitor once all the queries before are counted. Only the rows written since
+    # the last start of the dnode are read, from the memtable of the log database, not to count its file blocks
+    def counters(self):
+        time.sleep(self.interval * 3)
+        tdSql.query("select sum(hits), sum(misses) from log.block_cache_info where ts > %d" % self.started)
+        hits, misses = tdSql.queryResult[0]
+        return hits or 0, misses or 0
+
+    # decoded tells if the first run decodes columns, or only reads the columns cached by the queries before
+    def checkQuery(self, sql, decoded):
+        hits, misses = self.counters()
+
+        tdSql.query(sql)
+        expected = tdSql.queryResult
+        hits1, misses1 = self.counters()
+        if decoded and misses1 == misses:
+            tdLog.exit("sql:%s, no column of the file blocks is decoded" % sql)
+        if not decoded and (misses1 != misses or hits1 == hits):
+            tdLog.exit("sql:%s, %d hits and %d misses, expect only hits" % (sql, hits1 - hits, misses1 - misses))
+
+        # the columns decoded by the first run are copied from the cache, the columns absent from the blocks are
+        # neither hits nor misses
+        tdSql.query(sql)
+        if tdSql.queryResult != expected:
+            tdLog.exit("sql:%s, the rows from the cache differ from the rows decoded" % sql)
+        hits2, misses2 = self.counters()
+        read = (hits1 - hits) + (misses1 - misses)
+        if misses2 != misses1 or hits2 - hits1 != read:
+            tdLog.exit("sql:%s, %d hits and %d misses after %d columns read, expect %d hits and no misses" %
+                       (sql, hits2 - hits1, misses2 - misses1, read, read))
+        tdLog.info("sql:%s, %d columns decoded, %d columns read from the cache" % (sql, misses1 - misses, read))
+
+    def run(self):
+        tdDnodes.stop(1)
+        tdDnodes.deploy(1)
+        tdDnodes.cfg(1, "blockCacheSize", 16)
+        tdDnodes.cfg(1, "monitor", 1)
+        tdDnodes.cfg(1, "monitorInterval", self.interval)
+        tdDnodes.start(1)
+
+        tdSql.execute("create database db maxrows 200")
+        tdSql.execute("create table db.t (ts timestamp, v int, n int, s binary(16))")
+        for i in range(0, self.rows, 500):
+            values = ["(%d, %d, null, 's%d')" % (self.ts + j * 1000, j, j % 13) for j in range(i, i + 500)]
+            tdSql.execute("insert into db.t values %s" % " ".join(values))
+
+        # the blocks committed before the column a is added have no a, and n is null in all of their rows
+        tdDnodes.stop(1)
+        tdDnodes.start(1)
+        tdSql.execute("alter table db.t add column a int")
+        for i in range(self.rows, self.rows * 2, 500):
+            values = ["(%d, %d, %d, 's%d', %d)" % (self.ts + j * 1000, j, j, j % 13, j % 7) for j in range(i, i + 500)]
+            tdSql.execute("insert into db.t values %s" % " ".join(values))
+        tdDnodes.stop(1)
+        tdDnodes.start(1)
+        self.started = int(time.time() * 1000)
+
+        self.checkQuery("select * from db.t", True)
+        # n and a are absent from the blocks committed first, their ts is cached
+        self.checkQuery("select ts, n, a from db.t where ts < %d" % (self.ts + self.rows * 1000), False)
+        self.checkQuery("select ts, v, a from db.t where n > 4000 or n < 10", False)
+        self.checkQuery("select ts, s from db.t where v > 10", False)
+
+    def stop(self):
+        tdSql.close()
+        tdLog.success("%s successfully executed" % __file__)
+
+
+tdCases.addWindows(__file__, TDTestCase())
+tdCases.addLinux(__file__, TDTestCase())
@@ -0,0 +1,159 @@
+###################################################################
+#           Copyright (c) 2016 by TAOS Technologies, Inc.
+#                     All rights reserved.
+#
+#  This file is proprietary and confidential to TAOS Technologies.
+#  No part of this file may be reproduced, stored, transmitted,
+#  disclosed or used in any form or by any means other than as
+#  expressly provided by the written permission from Jianhui Tao
+#
+###################################################################
+
+# -*- coding: utf-8 -*-
+
+import sys
+import glob
+import taos
+from util.log import tdLog
+from util.cases import tdCases
+from util.sql import tdSql
+from util.dnodes import tdDnodes
+
+
+class TDTestCase:
+    def init(self, conn, logSql):
+        tdLog.debug("start to execute %s" % __file__)
+        tdSql.init(conn.cursor(), logSql)
+
+        self.ts = 1537146000000
+        self.groupRows = 200
+        self.rows = 4000
+        # the rows written after the column a is added
+        self.newRows = 1000
+
+    def ts2ms(self, ts):
+        return int(ts.timestamp() * 1000 + 0.5)
+
+    def skipped(self):
+        n = 0
+        for log in glob.glob("%s/dnode1/log/taosdlog.*" % tdDnodes.getDnodesRootDir()):
+            with open(log, errors="ignore") as f:
+                n += sum(1 for line in f if "file block skipped by filters" in line)
+        return n
+
+    # the rows are written in groups of 200, v of a group is within [1000 * g, 1000 * g + 199], n is null in the even
+    # groups, f and d reach the edges of their ranges in the groups 4 and 5. A commit writes file blocks of 160 rows,
+    # so some blocks have n all null and the others have both null and not null n
+    def row(self, i):
+        g = i // self.groupRows
+        v = g * 1000 + i % self.groupRows
+        n = "null" if g % 2 == 0 else str(i)
+        if g == 4:
+            f, d = 1.25 if i % 7 == 0 else 0.5, 1e308 if i % 11 == 0 else -2.5
+        elif g == 5:
+            f, d = -1e38 if i % 13 == 0 else -0.25, -1e308 if i % 3 == 0 else 0.0
+        else:
+            f, d = (i % 50) * 0.125, (i % 40) * 0.25
+        return "(%d, %d, %s, %r, %r)" % (self.ts + i * 1000, v, n, f, d)
+
+    def prepare(self):
+        tdSql.execute("create database db maxrows 200 minrows 10")
+        tdSql.execute("create table db.t (ts timestamp, v int, n int, f float, d double)")
+        for i in range(0, self.rows, self.groupRows):
+            tdSql.execute("insert into db.t values %s" % " ".join(self.row(j) for j in range(i, i + self.groupRows)))
+
+        # the blocks committed before the column is added have no a
+        tdDnodes.stop(1)
+        tdDnodes.start(1)
+        tdSql.execute("alter table db.t add column a int")
+        for i in range(self.rows, self.rows + self.newRows, self.groupRows):
+            values = ["(%d, %d, %d, 0.5, 0.5, %d)" % (self.ts + j * 1000, j, j, j % 10) for j in range(i, i + self.groupRows)]
+            tdSql.execute("insert into db.t values %s" % " ".join(values))
+        tdDnodes.stop(1)
+        tdDnodes.start(1)
+
+    # the rows of the time range read without filters, which the reader never skips, filtered here
+    def expect(self, skey, ekey, match):
+        tdSql.query("select * from db.t where ts >= %d and ts <= %d" % (skey, ekey))
+        cols = ["ts", "v", "n", "f", "d", "a"]
+        rows = []
+        for r in tdSql.queryResult:
+            row = dict(zip(cols, r))
+            row["ts"] = self.ts2ms(row["ts"])
+            if match(row):
+                rows.append(row)
+        return rows
+
+    # the query starts and ends in the middle of file blocks, which the reader checks by their statistics
+    def checkRows(self, cond, match, skey, ekey):
+        expected = self.expect(skey, ekey, match)
+        tdSql.query("select ts, v from db.t where ts >= %d and ts <= %d and (%s)" % (skey, ekey, cond))
+        res = [(self.ts2ms(r[0]), r[1]) for r in tdSql.queryResult]
+        if res != [(r["ts"], r["v"]) for r in expected]:
+            tdLog.exit("where %s: %d rows, expect %d" % (cond, len(res), len(expected)))
+        tdLog.info("where %s: %d rows in [%d, %d]" % (cond, len(res), skey, ekey))
+
+    # first, last and interp read rows the filters do not match, the reader is given no filters
+    def checkSelect(self, cond, match, skey, ekey):
+        expected = self.expect(skey, ekey, match)
+        if len(expected) == 0:
+            tdLog.exit("where %s matches no rows to select" % cond)
+
+        tdSql.query("select first(v), last(v) from db.t where ts >= %d and ts <= %d and (%s)" % (skey, ekey, cond))
+        tdSql.checkData(0, 0, expected[0]["v"])
+        tdSql.checkData(0, 1, expected[-1]["v"])
+
+        tdSql.query("select first(*) from db.t where ts >= %d and ts <= %d and %s order by ts desc" % (skey, ekey, cond))
+        tdSql.checkData(0, 1, expected[0]["v"])
+
+        point = expected[len(expected) // 2]
+        tdSql.query("select interp(v) from db.t where ts = %d and %s" % (point["ts"], cond))
+        tdSql.checkData(0, 1, point["v"])
+
+    def run(self):
+        tdDnodes.stop(1)
+        tdDnodes.deploy(1)
+        tdDnodes.start(1)
+        self.prepare()
+
+        ts = lambda i: self.ts + i * 1000
+
+        # no rows of the file blocks at the ends of the range match, they are skipped
+        before = self.skipped()
+        self.checkRows("v >= 5000 and v <= 5100", lambda r: 5000 <= r["v"] <= 5100, ts(450), ts(1650))
+        if self.skipped() == before:
+            tdLog.exit("no file block is skipped by the filters")
+
+        # the blocks with n all null and the blocks with both null and not null n
+        self.checkRows("n is null", lambda r: r["n"] is None, ts(50), ts(1450))
+        self.checkRows("n is not null", lambda r: r["n"] is not None, ts(50), ts(1450))
+        self.checkRows("n > 300", lambda r: r["n"] is not None and r["n"] > 300, ts(50), ts(1450))
+        self.checkRows("n > 300 or n < 250", lambda r: r["n"] is not None and (r["n"] > 300 or r["n"] < 250), ts(150),
+                       ts(1050))
+
+        # the filters at the bounds of the floats of a block
+        self.checkRows("f >= 1.25", lambda r: r["f"] >= 1.25, ts(810), ts(1190))
+        self.checkRows("f = 1.25", lambda r: r["f"] == 1.25, ts(810), ts(1190))
+        self.checkRows("f <= -9e37", lambda r: r["f"] <= -9e37, ts(1010), ts(1390))
+        self.checkRows("f < -0.2 and f > -0.3", lambda r: -0.3 < r["f"] < -0.2, ts(1010), ts(1390))
+        self.checkRows("d >= 1e308", lambda r: r["d"] >= 1e308, ts(810), ts(1190))
+        self.checkRows("d <= -1e308", lambda r: r["d"] <= -1e308, ts(1010), ts(1390))
+        self.checkRows("d = 0", lambda r: r["d"] == 0, ts(1010), ts(1390))
+
+        # the blocks written before the column a is added have none of it, all of its rows are null
+        self.checkRows("a is null", lambda r: r["a"] is None, ts(self.rows - 350), ts(self.rows + 350))
+        self.checkRows("a is not null", lambda r: r["a"] is not None, ts(self.rows - 350), ts(self.rows + 350))
+        self.checkRows("a < 3 or a > 7", lambda r: r["a"] is not None and (r["a"] < 3 or r["a"] > 7),
+                       ts(self.rows - 350), ts(self.rows + 350))
+
+        self.checkSelect("v >= 5000 and v <= 5100", lambda r: 5000 <= r["v"] <= 5100, ts(450), ts(1650))
+        self.checkSelect("n is null", lambda r: r["n"] is None, ts(250), ts(1050))
+        self.checkSelect("a is null", lambda r: r["a"] is None, ts(self.rows - 350), ts(self.rows + 350))
+
+    def stop(self):
+        tdSql.close()
+        tdLog.success("%s successfully executed" % __file__)
+
+
+tdCases.addWindows(__file__, TDTestCase())
+tdCases.addLinux(__file__, TDTestCase())
@@ -0,0 +1,202 @@
+###################################################################
+#           Copyright (c) 2016 by TAOS Technologies, Inc.
+#                     All rights reserved.
+#
+#  This file is proprietary and confidential to TAOS Technologies.
+#  No part of this file may be reproduced, stored, transmitted,
+#  disclosed or used in any form or by any means other than as
+#  expressly provided by the written permission from Jianhui Tao
+#
+###################################################################
+
+# -*- coding: utf-8 -*-
+
+import glob
+import taos
+from util.log import tdLog
+from util.cases import tdCases
+from util.sql import tdSql
+from util.dnodes import tdDnodes
+
+
+# count, sum, min and max of the values of a group, None when all of them are null
+class GroupModel:
+    def __init__(self):
+        self.count = 0
+        self.values = []
+
+    def add(self, value):
+        self.count += 1
+        if value is not None:
+            self.values.append(value)
+
+    def sum(self):
+        return sum(self.values) if self.values else None
+
+    def min(self):
+        return min(self.values) if self.values else None
+
+    def max(self):
+        return max(self.values) if self.values else None
+
+
+class TDTestCase:
+    def init(self, conn, logSql):
+        tdLog.debug("start to execute %s" % __file__)
+        tdSql.init(conn.cursor(), logSql)
+
+        self.ts = 1537146000000
+        self.tables = 20
+        self.rows = 3000
+
+        # with groupbyBufferSize 0 a pass keeps 1024 groups and spreads the others over 16 partitions, so more than
+        # 16 * 1024 + 1024 groups take the partitions of the second level
+        self.intGroups = 30000
+        self.binGroups = 25000
+
+        # more tables than the 1024 groups of a batch
+        self.batchTables = 1500
+
+    def logCount(self, text):
+        n = 0
+        for log in glob.glob("%s/dnode1/log/taosdlog.*" % tdDnodes.getDnodesRootDir()):
+            with open(log, errors="ignore") as f:
+                n += sum(1 for line in f if text in line)
+        return n
+
+    def row(self, n):
+        v = None if n % 97 == 0 else (n * 7919) % self.intGroups
+        return self.ts + n * 1000, v, "k%d" % ((n * 104729) % self.binGroups), n % 1000 + 0.25
+
+    def insertData(self):
+        tdSql.execute("create table db.st (ts timestamp, v int, b binary(16), f double) tags (t int)")
+        tdSql.execute("create table db.nt (ts timestamp, v int, b binary(16), f double)")
+
+        self.stRows = []
+        self.ntRows = []
+        n = 0
+        for i in range(self.tables + 1):
+            name = "db.nt" if i == self.tables else "db.t%d" % i
+            if i < self.tables:
+                tdSql.execute("create table %s using db.st tags (%d)" % (name, i % 3))
+
+            rows = [self.row(m) for m in range(n, n + self.rows)]
+            n += self.rows
+            for k in range(0, self.rows, 500):
+                tdSql.execute("insert into %s values %s" % (name, " ".join(
+                    "(%d, %s, '%s', %r)" % (ts, "null" if v is None else v, b, f) for ts, v, b, f in rows[k:k + 500])))
+
+            if i < self.tables:
+                self.stRows += [(i % 3,) + r for r in rows]
+            else:
+                self.ntRows = rows
+
+    def groups(self, rows, key, value):
+        groups = {}
+        for r in rows:
+            groups.setdefault(key(r), GroupModel()).add(value(r))
+        return groups
+
+    # the rows of a query by the group by column selected last, each group is returned once
+    def queryGroups(self, sql):
+        tdSql.query(sql)
+        res = {}
+        for r in tdSql.queryResult:
+            if r[-1] in res:
+                tdLog.exit("sql:%s, group %s returned twice" % (sql, r[-1]))
+            res[r[-1]] = list(r[:-1])
+        return res
+
+    def checkGroups(self, sql, groups, expect):
+        res = self.queryGroups(sql)
+        if len(res) != len(groups):
+            tdLog.exit("sql:%s, %d groups, expect %d" % (sql, len(res), len(groups)))
+
+        for key, g in groups.items():
+            if res.get(key) != expect(g):
+                tdLog.exit("sql:%s, group %s: %s, expect %s" % (sql, key, res.get(key), expect(g)))
+        tdLog.info("sql:%s, %d groups" % (sql, len(res)))
+
+    def checkSpill(self):
+        spilled = self.logCount("spilled, rows:")
+        level1 = self.logCount("start to aggregate group by partition of level:1")
+
+        byV = self.groups(self.stRows, lambda r: r[2], lambda r: r[4])
+        self.checkGroups("select count(*), sum(f), min(f), v from db.st group by v", byV,
+                         lambda g: [g.count, g.sum(), g.min()])
+
+        byB = self.groups(self.stRows, lambda r: r[3], lambda r: r[2])
+        self.checkGroups("select count(*), min(v), max(v), b from db.st group by b", byB,
+                         lambda g: [g.count, g.min(), g.max()])
+
+        # only the tag of the group by columns is returned, the groups are told apart by their results
+        byTB = self.groups(self.stRows, lambda r: (r[0], r[3]), lambda r: r[2])
+        tdSql.query("select count(*), sum(v) from db.st group by t, b")
+        expected = [(g.count, g.sum(), key[0]) for key, g in byTB.items()]
+        if sorted(tdSql.queryResult, key=str) != sorted(expected, key=str):
+            tdLog.exit("the groups of t and b differ from the %d groups written" % len(byTB))
+
+        ntByV = self.groups(self.ntRows, lambda r: r[1], lambda r: r[3])
+        self.checkGroups("select count(*), max(f), v from db.nt group by v", ntByV, lambda g: [g.count, g.max()])
+
+        if self.logCount("spilled, rows:") == spilled:
+            tdLog.exit("no group by partition is spilled")
+        if self.logCount("start to aggregate group by partition of level:1") == level1:
+            tdLog.exit("no group by partition of the second level is aggregated")
+
+        # the groups of each partition are sorted before the partition is returned
+        tdSql.query("select count(*), sum(f), v from db.st where v >= 0 group by v order by v desc")
+        keys = [r[-1] for r in tdSql.queryResult]
+        if keys != sorted((k for k in byV if k is not None), reverse=True):
+            tdLog.exit("the groups are not returned in the descending order of v")
+        for r in tdSql.queryResult:
+            if [r[0], r[1]] != [byV[r[-1]].count, byV[r[-1]].sum()]:
+                tdLog.exit("group %d: %s, expect %d rows summed to %s" % (r[-1], r, byV[r[-1]].count, byV[r[-1]].sum()))
+
+    def checkTableBatches(self):
+        tdSql.execute("create table db.bst (ts timestamp, v int) tags (t int)")
+        for i in range(0, self.batchTables, 100):
+            tdSql.execute("create table %s" % " ".join(
+                "db.b%d using db.bst tags (%d)" % (k, k % 5) for k in range(i, i + 100)))
+            tdSql.execute("insert into %s" % " ".join(
+                "db.b%d values (%d, %d) (%d, %d)" % (k, self.ts, k, self.ts + 1000, k * 2) for k in range(i, i + 100)))
+
+        batches = self.logCount("table groups are aggregated in 2 batches")
+
+        tdSql.query("select count(*), sum(v), min(v), tbname from db.bst group by tbname")
+        tdSql.checkRows(self.batchTables)
+        for r in tdSql.queryResult:
+            k = int(r[-1][1:])
+            if list(r[:3]) != [2, k * 3, k]:
+                tdLog.exit("table b%d: %s, expect 2 rows summed to %d" % (k, r, k * 3))
+
+        # the tables of a tag are all in one group
+        tdSql.query("select count(*), sum(v), t from db.bst group by t")
+        tdSql.checkRows(5)
+        for r in tdSql.queryResult:
+            tdSql.checkEqual(r[1], sum(k * 3 for k in range(r[-1], self.batchTables, 5)))
+
+        if self.logCount("table groups are aggregated in 2 batches") != batches + 1:
+            tdLog.exit("the groups of the tables are not aggregated in batches")
+
+    def run(self):
+        tdDnodes.stop(1)
+        tdDnodes.deploy(1)
+        tdDnodes.cfg(1, "groupbyBufferSize", 0)
+        # all the tables in one vnode
+        tdDnodes.cfg(1, "maxVgroupsPerDb", 1)
+        tdDnodes.start(1)
+
+        tdSql.prepare()
+        self.insertData()
+
+        self.checkSpill()
+        self.checkTableBatches()
+
+    def stop(self):
+        tdSql.close()
+        tdLog.success("%s successfully executed" % __file__)
+
+
+tdCases.addWindows(__file__, TDTestCase())
+tdCases.addLinux(__file__, TDTestCase())
@@ -0,0 +1,193 @@
+###################################################################
+#           Copyright (c) 2016 by TAOS Technologies, Inc.
+#                     All rights reserved.
+#
+#  This file is proprietary and confidential to TAOS Technologies.
+#  No part of this file may be reproduced, stored, transmitted,
+#  disclosed or used in any form or by any means other than as
+#  expressly provided by the written permission from Jianhui Tao
+#
+###################################################################
+
+# -*- coding: utf-8 -*-
+
+import os
+import glob
+import subprocess
+import taos
+from util.log import tdLog
+from util.cases import tdCases
+from util.sql import tdSql
+from util.dnodes import tdDnodes
+
+
+class TDTestCase:
+    def init(self, conn, logSql):
+        tdLog.debug("start to execute %s" % __file__)
+        tdSql.init(conn.cursor(), logSql)
+
+        self.ts = 1537146000000
+        self.tables = 4
+        self.rows = 12000
+        self.batch = 500
+
+        # the float functions are compared with those of the plain blocks of pdb, the others with the rows written
+        self.floatQueries = [
+            "select count(*), sum(d), min(f), max(f), spread(d) from %s.nt interval(5m)",
+            "select count(*), avg(v), spread(b), first(f), last(d) from %s.nt interval(1h)",
+            "select count(*), sum(v), max(f) from %s.nt interval(10m) sliding(5m)",
+            "select count(*), avg(b), spread(f) from %s.st interval(1h) group by tbname",
+            "select count(*), sum(d), max(v) from %s.st interval(1h)",
+        ]
+
+    def getBuildPath(self):
+        selfPath = os.path.dirname(os.path.realpath(__file__))
+
+        if ("community" in selfPath):
+            projPath = selfPath[:selfPath.find("community")]
+        else:
+            projPath = selfPath[:selfPath.find("tests")]
+
+        for root, dirs, files in os.walk(projPath):
+            if ("taosscan" in files):
+                rootRealPath = os.path.dirname(os.path.realpath(root))
+                if ("packaging" not in rootRealPath):
+                    buildPath = root[:len(root) - len("/build/bin")]
+                    break
+        return buildPath
+
+    # rows every second with a gap of 37 seconds every 500 rows, the sums of the float columns are exact
+    def row(self, n, k):
+        ts = self.ts + n * 1000 + (n // 500) * 37000
+        v = None if (n + k) % 13 == 0 else (n * 7919 + k) % 20000 - 10000
+        return ts, v, (n - 6000) * 1000003, (n % 1000) * 0.5, n * 0.25, n % 30000 - 15000, n % 200 - 100
+
+    def insertData(self, db):
+        tdSql.execute("drop database if exists %s" % db)
+        tdSql.execute("create database %s" % db)
+        tdSql.execute("create table %s.st (ts timestamp, v int, b bigint, f float, d double, s smallint, t tinyint) "
+                      "tags (id int)" % db)
+        tdSql.execute("create table %s.nt (ts timestamp, v int, b bigint, f float, d double, s smallint, t tinyint)" % db)
+
+        names = ["t%d" % i for i in range(self.tables)] + ["nt"]
+        for i in range(self.tables):
+            tdSql.execute("create table %s.t%d using %s.st tags (%d)" % (db, i, db, i))
+
+        self.model = {}
+        for k, name in enumerate(names):
+            self.model[name] = [self.row(n, k) for n in range(self.rows)]
+            for n0 in range(0, self.rows, self.batch):
+                values = ["(%d, %s, %d, %.1f, %.2f, %d, %d)" % (r[0], "null" if r[1] is None else r[1], *r[2:])
+                          for r in self.model[name][n0:n0 + self.batch]]
+                tdSql.execute("insert into %s.%s values %s" % (db, name, " ".join(values)))
+
+    # the windows of the rows of a table, each one aggregated by the functions of the columns given
+    def windows(self, name, interval, funcs):
+        groups = {}
+        for r in self.model[name]:
+            groups.setdefault(r[0] - r[0] % interval, []).append(r)
+        return [[ts] + [func([r[col] for r in rows if r[col] is not None]) for func, col in funcs]
+                for ts, rows in sorted(groups.items())]
+
+    def rollupBlocks(self):
+        n = 0
+        for log in glob.glob("%s/dnode1/log/taosdlog.*" % tdDnodes.getDnodesRootDir()):
+            with open(log, errors="ignore") as f:
+                n += sum(1 for line in f if "qualified by" in line and "rollup windows" in line)
+        return n
+
+    def checkWindows(self, sql, expected):
+        tdSql.query(sql)
+        res = [[int(r[0].timestamp() * 1000 + 0.5)] + list(r[1:]) for r in tdSql.queryResult]
+        if len(res) != len(expected):
+            tdLog.exit("sql:%s, %d windows, expect %d" % (sql, len(res), len(expected)))
+        for i in range(len(res)):
+            if res[i] != expected[i]:
+                tdLog.exit("sql:%s, window:%d, %s, expect %s" % (sql, i, res[i], expected[i]))
+        tdLog.info("sql:%s, %d windows" % (sql, len(res)))
+
+    def checkModel(self):
+        count = lambda vals: len(vals)
+        total = lambda vals: sum(vals) if vals else None
+        low = lambda vals: min(vals) if vals else None
+        high = lambda vals: max(vals) if vals else None
+        minute, hour = 60000, 3600000
+
+        before = self.rollupBlocks()
+        self.checkWindows("select count(*), count(v), sum(v), min(v), max(v) from rdb.nt interval(1m)",
+                          self.windows("nt", minute, [(count, 0), (count, 1), (total, 1), (low, 1), (high, 1)]))
+        self.checkWindows("select count(*), sum(b), min(b), max(b), min(t), max(s) from rdb.nt interval(5m)",
+                          self.windows("nt", 5 * minute, [(count, 0), (total, 2), (low, 2), (high, 2), (low, 6),
+                                                          (high, 5)]))
+        self.checkWindows("select count(*), sum(s), min(v), max(v) from rdb.nt interval(1h)",
+                          self.windows("nt", hour, [(count, 0), (total, 5), (low, 1), (high, 1)]))
+        self.checkWindows("select count(*), min(v), max(b) from rdb.nt interval(1h) order by ts desc",
+                          self.windows("nt", hour, [(count, 0), (low, 1), (high, 2)])[::-1])
+        self.checkWindows("select count(*), sum(v), min(d) from rdb.nt interval(30s)",
+                          self.windows("nt", 30000, [(count, 0), (total, 1), (low, 4)]))
+
+        # the windows of the tables one after another
+        expected = []
+        for i in range(self.tables):
+            expected += [w + ["t%d" % i] for w in self.windows("t%d" % i, minute, [(count, 0), (total, 1), (high, 6)])]
+        self.checkWindows("select count(*), sum(v), max(t) from rdb.st interval(1m) group by tbname", expected)
+
+        if self.rollupBlocks() == before:
+            tdLog.exit("no file block is read by its rollup windows")
+
+    # the data files of the vnode of a database
+    def dataFiles(self, db):
+        tdSql.query("show %s.vgroups" % db)
+        vgId = tdSql.queryResult[0][0]
+        return glob.glob("%s/dnode1/data/vnode/vnode%d/tsdb/data/*.data" % (tdDnodes.getDnodesRootDir(), vgId))
+
+    def restart(self, levels):
+        tdDnodes.stop(1)
+        tdDnodes.cfg(1, "rollupLevels", levels)
+        tdDnodes.start(1)
+
+    def run(self):
+        tdDnodes.stop(1)
+        tdDnodes.deploy(1)
+        tdDnodes.start(1)
+
+        # the blocks of pdb are committed without a rollup when the dnode stops
+        self.insertData("pdb")
+        self.restart("1m,1h")
+
+        self.insertData("rdb")
+        self.restart("1m,1h")
+
+        # the rollups make the data files of rdb larger
+        pdbSize = sum(os.path.getsize(f) for f in self.dataFiles("pdb"))
+        rdbSize = sum(os.path.getsize(f) for f in self.dataFiles("rdb"))
+        if pdbSize == 0 or rdbSize <= pdbSize:
+            tdLog.exit("data files of %d bytes with rollups, %d bytes without" % (rdbSize, pdbSize))
+
+        self.checkModel()
+
+        for sql in self.floatQueries:
+            tdSql.query(sql % "pdb")
+            expected = list(tdSql.queryResult)
+            tdSql.query(sql % "rdb")
+            if list(tdSql.queryResult) != expected:
+                tdLog.exit("sql:%s, %d windows with rollups differ from the %d windows of the plain blocks" %
+                           (sql % "rdb", tdSql.queryRows, len(expected)))
+            tdLog.info("sql:%s, %d windows matched" % (sql % "rdb", len(expected)))
+
+        # the rollups read back by taosscan have their checksums and cover the rows of each block
+        tdDnodes.stop(1)
+        dirs = glob.glob("%s/dnode1/data/vnode/vnode*" % tdDnodes.getDnodesRootDir())
+        taosscan = "%s/build/bin/taosscan" % self.getBuildPath()
+        proc = subprocess.run([taosscan, "-s"] + dirs, stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+        if proc.returncode != 0:
+            tdLog.exit("taosscan failed:\n%s" % proc.stdout.decode("utf-8"))
+        tdDnodes.start(1)
+
+    def stop(self):
+        tdSql.close()
+        tdLog.success("%s successfully executed" % __file__)
+
+
+tdCases.addWindows(__file__, TDTestCase())
+tdCases.addLinux(__file__, TDTestCase())
@@ -0,0 +1,175 @@
+###################################################################
+#           Copyright (c) 2016 by TAOS Technologies, Inc.
+#                     All rights reserved.
+#
+#  This file is proprietary and confidential to TAOS Technologies.
+#  No part of this file may be reproduced, stored, transmitted,
+#  disclosed or used in any form or by any means other than as
+#  expressly provided by the written permission from Jianhui Tao
+#
+###################################################################
+
+# -*- coding: utf-8 -*-
+
+import sys
+import taos
+from util.log import tdLog
+from util.cases import tdCases
+from util.sql import tdSql
+from util.dnodes import tdDnodes
+
+
+# the rows of a table as the database keeps them, a later row of the same key replaces the row with update 1 and only
+# its columns that are not null with update 2
+class TableModel:
+    def __init__(self, update):
+        self.update = update
+        self.rows = {}
+
+    def write(self, ts, cols):
+        if self.update == 2 and ts in self.rows:
+            self.rows[ts] = [o if c is None else c for o, c in zip(self.rows[ts], cols)]
+        else:
+            self.rows[ts] = list(cols)
+
+    def select(self, skey, ekey):
+        return [[ts] + self.rows[ts] for ts in sorted(self.rows) if skey <= ts <= ekey]
+
+
+class TDTestCase:
+    def init(self, conn, logSql):
+        tdLog.debug("start to execute %s" % __file__)
+        tdSql.init(conn.cursor(), logSql)
+
+        self.ts = 1537146000000
+        self.tables = 3
+        self.fileRows = 3000
+
+    def value(self, n, k, col):
+        if col == 0:
+            return (n * 7919 + k) % 20001 - 10000
+        if col == 1:
+            return (n - 1500) * 1000003 + k
+        return "s%d" % ((n + k) % 97)
+
+    def toSql(self, c):
+        if c is None:
+            return "null"
+        return "'%s'" % c if isinstance(c, str) else str(c)
+
+    def insert(self, db, k, model, rows):
+        for i in range(0, len(rows), 200):
+            batch = rows[i:i + 200]
+            tdSql.execute("insert into %s.t%d values %s" %
+                          (db, k, " ".join("(%d, %s)" % (ts, ", ".join(self.toSql(c) for c in cols))
+                                           for ts, cols in batch)))
+            for ts, cols in batch:
+                model.write(ts, cols)
+
+    # the file rows every 10 seconds, committed when the dnode restarts
+    def fileData(self, k):
+        return [(self.ts + n * 10000, [self.value(n, k, c) for c in range(3)]) for n in range(self.fileRows)]
+
+    # memtable rows between the file rows, rows overwriting file rows with some columns null, and rows before and after
+    # the keys of the files
+    def memData(self, k):
+        rows = []
+        for n in range(0, self.fileRows, 7):
+            rows.append((self.ts + n * 10000 + 5000, [self.value(n, k + 50, c) for c in range(3)]))
+        for n in range(3, self.fileRows, 11):
+            cols = [self.value(n, k + 100, c) for c in range(3)]
+            cols[n % 3] = None
+            rows.append((self.ts + n * 10000, cols))
+        for n in range(1, 40):
+            rows.append((self.ts - n * 1000, [self.value(n, k + 200, c) for c in range(3)]))
+            rows.append((self.ts + self.fileRows * 10000 + n * 1000, [self.value(n, k + 300, c) for c in range(3)]))
+        return rows
+
+    def queries(self, db):
+        last = self.ts + self.fileRows * 10000
+        sqls = []
+        for k in range(self.tables):
+            sqls += [
+                "select * from %s.t%d" % (db, k),
+                "select * from %s.t%d order by ts desc" % (db, k),
+                "select * from %s.t%d where ts >= %d and ts <= %d" % (db, k, self.ts + 12345000, self.ts + 23456000),
+                "select * from %s.t%d where ts >= %d and ts <= %d order by ts desc" % (db, k, self.ts - 5000,
+                                                                                      self.ts + 7000000),
+                "select * from %s.t%d limit 500 offset 1234" % (db, k),
+                "select count(*), count(v), sum(b), min(v), max(v), last(s) from %s.t%d interval(10m)" % (db, k),
+            ]
+        sqls += [
+            "select count(*), sum(v), first(s), last(b) from %s.st group by tbname" % db,
+            "select * from %s.st where ts > %d and ts < %d" % (db, last - 300000, last + 20000),
+        ]
+        return sqls
+
+    def queryAll(self, sqls):
+        res = []
+        for sql in sqls:
+            tdSql.query(sql)
+            res.append(list(tdSql.queryResult))
+        return res
+
+    def checkModel(self, db, models):
+        for k, model in enumerate(models):
+            tdSql.query("select * from %s.t%d" % (db, k))
+            expected = model.select(0, sys.maxsize)
+            if len(tdSql.queryResult) != len(expected):
+                tdLog.exit("%s.t%d: %d rows, expect %d" % (db, k, len(tdSql.queryResult), len(expected)))
+
+            for i, row in enumerate(tdSql.queryResult):
+                ts = int(row[0].timestamp() * 1000 + 0.5) if not isinstance(row[0], int) else row[0]
+                if [ts] + list(row[1:]) != expected[i]:
+                    tdLog.exit("%s.t%d row %d: %s, expect %s" % (db, k, i, row, expected[i]))
+            tdLog.info("%s.t%d: %d rows of the files and the memtable are merged" % (db, k, len(expected)))
+
+    def checkUpdate(self, update):
+        db = "u%d" % update
+        models = [TableModel(update) for k in range(self.tables)]
+
+        tdSql.execute("create database %s update %d" % (db, update))
+        tdSql.execute("create table %s.st (ts timestamp, v int, b bigint, s binary(8)) tags (id int)" % db)
+        for k in range(self.tables):
+            tdSql.execute("create table %s.t%d using %s.st tags (%d)" % (db, k, db, k))
+            self.insert(db, k, models[k], self.fileData(k))
+
+        tdDnodes.stop(1)
+        tdDnodes.start(1)
+
+        for k in range(self.tables):
+            self.insert(db, k, models[k], self.memData(k))
+
+        sqls = self.queries(db)
+        byIndex = self.queryAll(sqls)
+        self.checkModel(db, models)
+
+        # the rows merged one by one, the memtable is not committed in between
+        tdSql.execute("alter dnode 1 mergeIndex 0")
+        byRow = self.queryAll(sqls)
+        tdSql.execute("alter dnode 1 mergeIndex 1")
+
+        for i, sql in enumerate(sqls):
+            if byIndex[i] != byRow[i]:
+                for j in range(min(len(byIndex[i]), len(byRow[i]))):
+                    if byIndex[i][j] != byRow[i][j]:
+                        tdLog.exit("sql:%s, row %d: %s by the merge index, %s row by row" %
+                                   (sql, j, byIndex[i][j], byRow[i][j]))
+                tdLog.exit("sql:%s, %d rows by the merge index, %d row by row" % (sql, len(byIndex[i]), len(byRow[i])))
+            tdLog.info("sql:%s, %d rows are the same row by row" % (sql, len(byRow[i])))
+
+    def run(self):
+        tdDnodes.stop(1)
+        tdDnodes.deploy(1)
+        tdDnodes.start(1)
+
+        self.checkUpdate(1)
+        self.checkUpdate(2)
+
+    def stop(self):
+        tdSql.close()
+        tdLog.success("%s successfully executed" % __file__)
+
+
+tdCases.addWindows(__file__, TDTestCase())
+tdCases.addLinux(__file__, TDTestCase())
@@ -0,0 +1,136 @@
+###################################################################
+#           Copyright (c) 2016 by TAOS Technologies, Inc.
+#                     All rights reserved.
+#
+#  This file is proprietary and confidential to TAOS Technologies.
+#  No part of this file may be reproduced, stored, transmitted,
+#  disclosed or used in any form or by any means other than as
+#  expressly provided by the written permission from Jianhui Tao
+#
+###################################################################
+
+# -*- coding: utf-8 -*-
+
+import sys
+import re
+import glob
+import taos
+from util.log import tdLog
+from util.cases import tdCases
+from util.sql import tdSql
+from util.dnodes import tdDnodes
+
+
+class TDTestCase:
+    def init(self, conn, logSql):
+        tdLog.debug("start to execute %s" % __file__)
+        tdSql.init(conn.cursor(), logSql)
+
+        self.ts = 1537146000000
+        self.tables = 8
+        self.rows = 400
+
+        # the query without limit and offset, the index of the order column in the result
+        self.queries = [
+            ("select * from db.st order by ts", 0),
+            ("select * from db.st order by ts desc", 0),
+            ("select ts, v, t from db.st where v > 10 order by ts desc", 0),
+            ("select * from (select ts, v, f from db.st) order by v", 1),
+            ("select * from (select ts, v, f from db.st) order by v desc", 1),
+            ("select * from (select ts, v, b from db.st where t < 5) order by b desc", 2),
+            ("select * from (select ts, v, f from db.nt) order by v", 1),
+            ("select * from (select ts, v, f from db.nt) order by f desc", 2),
+        ]
+        self.limits = [(1, 0), (7, 0), (10, 5), (33, 17), (100, 350), (500, 1000), (20, 3180), (10, 5000)]
+
+    def insertData(self):
+        tdSql.execute("create table db.st (ts timestamp, v int, f double, b binary(16)) tags (t int)")
+        tdSql.execute("create table db.nt (ts timestamp, v int, f double, b binary(16))")
+
+        # the child tables share their timestamps, and v, f and b repeat, so the order columns have many ties
+        for i in range(self.tables + 1):
+            name = "db.nt" if i == self.tables else "db.t%d" % i
+            if i < self.tables:
+                tdSql.execute("create table %s using db.st tags (%d)" % (name, i))
+
+            values = []
+            for j in range(self.rows):
+                v = "null" if (i + j) % 41 == 0 else str((i * 7 + j) % 50)
+                values.append("(%d, %s, %d.5, 'b%d')" % (self.ts + j * 1000, v, (i + j) % 13, (i * 3 + j) % 37))
+            tdSql.execute("insert into %s values %s" % (name, " ".join(values)))
+
+    # the rows with the same order key may come in any order, so the rows of each key in the result are compared with
+    # those of the full sort, and the rows of a key cut by the limit or offset must be some of them
+    def checkLimit(self, sql, col, full, res, limit, offset):
+        expect = full[offset:offset + limit]
+        if len(res) != len(expect):
+            tdLog.exit("sql:%s, %d rows, expect %d" % (sql, len(res), len(expect)))
+
+        for i in range(len(res)):
+            if res[i][col] != expect[i][col]:
+                tdLog.exit("sql:%s, row:%d, order key %s, expect %s" % (sql, i, res[i][col], expect[i][col]))
+
+        keys = {}
+        for row in full:
+            keys.setdefault(row[col], []).append(row)
+
+        window = {}
+        for row in res:
+            window.setdefault(row[col], []).append(row)
+
+        for key, rows in window.items():
+            all = sorted(keys[key], key=str)
+            if len(rows) == len(all) and sorted(rows, key=str) != all:
+                tdLog.exit("sql:%s, rows of order key %s are %s, expect %s" % (sql, key, rows, all))
+            for row in rows:
+                if row not in all:
+                    tdLog.exit("sql:%s, row %s not in the rows of order key %s" % (sql, row, key))
+
+    # the rows kept by the top-N operators of the vnodes since the last call, each vnode logs one line per query
+    def vnodeTopN(self):
+        lines = []
+        for log in sorted(glob.glob("%s/dnode1/log/taosdlog.*" % tdDnodes.getDnodesRootDir())):
+            with open(log, errors="ignore") as f:
+                lines += [line for line in f if "top-N kept" in line]
+
+        kept = [tuple(int(x) for x in re.search(r"top-N kept (\d+) of (\d+) rows, limit:(\d+)", line).groups())
+                for line in lines[self.topNLines:]]
+        self.topNLines = len(lines)
+        return kept
+
+    # each vgroup of an ordered projection on the super table returns no more than limit + offset rows
+    def checkVnodeRows(self, sql, limit, offset):
+        kept = self.vnodeTopN()
+        if len(kept) == 0:
+            tdLog.exit("sql:%s, no vnode kept the first %d rows" % (sql, limit + offset))
+
+        for rows, total, vgroupLimit in kept:
+            if vgroupLimit != limit + offset or rows != min(total, vgroupLimit):
+                tdLog.exit("sql:%s, a vnode returns %d of %d rows, limit:%d" % (sql, rows, total, vgroupLimit))
+
+    def run(self):
+        tdSql.prepare()
+        self.insertData()
+        self.topNLines = 0
+
+        for sql, col in self.queries:
+            tdSql.query(sql)
+            full = list(tdSql.queryResult)
+            self.vnodeTopN()
+
+            for limit, offset in self.limits:
+                limitSql = "%s limit %d offset %d" % (sql, limit, offset)
+                tdSql.query(limitSql)
+                self.checkLimit(limitSql, col, full, list(tdSql.queryResult), limit, offset)
+                if sql.startswith("select * from db.st") or sql.startswith("select ts, v, t from db.st"):
+                    self.checkVnodeRows(limitSql, limit, offset)
+
+            tdLog.info("sql:%s, %d rows, limits matched" % (sql, len(full)))
+
+    def stop(self):
+        tdSql.close()
+        tdLog.success("%s successfully executed" % __file__)
+
+
+tdCases.addWindows(__file__, TDTestCase())
+tdCases.addLinux(__file__, TDTestCase())
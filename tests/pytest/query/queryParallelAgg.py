@@ -0,0 +1,219 @@
+###################################################################
+#           Copyright (c) 2016 by TAOS Technologies, Inc.
+#                     All rights reserved.
+#
+#  This file is proprietary and confidential to TAOS Technologies.
+#  No part of this file may be reproduced, stored, transmitted,
+#  disclosed or used in any form or by any means other than as
+#  expressly provided by the written permission from Jianhui Tao
+#
+###################################################################
+
+# -*- coding: utf-8 -*-
+
+import re
+import glob
+import math
+import time
+import taos
+from util.log import tdLog
+from util.cases import tdCases
+from util.sql import tdSql
+from util.dnodes import tdDnodes
+
+
+# the aggregate functions over the values that are not null, None if there are none
+def count(vals):
+    return len(vals)
+
+
+def total(vals):
+    return sum(vals) if vals else None
+
+
+def avg(vals):
+    return sum(vals) / len(vals) if vals else None
+
+
+def low(vals):
+    return min(vals) if vals else None
+
+
+def high(vals):
+    return max(vals) if vals else None
+
+
+def spread(vals):
+    return float(max(vals) - min(vals)) if vals else None
+
+
+def stddev(vals):
+    if not vals:
+        return None
+    mean = sum(vals) / len(vals)
+    return math.sqrt(sum((x - mean) ** 2 for x in vals) / len(vals))
+
+
+class TDTestCase:
+    def init(self, conn, logSql):
+        tdLog.debug("start to execute %s" % __file__)
+        tdSql.init(conn.cursor(), logSql)
+
+        self.ts = 1537146000000
+        self.tables = 40
+        self.rows = 400
+        self.workers = 4
+
+        # the columns of the rows of the model
+        TS, V, B, F, D, T, G = range(7)
+        first, last = self.ts + 30000, self.ts + 300000
+
+        # sql, the rows it reads, the key of its groups, the functions of the columns and the passes of it aggregated by
+        # the workers. The stddev of a super table takes a pass for the averages, which the workers aggregate, and then
+        # the pass of stddev, which is not split among them, neither are interval and normal table queries
+        self.queries = [
+            ("select count(*), count(v), sum(v), avg(v), min(v), max(v), spread(f) from db.st", None, None,
+             [(count, TS), (count, V), (total, V), (avg, V), (low, V), (high, V), (spread, F)], 1),
+            ("select count(*), sum(v), stddev(v) from db.st", None, None,
+             [(count, TS), (total, V), (stddev, V)], 1),
+            ("select count(*), sum(v), max(d), min(d), avg(d), spread(d) from db.st where v > 100",
+             lambda r: r[V] is not None and r[V] > 100, None,
+             [(count, TS), (total, V), (high, D), (low, D), (avg, D), (spread, D)], 1),
+            ("select count(*), sum(b), avg(f), min(v), max(f), min(f) from db.st group by g", None, G,
+             [(count, TS), (total, B), (avg, F), (low, V), (high, F), (low, F)], 1),
+            ("select count(v), sum(v), spread(v), stddev(d) from db.st where t > 5 and v < 0 group by t",
+             lambda r: r[T] > 5 and r[V] is not None and r[V] < 0, T,
+             [(count, V), (total, V), (spread, V), (stddev, D)], 1),
+            ("select count(*), min(v), max(v) from db.st where ts > %d and ts < %d group by g" % (first, last),
+             lambda r: first < r[TS] < last, G, [(count, TS), (low, V), (high, V)], 1),
+            ("select max(v), min(v), sum(b) from db.st group by t", None, T, [(high, V), (low, V), (total, B)], 1),
+            ("select max(v), min(v), sum(f) from db.st interval(1m)", None, lambda r: r[TS] - r[TS] % 60000,
+             [(high, V), (low, V), (total, F)], 0),
+            ("select count(*), sum(v), avg(f) from db.t3", lambda r: r[T] == 3, None,
+             [(count, TS), (total, V), (avg, F)], 0),
+        ]
+
+    def insertData(self, start, end):
+        for i in range(self.tables):
+            rows = []
+            for n in range(start, end):
+                v = None if (n * 31 + i) % 19 == 0 else (n * 7919 + i * 104729) % 2001 - 1000
+                rows.append((self.ts + n * 1000 + i, v, (n - i) * 1000003, (n * 13 + i) % 1000 * 0.25,
+                             (n + i) % 97 / 16.0, i, i % 3))
+            tdSql.execute("insert into db.t%d values %s" % (i, " ".join(
+                "(%d, %s, %d, %r, %r)" % (r[0], "null" if r[1] is None else r[1], r[2], r[3], r[4]) for r in rows)))
+            self.model += rows
+
+    # the rows of each group aggregated by the functions of the query, the key is the first column of an interval
+    # query and the last one of a group by query
+    def expect(self, cond, key, funcs):
+        groups = {}
+        for r in self.model:
+            if cond is None or cond(r):
+                k = None if key is None else (key(r) if callable(key) else r[key])
+                groups.setdefault(k, []).append(r)
+
+        rows = {}
+        for k, group in groups.items():
+            rows[k] = [func([r[col] for r in group if r[col] is not None]) for func, col in funcs]
+        return rows
+
+    def morsels(self):
+        lines = []
+        for log in glob.glob("%s/dnode1/log/taosdlog.*" % tdDnodes.getDnodesRootDir()):
+            with open(log, errors="ignore") as f:
+                lines += [line for line in f if "aggregated in" in line and "morsels" in line]
+        return lines
+
+    # the log lines of the queries aggregated by the workers, once all the lines of the queries before are written
+    def waitMorsels(self, expected):
+        for i in range(30):
+            lines = self.morsels()
+            if len(lines) >= expected:
+                break
+            time.sleep(0.1)
+        return lines
+
+    # the partial results of the workers are merged in any order, so the sums of floats may differ in the last digits
+    def isEqual(self, v1, v2):
+        if isinstance(v1, float) or isinstance(v2, float):
+            return v1 is not None and v2 is not None and math.isclose(v1, v2, rel_tol=1e-9, abs_tol=1e-9)
+        return v1 == v2
+
+    def checkQuery(self, sql, cond, key, funcs, passes, desc):
+        tdSql.query(sql)
+        expected = self.expect(cond, key, funcs)
+        if tdSql.queryRows != len(expected):
+            tdLog.exit("sql:%s, %d rows %s, expect %d" % (sql, tdSql.queryRows, desc, len(expected)))
+
+        for r in tdSql.queryResult:
+            if key is None:
+                k, vals = None, list(r)
+            elif callable(key):
+                k, vals = int(r[0].timestamp() * 1000 + 0.5), list(r[1:])
+            else:
+                k, vals = r[-1], list(r[:-1])
+            if k not in expected or len(vals) != len(expected[k]) or \
+                    not all(self.isEqual(a, b) for a, b in zip(vals, expected[k])):
+                tdLog.exit("sql:%s, group %s: %s %s, expect %s" % (sql, k, vals, desc, expected.get(k)))
+
+        if self.workers > 0:
+            self.parallelPasses += passes
+        lines = self.waitMorsels(self.parallelPasses)
+        if len(lines) != self.parallelPasses:
+            tdLog.exit("sql:%s, %d passes aggregated by the workers, expect %d %s" %
+                       (sql, len(lines) - self.parallelPasses + passes, passes if self.workers > 0 else 0, desc))
+        tdLog.info("sql:%s, %d rows %s" % (sql, tdSql.queryRows, desc))
+        return lines
+
+    def checkAll(self, desc):
+        for sql, cond, key, funcs, passes in self.queries:
+            self.checkQuery(sql, cond, key, funcs, passes, desc)
+
+    def restart(self, workers, bufferSize=-1):
+        tdDnodes.stop(1)
+        tdDnodes.cfg(1, "numOfQueryWorkers", workers)
+        tdDnodes.cfg(1, "queryBufferSize", bufferSize)
+        tdDnodes.start(1)
+
+        self.workers = workers
+        self.parallelPasses = len(self.morsels())
+
+    def run(self):
+        tdDnodes.stop(1)
+        tdDnodes.deploy(1)
+        tdDnodes.start(1)
+        self.model = []
+
+        tdSql.prepare()
+        tdSql.execute("create table db.st (ts timestamp, v int, b bigint, f float, d double) tags (t int, g int)")
+        for i in range(self.tables):
+            tdSql.execute("create table db.t%d using db.st tags (%d, %d)" % (i, i, i % 3))
+
+        # half of the rows in the data files and half in the memory tables
+        self.insertData(0, self.rows // 2)
+        self.restart(4)
+        self.insertData(self.rows // 2, self.rows)
+        self.checkAll("by the workers from the files and memory")
+
+        self.restart(4)
+        self.checkAll("by the workers from the files")
+
+        self.restart(0)
+        self.checkAll("without workers")
+
+        # the result buffers of the workers are taken from the query buffer of 1MB, a quarter of it at most
+        self.restart(4, 1)
+        sql, cond, key, funcs, passes = self.queries[3]
+        lines = self.checkQuery(sql, cond, key, funcs, passes, "by the workers with a small query buffer")
+        bufSize = int(re.search(r"(\d+) bytes of result buffer each", lines[-1]).group(1))
+        if bufSize * self.workers > 1048576 // 4:
+            tdLog.exit("%d workers take %d bytes each of the query buffer of 1MB" % (self.workers, bufSize))
+
+    def stop(self):
+        tdSql.close()
+        tdLog.success("%s successfully executed" % __file__)
+
+
+tdCases.addWindows(__file__, TDTestCase())
+tdCases.addLinux(__file__, TDTestCase())
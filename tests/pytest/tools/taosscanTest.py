@@ -0,0 +1,124 @@
+###################################################################
+#           Copyright (c) 2016 by TAOS Technologies, Inc.
+#                     All rights reserved.
+#
+#  This file is proprietary and confidential to TAOS Technologies.
+#  No part of this file may be reproduced, stored, transmitted,
+#  disclosed or used in any form or by any means other than as
+#  expressly provided by the written permission from Jianhui Tao
+#
+###################################################################
+
+# -*- coding: utf-8 -*-
+
+import os
+import glob
+import shutil
+import subprocess
+from util.log import tdLog
+from util.cases import tdCases
+from util.sql import tdSql
+from util.dnodes import tdDnodes
+
+
+class TDTestCase:
+    def init(self, conn, logSql):
+        tdLog.debug("start to execute %s" % __file__)
+        tdSql.init(conn.cursor(), logSql)
+
+        self.ts = 1537146000000
+        self.tables = 5
+        self.rows = 2000
+
+    def getBuildPath(self):
+        selfPath = os.path.dirname(os.path.realpath(__file__))
+
+        if ("community" in selfPath):
+            projPath = selfPath[:selfPath.find("community")]
+        else:
+            projPath = selfPath[:selfPath.find("tests")]
+
+        buildPath = ""
+        for root, dirs, files in os.walk(projPath):
+            if ("taosscan" in files):
+                rootRealPath = os.path.dirname(os.path.realpath(root))
+                if ("packaging" not in rootRealPath):
+                    buildPath = root[:len(root) - len("/build/bin")]
+                    break
+        return buildPath
+
+    def scan(self, dataDir):
+        p = subprocess.run([self.taosscan, "-s", dataDir], stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+                           universal_newlines=True)
+        tdLog.info("taosscan %s exits with %d:\n%s" % (dataDir, p.returncode, p.stdout))
+        return p.returncode, p.stdout
+
+    # a copy of the data files with the bytes at the middle of a file of the suffix changed
+    def corrupt(self, dataDir, name, suffix):
+        copyDir = os.path.join(os.path.dirname(dataDir), name)
+        shutil.rmtree(copyDir, ignore_errors=True)
+        shutil.copytree(dataDir, copyDir)
+
+        files = glob.glob(os.path.join(copyDir, "*.%s" % suffix))
+        if len(files) != 1:
+            tdLog.exit("%d .%s files in %s" % (len(files), suffix, copyDir))
+
+        with open(files[0], "r+b") as f:
+            size = f.seek(0, os.SEEK_END)
+            f.seek(size // 2)
+            data = f.read(16)
+            f.seek(size // 2)
+            f.write(bytes(b ^ 0x5a for b in data))
+        return copyDir
+
+    def run(self):
+        buildPath = self.getBuildPath()
+        if (buildPath == ""):
+            tdLog.exit("taosscan not found!")
+        self.taosscan = buildPath + "/build/bin/taosscan"
+
+        tdDnodes.stop(1)
+        tdDnodes.deploy(1)
+        tdDnodes.start(1)
+
+        tdSql.execute("create database db maxrows 200")
+        tdSql.execute("create table db.st (ts timestamp, v int, f float, s binary(16)) tags (t int)")
+        for k in range(self.tables):
+            tdSql.execute("create table db.t%d using db.st tags (%d)" % (k, k))
+            for i in range(0, self.rows, 500):
+                values = ["(%d, %d, %f, 's%d')" % (self.ts + n * 1000, n * k, n * 0.5, n % 37)
+                          for n in range(i, i + 500)]
+                tdSql.execute("insert into db.t%d values %s" % (k, " ".join(values)))
+
+        # the rows are committed to the FSET when the dnode stops, the files are scanned without it
+        tdDnodes.stop(1)
+        dataDirs = glob.glob("%s/dnode1/data/vnode/vnode*/tsdb/data" % tdDnodes.getDnodesRootDir())
+        if len(dataDirs) != 1:
+            tdLog.exit("%d vnode data directories" % len(dataDirs))
+        dataDir = dataDirs[0]
+
+        code, out = self.scan(dataDir)
+        if code != 0 or "OK, 0 problems found" not in out:
+            tdLog.exit("problems found in the FSET just committed")
+        if "rows:%d " % (self.tables * self.rows) not in out:
+            tdLog.exit("the rows scanned are not the %d rows written" % (self.tables * self.rows))
+
+        for suffix in ["data", "head"]:
+            copyDir = self.corrupt(dataDir, "corrupted_" + suffix, suffix)
+            code, out = self.scan(copyDir)
+            if code != 1 or "OK, 0 problems found" in out:
+                tdLog.exit("no problem found in the corrupted .%s file" % suffix)
+            shutil.rmtree(copyDir)
+            tdLog.info("the corrupted .%s file is found" % suffix)
+
+        tdDnodes.start(1)
+        tdSql.query("select count(*) from db.st")
+        tdSql.checkData(0, 0, self.tables * self.rows)
+
+    def stop(self):
+        tdSql.close()
+        tdLog.success("%s successfully executed" % __file__)
+
+
+tdCases.addWindows(__file__, TDTestCase())
+tdCases.addLinux(__file__, TDTestCase())